@@ -0,0 +1,216 @@
+/*************************************/
+/** Copyright © 2014 Coldsnap Games **/
+/*************************************/
+
+/*************************************/
+/**             Headers             **/
+/*************************************/
+#include <Tyrant/Network.hpp>
+#include <Tyrant/System/Clock.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+
+////////////////////////////////////////////////////////////
+/// Measures TGE::CompressedPacket on representative game
+/// payloads: level chunks, world-state packets, small entity
+/// updates (without and with a TGE::CompressionDictionary
+/// trained on other updates) and random data. For each one,
+/// the compression ratio and the compression and
+/// uncompression speeds, in MB/s of uncompressed data. Every
+/// payload is uncompressed and compared with the original.
+///
+/// Usage: CompressionBenchmark [megabytes]
+///
+////////////////////////////////////////////////////////////
+namespace
+{
+    // Size of a level chunk, in blocks
+    const int ChunkWidth = 32;
+    const int ChunkHeight = 64;
+
+    // Number of entities of a world-state packet
+    const int WorldEntities = 100;
+
+    // Number of updates the dictionary is trained on, and its size
+    const std::size_t TrainingSamples = 500;
+    const std::size_t DictionarySize = 4096;
+
+    std::size_t megabytes = 64;
+    int failures = 0;
+
+    ////////////////////////////////////////////////////////////
+    /// Compressed packet giving access to its compression
+    /// functions, without going through a socket
+    ////////////////////////////////////////////////////////////
+    class MeasuredPacket : public TGE::CompressedPacket
+    {
+    public :
+
+        using TGE::CompressedPacket::onSend;
+        using TGE::CompressedPacket::onReceive;
+    };
+
+    // A 32x32x64 chunk of blocks: stone, dirt and air layers, with ores and caves
+    void makeChunk(TGE::Packet& packet, int seed)
+    {
+        std::srand(seed);
+        std::vector<TGE::Uint8> blocks(ChunkWidth * ChunkWidth * ChunkHeight);
+        for (int y = 0; y < ChunkHeight; ++y)
+        {
+            for (int i = 0; i < ChunkWidth * ChunkWidth; ++i)
+            {
+                TGE::Uint8 block = (y < 40) ? 1 : (y < 44) ? 2 : 0;
+                if ((block == 1) && (std::rand() % 50 == 0))
+                    block = static_cast<TGE::Uint8>(3 + std::rand() % 4);
+                else if ((block != 0) && (std::rand() % 200 == 0))
+                    block = 0;
+                blocks[y * ChunkWidth * ChunkWidth + i] = block;
+            }
+        }
+
+        packet.clear();
+        packet << static_cast<TGE::Int32>(seed) << static_cast<TGE::Int32>(-seed);
+        packet.append(&blocks[0], blocks.size());
+    }
+
+    // One entity, as a game would send it
+    void writeEntity(TGE::Packet& packet, int id)
+    {
+        char name[32];
+        std::sprintf(name, "soldier_%d", id % 16);
+
+        packet << static_cast<TGE::Uint16>(id)
+               << static_cast<TGE::Uint8>(id % 4)
+               << std::string(name)
+               << std::rand() % 2000 - 1000.f << 12.5f << std::rand() % 2000 - 1000.f
+               << 0.f << std::rand() % 360 * 1.f << 0.f
+               << std::rand() % 10 - 5.f << 0.f << std::rand() % 10 - 5.f
+               << static_cast<TGE::Uint8>(std::rand() % 101)
+               << static_cast<TGE::Uint16>(30) << static_cast<TGE::Uint16>(120)
+               << true << false << (id % 3 == 0)
+               << std::string("rifle") << std::string("helmet") << std::string("team_red");
+    }
+
+    // The state of the world sent to a client, about 9 KB
+    void makeWorldState(TGE::Packet& packet, int seed)
+    {
+        std::srand(seed);
+        packet.clear();
+        packet << static_cast<TGE::Uint32>(seed) << static_cast<TGE::Uint16>(WorldEntities);
+        for (int i = 0; i < WorldEntities; ++i)
+            writeEntity(packet, i);
+    }
+
+    // The update of a single entity, about 210 bytes with its events
+    void makeEntityUpdate(TGE::Packet& packet, int seed)
+    {
+        std::srand(seed);
+        packet.clear();
+        packet << static_cast<TGE::Uint32>(seed);
+        writeEntity(packet, seed % 64);
+        packet << std::string("event:weapon_fired") << std::string("event:footstep") << std::string("event:reload_done");
+        packet << static_cast<TGE::Uint32>(seed * 7) << static_cast<TGE::Uint32>(seed * 13);
+        packet << std::string("animation:run_forward") << std::string("animation:aim_rifle");
+    }
+
+    void makeRandom(TGE::Packet& packet, int seed)
+    {
+        std::srand(seed);
+        std::vector<char> data(16384);
+        for (std::size_t i = 0; i < data.size(); ++i)
+            data[i] = static_cast<char>(std::rand());
+
+        packet.clear();
+        packet.append(&data[0], data.size());
+    }
+
+
+    ////////////////////////////////////////////////////////////
+    void measure(const char* name, const TGE::Packet& payload, const TGE::CompressionDictionary* dictionary)
+    {
+        std::size_t size = payload.getDataSize();
+        std::size_t iterations = std::max<std::size_t>(megabytes * 1024 * 1024 / size, 1);
+
+        MeasuredPacket sender;
+        sender.setDictionary(dictionary);
+        sender.append(payload.getData(), size);
+
+        // Compress
+        std::size_t compressedSize = 0;
+        const void* compressed = NULL;
+        TGE::Clock clock;
+        for (std::size_t i = 0; i < iterations; ++i)
+            compressed = sender.onSend(compressedSize);
+        double compressTime = clock.getElapsedTime().asSeconds();
+
+        // Uncompress
+        std::vector<char> wire(static_cast<const char*>(compressed), static_cast<const char*>(compressed) + compressedSize);
+        MeasuredPacket receiver;
+        receiver.setDictionary(dictionary);
+        clock.restart();
+        for (std::size_t i = 0; i < iterations; ++i)
+        {
+            receiver.clear();
+            receiver.onReceive(&wire[0], wire.size());
+        }
+        double uncompressTime = clock.getElapsedTime().asSeconds();
+
+        bool identical = (receiver.getDataSize() == size) && (std::memcmp(receiver.getData(), payload.getData(), size) == 0);
+        if (!identical)
+            failures++;
+
+        double total = static_cast<double>(size) * iterations / (1024 * 1024);
+        std::printf("%-28s %7u B   ratio %6.2fx   compress %7.0f MB/s   uncompress %7.0f MB/s%s\n",
+                    name,
+                    static_cast<unsigned int>(size),
+                    static_cast<double>(size) / compressedSize,
+                    total / compressTime,
+                    total / uncompressTime,
+                    identical ? "" : "   MISMATCH");
+    }
+}
+
+
+////////////////////////////////////////////////////////////
+int main(int argc, char* argv[])
+{
+    if (argc > 1)
+        megabytes = std::max(std::atoi(argv[1]), 1);
+
+    std::printf("Tyrant compression benchmark, %u MB per measure\n\n", static_cast<unsigned int>(megabytes));
+
+    TGE::Packet payload;
+
+    makeChunk(payload, 1);
+    measure("level chunk", payload, NULL);
+
+    makeWorldState(payload, 1);
+    measure("world state", payload, NULL);
+
+    // The dictionary is trained on other updates than the one measured
+    std::vector<TGE::Packet> samples(TrainingSamples);
+    for (std::size_t i = 0; i < samples.size(); ++i)
+        makeEntityUpdate(samples[i], static_cast<int>(i + 1000));
+    TGE::CompressionDictionary dictionary;
+    dictionary.train(samples, DictionarySize);
+
+    makeEntityUpdate(payload, 1);
+    measure("entity update", payload, NULL);
+    measure("entity update, dictionary", payload, &dictionary);
+
+    makeRandom(payload, 1);
+    measure("random data", payload, NULL);
+
+    if (failures > 0)
+    {
+        std::printf("\n%d payloads were not uncompressed correctly\n", failures);
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,372 @@
+/*************************************/
+/** Copyright © 2014 Coldsnap Games **/
+/*************************************/
+
+/*************************************/
+/**             Headers             **/
+/*************************************/
+#include <Tyrant/Network.hpp>
+#include <Tyrant/System/Clock.hpp>
+#include <Tyrant/System/Thread.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+
+////////////////////////////////////////////////////////////
+/// Measures TGE::Http against a minimal HTTP/1.1 server
+/// running in the same process: small requests on a new
+/// connection each, on a kept-alive connection and pipelined,
+/// then large bodies stored and streamed to a callback.
+///
+/// The server can also close the connection after a number
+/// of responses, to check that the GET requests are sent
+/// again and the POST requests are not, and it counts the
+/// POST requests which arrived pipelined with other ones.
+///
+/// Usage: HttpBenchmark [port] [requests]
+///
+////////////////////////////////////////////////////////////
+namespace
+{
+    // Size of the small responses
+    const std::size_t SmallBodySize = 200;
+
+    // Size of the large responses
+    const std::size_t LargeBodySize = 64 * 1024 * 1024;
+
+    // Number of requests of a pipelined batch
+    const std::size_t BatchSize = 50;
+
+    unsigned short port = 48000;
+    std::size_t requestCount = 20000;
+
+    ////////////////////////////////////////////////////////////
+    /// HTTP server answering in the order of the requests, with
+    /// one thread for all its connections
+    ////////////////////////////////////////////////////////////
+    class Server
+    {
+    public :
+
+        Server() :
+        closeEvery      (0),
+        postsPipelined  (0),
+        postsReceived   (0),
+        m_thread        (&Server::run, this),
+        m_stop          (false)
+        {
+        }
+
+        bool start()
+        {
+            if (m_listener.listen(port) != TGE::Socket::Done)
+                return false;
+
+            m_smallBody.assign(SmallBodySize, 's');
+            m_largeBody.assign(LargeBodySize, 'l');
+            m_thread.launch();
+            return true;
+        }
+
+        void stop()
+        {
+            m_stop = true;
+            m_thread.wait();
+        }
+
+        std::size_t closeEvery;     ///< Close the connection after this number of responses, 0 for never
+        std::size_t postsPipelined; ///< POST requests received in the same data as another request
+        std::size_t postsReceived;  ///< POST requests received
+
+    private :
+
+        struct Connection
+        {
+            TGE::TcpSocket socket;
+            std::string    data;
+            std::size_t    answered;
+        };
+
+        void run()
+        {
+            TGE::SocketSelector selector;
+            selector.add(m_listener);
+            std::vector<Connection*> connections;
+
+            while (!m_stop)
+            {
+                if (!selector.wait(TGE::milliseconds(20)))
+                    continue;
+
+                if (selector.isReady(m_listener))
+                {
+                    Connection* connection = new Connection;
+                    connection->answered = 0;
+                    if (m_listener.accept(connection->socket) == TGE::Socket::Done)
+                    {
+                        selector.add(connection->socket);
+                        connections.push_back(connection);
+                    }
+                    else
+                    {
+                        delete connection;
+                    }
+                }
+
+                for (std::vector<Connection*>::iterator it = connections.begin(); it != connections.end(); )
+                {
+                    Connection* connection = *it;
+                    if (selector.isReady(connection->socket) && !serve(*connection))
+                    {
+                        selector.remove(connection->socket);
+                        delete connection;
+                        it = connections.erase(it);
+                    }
+                    else
+                    {
+                        ++it;
+                    }
+                }
+            }
+
+            for (std::vector<Connection*>::iterator it = connections.begin(); it != connections.end(); ++it)
+                delete *it;
+        }
+
+        // Read what the client sent and answer the complete requests, false to close the connection
+        bool serve(Connection& connection)
+        {
+            char buffer[65536];
+            std::size_t received = 0;
+            if (connection.socket.receive(buffer, sizeof(buffer), received) != TGE::Socket::Done)
+                return false;
+            connection.data.append(buffer, received);
+
+            // Count the requests which are complete, to find the pipelined POSTs
+            std::vector<std::size_t> ends;
+            std::vector<bool> posts;
+            std::size_t begin = 0;
+            for (;;)
+            {
+                std::size_t headerEnd = connection.data.find("\r\n\r\n", begin);
+                if (headerEnd == std::string::npos)
+                    break;
+
+                std::size_t length = 0;
+                std::size_t field = connection.data.find("Content-Length: ", begin);
+                if ((field != std::string::npos) && (field < headerEnd))
+                    length = std::strtoul(connection.data.c_str() + field + 16, NULL, 10);
+                if (headerEnd + 4 + length > connection.data.size())
+                    break;
+
+                posts.push_back(connection.data.compare(begin, 5, "POST ") == 0);
+                begin = headerEnd + 4 + length;
+                ends.push_back(begin);
+            }
+
+            for (std::size_t i = 0; i < posts.size(); ++i)
+            {
+                if (posts[i])
+                {
+                    postsReceived++;
+                    if (posts.size() > 1)
+                        postsPipelined++;
+                }
+            }
+
+            // Answer the requests in order
+            std::size_t start = 0;
+            for (std::size_t i = 0; i < ends.size(); ++i)
+            {
+                std::string request = connection.data.substr(start, ends[i] - start);
+                start = ends[i];
+
+                bool large = request.compare(0, 10, "GET /large") == 0;
+                bool head = request.compare(0, 5, "HEAD ") == 0;
+                const std::string& body = large ? m_largeBody : m_smallBody;
+
+                char header[128];
+                std::sprintf(header, "HTTP/1.1 200 OK\r\nContent-Length: %u\r\n\r\n", static_cast<unsigned int>(body.size()));
+                if (connection.socket.send(header, std::strlen(header)) != TGE::Socket::Done)
+                    return false;
+                if (!head && (connection.socket.send(body.data(), body.size()) != TGE::Socket::Done))
+                    return false;
+
+                // Drop the connection without answering the requests left
+                connection.answered++;
+                if ((closeEvery > 0) && (connection.answered % closeEvery == 0))
+                    return false;
+            }
+
+            connection.data.erase(0, start);
+            return true;
+        }
+
+        TGE::TcpListener m_listener;  ///< Socket accepting the connections
+        TGE::Thread      m_thread;    ///< Thread running the server
+        volatile bool    m_stop;      ///< Stop the server?
+        std::string      m_smallBody; ///< Body of the small responses
+        std::string      m_largeBody; ///< Body of the large responses
+    };
+
+    void printRate(const char* name, std::size_t requests, std::size_t succeeded, double elapsed)
+    {
+        std::printf("%-36s %9.0f req/s   %7.1f us/req   %u/%u ok\n",
+                    name,
+                    requests / elapsed,
+                    elapsed * 1e6 / requests,
+                    static_cast<unsigned int>(succeeded),
+                    static_cast<unsigned int>(requests));
+    }
+
+    std::size_t countOk(const std::vector<TGE::Http::Response>& responses)
+    {
+        std::size_t ok = 0;
+        for (std::vector<TGE::Http::Response>::const_iterator it = responses.begin(); it != responses.end(); ++it)
+            ok += (it->getStatus() == TGE::Http::Response::Ok) && (it->getBody().size() == SmallBodySize) ? 1 : 0;
+        return ok;
+    }
+
+
+    ////////////////////////////////////////////////////////////
+    void benchmarkSmallRequests(TGE::Http& http)
+    {
+        std::printf("\n-- %u B responses --\n", static_cast<unsigned int>(SmallBodySize));
+
+        // A new connection for each request, as before keep-alive
+        {
+            std::size_t count = std::max<std::size_t>(requestCount / 10, 1);
+            TGE::Http::Request request("/small");
+            request.setField("Connection", "close");
+            std::size_t ok = 0;
+            TGE::Clock clock;
+            for (std::size_t i = 0; i < count; ++i)
+                ok += (http.sendRequest(request).getStatus() == TGE::Http::Response::Ok) ? 1 : 0;
+            printRate("GET, one connection each", count, ok, clock.getElapsedTime().asSeconds());
+        }
+
+        {
+            TGE::Http::Request request("/small");
+            std::size_t ok = 0;
+            TGE::Clock clock;
+            for (std::size_t i = 0; i < requestCount; ++i)
+                ok += (http.sendRequest(request).getStatus() == TGE::Http::Response::Ok) ? 1 : 0;
+            printRate("GET, kept alive", requestCount, ok, clock.getElapsedTime().asSeconds());
+        }
+
+        {
+            std::vector<TGE::Http::Request> batch(BatchSize, TGE::Http::Request("/small"));
+            std::size_t ok = 0;
+            TGE::Clock clock;
+            for (std::size_t i = 0; i < requestCount; i += BatchSize)
+                ok += countOk(http.sendRequests(batch));
+            printRate("GET, pipelined by 50", requestCount - requestCount % BatchSize, ok, clock.getElapsedTime().asSeconds());
+        }
+    }
+
+
+    ////////////////////////////////////////////////////////////
+    void benchmarkLargeBodies(TGE::Http& http)
+    {
+        std::printf("\n-- %u MB responses --\n", static_cast<unsigned int>(LargeBodySize / (1024 * 1024)));
+
+        TGE::Http::Request request("/large");
+        const std::size_t count = 4;
+
+        {
+            std::size_t ok = 0;
+            TGE::Clock clock;
+            for (std::size_t i = 0; i < count; ++i)
+                ok += (http.sendRequest(request).getBody().size() == LargeBodySize) ? 1 : 0;
+            double elapsed = clock.getElapsedTime().asSeconds();
+            std::printf("%-36s %9.0f MB/s   %u/%u ok\n", "stored in the response", count * LargeBodySize / elapsed / (1024 * 1024),
+                        static_cast<unsigned int>(ok), static_cast<unsigned int>(count));
+        }
+
+        {
+            std::size_t received = 0;
+            TGE::Http::BodyCallback callback = [&](const char*, std::size_t size) {received += size; return true;};
+            TGE::Clock clock;
+            for (std::size_t i = 0; i < count; ++i)
+                http.sendRequest(request, callback);
+            double elapsed = clock.getElapsedTime().asSeconds();
+            std::printf("%-36s %9.0f MB/s   %u/%u ok\n", "streamed to a callback", count * LargeBodySize / elapsed / (1024 * 1024),
+                        static_cast<unsigned int>(received / LargeBodySize), static_cast<unsigned int>(count));
+        }
+    }
+
+
+    ////////////////////////////////////////////////////////////
+    void benchmarkClosedConnections(TGE::Http& http, Server& server)
+    {
+        std::printf("\n-- Server closing the connection after every 7 responses --\n");
+
+        server.closeEvery = 7;
+        server.postsPipelined = 0;
+        server.postsReceived = 0;
+
+        // Pipelined GETs are sent again when the connection is closed
+        std::vector<TGE::Http::Request> batch(BatchSize, TGE::Http::Request("/small"));
+        std::size_t ok = 0;
+        std::size_t count = std::min<std::size_t>(requestCount, 2000);
+        TGE::Clock clock;
+        for (std::size_t i = 0; i < count; i += BatchSize)
+            ok += countOk(http.sendRequests(batch));
+        printRate("GET, pipelined by 50", count - count % BatchSize, ok, clock.getElapsedTime().asSeconds());
+
+        // POSTs in the middle of GETs: never pipelined, never sent twice
+        batch[BatchSize / 2] = TGE::Http::Request("/form", TGE::Http::Request::Post, "name=value");
+        std::size_t posts = 0;
+        std::size_t postsAnswered = 0;
+        ok = 0;
+        clock.restart();
+        for (std::size_t i = 0; i < count; i += BatchSize)
+        {
+            std::vector<TGE::Http::Response> responses = http.sendRequests(batch);
+            ok += countOk(responses);
+            posts++;
+            postsAnswered += (responses[BatchSize / 2].getStatus() == TGE::Http::Response::Ok) ? 1 : 0;
+        }
+        printRate("GET and POST, batches of 50", count - count % BatchSize, ok, clock.getElapsedTime().asSeconds());
+        std::printf("POST sent %u, received by the server %u, answered %u, pipelined %u\n",
+                    static_cast<unsigned int>(posts),
+                    static_cast<unsigned int>(server.postsReceived),
+                    static_cast<unsigned int>(postsAnswered),
+                    static_cast<unsigned int>(server.postsPipelined));
+
+        server.closeEvery = 0;
+    }
+}
+
+
+////////////////////////////////////////////////////////////
+int main(int argc, char* argv[])
+{
+    if (argc > 1)
+        port = static_cast<unsigned short>(std::atoi(argv[1]));
+    if (argc > 2)
+        requestCount = std::max(std::atoi(argv[2]), 100);
+
+    Server server;
+    if (!server.start())
+    {
+        std::printf("cannot listen on port %u\n", port);
+        return EXIT_FAILURE;
+    }
+
+    std::printf("Tyrant HTTP benchmark, local server on port %u, %u requests per run\n", port, static_cast<unsigned int>(requestCount));
+
+    TGE::Http http("127.0.0.1", port);
+    benchmarkSmallRequests(http);
+    benchmarkLargeBodies(http);
+    benchmarkClosedConnections(http, server);
+
+    http.closeConnections();
+    server.stop();
+
+    return EXIT_SUCCESS;
+}
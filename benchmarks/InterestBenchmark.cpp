@@ -0,0 +1,228 @@
+/*************************************/
+/** Copyright © 2014 Coldsnap Games **/
+/*************************************/
+
+/*************************************/
+/**             Headers             **/
+/*************************************/
+#include <Tyrant/Network.hpp>
+#include <Tyrant/System/Clock.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+
+////////////////////////////////////////////////////////////
+/// Measures TGE::InterestManager with simulated clients in
+/// the same process: each client follows one of the moving
+/// entities, and gets 20-byte updates of the entities
+/// around it within the default budget.
+///
+/// A sparse world fits every update of an area in the
+/// budget; a dense one doesn't, and the priorities decide.
+/// For each one, the time of update() and of the writes per
+/// tick, the bytes written against sending every entity to
+/// every client, and how often an entity is refreshed. The
+/// updates are checked to fit the budget and to hold only
+/// entities of the client's area, and the areas to match the
+/// entities reported entering and leaving them.
+///
+/// Usage: InterestBenchmark [clients] [ticks]
+///
+////////////////////////////////////////////////////////////
+namespace
+{
+    // Number of moving entities; every 10th one is a player
+    const TGE::Uint16 EntityCount = 5000;
+    const TGE::Uint16 PlayerInterval = 10;
+    const float PlayerPriority = 2.f;
+
+    // Radius of the areas of interest, and the default hysteresis
+    const float Radius = 100.f;
+    const float Hysteresis = 1.2f;
+
+    // Distance an entity moves at most per tick, on each axis
+    const float Speed = 4.f;
+
+    // Size of the update of an entity
+    const std::size_t UpdateSize = 20;
+
+    // Size of the update budget of a client, the default
+    const std::size_t Budget = 1200;
+
+    std::size_t clientCount = 500;
+    unsigned int tickCount = 50;
+    int failures = 0;
+
+    void check(bool condition, const char* what)
+    {
+        if (!condition)
+        {
+            std::printf("FAILED: %s\n", what);
+            failures++;
+        }
+    }
+
+    struct Entity
+    {
+        TGE::Vector2f position;
+        TGE::Vector2f velocity;
+    };
+
+    float getDistanceSquared(const TGE::Vector2f& left, const TGE::Vector2f& right)
+    {
+        return (left.x - right.x) * (left.x - right.x) + (left.y - right.y) * (left.y - right.y);
+    }
+
+    float random(float min, float max)
+    {
+        return min + (max - min) * std::rand() / RAND_MAX;
+    }
+
+
+    ////////////////////////////////////////////////////////////
+    void benchmarkWorld(const char* name, float worldSize)
+    {
+        std::srand(5);
+        std::vector<Entity> entities(EntityCount);
+        for (std::vector<Entity>::iterator it = entities.begin(); it != entities.end(); ++it)
+        {
+            it->position = TGE::Vector2f(random(0.f, worldSize), random(0.f, worldSize));
+            it->velocity = TGE::Vector2f(random(-Speed, Speed), random(-Speed, Speed));
+        }
+
+        TGE::InterestManager interest(Radius);
+        std::vector<std::size_t> clients(clientCount);
+        for (std::size_t i = 0; i < clientCount; ++i)
+        {
+            clients[i] = interest.addClient();
+            interest.setBudget(clients[i], Budget);
+        }
+
+        // Tick each entity was last sent to each client at, 0 if not since it entered the area
+        std::vector<TGE::Uint32> lastSent(clientCount * EntityCount, 0);
+        std::vector<std::size_t> counts(clientCount, 0);
+
+        double updateTime = 0;
+        double writeTime = 0;
+        std::size_t bytes = 0;
+        std::size_t areaEntities = 0;
+        TGE::Uint64 intervals[2] = {0, 0};
+        TGE::Uint64 refreshes[2] = {0, 0};
+        TGE::Uint32 longestInterval = 0;
+        TGE::Packet packet;
+        TGE::Clock clock;
+
+        for (TGE::Uint32 tick = 1; tick <= tickCount; ++tick)
+        {
+            // Move the entities, bouncing on the borders of the world
+            for (TGE::Uint16 id = 0; id < EntityCount; ++id)
+            {
+                Entity& entity = entities[id];
+                entity.position += entity.velocity;
+                if ((entity.position.x < 0.f) || (entity.position.x > worldSize))
+                    entity.velocity.x = -entity.velocity.x;
+                if ((entity.position.y < 0.f) || (entity.position.y > worldSize))
+                    entity.velocity.y = -entity.velocity.y;
+
+                interest.setEntity(id, entity.position, (id % PlayerInterval == 0) ? PlayerPriority : 1.f);
+            }
+
+            // Each client follows a player
+            for (std::size_t i = 0; i < clientCount; ++i)
+                interest.setArea(clients[i], entities[(i * PlayerInterval) % EntityCount].position, Radius);
+
+            clock.restart();
+            interest.update();
+            updateTime += clock.getElapsedTime().asSeconds();
+
+            for (std::size_t i = 0; i < clientCount; ++i)
+            {
+                const std::vector<TGE::Uint16>& entered = interest.getEnteredEntities(clients[i]);
+                const std::vector<TGE::Uint16>& left = interest.getLeftEntities(clients[i]);
+                counts[i] += entered.size();
+                counts[i] -= left.size();
+                check(counts[i] == interest.getEntityCount(clients[i]), "area matches the entities entered and left");
+
+                for (std::vector<TGE::Uint16>::const_iterator it = left.begin(); it != left.end(); ++it)
+                    lastSent[i * EntityCount + *it] = 0;
+
+                areaEntities += counts[i];
+            }
+
+            // The harness writer is timed with the writes, as a game's would be
+            clock.restart();
+            for (std::size_t i = 0; i < clientCount; ++i)
+            {
+                const TGE::Vector2f& center = entities[(i * PlayerInterval) % EntityCount].position;
+                bool outside = false;
+
+                packet.clear();
+                interest.writeUpdates(clients[i], packet, [&](TGE::Uint16 id, TGE::Packet& update)
+                {
+                    const Entity& entity = entities[id];
+                    update << id << entity.position.x << entity.position.y << entity.velocity.x << entity.velocity.y
+                           << static_cast<TGE::Uint8>(100) << static_cast<TGE::Uint8>(id % 4);
+
+                    outside |= getDistanceSquared(entity.position, center) > Radius * Hysteresis * Radius * Hysteresis * 1.001f;
+
+                    TGE::Uint32& last = lastSent[i * EntityCount + id];
+                    if (last > 0)
+                    {
+                        intervals[id % PlayerInterval == 0] += tick - last;
+                        refreshes[id % PlayerInterval == 0]++;
+                        longestInterval = std::max(longestInterval, tick - last);
+                    }
+                    last = tick;
+                });
+
+                check(packet.getDataSize() <= Budget, "updates within the budget");
+                check(!outside, "updates only of entities in the area");
+                bytes += packet.getDataSize();
+            }
+            writeTime += clock.getElapsedTime().asSeconds();
+        }
+
+        std::printf("\n-- %s world, %.0f entities per area on average --\n",
+                    name,
+                    static_cast<double>(areaEntities) / (clientCount * tickCount));
+        std::printf("update %6.2f ms/tick   writes %6.2f ms/tick\n",
+                    updateTime * 1000 / tickCount,
+                    writeTime * 1000 / tickCount);
+        std::printf("%7.0f KB/tick, against %.0f KB/tick to send every entity to every client\n",
+                    static_cast<double>(bytes) / tickCount / 1024,
+                    static_cast<double>(clientCount) * EntityCount * UpdateSize / 1024);
+        std::printf("entity refreshed every %.2f ticks, players every %.2f, at most %u ticks apart\n",
+                    refreshes[0] ? static_cast<double>(intervals[0]) / refreshes[0] : 0.0,
+                    refreshes[1] ? static_cast<double>(intervals[1]) / refreshes[1] : 0.0,
+                    longestInterval);
+    }
+}
+
+
+////////////////////////////////////////////////////////////
+int main(int argc, char* argv[])
+{
+    if (argc > 1)
+        clientCount = std::max(std::atoi(argv[1]), 1);
+    if (argc > 2)
+        tickCount = std::max(std::atoi(argv[2]), 2);
+
+    std::printf("Tyrant interest management benchmark, %u clients, %u entities, %u ticks\n",
+                static_cast<unsigned int>(clientCount),
+                EntityCount,
+                tickCount);
+
+    // About 28 and 400 entities in an area of interest
+    benchmarkWorld("Sparse", 2370.f);
+    benchmarkWorld("Dense", 627.f);
+
+    if (failures > 0)
+    {
+        std::printf("\n%d checks failed\n", failures);
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
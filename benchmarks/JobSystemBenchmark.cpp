@@ -0,0 +1,223 @@
+/*************************************/
+/** Copyright © 2014 Coldsnap Games **/
+/*************************************/
+
+/*************************************/
+/**             Headers             **/
+/*************************************/
+#include <Tyrant/System/AllocationCounter.hpp>
+#include <Tyrant/System/Clock.hpp>
+#include <Tyrant/System/JobSystem.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+
+////////////////////////////////////////////////////////////
+/// Measures the cost of TGE::JobSystem: the overhead of a job
+/// too small to be worth anything (pooled, and too large for
+/// the pools), continuations, fan-out from one job to many,
+/// and the speedup of parallelFor over a serial loop for
+/// several grain sizes.
+///
+/// With an engine built with COUNT_ALLOCATIONS=1, the heap
+/// allocations per job are printed too.
+///
+/// Usage: JobSystemBenchmark [workers] [jobs]
+///
+////////////////////////////////////////////////////////////
+namespace
+{
+    // Number of elements processed by the parallelFor runs
+    const std::size_t ElementCount = 1 << 22;
+
+    // Grain sizes measured for parallelFor
+    const std::size_t GrainSizes[] = {64, 1024, 16384, 262144};
+
+    // Number of children of each job of the fan-out tree
+    const std::size_t FanOut = 16;
+
+    // Number of jobs queued before waiting for them, well below the capacity of a worker queue
+    const std::size_t BatchSize = 1024;
+
+    unsigned int workerCount = 0;
+    std::size_t jobCount = 1000000;
+
+    std::vector<float> elements;
+    volatile float sink = 0;
+    volatile int hit = 0;
+
+    // Work of one element, a few dozen cycles
+    inline float process(float value)
+    {
+        for (int i = 0; i < 8; ++i)
+            value = value * 0.999f + 0.5f;
+        return value;
+    }
+
+    struct Measure
+    {
+        Measure() : allocations(TGE::AllocationCounter::getCount()) {}
+
+        // Prints the time and allocations per operation
+        void print(const char* name, std::size_t operations)
+        {
+            double elapsed = clock.getElapsedTime().asSeconds();
+            std::printf("%-32s %8.1f ns/job   %10.0f jobs/s", name, elapsed * 1e9 / operations, operations / elapsed);
+            if (TGE::AllocationCounter::isEnabled())
+                std::printf("   %5.2f allocations/job", static_cast<double>(TGE::AllocationCounter::getCount() - allocations) / operations);
+            std::printf("\n");
+        }
+
+        TGE::Clock clock;
+        TGE::Uint32 allocations;
+    };
+
+
+    // Run jobCount copies of a job, in batches
+    template <typename F>
+    void runBatches(TGE::JobSystem& jobs, F function)
+    {
+        for (std::size_t done = 0; done < jobCount; done += BatchSize)
+        {
+            TGE::JobCounter counter;
+            for (std::size_t i = 0; i < BatchSize; ++i)
+                jobs.run(function, &counter);
+            jobs.wait(counter);
+        }
+    }
+
+
+    ////////////////////////////////////////////////////////////
+    void benchmarkOverhead(TGE::JobSystem& jobs)
+    {
+        std::printf("\n-- Job overhead, %u empty jobs --\n", static_cast<unsigned int>(jobCount));
+
+        // Warm the pools up, so that the runs measure the steady state
+        runBatches(jobs, []() {hit = 1;});
+
+        {
+            Measure measure;
+            runBatches(jobs, []() {hit = 1;});
+            measure.print("pooled, queued by main", jobCount);
+        }
+
+        // Captures too large for the pool blocks fall back to the heap
+        {
+            struct Large {char data[256];} large = {};
+            Measure measure;
+            runBatches(jobs, [=]() {hit = large.data[0] + 1;});
+            measure.print("heap (256 B capture)", jobCount);
+        }
+
+        // Each job queues the next one when it's done
+        {
+            std::size_t chainLength = jobCount / 10;
+            std::vector<TGE::JobCounter> links(chainLength);
+            Measure measure;
+            for (std::size_t i = 1; i < chainLength; ++i)
+                jobs.runAfter(links[i - 1], []() {hit = 1;}, &links[i]);
+            jobs.run([]() {hit = 1;}, &links[0]);
+            jobs.wait(links[chainLength - 1]);
+            measure.print("continuation chain", chainLength);
+        }
+    }
+
+
+    ////////////////////////////////////////////////////////////
+    void spawnTree(TGE::JobSystem& jobs, std::size_t depth, TGE::JobCounter& counter)
+    {
+        if (depth == 0)
+            return;
+
+        for (std::size_t i = 0; i < FanOut; ++i)
+            jobs.run([&jobs, depth, &counter]() {spawnTree(jobs, depth - 1, counter);}, &counter);
+    }
+
+    void benchmarkFanOut(TGE::JobSystem& jobs)
+    {
+        std::printf("\n-- Fan-out --\n");
+
+        // One job queueing many small ones, which the other workers must steal
+        {
+            Measure measure;
+            TGE::JobCounter counter;
+            jobs.run([&]()
+            {
+                for (std::size_t i = 0; i < jobCount; ++i)
+                    jobs.run([]() {}, &counter);
+            }, &counter);
+            jobs.wait(counter);
+            measure.print("flat, queued by one worker", jobCount + 1);
+        }
+
+        // Every job queues children, down to 16^5 leaves
+        {
+            std::size_t depth = 5;
+            std::size_t total = 0;
+            for (std::size_t level = 1, count = FanOut; level <= depth; ++level, count *= FanOut)
+                total += count;
+
+            Measure measure;
+            TGE::JobCounter counter;
+            spawnTree(jobs, depth, counter);
+            jobs.wait(counter);
+            measure.print("tree, 16 children per job", total);
+        }
+    }
+
+
+    ////////////////////////////////////////////////////////////
+    void benchmarkParallelFor(TGE::JobSystem& jobs)
+    {
+        std::printf("\n-- parallelFor over %u elements --\n", static_cast<unsigned int>(ElementCount));
+
+        elements.assign(ElementCount, 1.f);
+
+        TGE::Clock clock;
+        for (std::size_t i = 0; i < ElementCount; ++i)
+            elements[i] = process(elements[i]);
+        double serial = clock.getElapsedTime().asSeconds();
+        std::printf("serial                    %8.2f ms\n", serial * 1000);
+
+        for (std::size_t g = 0; g < sizeof(GrainSizes) / sizeof(*GrainSizes); ++g)
+        {
+            clock.restart();
+            jobs.parallelFor(0, ElementCount, GrainSizes[g], [&](std::size_t first, std::size_t last)
+            {
+                for (std::size_t i = first; i < last; ++i)
+                    elements[i] = process(elements[i]);
+            });
+            double elapsed = clock.getElapsedTime().asSeconds();
+
+            std::printf("grain %6u              %8.2f ms   speedup %5.2f   %6u pieces\n",
+                        static_cast<unsigned int>(GrainSizes[g]),
+                        elapsed * 1000,
+                        serial / elapsed,
+                        static_cast<unsigned int>((ElementCount + GrainSizes[g] - 1) / GrainSizes[g]));
+        }
+
+        sink = elements[ElementCount / 2];
+    }
+}
+
+
+////////////////////////////////////////////////////////////
+int main(int argc, char* argv[])
+{
+    if (argc > 1)
+        workerCount = static_cast<unsigned int>(std::atoi(argv[1]));
+    if (argc > 2)
+        jobCount = std::max(std::atoi(argv[2]), 1000);
+
+    TGE::JobSystem jobs(workerCount);
+
+    std::printf("Tyrant job system benchmark, %u workers and the main thread\n", jobs.getWorkerCount());
+
+    benchmarkOverhead(jobs);
+    benchmarkFanOut(jobs);
+    benchmarkParallelFor(jobs);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,741 @@
+/*************************************/
+/** Copyright © 2014 Coldsnap Games **/
+/*************************************/
+
+/*************************************/
+/**             Headers             **/
+/*************************************/
+#include <Tyrant/Network.hpp>
+#include <Tyrant/System/Clock.hpp>
+#include <Tyrant/System/Sleep.hpp>
+#include <Tyrant/System/Thread.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <vector>
+
+#if defined(OS_WINDOWS)
+    #include <winsock2.h>
+#else
+    #include <arpa/inet.h>
+#endif
+
+#if defined(OS_LINUX)
+    #include <poll.h>
+    #include <sys/resource.h>
+    #include <time.h>
+#endif
+
+
+////////////////////////////////////////////////////////////
+/// Measures the network module over the loopback interface:
+/// throughput, packets per second, latency percentiles and
+/// CPU time per message, for several message sizes. The
+/// receive paths of TGE::TcpSocket are compared with the
+/// unbuffered loop it used to have, for small packets. On
+/// Linux, the epoll selector is compared with a scan of every
+/// handle on a server holding thousands of idle sockets. The last
+/// run goes through a TGE::LinkConditioner, with a fixed seed,
+/// to check how TGE::UdpConnection copes with a bad network.
+///
+/// Usage: NetworkBenchmark [port] [messages]
+///
+////////////////////////////////////////////////////////////
+namespace
+{
+    // Sizes of the messages measured, in bytes
+    const std::size_t MessageSizes[] = {16, 64, 256, 1024, 4096, 16384};
+
+    // Number of packets given to each batch send
+    const std::size_t BatchSize = 32;
+
+    // Number of round trips measured for the latencies
+    const std::size_t RoundTrips = 10000;
+
+    // Maximum number of bytes sent by a TCP throughput run
+    const std::size_t MaxTcpBytes = 512 * 1024 * 1024;
+
+    // Time without datagrams after which a UDP run is over
+    const TGE::Time UdpSilence = TGE::milliseconds(200);
+
+    // Sockets of the idle server run, and how many of them have data
+    const std::size_t IdleSockets = 10000;
+    const std::size_t ActiveSockets = 100;
+
+    unsigned short port = 47000;
+    std::size_t messageCount = 200000;
+
+    // Process time, all threads included, in seconds
+    double getCpuTime()
+    {
+        return static_cast<double>(std::clock()) / CLOCKS_PER_SEC;
+    }
+
+    // Time spent running the calling thread, in seconds
+    double getThreadCpuTime()
+    {
+    #if defined(OS_LINUX)
+        timespec time;
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+        return time.tv_sec + time.tv_nsec / 1e9;
+    #else
+        return getCpuTime();
+    #endif
+    }
+
+    // Value below which a given ratio of the samples are
+    double getPercentile(std::vector<TGE::Int64>& samples, double ratio)
+    {
+        std::size_t index = static_cast<std::size_t>(ratio * (samples.size() - 1));
+        std::nth_element(samples.begin(), samples.begin() + index, samples.end());
+        return static_cast<double>(samples[index]);
+    }
+
+    void fillPacket(TGE::Packet& packet, std::size_t size)
+    {
+        static std::vector<char> data(65536, 'x');
+
+        packet.clear();
+        packet.append(&data[0], size);
+    }
+
+    // Print the latencies of a run of round trips, in microseconds
+    void printLatencies(const char* name, std::size_t size, std::vector<TGE::Int64>& samples, double cpu)
+    {
+        std::printf("%-12s %6u B   p50 %7.1f us   p99 %7.1f us   max %8.1f us   cpu %5.2f us/trip\n",
+                    name,
+                    static_cast<unsigned int>(size),
+                    getPercentile(samples, 0.5),
+                    getPercentile(samples, 0.99),
+                    getPercentile(samples, 1.0),
+                    cpu * 1e6 / samples.size());
+    }
+
+
+    ////////////////////////////////////////////////////////////
+    void benchmarkPacket()
+    {
+        std::printf("\n-- Packet serialization --\n");
+
+        TGE::Packet packet;
+        TGE::Clock clock;
+        TGE::Uint32 checksum = 0;
+        for (std::size_t i = 0; i < messageCount; ++i)
+        {
+            packet.clear();
+            packet << static_cast<TGE::Uint32>(i) << 1.5f << static_cast<TGE::Int16>(-3) << std::string("position");
+
+            TGE::Uint32 value;
+            float x;
+            TGE::Int16 y;
+            std::string name;
+            packet >> value >> x >> y >> name;
+            checksum += value + static_cast<TGE::Uint32>(name.size());
+        }
+        double elapsed = clock.getElapsedTime().asSeconds();
+
+        std::printf("write + read %8.0f packets/s  (%u)\n", messageCount / elapsed, checksum);
+    }
+
+
+    ////////////////////////////////////////////////////////////
+    void benchmarkTcpThroughput()
+    {
+        std::printf("\n-- TCP throughput, batches of %u packets --\n", static_cast<unsigned int>(BatchSize));
+
+        TGE::TcpListener listener;
+        if (listener.listen(port) != TGE::Socket::Done)
+        {
+            std::printf("cannot listen on port %u\n", port);
+            return;
+        }
+
+        for (std::size_t s = 0; s < sizeof(MessageSizes) / sizeof(*MessageSizes); ++s)
+        {
+            std::size_t size = MessageSizes[s];
+            std::size_t count = std::max<std::size_t>(std::min(messageCount, MaxTcpBytes / size), BatchSize);
+            count -= count % BatchSize;
+
+            TGE::TcpSocket sender;
+            TGE::TcpSocket receiver;
+            sender.connect(TGE::IpAddress::LocalHost, port);
+            listener.accept(receiver);
+
+            std::size_t received = 0;
+            TGE::Thread thread([&]()
+            {
+                std::vector<TGE::Packet*> packets;
+                while (received < count)
+                {
+                    if (receiver.receive(packets) != TGE::Socket::Done)
+                        break;
+                    received += packets.size();
+                }
+            });
+
+            std::vector<TGE::Packet> batch(BatchSize);
+            for (std::vector<TGE::Packet>::iterator it = batch.begin(); it != batch.end(); ++it)
+                fillPacket(*it, size);
+
+            double cpu = getCpuTime();
+            TGE::Clock clock;
+            thread.launch();
+            for (std::size_t sent = 0; sent < count; sent += BatchSize)
+            {
+                if (sender.send(&batch[0], BatchSize) != TGE::Socket::Done)
+                    break;
+            }
+            thread.wait();
+            double elapsed = clock.getElapsedTime().asSeconds();
+            cpu = getCpuTime() - cpu;
+
+            std::printf("%6u B   %9.0f msg/s   %8.1f MB/s   cpu %5.2f us/msg   (%u/%u)\n",
+                        static_cast<unsigned int>(size),
+                        received / elapsed,
+                        received * size / elapsed / (1024 * 1024),
+                        cpu * 1e6 / count,
+                        static_cast<unsigned int>(received),
+                        static_cast<unsigned int>(count));
+        }
+    }
+
+
+    // Receive a packet the way TcpSocket::receive(Packet&) did before the receive
+    // buffer: the size, then the data in 1024-byte reads, copied again into the packet
+    bool receiveUnbuffered(TGE::TcpSocket& socket, TGE::Packet& packet, std::vector<char>& pending)
+    {
+        TGE::Uint32 size = 0;
+        std::size_t received = 0;
+        for (std::size_t read = 0; read < sizeof(size); read += received)
+        {
+            if (socket.receive(reinterpret_cast<char*>(&size) + read, sizeof(size) - read, received) != TGE::Socket::Done)
+                return false;
+        }
+        size = ntohl(size);
+
+        pending.clear();
+        while (pending.size() < size)
+        {
+            char buffer[1024];
+            if (socket.receive(buffer, std::min<std::size_t>(size - pending.size(), sizeof(buffer)), received) != TGE::Socket::Done)
+                return false;
+            pending.resize(pending.size() + received);
+            std::memcpy(&pending[pending.size() - received], buffer, received);
+        }
+
+        packet.clear();
+        packet.append(&pending[0], size);
+        return true;
+    }
+
+    ////////////////////////////////////////////////////////////
+    void benchmarkTcpReceive()
+    {
+        const std::size_t size = 16;
+        std::printf("\n-- TCP receive of %u B packets, per core of the receiver --\n", static_cast<unsigned int>(size));
+
+        // The port of the other TCP runs may still be in use
+        unsigned short listenerPort = port + 2;
+        TGE::TcpListener listener;
+        if (listener.listen(listenerPort) != TGE::Socket::Done)
+        {
+            std::printf("cannot listen on port %u\n", listenerPort);
+            return;
+        }
+
+        const char* names[] = {"unbuffered", "packet", "batch"};
+        double rates[3] = {0, 0, 0};
+        for (int path = 0; path < 3; ++path)
+        {
+            TGE::TcpSocket sender;
+            TGE::TcpSocket receiver;
+            sender.connect(TGE::IpAddress::LocalHost, listenerPort);
+            listener.accept(receiver);
+
+            std::size_t count = messageCount - messageCount % BatchSize;
+            TGE::Thread thread([&]()
+            {
+                std::vector<TGE::Packet> batch(BatchSize);
+                for (std::vector<TGE::Packet>::iterator it = batch.begin(); it != batch.end(); ++it)
+                    fillPacket(*it, size);
+
+                for (std::size_t sent = 0; sent < count; sent += BatchSize)
+                {
+                    if (sender.send(&batch[0], BatchSize) != TGE::Socket::Done)
+                        break;
+                }
+            });
+            thread.launch();
+
+            // Only the receiving thread is timed
+            std::size_t received = 0;
+            TGE::Packet packet;
+            std::vector<TGE::Packet*> packets;
+            std::vector<char> pending;
+            double cpu = getThreadCpuTime();
+            while (received < count)
+            {
+                if (path == 0)
+                {
+                    if (!receiveUnbuffered(receiver, packet, pending))
+                        break;
+                    received++;
+                }
+                else if (path == 1)
+                {
+                    if (receiver.receive(packet) != TGE::Socket::Done)
+                        break;
+                    received++;
+                }
+                else
+                {
+                    if (receiver.receive(packets) != TGE::Socket::Done)
+                        break;
+                    received += packets.size();
+                }
+            }
+            cpu = getThreadCpuTime() - cpu;
+            thread.wait();
+
+            rates[path] = received / cpu;
+            std::printf("%-12s %10.0f packets/s   %5.3f us/packet   x%4.1f   (%u/%u)\n",
+                        names[path],
+                        rates[path],
+                        cpu * 1e6 / received,
+                        rates[path] / rates[0],
+                        static_cast<unsigned int>(received),
+                        static_cast<unsigned int>(count));
+        }
+
+        std::printf("batch receive %.1fx the unbuffered loop, target 5x\n", rates[2] / rates[0]);
+    }
+
+
+    ////////////////////////////////////////////////////////////
+    void benchmarkTcpLatency()
+    {
+        std::printf("\n-- TCP round trips --\n");
+
+        // The port of the throughput runs may still be in use
+        unsigned short listenerPort = port + 1;
+        TGE::TcpListener listener;
+        if (listener.listen(listenerPort) != TGE::Socket::Done)
+        {
+            std::printf("cannot listen on port %u\n", listenerPort);
+            return;
+        }
+
+        const std::size_t sizes[] = {16, 1024};
+        for (std::size_t s = 0; s < 2; ++s)
+        {
+            TGE::TcpSocket client;
+            TGE::TcpSocket server;
+            client.connect(TGE::IpAddress::LocalHost, listenerPort);
+            listener.accept(server);
+
+            TGE::Thread echo([&]()
+            {
+                TGE::Packet packet;
+                while (server.receive(packet) == TGE::Socket::Done)
+                    server.send(packet);
+            });
+            echo.launch();
+
+            TGE::Packet packet;
+            std::vector<TGE::Int64> samples;
+            samples.reserve(RoundTrips);
+
+            double cpu = getCpuTime();
+            TGE::Clock clock;
+            for (std::size_t i = 0; i < RoundTrips; ++i)
+            {
+                fillPacket(packet, sizes[s]);
+                TGE::Int64 start = clock.getElapsedTime().asMicroseconds();
+                if ((client.send(packet) != TGE::Socket::Done) || (client.receive(packet) != TGE::Socket::Done))
+                    break;
+                samples.push_back(clock.getElapsedTime().asMicroseconds() - start);
+            }
+            cpu = getCpuTime() - cpu;
+
+            client.disconnect();
+            echo.wait();
+
+            if (!samples.empty())
+                printLatencies("tcp", sizes[s], samples, cpu);
+        }
+    }
+
+
+    ////////////////////////////////////////////////////////////
+    void benchmarkUdpThroughput()
+    {
+        std::printf("\n-- UDP throughput, batches of %u datagrams --\n", static_cast<unsigned int>(BatchSize));
+
+        const std::size_t sizes[] = {16, 64, 256, 1024};
+        for (std::size_t s = 0; s < 4; ++s)
+        {
+            std::size_t size = sizes[s];
+            std::size_t count = messageCount - messageCount % BatchSize;
+
+            TGE::UdpSocket sender;
+            TGE::UdpSocket receiver;
+            if ((sender.bind(TGE::Socket::AnyPort) != TGE::Socket::Done) || (receiver.bind(port) != TGE::Socket::Done))
+            {
+                std::printf("cannot bind port %u\n", port);
+                return;
+            }
+
+            // The receiver stops after a silence, the datagrams it missed were dropped
+            std::size_t received = 0;
+            TGE::Int64 lastReceived = 0;
+            TGE::Clock clock;
+            TGE::Thread thread([&]()
+            {
+                TGE::SocketSelector selector;
+                selector.add(receiver);
+                receiver.setBlocking(false);
+
+                std::vector<TGE::UdpSocket::Datagram> datagrams;
+                while ((received < count) && selector.wait(UdpSilence))
+                {
+                    while (receiver.receive(datagrams) == TGE::Socket::Done)
+                        received += datagrams.size();
+                    lastReceived = clock.getElapsedTime().asMicroseconds();
+                }
+            });
+
+            std::vector<TGE::Packet> packets(BatchSize);
+            std::vector<TGE::UdpSocket::Datagram> batch;
+            for (std::vector<TGE::Packet>::iterator it = packets.begin(); it != packets.end(); ++it)
+            {
+                fillPacket(*it, size);
+                batch.push_back(TGE::UdpSocket::Datagram(*it, TGE::IpAddress::LocalHost, port));
+            }
+
+            double cpu = getCpuTime();
+            clock.restart();
+            thread.launch();
+            for (std::size_t sent = 0; sent < count; )
+            {
+                std::size_t done = 0;
+                TGE::Socket::Status status = sender.send(&batch[0], BatchSize, done);
+                sent += done;
+                if ((status != TGE::Socket::Done) && (status != TGE::Socket::Partial))
+                    break;
+            }
+            thread.wait();
+            cpu = getCpuTime() - cpu;
+            double elapsed = lastReceived / 1e6;
+
+            std::printf("%6u B   %9.0f msg/s   %8.1f MB/s   cpu %5.2f us/msg   delivered %5.1f%%\n",
+                        static_cast<unsigned int>(size),
+                        received / elapsed,
+                        received * size / elapsed / (1024 * 1024),
+                        cpu * 1e6 / count,
+                        100.0 * received / count);
+        }
+    }
+
+
+    ////////////////////////////////////////////////////////////
+    void benchmarkUdpLatency()
+    {
+        std::printf("\n-- UDP round trips --\n");
+
+        const std::size_t sizes[] = {16, 1024};
+        for (std::size_t s = 0; s < 2; ++s)
+        {
+            TGE::UdpSocket client;
+            TGE::UdpSocket server;
+            if ((client.bind(TGE::Socket::AnyPort) != TGE::Socket::Done) || (server.bind(port) != TGE::Socket::Done))
+            {
+                std::printf("cannot bind port %u\n", port);
+                return;
+            }
+
+            // An empty datagram stops the echo
+            TGE::Thread echo([&]()
+            {
+                TGE::Packet packet;
+                TGE::IpAddress address;
+                unsigned short remotePort;
+                while ((server.receive(packet, address, remotePort) == TGE::Socket::Done) && (packet.getDataSize() > 0))
+                    server.send(packet, address, remotePort);
+            });
+            echo.launch();
+
+            TGE::Packet packet;
+            TGE::IpAddress address;
+            unsigned short remotePort;
+            std::vector<TGE::Int64> samples;
+            samples.reserve(RoundTrips);
+
+            double cpu = getCpuTime();
+            TGE::Clock clock;
+            for (std::size_t i = 0; i < RoundTrips; ++i)
+            {
+                fillPacket(packet, sizes[s]);
+                TGE::Int64 start = clock.getElapsedTime().asMicroseconds();
+                if ((client.send(packet, TGE::IpAddress::LocalHost, port) != TGE::Socket::Done) ||
+                    (client.receive(packet, address, remotePort) != TGE::Socket::Done))
+                    break;
+                samples.push_back(clock.getElapsedTime().asMicroseconds() - start);
+            }
+            cpu = getCpuTime() - cpu;
+
+            packet.clear();
+            client.send(packet, TGE::IpAddress::LocalHost, port);
+            echo.wait();
+
+            if (!samples.empty())
+                printLatencies("udp", sizes[s], samples, cpu);
+        }
+    }
+
+
+    ////////////////////////////////////////////////////////////
+    void benchmarkSelector()
+    {
+        std::printf("\n-- Selector wait, one ready socket --\n");
+
+        const std::size_t counts[] = {16, 256, 1024};
+        for (std::size_t c = 0; c < 3; ++c)
+        {
+            std::vector<TGE::UdpSocket*> sockets;
+            TGE::SocketSelector selector;
+            for (std::size_t i = 0; i < counts[c]; ++i)
+            {
+                TGE::UdpSocket* socket = new TGE::UdpSocket;
+                socket->bind(TGE::Socket::AnyPort);
+                selector.add(*socket);
+                sockets.push_back(socket);
+            }
+
+            // The datagram is never read, the last socket stays ready
+            TGE::UdpSocket sender;
+            char byte = 0;
+            sender.send(&byte, 1, TGE::IpAddress::LocalHost, sockets.back()->getLocalPort());
+            selector.wait(TGE::milliseconds(100));
+
+            const std::size_t waits = 10000;
+            TGE::Clock clock;
+            for (std::size_t i = 0; i < waits; ++i)
+                selector.wait(TGE::milliseconds(100));
+            double elapsed = clock.getElapsedTime().asSeconds();
+
+            std::printf("%5u sockets   %7.2f us/wait\n", static_cast<unsigned int>(counts[c]), elapsed * 1e6 / waits);
+
+            for (std::vector<TGE::UdpSocket*>::iterator it = sockets.begin(); it != sockets.end(); ++it)
+                delete *it;
+        }
+    }
+
+
+#if defined(OS_LINUX)
+
+    ////////////////////////////////////////////////////////////
+    /// UDP socket giving access to its handle, for poll()
+    ////////////////////////////////////////////////////////////
+    class HandleSocket : public TGE::UdpSocket
+    {
+    public :
+
+        using TGE::UdpSocket::getHandle;
+    };
+
+    ////////////////////////////////////////////////////////////
+    void benchmarkIdleServer()
+    {
+        std::printf("\n-- Selector wait, %u idle and %u active sockets --\n",
+                    static_cast<unsigned int>(IdleSockets),
+                    static_cast<unsigned int>(ActiveSockets));
+
+        // The default limit of open files is often 1024
+        std::size_t total = IdleSockets + ActiveSockets;
+        rlimit limit;
+        if ((getrlimit(RLIMIT_NOFILE, &limit) == 0) && (limit.rlim_cur < total + 64))
+        {
+            limit.rlim_cur = std::min<rlim_t>(total + 64, limit.rlim_max);
+            setrlimit(RLIMIT_NOFILE, &limit);
+        }
+
+        // The active sockets are spread among the idle ones
+        std::vector<HandleSocket> sockets(total);
+        std::vector<HandleSocket*> active;
+        TGE::SocketSelector selector;
+        std::vector<pollfd> handles;
+        for (std::size_t i = 0; i < total; ++i)
+        {
+            if (sockets[i].bind(TGE::Socket::AnyPort) != TGE::Socket::Done)
+            {
+                std::printf("cannot open %u sockets (open files limit)\n", static_cast<unsigned int>(total));
+                return;
+            }
+
+            selector.add(sockets[i]);
+            pollfd handle = {sockets[i].getHandle(), POLLIN, 0};
+            handles.push_back(handle);
+            if (i % (total / ActiveSockets) == 0)
+                active.push_back(&sockets[i]);
+        }
+
+        // The datagrams are never read, the active sockets stay ready
+        TGE::UdpSocket sender;
+        char byte = 0;
+        for (std::vector<HandleSocket*>::iterator it = active.begin(); it != active.end(); ++it)
+            sender.send(&byte, 1, TGE::IpAddress::LocalHost, (*it)->getLocalPort());
+        TGE::sleep(TGE::milliseconds(50));
+
+        // Each wait also finds the ready sockets, as a server would
+        const std::size_t waits = 1000;
+        std::size_t found = 0;
+        TGE::Clock clock;
+        for (std::size_t i = 0; i < waits; ++i)
+        {
+            selector.wait(TGE::milliseconds(100));
+            for (std::size_t j = 0; j < selector.getReadyCount(); ++j)
+                found += (&selector.getReadySocket(j) != NULL);
+        }
+        double elapsed = clock.getElapsedTime().asSeconds();
+        std::printf("epoll          %9.2f us/wait   %u ready\n", elapsed * 1e6 / waits, static_cast<unsigned int>(found / waits));
+
+        // select() cannot hold handles above FD_SETSIZE (1024), poll()
+        // has the same cost: every handle is given and scanned on each wait
+        found = 0;
+        clock.restart();
+        for (std::size_t i = 0; i < waits; ++i)
+        {
+            poll(&handles[0], handles.size(), 100);
+            for (std::vector<pollfd>::const_iterator it = handles.begin(); it != handles.end(); ++it)
+                found += (it->revents & POLLIN) ? 1 : 0;
+        }
+        elapsed = clock.getElapsedTime().asSeconds();
+        std::printf("select (poll)  %9.2f us/wait   %u ready\n", elapsed * 1e6 / waits, static_cast<unsigned int>(found / waits));
+    }
+
+#endif
+
+    ////////////////////////////////////////////////////////////
+    void benchmarkConditionedConnection()
+    {
+        std::printf("\n-- Reliable messages through a conditioned link --\n");
+        std::printf("40 ms latency, 10 ms jitter, 5%% loss, 2%% reordering, 256 KB/s, each way\n");
+
+        TGE::UdpSocket clientSocket;
+        TGE::UdpSocket serverSocket;
+        if ((clientSocket.bind(TGE::Socket::AnyPort) != TGE::Socket::Done) || (serverSocket.bind(port) != TGE::Socket::Done))
+        {
+            std::printf("cannot bind port %u\n", port);
+            return;
+        }
+        clientSocket.setBlocking(false);
+        serverSocket.setBlocking(false);
+
+        TGE::LinkConditioner clientLink(clientSocket, 1);
+        TGE::LinkConditioner serverLink(serverSocket, 2);
+        TGE::LinkConditioner* links[] = {&clientLink, &serverLink};
+        for (std::size_t i = 0; i < 2; ++i)
+        {
+            links[i]->setLatency(TGE::milliseconds(40));
+            links[i]->setJitter(TGE::milliseconds(10));
+            links[i]->setLoss(0.05f);
+            links[i]->setReordering(0.02f);
+            links[i]->setBandwidth(256 * 1024);
+        }
+
+        TGE::UdpConnection client(clientSocket, TGE::IpAddress::LocalHost, port);
+        TGE::UdpConnection server(serverSocket, TGE::IpAddress::LocalHost, clientSocket.getLocalPort());
+        client.setLinkConditioner(&clientLink);
+        server.setLinkConditioner(&serverLink);
+
+        // A 100 byte message every 10 ms, like a game sending its
+        // inputs; all must arrive in order
+        const TGE::Uint32 messages = 400;
+        const TGE::Int64 interval = 10000;
+        TGE::Uint32 sent = 0;
+        TGE::Uint32 expected = 0;
+        bool ordered = true;
+        TGE::Packet packet;
+        TGE::IpAddress address;
+        unsigned short remotePort;
+        TGE::Packet padding;
+        std::vector<TGE::Int64> sendTimes;
+        std::vector<TGE::Int64> delays;
+
+        TGE::Clock clock;
+        while ((expected < messages) && (clock.getElapsedTime() < TGE::seconds(30)))
+        {
+            TGE::Int64 now = clock.getElapsedTime().asMicroseconds();
+            if ((sent < messages) && (now >= sent * interval))
+            {
+                packet.clear();
+                packet << sent;
+                fillPacket(padding, 96);
+                packet.append(padding.getData(), padding.getDataSize());
+                client.send(packet, TGE::UdpConnection::ReliableOrdered);
+                sendTimes.push_back(now);
+                sent++;
+            }
+
+            client.update();
+            server.update();
+
+            while (clientSocket.receive(packet, address, remotePort) == TGE::Socket::Done)
+                client.processDatagram(packet);
+            while (serverSocket.receive(packet, address, remotePort) == TGE::Socket::Done)
+                server.processDatagram(packet);
+
+            while (server.receive(packet))
+            {
+                TGE::Uint32 index;
+                packet >> index;
+                ordered = ordered && (index == expected);
+                if (index < sendTimes.size())
+                    delays.push_back(clock.getElapsedTime().asMicroseconds() - sendTimes[index]);
+                expected++;
+            }
+
+            TGE::sleep(TGE::microseconds(200));
+        }
+
+        std::printf("delivered %u/%u, %s\n", expected, messages, ordered ? "in order" : "OUT OF ORDER");
+        std::printf("dropped by the links: %u and %u datagrams\n",
+                    static_cast<unsigned int>(clientLink.getDroppedCount()),
+                    static_cast<unsigned int>(serverLink.getDroppedCount()));
+        std::printf("round trip %.1f ms, estimated loss %.1f%%, send rate %u B/s\n",
+                    client.getRoundTripTime().asSeconds() * 1000,
+                    client.getPacketLoss() * 100,
+                    client.getSendRate());
+        if (!delays.empty())
+            std::printf("delivery   p50 %6.1f ms   p99 %6.1f ms\n", getPercentile(delays, 0.5) / 1000, getPercentile(delays, 0.99) / 1000);
+    }
+}
+
+
+////////////////////////////////////////////////////////////
+int main(int argc, char* argv[])
+{
+    if (argc > 1)
+        port = static_cast<unsigned short>(std::atoi(argv[1]));
+    if (argc > 2)
+        messageCount = std::max(std::atoi(argv[2]), 1000);
+
+    std::printf("Tyrant network benchmark, loopback, port %u, %u messages per run\n", port, static_cast<unsigned int>(messageCount));
+
+    benchmarkPacket();
+    benchmarkTcpThroughput();
+    benchmarkTcpReceive();
+    benchmarkTcpLatency();
+    benchmarkUdpThroughput();
+    benchmarkUdpLatency();
+    benchmarkSelector();
+#if defined(OS_LINUX)
+    benchmarkIdleServer();
+#endif
+    benchmarkConditionedConnection();
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,305 @@
+/*************************************/
+/** Copyright © 2014 Coldsnap Games **/
+/*************************************/
+
+/*************************************/
+/**             Headers             **/
+/*************************************/
+#include <Tyrant/Network.hpp>
+#include <Tyrant/System/Clock.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+
+////////////////////////////////////////////////////////////
+/// Compares the bandwidth of a game snapshot written with
+/// TGE::Packet and with TGE::BitWriter: bytes per snapshot,
+/// the resulting bit rate for one client, and the time to
+/// write and read it back. Both formats are read back and
+/// checked, the quantized values within half a step.
+///
+/// Usage: SerializationBenchmark [entities] [snapshots]
+///
+////////////////////////////////////////////////////////////
+namespace
+{
+    // Snapshots sent to each client per second
+    const double SnapshotRate = 20;
+
+    // Ranges and precision of the quantized fields
+    const float WorldSize = 1024.f;
+    const unsigned int PositionBits = 18;
+    const float MaxSpeed = 64.f;
+    const unsigned int VelocityBits = 12;
+    const unsigned int YawBits = 10;
+
+    std::size_t entityCount = 64;
+    std::size_t snapshotCount = 20000;
+    int failures = 0;
+    volatile std::size_t sink = 0;
+
+    struct Entity
+    {
+        TGE::Uint16   id;
+        TGE::Vector3f position;
+        float         yaw;
+        TGE::Vector3f velocity;
+        TGE::Int32    health;
+        bool          visible;
+        bool          firing;
+        bool          crouching;
+        std::string   name;
+    };
+
+    // Entities spread over the world, with deterministic values
+    std::vector<Entity> makeEntities()
+    {
+        std::srand(42);
+        std::vector<Entity> entities(entityCount);
+        for (std::size_t i = 0; i < entities.size(); ++i)
+        {
+            Entity& entity = entities[i];
+            entity.id        = static_cast<TGE::Uint16>(i * 7 + 3);
+            entity.position  = TGE::Vector3f(std::rand() % 2000 - 1000.f, std::rand() % 100 * 0.37f, std::rand() % 2000 - 1000.f);
+            entity.yaw       = std::rand() % 3600 / 10.f;
+            entity.velocity  = TGE::Vector3f(std::rand() % 120 - 60.f, 0.f, std::rand() % 120 - 60.f);
+            entity.health    = std::rand() % 101;
+            entity.visible   = (std::rand() % 2) == 0;
+            entity.firing    = (std::rand() % 5) == 0;
+            entity.crouching = (std::rand() % 3) == 0;
+            entity.name      = "player" + std::string(1, static_cast<char>('a' + i % 26));
+        }
+
+        return entities;
+    }
+
+    void check(bool condition, const char* what)
+    {
+        if (!condition)
+        {
+            std::printf("FAILED: %s\n", what);
+            failures++;
+        }
+    }
+
+    bool isClose(float left, float right, float min, float max, unsigned int bitCount)
+    {
+        return std::fabs(left - right) <= (max - min) / ((1u << bitCount) - 1) * 0.5f + 1e-3f;
+    }
+
+
+    ////////////////////////////////////////////////////////////
+    void writePacket(TGE::Packet& packet, const std::vector<Entity>& entities, bool names)
+    {
+        packet << static_cast<TGE::Uint16>(entities.size());
+        for (std::vector<Entity>::const_iterator it = entities.begin(); it != entities.end(); ++it)
+        {
+            packet << it->id
+                   << it->position.x << it->position.y << it->position.z
+                   << it->yaw
+                   << it->velocity.x << it->velocity.y << it->velocity.z
+                   << static_cast<TGE::Uint8>(it->health)
+                   << it->visible << it->firing << it->crouching;
+            if (names)
+                packet << it->name;
+        }
+    }
+
+    void readPacket(TGE::Packet& packet, std::vector<Entity>& entities, bool names)
+    {
+        TGE::Uint16 count = 0;
+        packet >> count;
+        entities.resize(count);
+        for (std::vector<Entity>::iterator it = entities.begin(); it != entities.end(); ++it)
+        {
+            TGE::Uint8 health = 0;
+            packet >> it->id
+                   >> it->position.x >> it->position.y >> it->position.z
+                   >> it->yaw
+                   >> it->velocity.x >> it->velocity.y >> it->velocity.z
+                   >> health
+                   >> it->visible >> it->firing >> it->crouching;
+            it->health = health;
+            if (names)
+                packet >> it->name;
+        }
+    }
+
+
+    ////////////////////////////////////////////////////////////
+    void writeBits(TGE::Packet& packet, const std::vector<Entity>& entities, bool names)
+    {
+        TGE::BitWriter writer(packet);
+        writer.writeVarint(static_cast<TGE::Uint32>(entities.size()));
+        for (std::vector<Entity>::const_iterator it = entities.begin(); it != entities.end(); ++it)
+        {
+            writer.writeVarint(it->id);
+            writer.writeVector(it->position, -WorldSize, WorldSize, PositionBits);
+            writer.writeFloat(it->yaw, 0.f, 360.f, YawBits);
+            writer.writeVector(it->velocity, -MaxSpeed, MaxSpeed, VelocityBits);
+            writer.writeInteger(it->health, 0, 100);
+            writer.write(it->visible);
+            writer.write(it->firing);
+            writer.write(it->crouching);
+            if (names)
+                writer.writeString(it->name);
+        }
+        writer.flush();
+    }
+
+    void readBits(TGE::Packet& packet, std::vector<Entity>& entities, bool names)
+    {
+        TGE::BitReader reader(packet);
+        entities.resize(reader.readVarint());
+        for (std::vector<Entity>::iterator it = entities.begin(); it != entities.end(); ++it)
+        {
+            it->id        = static_cast<TGE::Uint16>(reader.readVarint());
+            it->position  = reader.readVector3(-WorldSize, WorldSize, PositionBits);
+            it->yaw       = reader.readFloat(0.f, 360.f, YawBits);
+            it->velocity  = reader.readVector3(-MaxSpeed, MaxSpeed, VelocityBits);
+            it->health    = reader.readInteger(0, 100);
+            it->visible   = reader.readBool();
+            it->firing    = reader.readBool();
+            it->crouching = reader.readBool();
+            if (names)
+                reader.readString(it->name);
+        }
+    }
+
+
+    ////////////////////////////////////////////////////////////
+    void checkEntities(const std::vector<Entity>& sent, const std::vector<Entity>& received, bool names, bool quantized)
+    {
+        check(sent.size() == received.size(), "number of entities");
+        for (std::size_t i = 0; (i < sent.size()) && (i < received.size()); ++i)
+        {
+            const Entity& a = sent[i];
+            const Entity& b = received[i];
+            bool positions = quantized ? isClose(a.position.x, b.position.x, -WorldSize, WorldSize, PositionBits) &&
+                                         isClose(a.position.y, b.position.y, -WorldSize, WorldSize, PositionBits) &&
+                                         isClose(a.position.z, b.position.z, -WorldSize, WorldSize, PositionBits) &&
+                                         isClose(a.yaw, b.yaw, 0.f, 360.f, YawBits) &&
+                                         isClose(a.velocity.x, b.velocity.x, -MaxSpeed, MaxSpeed, VelocityBits) &&
+                                         isClose(a.velocity.z, b.velocity.z, -MaxSpeed, MaxSpeed, VelocityBits)
+                                       : (a.position == b.position) && (a.yaw == b.yaw) && (a.velocity == b.velocity);
+
+            check(positions, "positions, yaw and velocity read back");
+            check((a.id == b.id) && (a.health == b.health), "id and health read back");
+            check((a.visible == b.visible) && (a.firing == b.firing) && (a.crouching == b.crouching), "flags read back");
+            check(!names || (a.name == b.name), "name read back");
+        }
+    }
+
+    typedef void (*Writer)(TGE::Packet&, const std::vector<Entity>&, bool);
+    typedef void (*Reader)(TGE::Packet&, std::vector<Entity>&, bool);
+
+    // Write and read a snapshot many times, and return its size
+    std::size_t measure(const char* name, Writer write, Reader read, const std::vector<Entity>& entities, bool names, bool quantized)
+    {
+        TGE::Packet packet;
+        std::vector<Entity> received;
+
+        TGE::Clock clock;
+        for (std::size_t i = 0; i < snapshotCount; ++i)
+        {
+            packet.clear();
+            write(packet, entities, names);
+        }
+        double writeTime = clock.getElapsedTime().asSeconds();
+
+        // Reading a packet consumes it: each read gets a copy, whose
+        // cost is measured alone and taken out
+        clock.restart();
+        for (std::size_t i = 0; i < snapshotCount; ++i)
+        {
+            TGE::Packet copy(packet);
+            read(copy, received, names);
+        }
+        double readTime = clock.getElapsedTime().asSeconds();
+
+        clock.restart();
+        for (std::size_t i = 0; i < snapshotCount; ++i)
+        {
+            TGE::Packet copy(packet);
+            sink += copy.getDataSize();
+        }
+        readTime = std::max(readTime - clock.getElapsedTime().asSeconds(), 0.0);
+
+        checkEntities(entities, received, names, quantized);
+
+        std::size_t size = packet.getDataSize();
+        std::printf("%-10s %6u B/snapshot   %8.1f kbit/s per client   write %6.2f us   read %6.2f us\n",
+                    name,
+                    static_cast<unsigned int>(size),
+                    size * 8 * SnapshotRate / 1000,
+                    writeTime * 1e6 / snapshotCount,
+                    readTime * 1e6 / snapshotCount);
+
+        return size;
+    }
+
+
+    ////////////////////////////////////////////////////////////
+    // Quantized floats at the limits: no bit, an empty range, out of the range, 32 bits
+    void checkQuantizationLimits()
+    {
+        TGE::Packet packet;
+        TGE::BitWriter writer(packet);
+        writer.writeFloat(5.f, -1.f, 1.f, 0);
+        writer.writeFloat(5.f, 2.f, 2.f, 8);
+        writer.writeFloat(-7.f, -1.f, 1.f, 8);
+        writer.writeFloat(0.123456f, 0.f, 1.f, 32);
+        writer.flush();
+
+        TGE::BitReader reader(packet);
+        check(reader.readFloat(-1.f, 1.f, 0) == -1.f, "float without any bit read back as the minimum");
+        check(reader.readFloat(2.f, 2.f, 8) == 2.f, "float of an empty range read back as the minimum");
+        check(reader.readFloat(-1.f, 1.f, 8) == -1.f, "float out of the range clamped");
+        check(std::fabs(reader.readFloat(0.f, 1.f, 32) - 0.123456f) < 1e-6f, "float on 32 bits read back");
+        check(reader, "quantized floats read within the packet");
+    }
+
+
+    ////////////////////////////////////////////////////////////
+    void benchmarkSnapshot(bool names)
+    {
+        std::printf("\n-- Snapshot of %u entities, %s, %.0f per second --\n",
+                    static_cast<unsigned int>(entityCount),
+                    names ? "with names" : "without names",
+                    SnapshotRate);
+
+        std::vector<Entity> entities = makeEntities();
+        std::size_t packetSize = measure("Packet", &writePacket, &readPacket, entities, names, false);
+        std::size_t bitSize = measure("BitWriter", &writeBits, &readBits, entities, names, true);
+
+        std::printf("BitWriter snapshots are %.2fx smaller\n", static_cast<double>(packetSize) / bitSize);
+    }
+}
+
+
+////////////////////////////////////////////////////////////
+int main(int argc, char* argv[])
+{
+    if (argc > 1)
+        entityCount = std::max(std::atoi(argv[1]), 1);
+    if (argc > 2)
+        snapshotCount = std::max(std::atoi(argv[2]), 100);
+
+    std::printf("Tyrant serialization benchmark, %u snapshots per run\n", static_cast<unsigned int>(snapshotCount));
+
+    checkQuantizationLimits();
+    benchmarkSnapshot(true);
+    benchmarkSnapshot(false);
+
+    if (failures > 0)
+    {
+        std::printf("%d values were not read back correctly\n", failures);
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -15,6 +15,7 @@
 #include <Tyrant/Audio/Sound.hpp>
 #include <Tyrant/Audio/SoundBuffer.hpp>
 #include <Tyrant/Audio/SoundBufferRecorder.hpp>
+#include <Tyrant/Audio/SoundMixer.hpp>
 #include <Tyrant/Audio/SoundRecorder.hpp>
 #include <Tyrant/Audio/SoundStream.hpp>
 
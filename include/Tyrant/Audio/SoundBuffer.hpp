@@ -259,10 +259,12 @@ private :
     ////////////////////////////////////////////////////////////
     // Member data
     ////////////////////////////////////////////////////////////
-    unsigned int       m_buffer;   ///< OpenAL buffer identifier
-    std::vector<Int16> m_samples;  ///< Samples buffer
-    Time               m_duration; ///< Sound duration
-    mutable SoundList  m_sounds;   ///< List of sounds that are using this buffer
+    unsigned int       m_buffer;       ///< OpenAL buffer identifier
+    std::vector<Int16> m_samples;      ///< Samples buffer
+    unsigned int       m_sampleRate;   ///< Number of samples per second
+    unsigned int       m_channelCount; ///< Number of channels (1 = mono, 2 = stereo, ...)
+    Time               m_duration;     ///< Sound duration
+    mutable SoundList  m_sounds;       ///< List of sounds that are using this buffer
 };
 
 } // namespace TGE
@@ -0,0 +1,463 @@
+/*************************************/
+/** Copyright © 2014 Coldsnap Games **/
+/*************************************/
+
+#ifndef TGE_SOUNDMIXER_HPP
+#define TGE_SOUNDMIXER_HPP
+
+/*************************************/
+/**             Headers             **/
+/*************************************/
+#include <Tyrant/Config.hpp>
+#include <Tyrant/System/Mutex.hpp>
+#include <Tyrant/System/NonCopyable.hpp>
+#include <Tyrant/System/Vector3.hpp>
+#include <cstdlib>
+#include <utility>
+#include <vector>
+
+
+namespace TGE
+{
+namespace priv
+{
+    class MixerStream;
+}
+
+class SoundBuffer;
+
+////////////////////////////////////////////////////////////
+/// \brief Mixes many sounds in software, and plays the mix
+///        with a single audio source
+///
+////////////////////////////////////////////////////////////
+class TGE_API SoundMixer : NonCopyable
+{
+public :
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Handle of a voice, 0 is never a valid voice
+    ///
+    ////////////////////////////////////////////////////////////
+    typedef Uint32 VoiceId;
+
+    enum
+    {
+        BusCount = 8 ///< Number of buses, each voice plays on one of them
+    };
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Construct the mixer
+    ///
+    /// The mixer doesn't play anything until startOutput() is
+    /// called; without an output, the mix can be read with
+    /// render().
+    ///
+    /// \param sampleRate Sample rate of the mix, in samples per second
+    ///
+    ////////////////////////////////////////////////////////////
+    explicit SoundMixer(unsigned int sampleRate = 44100);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Destructor
+    ///
+    ////////////////////////////////////////////////////////////
+    ~SoundMixer();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Start playing the mix through an audio source
+    ///
+    /// The mix is streamed from its own thread, like a
+    /// TGE::SoundStream, with about 70 ms of latency.
+    ///
+    /// \return True if the output started
+    ///
+    /// \see stopOutput, render
+    ///
+    ////////////////////////////////////////////////////////////
+    bool startOutput();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Stop playing the mix
+    ///
+    /// The voices are kept, and continue when the output starts
+    /// again.
+    ///
+    ////////////////////////////////////////////////////////////
+    void stopOutput();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Set the maximum number of voices actually mixed
+    ///
+    /// When more voices play, only the most audible ones are
+    /// mixed; the others are virtual: they keep their playing
+    /// position but cost almost nothing, and become real again
+    /// when they are among the most audible. The default is 32.
+    ///
+    /// \param count Maximum number of voices mixed at once
+    ///
+    ////////////////////////////////////////////////////////////
+    void setMixedVoiceCount(unsigned int count);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Start playing a sound buffer
+    ///
+    /// The buffer must stay alive and unchanged while the voice
+    /// plays. Mono buffers can be spatialized, stereo buffers
+    /// are played as they are.
+    ///
+    /// \param buffer   Sound buffer to play, mono or stereo
+    /// \param bus      Bus to play on, less than BusCount
+    /// \param priority Importance of the voice; the voices
+    ///                 mixed are the ones with the highest
+    ///                 priority times gain
+    ///
+    /// \return Handle of the new voice, 0 if the buffer can't
+    ///         be played
+    ///
+    ////////////////////////////////////////////////////////////
+    VoiceId play(const SoundBuffer& buffer, unsigned int bus = 0, float priority = 1.f);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Stop a voice
+    ///
+    /// Its handle becomes invalid.
+    ///
+    /// \param voice Voice to stop
+    ///
+    ////////////////////////////////////////////////////////////
+    void stop(VoiceId voice);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Stop all the voices
+    ///
+    ////////////////////////////////////////////////////////////
+    void stopAll();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Tell whether a voice is still playing
+    ///
+    /// \param voice Voice to check
+    ///
+    /// \return True if the voice plays, mixed or virtual
+    ///
+    ////////////////////////////////////////////////////////////
+    bool isPlaying(VoiceId voice) const;
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Tell whether a voice is virtual
+    ///
+    /// \param voice Voice to check
+    ///
+    /// \return True if the voice plays but is not mixed
+    ///
+    ////////////////////////////////////////////////////////////
+    bool isVirtual(VoiceId voice) const;
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Set the volume of a voice
+    ///
+    /// \param voice  Voice to change
+    /// \param volume Volume factor, 1 for the volume of the buffer
+    ///
+    ////////////////////////////////////////////////////////////
+    void setVolume(VoiceId voice, float volume);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Set the pitch of a voice
+    ///
+    /// \param voice Voice to change
+    /// \param pitch Speed factor, 1 for the normal speed
+    ///
+    ////////////////////////////////////////////////////////////
+    void setPitch(VoiceId voice, float pitch);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Set whether a voice restarts when it reaches its end
+    ///
+    /// \param voice Voice to change
+    /// \param loop  True to play in loop
+    ///
+    ////////////////////////////////////////////////////////////
+    void setLoop(VoiceId voice, bool loop);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Set the position of a voice in the scene
+    ///
+    /// A voice with a position is attenuated with the distance
+    /// to the listener, and panned to its side. The voices
+    /// without position play at full volume in the center.
+    ///
+    /// \param voice    Voice to change
+    /// \param position Position of the voice
+    ///
+    ////////////////////////////////////////////////////////////
+    void setPosition(VoiceId voice, const Vector3f& position);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Set how a voice fades with the distance
+    ///
+    /// The attenuation is the same as TGE::SoundSource's: full
+    /// volume up to the minimum distance, then decreasing as
+    /// minDistance / (minDistance + attenuation * (distance - minDistance)).
+    /// The defaults are 1 and 1.
+    ///
+    /// \param voice       Voice to change
+    /// \param minDistance Distance under which the voice is at
+    ///                    full volume
+    /// \param attenuation Attenuation factor, 0 for none
+    ///
+    ////////////////////////////////////////////////////////////
+    void setAttenuation(VoiceId voice, float minDistance, float attenuation);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Set the volume of a bus
+    ///
+    /// Buses group the voices, like music, effects and dialogs,
+    /// so that their volumes can be set together.
+    ///
+    /// \param bus    Bus to change, less than BusCount
+    /// \param volume Volume factor of the voices of the bus
+    ///
+    ////////////////////////////////////////////////////////////
+    void setBusVolume(unsigned int bus, float volume);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Get the volume of a bus
+    ///
+    /// \param bus Bus to query, less than BusCount
+    ///
+    /// \return Volume factor of the bus
+    ///
+    ////////////////////////////////////////////////////////////
+    float getBusVolume(unsigned int bus) const;
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Set the position of the listener
+    ///
+    /// \param position Position of the listener
+    ///
+    ////////////////////////////////////////////////////////////
+    void setListenerPosition(const Vector3f& position);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Set the direction the listener faces
+    ///
+    /// The up vector is always (0, 1, 0). The default direction
+    /// is (0, 0, -1), like TGE::Listener's.
+    ///
+    /// \param direction Direction of the listener
+    ///
+    ////////////////////////////////////////////////////////////
+    void setListenerDirection(const Vector3f& direction);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Update the gains of the voices and choose the
+    ///        ones to mix
+    ///
+    /// The distances, pans and volumes of all the voices are
+    /// computed together, once per call; this function should
+    /// be called once per frame, after moving the voices.
+    ///
+    ////////////////////////////////////////////////////////////
+    void update();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Mix the next samples
+    ///
+    /// The output calls this function from its own thread. It
+    /// can also be called directly, without output, to mix
+    /// offline or to test the mixer without an audio device.
+    /// The voices advance by \a frameCount frames.
+    ///
+    /// \param samples    Array receiving the stereo samples,
+    ///                   left then right, 2 * frameCount samples
+    /// \param frameCount Number of frames to mix
+    ///
+    ////////////////////////////////////////////////////////////
+    void render(Int16* samples, std::size_t frameCount);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Get the sample rate of the mix
+    ///
+    /// \return Sample rate, in samples per second
+    ///
+    ////////////////////////////////////////////////////////////
+    unsigned int getSampleRate() const;
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Get the number of voices playing
+    ///
+    /// \return Number of voices, mixed or virtual
+    ///
+    ////////////////////////////////////////////////////////////
+    std::size_t getVoiceCount() const;
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Get the number of voices mixed
+    ///
+    /// \return Number of voices which are not virtual
+    ///
+    ////////////////////////////////////////////////////////////
+    std::size_t getMixedVoiceCount() const;
+
+private :
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Sound being played
+    ///
+    ////////////////////////////////////////////////////////////
+    struct Voice
+    {
+        const Int16* samples;      ///< Samples of the buffer
+        std::size_t  frameCount;   ///< Number of frames of the buffer
+        unsigned int channelCount; ///< Number of channels of the buffer, 1 or 2
+        float        rate;         ///< Ratio of the buffer's sample rate to the mixer's
+        double       offset;       ///< Playing position, in frames of the buffer
+        float        volume;       ///< Volume factor
+        float        pitch;        ///< Speed factor
+        float        priority;     ///< Importance of the voice
+        unsigned int bus;          ///< Bus of the voice
+        bool         loop;         ///< Does the voice restart at its end?
+        bool         spatial;      ///< Does the voice have a position?
+        Vector3f     position;     ///< Position of the voice in the scene
+        float        minDistance;  ///< Distance under which the voice is at full volume
+        float        attenuation;  ///< Attenuation factor with the distance
+        float        left;         ///< Gain of the left channel
+        float        right;        ///< Gain of the right channel
+        float        mixedLeft;    ///< Gain of the left channel at the end of the last mix
+        float        mixedRight;   ///< Gain of the right channel at the end of the last mix
+        bool         active;       ///< Is the voice playing?
+        bool         mixed;        ///< Is the voice mixed, rather than virtual?
+        Uint16       generation;   ///< Incremented each time the slot is reused
+    };
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Get the voice of a handle
+    ///
+    /// \param voice Handle of the voice
+    ///
+    /// \return Pointer to the voice, NULL if it doesn't play
+    ///
+    ////////////////////////////////////////////////////////////
+    Voice* findVoice(VoiceId voice);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Get the voice of a handle
+    ///
+    /// \param voice Handle of the voice
+    ///
+    /// \return Pointer to the voice, NULL if it doesn't play
+    ///
+    ////////////////////////////////////////////////////////////
+    const Voice* findVoice(VoiceId voice) const;
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Compute the gains of the channels of a voice
+    ///
+    /// \param voice Voice to update
+    ///
+    ////////////////////////////////////////////////////////////
+    void computeGains(Voice& voice) const;
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Mix a voice into the mix buffer
+    ///
+    /// \param voice      Voice to mix
+    /// \param frameCount Number of frames to mix
+    ///
+    /// \return False if the voice reached its end
+    ///
+    ////////////////////////////////////////////////////////////
+    bool mixVoice(Voice& voice, std::size_t frameCount);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Advance a virtual voice without mixing it
+    ///
+    /// \param voice      Voice to advance
+    /// \param frameCount Number of frames to skip
+    ///
+    /// \return False if the voice reached its end
+    ///
+    ////////////////////////////////////////////////////////////
+    bool skipVoice(Voice& voice, std::size_t frameCount);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Stop a voice and free its slot
+    ///
+    /// \param index Index of the voice
+    ///
+    ////////////////////////////////////////////////////////////
+    void release(std::size_t index);
+
+    ////////////////////////////////////////////////////////////
+    // Member data
+    ////////////////////////////////////////////////////////////
+    unsigned int                                m_sampleRate;           ///< Sample rate of the mix
+    std::size_t                                 m_maxMixed;             ///< Maximum number of voices mixed at once
+    std::size_t                                 m_mixedCount;           ///< Number of voices mixed
+    std::size_t                                 m_activeCount;          ///< Number of voices playing
+    std::vector<Voice>                          m_voices;               ///< Voices, indexed by slot
+    std::vector<std::size_t>                    m_freeSlots;            ///< Slots of the voices which stopped
+    float                                       m_busVolumes[BusCount]; ///< Volume factor of each bus
+    Vector3f                                    m_listenerPosition;     ///< Position of the listener
+    Vector3f                                    m_listenerRight;        ///< Direction of the listener's right ear
+    std::vector<std::pair<float, std::size_t> > m_audibility;           ///< Voices by priority times gain, for choosing the voices to mix
+    std::vector<float>                          m_mix;                  ///< Mix being built, left then right
+    priv::MixerStream*                          m_output;               ///< Audio stream playing the mix, if started
+    mutable Mutex                               m_mutex;                ///< Mutex protecting the voices from the output thread
+};
+
+} // namespace TGE
+
+
+#endif // TGE_SOUNDMIXER_HPP
+
+
+////////////////////////////////////////////////////////////
+/// \class TGE::SoundMixer
+/// \ingroup audio
+///
+/// Every TGE::Sound uses an audio source of the driver, and
+/// drivers only have a few of them, often 32 to 256: in a busy
+/// scene, the sounds played once all the sources are used are
+/// silently dropped, and each source costs mixing time in the
+/// driver. TGE::SoundMixer mixes its voices itself, and plays
+/// the mix with a single streamed source.
+///
+/// Any number of voices can play at once. Only the most
+/// audible ones, by priority times gain, are mixed; the others
+/// are virtual: they keep their playing position, and become
+/// mixed again when the voices louder than them stop or move
+/// away. Voices too quiet to be heard are never mixed. The
+/// gains fade over a mix block when they change, so voices
+/// don't click when they move or switch between mixed and
+/// virtual.
+///
+/// Each voice plays on a bus, whose volume applies to all its
+/// voices. Mono voices can have a position, and are attenuated
+/// and panned from the listener of the mixer, which is
+/// independent from TGE::Listener.
+///
+/// The voice functions are called from the game thread, and
+/// the mix is made by the output thread; render() can also be
+/// called directly to get the mix without any audio device.
+///
+/// Usage example:
+/// \code
+/// TGE::SoundMixer mixer;
+/// mixer.setBusVolume(Effects, 0.8f);
+/// mixer.startOutput();
+///
+/// // When a gun fires
+/// TGE::SoundMixer::VoiceId voice = mixer.play(gunshot, Effects);
+/// mixer.setPosition(voice, TGE::Vector3f(gun.x, gun.y, 0.f));
+///
+/// // Every frame
+/// mixer.setListenerPosition(TGE::Vector3f(camera.x, camera.y, 0.f));
+/// mixer.update();
+/// \endcode
+///
+/// \see TGE::Sound, TGE::SoundBuffer
+///
+////////////////////////////////////////////////////////////
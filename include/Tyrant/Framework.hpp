@@ -10,7 +10,9 @@
 /*************************************/
 
 #include <Tyrant/Framework/Game.hpp>
+#include <Tyrant/Framework/FrameStatistics.hpp>
 #include <Tyrant/Framework/ResourceManager.hpp>
+#include <Tyrant/Framework/SoundInstancePool.hpp>
 #include <Tyrant/Framework/StateManager.hpp>
 #include <Tyrant/Framework/State.hpp>
 #include <Tyrant/Framework/InputMap.hpp>
@@ -0,0 +1,119 @@
+/*************************************/
+/** Copyright © 2014 Coldsnap Games **/
+/*************************************/
+
+#ifndef TGE_FRAMESTATISTICS_HPP
+#define TGE_FRAMESTATISTICS_HPP
+
+/*************************************/
+/**             Headers             **/
+/*************************************/
+#include <Tyrant/Config.hpp>
+#include <Tyrant/System/Time.hpp>
+#include <vector>
+
+namespace TGE
+{
+    ////////////////////////////////////////////////////////////
+    /// \brief Keeps the durations of the most recent frames
+    /// and computes statistics on them.
+    ////////////////////////////////////////////////////////////
+    class TGE_API FrameStatistics
+    {
+        public:
+            ////////////////////////////////////////////////////
+            /// \brief Creates statistics over the given number
+            /// of most recent frames.
+            ////////////////////////////////////////////////////
+            explicit FrameStatistics(unsigned int capacity = 1024);
+
+            ////////////////////////////////////////////////////
+            /// \brief Adds the duration of a frame and the
+            /// number of heap allocations made during it,
+            /// replacing the oldest frame once the capacity is
+            /// reached.
+            ////////////////////////////////////////////////////
+            void addFrame(Time frameTime, Uint32 allocationCount = 0);
+
+            ////////////////////////////////////////////////////
+            /// \brief Forgets all the recorded frames.
+            ////////////////////////////////////////////////////
+            void clear();
+
+            ////////////////////////////////////////////////////
+            /// \brief Returns the number of recorded frames.
+            ////////////////////////////////////////////////////
+            unsigned int getFrameCount() const;
+
+            ////////////////////////////////////////////////////
+            /// \brief Returns the total number of frames added
+            /// since the last clear().
+            ////////////////////////////////////////////////////
+            Uint64 getTotalFrameCount() const;
+
+            ////////////////////////////////////////////////////
+            /// \brief Returns the duration of the last frame.
+            ////////////////////////////////////////////////////
+            Time getLastFrameTime() const;
+
+            ////////////////////////////////////////////////////
+            /// \brief Returns the average frame duration.
+            ////////////////////////////////////////////////////
+            Time getAverage() const;
+
+            ////////////////////////////////////////////////////
+            /// \brief Returns the frame duration below which
+            /// the given percentage (0 to 100) of the recorded
+            /// frames fall, e.g. getPercentile(99) for p99.
+            ////////////////////////////////////////////////////
+            Time getPercentile(float percentile) const;
+
+            ////////////////////////////////////////////////////
+            /// \brief Returns the number of heap allocations
+            /// made during the last frame.
+            ////////////////////////////////////////////////////
+            Uint32 getLastAllocationCount() const;
+
+            ////////////////////////////////////////////////////
+            /// \brief Returns the largest number of heap
+            /// allocations made during one of the recorded
+            /// frames.
+            ////////////////////////////////////////////////////
+            Uint32 getMaxAllocationCount() const;
+
+        private:
+            std::vector<Int64> frameTimes; ///< Ring buffer of frame durations, in microseconds
+            std::vector<Uint32> frameAllocations; ///< Ring buffer of heap allocation counts, parallel to frameTimes
+            mutable std::vector<Int64> sorted; ///< Scratch buffer used to compute percentiles
+            unsigned int capacity; ///< Maximum number of recorded frames
+            unsigned int next; ///< Index of the slot receiving the next frame
+            Uint64 totalFrames; ///< Frames added since the last clear()
+            Int64 lastFrameTime; ///< Duration of the last frame, in microseconds
+    };
+} // namespace TGE
+
+#endif // TGE_FRAMESTATISTICS_HPP
+
+////////////////////////////////////////////////////////////
+/// \class TGE::FrameStatistics
+/// \ingroup framework
+///
+/// Averages hide stutter: a game running at 60 FPS on average
+/// can still drop a frame every second. FrameStatistics keeps
+/// a window of recent frame durations so that percentiles
+/// (typically p50 and p99) can be used to judge smoothness.
+///
+/// TGE::Game records one in its main loop, see
+/// TGE::Game::getFrameStatistics(). When the engine is built
+/// with TGE_COUNT_ALLOCATIONS, it also records the number of
+/// heap allocations of each frame (see TGE::AllocationCounter):
+/// a steady-state frame should make none.
+///
+/// Example:
+/// \code
+/// const TGE::FrameStatistics& stats = TGE::Game::getInstance()->getFrameStatistics();
+/// TGE::Log() << "p50: " << stats.getPercentile(50).asMicroseconds() << "us, "
+///            << "p99: " << stats.getPercentile(99).asMicroseconds() << "us" << std::endl;
+/// \endcode
+///
+////////////////////////////////////////////////////////////
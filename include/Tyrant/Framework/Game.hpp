@@ -13,6 +13,10 @@
 //#include <Tyrant/Framework/Event.hpp>
 #include <Tyrant/Framework/State.hpp>
 #include <Tyrant/Framework/StateManager.hpp>
+#include <Tyrant/Framework/FrameStatistics.hpp>
+#include <Tyrant/Network/MetricsServer.hpp>
+#include <Tyrant/System/Semaphore.hpp>
+#include <exception>
 #include <vector>
 #include <string>
 
@@ -85,10 +89,153 @@ namespace TGE
             ////////////////////////////////////////////////////
             void start(State* state);
 
+            ////////////////////////////////////////////////////
+            /// \brief Enables or disables the pipelined game
+            /// loop. Must be called before start().
+            ///
+            /// When enabled, State::update() for frame N runs on
+            /// a worker thread while the main thread renders
+            /// frame N-1 from a snapshot recorded at the end of
+            /// the previous update. Input is still processed on
+            /// the main thread, between two updates.
+            ///
+            /// The snapshot contains the vertices and render
+            /// states produced by the drawables, so update() may
+            /// freely modify (or delete) drawables while the
+            /// previous frame is rendered. Texts are copied, and
+            /// their glyphs are loaded by the main thread when
+            /// the frame is rendered. Textures, fonts and
+            /// shaders are referenced by the snapshot and must
+            /// stay alive for one more frame.
+            ////////////////////////////////////////////////////
+            void setPipelined(bool p);
+
+            bool isPipelined();
+
+            ////////////////////////////////////////////////////
+            /// \brief Sets the simulation step of the game
+            /// loop.
+            ///
+            /// With a non-zero step, State::update() is called
+            /// as many times as needed for the simulation to
+            /// advance by exactly \a step per call, whatever
+            /// the frame rate. At most \a maxSteps updates are
+            /// run per frame; if the simulation falls further
+            /// behind, the extra time is dropped (the game
+            /// slows down instead of freezing).
+            /// With Time::Zero (the default), update() is
+            /// called once per frame.
+            ////////////////////////////////////////////////////
+            void setFixedTimestep(Time step, unsigned int maxSteps = 5);
+
+            Time getFixedTimestep();
+
+            ////////////////////////////////////////////////////
+            /// \brief Returns the fraction of a fixed step
+            /// elapsed since the last update, in [0, 1[. It is
+            /// also passed to State::interpolate(). Always 1
+            /// without a fixed timestep.
+            ////////////////////////////////////////////////////
+            float getInterpolationAlpha();
+
+            ////////////////////////////////////////////////////
+            /// \brief Returns the durations of the most recent
+            /// frames of the main loop.
+            ////////////////////////////////////////////////////
+            const FrameStatistics& getFrameStatistics();
+
+            ////////////////////////////////////////////////////
+            /// \brief Publishes the engine metrics on a
+            /// metrics server: frame times, tick rate, heap
+            /// allocations and resource cache sizes.
+            ///
+            /// The main loop calls MetricsServer::update() at
+            /// the end of each frame, so that the server's other
+            /// collectors also run on the main thread. The
+            /// server must outlive the game.
+            ////////////////////////////////////////////////////
+            void setMetricsServer(MetricsServer* server);
+
             StateManager* getStateManager();
 
         private:
+            ////////////////////////////////////////////////////
+            /// \brief Immutable snapshot of everything needed
+            /// to render a frame.
+            ////////////////////////////////////////////////////
+            struct FramePacket
+            {
+                RenderQueue scene; ///< Recorded drawableStack
+                RenderQueue overlay; ///< Recorded drawableStackOverlay
+                View view; ///< View of the scene
+                Color color;
+                Shader* renderShader;
+                Shader* renderShaderGlobal;
+                unsigned int renderPasses;
+            };
+
             Game(std::string windowTitle, bool fullscreen, float width = 0, float height = 0);
+
+            ////////////////////////////////////////////////////
+            /// \brief Draws a stack of drawables to a target,
+            /// in order of depth.
+            ////////////////////////////////////////////////////
+            void drawStack(const std::vector<Drawable*>& stack, RenderTarget& target);
+
+            ////////////////////////////////////////////////////
+            /// \brief Resizes and clears the render textures.
+            ////////////////////////////////////////////////////
+            void beginFrame();
+
+            ////////////////////////////////////////////////////
+            /// \brief Applies the render passes to the scene
+            /// and copies it to the global render texture.
+            ////////////////////////////////////////////////////
+            void composeScene(const View& sceneView, Shader* shader, unsigned int passes);
+
+            ////////////////////////////////////////////////////
+            /// \brief Draws the global render texture to the
+            /// window and displays it.
+            ////////////////////////////////////////////////////
+            void endFrame(Shader* shaderGlobal, const Color& c);
+
+            ////////////////////////////////////////////////////
+            /// \brief Runs the updates of a frame, according
+            /// to the timestep, then lets the state
+            /// interpolate.
+            ////////////////////////////////////////////////////
+            void runUpdates();
+
+            ////////////////////////////////////////////////////
+            /// \brief Worker thread entry point of the
+            /// pipelined loop: for each request, updates the
+            /// active state and records the result into the
+            /// packet that isn't being rendered.
+            ////////////////////////////////////////////////////
+            void updateLoop();
+
+            ////////////////////////////////////////////////////
+            /// \brief Records the active state's drawables
+            /// and the render settings into a packet.
+            ////////////////////////////////////////////////////
+            void recordFrame(FramePacket& packet);
+
+            ////////////////////////////////////////////////////
+            /// \brief Renders a previously recorded packet.
+            ////////////////////////////////////////////////////
+            void drawPacket(FramePacket& packet);
+
+            ////////////////////////////////////////////////////
+            /// \brief Records the duration and the heap
+            /// allocations of the frame that just ended.
+            ////////////////////////////////////////////////////
+            void recordFrameStatistics();
+
+            ////////////////////////////////////////////////////
+            /// \brief Collector writing the engine metrics.
+            ////////////////////////////////////////////////////
+            void writeMetrics(MetricsServer& server);
+
             StateManager* stateManager; ///< The game's stateManager
             //EventListener* eventManager; ///< The game's eventListener
             RenderWindow* window; ///< The game's window
@@ -97,6 +244,27 @@ namespace TGE
             RenderTexture renderTexture, renderTextureGlobal;
             Color color;
             unsigned int renderPasses;
+            bool pipelined; ///< Is the pipelined game loop enabled?
+            View pipelinedView; ///< Scene view set by the update thread in pipelined mode
+            FramePacket framePackets[2]; ///< Packets being rendered and recorded
+            unsigned int renderPacket; ///< Index of the packet being rendered
+            Semaphore updateRequest; ///< Posted by the main thread to start an update
+            Semaphore updateDone; ///< Posted by the worker thread when the update is recorded
+            bool updateStop; ///< Tells the worker thread to exit
+            std::exception_ptr updateError; ///< Exception thrown by the update thread, rethrown by start()
+            Time timestep; ///< Fixed simulation step, zero for one update per frame
+            unsigned int maxUpdateSteps; ///< Maximum number of updates per frame
+            Time accumulator; ///< Simulation time not consumed by updates yet
+            Clock updateClock; ///< Measures the time to simulate
+            float interpolationAlpha; ///< Fraction of a step left in the accumulator
+            FrameStatistics frameStatistics; ///< Durations of the recent frames
+            Clock frameClock; ///< Measures the duration of the frames
+            Uint32 frameAllocations; ///< Allocation counter at the start of the frame
+            MetricsServer* metricsServer; ///< Server publishing the metrics, if any
+            MetricsServer::Histogram frameHistogram; ///< Distribution of the frame durations, in seconds
+            Uint64 updateCount; ///< Number of calls to State::update()
+            Uint64 metricsUpdateCount; ///< Value of updateCount at the last collection
+            Clock metricsClock; ///< Measures the time between two collections
             static Game* instance;
     };
 }
@@ -11,15 +11,32 @@
 #include <Tyrant/Config.hpp>
 #include <Tyrant/Graphics.hpp>
 #include <Tyrant/Audio.hpp>
+#include <Tyrant/Framework/SoundInstancePool.hpp>
 #include <map>
+#include <vector>
 
 //#define getTexture *TGE::ResourceManager::getResourceManager()->requestTexture
 
 namespace TGE
 {
-    class TGE_API ResourceManager
+    class TGE_API ResourceManager : private SoundInstancePool
     {
         public:
+            ////////////////////////////////////////////////////
+            /// \brief Handle of a sound instance, 0 if no
+            /// instance was played
+            ////////////////////////////////////////////////////
+            typedef SoundInstancePool::Handle SoundHandle;
+
+            ////////////////////////////////////////////////////
+            /// \brief Instance stolen when a sound reaches its
+            /// instance limit, see SoundInstancePool::StealPolicy
+            ////////////////////////////////////////////////////
+            using SoundInstancePool::StealPolicy;
+            using SoundInstancePool::StealNone;
+            using SoundInstancePool::StealOldest;
+            using SoundInstancePool::StealQuietest;
+
             ~ResourceManager();
             static ResourceManager* getInstance();
 
@@ -30,11 +47,68 @@ namespace TGE
             void setSoundVolume(float volume);
             void setMusicVolume(float volume);
 
-            void playSound(std::string pathToSound, bool loop = false);
-            void pauseSound(std::string pathToSound);
-            void stopSound(std::string pathToSound);
-            void loopSound(std::string pathToSound, bool loop = true);
-            Time getSoundDuration(std::string pathToSound);
+            ////////////////////////////////////////////////////
+            /// \brief Play a new instance of a sound
+            ///
+            /// Each call plays another instance, so firing the
+            /// same sound twice doesn't cut the first one. The
+            /// finished instances are recycled, without creating
+            /// new sources.
+            ///
+            /// \return Handle of the instance, 0 if the instance
+            /// limit of the sound was reached with StealNone
+            ////////////////////////////////////////////////////
+            SoundHandle playSound(const std::string& pathToSound, bool loop = false);
+
+            ////////////////////////////////////////////////////
+            /// \brief Pause, resume, stop or loop all the
+            /// instances of a sound
+            ///
+            /// playSound always starts a new instance; the
+            /// paused ones continue with resumeSound.
+            ////////////////////////////////////////////////////
+            void pauseSound(const std::string& pathToSound);
+            void resumeSound(const std::string& pathToSound);
+            void stopSound(const std::string& pathToSound);
+            void loopSound(const std::string& pathToSound, bool loop = true);
+            Time getSoundDuration(const std::string& pathToSound);
+
+            ////////////////////////////////////////////////////
+            /// \brief Set how many instances of a sound can play
+            /// at once, 8 by default, and which one is stolen
+            /// beyond the limit
+            ////////////////////////////////////////////////////
+            void setSoundInstanceLimit(const std::string& pathToSound, unsigned int maxInstances, StealPolicy policy = StealOldest);
+
+            ////////////////////////////////////////////////////
+            /// \brief Set how many instances of all the sounds
+            /// can play at once, 64 by default
+            ///
+            /// Beyond it, the oldest instance is stolen. Audio
+            /// devices usually have a few hundred sources.
+            ////////////////////////////////////////////////////
+            void setMaxSoundInstances(unsigned int maxInstances);
+
+            ////////////////////////////////////////////////////
+            /// \brief Control a single instance of a sound
+            ///
+            /// The handle becomes invalid once the instance is
+            /// stopped or recycled; the functions then do
+            /// nothing.
+            ////////////////////////////////////////////////////
+            void pauseSound(SoundHandle sound);
+            void resumeSound(SoundHandle sound);
+            void stopSound(SoundHandle sound);
+            void loopSound(SoundHandle sound, bool loop = true);
+            void setSoundVolume(SoundHandle sound, float volume);
+            void setSoundPitch(SoundHandle sound, float pitch);
+            void setSoundPosition(SoundHandle sound, const Vector3f& position);
+            bool isSoundPlaying(SoundHandle sound) const;
+
+            ////////////////////////////////////////////////////
+            /// \brief Stop all the instances of all the sounds
+            ////////////////////////////////////////////////////
+            void stopAllSounds();
 
             void playMusic(std::string pathToMusic, bool loop = false);
             void pauseMusic(std::string pathToMusic);
@@ -42,14 +116,49 @@ namespace TGE
             void loopMusic(std::string pathToMusic, bool loop = true);
             Time getMusicDuration(std::string pathToMusic);
 
+            ////////////////////////////////////////////////////
+            /// \brief Returns the number of resources of each
+            /// kind held in the caches.
+            ////////////////////////////////////////////////////
+            std::size_t getTextureCount() const;
+            std::size_t getFontCount() const;
+            std::size_t getSoundBufferCount() const;
+            std::size_t getMusicCount() const;
+            std::size_t getSoundInstanceCount() const;
+
+            ////////////////////////////////////////////////////
+            /// \brief Returns the memory used by the cached
+            /// textures and sound buffers, in bytes.
+            ////////////////////////////////////////////////////
+            Uint64 getTextureMemory() const;
+            Uint64 getSoundBufferMemory() const;
+
         private:
+            struct SoundEntry : Group
+            {
+                SoundBuffer buffer;
+            };
+
+            struct SoundInstance
+            {
+                Sound* sound;
+                float volume;
+            };
+
             static ResourceManager* instance;
             ResourceManager();
             bool loadTexture(std::string pathToTexture);
+            SoundEntry& requestSound(const std::string& pathToSound);
+            SoundInstance* findSoundInstance(SoundHandle sound);
+            const SoundInstance* findSoundInstance(SoundHandle sound) const;
+            virtual void onCreate(std::size_t index);
+            virtual bool isFinished(std::size_t index) const;
+            virtual float getGain(std::size_t index) const;
+            virtual void onStop(std::size_t index);
             std::map<std::string, Texture*> textureMap;
             std::map<std::string, Font*> fontMap;
-            std::map<std::string, SoundBuffer*> soundBufferMap;
-            std::map<std::string, Sound*> soundMap;
+            std::map<std::string, SoundEntry*> soundMap;
+            std::vector<SoundInstance> soundInstances;
             std::map<std::string, Music*> musicMap;
             float* soundVolume;
             float* musicVolume;
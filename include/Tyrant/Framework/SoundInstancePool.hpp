@@ -0,0 +1,179 @@
+/*************************************/
+/** Copyright © 2014 Coldsnap Games **/
+/*************************************/
+
+#ifndef TGE_SOUNDINSTANCEPOOL_HPP
+#define TGE_SOUNDINSTANCEPOOL_HPP
+
+/*************************************/
+/**             Headers             **/
+/*************************************/
+#include <Tyrant/Config.hpp>
+#include <vector>
+
+namespace TGE
+{
+    ////////////////////////////////////////////////////////////
+    /// \brief Keeps track of the sound instances playing at
+    /// once, recycling and stealing them within limits.
+    ////////////////////////////////////////////////////////////
+    class TGE_API SoundInstancePool
+    {
+        public:
+            ////////////////////////////////////////////////////
+            /// \brief Handle of an instance, 0 if no instance
+            /// was played
+            ////////////////////////////////////////////////////
+            typedef Uint32 Handle;
+
+            ////////////////////////////////////////////////////
+            /// \brief Instance stolen when a group reaches its
+            /// instance limit
+            ////////////////////////////////////////////////////
+            enum StealPolicy
+            {
+                StealNone,     ///< Don't play the new instance
+                StealOldest,   ///< Restart the instance played first
+                StealQuietest  ///< Restart the instance heard the least
+            };
+
+            ////////////////////////////////////////////////////
+            /// \brief Instances of a sound, with their limit
+            ////////////////////////////////////////////////////
+            struct TGE_API Group
+            {
+                ////////////////////////////////////////////////
+                /// \brief Creates a group of 8 instances at most,
+                /// stealing the oldest beyond.
+                ////////////////////////////////////////////////
+                Group();
+
+                unsigned int maxInstances; ///< Instances of the group playing at once
+                StealPolicy policy; ///< Instance stolen beyond the limit
+                std::vector<std::size_t> instances; ///< Indices of the instances of the group, in no particular order
+            };
+
+            ////////////////////////////////////////////////////
+            /// \brief Creates an empty pool of 64 instances at
+            /// most.
+            ////////////////////////////////////////////////////
+            SoundInstancePool();
+
+            virtual ~SoundInstancePool();
+
+            ////////////////////////////////////////////////////
+            /// \brief Sets how many instances of all the groups
+            /// can play at once, from 1 to 65535.
+            ///
+            /// Beyond it, the oldest instance is stolen.
+            ////////////////////////////////////////////////////
+            void setMaxInstances(unsigned int maxInstances);
+
+            ////////////////////////////////////////////////////
+            /// \brief Takes an instance to play a sound of a
+            /// group.
+            ///
+            /// The finished instances are released first. At
+            /// the limit of the group, an instance of the group
+            /// is stolen according to its policy; at the limit
+            /// of the pool, the oldest instance of all is. The
+            /// instances are only created when none is free.
+            ///
+            /// \return Index of the instance, getSlotCount() if
+            /// the limit of the group was reached with StealNone
+            ////////////////////////////////////////////////////
+            std::size_t acquire(Group& group);
+
+            ////////////////////////////////////////////////////
+            /// \brief Stops an instance and makes it free.
+            ////////////////////////////////////////////////////
+            void release(std::size_t index);
+
+            ////////////////////////////////////////////////////
+            /// \brief Stops all the instances.
+            ////////////////////////////////////////////////////
+            void releaseAll();
+
+            ////////////////////////////////////////////////////
+            /// \brief Returns the handle of an instance: its
+            /// index in the 16 low bits, and its generation,
+            /// changed each time it is released or stolen, in
+            /// the 16 high bits.
+            ////////////////////////////////////////////////////
+            Handle getHandle(std::size_t index) const;
+
+            ////////////////////////////////////////////////////
+            /// \brief Returns the index of the instance of a
+            /// handle, getSlotCount() if it was released or
+            /// stolen since.
+            ////////////////////////////////////////////////////
+            std::size_t find(Handle handle) const;
+
+            ////////////////////////////////////////////////////
+            /// \brief Returns the number of instances created,
+            /// free or not.
+            ////////////////////////////////////////////////////
+            std::size_t getSlotCount() const;
+
+            ////////////////////////////////////////////////////
+            /// \brief Returns the number of instances taken.
+            ////////////////////////////////////////////////////
+            std::size_t getInstanceCount() const;
+
+        protected:
+            ////////////////////////////////////////////////////
+            /// \brief Creates the sound of a new instance, at
+            /// the index getSlotCount() - 1.
+            ////////////////////////////////////////////////////
+            virtual void onCreate(std::size_t index) = 0;
+
+            ////////////////////////////////////////////////////
+            /// \brief Tells whether the sound of an instance
+            /// finished playing.
+            ////////////////////////////////////////////////////
+            virtual bool isFinished(std::size_t index) const = 0;
+
+            ////////////////////////////////////////////////////
+            /// \brief Returns how loud an instance is heard,
+            /// for StealQuietest.
+            ////////////////////////////////////////////////////
+            virtual float getGain(std::size_t index) const = 0;
+
+            ////////////////////////////////////////////////////
+            /// \brief Stops the sound of an instance released
+            /// or stolen.
+            ////////////////////////////////////////////////////
+            virtual void onStop(std::size_t index) = 0;
+
+        private:
+            struct Slot
+            {
+                Group* group; ///< Group of the instance, NULL if free
+                Uint16 generation; ///< Changed each time the instance is released or stolen
+                Uint32 order; ///< Order in which the instances were acquired
+            };
+
+            bool isOlder(std::size_t first, std::size_t second) const;
+
+            std::vector<Slot> slots; ///< Instances created
+            std::vector<std::size_t> freeSlots; ///< Indices of the free instances
+            unsigned int maxInstances; ///< Instances of all the groups playing at once
+            Uint32 nextOrder; ///< Order of the next instance acquired
+    };
+} // namespace TGE
+
+#endif // TGE_SOUNDINSTANCEPOOL_HPP
+
+////////////////////////////////////////////////////////////
+/// \class TGE::SoundInstancePool
+/// \ingroup framework
+///
+/// Firing the same sound again shouldn't cut the instance
+/// still playing, but creating a source for every shot would
+/// soon exhaust the device. SoundInstancePool only does the
+/// bookkeeping: which instances are taken, by which group,
+/// which one to steal, and the handles given to the game. The
+/// sounds themselves are managed by a derived class through
+/// the virtual functions, see TGE::ResourceManager.
+///
+////////////////////////////////////////////////////////////
@@ -140,6 +140,17 @@ namespace TGE
 
             virtual void update() = 0;
 
+            ////////////////////////////////////////////////
+            /// \brief Virtual function, executed once per
+            /// frame after the updates and before drawing.
+            /// With a fixed timestep (see
+            /// Game::setFixedTimestep), alpha is the fraction
+            /// of a step elapsed since the last update, and
+            /// can be used to place drawables between the
+            /// previous and the current simulation states.
+            ////////////////////////////////////////////////
+            virtual void interpolate(float) {}
+
             ////////////////////////////////////////////////
             /// \brief Virtual function, pauses execution
             /// of the game state. Used for things like
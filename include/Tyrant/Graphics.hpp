@@ -15,7 +15,9 @@
 #include <Tyrant/Graphics/Font.hpp>
 #include <Tyrant/Graphics/Glyph.hpp>
 #include <Tyrant/Graphics/Image.hpp>
+#include <Tyrant/Graphics/InstancedSpriteBatch.hpp>
 #include <Tyrant/Graphics/RenderStates.hpp>
+#include <Tyrant/Graphics/RenderQueue.hpp>
 #include <Tyrant/Graphics/RenderTexture.hpp>
 #include <Tyrant/Graphics/RenderWindow.hpp>
 #include <Tyrant/Graphics/Shader.hpp>
@@ -14,6 +14,7 @@
 #include <Tyrant/Graphics/Rect.hpp>
 #include <Tyrant/System/Vector2.hpp>
 #include <Tyrant/System/String.hpp>
+#include <Tyrant/System/Mutex.hpp>
 #include <map>
 #include <string>
 #include <vector>
@@ -198,6 +199,8 @@ public :
 
 private :
 
+    friend class Text;
+
     ////////////////////////////////////////////////////////////
     /// \brief Structure defining a row of glyphs
     ///
@@ -285,6 +288,7 @@ private :
     Info                       m_info;        ///< Information about the font
     mutable PageTable          m_pages;       ///< Table containing the glyphs pages by character size
     mutable std::vector<Uint8> m_pixelBuffer; ///< Pixel buffer holding a glyph's pixels before being written to the texture
+    mutable Mutex              m_mutex;       ///< Mutex protecting the pages, locked by Text while it draws with their textures
 };
 
 } // namespace TGE
@@ -0,0 +1,331 @@
+/*************************************/
+/** Copyright © 2014 Coldsnap Games **/
+/*************************************/
+
+#ifndef TGE_INSTANCEDSPRITEBATCH_HPP
+#define TGE_INSTANCEDSPRITEBATCH_HPP
+
+/*************************************/
+/**             Headers             **/
+/*************************************/
+#include <Tyrant/Config.hpp>
+#include <Tyrant/Graphics/Drawable.hpp>
+#include <Tyrant/Graphics/Transformable.hpp>
+#include <Tyrant/Graphics/Vertex.hpp>
+#include <Tyrant/Graphics/Color.hpp>
+#include <Tyrant/Graphics/Rect.hpp>
+#include <Tyrant/Window/GlResource.hpp>
+#include <Tyrant/System/NonCopyable.hpp>
+#include <vector>
+
+
+namespace TGE
+{
+class Texture;
+
+////////////////////////////////////////////////////////////
+/// \brief Drawable set of many sprites sharing the same texture,
+///        rendered with a single instanced draw call
+///
+////////////////////////////////////////////////////////////
+class TGE_API InstancedSpriteBatch : public Drawable, public Transformable, GlResource, NonCopyable
+{
+public :
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Compact per-instance data (32 bytes)
+    ///
+    ////////////////////////////////////////////////////////////
+    struct Instance
+    {
+        ////////////////////////////////////////////////////////////
+        /// \brief Default constructor
+        ///
+        /// Creates an instance at (0, 0), with no rotation, unit
+        /// scale, an empty texture rect and opaque white color.
+        ///
+        ////////////////////////////////////////////////////////////
+        Instance();
+
+        ////////////////////////////////////////////////////////////
+        /// \brief Construct the instance from its attributes
+        ///
+        /// \param thePosition    Position of the instance
+        /// \param theTextureRect Sub-rectangle of the texture to display
+        /// \param theColor       Color of the instance
+        /// \param theRotation    Rotation of the instance, in degrees
+        /// \param theScale       Scale factors of the instance
+        ///
+        ////////////////////////////////////////////////////////////
+        Instance(const Vector2f& thePosition, const IntRect& theTextureRect, const Color& theColor = Color::White,
+                 float theRotation = 0.f, const Vector2f& theScale = Vector2f(1.f, 1.f));
+
+        ////////////////////////////////////////////////////////////
+        /// \brief Set the sub-rectangle of the texture to display
+        ///
+        /// Coordinates are stored as 16-bit integers, which is
+        /// enough for any texture size supported by OpenGL.
+        /// Negative sizes flip the instance, like with TGE::Sprite.
+        ///
+        /// \param rectangle Rectangle of the texture to display
+        ///
+        ////////////////////////////////////////////////////////////
+        void setTextureRect(const IntRect& rectangle);
+
+        ////////////////////////////////////////////////////////////
+        /// \brief Get the sub-rectangle of the texture to display
+        ///
+        /// \return Texture rectangle of the instance
+        ///
+        ////////////////////////////////////////////////////////////
+        IntRect getTextureRect() const;
+
+        ////////////////////////////////////////////////////////////
+        // Member data
+        ////////////////////////////////////////////////////////////
+        Vector2f position;       ///< Position of the instance
+        float    rotation;       ///< Rotation of the instance, in degrees
+        Vector2f scale;          ///< Scale factors of the instance
+        Int16    textureRect[4]; ///< Left, top, width and height of the texture rect
+        Color    color;          ///< Color of the instance
+    };
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Default constructor
+    ///
+    /// Creates an empty batch with no source texture.
+    ///
+    ////////////////////////////////////////////////////////////
+    InstancedSpriteBatch();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Construct the batch from a source texture
+    ///
+    /// \param texture Source texture
+    ///
+    ////////////////////////////////////////////////////////////
+    explicit InstancedSpriteBatch(const Texture& texture);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Destructor
+    ///
+    ////////////////////////////////////////////////////////////
+    ~InstancedSpriteBatch();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Change the source texture shared by all instances
+    ///
+    /// The texture must exist as long as the batch uses it.
+    ///
+    /// \param texture New texture
+    ///
+    /// \see getTexture
+    ///
+    ////////////////////////////////////////////////////////////
+    void setTexture(const Texture& texture);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Get the source texture of the batch
+    ///
+    /// \return Pointer to the batch's texture, NULL if none
+    ///
+    /// \see setTexture
+    ///
+    ////////////////////////////////////////////////////////////
+    const Texture* getTexture() const;
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Set the origin shared by all instances
+    ///
+    /// The origin is relative to the size of each instance's
+    /// texture rect: (0, 0) is the top-left corner (the default,
+    /// like TGE::Sprite) and (0.5, 0.5) is the center. It is the
+    /// point around which instances are rotated and scaled.
+    ///
+    /// \param origin Relative origin of the instances
+    ///
+    ////////////////////////////////////////////////////////////
+    void setInstanceOrigin(const Vector2f& origin);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Get the origin shared by all instances
+    ///
+    /// \return Relative origin of the instances
+    ///
+    ////////////////////////////////////////////////////////////
+    const Vector2f& getInstanceOrigin() const;
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Return the number of instances in the batch
+    ///
+    /// \return Number of instances
+    ///
+    ////////////////////////////////////////////////////////////
+    unsigned int getInstanceCount() const;
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Get a read-write access to an instance by its index
+    ///
+    /// This function doesn't check \a index, it must be in range
+    /// [0, getInstanceCount() - 1].
+    ///
+    /// \param index Index of the instance to get
+    ///
+    /// \return Reference to the index-th instance
+    ///
+    ////////////////////////////////////////////////////////////
+    Instance& operator [](unsigned int index);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Get a read-only access to an instance by its index
+    ///
+    /// \param index Index of the instance to get
+    ///
+    /// \return Const reference to the index-th instance
+    ///
+    ////////////////////////////////////////////////////////////
+    const Instance& operator [](unsigned int index) const;
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Add an instance to the batch
+    ///
+    /// \param instance Instance to add
+    ///
+    ////////////////////////////////////////////////////////////
+    void append(const Instance& instance);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Resize the batch
+    ///
+    /// New instances are default-constructed.
+    ///
+    /// \param instanceCount New number of instances
+    ///
+    ////////////////////////////////////////////////////////////
+    void resize(unsigned int instanceCount);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Reserve storage for a given number of instances
+    ///
+    /// \param instanceCount Number of instances to reserve
+    ///
+    ////////////////////////////////////////////////////////////
+    void reserve(unsigned int instanceCount);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Remove all the instances of the batch
+    ///
+    ////////////////////////////////////////////////////////////
+    void clear();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Tell whether instanced rendering is supported
+    ///
+    /// When it isn't, the batch falls back to expanding the
+    /// instances into vertices on the CPU.
+    ///
+    /// \return True if instanced rendering is available
+    ///
+    ////////////////////////////////////////////////////////////
+    static bool isInstancingAvailable();
+
+private :
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Draw the batch to a render target
+    ///
+    /// \param target Render target to draw to
+    /// \param states Current render states
+    ///
+    ////////////////////////////////////////////////////////////
+    virtual void draw(RenderTarget& target, RenderStates states) const;
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Draw the batch with a single instanced draw call
+    ///
+    /// \param target Render target to draw to
+    /// \param states Current render states
+    ///
+    /// \return True on success, false if the fallback must be used
+    ///
+    ////////////////////////////////////////////////////////////
+    bool drawInstanced(RenderTarget& target, const RenderStates& states) const;
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Draw the batch by expanding the instances on the CPU
+    ///
+    /// \param target Render target to draw to
+    /// \param states Current render states
+    ///
+    ////////////////////////////////////////////////////////////
+    void drawExpanded(RenderTarget& target, const RenderStates& states) const;
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Create the instancing program if it doesn't exist yet
+    ///
+    /// \return True if the program is ready to be used
+    ///
+    ////////////////////////////////////////////////////////////
+    bool ensureProgram() const;
+
+    ////////////////////////////////////////////////////////////
+    // Member data
+    ////////////////////////////////////////////////////////////
+    std::vector<Instance>       m_instances;      ///< Instances of the batch
+    const Texture*              m_texture;        ///< Texture shared by all instances
+    Vector2f                    m_instanceOrigin; ///< Relative origin of the instances
+    mutable std::vector<Vertex> m_vertices;       ///< Vertices used by the CPU fallback
+    mutable unsigned int        m_program;        ///< OpenGL identifier of the instancing program
+    mutable int                 m_originLocation; ///< Location of the origin uniform in the program
+    mutable unsigned int        m_buffer;         ///< OpenGL identifier of the instance buffer
+    mutable std::size_t         m_bufferSize;     ///< Capacity of the instance buffer, in bytes
+    mutable bool                m_programFailed;  ///< Did the program fail to build (use the fallback)?
+};
+
+} // namespace TGE
+
+
+#endif // TGE_INSTANCEDSPRITEBATCH_HPP
+
+
+////////////////////////////////////////////////////////////
+/// \class TGE::InstancedSpriteBatch
+/// \ingroup graphics
+///
+/// TGE::InstancedSpriteBatch is meant for drawing very large
+/// numbers of homogeneous sprites (bullets, particles, tiles...)
+/// that share a single texture.
+///
+/// Instead of storing four transformed vertices and a full
+/// TGE::Transformable per sprite, each instance only stores
+/// its position, rotation, scale, texture rect and color in
+/// 32 bytes. When the hardware supports it, the instances are
+/// uploaded to the GPU in a single buffer and expanded by a
+/// vertex shader in one instanced draw call. Otherwise they are
+/// expanded into vertices on the CPU and drawn with one regular
+/// draw call.
+///
+/// The batch itself is a TGE::Transformable, its transform is
+/// applied on top of the instances' own transforms. Depth,
+/// visibility and render states work like with any other
+/// TGE::Drawable. Note that a custom shader passed in the render
+/// states forces the CPU fallback, since it wouldn't know how to
+/// read the per-instance attributes.
+///
+/// Usage example:
+/// \code
+/// TGE::InstancedSpriteBatch bullets(texture);
+/// bullets.setInstanceOrigin(TGE::Vector2f(0.5f, 0.5f));
+/// bullets.reserve(100000);
+///
+/// for (unsigned int i = 0; i < 100000; ++i)
+///     bullets.append(TGE::InstancedSpriteBatch::Instance(positions[i], TGE::IntRect(0, 0, 8, 8)));
+///
+/// // Each frame, update the instances and draw them
+/// bullets[42].position += velocity;
+/// window.draw(bullets);
+/// \endcode
+///
+/// \see TGE::Sprite, TGE::VertexArray
+///
+////////////////////////////////////////////////////////////
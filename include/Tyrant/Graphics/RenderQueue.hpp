@@ -0,0 +1,197 @@
+/*************************************/
+/** Copyright © 2014 Coldsnap Games **/
+/*************************************/
+
+#ifndef TGE_RENDERQUEUE_HPP
+#define TGE_RENDERQUEUE_HPP
+
+/*************************************/
+/**             Headers             **/
+/*************************************/
+#include <Tyrant/Config.hpp>
+#include <Tyrant/Graphics/RenderTarget.hpp>
+#include <Tyrant/Graphics/Text.hpp>
+#include <vector>
+
+
+namespace TGE
+{
+////////////////////////////////////////////////////////////
+/// \brief Render target that records draw calls so that
+///        they can be replayed later
+///
+////////////////////////////////////////////////////////////
+class TGE_API RenderQueue : public RenderTarget
+{
+public :
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Default constructor
+    ///
+    /// Creates an empty queue with a size of 0x0.
+    ///
+    ////////////////////////////////////////////////////////////
+    RenderQueue();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Set the size reported by the queue
+    ///
+    /// This should match the size of the target the queue will
+    /// be replayed on, so that views and coordinate mapping
+    /// functions behave the same on both.
+    ///
+    /// \param size New size, in pixels
+    ///
+    ////////////////////////////////////////////////////////////
+    void setSize(const Vector2u& size);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Return the size of the queue
+    ///
+    /// \return Size in pixels
+    ///
+    ////////////////////////////////////////////////////////////
+    virtual Vector2u getSize() const;
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Remove all the recorded draw calls
+    ///
+    /// The internal storage is kept, so that recording the same
+    /// amount of geometry again doesn't allocate memory.
+    ///
+    ////////////////////////////////////////////////////////////
+    void reset();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Return the number of recorded draw calls
+    ///
+    /// \return Number of draw calls
+    ///
+    ////////////////////////////////////////////////////////////
+    unsigned int getCommandCount() const;
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Execute all the recorded draw calls on another target
+    ///
+    /// \param target Render target to draw to
+    ///
+    ////////////////////////////////////////////////////////////
+    void replay(RenderTarget& target) const;
+
+private :
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Store a draw call
+    ///
+    /// \param vertices    Pointer to the vertices
+    /// \param vertexCount Number of vertices in the array
+    /// \param type        Type of primitives to draw
+    /// \param states      Render states to use for drawing
+    ///
+    /// \return Always true, recorded calls are never executed
+    ///
+    ////////////////////////////////////////////////////////////
+    virtual bool interceptDraw(const Vertex* vertices, unsigned int vertexCount,
+                               PrimitiveType type, const RenderStates& states);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Store a copy of a text
+    ///
+    /// The glyphs of the copy are resolved when it is replayed,
+    /// so that the textures of the font are only updated by the
+    /// thread that renders them.
+    ///
+    /// \param text   Text to draw
+    /// \param states Render states to use for drawing
+    ///
+    /// \return Always true, recorded texts are never drawn
+    ///
+    ////////////////////////////////////////////////////////////
+    virtual bool interceptText(const Text& text, const RenderStates& states);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Activate the target for rendering
+    ///
+    /// A queue has no OpenGL context, so this always fails.
+    ///
+    /// \param active Ignored
+    ///
+    /// \return Always false
+    ///
+    ////////////////////////////////////////////////////////////
+    virtual bool activate(bool active);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Recorded draw call
+    ///
+    ////////////////////////////////////////////////////////////
+    struct Command
+    {
+        std::size_t   first;  ///< Index of the first vertex in the vertex storage, or of the text
+        unsigned int  count;  ///< Number of vertices, 0 for a text
+        PrimitiveType type;   ///< Type of primitives to draw
+        RenderStates  states; ///< Render states to use for drawing
+    };
+
+    ////////////////////////////////////////////////////////////
+    // Member data
+    ////////////////////////////////////////////////////////////
+    std::vector<Vertex>  m_vertices;  ///< Copy of the vertices of all the draw calls
+    std::vector<Text>    m_texts;     ///< Copy of the texts drawn, kept between two recordings to reuse their storage
+    std::size_t          m_textCount; ///< Number of texts recorded in m_texts
+    std::vector<Command> m_commands;  ///< Recorded draw calls
+    Vector2u             m_size;      ///< Size reported to the drawables
+};
+
+} // namespace TGE
+
+
+#endif // TGE_RENDERQUEUE_HPP
+
+
+////////////////////////////////////////////////////////////
+/// \class TGE::RenderQueue
+/// \ingroup graphics
+///
+/// TGE::RenderQueue is a render target that doesn't draw
+/// anything: it copies the vertices and render states of every
+/// draw call it receives, and can later execute them on a real
+/// target with replay().
+///
+/// Since the recorded vertices already include everything that
+/// the drawables computed (transforms, colors, texture
+/// coordinates...), a queue is an immutable snapshot of what
+/// was drawn. The drawables can be modified, or even destroyed,
+/// right after they have been recorded. This is what allows
+/// TGE::Game to run the update of a frame on another thread while
+/// the previous frame is being rendered.
+///
+/// Textures and shaders are referenced, not copied: they must
+/// still be alive when the queue is replayed. Texts are the
+/// exception: a copy of the text is recorded, and its glyphs
+/// are resolved when it is replayed, because loading a glyph
+/// updates the texture of the font. The fonts must also still
+/// be alive.
+///
+/// Since the queue has no OpenGL context, drawing can be
+/// recorded from any thread. Clearing a queue has no effect.
+///
+/// Usage example:
+/// \code
+/// TGE::RenderQueue queue;
+/// queue.setSize(window.getSize());
+///
+/// // Record (on any thread)
+/// queue.reset();
+/// queue.draw(sprite);
+/// queue.draw(text);
+///
+/// // Replay (on the rendering thread)
+/// window.clear();
+/// queue.replay(window);
+/// window.display();
+/// \endcode
+///
+/// \see TGE::RenderTarget, TGE::Game
+///
+////////////////////////////////////////////////////////////
@@ -23,6 +23,7 @@
 namespace TGE
 {
 class Drawable;
+class Text;
 
 ////////////////////////////////////////////////////////////
 /// \brief Base class for all render targets (window, texture, ...)
@@ -320,8 +321,64 @@ protected :
     ////////////////////////////////////////////////////////////
     void initialize();
 
+    ////////////////////////////////////////////////////////////
+    /// \brief Intercept a draw call before it reaches OpenGL
+    ///
+    /// Derived classes can override this function to store draw
+    /// calls instead of executing them (see TGE::RenderQueue).
+    /// The default implementation does nothing.
+    ///
+    /// \param vertices    Pointer to the vertices
+    /// \param vertexCount Number of vertices in the array
+    /// \param type        Type of primitives to draw
+    /// \param states      Render states to use for drawing
+    ///
+    /// \return True if the draw call was handled and must not be executed
+    ///
+    ////////////////////////////////////////////////////////////
+    virtual bool interceptDraw(const Vertex* vertices, unsigned int vertexCount,
+                               PrimitiveType type, const RenderStates& states);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Intercept the drawing of a text before its glyphs
+    ///        are resolved
+    ///
+    /// Resolving the glyphs may load them into the textures of
+    /// the font, so derived classes which store draw calls to
+    /// execute them on another thread must store a copy of the
+    /// text instead of its vertices (see TGE::RenderQueue).
+    /// The default implementation does nothing.
+    ///
+    /// \param text   Text to draw
+    /// \param states Render states to use for drawing, without
+    ///               the transform of the text
+    ///
+    /// \return True if the text was handled and must not be drawn
+    ///
+    ////////////////////////////////////////////////////////////
+    virtual bool interceptText(const Text& text, const RenderStates& states);
+
 private:
 
+    friend class InstancedSpriteBatch;
+    friend class Text;
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Activate the target and apply render states for a custom draw call
+    ///
+    /// This is used by drawables that issue their own OpenGL
+    /// draw calls (like InstancedSpriteBatch) instead of going
+    /// through draw(). The shader of \a states is ignored, and
+    /// the vertex cache is invalidated since the caller is going
+    /// to change the vertex pointers.
+    ///
+    /// \param states Render states to apply
+    ///
+    /// \return True if the target is ready for drawing
+    ///
+    ////////////////////////////////////////////////////////////
+    bool applyStates(const RenderStates& states);
+
     ////////////////////////////////////////////////////////////
     /// \brief Apply the current view
     ///
@@ -108,6 +108,17 @@ public :
     ////////////////////////////////////////////////////////////
     void resize(unsigned int vertexCount);
 
+    ////////////////////////////////////////////////////////////
+    /// \brief Allocate memory for a number of vertices
+    ///
+    /// The size of the array doesn't change, but appending
+    /// vertices up to \a vertexCount won't reallocate memory.
+    ///
+    /// \param vertexCount Number of vertices to make room for
+    ///
+    ////////////////////////////////////////////////////////////
+    void reserve(unsigned int vertexCount);
+
     ////////////////////////////////////////////////////////////
     /// \brief Add a vertex to the array
     ///
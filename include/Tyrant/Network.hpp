@@ -10,13 +10,28 @@
 /*************************************/
 
 #include <Tyrant/System.hpp>
+#include <Tyrant/Network/BitReader.hpp>
+#include <Tyrant/Network/BitWriter.hpp>
+#include <Tyrant/Network/CompressedPacket.hpp>
+#include <Tyrant/Network/CompressionDictionary.hpp>
 #include <Tyrant/Network/Ftp.hpp>
 #include <Tyrant/Network/Http.hpp>
+#include <Tyrant/Network/HttpDownloader.hpp>
+#include <Tyrant/Network/InterestManager.hpp>
 #include <Tyrant/Network/IpAddress.hpp>
+#include <Tyrant/Network/LinkConditioner.hpp>
+#include <Tyrant/Network/MetricsServer.hpp>
+#include <Tyrant/Network/NetworkService.hpp>
 #include <Tyrant/Network/Packet.hpp>
+#include <Tyrant/Network/ReplicationClient.hpp>
+#include <Tyrant/Network/ReplicationSchema.hpp>
+#include <Tyrant/Network/ReplicationServer.hpp>
+#include <Tyrant/Network/Resolver.hpp>
+#include <Tyrant/Network/Snapshot.hpp>
 #include <Tyrant/Network/SocketSelector.hpp>
 #include <Tyrant/Network/TcpListener.hpp>
 #include <Tyrant/Network/TcpSocket.hpp>
+#include <Tyrant/Network/UdpConnection.hpp>
 #include <Tyrant/Network/UdpSocket.hpp>
 
 
@@ -0,0 +1,229 @@
+/*************************************/
+/** Copyright © 2014 Coldsnap Games **/
+/*************************************/
+
+#ifndef TGE_BITREADER_HPP
+#define TGE_BITREADER_HPP
+
+/*************************************/
+/**             Headers             **/
+/*************************************/
+#include <Tyrant/Config.hpp>
+#include <Tyrant/System/Vector2.hpp>
+#include <Tyrant/System/Vector3.hpp>
+#include <string>
+
+
+namespace TGE
+{
+class Packet;
+class String;
+
+////////////////////////////////////////////////////////////
+/// \brief Reads the values written to a packet by a
+///        TGE::BitWriter
+///
+////////////////////////////////////////////////////////////
+class TGE_API BitReader
+{
+    // A bool-like type that cannot be converted to integer or pointer types
+    typedef bool (BitReader::*BoolType)(std::size_t);
+
+public :
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Construct the reader
+    ///
+    /// \param packet Packet to read, must outlive the reader and
+    ///               not be modified while it is read
+    /// \param offset Position of the first byte to read in the packet
+    ///
+    ////////////////////////////////////////////////////////////
+    explicit BitReader(const Packet& packet, std::size_t offset = 0);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Read an integer written by BitWriter::writeBits
+    ///
+    /// \param bitCount Number of bits to read, between 1 and 32
+    ///
+    /// \return Value read, 0 if the packet has not enough bits left
+    ///
+    ////////////////////////////////////////////////////////////
+    Uint32 readBits(unsigned int bitCount);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Read a boolean written by BitWriter::write
+    ///
+    /// \return Value read
+    ///
+    ////////////////////////////////////////////////////////////
+    bool readBool();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Read an integer written by BitWriter::writeInteger
+    ///
+    /// \param min Minimum value, as given to the writer
+    /// \param max Maximum value, as given to the writer
+    ///
+    /// \return Value read
+    ///
+    ////////////////////////////////////////////////////////////
+    Int32 readInteger(Int32 min, Int32 max);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Read an integer written by BitWriter::writeVarint
+    ///
+    /// \return Value read
+    ///
+    ////////////////////////////////////////////////////////////
+    Uint32 readVarint();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Read an integer written by BitWriter::writeSignedVarint
+    ///
+    /// \return Value read
+    ///
+    ////////////////////////////////////////////////////////////
+    Int32 readSignedVarint();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Read a float written by BitWriter::writeFloat(float)
+    ///
+    /// \return Value read
+    ///
+    ////////////////////////////////////////////////////////////
+    float readFloat();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Read a quantized float
+    ///
+    /// \param min      Minimum value, as given to the writer
+    /// \param max      Maximum value, as given to the writer
+    /// \param bitCount Number of bits, as given to the writer
+    ///
+    /// \return Value read
+    ///
+    ////////////////////////////////////////////////////////////
+    float readFloat(float min, float max, unsigned int bitCount);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Read a quantized 2D vector
+    ///
+    /// \param min      Minimum value, as given to the writer
+    /// \param max      Maximum value, as given to the writer
+    /// \param bitCount Number of bits, as given to the writer
+    ///
+    /// \return Value read
+    ///
+    ////////////////////////////////////////////////////////////
+    Vector2f readVector2(float min, float max, unsigned int bitCount);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Read a quantized 3D vector
+    ///
+    /// \param min      Minimum value, as given to the writer
+    /// \param max      Maximum value, as given to the writer
+    /// \param bitCount Number of bits, as given to the writer
+    ///
+    /// \return Value read
+    ///
+    ////////////////////////////////////////////////////////////
+    Vector3f readVector3(float min, float max, unsigned int bitCount);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Read a string written by BitWriter::writeString
+    ///
+    /// \param value String to fill
+    ///
+    ////////////////////////////////////////////////////////////
+    void readString(std::string& value);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Read a string written by BitWriter::writeString,
+    ///        decoding it from UTF-8
+    ///
+    /// \param value String to fill
+    ///
+    ////////////////////////////////////////////////////////////
+    void readString(String& value);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Skip the bits left in the current byte
+    ///
+    ////////////////////////////////////////////////////////////
+    void alignToByte();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Get the number of bits left to read
+    ///
+    /// \return Number of bits left
+    ///
+    ////////////////////////////////////////////////////////////
+    std::size_t getRemainingBits() const;
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Test the validity of the reader, for reading
+    ///
+    /// The reader becomes invalid when a value is read past the
+    /// end of the packet, which usually means that the data is
+    /// corrupted or that the reader and the writer disagree.
+    ///
+    /// \return True if all the values read so far were valid
+    ///
+    ////////////////////////////////////////////////////////////
+    operator BoolType() const;
+
+private :
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Check if the reader can read a given number of bits
+    ///
+    /// This function updates accordingly the state of the reader.
+    ///
+    /// \param bitCount Number of bits to check
+    ///
+    /// \return True if \a bitCount bits can be read
+    ///
+    ////////////////////////////////////////////////////////////
+    bool checkSize(std::size_t bitCount);
+
+    ////////////////////////////////////////////////////////////
+    // Member data
+    ////////////////////////////////////////////////////////////
+    const Uint8* m_data;        ///< Data read
+    std::size_t  m_size;        ///< Number of bytes of the data
+    std::size_t  m_bitPosition; ///< Position of the next bit to read
+    bool         m_isValid;     ///< Reading state of the reader
+};
+
+} // namespace TGE
+
+
+#endif // TGE_BITREADER_HPP
+
+
+////////////////////////////////////////////////////////////
+/// \class TGE::BitReader
+/// \ingroup network
+///
+/// TGE::BitReader reads back the values written by a
+/// TGE::BitWriter, in the same order, with the same ranges and
+/// bit counts. It reads the data of the packet in place and
+/// doesn't modify it.
+///
+/// Like TGE::Packet, the reader can be tested as a boolean to
+/// know if all the values read were valid.
+///
+/// Usage example:
+/// \code
+/// TGE::BitReader reader(packet);
+/// entity.health = reader.readInteger(0, 100);
+/// entity.position = reader.readVector3(-1024.f, 1024.f, 18);
+/// entity.isJumping = reader.readBool();
+/// if (!reader)
+///     std::cout << "Invalid snapshot" << std::endl;
+/// \endcode
+///
+/// \see TGE::BitWriter, TGE::Packet
+///
+////////////////////////////////////////////////////////////
@@ -0,0 +1,251 @@
+/*************************************/
+/** Copyright © 2014 Coldsnap Games **/
+/*************************************/
+
+#ifndef TGE_BITWRITER_HPP
+#define TGE_BITWRITER_HPP
+
+/*************************************/
+/**             Headers             **/
+/*************************************/
+#include <Tyrant/Config.hpp>
+#include <Tyrant/System/NonCopyable.hpp>
+#include <Tyrant/System/Vector2.hpp>
+#include <Tyrant/System/Vector3.hpp>
+#include <string>
+
+
+namespace TGE
+{
+class Packet;
+class String;
+
+////////////////////////////////////////////////////////////
+/// \brief Writes values to a packet with as few bits as
+///        possible
+///
+////////////////////////////////////////////////////////////
+class TGE_API BitWriter : NonCopyable
+{
+public :
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Construct the writer
+    ///
+    /// The values are appended to the current content of the
+    /// packet, starting on a new byte.
+    ///
+    /// \param packet Packet to write to, must outlive the writer
+    ///
+    ////////////////////////////////////////////////////////////
+    explicit BitWriter(Packet& packet);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Destructor
+    ///
+    /// Flushes the bits not written to the packet yet.
+    ///
+    ////////////////////////////////////////////////////////////
+    ~BitWriter();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Write the lowest bits of an integer
+    ///
+    /// \param value    Value to write
+    /// \param bitCount Number of bits to write, between 1 and 32
+    ///
+    ////////////////////////////////////////////////////////////
+    void writeBits(Uint32 value, unsigned int bitCount);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Write a boolean, as a single bit
+    ///
+    /// \param value Value to write
+    ///
+    ////////////////////////////////////////////////////////////
+    void write(bool value);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Write an integer known to be in a range
+    ///
+    /// The value is written with the bits needed by the range:
+    /// a value between 0 and 100 takes 7 bits.
+    ///
+    /// \param value Value to write, clamped to the range
+    /// \param min   Minimum value
+    /// \param max   Maximum value
+    ///
+    ////////////////////////////////////////////////////////////
+    void writeInteger(Int32 value, Int32 min, Int32 max);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Write an integer with a number of bits which
+    ///        depends on its value
+    ///
+    /// The value is written in groups of 7 bits, each followed
+    /// by a bit telling if more groups follow: values under 128
+    /// take 8 bits.
+    ///
+    /// \param value Value to write
+    ///
+    ////////////////////////////////////////////////////////////
+    void writeVarint(Uint32 value);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Write a signed integer with a number of bits
+    ///        which depends on its magnitude
+    ///
+    /// \param value Value to write
+    ///
+    ////////////////////////////////////////////////////////////
+    void writeSignedVarint(Int32 value);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Write a float without loss of precision
+    ///
+    /// \param value Value to write
+    ///
+    ////////////////////////////////////////////////////////////
+    void writeFloat(float value);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Write a float known to be in a range, quantized
+    ///
+    /// The range is split into 2^bitCount steps, the value is
+    /// rounded to the nearest one. If the range is empty (max
+    /// is not above min), 0 is written and min is read back.
+    /// With a \a bitCount of 0, nothing is written and min is
+    /// read back.
+    ///
+    /// \param value    Value to write, clamped to the range
+    /// \param min      Minimum value
+    /// \param max      Maximum value
+    /// \param bitCount Number of bits to write, between 0 and 32
+    ///
+    ////////////////////////////////////////////////////////////
+    void writeFloat(float value, float min, float max, unsigned int bitCount);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Write a 2D vector, each component quantized in a range
+    ///
+    /// \param value    Value to write, clamped to the range
+    /// \param min      Minimum value of a component
+    /// \param max      Maximum value of a component
+    /// \param bitCount Number of bits of each component
+    ///
+    ////////////////////////////////////////////////////////////
+    void writeVector(const Vector2f& value, float min, float max, unsigned int bitCount);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Write a 3D vector, each component quantized in a range
+    ///
+    /// \param value    Value to write, clamped to the range
+    /// \param min      Minimum value of a component
+    /// \param max      Maximum value of a component
+    /// \param bitCount Number of bits of each component
+    ///
+    ////////////////////////////////////////////////////////////
+    void writeVector(const Vector3f& value, float min, float max, unsigned int bitCount);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Write a string
+    ///
+    /// The length is written as a varint, then the characters
+    /// are copied to the packet at once, starting on a new byte.
+    ///
+    /// \param value String to write, encoded in UTF-8 or ASCII
+    ///
+    ////////////////////////////////////////////////////////////
+    void writeString(const std::string& value);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Write a string, encoded in UTF-8
+    ///
+    /// \param value String to write
+    ///
+    ////////////////////////////////////////////////////////////
+    void writeString(const String& value);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Skip the bits left in the current byte
+    ///
+    ////////////////////////////////////////////////////////////
+    void alignToByte();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Write the pending bits to the packet
+    ///
+    /// The current byte is completed with zeros: writing more
+    /// values after a flush starts on a new byte.
+    ///
+    ////////////////////////////////////////////////////////////
+    void flush();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Get the number of bits written so far
+    ///
+    /// \return Number of bits written by the writer, including
+    ///         the padding
+    ///
+    ////////////////////////////////////////////////////////////
+    std::size_t getBitCount() const;
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Get the number of bits needed to store a value
+    ///
+    /// \param maxValue Maximum value to store
+    ///
+    /// \return Number of bits needed, at least 1
+    ///
+    ////////////////////////////////////////////////////////////
+    static unsigned int getBitsRequired(Uint32 maxValue);
+
+private :
+
+    ////////////////////////////////////////////////////////////
+    // Member data
+    ////////////////////////////////////////////////////////////
+    Packet&      m_packet;      ///< Packet written to
+    Uint64       m_scratch;     ///< Bits not written to the packet yet
+    unsigned int m_scratchBits; ///< Number of bits in the scratch
+    std::size_t  m_bitCount;    ///< Number of bits written so far
+};
+
+} // namespace TGE
+
+
+#endif // TGE_BITWRITER_HPP
+
+
+////////////////////////////////////////////////////////////
+/// \class TGE::BitWriter
+/// \ingroup network
+///
+/// TGE::Packet writes every value with its full size: a bool
+/// takes a byte, a float 4 bytes. Most values sent by a game
+/// need much less: a health between 0 and 100 fits in 7 bits,
+/// a position known to the centimeter in a 2 km wide level
+/// fits in 18 bits per component. TGE::BitWriter writes such
+/// values with the bits they need, and TGE::BitReader reads
+/// them back; both sides must use the same ranges and bit
+/// counts.
+///
+/// The bits are packed into a 64-bit integer and written to
+/// the packet 32 at a time. The writer must be flushed, or
+/// destroyed, before the packet is sent.
+///
+/// Usage example:
+/// \code
+/// TGE::Packet packet;
+/// {
+///     TGE::BitWriter writer(packet);
+///     writer.writeInteger(entity.health, 0, 100);
+///     writer.writeVector(entity.position, -1024.f, 1024.f, 18);
+///     writer.write(entity.isJumping);
+/// }
+/// socket.send(packet, address, port);
+/// \endcode
+///
+/// \see TGE::BitReader, TGE::Packet
+///
+////////////////////////////////////////////////////////////
@@ -0,0 +1,183 @@
+/*************************************/
+/** Copyright © 2014 Coldsnap Games **/
+/*************************************/
+
+#ifndef TGE_COMPRESSEDPACKET_HPP
+#define TGE_COMPRESSEDPACKET_HPP
+
+/*************************************/
+/**             Headers             **/
+/*************************************/
+#include <Tyrant/Network/Packet.hpp>
+#include <vector>
+
+
+namespace TGE
+{
+class CompressionDictionary;
+
+////////////////////////////////////////////////////////////
+/// \brief Packet compressed when sent and uncompressed when
+///        received
+///
+////////////////////////////////////////////////////////////
+class TGE_API CompressedPacket : public Packet
+{
+public :
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Default constructor
+    ///
+    /// Creates an empty packet, compressed above 128 bytes,
+    /// without dictionary.
+    ///
+    ////////////////////////////////////////////////////////////
+    CompressedPacket();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Set the size above which the packet is compressed
+    ///
+    /// Smaller packets are sent as is, with a single byte of
+    /// header: compressing them costs time and rarely saves
+    /// anything.
+    ///
+    /// \param threshold Minimum size to compress, in bytes
+    ///
+    ////////////////////////////////////////////////////////////
+    void setCompressionThreshold(std::size_t threshold);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Get the size above which the packet is compressed
+    ///
+    /// \return Minimum size to compress, in bytes
+    ///
+    ////////////////////////////////////////////////////////////
+    std::size_t getCompressionThreshold() const;
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Set the dictionary used to compress the packet
+    ///
+    /// The receiver must use the same dictionary; a packet
+    /// compressed with a dictionary the receiver doesn't have
+    /// is received empty.
+    ///
+    /// \param dictionary Dictionary to use, must outlive the
+    ///                   packet; NULL to use none
+    ///
+    ////////////////////////////////////////////////////////////
+    void setDictionary(const CompressionDictionary* dictionary);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Get the dictionary used to compress the packet
+    ///
+    /// \return Dictionary used, NULL if none
+    ///
+    ////////////////////////////////////////////////////////////
+    const CompressionDictionary* getDictionary() const;
+
+protected :
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Compress the data before it is sent
+    ///
+    /// \param size Variable to fill with the size of data to send
+    ///
+    /// \return Pointer to the array of bytes to send
+    ///
+    ////////////////////////////////////////////////////////////
+    virtual const void* onSend(std::size_t& size);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Uncompress the data after it is received
+    ///
+    /// \param data Pointer to the received bytes
+    /// \param size Number of bytes
+    ///
+    ////////////////////////////////////////////////////////////
+    virtual void onReceive(const void* data, std::size_t size);
+
+private :
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Compress a block of data
+    ///
+    /// \param data   Pointer to the data to compress
+    /// \param size   Size of the data, in bytes
+    /// \param output Buffer to fill with the compressed data,
+    ///               large enough for the worst case
+    ///
+    /// \return Size of the compressed data, in bytes
+    ///
+    ////////////////////////////////////////////////////////////
+    std::size_t compress(const char* data, std::size_t size, char* output);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Uncompress a block of data
+    ///
+    /// \param data       Pointer to the compressed data
+    /// \param size       Size of the compressed data, in bytes
+    /// \param dictionary Dictionary used by the sender, or NULL
+    /// \param output     Buffer to fill with the uncompressed data
+    /// \param outputSize Size of the uncompressed data, in bytes
+    ///
+    /// \return True if the data was valid
+    ///
+    ////////////////////////////////////////////////////////////
+    static bool uncompress(const char* data, std::size_t size, const CompressionDictionary* dictionary, char* output, std::size_t outputSize);
+
+    ////////////////////////////////////////////////////////////
+    // Member data
+    ////////////////////////////////////////////////////////////
+    std::size_t                  m_threshold;  ///< Minimum size to compress
+    const CompressionDictionary* m_dictionary; ///< Dictionary used, if any
+    std::vector<char>            m_buffer;     ///< Compressed or uncompressed data
+    std::vector<Uint32>          m_table;      ///< Last position of each hash, used by the compressor
+};
+
+} // namespace TGE
+
+
+#endif // TGE_COMPRESSEDPACKET_HPP
+
+
+////////////////////////////////////////////////////////////
+/// \class TGE::CompressedPacket
+/// \ingroup network
+///
+/// TGE::CompressedPacket is used like a regular packet; the
+/// data is compressed in onSend and uncompressed in onReceive,
+/// so it works with all the sockets. Both ends must use a
+/// compressed packet.
+///
+/// The codec is a fast LZ77 variant, in the spirit of LZ4:
+/// repeated sequences of 4 bytes or more are replaced by a
+/// reference to their previous occurrence, up to 64 KB back,
+/// without any entropy coding. It compresses hundreds of
+/// megabytes per second and uncompresses even faster, so it
+/// can be used on every packet; it shines on world state and
+/// level chunks, which repeat a lot, and does little for data
+/// that is already compressed or random.
+///
+/// Packets too small to be worth compressing, and packets
+/// which wouldn't get smaller, are sent as is. Small packets
+/// compress much better with a TGE::CompressionDictionary
+/// trained on typical packets.
+///
+/// The batch receive functions of the sockets hand out plain
+/// packets, they can't be used with compressed packets.
+///
+/// Usage example:
+/// \code
+/// TGE::CompressedPacket packet;
+/// packet << chunk.x << chunk.y;
+/// packet.append(chunk.blocks, sizeof(chunk.blocks));
+/// socket.send(packet);
+///
+/// TGE::CompressedPacket received;
+/// socket.receive(received);
+/// received >> x >> y;
+/// \endcode
+///
+/// \see TGE::Packet, TGE::CompressionDictionary
+///
+////////////////////////////////////////////////////////////
@@ -0,0 +1,174 @@
+/*************************************/
+/** Copyright © 2014 Coldsnap Games **/
+/*************************************/
+
+#ifndef TGE_COMPRESSIONDICTIONARY_HPP
+#define TGE_COMPRESSIONDICTIONARY_HPP
+
+/*************************************/
+/**             Headers             **/
+/*************************************/
+#include <Tyrant/Config.hpp>
+#include <vector>
+
+
+namespace TGE
+{
+class Packet;
+
+////////////////////////////////////////////////////////////
+/// \brief Bytes shared by both ends of a connection to
+///        improve the compression of small packets
+///
+////////////////////////////////////////////////////////////
+class TGE_API CompressionDictionary
+{
+public :
+
+    ////////////////////////////////////////////////////////////
+    // Constants
+    ////////////////////////////////////////////////////////////
+    enum
+    {
+        MaxSize = 65535 ///< The maximum number of bytes of a dictionary
+    };
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Default constructor
+    ///
+    /// Creates an empty dictionary.
+    ///
+    ////////////////////////////////////////////////////////////
+    CompressionDictionary();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Load the dictionary from memory
+    ///
+    /// Only the last MaxSize bytes are kept if the data is
+    /// larger.
+    ///
+    /// \param data Pointer to the content of the dictionary
+    /// \param size Size of the data, in bytes
+    ///
+    ////////////////////////////////////////////////////////////
+    void loadFromMemory(const void* data, std::size_t size);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Build the dictionary from typical packets
+    ///
+    /// The dictionary is made of the pieces of the samples
+    /// which contain the byte sequences found in the most
+    /// samples. The samples should be the packets the game
+    /// actually sends, a few hundred of them.
+    ///
+    /// \param samples Packets to train on
+    /// \param maxSize Maximum size of the dictionary, in bytes
+    ///
+    ////////////////////////////////////////////////////////////
+    void train(const std::vector<Packet>& samples, std::size_t maxSize = 16384);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Get the content of the dictionary
+    ///
+    /// Save it to send it along with the game, both ends must
+    /// use the same dictionary.
+    ///
+    /// \return Pointer to the content of the dictionary
+    ///
+    ////////////////////////////////////////////////////////////
+    const void* getData() const;
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Get the size of the dictionary
+    ///
+    /// \return Size of the dictionary, in bytes
+    ///
+    ////////////////////////////////////////////////////////////
+    std::size_t getSize() const;
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Get the identifier of the dictionary
+    ///
+    /// It is a hash of the content, sent with the packets
+    /// compressed with the dictionary so that the receiver can
+    /// check it has the same one.
+    ///
+    /// \return Identifier of the dictionary
+    ///
+    ////////////////////////////////////////////////////////////
+    Uint32 getId() const;
+
+private :
+
+    friend class CompressedPacket;
+
+    ////////////////////////////////////////////////////////////
+    // Constants
+    ////////////////////////////////////////////////////////////
+    enum
+    {
+        HashLog = 12 ///< Number of bits of the hash of a sequence
+    };
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Hash the 4 bytes starting at a position
+    ///
+    /// \param data Pointer to the bytes
+    ///
+    /// \return Hash, lower than 2^HashLog
+    ///
+    ////////////////////////////////////////////////////////////
+    static Uint32 hash(const char* data);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Compute the identifier and the hash table
+    ///
+    ////////////////////////////////////////////////////////////
+    void update();
+
+    ////////////////////////////////////////////////////////////
+    // Member data
+    ////////////////////////////////////////////////////////////
+    std::vector<char>   m_data;  ///< Content of the dictionary
+    Uint32              m_id;    ///< Hash of the content
+    std::vector<Uint32> m_table; ///< Last position of each hash in the dictionary
+};
+
+} // namespace TGE
+
+
+#endif // TGE_COMPRESSIONDICTIONARY_HPP
+
+
+////////////////////////////////////////////////////////////
+/// \class TGE::CompressionDictionary
+/// \ingroup network
+///
+/// A packet of a few hundred bytes compresses poorly on its
+/// own: there is too little data for the repetitions to pay
+/// off. But the packets of a game look alike; with a
+/// dictionary of byte sequences common to them, already known
+/// by both ends, the compressor can refer to the dictionary
+/// from the very first byte.
+///
+/// The dictionary is trained once, on packets recorded while
+/// playing, and shipped with the game. A dictionary can be
+/// shared by any number of TGE::CompressedPacket instances,
+/// from any thread, as long as it's not modified meanwhile.
+///
+/// Usage example:
+/// \code
+/// // When building the game
+/// TGE::CompressionDictionary dictionary;
+/// dictionary.train(recordedPackets);
+/// save("packets.dict", dictionary.getData(), dictionary.getSize());
+///
+/// // In the game
+/// dictionary.loadFromMemory(data, size);
+/// TGE::CompressedPacket packet;
+/// packet.setDictionary(&dictionary);
+/// \endcode
+///
+/// \see TGE::CompressedPacket
+///
+////////////////////////////////////////////////////////////
@@ -9,17 +9,17 @@
 /**             Headers             **/
 /*************************************/
 #include <Tyrant/Config.hpp>
+#include <Tyrant/Network/IpAddress.hpp>
 #include <Tyrant/Network/TcpSocket.hpp>
 #include <Tyrant/System/NonCopyable.hpp>
 #include <Tyrant/System/Time.hpp>
+#include <functional>
 #include <string>
 #include <vector>
 
 
 namespace TGE
 {
-class IpAddress;
-
 ////////////////////////////////////////////////////////////
 /// \brief A FTP client
 ///
@@ -28,6 +28,17 @@ class TGE_API Ftp : NonCopyable
 {
 public :
 
+    ////////////////////////////////////////////////////////////
+    /// \brief Function notified of the progress of a transfer
+    ///
+    /// It receives the number of bytes of the file transferred
+    /// so far, including the ones transferred before a
+    /// resumption, and the size of the file (0 if the server
+    /// doesn't tell it). It returns false to abort the transfer.
+    ///
+    ////////////////////////////////////////////////////////////
+    typedef std::function<bool (Uint64 transferred, Uint64 total)> ProgressCallback;
+
     ////////////////////////////////////////////////////////////
     /// \brief Enumeration of transfer modes
     ///
@@ -228,6 +239,12 @@ public :
     };
 
 
+    ////////////////////////////////////////////////////////////
+    /// \brief Default constructor
+    ///
+    ////////////////////////////////////////////////////////////
+    Ftp();
+
     ////////////////////////////////////////////////////////////
     /// \brief Destructor
     ///
@@ -433,16 +450,55 @@ public :
     /// destination path is relative to the current directory
     /// of your application.
     ///
+    /// The file is written to disk as it is received, so its
+    /// size isn't limited by the memory available. If \a resume
+    /// is true and the local file already exists, only the rest
+    /// of the file is downloaded and appended to it (if the
+    /// server doesn't support resuming, the whole file is
+    /// downloaded again).
+    ///
     /// \param remoteFile Filename of the distant file to download
     /// \param localPath  The directory in which to put the file on the local computer
     /// \param mode       Transfer mode
+    /// \param resume     Resume the download of an existing local file?
+    /// \param progress   Function notified of the progress, may be empty
     ///
     /// \return Server response to the request
     ///
-    /// \see upload
+    /// \see upload, downloadFiles
+    ///
+    ////////////////////////////////////////////////////////////
+    Response download(const std::string& remoteFile, const std::string& localPath, TransferMode mode = Binary,
+                      bool resume = false, const ProgressCallback& progress = ProgressCallback());
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Download several files from the server at once
+    ///
+    /// A FTP connection transfers a single file at a time;
+    /// this function opens \a connectionCount - 1 additional
+    /// connections to the server, logged in with the same
+    /// account and in the same working directory, and spreads
+    /// the files between them. It is much faster than
+    /// downloading the files one by one when they are small,
+    /// or when the server limits the speed of each connection.
+    ///
+    /// The client must be connected and logged in. If the
+    /// additional connections can't be opened, the files are
+    /// downloaded by the others.
+    ///
+    /// \param remoteFiles     Filenames of the distant files to download
+    /// \param localPath       The directory in which to put the files on the local computer
+    /// \param connectionCount Maximum number of connections used at once
+    /// \param mode            Transfer mode
+    /// \param resume          Resume the download of existing local files?
+    ///
+    /// \return Server response to the request of each file
+    ///
+    /// \see download
     ///
     ////////////////////////////////////////////////////////////
-    Response download(const std::string& remoteFile, const std::string& localPath, TransferMode mode = Binary);
+    std::vector<Response> downloadFiles(const std::vector<std::string>& remoteFiles, const std::string& localPath,
+                                        unsigned int connectionCount = 4, TransferMode mode = Binary, bool resume = false);
 
     ////////////////////////////////////////////////////////////
     /// \brief Upload a file to the server
@@ -452,16 +508,24 @@ public :
     /// remote path is relative to the current directory of the
     /// FTP server.
     ///
+    /// The file is read from disk as it is sent, so its size
+    /// isn't limited by the memory available. If \a resume is
+    /// true and the file already exists on the server, only the
+    /// rest of the file is uploaded.
+    ///
     /// \param localFile  Path of the local file to upload
     /// \param remotePath The directory in which to put the file on the server
     /// \param mode       Transfer mode
+    /// \param resume     Resume the upload of an existing remote file?
+    /// \param progress   Function notified of the progress, may be empty
     ///
     /// \return Server response to the request
     ///
     /// \see download
     ///
     ////////////////////////////////////////////////////////////
-    Response upload(const std::string& localFile, const std::string& remotePath, TransferMode mode = Binary);
+    Response upload(const std::string& localFile, const std::string& remotePath, TransferMode mode = Binary,
+                    bool resume = false, const ProgressCallback& progress = ProgressCallback());
 
     ////////////////////////////////////////////////////////////
     /// \brief Send a command to the FTP server
@@ -494,6 +558,27 @@ private:
     ////////////////////////////////////////////////////////////
     Response getResponse();
 
+    ////////////////////////////////////////////////////////////
+    /// \brief Get the size of a file on the server
+    ///
+    /// \param name Name of the distant file
+    ///
+    /// \return Size of the file, 0 if the server doesn't tell it
+    ///
+    ////////////////////////////////////////////////////////////
+    Uint64 getFileSize(const std::string& name);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Ask the server to start the next transfer at a
+    ///        given position of the file
+    ///
+    /// \param offset Position to start at, in bytes
+    ///
+    /// \return True if the server accepted
+    ///
+    ////////////////////////////////////////////////////////////
+    bool restartAt(Uint64 offset);
+
     ////////////////////////////////////////////////////////////
     /// \brief Utility class for exchanging datas with the server
     ///        on the data channel
@@ -506,7 +591,12 @@ private:
     ////////////////////////////////////////////////////////////
     // Member data
     ////////////////////////////////////////////////////////////
-    TcpSocket m_commandSocket; ///< Socket holding the control connection with the server
+    TcpSocket      m_commandSocket; ///< Socket holding the control connection with the server
+    IpAddress      m_server;        ///< Address of the server, to open additional connections
+    unsigned short m_port;          ///< Port of the server
+    Time           m_timeout;       ///< Timeout used to connect to the server
+    std::string    m_name;          ///< User name used to log in
+    std::string    m_password;      ///< Password used to log in
 };
 
 } // namespace TGE
@@ -573,6 +663,16 @@ private:
 /// if (response.isOk())
 ///     std::cout << "File uploaded" << std::endl;
 ///
+/// // Download a big file, resuming a previous attempt
+/// response = ftp.download("files/archive.zip", "downloads", TGE::Ftp::Binary, true,
+///                         [](TGE::Uint64 transferred, TGE::Uint64 total)
+///                         {
+///                             std::cout << transferred << " / " << total << std::endl;
+///                             return true;
+///                         });
+/// if (response.isOk())
+///     std::cout << "File downloaded" << std::endl;
+///
 /// // Send specific commands (here: FEAT to list supported FTP features)
 /// response = ftp.sendCommand("FEAT");
 /// if (response.isOk())
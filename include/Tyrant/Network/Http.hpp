@@ -11,10 +11,14 @@
 #include <Tyrant/Config.hpp>
 #include <Tyrant/Network/IpAddress.hpp>
 #include <Tyrant/Network/TcpSocket.hpp>
+#include <Tyrant/System/Clock.hpp>
+#include <Tyrant/System/Mutex.hpp>
 #include <Tyrant/System/NonCopyable.hpp>
 #include <Tyrant/System/Time.hpp>
+#include <functional>
 #include <map>
 #include <string>
+#include <vector>
 
 
 namespace TGE
@@ -27,6 +31,15 @@ class TGE_API Http : NonCopyable
 {
 public :
 
+    ////////////////////////////////////////////////////////////
+    /// \brief Function receiving the body of a response, piece
+    ///        by piece
+    ///
+    /// It returns false to abort the transfer.
+    ///
+    ////////////////////////////////////////////////////////////
+    typedef std::function<bool (const char* data, std::size_t size)> BodyCallback;
+
     ////////////////////////////////////////////////////////////
     /// \brief Define a HTTP request
     ///
@@ -101,7 +114,8 @@ public :
         ////////////////////////////////////////////////////////////
         /// \brief Set the HTTP version for the request
         ///
-        /// The HTTP version is 1.0 by default.
+        /// The HTTP version is 1.1 by default, which lets the
+        /// client keep the connection open for the next requests.
         ///
         /// \param major Major HTTP version number
         /// \param minor Minor HTTP version number
@@ -286,27 +300,81 @@ public :
         friend class Http;
 
         ////////////////////////////////////////////////////////////
-        /// \brief Construct the header from a response string
+        /// \brief Steps of the parsing of a response
         ///
-        /// This function is used by Http to build the response
-        /// of a request.
+        ////////////////////////////////////////////////////////////
+        enum ParseState
+        {
+            StatusLine,     ///< Waiting for the status line
+            Header,         ///< Reading the fields of the header
+            Body,           ///< Reading a body of known length
+            BodyUntilClose, ///< Reading a body ended by the closing of the connection
+            ChunkSize,      ///< Waiting for the size of the next chunk
+            ChunkData,      ///< Reading the data of a chunk
+            ChunkEnd,       ///< Waiting for the end of line after a chunk
+            Trailer,        ///< Reading the fields after the last chunk
+            Complete,       ///< The whole response was received
+            Failed          ///< The response is invalid, or was aborted
+        };
+
+        ////////////////////////////////////////////////////////////
+        /// \brief Prepare the response to parse new data
         ///
-        /// \param data Content of the response to parse
+        /// \param hasBody  False if the response has no body
+        ///                 whatever its header says (HEAD requests)
+        /// \param callback Function receiving the body, NULL to
+        ///                 store the body in the response
         ///
         ////////////////////////////////////////////////////////////
-        void parse(const std::string& data);
+        void startParsing(bool hasBody, const BodyCallback* callback);
 
+        ////////////////////////////////////////////////////////////
+        /// \brief Parse the next bytes received
+        ///
+        /// This function is used by Http to build the response as
+        /// the data arrives. The data is read in place; only the
+        /// lines split between two calls are copied.
+        ///
+        /// \param data Pointer to the bytes received
+        /// \param size Number of bytes
+        ///
+        /// \return Number of bytes used, less than \a size only if
+        ///         the response is complete (the rest belongs to
+        ///         the next response)
+        ///
+        ////////////////////////////////////////////////////////////
+        std::size_t parse(const char* data, std::size_t size);
+
+        ////////////////////////////////////////////////////////////
+        /// \brief Tell the response that the connection was closed
+        ///
+        ////////////////////////////////////////////////////////////
+        void finishParsing();
+
+        ////////////////////////////////////////////////////////////
+        /// \brief Parse a complete line of the header or the trailer
+        ///
+        /// \param begin Start of the line
+        /// \param end   End of the line, without the line feed
+        ///
+        ////////////////////////////////////////////////////////////
+        void parseLine(const char* begin, const char* end);
 
         ////////////////////////////////////////////////////////////
-        /// \brief Read values passed in the answer header
+        /// \brief Choose how the body is read, once the header
+        ///        is complete
         ///
-        /// This function is used by Http to extract values passed
-        /// in the response.
+        ////////////////////////////////////////////////////////////
+        void startBody();
+
+        ////////////////////////////////////////////////////////////
+        /// \brief Store or forward a piece of the body
         ///
-        /// \param in String stream containing the header values
+        /// \param data Pointer to the bytes of the body
+        /// \param size Number of bytes
         ///
         ////////////////////////////////////////////////////////////
-        void parseFields(std::istream &in);
+        void receiveBody(const char* data, std::size_t size);
 
         ////////////////////////////////////////////////////////////
         // Types
@@ -316,11 +384,18 @@ public :
         ////////////////////////////////////////////////////////////
         // Member data
         ////////////////////////////////////////////////////////////
-        FieldTable   m_fields;       ///< Fields of the header
-        Status       m_status;       ///< Status code
-        unsigned int m_majorVersion; ///< Major HTTP version
-        unsigned int m_minorVersion; ///< Minor HTTP version
-        std::string  m_body;         ///< Body of the response
+        FieldTable          m_fields;       ///< Fields of the header
+        Status              m_status;       ///< Status code
+        unsigned int        m_majorVersion; ///< Major HTTP version
+        unsigned int        m_minorVersion; ///< Minor HTTP version
+        std::string         m_body;         ///< Body of the response
+        ParseState          m_state;        ///< Current step of the parsing
+        std::string         m_line;         ///< Start of a line split between two reads
+        std::size_t         m_remaining;    ///< Bytes left in the body or the current chunk
+        std::size_t         m_received;     ///< Number of bytes parsed so far
+        bool                m_hasBody;      ///< Can the response have a body?
+        bool                m_keepAlive;    ///< Can the connection be used for another request?
+        const BodyCallback* m_callback;     ///< Function receiving the body, if any
     };
 
     ////////////////////////////////////////////////////////////
@@ -345,6 +420,14 @@ public :
     ////////////////////////////////////////////////////////////
     Http(const std::string& host, unsigned short port = 0);
 
+    ////////////////////////////////////////////////////////////
+    /// \brief Destructor
+    ///
+    /// Closes the connections kept open.
+    ///
+    ////////////////////////////////////////////////////////////
+    ~Http();
+
     ////////////////////////////////////////////////////////////
     /// \brief Set the target host
     ///
@@ -356,6 +439,8 @@ public :
     /// this unless you really need a port other than the
     /// standard one, or use an unknown protocol.
     ///
+    /// The connections kept open to the previous host are closed.
+    ///
     /// \param host Web server to connect to
     /// \param port Port to use for connection
     ///
@@ -374,6 +459,11 @@ public :
     /// of Time::Zero means that the client will use the system defaut timeout
     /// (which is usually pretty long).
     ///
+    /// For HTTP/1.1 requests, the connection is kept open and
+    /// reused by the next requests, unless the server closes it.
+    /// Several threads may send requests at the same time, each
+    /// one uses its own connection.
+    ///
     /// \param request Request to send
     /// \param timeout Maximum time to wait
     ///
@@ -382,15 +472,129 @@ public :
     ////////////////////////////////////////////////////////////
     Response sendRequest(const Request& request, Time timeout = Time::Zero);
 
+    ////////////////////////////////////////////////////////////
+    /// \brief Send a HTTP request and stream the body of the
+    ///        response
+    ///
+    /// The body is given to \a callback as it arrives, in pieces
+    /// of any size, instead of being stored in the response:
+    /// large downloads can be written to a file without ever
+    /// being entirely in memory. The callback is called from
+    /// this function, and may return false to abort the
+    /// transfer.
+    ///
+    /// \param request  Request to send
+    /// \param callback Function receiving the body
+    /// \param timeout  Maximum time to wait
+    ///
+    /// \return Server's response, with an empty body
+    ///
+    ////////////////////////////////////////////////////////////
+    Response sendRequest(const Request& request, const BodyCallback& callback, Time timeout = Time::Zero);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Send several HTTP requests at once
+    ///
+    /// The requests are pipelined: they are all written to the
+    /// same connection before the first response is read, which
+    /// saves a round trip per request. If the server closes the
+    /// connection before answering all of them, the remaining
+    /// requests are sent again on a new connection.
+    ///
+    /// Only GET and HEAD requests are pipelined and sent again:
+    /// a POST request is sent alone, once the previous ones are
+    /// answered, and its response is empty if the connection is
+    /// closed before the answer.
+    ///
+    /// \param requests Requests to send
+    /// \param timeout  Maximum time to wait
+    ///
+    /// \return Server's responses, in the order of the requests
+    ///
+    ////////////////////////////////////////////////////////////
+    std::vector<Response> sendRequests(const std::vector<Request>& requests, Time timeout = Time::Zero);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Close the connections kept open
+    ///
+    ////////////////////////////////////////////////////////////
+    void closeConnections();
+
 private :
 
+    ////////////////////////////////////////////////////////////
+    /// \brief Connection to the host, with its received data
+    ///
+    ////////////////////////////////////////////////////////////
+    struct Connection
+    {
+        TcpSocket         socket;   ///< Socket connected to the host
+        std::vector<char> buffer;   ///< Data received
+        std::size_t       begin;    ///< Start of the data not parsed yet
+        std::size_t       end;      ///< End of the data received
+        Int64             lastUsed; ///< Time of the last response, in microseconds
+    };
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Add the missing mandatory fields to a request and
+    ///        convert it to a string
+    ///
+    /// \param request Request to prepare
+    ///
+    /// \return String containing the request, ready to be sent
+    ///
+    ////////////////////////////////////////////////////////////
+    std::string prepareRequest(const Request& request) const;
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Send requests and read their responses
+    ///
+    /// \param requests  Requests to send
+    /// \param responses Responses to fill, one per request
+    /// \param count     Number of requests
+    /// \param callback  Function receiving the bodies, or NULL
+    /// \param timeout   Maximum time to wait for a connection
+    ///
+    ////////////////////////////////////////////////////////////
+    void process(const Request* requests, Response* responses, std::size_t count, const BodyCallback* callback, Time timeout);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Get an open connection to the host
+    ///
+    /// \param timeout Maximum time to wait for a new connection
+    /// \param reused  Set to true if the connection was already open
+    ///
+    /// \return Connection, NULL if the host couldn't be reached
+    ///
+    ////////////////////////////////////////////////////////////
+    Connection* acquireConnection(Time timeout, bool& reused);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Keep a connection open for the next requests
+    ///
+    /// \param connection Connection to keep
+    ///
+    ////////////////////////////////////////////////////////////
+    void releaseConnection(Connection* connection);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Read a response from a connection
+    ///
+    /// \param connection Connection to read from
+    /// \param response   Response to fill, ready to be parsed
+    ///
+    ////////////////////////////////////////////////////////////
+    void receiveResponse(Connection& connection, Response& response);
+
     ////////////////////////////////////////////////////////////
     // Member data
     ////////////////////////////////////////////////////////////
-    TcpSocket      m_connection; ///< Connection to the host
-    IpAddress      m_host;       ///< Web host address
-    std::string    m_hostName;   ///< Web host name
-    unsigned short m_port;       ///< Port used for connection with host
+    IpAddress                m_host;        ///< Web host address
+    std::string              m_hostName;    ///< Web host name
+    unsigned short           m_port;        ///< Port used for connection with host
+    std::vector<Connection*> m_connections; ///< Idle connections to the host
+    Mutex                    m_mutex;       ///< Mutex protecting the idle connections
+    Clock                    m_clock;       ///< Clock measuring how long the connections are idle
 };
 
 } // namespace TGE
@@ -431,6 +635,15 @@ private :
 /// TGE::Http::Request and return the corresponding TGE::Http::Response
 /// from the server.
 ///
+/// The connections are kept open between requests (HTTP/1.1
+/// keep-alive), so a series of small requests to the same host
+/// only pays for the TCP handshake once. sendRequests pipelines
+/// several requests on a single connection, and a body callback
+/// streams large responses instead of storing them. A request
+/// that failed because the server closed a kept-alive connection
+/// is sent again only if it's a GET or a HEAD: a POST may have
+/// been processed, the caller decides what to do.
+///
 /// Usage example:
 /// \code
 /// // Create a new HTTP client
@@ -455,6 +668,14 @@ private :
 /// {
 ///     std::cout << "Error " << status << std::endl;
 /// }
+///
+/// // Download a large file straight to the disk
+/// std::ofstream file("level.pak", std::ios::binary);
+/// http.sendRequest(TGE::Http::Request("level.pak"), [&](const char* data, std::size_t size)
+/// {
+///     file.write(data, size);
+///     return true;
+/// });
 /// \endcode
 ///
 ////////////////////////////////////////////////////////////
@@ -0,0 +1,301 @@
+/*************************************/
+/** Copyright © 2014 Coldsnap Games **/
+/*************************************/
+
+#ifndef TGE_HTTPDOWNLOADER_HPP
+#define TGE_HTTPDOWNLOADER_HPP
+
+/*************************************/
+/**             Headers             **/
+/*************************************/
+#include <Tyrant/Config.hpp>
+#include <Tyrant/Network/Http.hpp>
+#include <Tyrant/System/Mutex.hpp>
+#include <Tyrant/System/NonCopyable.hpp>
+#include <Tyrant/System/Time.hpp>
+#include <atomic>
+#include <fstream>
+#include <string>
+#include <vector>
+
+
+namespace TGE
+{
+////////////////////////////////////////////////////////////
+/// \brief Downloads large files over several HTTP
+///        connections, and resumes interrupted downloads
+///
+////////////////////////////////////////////////////////////
+class TGE_API HttpDownloader : NonCopyable
+{
+public :
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Result of a download
+    ///
+    ////////////////////////////////////////////////////////////
+    enum Status
+    {
+        Done,    ///< The file was downloaded completely
+        Stopped, ///< The download was stopped, it can be resumed
+        Error    ///< The download failed, it can be resumed if the error is temporary
+    };
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Default constructor
+    ///
+    /// The downloader uses 4 connections and chunks of 4 MB.
+    ///
+    ////////////////////////////////////////////////////////////
+    HttpDownloader();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Set the web server to download from
+    ///
+    /// \param host Web server to connect to
+    /// \param port Port to use for connection, 0 for the default
+    ///             port of the protocol
+    ///
+    /// \see Http::setHost
+    ///
+    ////////////////////////////////////////////////////////////
+    void setHost(const std::string& host, unsigned short port = 0);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Set the number of connections used at once
+    ///
+    /// \param count Number of connections, at least 1
+    ///
+    ////////////////////////////////////////////////////////////
+    void setConnectionCount(unsigned int count);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Set the size of the chunks
+    ///
+    /// Each chunk is a separate range request, verified and
+    /// recorded in the journal when complete; an interrupted
+    /// download resumes at the chunk level. The size must not
+    /// change between a download and its resumption, otherwise
+    /// the download restarts from the beginning.
+    ///
+    /// \param size Size of a chunk, in bytes
+    ///
+    ////////////////////////////////////////////////////////////
+    void setChunkSize(std::size_t size);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Set the expected checksums of the chunks
+    ///
+    /// If the publisher of the file provides the checksum of
+    /// each chunk, computed with computeChecksum, every chunk
+    /// downloaded is checked against it and downloaded again if
+    /// it doesn't match. Without them, the checksums only
+    /// protect the resumed downloads against a damaged file.
+    ///
+    /// \param checksums CRC-32 of each chunk, empty to check none
+    ///
+    ////////////////////////////////////////////////////////////
+    void setExpectedChecksums(const std::vector<Uint32>& checksums);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Download a file
+    ///
+    /// The file is downloaded to "<filename>.part", along with a
+    /// journal of the chunks received, "<filename>.journal".
+    /// Once complete, it is renamed to \a filename and the
+    /// journal is removed. If both files exist when the
+    /// download starts, and the file didn't change on the
+    /// server, the chunks already received are verified and
+    /// only the missing ones are downloaded.
+    ///
+    /// If the server doesn't support range requests, the file
+    /// is downloaded over a single connection and can't be
+    /// resumed.
+    ///
+    /// This function blocks until the download is over; use
+    /// a thread to keep the application running meanwhile.
+    ///
+    /// \param uri      URI of the file on the server
+    /// \param filename Path of the file to write
+    /// \param timeout  Maximum time to wait for a connection
+    ///
+    /// \return Result of the download
+    ///
+    ////////////////////////////////////////////////////////////
+    Status download(const std::string& uri, const std::string& filename, Time timeout = Time::Zero);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Stop the download in progress
+    ///
+    /// This function can be called from any thread. download()
+    /// returns Stopped shortly after, and the download can be
+    /// resumed later.
+    ///
+    ////////////////////////////////////////////////////////////
+    void stop();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Get the number of bytes received so far
+    ///
+    /// This function can be called from any thread.
+    ///
+    /// \return Number of bytes of the file received, including
+    ///         the ones received before a resumption
+    ///
+    ////////////////////////////////////////////////////////////
+    Uint64 getDownloadedSize() const;
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Get the size of the file
+    ///
+    /// This function can be called from any thread.
+    ///
+    /// \return Size of the file being downloaded, 0 if not
+    ///         known yet
+    ///
+    ////////////////////////////////////////////////////////////
+    Uint64 getTotalSize() const;
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Compute the checksum of a block of data
+    ///
+    /// The checksum is a CRC-32, the same as zip files use.
+    /// To compute the checksum of data split in several
+    /// blocks, pass the checksum of the previous blocks.
+    ///
+    /// \param data     Pointer to the data
+    /// \param size     Size of the data, in bytes
+    /// \param previous Checksum of the previous blocks
+    ///
+    /// \return Checksum of the data
+    ///
+    ////////////////////////////////////////////////////////////
+    static Uint32 computeChecksum(const void* data, std::size_t size, Uint32 previous = 0);
+
+private :
+
+    ////////////////////////////////////////////////////////////
+    /// \brief States of a chunk
+    ///
+    ////////////////////////////////////////////////////////////
+    enum ChunkState
+    {
+        Pending,    ///< Not downloaded yet
+        InProgress, ///< Being downloaded by a worker
+        Finished    ///< Downloaded and verified
+    };
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Range of the file downloaded by a single request
+    ///
+    ////////////////////////////////////////////////////////////
+    struct Chunk
+    {
+        Uint64       offset;   ///< Position of the chunk in the file
+        Uint64       size;     ///< Size of the chunk
+        ChunkState   state;    ///< Download state
+        unsigned int attempts; ///< Number of failed downloads
+    };
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Download the whole file over a single connection
+    ///
+    /// \param filename Path of the file to write
+    ///
+    /// \return Result of the download
+    ///
+    ////////////////////////////////////////////////////////////
+    Status downloadWhole(const std::string& filename);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Load the journal of a previous download
+    ///
+    /// The chunks recorded in the journal are verified against
+    /// the file and marked as finished.
+    ///
+    /// \param filename  Path of the file to write
+    /// \param validator ETag or date of the file on the server
+    ///
+    /// \return True if the previous download can be resumed
+    ///
+    ////////////////////////////////////////////////////////////
+    bool loadJournal(const std::string& filename, const std::string& validator);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Download chunks until none is left
+    ///
+    /// This function is the entry point of the worker threads.
+    ///
+    ////////////////////////////////////////////////////////////
+    void downloadChunks();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Move the downloaded file to its final path
+    ///
+    /// \param filename Path of the file to write
+    ///
+    /// \return True on success
+    ///
+    ////////////////////////////////////////////////////////////
+    bool finish(const std::string& filename);
+
+    ////////////////////////////////////////////////////////////
+    // Member data
+    ////////////////////////////////////////////////////////////
+    Http                m_http;            ///< Client shared by the workers, one connection each
+    unsigned int        m_connectionCount; ///< Number of connections used at once
+    std::size_t         m_chunkSize;       ///< Size of the chunks
+    std::vector<Uint32> m_expected;        ///< Expected checksums of the chunks
+    std::string         m_uri;             ///< URI of the file being downloaded
+    std::string         m_partName;        ///< Path of the file being written
+    Time                m_timeout;         ///< Maximum time to wait for a connection
+    std::vector<Chunk>  m_chunks;          ///< Chunks of the file
+    std::ofstream       m_journal;         ///< Journal of the chunks finished
+    Mutex               m_mutex;           ///< Mutex protecting the chunks and the journal
+    std::atomic<bool>   m_stop;            ///< Was the download stopped?
+    std::atomic<Uint64> m_downloadedSize;  ///< Number of bytes received
+    std::atomic<Uint64> m_totalSize;       ///< Size of the file
+};
+
+} // namespace TGE
+
+
+#endif // TGE_HTTPDOWNLOADER_HPP
+
+
+////////////////////////////////////////////////////////////
+/// \class TGE::HttpDownloader
+/// \ingroup network
+///
+/// TGE::Http holds the whole response in memory and uses a
+/// single connection, which is fine for web pages but not for
+/// content packs of several gigabytes. TGE::HttpDownloader
+/// splits the file in chunks, fetched with range requests
+/// over several connections at once and written straight to
+/// their place in the file.
+///
+/// Each chunk finished is recorded with its checksum in a
+/// journal next to the file. When a download is interrupted,
+/// by a lost connection, stop(), or the game being closed,
+/// calling download() again with the same parameters resumes
+/// it: the chunks recorded are verified and only the others
+/// are downloaded. A chunk that fails is retried a few times
+/// before the download gives up.
+///
+/// Usage example:
+/// \code
+/// TGE::HttpDownloader downloader;
+/// downloader.setHost("http://cdn.example.com");
+/// downloader.setConnectionCount(6);
+///
+/// // In a thread
+/// if (downloader.download("/packs/level3.pak", "packs/level3.pak") == TGE::HttpDownloader::Done)
+///     loadPack("packs/level3.pak");
+///
+/// // In the loading screen
+/// float progress = static_cast<float>(downloader.getDownloadedSize()) / downloader.getTotalSize();
+/// \endcode
+///
+/// \see TGE::Http
+///
+////////////////////////////////////////////////////////////
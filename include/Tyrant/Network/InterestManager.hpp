@@ -0,0 +1,359 @@
+/*************************************/
+/** Copyright © 2014 Coldsnap Games **/
+/*************************************/
+
+#ifndef TGE_INTERESTMANAGER_HPP
+#define TGE_INTERESTMANAGER_HPP
+
+/*************************************/
+/**             Headers             **/
+/*************************************/
+#include <Tyrant/Config.hpp>
+#include <Tyrant/Network/Packet.hpp>
+#include <Tyrant/System/NonCopyable.hpp>
+#include <Tyrant/System/Vector2.hpp>
+#include <functional>
+#include <utility>
+#include <vector>
+
+
+namespace TGE
+{
+////////////////////////////////////////////////////////////
+/// \brief Chooses which entities to send to each client, and
+///        in which order, within a bandwidth budget
+///
+////////////////////////////////////////////////////////////
+class TGE_API InterestManager : NonCopyable
+{
+public :
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Function writing the state of an entity to a packet
+    ///
+    ////////////////////////////////////////////////////////////
+    typedef std::function<void (Uint16 entity, Packet& packet)> Writer;
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Construct the manager
+    ///
+    /// \param cellSize Size of the cells of the spatial grid,
+    ///                 about the radius of the areas of interest
+    ///
+    ////////////////////////////////////////////////////////////
+    explicit InterestManager(float cellSize);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Set how far an entity must go past the radius of
+    ///        an area of interest to leave it
+    ///
+    /// An entity enters an area when it gets within its radius,
+    /// and only leaves it when it gets further than the radius
+    /// times \a factor, so that entities moving along the edge
+    /// don't keep entering and leaving. The default is 1.2.
+    ///
+    /// \param factor Ratio of the leaving radius to the entering
+    ///               radius, at least 1
+    ///
+    ////////////////////////////////////////////////////////////
+    void setHysteresis(float factor);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Set the priority of the entities that didn't change
+    ///        since they were last sent to a client
+    ///
+    /// Such entities are still sent from time to time, as
+    /// updates may have been lost, but less often. The default
+    /// is 0.1, ten times less than the entities that changed.
+    ///
+    /// \param factor Factor applied to the priority of the
+    ///               entities that didn't change
+    ///
+    ////////////////////////////////////////////////////////////
+    void setIdleFactor(float factor);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Add an entity, or update its position
+    ///
+    /// An entity whose position changes is considered changed.
+    ///
+    /// \param entity   Identifier of the entity
+    /// \param position Position of the entity
+    /// \param priority Importance of the entity, relative to the
+    ///                 others; a player may be 2, a particle 0.5
+    ///
+    ////////////////////////////////////////////////////////////
+    void setEntity(Uint16 entity, const Vector2f& position, float priority = 1.f);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Tell that the state of an entity changed
+    ///
+    /// Use this function when something else than the position
+    /// changes, like the health.
+    ///
+    /// \param entity Identifier of the entity
+    ///
+    ////////////////////////////////////////////////////////////
+    void markChanged(Uint16 entity);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Remove an entity
+    ///
+    /// It leaves all the areas of interest at the next update.
+    ///
+    /// \param entity Identifier of the entity
+    ///
+    ////////////////////////////////////////////////////////////
+    void removeEntity(Uint16 entity);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Add a client
+    ///
+    /// \return Identifier of the client
+    ///
+    ////////////////////////////////////////////////////////////
+    std::size_t addClient();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Remove a client
+    ///
+    /// Its identifier may be given to a later client.
+    ///
+    /// \param client Identifier of the client
+    ///
+    ////////////////////////////////////////////////////////////
+    void removeClient(std::size_t client);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Set the area of interest of a client
+    ///
+    /// \param client Identifier of the client
+    /// \param center Center of the area, usually the position of
+    ///               the client's camera or avatar
+    /// \param radius Distance within which entities enter the area
+    ///
+    ////////////////////////////////////////////////////////////
+    void setArea(std::size_t client, const Vector2f& center, float radius);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Set the maximum size of the updates written for a
+    ///        client
+    ///
+    /// The default is 1200 bytes, which fits a datagram.
+    ///
+    /// \param client Identifier of the client
+    /// \param size   Maximum size of the packet, in bytes
+    ///
+    ////////////////////////////////////////////////////////////
+    void setBudget(std::size_t client, std::size_t size);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Update the areas of interest and the priorities
+    ///
+    /// This function must be called once per tick, after the
+    /// entities and the areas are updated and before the
+    /// updates are written.
+    ///
+    ////////////////////////////////////////////////////////////
+    void update();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Write the most important updates for a client
+    ///
+    /// The entities of the client's area are written by
+    /// decreasing priority, as long as they fit in the budget.
+    /// The entities written get their priority reset, the
+    /// others keep it and are more likely to be written next
+    /// time.
+    ///
+    /// \param client Identifier of the client
+    /// \param packet Packet to append the updates to
+    /// \param writer Function writing an entity
+    ///
+    /// \return Number of entities written
+    ///
+    ////////////////////////////////////////////////////////////
+    std::size_t writeUpdates(std::size_t client, Packet& packet, const Writer& writer);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Get the entities which entered the area of a
+    ///        client at the last update
+    ///
+    /// \param client Identifier of the client
+    ///
+    /// \return Entities sorted by identifier
+    ///
+    ////////////////////////////////////////////////////////////
+    const std::vector<Uint16>& getEnteredEntities(std::size_t client) const;
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Get the entities which left the area of a client
+    ///        at the last update
+    ///
+    /// The client should be told to destroy them, over a
+    /// reliable channel.
+    ///
+    /// \param client Identifier of the client
+    ///
+    /// \return Entities sorted by identifier
+    ///
+    ////////////////////////////////////////////////////////////
+    const std::vector<Uint16>& getLeftEntities(std::size_t client) const;
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Get the number of entities in the area of a client
+    ///
+    /// \param client Identifier of the client
+    ///
+    /// \return Number of entities
+    ///
+    ////////////////////////////////////////////////////////////
+    std::size_t getEntityCount(std::size_t client) const;
+
+private :
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Replicated entity
+    ///
+    ////////////////////////////////////////////////////////////
+    struct Entity
+    {
+        bool     exists;     ///< Is the slot used?
+        Vector2f position;   ///< Position of the entity
+        float    priority;   ///< Importance of the entity
+        Uint32   changeTick; ///< Tick of the last change
+    };
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Entity in the area of a client
+    ///
+    ////////////////////////////////////////////////////////////
+    struct Interest
+    {
+        Uint16 entity;      ///< Identifier of the entity
+        float  accumulator; ///< Priority accumulated since the entity was last sent
+        Uint32 sentTick;    ///< Tick the entity was last sent at, 0 if never
+    };
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Area of interest of a client
+    ///
+    ////////////////////////////////////////////////////////////
+    struct Client
+    {
+        Client();
+
+        bool                  connected; ///< Is the slot used?
+        Vector2f              center;    ///< Center of the area
+        float                 radius;    ///< Radius within which entities enter the area
+        std::size_t           budget;    ///< Maximum size of the updates
+        std::vector<Interest> interests; ///< Entities in the area, sorted by identifier
+        std::vector<Uint16>   entered;   ///< Entities which entered the area at the last update
+        std::vector<Uint16>   left;      ///< Entities which left the area at the last update
+    };
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Get the key of the grid cell containing a position
+    ///
+    /// \param x Cell column
+    /// \param y Cell row
+    ///
+    /// \return Key of the cell, keys are sorted by row then column
+    ///
+    ////////////////////////////////////////////////////////////
+    static Uint64 getCellKey(Int32 x, Int32 y);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Update the area of interest of a client
+    ///
+    /// \param client Client to update
+    ///
+    ////////////////////////////////////////////////////////////
+    void updateClient(Client& client);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Add the priority of a tick to an entity of an area
+    ///
+    /// \param interest        Entity of the area
+    /// \param distanceSquared Squared distance of the entity to
+    ///                        the center of the area
+    /// \param leaveRadius     Radius of the area to leave it
+    ///
+    ////////////////////////////////////////////////////////////
+    void accumulate(Interest& interest, float distanceSquared, float leaveRadius) const;
+
+    ////////////////////////////////////////////////////////////
+    // Member data
+    ////////////////////////////////////////////////////////////
+    float                                       m_cellSize;   ///< Size of the grid cells
+    float                                       m_hysteresis; ///< Ratio of the leaving radius to the entering radius
+    float                                       m_idleFactor; ///< Priority factor of the entities that didn't change
+    Uint32                                      m_tick;       ///< Number of updates
+    std::vector<Entity>                         m_entities;   ///< Entities, indexed by identifier
+    std::vector<Client>                         m_clients;    ///< Clients, indexed by identifier
+    std::vector<std::pair<Uint64, Uint16> >     m_grid;       ///< Entities sorted by grid cell
+    std::vector<Uint16>                         m_candidates; ///< Entities within the leaving radius of a client
+    std::vector<Uint32>                         m_marks;      ///< Stamp of the client update each entity was last found by, indexed by entity
+    std::vector<float>                          m_distances;  ///< Squared distance to the client found at, indexed by entity
+    Uint32                                      m_stamp;      ///< Stamp of the current client update
+    std::vector<Interest>                       m_interests;  ///< Entities entering the area of a client
+    std::vector<std::pair<float, std::size_t> > m_order;      ///< Heap of the entities of a client by priority
+    Packet                                      m_update;     ///< Update of a single entity
+};
+
+} // namespace TGE
+
+
+#endif // TGE_INTERESTMANAGER_HPP
+
+
+////////////////////////////////////////////////////////////
+/// \class TGE::InterestManager
+/// \ingroup network
+///
+/// Without interest management, every client receives every
+/// entity, and the bandwidth and server time grow with the
+/// number of clients times the number of entities.
+/// TGE::InterestManager sends each client only the entities
+/// around it, most important first:
+/// \li the entities are sorted in a grid, so that finding the
+///     ones near a client only looks at a few cells;
+/// \li each client has an area of interest, with a larger
+///     radius to leave it than to enter it;
+/// \li each entity of an area accumulates priority on every
+///     tick, more when it is close to the center, and much
+///     more when it changed since it was last sent;
+/// \li the updates are written by decreasing priority until
+///     the client's budget is used, and the entities written
+///     start again from zero. The entities left out keep their
+///     priority and eventually get through.
+///
+/// The updates hold the whole state of the entities, as the
+/// writer function writes it: they are sent unreliably, and a
+/// lost update is simply replaced by a later one. Entering and
+/// leaving the areas are reported separately, to be sent over
+/// a reliable channel.
+///
+/// Usage example:
+/// \code
+/// // On every tick
+/// for (auto& entity : entities)
+///     interest.setEntity(entity.id, entity.position, entity.isPlayer ? 2.f : 1.f);
+/// for (auto& client : clients)
+///     interest.setArea(client.id, client.camera, 800.f);
+/// interest.update();
+///
+/// for (auto& client : clients)
+/// {
+///     TGE::Packet packet;
+///     interest.writeUpdates(client.id, packet, [&](TGE::Uint16 id, TGE::Packet& update)
+///     {
+///         update << id << entities[id].position.x << entities[id].position.y;
+///     });
+///     client.connection.send(packet, TGE::UdpConnection::UnreliableSequenced);
+/// }
+/// \endcode
+///
+/// \see TGE::ReplicationServer, TGE::UdpConnection
+///
+////////////////////////////////////////////////////////////
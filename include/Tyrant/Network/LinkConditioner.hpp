@@ -0,0 +1,253 @@
+/*************************************/
+/** Copyright © 2014 Coldsnap Games **/
+/*************************************/
+
+#ifndef TGE_LINKCONDITIONER_HPP
+#define TGE_LINKCONDITIONER_HPP
+
+/*************************************/
+/**             Headers             **/
+/*************************************/
+#include <Tyrant/Config.hpp>
+#include <Tyrant/Network/IpAddress.hpp>
+#include <Tyrant/Network/UdpSocket.hpp>
+#include <Tyrant/System/Clock.hpp>
+#include <Tyrant/System/NonCopyable.hpp>
+#include <Tyrant/System/Time.hpp>
+#include <random>
+#include <vector>
+
+
+namespace TGE
+{
+class Packet;
+
+////////////////////////////////////////////////////////////
+/// \brief Simulates a bad network in front of a UDP socket
+///
+////////////////////////////////////////////////////////////
+class TGE_API LinkConditioner : NonCopyable
+{
+public :
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Construct the conditioner
+    ///
+    /// A new conditioner lets everything through, right away.
+    ///
+    /// \param socket Socket sending the datagrams, must outlive
+    ///               the conditioner
+    /// \param seed   Seed of the random decisions
+    ///
+    ////////////////////////////////////////////////////////////
+    explicit LinkConditioner(UdpSocket& socket, Uint32 seed = 0);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Set the time the datagrams take to arrive
+    ///
+    /// \param latency One-way latency of the link
+    ///
+    ////////////////////////////////////////////////////////////
+    void setLatency(Time latency);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Set the variation of the latency
+    ///
+    /// Each datagram gets a random latency within \a jitter of
+    /// the latency. The datagrams still arrive in order, unless
+    /// they are reordered.
+    ///
+    /// \param jitter Maximum deviation from the latency
+    ///
+    ////////////////////////////////////////////////////////////
+    void setJitter(Time jitter);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Set the probability that a datagram is lost
+    ///
+    /// \param probability Probability, between 0 and 1
+    ///
+    ////////////////////////////////////////////////////////////
+    void setLoss(float probability);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Set the probability that a datagram arrives after
+    ///        the ones sent after it
+    ///
+    /// A reordered datagram is held back by one more latency,
+    /// and at least a millisecond.
+    ///
+    /// \param probability Probability, between 0 and 1
+    ///
+    ////////////////////////////////////////////////////////////
+    void setReordering(float probability);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Set the bandwidth of the link
+    ///
+    /// The datagrams queue up when they are sent faster than
+    /// the bandwidth, and are dropped once they would wait in
+    /// the queue more than 250 ms, like in a router.
+    ///
+    /// \param bytesPerSecond Bandwidth, 0 for unlimited
+    ///
+    ////////////////////////////////////////////////////////////
+    void setBandwidth(Uint32 bytesPerSecond);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Restart the random decisions from a seed
+    ///
+    /// With the same seed and the same datagrams sent, the same
+    /// datagrams are lost and reordered.
+    ///
+    /// \param seed Seed of the random decisions
+    ///
+    ////////////////////////////////////////////////////////////
+    void setSeed(Uint32 seed);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Send raw data to a remote peer through the link
+    ///
+    /// \param data          Pointer to the data to send
+    /// \param size          Number of bytes to send
+    /// \param remoteAddress Address of the receiver
+    /// \param remotePort    Port of the receiver
+    ///
+    /// \return Socket::Done if the datagram entered the link,
+    ///         even if it is lost later, Socket::Error if it is
+    ///         too big
+    ///
+    ////////////////////////////////////////////////////////////
+    Socket::Status send(const void* data, std::size_t size, const IpAddress& remoteAddress, unsigned short remotePort);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Send a packet to a remote peer through the link
+    ///
+    /// \param packet        Packet to send
+    /// \param remoteAddress Address of the receiver
+    /// \param remotePort    Port of the receiver
+    ///
+    /// \return Status code, see the other overload
+    ///
+    ////////////////////////////////////////////////////////////
+    Socket::Status send(Packet& packet, const IpAddress& remoteAddress, unsigned short remotePort);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Send the datagrams that reached the end of the link
+    ///
+    /// This function must be called often, at least every
+    /// millisecond for the latencies to be accurate.
+    ///
+    ////////////////////////////////////////////////////////////
+    void update();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Get the number of datagrams in the link
+    ///
+    /// \return Number of datagrams not sent by the socket yet
+    ///
+    ////////////////////////////////////////////////////////////
+    std::size_t getPendingCount() const;
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Get the number of datagrams dropped
+    ///
+    /// \return Number of datagrams lost or dropped by the
+    ///         bandwidth limit
+    ///
+    ////////////////////////////////////////////////////////////
+    Uint64 getDroppedCount() const;
+
+private :
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Datagram in the link
+    ///
+    ////////////////////////////////////////////////////////////
+    struct Datagram
+    {
+        Int64             time;     ///< Time at which the datagram leaves the link
+        Uint64            sequence; ///< Order in which the datagram was sent, for the ties
+        IpAddress         address;  ///< Address of the receiver
+        unsigned short    port;     ///< Port of the receiver
+        std::vector<char> data;     ///< Data of the datagram
+    };
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Order of the datagrams in the heap, earliest first
+    ///
+    ////////////////////////////////////////////////////////////
+    struct Later
+    {
+        bool operator ()(const Datagram& left, const Datagram& right) const;
+    };
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Get a random number
+    ///
+    /// \return Number in [0, 1[
+    ///
+    ////////////////////////////////////////////////////////////
+    float random();
+
+    ////////////////////////////////////////////////////////////
+    // Member data
+    ////////////////////////////////////////////////////////////
+    UdpSocket&                      m_socket;      ///< Socket sending the datagrams
+    Int64                           m_latency;     ///< One-way latency, in microseconds
+    Int64                           m_jitter;      ///< Maximum deviation from the latency, in microseconds
+    float                           m_loss;        ///< Probability that a datagram is lost
+    float                           m_reordering;  ///< Probability that a datagram is reordered
+    Uint32                          m_bandwidth;   ///< Bandwidth in bytes per second, 0 for unlimited
+    std::mt19937                    m_generator;   ///< Generator of the random decisions
+    Clock                           m_clock;       ///< Clock giving the current time
+    Int64                           m_linkFree;    ///< Time at which the link finishes sending the queued datagrams
+    Int64                           m_lastArrival; ///< Time at which the last datagram in order leaves the link
+    Uint64                          m_sequence;    ///< Number of datagrams sent
+    Uint64                          m_dropped;     ///< Number of datagrams dropped
+    std::vector<Datagram>           m_link;        ///< Datagrams in the link, as a heap
+    std::vector<std::vector<char> > m_buffers;     ///< Buffers of the datagrams sent, reused
+};
+
+} // namespace TGE
+
+
+#endif // TGE_LINKCONDITIONER_HPP
+
+
+////////////////////////////////////////////////////////////
+/// \class TGE::LinkConditioner
+/// \ingroup network
+///
+/// Networking code must cope with latency, jitter, lost and
+/// reordered datagrams, and limited bandwidth, none of which
+/// happens over the loopback interface. TGE::LinkConditioner
+/// sits between the code sending the datagrams and its
+/// TGE::UdpSocket, and holds, drops and reorders the datagrams
+/// like a bad network would, entirely in the process. The
+/// random decisions come from a seeded generator, so a test
+/// run can be repeated exactly.
+///
+/// The conditioner only affects the datagrams sent through it;
+/// to condition both directions, each peer uses one. A
+/// TGE::UdpConnection sends through a conditioner with
+/// TGE::UdpConnection::setLinkConditioner.
+///
+/// Usage example:
+/// \code
+/// TGE::UdpSocket socket;
+/// socket.bind(TGE::Socket::AnyPort);
+///
+/// TGE::LinkConditioner conditioner(socket, 42);
+/// conditioner.setLatency(TGE::milliseconds(80));
+/// conditioner.setJitter(TGE::milliseconds(15));
+/// conditioner.setLoss(0.02f);
+/// conditioner.setBandwidth(64 * 1024);
+///
+/// TGE::UdpConnection connection(socket, server, 55002);
+/// connection.setLinkConditioner(&conditioner);
+/// \endcode
+///
+/// \see TGE::UdpSocket, TGE::UdpConnection
+///
+////////////////////////////////////////////////////////////
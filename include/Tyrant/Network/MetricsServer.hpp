@@ -0,0 +1,467 @@
+/*************************************/
+/** Copyright © 2014 Coldsnap Games **/
+/*************************************/
+
+#ifndef TGE_METRICSSERVER_HPP
+#define TGE_METRICSSERVER_HPP
+
+/*************************************/
+/**             Headers             **/
+/*************************************/
+#include <Tyrant/Config.hpp>
+#include <Tyrant/Network/NetworkService.hpp>
+#include <Tyrant/Network/SocketSelector.hpp>
+#include <Tyrant/Network/TcpListener.hpp>
+#include <Tyrant/Network/TcpSocket.hpp>
+#include <Tyrant/System/Clock.hpp>
+#include <Tyrant/System/MemoryArena.hpp>
+#include <Tyrant/System/MemoryPool.hpp>
+#include <Tyrant/System/Mutex.hpp>
+#include <Tyrant/System/NonCopyable.hpp>
+#include <Tyrant/System/Thread.hpp>
+#include <atomic>
+#include <functional>
+#include <list>
+#include <string>
+#include <vector>
+
+
+namespace TGE
+{
+////////////////////////////////////////////////////////////
+/// \brief Embedded HTTP server exposing the metrics of the
+///        engine to monitoring tools
+///
+////////////////////////////////////////////////////////////
+class TGE_API MetricsServer : NonCopyable
+{
+public :
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Distribution of values in fixed buckets
+    ///
+    ////////////////////////////////////////////////////////////
+    class TGE_API Histogram
+    {
+    public :
+
+        ////////////////////////////////////////////////////////////
+        /// \brief Construct the histogram from the upper bounds of
+        ///        its buckets
+        ///
+        /// A last bucket, without upper bound, catches the values
+        /// above the last bound.
+        ///
+        /// \param bounds Upper bounds of the buckets, in increasing order
+        ///
+        ////////////////////////////////////////////////////////////
+        explicit Histogram(const std::vector<double>& bounds);
+
+        ////////////////////////////////////////////////////////////
+        /// \brief Add a value to the histogram
+        ///
+        /// \param value Value to add
+        ///
+        ////////////////////////////////////////////////////////////
+        void observe(double value);
+
+        ////////////////////////////////////////////////////////////
+        /// \brief Remove all the values
+        ///
+        ////////////////////////////////////////////////////////////
+        void clear();
+
+        ////////////////////////////////////////////////////////////
+        /// \brief Get the upper bounds of the buckets
+        ///
+        /// \return Upper bounds, without the last bucket
+        ///
+        ////////////////////////////////////////////////////////////
+        const std::vector<double>& getBounds() const;
+
+        ////////////////////////////////////////////////////////////
+        /// \brief Get the number of values in each bucket
+        ///
+        /// \return Number of values per bucket, the last one being
+        ///         the values above all the bounds
+        ///
+        ////////////////////////////////////////////////////////////
+        const std::vector<Uint64>& getCounts() const;
+
+        ////////////////////////////////////////////////////////////
+        /// \brief Get the number of values added
+        ///
+        /// \return Number of values
+        ///
+        ////////////////////////////////////////////////////////////
+        Uint64 getCount() const;
+
+        ////////////////////////////////////////////////////////////
+        /// \brief Get the sum of the values added
+        ///
+        /// \return Sum of the values
+        ///
+        ////////////////////////////////////////////////////////////
+        double getSum() const;
+
+    private :
+
+        ////////////////////////////////////////////////////////////
+        // Member data
+        ////////////////////////////////////////////////////////////
+        std::vector<double> m_bounds; ///< Upper bounds of the buckets
+        std::vector<Uint64> m_counts; ///< Number of values per bucket
+        Uint64              m_count;  ///< Number of values
+        double              m_sum;    ///< Sum of the values
+    };
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Kinds of single value metrics
+    ///
+    ////////////////////////////////////////////////////////////
+    enum Type
+    {
+        Counter, ///< Value that only increases, like a number of bytes sent
+        Gauge    ///< Value that goes up and down, like a number of connections
+    };
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Function writing metrics with the write functions
+    ///
+    ////////////////////////////////////////////////////////////
+    typedef std::function<void (MetricsServer&)> Collector;
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Default constructor
+    ///
+    ////////////////////////////////////////////////////////////
+    MetricsServer();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Destructor
+    ///
+    /// Stops the server thread and closes all the connections.
+    ///
+    ////////////////////////////////////////////////////////////
+    ~MetricsServer();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Accept HTTP connections on a port
+    ///
+    /// This function must be called before launch(). The port
+    /// is open on all the network interfaces, it should not be
+    /// reachable from outside the servers' network.
+    ///
+    /// \param port Port to listen to
+    ///
+    /// \return True on success
+    ///
+    ////////////////////////////////////////////////////////////
+    bool listen(unsigned short port);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Start the server thread
+    ///
+    ////////////////////////////////////////////////////////////
+    void launch();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Stop the server thread and close all the
+    ///        connections
+    ///
+    ////////////////////////////////////////////////////////////
+    void stop();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Add a function writing metrics
+    ///
+    /// The collectors are called by update(), in the order they
+    /// were added, when a monitoring tool requests the metrics.
+    ///
+    /// \param collector Function to add
+    ///
+    ////////////////////////////////////////////////////////////
+    void addCollector(const Collector& collector);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Add a collector writing the usage of a memory pool
+    ///
+    /// \param name Name of the pool in the metrics
+    /// \param pool Pool to watch, it must outlive the server
+    ///
+    ////////////////////////////////////////////////////////////
+    void addPool(const std::string& name, const MemoryPool& pool);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Add a collector writing the usage of a memory arena
+    ///
+    /// \param name  Name of the arena in the metrics
+    /// \param arena Arena to watch, it must outlive the server
+    ///
+    ////////////////////////////////////////////////////////////
+    void addArena(const std::string& name, const MemoryArena& arena);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Add a collector writing the traffic of each
+    ///        connection of a network service
+    ///
+    /// \param service Network service to watch, it must outlive
+    ///                the server
+    ///
+    ////////////////////////////////////////////////////////////
+    void addNetworkService(const NetworkService& service);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Collect the metrics if they were requested
+    ///
+    /// This function must be called regularly, usually once per
+    /// frame, by the thread that owns the data the collectors
+    /// read. When nobody requested the metrics, it returns
+    /// right away.
+    ///
+    ////////////////////////////////////////////////////////////
+    void update();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Write a metric
+    ///
+    /// This function must only be called by the collectors.
+    ///
+    /// \param type  Kind of metric
+    /// \param name  Name of the metric, like "tge_frames_total"
+    /// \param value Value of the metric
+    ///
+    ////////////////////////////////////////////////////////////
+    void write(Type type, const std::string& name, double value);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Write a value of a metric with a label
+    ///
+    /// This function must only be called by the collectors.
+    ///
+    /// \param type       Kind of metric
+    /// \param name       Name of the metric
+    /// \param label      Name of the label, like "connection"
+    /// \param labelValue Value of the label
+    /// \param value      Value of the metric
+    ///
+    ////////////////////////////////////////////////////////////
+    void write(Type type, const std::string& name, const std::string& label, const std::string& labelValue, double value);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Write a histogram
+    ///
+    /// This function must only be called by the collectors.
+    ///
+    /// \param name      Name of the metric, like "tge_frame_seconds"
+    /// \param histogram Histogram to write
+    ///
+    ////////////////////////////////////////////////////////////
+    void write(const std::string& name, const Histogram& histogram);
+
+private :
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Formats of the metrics
+    ///
+    ////////////////////////////////////////////////////////////
+    enum Format
+    {
+        None, ///< No metrics requested
+        Text, ///< Prometheus text format
+        Json  ///< JSON document
+    };
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Value written by a collector
+    ///
+    ////////////////////////////////////////////////////////////
+    struct Sample
+    {
+        Type                type;       ///< Type of the metric, if not a histogram
+        bool                histogram;  ///< Is the sample a histogram?
+        std::string         name;       ///< Name of the metric
+        std::string         label;      ///< Name of the label, if any
+        std::string         labelValue; ///< Value of the label
+        double              value;      ///< Value, or sum of the histogram
+        Uint64              count;      ///< Number of values of the histogram
+        std::vector<double> bounds;     ///< Upper bounds of the histogram buckets
+        std::vector<Uint64> counts;     ///< Number of values per histogram bucket
+    };
+
+    ////////////////////////////////////////////////////////////
+    /// \brief HTTP connection of a monitoring tool
+    ///
+    ////////////////////////////////////////////////////////////
+    struct Client
+    {
+        TcpSocket   socket;    ///< Socket of the connection
+        std::string request;   ///< Data received and not handled yet
+        std::string response;  ///< Response being sent
+        std::size_t sent;      ///< Number of bytes of the response already sent
+        Format      waiting;   ///< Format of the metrics the client waits for
+        bool        keepAlive; ///< Keep the connection open after the response?
+        bool        closing;   ///< Close the connection once the response is sent?
+        Int64       lastTime;  ///< Time of the last activity, or of the request while waiting
+    };
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Entry point of the server thread
+    ///
+    ////////////////////////////////////////////////////////////
+    void run();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Accept the pending connections of the listener
+    ///
+    ////////////////////////////////////////////////////////////
+    void acceptClients();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Receive and handle the requests of a client
+    ///
+    /// \param client Client to read
+    ///
+    /// \return False if the connection was lost
+    ///
+    ////////////////////////////////////////////////////////////
+    bool receiveRequests(Client& client);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Handle the next complete request of a client
+    ///
+    /// \param client Client whose request to handle
+    ///
+    /// \return False if no complete request was received
+    ///
+    ////////////////////////////////////////////////////////////
+    bool handleRequest(Client& client);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Send as much of the response as possible
+    ///
+    /// \param client Client to write
+    ///
+    /// \return False if the connection was lost or is done
+    ///
+    ////////////////////////////////////////////////////////////
+    bool sendResponse(Client& client);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Answer the clients waiting for the metrics
+    ///
+    /// \param published Were new metrics collected?
+    ///
+    ////////////////////////////////////////////////////////////
+    void answerWaitingClients(bool published);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Start a response
+    ///
+    /// \param client      Client to answer
+    /// \param status      Status line, like "200 OK"
+    /// \param contentType Type of the body
+    /// \param body        Body of the response
+    ///
+    ////////////////////////////////////////////////////////////
+    void respond(Client& client, const char* status, const char* contentType, const std::string& body);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Format the published metrics
+    ///
+    /// \param format Format to use
+    /// \param body   String to fill
+    ///
+    ////////////////////////////////////////////////////////////
+    void formatMetrics(Format format, std::string& body) const;
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Get the next sample to write, reusing the memory
+    ///        of the previous collections
+    ///
+    /// \return Sample to fill
+    ///
+    ////////////////////////////////////////////////////////////
+    Sample& nextSample();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Close a connection
+    ///
+    /// \param client Iterator to the client to close
+    ///
+    /// \return Iterator to the next client
+    ///
+    ////////////////////////////////////////////////////////////
+    std::list<Client>::iterator close(std::list<Client>::iterator client);
+
+    ////////////////////////////////////////////////////////////
+    // Member data
+    ////////////////////////////////////////////////////////////
+    Thread                 m_thread;         ///< Server thread
+    std::atomic<bool>      m_running;        ///< Is the server thread running?
+    std::atomic<bool>      m_requested;      ///< Are the metrics requested by a client?
+    std::atomic<bool>      m_published;      ///< Were new metrics collected since the last answer?
+    std::vector<Collector> m_collectors;     ///< Functions writing the metrics
+    std::vector<Sample>    m_samples;        ///< Samples being written by the collectors
+    std::size_t            m_sampleCount;    ///< Number of samples written by the collectors
+    std::vector<Sample>    m_snapshot;       ///< Samples of the last collection
+    std::size_t            m_snapshotCount;  ///< Number of samples of the last collection
+    bool                   m_hasSnapshot;    ///< Were the metrics ever collected?
+    Mutex                  m_mutex;          ///< Mutex protecting the snapshot
+    TcpListener            m_listener;       ///< Listener accepting the monitoring tools
+    SocketSelector         m_selector;       ///< Selector watching the sockets
+    std::list<Client>      m_clients;        ///< Open connections
+    Clock                  m_clock;          ///< Clock measuring the timeouts
+};
+
+} // namespace TGE
+
+
+#endif // TGE_METRICSSERVER_HPP
+
+
+////////////////////////////////////////////////////////////
+/// \class TGE::MetricsServer
+/// \ingroup network
+///
+/// TGE::MetricsServer lets a monitoring tool watch a running
+/// game, typically a headless server. It answers HTTP/1.1
+/// requests on its own thread:
+/// \li GET /metrics returns the metrics in the Prometheus text
+///     format, ready to be scraped;
+/// \li GET /metrics.json returns them as a JSON document.
+///
+/// The metrics are written by collectors, functions that read
+/// the state of the game and call write(). They run on the
+/// thread that calls update(), usually the game thread, so
+/// they can read its data without any locking, and only when
+/// a request is waiting: between two scrapes, update() costs
+/// a single atomic load, and the server thread sleeps in the
+/// selector. If update() isn't called within a second, for
+/// example because the game is stuck in a long frame, the
+/// metrics of the previous collection are returned.
+///
+/// Collectors for the memory pools and arenas and for the
+/// traffic of a TGE::NetworkService are provided. TGE::Game
+/// adds the frame times, tick rate and resource cache sizes
+/// when given a server, see TGE::Game::setMetricsServer.
+///
+/// Usage example:
+/// \code
+/// TGE::MetricsServer metrics;
+/// metrics.listen(9100);
+/// metrics.addNetworkService(network);
+/// metrics.addPool("bullets", bulletPool);
+/// metrics.addCollector([&](TGE::MetricsServer& server)
+/// {
+///     server.write(TGE::MetricsServer::Gauge, "game_players", players.size());
+/// });
+/// metrics.launch();
+///
+/// // Once per frame, on the game thread
+/// metrics.update();
+/// \endcode
+///
+/// \see TGE::NetworkService
+///
+////////////////////////////////////////////////////////////
@@ -0,0 +1,428 @@
+/*************************************/
+/** Copyright © 2014 Coldsnap Games **/
+/*************************************/
+
+#ifndef TGE_NETWORKSERVICE_HPP
+#define TGE_NETWORKSERVICE_HPP
+
+/*************************************/
+/**             Headers             **/
+/*************************************/
+#include <Tyrant/Config.hpp>
+#include <Tyrant/Network/IpAddress.hpp>
+#include <Tyrant/Network/Packet.hpp>
+#include <Tyrant/Network/SocketSelector.hpp>
+#include <Tyrant/Network/TcpListener.hpp>
+#include <Tyrant/Network/TcpSocket.hpp>
+#include <Tyrant/System/Clock.hpp>
+#include <Tyrant/System/Mutex.hpp>
+#include <Tyrant/System/NonCopyable.hpp>
+#include <Tyrant/System/SpscQueue.hpp>
+#include <Tyrant/System/Thread.hpp>
+#include <Tyrant/System/Time.hpp>
+#include <atomic>
+#include <map>
+#include <vector>
+
+
+namespace TGE
+{
+////////////////////////////////////////////////////////////
+/// \brief Runs TCP connections on a dedicated thread, and
+///        exchanges packets with the game thread through
+///        lock-free queues
+///
+////////////////////////////////////////////////////////////
+class TGE_API NetworkService : NonCopyable
+{
+public :
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Identifier of a connection, never 0
+    ///
+    ////////////////////////////////////////////////////////////
+    typedef Uint32 ConnectionId;
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Something that happened on a connection
+    ///
+    ////////////////////////////////////////////////////////////
+    struct Event
+    {
+        ////////////////////////////////////////////////////////////
+        /// \brief Types of events
+        ///
+        ////////////////////////////////////////////////////////////
+        enum Type
+        {
+            Connected,    ///< The connection was established, or accepted by the listener
+            Disconnected, ///< The connection was closed, or couldn't be established
+            Received,     ///< A packet was received
+            Congested,    ///< The send queue of the connection is over the limit, stop sending
+            Drained       ///< The send queue of the connection is back under half the limit
+        };
+
+        Type         type;       ///< Type of the event
+        ConnectionId connection; ///< Connection concerned
+        Packet       packet;     ///< Packet received, for Received events
+    };
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Traffic of a connection
+    ///
+    ////////////////////////////////////////////////////////////
+    struct Statistics
+    {
+        Uint64 bytesSent;       ///< Size of the packets sent, in bytes
+        Uint64 bytesReceived;   ///< Size of the packets received, in bytes
+        Uint64 packetsSent;     ///< Number of packets sent
+        Uint64 packetsReceived; ///< Number of packets received
+    };
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Default constructor
+    ///
+    /// \param queueCapacity Maximum number of commands waiting
+    ///                      for the network thread, and of
+    ///                      events waiting for the game thread
+    ///
+    ////////////////////////////////////////////////////////////
+    explicit NetworkService(std::size_t queueCapacity = 4096);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Destructor
+    ///
+    /// Stops the network thread and closes all the connections.
+    ///
+    ////////////////////////////////////////////////////////////
+    ~NetworkService();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Accept connections on a port
+    ///
+    /// This function must be called before launch().
+    ///
+    /// \param port Port to listen to
+    ///
+    /// \return True on success
+    ///
+    ////////////////////////////////////////////////////////////
+    bool listen(unsigned short port);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Set the size of the send queues above which the
+    ///        connections are congested
+    ///
+    /// This function must be called before launch(). The
+    /// default limit is 1 MB.
+    ///
+    /// \param size Number of bytes waiting to be sent
+    ///
+    ////////////////////////////////////////////////////////////
+    void setSendLimit(std::size_t size);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Start the network thread
+    ///
+    ////////////////////////////////////////////////////////////
+    void launch();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Stop the network thread and close all the
+    ///        connections
+    ///
+    /// The packets not sent yet are lost, and the events not
+    /// polled yet are discarded.
+    ///
+    ////////////////////////////////////////////////////////////
+    void stop();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Open a connection to a remote peer
+    ///
+    /// The connection is established by the network thread, the
+    /// result is reported by a Connected or Disconnected event.
+    /// Packets can be sent right away, they are queued until
+    /// the connection is established.
+    ///
+    /// \param address Address of the remote peer
+    /// \param port    Port of the remote peer
+    /// \param timeout Maximum time to establish the connection
+    ///
+    /// \return Identifier of the new connection, 0 if the
+    ///         command queue is full
+    ///
+    ////////////////////////////////////////////////////////////
+    ConnectionId connect(const IpAddress& address, unsigned short port, Time timeout = seconds(5.f));
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Send a packet on a connection
+    ///
+    /// The packet is copied and sent by the network thread.
+    /// Packets sent on a connection that doesn't exist anymore
+    /// are ignored.
+    ///
+    /// \param connection Connection to send the packet on
+    /// \param packet     Packet to send
+    ///
+    /// \return False if the command queue is full
+    ///
+    ////////////////////////////////////////////////////////////
+    bool send(ConnectionId connection, const Packet& packet);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Close a connection
+    ///
+    /// The packets already sent on the connection are
+    /// delivered first. A Disconnected event is generated once
+    /// the connection is closed.
+    ///
+    /// \param connection Connection to close
+    ///
+    /// \return False if the command queue is full
+    ///
+    ////////////////////////////////////////////////////////////
+    bool disconnect(ConnectionId connection);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Pop the next event
+    ///
+    /// \param event Event to fill
+    ///
+    /// \return False if there is no event
+    ///
+    ////////////////////////////////////////////////////////////
+    bool pollEvent(Event& event);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Get the traffic of the open connections
+    ///
+    /// The traffic is counted by the network thread, in atomic
+    /// counters of each connection: a packet counts as sent
+    /// once the socket took all of it, the packets lost when a
+    /// connection closes are not counted. A connection is
+    /// listed from the time the network thread opens or
+    /// accepts it, until its Disconnected event is pushed.
+    ///
+    /// This function reads the counters, under a lock that the
+    /// network thread only takes to open and close
+    /// connections; it is meant for monitoring, not for every
+    /// frame. The map returned is valid until the next call.
+    ///
+    /// \return Traffic of each connection, by identifier
+    ///
+    ////////////////////////////////////////////////////////////
+    const std::map<ConnectionId, Statistics>& getStatistics() const;
+
+private :
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Request from the game thread to the network thread
+    ///
+    ////////////////////////////////////////////////////////////
+    struct Command
+    {
+        enum Type
+        {
+            Connect,   ///< Open a connection
+            Send,      ///< Send a packet
+            Disconnect ///< Close a connection
+        };
+
+        Type           type;       ///< Type of the command
+        ConnectionId   connection; ///< Connection concerned
+        IpAddress      address;    ///< Address to connect to
+        unsigned short port;       ///< Port to connect to
+        Time           timeout;    ///< Maximum time to connect
+        Packet         packet;     ///< Packet to send
+    };
+
+    ////////////////////////////////////////////////////////////
+    /// \brief State of a connection, owned by the network thread
+    ///
+    ////////////////////////////////////////////////////////////
+    struct Connection
+    {
+        ConnectionId        id;              ///< Identifier of the connection
+        TcpSocket           socket;          ///< Socket of the connection
+        std::vector<Packet> queue;           ///< Packets waiting to be sent
+        std::size_t         first;           ///< Index of the first packet of the queue not sent yet
+        std::size_t         batchCount;      ///< Number of packets being sent in a single batch, from first
+        std::size_t         queuedSize;      ///< Number of bytes waiting to be sent
+        Int64               deadline;        ///< Time limit to connect
+        bool                connected;       ///< Is the connection established?
+        bool                closing;         ///< Close once the queues are empty?
+        bool                congested;       ///< Was a Congested event sent?
+        bool                watchWrite;      ///< Is the socket watched for writing?
+        std::atomic<Uint64> bytesSent;       ///< Size of the packets sent, read by getStatistics
+        std::atomic<Uint64> bytesReceived;   ///< Size of the packets received, read by getStatistics
+        std::atomic<Uint64> packetsSent;     ///< Number of packets sent, read by getStatistics
+        std::atomic<Uint64> packetsReceived; ///< Number of packets received, read by getStatistics
+    };
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Entry point of the network thread
+    ///
+    ////////////////////////////////////////////////////////////
+    void run();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Wake the network thread up if it is waiting for
+    ///        the sockets
+    ///
+    /// Called after a command is pushed, from the game thread.
+    ///
+    ////////////////////////////////////////////////////////////
+    void wakeUp();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Execute a command of the game thread
+    ///
+    /// \param command Command to execute
+    ///
+    ////////////////////////////////////////////////////////////
+    void execute(Command& command);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Accept the pending connections of the listener
+    ///
+    ////////////////////////////////////////////////////////////
+    void acceptConnections();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Receive the packets available on a connection
+    ///
+    /// \param connection Connection to read
+    ///
+    /// \return False if the connection was lost
+    ///
+    ////////////////////////////////////////////////////////////
+    bool receivePackets(Connection& connection);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Send as many queued packets as possible
+    ///
+    /// \param connection Connection to write
+    ///
+    /// \return False if the connection was lost
+    ///
+    ////////////////////////////////////////////////////////////
+    bool sendPackets(Connection& connection);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Watch a connection for writing only while it has
+    ///        something to send, and close it once it has sent
+    ///        everything if it is closing
+    ///
+    /// \param connection Connection to update, may be destroyed
+    ///
+    ////////////////////////////////////////////////////////////
+    void update(Connection* connection);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Close a connection and report it
+    ///
+    /// \param connection Connection to close, destroyed
+    ///
+    ////////////////////////////////////////////////////////////
+    void close(Connection* connection);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Pass an event to the game thread
+    ///
+    /// Events that don't fit in the queue are kept in a backlog,
+    /// and no packet is received until it is empty again.
+    ///
+    /// \param event Event to pass
+    ///
+    ////////////////////////////////////////////////////////////
+    void pushEvent(const Event& event);
+
+    ////////////////////////////////////////////////////////////
+    // Member data
+    ////////////////////////////////////////////////////////////
+    Thread                                     m_thread;      ///< Network thread
+    std::atomic<bool>                          m_running;     ///< Is the network thread running?
+    std::atomic<bool>                          m_waiting;     ///< Is the network thread waiting for the sockets, or about to?
+    SpscQueue<Command>                         m_commands;    ///< Commands from the game thread
+    SpscQueue<Event>                           m_events;      ///< Events for the game thread
+    std::atomic<ConnectionId>                  m_nextId;      ///< Identifier of the next connection
+    std::size_t                                m_sendLimit;   ///< Size of the send queues above which connections are congested
+    Command                                    m_command;     ///< Command being built by the game thread
+    TcpListener                                m_listener;    ///< Listener accepting connections, if any
+    SocketSelector                             m_selector;    ///< Selector watching the sockets
+    Clock                                      m_clock;       ///< Clock measuring the connection timeouts
+    std::map<ConnectionId, Connection*>        m_connections; ///< Open connections, by identifier, only changed under m_mutex
+    std::map<const Socket*, Connection*>       m_sockets;     ///< Open connections, by socket
+    std::vector<Event>                         m_backlog;     ///< Events waiting for room in the queue
+    std::vector<Packet*>                       m_received;    ///< Packets received by the last read
+    Event                                      m_event;       ///< Event being built by the network thread
+    mutable std::map<ConnectionId, Statistics> m_statistics;  ///< Traffic of the connections returned by getStatistics
+    mutable Mutex                              m_mutex;       ///< Mutex protecting the list of connections read by getStatistics
+};
+
+} // namespace TGE
+
+
+#endif // TGE_NETWORKSERVICE_HPP
+
+
+////////////////////////////////////////////////////////////
+/// \class TGE::NetworkService
+/// \ingroup network
+///
+/// TGE::NetworkService moves all the socket work off the game
+/// thread. Its network thread owns a listener and any number
+/// of TCP connections, waits for them with a TGE::SocketSelector
+/// (epoll on Linux), and exchanges packets with the game thread
+/// through two bounded TGE::SpscQueue: commands one way
+/// (connect, send, disconnect) and events the other way
+/// (connected, received, disconnected). The game thread only
+/// pushes and pops in memory; the only system call it makes
+/// wakes the network thread up when a command arrives while it
+/// sleeps, waiting for the sockets.
+///
+/// The network thread sends the packets of a connection in
+/// batches, with as few system calls as possible, and keeps
+/// the ones the socket can't take yet in a per-connection
+/// queue. When that queue grows over the send limit, a
+/// Congested event tells the game to stop sending to that
+/// peer (a slow client, or one that stopped reading), and a
+/// Drained event tells it when it can resume. In the other
+/// direction, when the game doesn't poll the events fast
+/// enough, the network thread stops reading the sockets, which
+/// slows the peers down through TCP flow control.
+///
+/// The commands are picked up as soon as they are pushed, and
+/// the network thread doesn't wake up when there is nothing to
+/// do. All the functions except launch() and stop() must be
+/// called from a single thread, usually the game thread.
+///
+/// Usage example:
+/// \code
+/// TGE::NetworkService network;
+/// network.listen(55001);
+/// network.launch();
+///
+/// // In State::update
+/// TGE::NetworkService::Event event;
+/// while (network.pollEvent(event))
+/// {
+///     if (event.type == TGE::NetworkService::Event::Received)
+///         handlePacket(event.connection, event.packet);
+///     else if (event.type == TGE::NetworkService::Event::Congested)
+///         players[event.connection].throttled = true;
+///     else if (event.type == TGE::NetworkService::Event::Drained)
+///         players[event.connection].throttled = false;
+/// }
+///
+/// for (auto& player : players)
+/// {
+///     if (!player.second.throttled)
+///         network.send(player.first, snapshot);
+/// }
+/// \endcode
+///
+/// \see TGE::SocketSelector, TGE::SpscQueue
+///
+////////////////////////////////////////////////////////////
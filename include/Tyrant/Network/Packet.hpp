@@ -56,6 +56,19 @@ public :
     ////////////////////////////////////////////////////////////
     void append(const void* data, std::size_t sizeInBytes);
 
+    ////////////////////////////////////////////////////////////
+    /// \brief Reserve memory for the data of the packet
+    ///
+    /// Reserving the final size of a packet before filling it
+    /// avoids reallocating its data while it grows.
+    ///
+    /// \param sizeInBytes Number of bytes to reserve
+    ///
+    /// \see append
+    ///
+    ////////////////////////////////////////////////////////////
+    void reserve(std::size_t sizeInBytes);
+
     ////////////////////////////////////////////////////////////
     /// \brief Clear the packet
     ///
@@ -190,8 +203,10 @@ public:
 
 protected:
 
+    friend class LinkConditioner;
     friend class TcpSocket;
     friend class UdpSocket;
+    friend class UdpConnection;
 
     ////////////////////////////////////////////////////////////
     /// \brief Called before the packet is sent over the network
@@ -253,12 +268,52 @@ private :
     ////////////////////////////////////////////////////////////
     bool checkSize(std::size_t size);
 
+    ////////////////////////////////////////////////////////////
+    /// \brief Make the packet read data that it doesn't own
+    ///
+    /// The data is not copied, it must stay valid while it is
+    /// read. It is copied if something is appended to the packet.
+    ///
+    /// \param data Pointer to the data
+    /// \param size Number of bytes
+    ///
+    ////////////////////////////////////////////////////////////
+    void setView(const void* data, std::size_t size);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Get a pointer to the data at the reading position
+    ///
+    /// \return Pointer to the next byte to read
+    ///
+    ////////////////////////////////////////////////////////////
+    const char* getReadPointer() const;
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Take a copy of the data read without being owned
+    ///
+    /// This function is called before modifying the data.
+    ///
+    ////////////////////////////////////////////////////////////
+    void detachView();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Append a sequence of characters, as 32-bit integers
+    ///
+    /// \param begin Iterator to the first character
+    /// \param end   Iterator past the last character
+    ///
+    ////////////////////////////////////////////////////////////
+    template <typename Iterator>
+    void appendCharacters(Iterator begin, Iterator end);
+
     ////////////////////////////////////////////////////////////
     // Member data
     ////////////////////////////////////////////////////////////
-    std::vector<char> m_data;    ///< Data stored in the packet
-    std::size_t       m_readPos; ///< Current reading position in the packet
-    bool              m_isValid; ///< Reading state of the packet
+    std::vector<char> m_data;     ///< Data stored in the packet
+    const char*       m_view;     ///< Data read without being owned, NULL if the packet reads m_data
+    std::size_t       m_viewSize; ///< Size of the data read without being owned
+    std::size_t       m_readPos;  ///< Current reading position in the packet
+    bool              m_isValid;  ///< Reading state of the packet
 };
 
 } // namespace TGE
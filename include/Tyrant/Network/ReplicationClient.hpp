@@ -0,0 +1,157 @@
+/*************************************/
+/** Copyright © 2014 Coldsnap Games **/
+/*************************************/
+
+#ifndef TGE_REPLICATIONCLIENT_HPP
+#define TGE_REPLICATIONCLIENT_HPP
+
+/*************************************/
+/**             Headers             **/
+/*************************************/
+#include <Tyrant/Config.hpp>
+#include <Tyrant/Network/Snapshot.hpp>
+#include <Tyrant/System/NonCopyable.hpp>
+#include <vector>
+
+
+namespace TGE
+{
+class Packet;
+class ReplicationSchema;
+
+////////////////////////////////////////////////////////////
+/// \brief Rebuilds the snapshots sent by a ReplicationServer
+///        and buffers them for interpolation
+///
+////////////////////////////////////////////////////////////
+class TGE_API ReplicationClient : NonCopyable
+{
+public :
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Construct the client
+    ///
+    /// \param schema     Fields of the entities, must outlive the client
+    /// \param bufferSize Number of snapshots kept
+    ///
+    ////////////////////////////////////////////////////////////
+    explicit ReplicationClient(const ReplicationSchema& schema, std::size_t bufferSize = 64);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Read a delta written by the server
+    ///
+    /// The snapshot is rebuilt from the baseline it was computed
+    /// against, and added to the buffer.
+    ///
+    /// \param packet Packet containing the delta
+    /// \param offset Position of the delta in the packet, in bytes
+    ///
+    /// \return True if the snapshot was rebuilt, false if the
+    ///         delta is invalid or its baseline is no longer
+    ///         in the buffer
+    ///
+    ////////////////////////////////////////////////////////////
+    bool readDelta(const Packet& packet, std::size_t offset = 0);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Tell if a snapshot was received
+    ///
+    /// \return True if the buffer contains a snapshot
+    ///
+    ////////////////////////////////////////////////////////////
+    bool hasSnapshot() const;
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Get the tick of the latest snapshot received
+    ///
+    /// This is the tick to acknowledge to the server.
+    ///
+    /// \return Tick of the latest snapshot
+    ///
+    /// \see ReplicationServer::acknowledge
+    ///
+    ////////////////////////////////////////////////////////////
+    Uint32 getLatestTick() const;
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Get a snapshot of the buffer
+    ///
+    /// \param tick Tick of the snapshot
+    ///
+    /// \return Pointer to the snapshot, NULL if it's not in the buffer
+    ///
+    ////////////////////////////////////////////////////////////
+    const Snapshot* findSnapshot(Uint32 tick) const;
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Compute the state between two snapshots
+    ///
+    /// The float fields of the entities present in both
+    /// snapshots surrounding the tick are interpolated
+    /// linearly; the other fields, and the entities present
+    /// in one snapshot only, come from the older snapshot.
+    /// If no newer snapshot was received, the latest one is
+    /// returned as is.
+    ///
+    /// Games usually render slightly in the past, two or three
+    /// ticks behind the latest snapshot, so that a snapshot
+    /// lost now and then doesn't stop the interpolation.
+    ///
+    /// \param tick   Tick to compute the state at, with a fraction
+    /// \param result Snapshot to fill
+    ///
+    /// \return True if the state was computed, false if the
+    ///         buffer has no snapshot older than the tick
+    ///
+    ////////////////////////////////////////////////////////////
+    bool interpolate(double tick, Snapshot& result) const;
+
+private :
+
+    ////////////////////////////////////////////////////////////
+    // Member data
+    ////////////////////////////////////////////////////////////
+    std::vector<Snapshot> m_buffer;   ///< Snapshots received, indexed by tick modulo the size
+    std::vector<bool>     m_valid;    ///< Does each slot of the buffer hold a snapshot?
+    bool                  m_received; ///< Was a snapshot received?
+    Uint32                m_latest;   ///< Tick of the latest snapshot received
+    Snapshot              m_scratch;  ///< Snapshot being rebuilt
+};
+
+} // namespace TGE
+
+
+#endif // TGE_REPLICATIONCLIENT_HPP
+
+
+////////////////////////////////////////////////////////////
+/// \class TGE::ReplicationClient
+/// \ingroup network
+///
+/// TGE::ReplicationClient is the counterpart of
+/// TGE::ReplicationServer: it applies each delta to the
+/// snapshot it was computed against, and keeps the snapshots
+/// received so that the next deltas find their baseline and
+/// the game can interpolate between them.
+///
+/// After each delta read, the client must send the latest
+/// tick back to the server, which then computes the next
+/// deltas against it.
+///
+/// Usage example:
+/// \code
+/// TGE::Packet packet;
+/// while (connection.receive(packet) == TGE::Socket::Done)
+/// {
+///     if (client.readDelta(packet))
+///         ack << client.getLatestTick();
+/// }
+///
+/// TGE::Snapshot state(schema);
+/// if (client.interpolate(renderTick, state))
+///     draw(state);
+/// \endcode
+///
+/// \see TGE::ReplicationServer, TGE::Snapshot
+///
+////////////////////////////////////////////////////////////
@@ -0,0 +1,202 @@
+/*************************************/
+/** Copyright © 2014 Coldsnap Games **/
+/*************************************/
+
+#ifndef TGE_REPLICATIONSCHEMA_HPP
+#define TGE_REPLICATIONSCHEMA_HPP
+
+/*************************************/
+/**             Headers             **/
+/*************************************/
+#include <Tyrant/Config.hpp>
+#include <vector>
+
+
+namespace TGE
+{
+////////////////////////////////////////////////////////////
+/// \brief Describes the replicated fields of the entities
+///
+////////////////////////////////////////////////////////////
+class TGE_API ReplicationSchema
+{
+public :
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Types of fields
+    ///
+    ////////////////////////////////////////////////////////////
+    enum FieldType
+    {
+        Integer, ///< Integer in a range
+        Float,   ///< Float in a range, quantized
+        Boolean  ///< Boolean
+    };
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Default constructor
+    ///
+    /// Creates a schema without fields.
+    ///
+    ////////////////////////////////////////////////////////////
+    ReplicationSchema();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Add an integer field
+    ///
+    /// \param min Minimum value of the field
+    /// \param max Maximum value of the field
+    ///
+    /// \return Index of the field
+    ///
+    ////////////////////////////////////////////////////////////
+    std::size_t addInteger(Int32 min, Int32 max);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Add a float field
+    ///
+    /// The range is split into 2^bitCount steps, the values
+    /// are rounded to the nearest one.
+    ///
+    /// \param min      Minimum value of the field
+    /// \param max      Maximum value of the field
+    /// \param bitCount Number of bits of the field, between 1 and 32
+    ///
+    /// \return Index of the field
+    ///
+    ////////////////////////////////////////////////////////////
+    std::size_t addFloat(float min, float max, unsigned int bitCount);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Add a boolean field
+    ///
+    /// \return Index of the field
+    ///
+    ////////////////////////////////////////////////////////////
+    std::size_t addBool();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Get the number of fields
+    ///
+    /// \return Number of fields of each entity
+    ///
+    ////////////////////////////////////////////////////////////
+    std::size_t getFieldCount() const;
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Get the type of a field
+    ///
+    /// \param field Index of the field
+    ///
+    /// \return Type of the field
+    ///
+    ////////////////////////////////////////////////////////////
+    FieldType getFieldType(std::size_t field) const;
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Get the number of bits of a field
+    ///
+    /// \param field Index of the field
+    ///
+    /// \return Number of bits used to send the field
+    ///
+    ////////////////////////////////////////////////////////////
+    unsigned int getBitCount(std::size_t field) const;
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Convert an integer to the value stored for a field
+    ///
+    /// \param field Index of the field
+    /// \param value Value to convert, clamped to the range of the field
+    ///
+    /// \return Value stored
+    ///
+    ////////////////////////////////////////////////////////////
+    Uint32 encodeInteger(std::size_t field, Int32 value) const;
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Convert the value stored for a field to an integer
+    ///
+    /// \param field Index of the field
+    /// \param value Value stored
+    ///
+    /// \return Integer value
+    ///
+    ////////////////////////////////////////////////////////////
+    Int32 decodeInteger(std::size_t field, Uint32 value) const;
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Convert a float to the value stored for a field
+    ///
+    /// \param field Index of the field
+    /// \param value Value to convert, clamped to the range of the field
+    ///
+    /// \return Value stored
+    ///
+    ////////////////////////////////////////////////////////////
+    Uint32 encodeFloat(std::size_t field, float value) const;
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Convert the value stored for a field to a float
+    ///
+    /// \param field Index of the field
+    /// \param value Value stored
+    ///
+    /// \return Float value
+    ///
+    ////////////////////////////////////////////////////////////
+    float decodeFloat(std::size_t field, Uint32 value) const;
+
+private :
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Description of a field
+    ///
+    ////////////////////////////////////////////////////////////
+    struct Field
+    {
+        FieldType    type;       ///< Type of the field
+        Int32        minInteger; ///< Minimum value of an integer field
+        Int32        maxInteger; ///< Maximum value of an integer field
+        float        minFloat;   ///< Minimum value of a float field
+        float        maxFloat;   ///< Maximum value of a float field
+        unsigned int bitCount;   ///< Number of bits of the field
+    };
+
+    ////////////////////////////////////////////////////////////
+    // Member data
+    ////////////////////////////////////////////////////////////
+    std::vector<Field> m_fields; ///< Fields of the entities
+};
+
+} // namespace TGE
+
+
+#endif // TGE_REPLICATIONSCHEMA_HPP
+
+
+////////////////////////////////////////////////////////////
+/// \class TGE::ReplicationSchema
+/// \ingroup network
+///
+/// TGE::ReplicationSchema lists the fields that the server
+/// replicates for each entity, with their range. The server
+/// and the clients must build the same schema, by adding the
+/// same fields in the same order.
+///
+/// The values of the fields are stored quantized, as they are
+/// sent: what the client receives is exactly what the server
+/// compared to detect the changes.
+///
+/// Usage example:
+/// \code
+/// TGE::ReplicationSchema schema;
+/// std::size_t positionX = schema.addFloat(-1024.f, 1024.f, 18);
+/// std::size_t positionY = schema.addFloat(-1024.f, 1024.f, 18);
+/// std::size_t health    = schema.addInteger(0, 100);
+/// std::size_t firing    = schema.addBool();
+/// \endcode
+///
+/// \see TGE::Snapshot, TGE::ReplicationServer, TGE::ReplicationClient
+///
+////////////////////////////////////////////////////////////
@@ -0,0 +1,199 @@
+/*************************************/
+/** Copyright © 2014 Coldsnap Games **/
+/*************************************/
+
+#ifndef TGE_REPLICATIONSERVER_HPP
+#define TGE_REPLICATIONSERVER_HPP
+
+/*************************************/
+/**             Headers             **/
+/*************************************/
+#include <Tyrant/Config.hpp>
+#include <Tyrant/Network/Snapshot.hpp>
+#include <Tyrant/System/Clock.hpp>
+#include <Tyrant/System/NonCopyable.hpp>
+#include <deque>
+#include <utility>
+#include <vector>
+
+
+namespace TGE
+{
+class Packet;
+class ReplicationSchema;
+
+////////////////////////////////////////////////////////////
+/// \brief Sends the snapshots to the clients, as deltas from
+///        what each client acknowledged
+///
+////////////////////////////////////////////////////////////
+class TGE_API ReplicationServer : NonCopyable
+{
+public :
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Construct the server
+    ///
+    /// \param schema      Fields of the entities, must outlive the server
+    /// \param historySize Number of snapshots kept as baselines
+    ///
+    ////////////////////////////////////////////////////////////
+    explicit ReplicationServer(const ReplicationSchema& schema, std::size_t historySize = 64);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Add the snapshot of a new tick
+    ///
+    /// The snapshot is copied. Its tick must be greater than the
+    /// tick of the previous one.
+    ///
+    /// \param snapshot Snapshot to add
+    ///
+    ////////////////////////////////////////////////////////////
+    void addSnapshot(const Snapshot& snapshot);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Add a client
+    ///
+    /// The client gets full snapshots until it acknowledges one.
+    ///
+    /// \return Identifier of the client
+    ///
+    ////////////////////////////////////////////////////////////
+    std::size_t addClient();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Remove a client
+    ///
+    /// Its identifier may be given to a later client.
+    ///
+    /// \param client Identifier of the client
+    ///
+    ////////////////////////////////////////////////////////////
+    void removeClient(std::size_t client);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Tell the server that a client received a snapshot
+    ///
+    /// Acknowledgements older than the last one are ignored,
+    /// they may arrive out of order.
+    ///
+    /// \param client Identifier of the client
+    /// \param tick   Tick of the snapshot received
+    ///
+    /// \see ReplicationClient::getLatestTick
+    ///
+    ////////////////////////////////////////////////////////////
+    void acknowledge(std::size_t client, Uint32 tick);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Write the latest snapshot for a client
+    ///
+    /// Only the entities and fields which changed since the
+    /// last snapshot acknowledged by the client are written. If
+    /// that snapshot is no longer in the history, or the client
+    /// never acknowledged one, the full snapshot is written.
+    ///
+    /// The delta is appended to the packet.
+    ///
+    /// \param client Identifier of the client
+    /// \param packet Packet to write to
+    ///
+    /// \return True if a delta was written, false if no snapshot
+    ///         was added yet
+    ///
+    ////////////////////////////////////////////////////////////
+    bool writeDelta(std::size_t client, Packet& packet);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Get the bandwidth used by a client
+    ///
+    /// \param client Identifier of the client
+    ///
+    /// \return Number of bytes written for the client in the
+    ///         last second
+    ///
+    ////////////////////////////////////////////////////////////
+    std::size_t getBytesPerSecond(std::size_t client) const;
+
+private :
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Replication state of a client
+    ///
+    ////////////////////////////////////////////////////////////
+    struct Client
+    {
+        Client();
+
+        bool                                       connected;    ///< Is the slot used?
+        bool                                       acknowledged; ///< Did the client acknowledge a snapshot?
+        Uint32                                     ackedTick;    ///< Tick of the last snapshot acknowledged
+        std::deque<std::pair<Int64, std::size_t> > sent;         ///< Time and size of the deltas of the last second
+    };
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Find a snapshot in the history
+    ///
+    /// \param tick Tick of the snapshot
+    ///
+    /// \return Pointer to the snapshot, NULL if it's not in the history
+    ///
+    ////////////////////////////////////////////////////////////
+    const Snapshot* findSnapshot(Uint32 tick) const;
+
+    ////////////////////////////////////////////////////////////
+    // Member data
+    ////////////////////////////////////////////////////////////
+    std::vector<Snapshot>    m_history;   ///< Last snapshots, indexed by tick modulo the size
+    bool                     m_hasLatest; ///< Was a snapshot added?
+    Uint32                   m_latest;    ///< Tick of the last snapshot added
+    std::vector<Client>      m_clients;   ///< Clients, indexed by identifier
+    std::vector<std::size_t> m_changed;   ///< Entities written in the current delta
+    std::vector<std::size_t> m_matching;  ///< Index in the baseline of the entities written
+    std::vector<Uint16>      m_removed;   ///< Entities removed since the baseline
+    Clock                    m_clock;     ///< Clock measuring the bandwidth
+};
+
+} // namespace TGE
+
+
+#endif // TGE_REPLICATIONSERVER_HPP
+
+
+////////////////////////////////////////////////////////////
+/// \class TGE::ReplicationServer
+/// \ingroup network
+///
+/// Sending the full state of the world to every client on
+/// every tick wastes most of the bandwidth: between two ticks
+/// few entities change, and those which do usually change a
+/// few fields. TGE::ReplicationServer keeps the last snapshots
+/// and, for each client, the last one the client acknowledged.
+/// It writes only what changed since that baseline: entities
+/// added or removed, and for the other ones the fields whose
+/// value differs, each with the bits given by the schema.
+///
+/// The deltas must be sent over an unreliable channel: a lost
+/// delta is never resent, the next one is simply computed
+/// against the same baseline until the client acknowledges a
+/// newer snapshot. The client sends back the tick of the last
+/// snapshot it received, with its inputs for instance.
+///
+/// Usage example:
+/// \code
+/// // On every tick
+/// server.addSnapshot(snapshot);
+/// for (std::size_t i = 0; i < clients.size(); ++i)
+/// {
+///     TGE::Packet packet;
+///     server.writeDelta(clients[i].id, packet);
+///     clients[i].connection.send(packet, TGE::UdpConnection::Unreliable);
+/// }
+///
+/// // When a client sends its acknowledgement
+/// server.acknowledge(client.id, tick);
+/// \endcode
+///
+/// \see TGE::ReplicationClient, TGE::Snapshot
+///
+////////////////////////////////////////////////////////////
@@ -0,0 +1,281 @@
+/*************************************/
+/** Copyright © 2014 Coldsnap Games **/
+/*************************************/
+
+#ifndef TGE_RESOLVER_HPP
+#define TGE_RESOLVER_HPP
+
+/*************************************/
+/**             Headers             **/
+/*************************************/
+#include <Tyrant/Config.hpp>
+#include <Tyrant/Network/IpAddress.hpp>
+#include <Tyrant/System/Clock.hpp>
+#include <Tyrant/System/ConditionVariable.hpp>
+#include <Tyrant/System/Mutex.hpp>
+#include <Tyrant/System/NonCopyable.hpp>
+#include <Tyrant/System/Time.hpp>
+#include <deque>
+#include <functional>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+namespace TGE
+{
+class Thread;
+
+////////////////////////////////////////////////////////////
+/// \brief Resolves host names in the background, with a cache
+///
+////////////////////////////////////////////////////////////
+class TGE_API Resolver : NonCopyable
+{
+public :
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Function receiving the result of a resolution
+    ///
+    /// The name is given in lower case, and the address is
+    /// IpAddress::None if the name could not be resolved.
+    ///
+    ////////////////////////////////////////////////////////////
+    typedef std::function<void (const std::string& name, const IpAddress& address)> Callback;
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Construct the resolver
+    ///
+    /// The worker threads are started by the first resolution
+    /// that needs them.
+    ///
+    /// \param workerCount Number of names resolved at once, at
+    ///                    least 1
+    ///
+    ////////////////////////////////////////////////////////////
+    explicit Resolver(unsigned int workerCount = 2);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Destructor
+    ///
+    /// The resolutions not started are abandoned, without
+    /// calling their callbacks. The system can't interrupt a
+    /// resolution in progress, so the destructor waits for them.
+    ///
+    ////////////////////////////////////////////////////////////
+    ~Resolver();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Set how long the results are kept in the cache
+    ///
+    /// The system resolver doesn't tell the time to live of the
+    /// DNS records, so the resolver uses these durations. The
+    /// defaults are 5 minutes for the names resolved, and 10
+    /// seconds for the failures.
+    ///
+    /// \param resolved Time to live of the names resolved
+    /// \param failed   Time to live of the failures
+    ///
+    ////////////////////////////////////////////////////////////
+    void setTimeToLive(Time resolved, Time failed);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Enable or disable the system resolver
+    ///
+    /// When disabled, the names which are not hosts of the
+    /// resolver fail without any network access, which is what
+    /// tests usually want. It is enabled by default.
+    ///
+    /// \param enabled True to resolve the unknown names with the
+    ///                system resolver
+    ///
+    ////////////////////////////////////////////////////////////
+    void setSystemLookup(bool enabled);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Add a host, which always resolves to an address
+    ///
+    /// The hosts take precedence over the system resolver and
+    /// never expire.
+    ///
+    /// \param name    Host name, case insensitive
+    /// \param address Address of the host
+    ///
+    ////////////////////////////////////////////////////////////
+    void addHost(const std::string& name, const IpAddress& address);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Add the hosts of a file in the hosts format
+    ///
+    /// Each line holds an address and its names, separated by
+    /// spaces, like /etc/hosts; '#' starts a comment. The lines
+    /// with an address other than IPv4 are ignored.
+    ///
+    /// \param filename Path of the file to load
+    ///
+    /// \return True if the file was loaded
+    ///
+    ////////////////////////////////////////////////////////////
+    bool loadHostsFile(const std::string& filename);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Resolve a host name in the background
+    ///
+    /// If the answer is already known, a host, an address in
+    /// the "xxx.xxx.xxx.xxx" form, or a name of the cache, the
+    /// callback is called right away. Otherwise it is called by
+    /// a later update, once a worker resolved the name; several
+    /// requests of the same name share a single resolution.
+    ///
+    /// \param name     Host name or address to resolve
+    /// \param callback Function receiving the result
+    ///
+    /// \see update
+    ///
+    ////////////////////////////////////////////////////////////
+    void resolve(const std::string& name, const Callback& callback);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Get the address of a host name, if it is known
+    ///
+    /// This function never waits for the network.
+    ///
+    /// \param name    Host name or address to look up
+    /// \param address Address filled with the answer
+    ///
+    /// \return True if the answer is known, false if the name
+    ///         must be resolved first
+    ///
+    ////////////////////////////////////////////////////////////
+    bool lookup(const std::string& name, IpAddress& address);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Call the callbacks of the resolutions finished
+    ///
+    /// The callbacks are called by the thread calling this
+    /// function, typically the game thread, once per frame.
+    ///
+    ////////////////////////////////////////////////////////////
+    void update();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Remove all the names from the cache
+    ///
+    /// The hosts and the resolutions in progress are kept.
+    ///
+    ////////////////////////////////////////////////////////////
+    void clearCache();
+
+private :
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Name of the cache
+    ///
+    ////////////////////////////////////////////////////////////
+    struct Entry
+    {
+        IpAddress             address;   ///< Address of the name, None if it failed
+        Int64                 expiry;    ///< Time at which the entry expires, in microseconds
+        bool                  pending;   ///< Is the name being resolved?
+        std::vector<Callback> callbacks; ///< Callbacks waiting for the resolution
+    };
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Resolution finished, waiting for the next update
+    ///
+    ////////////////////////////////////////////////////////////
+    struct Result
+    {
+        std::string           name;      ///< Name resolved
+        IpAddress             address;   ///< Address of the name, None if it failed
+        std::vector<Callback> callbacks; ///< Callbacks to call
+    };
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Find the answer of a name without resolving it
+    ///
+    /// The mutex must be locked.
+    ///
+    /// \param name    Name to look up, in lower case
+    /// \param address Address filled with the answer
+    ///
+    /// \return True if the answer is known
+    ///
+    ////////////////////////////////////////////////////////////
+    bool findAddress(const std::string& name, IpAddress& address);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Resolve the names of the queue until the resolver
+    ///        is destroyed, run by the worker threads
+    ///
+    ////////////////////////////////////////////////////////////
+    void resolveNames();
+
+    ////////////////////////////////////////////////////////////
+    // Member data
+    ////////////////////////////////////////////////////////////
+    unsigned int                     m_workerCount; ///< Maximum number of worker threads
+    std::vector<Thread*>             m_workers;     ///< Worker threads, started on demand
+    unsigned int                     m_idle;        ///< Number of workers waiting for a name
+    bool                             m_running;     ///< False when the workers must exit
+    Int64                            m_resolvedTtl; ///< Time to live of the names resolved, in microseconds
+    Int64                            m_failedTtl;   ///< Time to live of the failures, in microseconds
+    bool                             m_system;      ///< Are the unknown names resolved by the system?
+    std::map<std::string, IpAddress> m_hosts;       ///< Names which always resolve, in lower case
+    std::map<std::string, Entry>     m_cache;       ///< Names resolved or being resolved, in lower case
+    std::deque<std::string>          m_queue;       ///< Names waiting for a worker
+    std::vector<Result>              m_results;     ///< Resolutions finished since the last update
+    Int64                            m_lastPurge;   ///< Time at which the expired names were last removed
+    Clock                            m_clock;       ///< Clock giving the current time
+    Mutex                            m_mutex;       ///< Mutex protecting the state shared with the workers
+    ConditionVariable                m_wakeUp;      ///< Notified when a name is queued, or at destruction
+};
+
+} // namespace TGE
+
+
+#endif // TGE_RESOLVER_HPP
+
+
+////////////////////////////////////////////////////////////
+/// \class TGE::Resolver
+/// \ingroup network
+///
+/// Building a TGE::IpAddress from a host name asks the system
+/// resolver and blocks until it answers, which can take seconds
+/// when the DNS server is slow or unreachable. TGE::Resolver
+/// does the same lookups on worker threads, and gives the
+/// answers to callbacks called by update(), on the thread of
+/// the caller.
+///
+/// The answers are kept in a cache: the names resolved for a
+/// few minutes, and the failures for a few seconds, so that a
+/// name which doesn't exist isn't asked again every frame.
+/// Requests for a name already being resolved wait for the
+/// same lookup, instead of starting another one.
+///
+/// Hosts can be added by hand or from a file in the
+/// /etc/hosts format; they are answered without the system.
+/// With the system lookup disabled, a test can run against a
+/// hosts file without any network access.
+///
+/// Usage example:
+/// \code
+/// TGE::Resolver resolver;
+///
+/// resolver.resolve("game.example.com", [&](const std::string& name, const TGE::IpAddress& address)
+/// {
+///     if (address == TGE::IpAddress::None)
+///         showError("Cannot find " + name);
+///     else
+///         service.connect(address, 55001);
+/// });
+///
+/// // Every frame
+/// resolver.update();
+/// \endcode
+///
+/// \see TGE::IpAddress
+///
+////////////////////////////////////////////////////////////
@@ -0,0 +1,263 @@
+/*************************************/
+/** Copyright © 2014 Coldsnap Games **/
+/*************************************/
+
+#ifndef TGE_SNAPSHOT_HPP
+#define TGE_SNAPSHOT_HPP
+
+/*************************************/
+/**             Headers             **/
+/*************************************/
+#include <Tyrant/Config.hpp>
+#include <vector>
+
+
+namespace TGE
+{
+class ReplicationSchema;
+
+////////////////////////////////////////////////////////////
+/// \brief State of the replicated entities at a given tick
+///
+////////////////////////////////////////////////////////////
+class TGE_API Snapshot
+{
+public :
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Construct an empty snapshot
+    ///
+    /// \param schema Fields of the entities, must outlive the snapshot
+    ///
+    ////////////////////////////////////////////////////////////
+    explicit Snapshot(const ReplicationSchema& schema);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Get the schema of the snapshot
+    ///
+    /// \return Fields of the entities
+    ///
+    ////////////////////////////////////////////////////////////
+    const ReplicationSchema& getSchema() const;
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Set the tick of the snapshot
+    ///
+    /// \param tick Simulation tick the snapshot was taken at
+    ///
+    ////////////////////////////////////////////////////////////
+    void setTick(Uint32 tick);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Get the tick of the snapshot
+    ///
+    /// \return Simulation tick the snapshot was taken at
+    ///
+    ////////////////////////////////////////////////////////////
+    Uint32 getTick() const;
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Remove all the entities
+    ///
+    ////////////////////////////////////////////////////////////
+    void clear();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Add an entity
+    ///
+    /// The fields of a new entity are at the minimum of their
+    /// range. Nothing happens if the entity already exists.
+    ///
+    /// \param entity Identifier of the entity
+    ///
+    ////////////////////////////////////////////////////////////
+    void addEntity(Uint16 entity);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Remove an entity
+    ///
+    /// \param entity Identifier of the entity
+    ///
+    ////////////////////////////////////////////////////////////
+    void removeEntity(Uint16 entity);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Tell if an entity exists
+    ///
+    /// \param entity Identifier of the entity
+    ///
+    /// \return True if the snapshot contains the entity
+    ///
+    ////////////////////////////////////////////////////////////
+    bool hasEntity(Uint16 entity) const;
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Get the number of entities
+    ///
+    /// \return Number of entities in the snapshot
+    ///
+    ////////////////////////////////////////////////////////////
+    std::size_t getEntityCount() const;
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Get the identifier of an entity
+    ///
+    /// The entities are sorted by identifier.
+    ///
+    /// \param index Index of the entity, below getEntityCount()
+    ///
+    /// \return Identifier of the entity
+    ///
+    ////////////////////////////////////////////////////////////
+    Uint16 getEntityId(std::size_t index) const;
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Set the value of an integer field
+    ///
+    /// The entity is added if it doesn't exist.
+    ///
+    /// \param entity Identifier of the entity
+    /// \param field  Index of the field in the schema
+    /// \param value  New value of the field
+    ///
+    ////////////////////////////////////////////////////////////
+    void setInteger(Uint16 entity, std::size_t field, Int32 value);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Get the value of an integer field
+    ///
+    /// \param entity Identifier of the entity
+    /// \param field  Index of the field in the schema
+    ///
+    /// \return Value of the field, 0 if the entity doesn't exist
+    ///
+    ////////////////////////////////////////////////////////////
+    Int32 getInteger(Uint16 entity, std::size_t field) const;
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Set the value of a float field
+    ///
+    /// The entity is added if it doesn't exist.
+    ///
+    /// \param entity Identifier of the entity
+    /// \param field  Index of the field in the schema
+    /// \param value  New value of the field
+    ///
+    ////////////////////////////////////////////////////////////
+    void setFloat(Uint16 entity, std::size_t field, float value);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Get the value of a float field
+    ///
+    /// \param entity Identifier of the entity
+    /// \param field  Index of the field in the schema
+    ///
+    /// \return Value of the field, as quantized by the schema,
+    ///         0 if the entity doesn't exist
+    ///
+    ////////////////////////////////////////////////////////////
+    float getFloat(Uint16 entity, std::size_t field) const;
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Set the value of a boolean field
+    ///
+    /// The entity is added if it doesn't exist.
+    ///
+    /// \param entity Identifier of the entity
+    /// \param field  Index of the field in the schema
+    /// \param value  New value of the field
+    ///
+    ////////////////////////////////////////////////////////////
+    void setBool(Uint16 entity, std::size_t field, bool value);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Get the value of a boolean field
+    ///
+    /// \param entity Identifier of the entity
+    /// \param field  Index of the field in the schema
+    ///
+    /// \return Value of the field, false if the entity doesn't exist
+    ///
+    ////////////////////////////////////////////////////////////
+    bool getBool(Uint16 entity, std::size_t field) const;
+
+private :
+
+    friend class ReplicationServer;
+    friend class ReplicationClient;
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Find the index of an entity
+    ///
+    /// \param entity Identifier of the entity
+    ///
+    /// \return Index of the entity, getEntityCount() if it doesn't exist
+    ///
+    ////////////////////////////////////////////////////////////
+    std::size_t findEntity(Uint16 entity) const;
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Get the values of an entity, adding it if needed
+    ///
+    /// \param entity Identifier of the entity
+    ///
+    /// \return Pointer to the values of the fields of the entity
+    ///
+    ////////////////////////////////////////////////////////////
+    Uint32* getValues(Uint16 entity);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Get the values of an entity by index
+    ///
+    /// \param index Index of the entity, below getEntityCount()
+    ///
+    /// \return Pointer to the values of the fields of the entity
+    ///
+    ////////////////////////////////////////////////////////////
+    const Uint32* getValuesAt(std::size_t index) const;
+
+    ////////////////////////////////////////////////////////////
+    // Member data
+    ////////////////////////////////////////////////////////////
+    const ReplicationSchema* m_schema;     ///< Fields of the entities
+    std::size_t              m_fieldCount; ///< Number of fields of each entity
+    Uint32                   m_tick;       ///< Simulation tick of the snapshot
+    std::vector<Uint16>      m_entities;   ///< Identifiers of the entities, sorted
+    std::vector<Uint32>      m_values;     ///< Values of the fields, entity after entity
+};
+
+} // namespace TGE
+
+
+#endif // TGE_SNAPSHOT_HPP
+
+
+////////////////////////////////////////////////////////////
+/// \class TGE::Snapshot
+/// \ingroup network
+///
+/// TGE::Snapshot holds the replicated fields of all the
+/// entities at a simulation tick. The server fills one every
+/// tick and gives it to its TGE::ReplicationServer; the clients
+/// get them back from TGE::ReplicationClient.
+///
+/// The values are stored quantized, as described by the
+/// schema, in a single array: copying a snapshot into another
+/// one of the same size doesn't allocate memory.
+///
+/// Usage example:
+/// \code
+/// TGE::Snapshot snapshot(schema);
+/// snapshot.setTick(tick);
+/// for (std::size_t i = 0; i < entities.size(); ++i)
+/// {
+///     snapshot.setFloat(entities[i].id, positionX, entities[i].position.x);
+///     snapshot.setFloat(entities[i].id, positionY, entities[i].position.y);
+///     snapshot.setInteger(entities[i].id, health, entities[i].health);
+/// }
+/// server.addSnapshot(snapshot);
+/// \endcode
+///
+/// \see TGE::ReplicationSchema, TGE::ReplicationServer, TGE::ReplicationClient
+///
+////////////////////////////////////////////////////////////
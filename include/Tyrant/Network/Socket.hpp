@@ -34,6 +34,7 @@ public :
     {
         Done,         ///< The socket has sent / received the data
         NotReady,     ///< The socket is not ready to send / receive data yet
+        Partial,      ///< The socket sent a part of the data, the rest must be sent again
         Disconnected, ///< The TCP socket has been disconnected
         Error         ///< An unexpected error happened
     };
@@ -10,6 +10,7 @@
 /*************************************/
 #include <Tyrant/Config.hpp>
 #include <Tyrant/System/Time.hpp>
+#include <cstddef>
 
 
 namespace TGE
@@ -24,11 +25,33 @@ class TGE_API SocketSelector
 {
 public :
 
+    ////////////////////////////////////////////////////////////
+    /// \brief Kinds of readiness that can be watched
+    ///
+    ////////////////////////////////////////////////////////////
+    enum Readiness
+    {
+        Read  = 1 << 0, ///< Data can be received, or a connection accepted
+        Write = 1 << 1  ///< Data can be sent without blocking
+    };
+
+    ////////////////////////////////////////////////////////////
+    /// \brief When sockets are reported as ready
+    ///
+    ////////////////////////////////////////////////////////////
+    enum Trigger
+    {
+        LevelTriggered, ///< Reported by every wait() while they are ready
+        EdgeTriggered   ///< Reported once each time they become ready (epoll only)
+    };
+
     ////////////////////////////////////////////////////////////
     /// \brief Default constructor
     ///
+    /// \param trigger When sockets are reported as ready
+    ///
     ////////////////////////////////////////////////////////////
-    SocketSelector();
+    explicit SocketSelector(Trigger trigger = LevelTriggered);
 
     ////////////////////////////////////////////////////////////
     /// \brief Copy constructor
@@ -51,13 +74,16 @@ public :
     /// so you have to make sure that the socket is not destroyed
     /// while it is stored in the selector.
     /// This function does nothing if the socket is not valid.
+    /// Adding a socket that is already in the selector changes
+    /// the readiness that is watched.
     ///
-    /// \param socket Reference to the socket to add
+    /// \param socket    Reference to the socket to add
+    /// \param readiness Combination of Readiness flags to watch
     ///
     /// \see remove, clear
     ///
     ////////////////////////////////////////////////////////////
-    void add(Socket& socket);
+    void add(Socket& socket, unsigned int readiness = Read);
 
     ////////////////////////////////////////////////////////////
     /// \brief Remove a socket from the selector
@@ -86,22 +112,39 @@ public :
 
     ////////////////////////////////////////////////////////////
     /// \brief Wait until one or more sockets are ready to receive
+    ///        or send
     ///
     /// This function returns as soon as at least one socket has
-    /// some data available to be received. To know which sockets are
-    /// ready, use the isReady function.
+    /// some data available to be received, or can send data if
+    /// it is watched for writing. To know which sockets are
+    /// ready, use getReadyCount and getReadySocket, or the
+    /// isReady function.
     /// If you use a timeout and no socket is ready before the timeout
-    /// is over, the function returns false.
+    /// is over, the function returns false. It also returns false
+    /// when another thread interrupts the wait.
     ///
     /// \param timeout Maximum time to wait, (use Time::Zero for infinity)
     ///
     /// \return True if there are sockets ready, false otherwise
     ///
-    /// \see isReady
+    /// \see isReady, interrupt
     ///
     ////////////////////////////////////////////////////////////
     bool wait(Time timeout = Time::Zero);
 
+    ////////////////////////////////////////////////////////////
+    /// \brief Make the current or next call to wait return
+    ///
+    /// This function can be called from any thread, while
+    /// another one waits: the wait returns false right away,
+    /// unless sockets are ready too. If no thread is waiting,
+    /// the next call to wait returns at once.
+    ///
+    /// \see wait
+    ///
+    ////////////////////////////////////////////////////////////
+    void interrupt();
+
     ////////////////////////////////////////////////////////////
     /// \brief Test a socket to know if it is ready to receive data
     ///
@@ -116,11 +159,68 @@ public :
     ///
     /// \return True if the socket is ready to read, false otherwise
     ///
-    /// \see isReady
+    /// \see isReadyToWrite
     ///
     ////////////////////////////////////////////////////////////
     bool isReady(Socket& socket) const;
 
+    ////////////////////////////////////////////////////////////
+    /// \brief Test a socket to know if it is ready to send data
+    ///
+    /// This function must be used after a call to wait, and only
+    /// works for sockets watched for writing.
+    ///
+    /// \param socket Socket to test
+    ///
+    /// \return True if the socket is ready to write, false otherwise
+    ///
+    /// \see isReady
+    ///
+    ////////////////////////////////////////////////////////////
+    bool isReadyToWrite(Socket& socket) const;
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Get the number of sockets found ready by the last
+    ///        call to wait
+    ///
+    /// \return Number of ready sockets
+    ///
+    /// \see getReadySocket, getReadiness
+    ///
+    ////////////////////////////////////////////////////////////
+    std::size_t getReadyCount() const;
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Get one of the sockets found ready by the last
+    ///        call to wait
+    ///
+    /// Iterating over the ready sockets avoids testing all the
+    /// sockets of the selector with isReady. The list doesn't
+    /// change until the next call to wait, even if sockets are
+    /// removed from the selector meanwhile.
+    ///
+    /// \param index Index of the socket, in [0, getReadyCount()[
+    ///
+    /// \return Ready socket
+    ///
+    /// \see getReadyCount, getReadiness
+    ///
+    ////////////////////////////////////////////////////////////
+    Socket& getReadySocket(std::size_t index) const;
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Get how one of the sockets found ready by the last
+    ///        call to wait is ready
+    ///
+    /// \param index Index of the socket, in [0, getReadyCount()[
+    ///
+    /// \return Combination of Readiness flags
+    ///
+    /// \see getReadyCount, getReadySocket
+    ///
+    ////////////////////////////////////////////////////////////
+    unsigned int getReadiness(std::size_t index) const;
+
     ////////////////////////////////////////////////////////////
     /// \brief Overload of assignment operator
     ///
@@ -176,6 +276,28 @@ private :
 /// \li make it wait until there is data available on any of the sockets
 /// \li test each socket to find out which ones are ready
 ///
+/// On Linux, selectors are built on epoll: waiting costs the
+/// same whatever the number of sockets, and there is no limit
+/// on the number of sockets. Servers with many connections
+/// should iterate over the ready sockets with getReadyCount()
+/// and getReadySocket() rather than call isReady() on every
+/// socket. Elsewhere, selectors use select(), which is limited
+/// to FD_SETSIZE sockets.
+///
+/// Sockets can also be watched for writing (add(socket,
+/// TGE::SocketSelector::Read | TGE::SocketSelector::Write)),
+/// to know when a non-blocking socket can send again.
+///
+/// With epoll, a selector can be edge-triggered: a socket is
+/// then only reported when it becomes ready, so it must be read
+/// (or written) until it returns TGE::Socket::NotReady. This
+/// saves reporting the same busy sockets on every wait. Other
+/// systems ignore the trigger and are always level-triggered.
+///
+/// A thread waiting on a selector can be woken up by another
+/// one with interrupt(), for example to give it new work
+/// without waiting for a timeout.
+///
 /// Usage example:
 /// \code
 /// // Create a socket to listen to new connections
@@ -238,6 +360,21 @@ private :
 /// }
 /// \endcode
 ///
+/// The same loop, iterating over the ready sockets only:
+/// \code
+/// if (selector.wait())
+/// {
+///     for (std::size_t i = 0; i < selector.getReadyCount(); ++i)
+///     {
+///         TGE::Socket& socket = selector.getReadySocket(i);
+///         if (&socket == &listener)
+///             acceptClient();
+///         else
+///             receiveFrom(static_cast<TGE::TcpSocket&>(socket));
+///     }
+/// }
+/// \endcode
+///
 /// \see TGE::Socket
 ///
 ////////////////////////////////////////////////////////////
@@ -50,6 +50,9 @@ public :
     /// port, waiting for new connections.
     /// If the socket was previously listening to another port,
     /// it will be stopped first and bound to the new port.
+    /// On Unix, the port can be listened to again right after
+    /// a previous listener closed, even if some of the
+    /// connections it accepted are still waiting to expire.
     ///
     /// \param port Port to listen for new connections
     ///
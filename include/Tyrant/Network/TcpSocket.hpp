@@ -33,6 +33,12 @@ public :
     ////////////////////////////////////////////////////////////
     TcpSocket();
 
+    ////////////////////////////////////////////////////////////
+    /// \brief Destructor
+    ///
+    ////////////////////////////////////////////////////////////
+    ~TcpSocket();
+
     ////////////////////////////////////////////////////////////
     /// \brief Get the port to which the socket is bound locally
     ///
@@ -71,6 +77,31 @@ public :
     ////////////////////////////////////////////////////////////
     unsigned short getRemotePort() const;
 
+    ////////////////////////////////////////////////////////////
+    /// \brief Set the size of the biggest packet accepted
+    ///
+    /// A peer announcing a bigger packet is disconnected, and the
+    /// receive functions return TGE::Socket::Error, so that it
+    /// can't make the socket buffer gigabytes. The default is
+    /// 16 MB. Raw data is not limited.
+    ///
+    /// \param size Maximum size of a received packet, in bytes
+    ///
+    /// \see getMaxPacketSize, receive
+    ///
+    ////////////////////////////////////////////////////////////
+    void setMaxPacketSize(std::size_t size);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Get the size of the biggest packet accepted
+    ///
+    /// \return Maximum size of a received packet, in bytes
+    ///
+    /// \see setMaxPacketSize
+    ///
+    ////////////////////////////////////////////////////////////
+    std::size_t getMaxPacketSize() const;
+
     ////////////////////////////////////////////////////////////
     /// \brief Connect the socket to a remote peer
     ///
@@ -105,6 +136,9 @@ public :
     /// \brief Send raw data to the remote peer
     ///
     /// This function will fail if the socket is not connected.
+    /// In non-blocking mode, part of the data may be sent before
+    /// the socket gets full; this overload can't tell how much,
+    /// use the other one to handle it.
     ///
     /// \param data Pointer to the sequence of bytes to send
     /// \param size Number of bytes to send
@@ -116,6 +150,25 @@ public :
     ////////////////////////////////////////////////////////////
     Status send(const void* data, std::size_t size);
 
+    ////////////////////////////////////////////////////////////
+    /// \brief Send raw data to the remote peer
+    ///
+    /// This function will fail if the socket is not connected.
+    /// In non-blocking mode, it returns TGE::Socket::Partial if
+    /// only part of the data could be sent: the rest, starting
+    /// at \a data + \a sent, must be sent later.
+    ///
+    /// \param data Pointer to the sequence of bytes to send
+    /// \param size Number of bytes to send
+    /// \param sent This variable is filled with the actual number of bytes sent
+    ///
+    /// \return Status code
+    ///
+    /// \see receive
+    ///
+    ////////////////////////////////////////////////////////////
+    Status send(const void* data, std::size_t size, std::size_t& sent);
+
     ////////////////////////////////////////////////////////////
     /// \brief Receive raw data from the remote peer
     ///
@@ -138,6 +191,13 @@ public :
     /// \brief Send a formatted packet of data to the remote peer
     ///
     /// This function will fail if the socket is not connected.
+    /// The size of the packet and its data are sent in a single
+    /// call, straight from the packet.
+    ///
+    /// In non-blocking mode, TGE::Socket::Partial means that the
+    /// packet was only partly sent: the same packet must be sent
+    /// again, and the socket will resume where it stopped. No
+    /// other data must be sent on the socket meanwhile.
     ///
     /// \param packet Packet to send
     ///
@@ -148,6 +208,28 @@ public :
     ////////////////////////////////////////////////////////////
     Status send(Packet& packet);
 
+    ////////////////////////////////////////////////////////////
+    /// \brief Send several formatted packets to the remote peer
+    ///
+    /// The packets are received as if they were sent one by
+    /// one, but they are sent with as few system calls as
+    /// possible, which is much faster for many small packets.
+    ///
+    /// In non-blocking mode, TGE::Socket::Partial means that the
+    /// packets were only partly sent: the same packets must be
+    /// sent again, and the socket will resume where it stopped.
+    /// No other data must be sent on the socket meanwhile.
+    ///
+    /// \param packets Array of packets to send
+    /// \param count   Number of packets in the array
+    ///
+    /// \return Status code
+    ///
+    /// \see receive
+    ///
+    ////////////////////////////////////////////////////////////
+    Status send(Packet* packets, std::size_t count);
+
     ////////////////////////////////////////////////////////////
     /// \brief Receive a formatted packet of data from the remote peer
     ///
@@ -155,6 +237,10 @@ public :
     /// has been received.
     /// This function will fail if the socket is not connected.
     ///
+    /// If the peer announces a packet bigger than the maximum
+    /// size (see setMaxPacketSize), the socket is disconnected
+    /// and TGE::Socket::Error is returned.
+    ///
     /// \param packet Packet to fill with the received data
     ///
     /// \return Status code
@@ -164,27 +250,71 @@ public :
     ////////////////////////////////////////////////////////////
     Status receive(Packet& packet);
 
+    ////////////////////////////////////////////////////////////
+    /// \brief Receive all the formatted packets available
+    ///
+    /// The socket reads everything that is available with a
+    /// single system call, and returns every complete packet
+    /// found in the received data. The packets are owned by the
+    /// socket and read the data straight from its receive
+    /// buffer: they are only valid until the next call to a
+    /// receive function, and appending data to one of them
+    /// takes a copy of its data first.
+    ///
+    /// In blocking mode, this function waits until at least one
+    /// packet has been received. In non-blocking mode, it returns
+    /// TGE::Socket::NotReady if no complete packet is available.
+    /// Like the single packet version, it disconnects a peer
+    /// announcing a packet bigger than the maximum size.
+    ///
+    /// \param packets Array to fill with the received packets,
+    ///                its previous content is discarded
+    ///
+    /// \return Status code, Done if at least one packet was received
+    ///
+    /// \see send
+    ///
+    ////////////////////////////////////////////////////////////
+    Status receive(std::vector<Packet*>& packets);
+
 private:
 
     friend class TcpListener;
 
     ////////////////////////////////////////////////////////////
-    /// \brief Structure holding the data of a pending packet
+    /// \brief Forget the data of the packets being sent and received
+    ///
+    ////////////////////////////////////////////////////////////
+    void resetPendingData();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Read as many bytes as possible into the receive buffer
+    ///
+    /// \return Status code, Done if some bytes were received
     ///
     ////////////////////////////////////////////////////////////
-    struct PendingPacket
-    {
-        PendingPacket();
+    Status fillReceiveBuffer();
 
-        Uint32            Size;         ///< Data of packet size
-        std::size_t       SizeReceived; ///< Number of size bytes received so far
-        std::vector<char> Data;         ///< Data of the packet
-    };
+    ////////////////////////////////////////////////////////////
+    /// \brief Find the next complete packet in the receive buffer
+    ///
+    /// \param data Filled with a pointer to the data of the packet
+    /// \param size Filled with the size of the packet
+    ///
+    /// \return True if a complete packet was found and consumed
+    ///
+    ////////////////////////////////////////////////////////////
+    bool extractPacket(const char*& data, std::size_t& size);
 
     ////////////////////////////////////////////////////////////
     // Member data
     ////////////////////////////////////////////////////////////
-    PendingPacket m_pendingPacket; ///< Temporary data of the packet currently being received
+    std::vector<char>    m_receiveBuffer; ///< Bytes received and not yet extracted
+    std::size_t          m_receiveBegin;  ///< Position of the first byte not yet extracted
+    std::size_t          m_receiveEnd;    ///< Position after the last byte received
+    std::vector<Packet*> m_packetPool;    ///< Packets returned by the batch receive, reused from call to call
+    std::size_t          m_sendOffset;    ///< Number of bytes of the packets being sent that a previous partial send already sent
+    std::size_t          m_maxPacketSize; ///< Size of the biggest packet accepted from the peer
 };
 
 } // namespace TGE
@@ -223,6 +353,16 @@ private:
 /// the data that is exchanged. You can look at the TGE::Packet
 /// class to get more details about how they work.
 ///
+/// Received data is read in large chunks into a buffer owned
+/// by the socket, so receiving many small packets costs few
+/// system calls. The batch version of receive returns all the
+/// packets available at once, without copying their data.
+/// The buffer grows with the bytes of a big packet as they
+/// arrive, and shrinks back once the packet is extracted. A
+/// peer announcing a packet bigger than 16 MB, or the size
+/// given to setMaxPacketSize, is disconnected, and receive
+/// returns TGE::Socket::Error.
+///
 /// The socket is automatically disconnected when it is destroyed,
 /// but if you want to explicitely close the connection while
 /// the socket instance is still alive, you can call disconnect.
@@ -0,0 +1,412 @@
+/*************************************/
+/** Copyright © 2014 Coldsnap Games **/
+/*************************************/
+
+#ifndef TGE_UDPCONNECTION_HPP
+#define TGE_UDPCONNECTION_HPP
+
+/*************************************/
+/**             Headers             **/
+/*************************************/
+#include <Tyrant/Config.hpp>
+#include <Tyrant/Network/IpAddress.hpp>
+#include <Tyrant/Network/Packet.hpp>
+#include <Tyrant/Network/Socket.hpp>
+#include <Tyrant/System/Clock.hpp>
+#include <Tyrant/System/NonCopyable.hpp>
+#include <Tyrant/System/Time.hpp>
+#include <deque>
+#include <vector>
+
+
+namespace TGE
+{
+class LinkConditioner;
+class UdpSocket;
+
+////////////////////////////////////////////////////////////
+/// \brief Reliable and ordered messages over a UDP socket
+///
+////////////////////////////////////////////////////////////
+class TGE_API UdpConnection : NonCopyable
+{
+public :
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Delivery guarantees of a message
+    ///
+    ////////////////////////////////////////////////////////////
+    enum Channel
+    {
+        Unreliable,          ///< The message may be lost, duplicated or arrive out of order
+        UnreliableSequenced, ///< The message may be lost, but is dropped if a newer one arrived first
+        ReliableOrdered      ///< The message is received exactly once, in the order it was sent
+    };
+
+    ////////////////////////////////////////////////////////////
+    // Constants
+    ////////////////////////////////////////////////////////////
+    enum
+    {
+        MaxFragmentSize = 1024,                 ///< Messages bigger than this are split into fragments
+        MaxMessageSize  = MaxFragmentSize * 255 ///< The maximum number of bytes of a message
+    };
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Construct the connection to a remote peer
+    ///
+    /// \param socket        Socket to send the datagrams with, must
+    ///                      outlive the connection
+    /// \param remoteAddress Address of the remote peer
+    /// \param remotePort    Port of the remote peer
+    ///
+    ////////////////////////////////////////////////////////////
+    UdpConnection(UdpSocket& socket, const IpAddress& remoteAddress, unsigned short remotePort);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Get the address of the remote peer
+    ///
+    /// \return Address of the remote peer
+    ///
+    ////////////////////////////////////////////////////////////
+    const IpAddress& getRemoteAddress() const;
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Get the port of the remote peer
+    ///
+    /// \return Port of the remote peer
+    ///
+    ////////////////////////////////////////////////////////////
+    unsigned short getRemotePort() const;
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Queue a message for the remote peer
+    ///
+    /// The message is copied and sent by the next call to
+    /// update. Unreliable messages which can't be sent by the
+    /// next update, because of the send rate, are dropped.
+    ///
+    /// \param packet  Message to send
+    /// \param channel Delivery guarantees of the message
+    ///
+    /// \return True if the message was queued, false if it is
+    ///         bigger than MaxMessageSize
+    ///
+    /// \see receive, update
+    ///
+    ////////////////////////////////////////////////////////////
+    bool send(Packet& packet, Channel channel);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Get the next message received from the remote peer
+    ///
+    /// \param packet Packet to fill with the message
+    ///
+    /// \return True if a message was received, false if there
+    ///         is no message waiting
+    ///
+    /// \see send, processDatagram
+    ///
+    ////////////////////////////////////////////////////////////
+    bool receive(Packet& packet);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Process a datagram received from the remote peer
+    ///
+    /// The connection doesn't read the socket itself, so that
+    /// a server can receive the datagrams of all its clients on
+    /// a single socket and give each one to its connection.
+    ///
+    /// \param datagram Datagram received from the remote peer
+    ///
+    /// \return True if the datagram is valid, false if it was
+    ///         not sent by a connection
+    ///
+    ////////////////////////////////////////////////////////////
+    bool processDatagram(const Packet& datagram);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Send the queued messages and the acknowledgements
+    ///
+    /// This function must be called regularly, typically every
+    /// frame. It also sends the reliable messages again when
+    /// they were not acknowledged in time.
+    ///
+    /// \return Status code, Disconnected if nothing was received
+    ///         from the remote peer for longer than the timeout
+    ///
+    ////////////////////////////////////////////////////////////
+    Socket::Status update();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Set the time after which a silent peer is
+    ///        considered disconnected
+    ///
+    /// The default timeout is 10 seconds.
+    ///
+    /// \param timeout Timeout of the connection
+    ///
+    ////////////////////////////////////////////////////////////
+    void setTimeout(Time timeout);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Set the maximum send rate of the connection
+    ///
+    /// The actual send rate adapts to the congestion of the
+    /// network, between a small minimum and this maximum. The
+    /// default maximum is 256 KB/s.
+    ///
+    /// \param bytesPerSecond Maximum number of bytes sent per second
+    ///
+    ////////////////////////////////////////////////////////////
+    void setMaxSendRate(Uint32 bytesPerSecond);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Send the datagrams through a link conditioner
+    ///
+    /// The conditioner simulates a bad network, to test how the
+    /// connection copes with it. It is updated by the connection.
+    ///
+    /// \param conditioner Conditioner to send through, must be
+    ///                    built on the connection's socket, or
+    ///                    NULL to send directly
+    ///
+    /// \see LinkConditioner
+    ///
+    ////////////////////////////////////////////////////////////
+    void setLinkConditioner(LinkConditioner* conditioner);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Get the current send rate of the connection
+    ///
+    /// \return Number of bytes that can be sent per second
+    ///
+    ////////////////////////////////////////////////////////////
+    Uint32 getSendRate() const;
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Get the smoothed round trip time to the remote peer
+    ///
+    /// \return Round trip time
+    ///
+    ////////////////////////////////////////////////////////////
+    Time getRoundTripTime() const;
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Get the ratio of datagrams lost recently
+    ///
+    /// \return Packet loss, between 0 and 1
+    ///
+    ////////////////////////////////////////////////////////////
+    float getPacketLoss() const;
+
+private :
+
+    ////////////////////////////////////////////////////////////
+    // Constants
+    ////////////////////////////////////////////////////////////
+    enum
+    {
+        DatagramWindow         = 256,  ///< Number of sent and received datagrams remembered
+        MessageWindow          = 1024, ///< Number of reliable messages in flight
+        MaxMessagesPerDatagram = 32    ///< Maximum number of messages in a datagram
+    };
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Message, or fragment of a message, waiting to be sent
+    ///
+    ////////////////////////////////////////////////////////////
+    struct OutgoingMessage
+    {
+        Uint16            id;            ///< Identifier of the message in its channel
+        Uint8             channel;       ///< Channel of the message
+        Uint8             fragmentIndex; ///< Index of the fragment in the message
+        Uint8             fragmentCount; ///< Number of fragments of the message, 1 if it is not split
+        bool              acknowledged;  ///< Did the remote peer receive the message?
+        Int64             lastSent;      ///< Time at which the message was last sent, -1 if never sent
+        std::vector<char> data;          ///< Data of the message
+    };
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Reliable message, or fragment, received out of order
+    ///
+    ////////////////////////////////////////////////////////////
+    struct IncomingMessage
+    {
+        bool              valid;         ///< Does the slot hold a message?
+        Uint16            id;            ///< Identifier of the message
+        Uint8             fragmentIndex; ///< Index of the fragment in the message
+        Uint8             fragmentCount; ///< Number of fragments of the message
+        std::vector<char> data;          ///< Data of the fragment
+    };
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Unreliable message being reassembled
+    ///
+    ////////////////////////////////////////////////////////////
+    struct Reassembly
+    {
+        Uint16                          id;        ///< Identifier of the message
+        std::size_t                     received;  ///< Number of fragments received
+        std::vector<std::vector<char> > fragments; ///< Data of the fragments, empty if not received yet
+    };
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Datagram sent, waiting for its acknowledgement
+    ///
+    ////////////////////////////////////////////////////////////
+    struct SentDatagram
+    {
+        bool   valid;                              ///< Does the slot hold a datagram?
+        Uint16 sequence;                           ///< Sequence number of the datagram
+        Int64  time;                               ///< Time at which the datagram was sent
+        Uint32 size;                               ///< Size of the datagram, in bytes
+        Uint8  messageCount;                       ///< Number of reliable messages in the datagram
+        Uint16 messageIds[MaxMessagesPerDatagram]; ///< Reliable messages in the datagram
+    };
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Write a message at the end of the datagram being built
+    ///
+    /// \param message Message to write
+    ///
+    ////////////////////////////////////////////////////////////
+    void writeMessage(const OutgoingMessage& message);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Handle a message read from a datagram
+    ///
+    ////////////////////////////////////////////////////////////
+    void processMessage(Uint8 channel, Uint16 id, Uint8 fragmentIndex, Uint8 fragmentCount, const char* data, std::size_t size);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Handle the acknowledgement of a datagram
+    ///
+    ////////////////////////////////////////////////////////////
+    void acknowledge(Uint16 sequence, Int64 now);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Deliver the reliable messages received in order
+    ///
+    ////////////////////////////////////////////////////////////
+    void deliverReliableMessages();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Make a received message available to receive
+    ///
+    ////////////////////////////////////////////////////////////
+    void deliver(Uint8 channel, Uint16 id, const char* data, std::size_t size);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Get the delay after which an unacknowledged
+    ///        message is sent again
+    ///
+    /// \return Retransmission timeout, in microseconds
+    ///
+    ////////////////////////////////////////////////////////////
+    Int64 getRetransmissionTimeout() const;
+
+    ////////////////////////////////////////////////////////////
+    // Member data
+    ////////////////////////////////////////////////////////////
+    UdpSocket&                      m_socket;             ///< Socket sending the datagrams
+    LinkConditioner*                m_conditioner;        ///< Conditioner the datagrams are sent through, if any
+    IpAddress                       m_remoteAddress;      ///< Address of the remote peer
+    unsigned short                  m_remotePort;         ///< Port of the remote peer
+    Clock                           m_clock;              ///< Clock giving the current time
+    Int64                           m_lastUpdate;         ///< Time of the last update
+    Int64                           m_lastSend;           ///< Time at which the last datagram was sent
+    Int64                           m_lastReceive;        ///< Time at which the last datagram was received
+    Int64                           m_timeout;            ///< Time after which a silent peer is disconnected
+    Uint16                          m_localSequence;      ///< Sequence number of the next datagram sent
+    Uint16                          m_remoteSequence;     ///< Most recent sequence number received
+    bool                            m_receivedAny;        ///< Was any datagram received yet?
+    bool                            m_ackPending;         ///< Must the last datagrams received be acknowledged?
+    std::vector<SentDatagram>       m_sentDatagrams;      ///< Datagrams sent, indexed by sequence number
+    std::vector<Int32>              m_receivedSequences;  ///< Sequence numbers received, indexed by sequence number, -1 if none
+    std::deque<OutgoingMessage>     m_reliableQueue;      ///< Reliable messages not acknowledged yet, in order
+    std::vector<OutgoingMessage>    m_unreliableQueue;    ///< Unreliable messages waiting for the next update
+    Uint16                          m_nextReliableId;     ///< Identifier of the next reliable message sent
+    Uint16                          m_nextUnreliableId;   ///< Identifier of the next unreliable message sent
+    std::vector<IncomingMessage>    m_incomingReliable;   ///< Reliable messages received, indexed by identifier
+    Uint16                          m_expectedReliableId; ///< Identifier of the next reliable message to deliver
+    Uint16                          m_lastSequencedId;    ///< Identifier of the last sequenced message delivered
+    bool                            m_sequencedReceived;  ///< Was any sequenced message delivered yet?
+    Reassembly                      m_reassembly[2];      ///< Unreliable messages being reassembled, per channel
+    std::deque<std::vector<char> >  m_received;           ///< Messages waiting to be received
+    Packet                          m_datagram;           ///< Datagram being built
+    Uint8                           m_datagramMessages;   ///< Number of messages in the datagram being built
+    Int64                           m_roundTripTime;      ///< Smoothed round trip time, in microseconds
+    Int64                           m_roundTripVariation; ///< Variation of the round trip time, in microseconds
+    float                           m_packetLoss;         ///< Smoothed ratio of lost datagrams
+    double                          m_sendRate;           ///< Current send rate, in bytes per second
+    double                          m_maxSendRate;        ///< Maximum send rate, in bytes per second
+    double                          m_sendBudget;         ///< Number of bytes that can be sent now
+    Int64                           m_lastRateDecrease;   ///< Time at which the send rate was last decreased
+};
+
+} // namespace TGE
+
+
+#endif // TGE_UDPCONNECTION_HPP
+
+
+////////////////////////////////////////////////////////////
+/// \class TGE::UdpConnection
+/// \ingroup network
+///
+/// TGE::UdpConnection adds the guarantees of TCP to a
+/// TGE::UdpSocket, only for the messages which need them. A
+/// lost TCP segment stalls everything sent after it, whereas
+/// a lost datagram of a connection only delays the reliable
+/// messages it contained: the real-time updates sent on the
+/// unreliable channels keep flowing.
+///
+/// Every datagram carries a sequence number and acknowledges
+/// the last 33 datagrams received from the remote peer. The
+/// acknowledgements measure the round trip time, detect the
+/// lost datagrams, and tell which reliable messages must be
+/// sent again. Messages bigger than MaxFragmentSize are split
+/// into fragments and reassembled by the receiver.
+///
+/// The send rate follows the congestion of the network: it
+/// grows by about one datagram per round trip while datagrams
+/// are acknowledged, and drops by 30% when some are lost.
+///
+/// The connection doesn't read the socket: the datagrams
+/// received from the remote peer must be given to
+/// processDatagram. Both peers must call update regularly.
+///
+/// Usage example:
+/// \code
+/// TGE::UdpSocket socket;
+/// socket.bind(55002);
+/// socket.setBlocking(false);
+///
+/// TGE::UdpConnection connection(socket, "192.168.1.50", 55001);
+///
+/// // Every frame
+/// TGE::Packet datagram;
+/// TGE::IpAddress sender;
+/// unsigned short port;
+/// while (socket.receive(datagram, sender, port) == TGE::Socket::Done)
+/// {
+///     if ((sender == connection.getRemoteAddress()) && (port == connection.getRemotePort()))
+///         connection.processDatagram(datagram);
+/// }
+///
+/// TGE::Packet message;
+/// while (connection.receive(message))
+///     handleMessage(message);
+///
+/// TGE::Packet position;
+/// position << x << y;
+/// connection.send(position, TGE::UdpConnection::UnreliableSequenced);
+///
+/// if (connection.update() == TGE::Socket::Disconnected)
+///     std::cout << "Connection lost" << std::endl;
+/// \endcode
+///
+/// \see TGE::UdpSocket, TGE::Packet
+///
+////////////////////////////////////////////////////////////
@@ -10,12 +10,12 @@
 /*************************************/
 #include <Tyrant/Config.hpp>
 #include <Tyrant/Network/Socket.hpp>
+#include <Tyrant/Network/IpAddress.hpp>
 #include <vector>
 
 
 namespace TGE
 {
-class IpAddress;
 class Packet;
 
 ////////////////////////////////////////////////////////////
@@ -31,7 +31,35 @@ public :
     ////////////////////////////////////////////////////////////
     enum
     {
-        MaxDatagramSize = 65507 ///< The maximum number of bytes that can be sent in a single UDP datagram
+        MaxDatagramSize     = 65507, ///< The maximum number of bytes that can be sent in a single UDP datagram
+        MaxDatagramsPerCall = 32     ///< The maximum number of datagrams sent or received by a single system call of the batch functions
+    };
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Packet sent to or received from a remote peer
+    ///
+    ////////////////////////////////////////////////////////////
+    struct Datagram
+    {
+        ////////////////////////////////////////////////////////////
+        /// \brief Default constructor
+        ///
+        ////////////////////////////////////////////////////////////
+        Datagram();
+
+        ////////////////////////////////////////////////////////////
+        /// \brief Construct a datagram to send
+        ///
+        /// \param datagramPacket Packet to send
+        /// \param remoteAddress  Address of the receiver
+        /// \param remotePort     Port of the receiver
+        ///
+        ////////////////////////////////////////////////////////////
+        Datagram(Packet& datagramPacket, const IpAddress& remoteAddress, unsigned short remotePort);
+
+        Packet*        packet;  ///< Data of the datagram
+        IpAddress      address; ///< Address of the receiver or of the sender
+        unsigned short port;    ///< Port of the receiver or of the sender
     };
 
     ////////////////////////////////////////////////////////////
@@ -40,6 +68,12 @@ public :
     ////////////////////////////////////////////////////////////
     UdpSocket();
 
+    ////////////////////////////////////////////////////////////
+    /// \brief Destructor
+    ///
+    ////////////////////////////////////////////////////////////
+    ~UdpSocket();
+
     ////////////////////////////////////////////////////////////
     /// \brief Get the port to which the socket is bound locally
     ///
@@ -62,14 +96,22 @@ public :
     /// system to automatically pick an available port, and then
     /// call getLocalPort to retrieve the chosen port.
     ///
-    /// \param port Port to bind the socket to
+    /// When \a sharePort is true, several sockets can bind to
+    /// the same port, and the system spreads the incoming
+    /// datagrams among them, so that each thread can receive on
+    /// its own socket. All the sockets sharing the port must
+    /// ask for it. This is not supported on Windows, where
+    /// binding then fails.
+    ///
+    /// \param port      Port to bind the socket to
+    /// \param sharePort Let other sockets bind to the same port
     ///
     /// \return Status code
     ///
     /// \see unbind, getLocalPort
     ///
     ////////////////////////////////////////////////////////////
-    Status bind(unsigned short port);
+    Status bind(unsigned short port, bool sharePort = false);
 
     ////////////////////////////////////////////////////////////
     /// \brief Unbind the socket from the local port to which it is bound
@@ -160,12 +202,58 @@ public :
     ////////////////////////////////////////////////////////////
     Status receive(Packet& packet, IpAddress& remoteAddress, unsigned short& remotePort);
 
+    ////////////////////////////////////////////////////////////
+    /// \brief Send several packets, each to its own receiver
+    ///
+    /// The datagrams are sent with as few system calls as
+    /// possible (a single one for up to MaxDatagramsPerCall
+    /// datagrams on Linux).
+    ///
+    /// In non-blocking mode, TGE::Socket::Partial means that
+    /// only the first \a sent datagrams were sent, the others
+    /// must be sent again later.
+    ///
+    /// \param datagrams Array of datagrams to send
+    /// \param count     Number of datagrams in the array
+    /// \param sent      This variable is filled with the number of datagrams sent
+    ///
+    /// \return Status code
+    ///
+    /// \see receive
+    ///
+    ////////////////////////////////////////////////////////////
+    Status send(const Datagram* datagrams, std::size_t count, std::size_t& sent);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Receive all the datagrams available, up to
+    ///        MaxDatagramsPerCall
+    ///
+    /// The datagrams are received with as few system calls as
+    /// possible (a single one on Linux). Their packets are owned
+    /// by the socket and read the data straight from its receive
+    /// buffer: they are only valid until the next batch receive.
+    ///
+    /// In blocking mode, this function waits until at least one
+    /// datagram has been received.
+    ///
+    /// \param datagrams Array to fill with the received datagrams,
+    ///                  its previous content is discarded
+    ///
+    /// \return Status code, Done if at least one datagram was received
+    ///
+    /// \see send
+    ///
+    ////////////////////////////////////////////////////////////
+    Status receive(std::vector<Datagram>& datagrams);
+
 private:
 
     ////////////////////////////////////////////////////////////
     // Member data
     ////////////////////////////////////////////////////////////
-    std::vector<char> m_buffer; ///< Temporary buffer holding the received data in Receive(Packet)
+    std::vector<char>    m_buffer;       ///< Temporary buffer holding the received data in Receive(Packet)
+    std::vector<char>    m_receiveArena; ///< Buffer receiving the datagrams of the batch receive
+    std::vector<Packet*> m_packetPool;   ///< Packets returned by the batch receive, reused from call to call
 };
 
 } // namespace TGE
@@ -213,6 +301,11 @@ private:
 /// of the protocol (dropped, mixed or duplicated datagrams may
 /// lead to a big mess when trying to recompose a packet).
 ///
+/// Servers talking to many peers should use the batch
+/// versions of send and receive, which process an array of
+/// datagrams at once and save many system calls. The
+/// received packets aren't copied.
+///
 /// If the socket is bound to a port, it is automatically
 /// unbound from it when the socket is destroyed. However,
 /// you can unbind the socket explicitely with the Unbind
@@ -37,7 +37,8 @@ public :
     ////////////////////////////////////////////////////////////
     // Types
     ////////////////////////////////////////////////////////////
-    typedef int AddrLength;
+    typedef int    AddrLength;
+    typedef WSABUF IoBuffer;
 
     ////////////////////////////////////////////////////////////
     /// \brief Create an internal sockaddr_in address
@@ -75,6 +76,69 @@ public :
     ////////////////////////////////////////////////////////////
     static void setBlocking(SocketHandle sock, bool block);
 
+    ////////////////////////////////////////////////////////////
+    /// \brief Point a buffer of a scatter-gather send to some data
+    ///
+    /// \param buffer Buffer to set
+    /// \param data   Data to send
+    /// \param size   Size of the data, in bytes
+    ///
+    ////////////////////////////////////////////////////////////
+    static void setIoBuffer(IoBuffer& buffer, const void* data, std::size_t size);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Send several buffers in a single call
+    ///
+    /// \param sock    Handle of the socket
+    /// \param buffers Buffers to send, in order
+    /// \param count   Number of buffers
+    /// \param flags   Flags of the send
+    ///
+    /// \return Number of bytes sent, or -1 on error
+    ///
+    ////////////////////////////////////////////////////////////
+    static int sendBuffers(SocketHandle sock, IoBuffer* buffers, std::size_t count, int flags);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Send several datagrams in as few calls as possible
+    ///
+    /// \param sock      Handle of the socket
+    /// \param buffers   Data of each datagram
+    /// \param addresses Receiver of each datagram
+    /// \param count     Number of datagrams
+    ///
+    /// \return Number of datagrams sent, or -1 if none could be sent
+    ///
+    ////////////////////////////////////////////////////////////
+    static int sendDatagrams(SocketHandle sock, IoBuffer* buffers, sockaddr_in* addresses, std::size_t count);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Receive several datagrams in as few calls as possible
+    ///
+    /// Waits for the first datagram if the socket is blocking,
+    /// then only takes the datagrams already received.
+    ///
+    /// \param sock      Handle of the socket
+    /// \param buffers   Buffer to fill with each datagram
+    /// \param addresses Filled with the sender of each datagram
+    /// \param sizes     Filled with the size of each datagram
+    /// \param count     Maximum number of datagrams to receive
+    ///
+    /// \return Number of datagrams received, or -1 on error
+    ///
+    ////////////////////////////////////////////////////////////
+    static int receiveDatagrams(SocketHandle sock, IoBuffer* buffers, sockaddr_in* addresses, std::size_t* sizes, std::size_t count);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Let several sockets bind to the same port
+    ///
+    /// \param sock Handle of the socket, not bound yet
+    ///
+    /// \return True if the system supports it
+    ///
+    ////////////////////////////////////////////////////////////
+    static bool setReusePort(SocketHandle sock);
+
     ////////////////////////////////////////////////////////////
     /// Get the last socket error status
     ///
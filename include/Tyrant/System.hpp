@@ -10,12 +10,26 @@
 /*************************************/
 
 #include <Tyrant/Config.hpp>
+#include <Tyrant/System/AllocationCounter.hpp>
+#include <Tyrant/System/ArenaAllocator.hpp>
 #include <Tyrant/System/Clock.hpp>
+#include <Tyrant/System/ConditionVariable.hpp>
 #include <Tyrant/System/Log.hpp>
 #include <Tyrant/System/InputStream.hpp>
+#include <Tyrant/System/JobSystem.hpp>
 #include <Tyrant/System/Lock.hpp>
+#include <Tyrant/System/MemoryArena.hpp>
+#include <Tyrant/System/MemoryPool.hpp>
+#include <Tyrant/System/MpmcQueue.hpp>
 #include <Tyrant/System/Mutex.hpp>
+#include <Tyrant/System/ObjectPool.hpp>
+#include <Tyrant/System/PoolAllocator.hpp>
+#include <Tyrant/System/Profiler.hpp>
+#include <Tyrant/System/ReadWriteLock.hpp>
+#include <Tyrant/System/Semaphore.hpp>
 #include <Tyrant/System/Sleep.hpp>
+#include <Tyrant/System/SpinMutex.hpp>
+#include <Tyrant/System/SpscQueue.hpp>
 #include <Tyrant/System/String.hpp>
 #include <Tyrant/System/Thread.hpp>
 #include <Tyrant/System/ThreadLocal.hpp>
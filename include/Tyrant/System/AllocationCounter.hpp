@@ -0,0 +1,77 @@
+/*************************************/
+/** Copyright © 2014 Coldsnap Games **/
+/*************************************/
+
+#ifndef TGE_ALLOCATIONCOUNTER_HPP
+#define TGE_ALLOCATIONCOUNTER_HPP
+
+/*************************************/
+/**             Headers             **/
+/*************************************/
+#include <Tyrant/Config.hpp>
+
+
+namespace TGE
+{
+////////////////////////////////////////////////////////////
+/// \brief Counts the heap allocations made by the program
+///
+////////////////////////////////////////////////////////////
+class TGE_API AllocationCounter
+{
+public :
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Tell whether allocations are counted
+    ///
+    /// \return True if the engine was built with
+    ///         TGE_COUNT_ALLOCATIONS
+    ///
+    ////////////////////////////////////////////////////////////
+    static bool isEnabled();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Get the number of heap allocations made so far
+    ///
+    /// The counter wraps around, only the difference between
+    /// two calls is meaningful.
+    ///
+    /// \return Number of calls to operator new since the start
+    ///         of the program, 0 if counting is disabled
+    ///
+    ////////////////////////////////////////////////////////////
+    static Uint32 getCount();
+};
+
+} // namespace TGE
+
+
+#endif // TGE_ALLOCATIONCOUNTER_HPP
+
+
+////////////////////////////////////////////////////////////
+/// \class TGE::AllocationCounter
+/// \ingroup system
+///
+/// TGE::AllocationCounter checks that code which runs every
+/// frame doesn't allocate memory: heap allocations are slow,
+/// take locks shared by all threads and fragment the memory.
+///
+/// When the engine is built with TGE_COUNT_ALLOCATIONS (make
+/// COUNT_ALLOCATIONS=1), it replaces the global operator new
+/// with a version that counts its calls. Otherwise nothing is
+/// counted and getCount() always returns 0. On Windows, the
+/// replacement only applies to the code linked with the
+/// engine statically.
+///
+/// TGE::Game records the number of allocations of each frame
+/// in its TGE::FrameStatistics.
+///
+/// Usage example:
+/// \code
+/// TGE::Uint32 before = TGE::AllocationCounter::getCount();
+/// world.update();
+/// TGE::Uint32 allocations = TGE::AllocationCounter::getCount() - before;
+/// \endcode
+///
+////////////////////////////////////////////////////////////
@@ -0,0 +1,180 @@
+/*************************************/
+/** Copyright © 2014 Coldsnap Games **/
+/*************************************/
+
+#ifndef TGE_ARENAALLOCATOR_HPP
+#define TGE_ARENAALLOCATOR_HPP
+
+/*************************************/
+/**             Headers             **/
+/*************************************/
+#include <Tyrant/Config.hpp>
+#include <Tyrant/System/MemoryArena.hpp>
+#include <cstddef>
+#include <new>
+
+
+namespace TGE
+{
+////////////////////////////////////////////////////////////
+/// \brief Standard allocator taking its memory from a
+///        TGE::MemoryArena
+///
+////////////////////////////////////////////////////////////
+template <typename T>
+class ArenaAllocator
+{
+public :
+
+    typedef T              value_type;
+    typedef T*             pointer;
+    typedef const T*       const_pointer;
+    typedef T&             reference;
+    typedef const T&       const_reference;
+    typedef std::size_t    size_type;
+    typedef std::ptrdiff_t difference_type;
+
+    template <typename U>
+    struct rebind
+    {
+        typedef ArenaAllocator<U> other;
+    };
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Construct the allocator from an arena
+    ///
+    /// \param arena Arena to allocate from, must outlive the
+    ///              allocator and its copies
+    ///
+    ////////////////////////////////////////////////////////////
+    explicit ArenaAllocator(MemoryArena& arena);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Construct the allocator from an allocator of
+    ///        another type
+    ///
+    /// \param other Allocator to copy the arena from
+    ///
+    ////////////////////////////////////////////////////////////
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Allocate memory for an array of elements
+    ///
+    /// \param count Number of elements
+    ///
+    /// \return Pointer to the first element
+    ///
+    ////////////////////////////////////////////////////////////
+    pointer allocate(size_type count, const void* hint = 0);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Release an array of elements
+    ///
+    /// Does nothing, the memory is released when the arena is
+    /// reset.
+    ///
+    ////////////////////////////////////////////////////////////
+    void deallocate(pointer elements, size_type count);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Get the maximum number of elements that can be
+    ///        allocated
+    ///
+    ////////////////////////////////////////////////////////////
+    size_type max_size() const;
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Construct an element in allocated memory
+    ///
+    ////////////////////////////////////////////////////////////
+    void construct(pointer element, const T& value);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Destroy an element without releasing its memory
+    ///
+    ////////////////////////////////////////////////////////////
+    void destroy(pointer element);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Get the address of an element
+    ///
+    ////////////////////////////////////////////////////////////
+    pointer address(reference element) const;
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Get the address of a constant element
+    ///
+    ////////////////////////////////////////////////////////////
+    const_pointer address(const_reference element) const;
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Get the arena of the allocator
+    ///
+    /// \return Arena used to allocate memory
+    ///
+    ////////////////////////////////////////////////////////////
+    MemoryArena& getArena() const;
+
+private :
+
+    ////////////////////////////////////////////////////////////
+    // Member data
+    ////////////////////////////////////////////////////////////
+    MemoryArena* m_arena; ///< Arena to allocate from
+};
+
+////////////////////////////////////////////////////////////
+/// \relates ArenaAllocator
+/// \brief Overload of binary operator == to compare two allocators
+///
+/// \return True if both allocators use the same arena
+///
+////////////////////////////////////////////////////////////
+template <typename T, typename U>
+bool operator ==(const ArenaAllocator<T>& left, const ArenaAllocator<U>& right);
+
+////////////////////////////////////////////////////////////
+/// \relates ArenaAllocator
+/// \brief Overload of binary operator != to compare two allocators
+///
+/// \return True if the allocators use different arenas
+///
+////////////////////////////////////////////////////////////
+template <typename T, typename U>
+bool operator !=(const ArenaAllocator<T>& left, const ArenaAllocator<U>& right);
+
+#include <Tyrant/System/ArenaAllocator.inl>
+
+} // namespace TGE
+
+
+#endif // TGE_ARENAALLOCATOR_HPP
+
+
+////////////////////////////////////////////////////////////
+/// \class TGE::ArenaAllocator
+/// \ingroup system
+///
+/// TGE::ArenaAllocator lets standard containers store their
+/// elements in a TGE::MemoryArena, typically the frame arena.
+/// Growing the container then costs no heap allocation, and
+/// releasing its memory is free.
+///
+/// The memory given back by the container is not reused
+/// before the arena is reset, so a container that grows a lot
+/// should reserve() its final size first. The container must
+/// be destroyed before the arena is reset.
+///
+/// Usage example:
+/// \code
+/// typedef std::vector<Enemy*, TGE::ArenaAllocator<Enemy*> > EnemyList;
+///
+/// EnemyList visible(TGE::ArenaAllocator<Enemy*>(TGE::MemoryArena::getFrameArena()));
+/// visible.reserve(enemies.size());
+/// \endcode
+///
+/// \see TGE::MemoryArena, TGE::PoolAllocator
+///
+////////////////////////////////////////////////////////////
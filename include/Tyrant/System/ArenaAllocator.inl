@@ -0,0 +1,99 @@
+/*************************************/
+/** Copyright © 2014 Coldsnap Games **/
+/*************************************/
+
+
+////////////////////////////////////////////////////////////
+template <typename T>
+ArenaAllocator<T>::ArenaAllocator(MemoryArena& arena) :
+m_arena(&arena)
+{
+}
+
+
+////////////////////////////////////////////////////////////
+template <typename T>
+template <typename U>
+ArenaAllocator<T>::ArenaAllocator(const ArenaAllocator<U>& other) :
+m_arena(&other.getArena())
+{
+}
+
+
+////////////////////////////////////////////////////////////
+template <typename T>
+typename ArenaAllocator<T>::pointer ArenaAllocator<T>::allocate(size_type count, const void*)
+{
+    return static_cast<pointer>(m_arena->allocate(count * sizeof(T), __alignof__(T)));
+}
+
+
+////////////////////////////////////////////////////////////
+template <typename T>
+void ArenaAllocator<T>::deallocate(pointer, size_type)
+{
+}
+
+
+////////////////////////////////////////////////////////////
+template <typename T>
+typename ArenaAllocator<T>::size_type ArenaAllocator<T>::max_size() const
+{
+    return static_cast<size_type>(-1) / sizeof(T);
+}
+
+
+////////////////////////////////////////////////////////////
+template <typename T>
+void ArenaAllocator<T>::construct(pointer element, const T& value)
+{
+    new (element) T(value);
+}
+
+
+////////////////////////////////////////////////////////////
+template <typename T>
+void ArenaAllocator<T>::destroy(pointer element)
+{
+    element->~T();
+}
+
+
+////////////////////////////////////////////////////////////
+template <typename T>
+typename ArenaAllocator<T>::pointer ArenaAllocator<T>::address(reference element) const
+{
+    return &element;
+}
+
+
+////////////////////////////////////////////////////////////
+template <typename T>
+typename ArenaAllocator<T>::const_pointer ArenaAllocator<T>::address(const_reference element) const
+{
+    return &element;
+}
+
+
+////////////////////////////////////////////////////////////
+template <typename T>
+MemoryArena& ArenaAllocator<T>::getArena() const
+{
+    return *m_arena;
+}
+
+
+////////////////////////////////////////////////////////////
+template <typename T, typename U>
+bool operator ==(const ArenaAllocator<T>& left, const ArenaAllocator<U>& right)
+{
+    return &left.getArena() == &right.getArena();
+}
+
+
+////////////////////////////////////////////////////////////
+template <typename T, typename U>
+bool operator !=(const ArenaAllocator<T>& left, const ArenaAllocator<U>& right)
+{
+    return !(left == right);
+}
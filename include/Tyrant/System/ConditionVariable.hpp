@@ -0,0 +1,143 @@
+/*************************************/
+/** Copyright © 2014 Coldsnap Games **/
+/*************************************/
+
+#ifndef TGE_CONDITIONVARIABLE_HPP
+#define TGE_CONDITIONVARIABLE_HPP
+
+/*************************************/
+/**             Headers             **/
+/*************************************/
+#include <Tyrant/Config.hpp>
+#include <Tyrant/System/NonCopyable.hpp>
+#include <Tyrant/System/Time.hpp>
+
+
+namespace TGE
+{
+namespace priv
+{
+    class ConditionVariableImpl;
+}
+
+class Mutex;
+
+////////////////////////////////////////////////////////////
+/// \brief Lets threads sleep until another thread tells
+///        them that a condition may have changed
+///
+////////////////////////////////////////////////////////////
+class TGE_API ConditionVariable : NonCopyable
+{
+public :
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Default constructor
+    ///
+    ////////////////////////////////////////////////////////////
+    ConditionVariable();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Destructor
+    ///
+    ////////////////////////////////////////////////////////////
+    ~ConditionVariable();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Release a mutex and wait until the condition is
+    ///        notified, then lock the mutex again
+    ///
+    /// \a mutex must be locked exactly once by the calling thread.
+    /// The function may return without a notification (spurious
+    /// wake up), so the condition must always be checked again.
+    ///
+    /// \param mutex Mutex protecting the condition
+    ///
+    /// \see notifyOne, notifyAll
+    ///
+    ////////////////////////////////////////////////////////////
+    void wait(Mutex& mutex);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Release a mutex and wait until the condition is
+    ///        notified or a timeout expires, then lock the mutex
+    ///        again
+    ///
+    /// \param mutex   Mutex protecting the condition
+    /// \param timeout Maximum time to wait
+    ///
+    /// \return False if the timeout expired
+    ///
+    ////////////////////////////////////////////////////////////
+    bool wait(Mutex& mutex, Time timeout);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Wake up one of the threads waiting on the condition
+    ///
+    ////////////////////////////////////////////////////////////
+    void notifyOne();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Wake up all the threads waiting on the condition
+    ///
+    ////////////////////////////////////////////////////////////
+    void notifyAll();
+
+private :
+
+    ////////////////////////////////////////////////////////////
+    // Member data
+    ////////////////////////////////////////////////////////////
+    priv::ConditionVariableImpl* m_conditionImpl; ///< OS-specific implementation
+};
+
+} // namespace TGE
+
+
+#endif // TGE_CONDITIONVARIABLE_HPP
+
+
+////////////////////////////////////////////////////////////
+/// \class TGE::ConditionVariable
+/// \ingroup system
+///
+/// A condition variable is always used together with a
+/// TGE::Mutex that protects some shared state. A thread that
+/// needs the state to change locks the mutex, checks the state,
+/// and if needed calls wait(): the mutex is released while the
+/// thread sleeps, so that other threads can modify the state
+/// and call notifyOne() or notifyAll().
+///
+/// The condition must be checked in a loop, because wait() can
+/// return while the condition is still false (another thread
+/// may have been faster, or the system may wake up the thread
+/// for no reason).
+///
+/// Usage example:
+/// \code
+/// TGE::Mutex mutex(TGE::Mutex::NonRecursive);
+/// TGE::ConditionVariable notEmpty;
+/// std::queue<Message> messages;
+///
+/// void post(const Message& message)
+/// {
+///     TGE::Lock lock(mutex);
+///     messages.push(message);
+///     notEmpty.notifyOne();
+/// }
+///
+/// Message receive()
+/// {
+///     TGE::Lock lock(mutex);
+///     while (messages.empty())
+///         notEmpty.wait(mutex);
+///
+///     Message message = messages.front();
+///     messages.pop();
+///     return message;
+/// }
+/// \endcode
+///
+/// \see TGE::Mutex, TGE::Semaphore
+///
+////////////////////////////////////////////////////////////
@@ -0,0 +1,403 @@
+/*************************************/
+/** Copyright © 2014 Coldsnap Games **/
+/*************************************/
+
+#ifndef TGE_JOBSYSTEM_HPP
+#define TGE_JOBSYSTEM_HPP
+
+/*************************************/
+/**             Headers             **/
+/*************************************/
+#include <Tyrant/Config.hpp>
+#include <Tyrant/System/NonCopyable.hpp>
+#include <Tyrant/System/Mutex.hpp>
+#include <Tyrant/System/Semaphore.hpp>
+#include <Tyrant/System/ThreadLocalPtr.hpp>
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <new>
+#include <vector>
+
+
+namespace TGE
+{
+class JobSystem;
+
+namespace priv
+{
+    struct Job;
+    struct JobWorker;
+}
+
+////////////////////////////////////////////////////////////
+/// \brief Counter of unfinished jobs, that can be waited on
+///        or used as a dependency
+///
+////////////////////////////////////////////////////////////
+class TGE_API JobCounter : NonCopyable
+{
+public :
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Default constructor
+    ///
+    /// A new counter has no pending job, it is done.
+    ///
+    ////////////////////////////////////////////////////////////
+    JobCounter();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Destructor
+    ///
+    /// The counter must be done when it is destroyed.
+    ///
+    ////////////////////////////////////////////////////////////
+    ~JobCounter();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Tell whether all the jobs attached to the counter
+    ///        are finished
+    ///
+    /// Once this function returns true, the counter is no longer
+    /// used by the job system and can be destroyed or reused.
+    ///
+    /// \return True if there is no pending job
+    ///
+    ////////////////////////////////////////////////////////////
+    bool isDone() const;
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Get the number of unfinished jobs
+    ///
+    /// \return Number of jobs attached to the counter that are
+    ///         queued, running or waiting for a dependency
+    ///
+    ////////////////////////////////////////////////////////////
+    unsigned int getPendingCount() const;
+
+private :
+
+    friend class JobSystem;
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Acquire the lock protecting the continuations
+    ///
+    ////////////////////////////////////////////////////////////
+    void lock() const;
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Release the lock protecting the continuations
+    ///
+    ////////////////////////////////////////////////////////////
+    void unlock() const;
+
+    ////////////////////////////////////////////////////////////
+    // Member data
+    ////////////////////////////////////////////////////////////
+    std::atomic<unsigned int>  m_count;         ///< Number of unfinished jobs
+    mutable std::atomic<bool>  m_locked;        ///< Spin lock protecting the continuations
+    priv::Job*                 m_continuations; ///< Jobs to start when the counter reaches zero
+};
+
+
+////////////////////////////////////////////////////////////
+/// \brief Work-stealing scheduler running small jobs on a
+///        pool of threads
+///
+////////////////////////////////////////////////////////////
+class TGE_API JobSystem : NonCopyable
+{
+public :
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Default constructor
+    ///
+    /// Starts the worker threads. The thread that creates the
+    /// job system becomes its main thread: it doesn't run jobs
+    /// by itself, but it helps the workers while it waits (see
+    /// wait()).
+    ///
+    /// \param workerCount Number of worker threads to start, or 0
+    ///                    to use one per core, minus the main thread
+    ///
+    ////////////////////////////////////////////////////////////
+    explicit JobSystem(unsigned int workerCount = 0);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Destructor
+    ///
+    /// Waits until all the queued jobs are finished, then stops
+    /// the worker threads.
+    ///
+    ////////////////////////////////////////////////////////////
+    ~JobSystem();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Get the number of worker threads
+    ///
+    /// \return Number of worker threads, not including the main thread
+    ///
+    ////////////////////////////////////////////////////////////
+    unsigned int getWorkerCount() const;
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Queue a job
+    ///
+    /// \a function can be a free function, a functor or a lambda
+    /// taking no argument. It is copied into the job.
+    ///
+    /// \param function Function to run
+    /// \param counter  Counter to increment until the job is finished, or NULL
+    ///
+    ////////////////////////////////////////////////////////////
+    template <typename F>
+    void run(F function, JobCounter* counter = NULL);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Queue a job that starts once other jobs are finished
+    ///
+    /// The job is queued as soon as \a dependency is done, by the
+    /// thread that finished the last job attached to it (or
+    /// immediately, if it is already done).
+    ///
+    /// \param dependency Counter to wait for
+    /// \param function   Function to run
+    /// \param counter    Counter to increment until the job is finished, or NULL
+    ///
+    ////////////////////////////////////////////////////////////
+    template <typename F>
+    void runAfter(JobCounter& dependency, F function, JobCounter* counter = NULL);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Run a function over a range of indices in parallel,
+    ///        and wait until it is done
+    ///
+    /// The range [begin, end) is recursively split in halves until
+    /// the pieces are no larger than \a grainSize, so that idle
+    /// workers steal large pieces first. \a function is called with
+    /// the bounds of each piece: function(first, last).
+    ///
+    /// \param begin     First index of the range
+    /// \param end       One past the last index of the range
+    /// \param grainSize Maximum number of indices given to one call
+    /// \param function  Function to call on each piece
+    ///
+    ////////////////////////////////////////////////////////////
+    template <typename F>
+    void parallelFor(std::size_t begin, std::size_t end, std::size_t grainSize, F function);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Wait until a counter is done
+    ///
+    /// Instead of blocking, the calling thread runs queued jobs
+    /// until the counter reaches zero. It is therefore safe to
+    /// call this function from inside a job.
+    ///
+    /// \param counter Counter to wait for
+    ///
+    ////////////////////////////////////////////////////////////
+    void wait(JobCounter& counter);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Run at most one queued job on the calling thread
+    ///
+    /// This lets the main thread help the workers, for example
+    /// while it waits for something else than a counter.
+    ///
+    /// \return True if a job was run
+    ///
+    ////////////////////////////////////////////////////////////
+    bool runPendingJob();
+
+private :
+
+    friend struct priv::JobWorker;
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Create a job running a function
+    ///
+    /// \param function Function to run
+    ///
+    /// \return New job, to release with releaseJob()
+    ///
+    ////////////////////////////////////////////////////////////
+    template <typename F>
+    priv::Job* createJob(F function);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Allocate the memory of a job
+    ///
+    /// Jobs up to priv::JobBlockSize bytes created by a thread of
+    /// the job system come from the pool of its worker, the
+    /// others are allocated with new.
+    ///
+    /// \param size Size of the job, in bytes
+    /// \param pool Filled with the worker owning the block, or
+    ///             NULL if it was allocated with new
+    ///
+    /// \return Memory of the job
+    ///
+    ////////////////////////////////////////////////////////////
+    void* allocateJob(std::size_t size, priv::JobWorker*& pool);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Destroy a job and give its memory back
+    ///
+    /// A block released by another thread than the owner of its
+    /// pool is handed back to the owner without any lock.
+    ///
+    /// \param job Job to release
+    ///
+    ////////////////////////////////////////////////////////////
+    void releaseJob(priv::Job* job);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Attach a job to its counter and queue it
+    ///
+    /// \param job Job to queue
+    ///
+    ////////////////////////////////////////////////////////////
+    void submit(priv::Job* job);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Attach a job to its counter and queue it once
+    ///        a dependency is done
+    ///
+    /// \param dependency Counter to wait for
+    /// \param job        Job to queue
+    ///
+    ////////////////////////////////////////////////////////////
+    void submitAfter(JobCounter& dependency, priv::Job* job);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Queue a job, on the queue of the calling thread if
+    ///        it belongs to the job system
+    ///
+    /// \param job Job to queue
+    ///
+    ////////////////////////////////////////////////////////////
+    void push(priv::Job* job);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Take a job to run: from the queue of the calling
+    ///        thread first, then from the shared queue, then by
+    ///        stealing from the other threads
+    ///
+    /// \return Job to run, or NULL if none was found
+    ///
+    ////////////////////////////////////////////////////////////
+    priv::Job* pop();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Run a job, then release it and update its counter
+    ///
+    /// \param job Job to run
+    ///
+    ////////////////////////////////////////////////////////////
+    void execute(priv::Job* job);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Entry point of the worker threads
+    ///
+    /// \param worker Worker running on the thread
+    ///
+    ////////////////////////////////////////////////////////////
+    void workerLoop(priv::JobWorker* worker);
+
+    ////////////////////////////////////////////////////////////
+    // Member data
+    ////////////////////////////////////////////////////////////
+    std::vector<priv::JobWorker*>  m_workers;       ///< Main thread (first) and worker threads
+    ThreadLocalPtr<priv::JobWorker> m_localWorker;  ///< Worker of the calling thread, NULL for foreign threads
+    std::deque<priv::Job*>         m_sharedQueue;   ///< Jobs queued by foreign threads
+    Mutex                          m_sharedMutex;   ///< Mutex protecting the shared queue
+    std::atomic<unsigned int>      m_sharedCount;   ///< Size of the shared queue, readable without the mutex
+    Semaphore                      m_wakeUp;        ///< Posted to wake up idle workers
+    std::atomic<unsigned int>      m_sleeping;      ///< Number of workers blocked on m_wakeUp
+    std::atomic<bool>              m_running;       ///< False when the workers must exit
+};
+
+#include <Tyrant/System/JobSystem.inl>
+
+} // namespace TGE
+
+
+#endif // TGE_JOBSYSTEM_HPP
+
+
+////////////////////////////////////////////////////////////
+/// \class TGE::JobSystem
+/// \ingroup system
+///
+/// TGE::JobSystem spreads small pieces of work (jobs) over all
+/// the cores, without creating a thread per task like
+/// TGE::Thread does. A fixed set of worker threads is started
+/// once, and each of them owns a queue of jobs.
+///
+/// A job queued from a worker goes to that worker's queue, where
+/// it is likely to be run next while its data is still in cache.
+/// A worker that runs out of jobs steals the oldest job of
+/// another thread's queue, so that the load balances itself
+/// without any central lock. Workers that find nothing to do go
+/// to sleep, and are woken up when new jobs are queued.
+///
+/// Jobs are grouped with TGE::JobCounter: a counter attached to
+/// jobs is incremented when they are queued and decremented when
+/// they finish. It can be waited on with wait(), or used as a
+/// dependency with runAfter() to chain jobs without blocking any
+/// thread.
+///
+/// wait() doesn't block: the waiting thread runs jobs until the
+/// counter is done. This is how the main thread takes part in
+/// the work, and why jobs can wait for other jobs without
+/// deadlocking the pool.
+///
+/// The jobs themselves are allocated from a pool owned by the
+/// thread queueing them, so queueing a small job doesn't touch
+/// the heap once the pool has grown to its working size.
+///
+/// Jobs must not throw exceptions.
+///
+/// Usage example:
+/// \code
+/// TGE::JobSystem jobs;
+///
+/// // Update all the particles, in pieces of 256
+/// jobs.parallelFor(0, particles.size(), 256, [&](std::size_t first, std::size_t last)
+/// {
+///     for (std::size_t i = first; i < last; ++i)
+///         particles[i].update(dt);
+/// });
+///
+/// // Load two files in parallel, then build the level
+/// TGE::JobCounter loading;
+/// jobs.run([&]() {terrain.load("terrain.dat");}, &loading);
+/// jobs.run([&]() {props.load("props.dat");}, &loading);
+///
+/// TGE::JobCounter building;
+/// jobs.runAfter(loading, [&]() {level.build(terrain, props);}, &building);
+///
+/// jobs.wait(building); // runs jobs while waiting
+/// \endcode
+///
+/// \see TGE::JobCounter, TGE::Thread
+///
+////////////////////////////////////////////////////////////
+
+
+////////////////////////////////////////////////////////////
+/// \class TGE::JobCounter
+/// \ingroup system
+///
+/// A TGE::JobCounter counts the unfinished jobs attached to it.
+/// Pass it to TGE::JobSystem::run() or parallelFor() to group
+/// jobs, then wait for them with TGE::JobSystem::wait(), or
+/// start other jobs once they are finished with
+/// TGE::JobSystem::runAfter().
+///
+/// A counter can be reused once it is done.
+///
+/// \see TGE::JobSystem
+///
+////////////////////////////////////////////////////////////
@@ -0,0 +1,120 @@
+/*************************************/
+/** Copyright © 2014 Coldsnap Games **/
+/*************************************/
+
+namespace priv
+{
+// Size of the blocks of the job pools; larger jobs are allocated with new
+enum {JobBlockSize = 128};
+
+// Base class for abstract jobs
+struct Job
+{
+    Job() : counter(NULL), next(NULL), pool(NULL) {}
+    virtual ~Job() {}
+    virtual void run() = 0;
+    JobCounter* counter; // Counter to decrement when the job is finished
+    Job*        next;    // Next job waiting on the same dependency
+    JobWorker*  pool;    // Worker whose pool holds the job, NULL if it was allocated with new
+};
+
+// Specialization using a functor (including free functions and lambdas) with no argument
+template <typename T>
+struct JobFunctor : Job
+{
+    JobFunctor(T functor) : m_functor(functor) {}
+    virtual void run() {m_functor();}
+    T m_functor;
+};
+
+// Piece of a parallelFor range, splitting itself into smaller jobs
+template <typename F>
+struct ParallelForRange
+{
+    void operator()()
+    {
+        // Queue the upper half until the piece is small enough,
+        // the largest pieces are the first ones to be stolen
+        while (end - begin > grainSize)
+        {
+            std::size_t middle = begin + (end - begin) / 2;
+
+            ParallelForRange<F> upper = *this;
+            upper.begin = middle;
+            system->run(upper, counter);
+
+            end = middle;
+        }
+
+        (*function)(begin, end);
+    }
+
+    JobSystem*  system;
+    std::size_t begin;
+    std::size_t end;
+    std::size_t grainSize;
+    F*          function;
+    JobCounter* counter;
+};
+
+} // namespace priv
+
+
+////////////////////////////////////////////////////////////
+template <typename F>
+void JobSystem::run(F function, JobCounter* counter)
+{
+    priv::Job* job = createJob(function);
+    job->counter = counter;
+
+    submit(job);
+}
+
+
+////////////////////////////////////////////////////////////
+template <typename F>
+void JobSystem::runAfter(JobCounter& dependency, F function, JobCounter* counter)
+{
+    priv::Job* job = createJob(function);
+    job->counter = counter;
+
+    submitAfter(dependency, job);
+}
+
+
+////////////////////////////////////////////////////////////
+template <typename F>
+void JobSystem::parallelFor(std::size_t begin, std::size_t end, std::size_t grainSize, F function)
+{
+    if (begin >= end)
+        return;
+
+    JobCounter counter;
+
+    priv::ParallelForRange<F> range;
+    range.system    = this;
+    range.begin     = begin;
+    range.end       = end;
+    range.grainSize = grainSize > 0 ? grainSize : 1;
+    range.function  = &function;
+    range.counter   = &counter;
+
+    // The calling thread splits the range and processes the first piece itself
+    range();
+
+    wait(counter);
+}
+
+
+////////////////////////////////////////////////////////////
+template <typename F>
+priv::Job* JobSystem::createJob(F function)
+{
+    priv::JobWorker* pool = NULL;
+    void* block = allocateJob(sizeof(priv::JobFunctor<F>), pool);
+
+    priv::Job* job = new (block) priv::JobFunctor<F>(function);
+    job->pool = pool;
+
+    return job;
+}
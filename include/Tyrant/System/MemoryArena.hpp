@@ -0,0 +1,160 @@
+/*************************************/
+/** Copyright © 2014 Coldsnap Games **/
+/*************************************/
+
+#ifndef TGE_MEMORYARENA_HPP
+#define TGE_MEMORYARENA_HPP
+
+/*************************************/
+/**             Headers             **/
+/*************************************/
+#include <Tyrant/Config.hpp>
+#include <Tyrant/System/NonCopyable.hpp>
+#include <cstddef>
+#include <vector>
+
+
+namespace TGE
+{
+////////////////////////////////////////////////////////////
+/// \brief Linear allocator whose memory is released all at
+///        once
+///
+////////////////////////////////////////////////////////////
+class TGE_API MemoryArena : NonCopyable
+{
+public :
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Construct the arena
+    ///
+    /// \param capacity Initial size of the buffer, in bytes
+    ///
+    ////////////////////////////////////////////////////////////
+    explicit MemoryArena(std::size_t capacity = 65536);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Destructor
+    ///
+    ////////////////////////////////////////////////////////////
+    ~MemoryArena();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Allocate a block of memory
+    ///
+    /// The block is valid until the next call to reset(); it
+    /// can't be released individually.
+    ///
+    /// \param size      Size of the block, in bytes
+    /// \param alignment Alignment of the block, must be a power of two
+    ///
+    /// \return Pointer to the block
+    ///
+    ////////////////////////////////////////////////////////////
+    void* allocate(std::size_t size, std::size_t alignment = 16);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Release all the allocated blocks
+    ///
+    /// If the buffer was too small since the last reset, it is
+    /// enlarged so that the same allocations fit next time.
+    ///
+    ////////////////////////////////////////////////////////////
+    void reset();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Get the size of the buffer
+    ///
+    /// \return Capacity of the arena, in bytes
+    ///
+    ////////////////////////////////////////////////////////////
+    std::size_t getCapacity() const;
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Get the amount of memory allocated since the last
+    ///        reset
+    ///
+    /// \return Allocated size, in bytes, including the blocks
+    ///         that didn't fit in the buffer
+    ///
+    ////////////////////////////////////////////////////////////
+    std::size_t getUsedSize() const;
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Get the frame arena of the calling thread
+    ///
+    /// The arena is created the first time a thread asks for
+    /// it. The arena of the thread calling Window::display() is
+    /// reset there; other threads must reset theirs themselves.
+    ///
+    /// \return Frame arena of the calling thread
+    ///
+    ////////////////////////////////////////////////////////////
+    static MemoryArena& getFrameArena();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Destroy the frame arena of the calling thread
+    ///
+    /// TGE::Thread calls it when its function returns. Threads
+    /// started another way must call it before they end,
+    /// otherwise their arena is only destroyed at the exit of
+    /// the program. A later call to getFrameArena() creates a
+    /// new arena.
+    ///
+    ////////////////////////////////////////////////////////////
+    static void releaseFrameArena();
+
+private :
+
+    ////////////////////////////////////////////////////////////
+    // Member data
+    ////////////////////////////////////////////////////////////
+    char*              m_buffer;       ///< Memory shared by the blocks
+    std::size_t        m_capacity;     ///< Size of the buffer
+    std::size_t        m_offset;       ///< Offset of the free space in the buffer
+    std::vector<void*> m_overflow;     ///< Blocks that didn't fit in the buffer
+    std::size_t        m_overflowSize; ///< Total size of the overflow blocks
+};
+
+} // namespace TGE
+
+
+#endif // TGE_MEMORYARENA_HPP
+
+
+////////////////////////////////////////////////////////////
+/// \class TGE::MemoryArena
+/// \ingroup system
+///
+/// TGE::MemoryArena hands out memory by moving an offset in a
+/// buffer allocated once, which is much cheaper than going
+/// through the heap. The blocks can't be freed one by one:
+/// they are all released by reset(). This fits temporaries
+/// that live for a frame or less, like the sorted list of
+/// drawables built by TGE::Game each frame.
+///
+/// When the buffer is full, the blocks are allocated on the
+/// heap, and the buffer is enlarged by the next reset(). A
+/// program doing the same work every frame therefore stops
+/// allocating after its first frames.
+///
+/// Each thread has its own frame arena, returned by
+/// getFrameArena(), which is reset at the end of the frame
+/// and destroyed when the thread ends.
+/// Memory from an arena can be used by standard containers
+/// through TGE::ArenaAllocator.
+///
+/// An arena is not thread-safe: only one thread may use it
+/// at a time.
+///
+/// Usage example:
+/// \code
+/// TGE::MemoryArena& arena = TGE::MemoryArena::getFrameArena();
+///
+/// // Valid until the end of the frame
+/// Particle** visible = static_cast<Particle**>(arena.allocate(count * sizeof(Particle*)));
+/// \endcode
+///
+/// \see TGE::ArenaAllocator, TGE::MemoryPool
+///
+////////////////////////////////////////////////////////////
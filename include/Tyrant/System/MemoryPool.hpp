@@ -0,0 +1,149 @@
+/*************************************/
+/** Copyright © 2014 Coldsnap Games **/
+/*************************************/
+
+#ifndef TGE_MEMORYPOOL_HPP
+#define TGE_MEMORYPOOL_HPP
+
+/*************************************/
+/**             Headers             **/
+/*************************************/
+#include <Tyrant/Config.hpp>
+#include <Tyrant/System/NonCopyable.hpp>
+#include <cstddef>
+#include <vector>
+
+
+namespace TGE
+{
+////////////////////////////////////////////////////////////
+/// \brief Allocator of memory blocks which all have the
+///        same size
+///
+////////////////////////////////////////////////////////////
+class TGE_API MemoryPool : NonCopyable
+{
+public :
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Construct the pool
+    ///
+    /// No memory is allocated until the first block is requested.
+    ///
+    /// \param blockSize      Size of each block, in bytes
+    /// \param blocksPerChunk Number of blocks allocated at once
+    ///                       when the pool is empty
+    ///
+    ////////////////////////////////////////////////////////////
+    explicit MemoryPool(std::size_t blockSize, std::size_t blocksPerChunk = 64);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Destructor
+    ///
+    /// Releases all the memory of the pool, including the
+    /// blocks that were not deallocated.
+    ///
+    ////////////////////////////////////////////////////////////
+    ~MemoryPool();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Get a block from the pool
+    ///
+    /// The block is aligned for any fundamental type.
+    ///
+    /// \return Pointer to the block
+    ///
+    /// \see deallocate
+    ///
+    ////////////////////////////////////////////////////////////
+    void* allocate();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Give a block back to the pool
+    ///
+    /// \param block Block returned by allocate(), or NULL
+    ///
+    /// \see allocate
+    ///
+    ////////////////////////////////////////////////////////////
+    void deallocate(void* block);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Get the size of the blocks
+    ///
+    /// It may be larger than the size requested in the
+    /// constructor, because of alignment.
+    ///
+    /// \return Size of each block, in bytes
+    ///
+    ////////////////////////////////////////////////////////////
+    std::size_t getBlockSize() const;
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Get the number of blocks currently allocated
+    ///
+    /// \return Number of blocks not given back to the pool
+    ///
+    ////////////////////////////////////////////////////////////
+    std::size_t getAllocatedCount() const;
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Get the total number of blocks owned by the pool
+    ///
+    /// \return Number of blocks, allocated or free
+    ///
+    ////////////////////////////////////////////////////////////
+    std::size_t getCapacity() const;
+
+private :
+
+    ////////////////////////////////////////////////////////////
+    // Member data
+    ////////////////////////////////////////////////////////////
+    std::size_t        m_blockSize;      ///< Size of each block
+    std::size_t        m_blocksPerChunk; ///< Number of blocks in each chunk
+    void*              m_freeList;       ///< First free block, each free block points to the next one
+    std::vector<char*> m_chunks;         ///< Memory of the blocks
+    std::size_t        m_allocated;      ///< Number of blocks in use
+};
+
+} // namespace TGE
+
+
+#endif // TGE_MEMORYPOOL_HPP
+
+
+////////////////////////////////////////////////////////////
+/// \class TGE::MemoryPool
+/// \ingroup system
+///
+/// TGE::MemoryPool serves blocks of a single size from large
+/// chunks, and keeps freed blocks in a list for reuse. Both
+/// allocate() and deallocate() take constant time and don't
+/// touch the heap once the pool holds enough blocks.
+///
+/// Pools suit objects which are created and destroyed all the
+/// time, like particles, projectiles or network messages. The
+/// memory of a pool is only released by its destructor.
+///
+/// A pool is not thread-safe: only one thread may use it at a
+/// time.
+///
+/// TGE::ObjectPool wraps a pool to construct and destroy
+/// objects of a given type, and TGE::PoolAllocator makes node
+/// based containers (std::list, std::map...) use a pool.
+///
+/// Usage example:
+/// \code
+/// TGE::MemoryPool pool(sizeof(Message));
+///
+/// void* block = pool.allocate();
+/// Message* message = new (block) Message;
+/// ...
+/// message->~Message();
+/// pool.deallocate(message);
+/// \endcode
+///
+/// \see TGE::ObjectPool, TGE::PoolAllocator, TGE::MemoryArena
+///
+////////////////////////////////////////////////////////////
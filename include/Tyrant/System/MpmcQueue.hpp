@@ -0,0 +1,136 @@
+/*************************************/
+/** Copyright © 2014 Coldsnap Games **/
+/*************************************/
+
+#ifndef TGE_MPMCQUEUE_HPP
+#define TGE_MPMCQUEUE_HPP
+
+/*************************************/
+/**             Headers             **/
+/*************************************/
+#include <Tyrant/Config.hpp>
+#include <Tyrant/System/NonCopyable.hpp>
+#include <atomic>
+#include <cstddef>
+
+
+namespace TGE
+{
+////////////////////////////////////////////////////////////
+/// \brief Bounded lock-free queue for any number of
+///        producer and consumer threads
+///
+////////////////////////////////////////////////////////////
+template <typename T>
+class MpmcQueue : NonCopyable
+{
+public :
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Construct the queue
+    ///
+    /// \param capacity Maximum number of elements, rounded up to
+    ///                 a power of two
+    ///
+    ////////////////////////////////////////////////////////////
+    explicit MpmcQueue(std::size_t capacity);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Destructor
+    ///
+    ////////////////////////////////////////////////////////////
+    ~MpmcQueue();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Add an element at the end of the queue
+    ///
+    /// \param value Element to copy into the queue
+    ///
+    /// \return False if the queue is full
+    ///
+    ////////////////////////////////////////////////////////////
+    bool push(const T& value);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Remove the element at the front of the queue
+    ///
+    /// \param value Variable to fill with the removed element
+    ///
+    /// \return False if the queue is empty
+    ///
+    ////////////////////////////////////////////////////////////
+    bool pop(T& value);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Get the maximum number of elements in the queue
+    ///
+    /// \return Capacity of the queue
+    ///
+    ////////////////////////////////////////////////////////////
+    std::size_t getCapacity() const;
+
+private :
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Element of the queue, with its sequence number
+    ///
+    ////////////////////////////////////////////////////////////
+    struct Cell
+    {
+        std::atomic<std::size_t> sequence; ///< Position that the cell is ready for
+        T                        value;    ///< Stored element
+    };
+
+    ////////////////////////////////////////////////////////////
+    // Member data
+    ////////////////////////////////////////////////////////////
+    Cell*                    m_cells;        ///< Circular storage of the elements
+    std::size_t              m_mask;         ///< Capacity minus one, to wrap the positions
+    char                     m_padding1[64]; ///< Keeps the positions on their own cache lines
+    std::atomic<std::size_t> m_pushPosition; ///< Position of the next element to push
+    char                     m_padding2[64]; ///< Keeps the positions on their own cache lines
+    std::atomic<std::size_t> m_popPosition;  ///< Position of the next element to pop
+};
+
+#include <Tyrant/System/MpmcQueue.inl>
+
+} // namespace TGE
+
+
+#endif // TGE_MPMCQUEUE_HPP
+
+
+////////////////////////////////////////////////////////////
+/// \class TGE::MpmcQueue
+/// \ingroup system
+///
+/// TGE::MpmcQueue is a first-in first-out queue that any number
+/// of threads can push to and pop from concurrently, without
+/// locks. Each cell of the queue carries a sequence number that
+/// tells whether it is ready to be written or read; threads
+/// claim a position with a single compare-and-swap, and only
+/// retry when another thread claimed the same position first.
+///
+/// The queue has a fixed capacity: push() fails when it is full
+/// and pop() fails when it is empty, neither ever blocks. T
+/// must be default-constructible and copyable.
+///
+/// When there is only one producer and one consumer,
+/// TGE::SpscQueue is cheaper.
+///
+/// Usage example:
+/// \code
+/// TGE::MpmcQueue<Message> messages(1024);
+///
+/// // Any thread
+/// messages.push(message);
+///
+/// // Any thread
+/// Message message;
+/// while (messages.pop(message))
+///     handle(message);
+/// \endcode
+///
+/// \see TGE::SpscQueue
+///
+////////////////////////////////////////////////////////////
@@ -0,0 +1,112 @@
+/*************************************/
+/** Copyright © 2014 Coldsnap Games **/
+/*************************************/
+
+
+////////////////////////////////////////////////////////////
+template <typename T>
+MpmcQueue<T>::MpmcQueue(std::size_t capacity) :
+m_cells       (NULL),
+m_mask        (1),
+m_pushPosition(0),
+m_popPosition (0)
+{
+    while (m_mask + 1 < capacity)
+        m_mask = (m_mask << 1) | 1;
+
+    m_cells = new Cell[m_mask + 1];
+    for (std::size_t i = 0; i <= m_mask; ++i)
+        m_cells[i].sequence.store(i, std::memory_order_relaxed);
+}
+
+
+////////////////////////////////////////////////////////////
+template <typename T>
+MpmcQueue<T>::~MpmcQueue()
+{
+    delete[] m_cells;
+}
+
+
+////////////////////////////////////////////////////////////
+template <typename T>
+bool MpmcQueue<T>::push(const T& value)
+{
+    Cell* cell;
+    std::size_t position = m_pushPosition.load(std::memory_order_relaxed);
+    for (;;)
+    {
+        cell = &m_cells[position & m_mask];
+        std::size_t sequence = cell->sequence.load(std::memory_order_acquire);
+        std::ptrdiff_t difference = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position);
+
+        if (difference == 0)
+        {
+            // The cell is free: claim it
+            if (m_pushPosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                break;
+        }
+        else if (difference < 0)
+        {
+            // The cell still holds an element from the previous lap: full
+            return false;
+        }
+        else
+        {
+            // Another producer claimed this position
+            position = m_pushPosition.load(std::memory_order_relaxed);
+        }
+    }
+
+    cell->value = value;
+    cell->sequence.store(position + 1, std::memory_order_release);
+
+    return true;
+}
+
+
+////////////////////////////////////////////////////////////
+template <typename T>
+bool MpmcQueue<T>::pop(T& value)
+{
+    Cell* cell;
+    std::size_t position = m_popPosition.load(std::memory_order_relaxed);
+    for (;;)
+    {
+        cell = &m_cells[position & m_mask];
+        std::size_t sequence = cell->sequence.load(std::memory_order_acquire);
+        std::ptrdiff_t difference = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position + 1);
+
+        if (difference == 0)
+        {
+            // The cell holds an element: claim it
+            if (m_popPosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                break;
+        }
+        else if (difference < 0)
+        {
+            // The cell hasn't been written yet: empty
+            return false;
+        }
+        else
+        {
+            // Another consumer claimed this position
+            position = m_popPosition.load(std::memory_order_relaxed);
+        }
+    }
+
+    value = cell->value;
+
+    // Make the cell available to the producers of the next lap
+    cell->sequence.store(position + m_mask + 1, std::memory_order_release);
+
+    return true;
+}
+
+
+////////////////////////////////////////////////////////////
+template <typename T>
+std::size_t MpmcQueue<T>::getCapacity() const
+{
+    return m_mask + 1;
+}
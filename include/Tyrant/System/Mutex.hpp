@@ -10,6 +10,7 @@
 /*************************************/
 #include <Tyrant/Config.hpp>
 #include <Tyrant/System/NonCopyable.hpp>
+#include <atomic>
 
 
 namespace TGE
@@ -28,11 +29,24 @@ class TGE_API Mutex : NonCopyable
 {
 public :
 
+    ////////////////////////////////////////////////////////////
+    /// \brief Behaviour of a mutex locked again by its owner thread
+    ///
+    ////////////////////////////////////////////////////////////
+    enum Type
+    {
+        Recursive,   ///< The owner thread can lock the mutex again, it must unlock it as many times
+        NonRecursive ///< Locking the mutex again from its owner thread deadlocks, but locking is cheaper
+    };
+
     ////////////////////////////////////////////////////////////
     /// \brief Default constructor
     ///
+    /// \param type Behaviour of the mutex when its owner thread
+    ///             locks it again
+    ///
     ////////////////////////////////////////////////////////////
-    Mutex();
+    explicit Mutex(Type type = Recursive);
 
     ////////////////////////////////////////////////////////////
     /// \brief Destructor
@@ -52,6 +66,17 @@ public :
     ////////////////////////////////////////////////////////////
     void lock();
 
+    ////////////////////////////////////////////////////////////
+    /// \brief Lock the mutex if it is available
+    ///
+    /// \return True if the mutex was locked, false if another
+    ///         thread owns it
+    ///
+    /// \see lock, unlock
+    ///
+    ////////////////////////////////////////////////////////////
+    bool tryLock();
+
     ////////////////////////////////////////////////////////////
     /// \brief Unlock the mutex
     ///
@@ -60,12 +85,27 @@ public :
     ////////////////////////////////////////////////////////////
     void unlock();
 
+    ////////////////////////////////////////////////////////////
+    /// \brief Get the number of times lock() had to wait for
+    ///        another thread
+    ///
+    /// A high count compared to the number of locks means that
+    /// the mutex is a bottleneck.
+    ///
+    /// \return Number of contended calls to lock()
+    ///
+    ////////////////////////////////////////////////////////////
+    unsigned int getContentionCount() const;
+
 private :
 
+    friend class ConditionVariable;
+
     ////////////////////////////////////////////////////////////
     // Member data
     ////////////////////////////////////////////////////////////
-    priv::MutexImpl* m_mutexImpl; ///< OS-specific implementation
+    priv::MutexImpl*          m_mutexImpl;       ///< OS-specific implementation
+    std::atomic<unsigned int> m_contentionCount; ///< Number of contended calls to lock()
 };
 
 } // namespace TGE
@@ -116,13 +156,21 @@ private :
 /// environments where exceptions can be thrown, you should
 /// use the helper class TGE::Lock to lock/unlock mutexes.
 ///
-/// TGE mutexes are recursive, which means that you can lock
+/// TGE mutexes are recursive by default, which means that you can lock
 /// a mutex multiple times in the same thread without creating
 /// a deadlock. In this case, the first call to lock() behaves
 /// as usual, and the following ones have no effect.
 /// However, you must call unlock() exactly as many times as you
 /// called lock(). If you don't, the mutex won't be released.
+/// Code that never locks a mutex twice should create it with
+/// TGE::Mutex::NonRecursive, which is cheaper (on Windows, all
+/// mutexes are recursive).
+///
+/// For very short critical sections, TGE::SpinMutex avoids
+/// putting the thread to sleep at all in most cases. When most
+/// accesses only read the shared data, TGE::ReadWriteLock lets
+/// the readers run in parallel.
 ///
-/// \see TGE::Lock
+/// \see TGE::Lock, TGE::SpinMutex, TGE::ReadWriteLock, TGE::ConditionVariable
 ///
 ////////////////////////////////////////////////////////////
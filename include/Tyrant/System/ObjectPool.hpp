@@ -0,0 +1,111 @@
+/*************************************/
+/** Copyright © 2014 Coldsnap Games **/
+/*************************************/
+
+#ifndef TGE_OBJECTPOOL_HPP
+#define TGE_OBJECTPOOL_HPP
+
+/*************************************/
+/**             Headers             **/
+/*************************************/
+#include <Tyrant/Config.hpp>
+#include <Tyrant/System/MemoryPool.hpp>
+#include <Tyrant/System/NonCopyable.hpp>
+#include <new>
+#include <utility>
+
+
+namespace TGE
+{
+////////////////////////////////////////////////////////////
+/// \brief Creates and destroys objects of a given type in a
+///        memory pool
+///
+////////////////////////////////////////////////////////////
+template <typename T>
+class ObjectPool : NonCopyable
+{
+public :
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Construct the pool
+    ///
+    /// \param objectsPerChunk Number of objects for which memory
+    ///                        is allocated at once
+    ///
+    ////////////////////////////////////////////////////////////
+    explicit ObjectPool(std::size_t objectsPerChunk = 64);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Construct a new object in the pool
+    ///
+    /// \param args Arguments passed to the constructor of T
+    ///
+    /// \return Pointer to the new object
+    ///
+    /// \see destroy
+    ///
+    ////////////////////////////////////////////////////////////
+    template <typename... Args>
+    T* create(Args&&... args);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Destroy an object created by this pool
+    ///
+    /// \param object Object to destroy, or NULL
+    ///
+    /// \see create
+    ///
+    ////////////////////////////////////////////////////////////
+    void destroy(T* object);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Get the number of living objects
+    ///
+    /// \return Number of objects created and not destroyed yet
+    ///
+    ////////////////////////////////////////////////////////////
+    std::size_t getSize() const;
+
+private :
+
+    ////////////////////////////////////////////////////////////
+    // Member data
+    ////////////////////////////////////////////////////////////
+    MemoryPool m_pool; ///< Memory of the objects
+};
+
+#include <Tyrant/System/ObjectPool.inl>
+
+} // namespace TGE
+
+
+#endif // TGE_OBJECTPOOL_HPP
+
+
+////////////////////////////////////////////////////////////
+/// \class TGE::ObjectPool
+/// \ingroup system
+///
+/// TGE::ObjectPool replaces new and delete for objects that
+/// are created and destroyed at a high rate. Their memory
+/// comes from a TGE::MemoryPool, so that once the pool has
+/// grown to the peak number of objects, creating an object
+/// costs no heap allocation.
+///
+/// The objects must all be destroyed before the pool: its
+/// destructor releases the memory without calling their
+/// destructors.
+///
+/// Usage example:
+/// \code
+/// TGE::ObjectPool<Bullet> bullets;
+///
+/// Bullet* bullet = bullets.create(position, velocity);
+/// ...
+/// bullets.destroy(bullet);
+/// \endcode
+///
+/// \see TGE::MemoryPool
+///
+////////////////////////////////////////////////////////////
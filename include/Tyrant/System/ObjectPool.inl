@@ -0,0 +1,40 @@
+/*************************************/
+/** Copyright © 2014 Coldsnap Games **/
+/*************************************/
+
+
+////////////////////////////////////////////////////////////
+template <typename T>
+ObjectPool<T>::ObjectPool(std::size_t objectsPerChunk) :
+m_pool(sizeof(T), objectsPerChunk)
+{
+}
+
+
+////////////////////////////////////////////////////////////
+template <typename T>
+template <typename... Args>
+T* ObjectPool<T>::create(Args&&... args)
+{
+    return new (m_pool.allocate()) T(std::forward<Args>(args)...);
+}
+
+
+////////////////////////////////////////////////////////////
+template <typename T>
+void ObjectPool<T>::destroy(T* object)
+{
+    if (object)
+    {
+        object->~T();
+        m_pool.deallocate(object);
+    }
+}
+
+
+////////////////////////////////////////////////////////////
+template <typename T>
+std::size_t ObjectPool<T>::getSize() const
+{
+    return m_pool.getAllocatedCount();
+}
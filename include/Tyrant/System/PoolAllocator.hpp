@@ -0,0 +1,182 @@
+/*************************************/
+/** Copyright © 2014 Coldsnap Games **/
+/*************************************/
+
+#ifndef TGE_POOLALLOCATOR_HPP
+#define TGE_POOLALLOCATOR_HPP
+
+/*************************************/
+/**             Headers             **/
+/*************************************/
+#include <Tyrant/Config.hpp>
+#include <Tyrant/System/MemoryPool.hpp>
+#include <cstddef>
+#include <new>
+
+
+namespace TGE
+{
+////////////////////////////////////////////////////////////
+/// \brief Standard allocator taking the memory of single
+///        elements from a TGE::MemoryPool
+///
+////////////////////////////////////////////////////////////
+template <typename T>
+class PoolAllocator
+{
+public :
+
+    typedef T              value_type;
+    typedef T*             pointer;
+    typedef const T*       const_pointer;
+    typedef T&             reference;
+    typedef const T&       const_reference;
+    typedef std::size_t    size_type;
+    typedef std::ptrdiff_t difference_type;
+
+    template <typename U>
+    struct rebind
+    {
+        typedef PoolAllocator<U> other;
+    };
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Construct the allocator from a pool
+    ///
+    /// \param pool Pool to allocate from, must outlive the
+    ///             allocator and its copies
+    ///
+    ////////////////////////////////////////////////////////////
+    explicit PoolAllocator(MemoryPool& pool);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Construct the allocator from an allocator of
+    ///        another type
+    ///
+    /// \param other Allocator to copy the pool from
+    ///
+    ////////////////////////////////////////////////////////////
+    template <typename U>
+    PoolAllocator(const PoolAllocator<U>& other);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Allocate memory for an array of elements
+    ///
+    /// Single elements which fit in the blocks of the pool come
+    /// from the pool, anything else from the heap.
+    ///
+    /// \param count Number of elements
+    ///
+    /// \return Pointer to the first element
+    ///
+    ////////////////////////////////////////////////////////////
+    pointer allocate(size_type count, const void* hint = 0);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Release an array of elements
+    ///
+    ////////////////////////////////////////////////////////////
+    void deallocate(pointer elements, size_type count);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Get the maximum number of elements that can be
+    ///        allocated
+    ///
+    ////////////////////////////////////////////////////////////
+    size_type max_size() const;
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Construct an element in allocated memory
+    ///
+    ////////////////////////////////////////////////////////////
+    void construct(pointer element, const T& value);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Destroy an element without releasing its memory
+    ///
+    ////////////////////////////////////////////////////////////
+    void destroy(pointer element);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Get the address of an element
+    ///
+    ////////////////////////////////////////////////////////////
+    pointer address(reference element) const;
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Get the address of a constant element
+    ///
+    ////////////////////////////////////////////////////////////
+    const_pointer address(const_reference element) const;
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Get the pool of the allocator
+    ///
+    /// \return Pool used to allocate single elements
+    ///
+    ////////////////////////////////////////////////////////////
+    MemoryPool& getPool() const;
+
+private :
+
+    ////////////////////////////////////////////////////////////
+    // Member data
+    ////////////////////////////////////////////////////////////
+    MemoryPool* m_pool; ///< Pool to allocate single elements from
+};
+
+////////////////////////////////////////////////////////////
+/// \relates PoolAllocator
+/// \brief Overload of binary operator == to compare two allocators
+///
+/// \return True if both allocators use the same pool
+///
+////////////////////////////////////////////////////////////
+template <typename T, typename U>
+bool operator ==(const PoolAllocator<T>& left, const PoolAllocator<U>& right);
+
+////////////////////////////////////////////////////////////
+/// \relates PoolAllocator
+/// \brief Overload of binary operator != to compare two allocators
+///
+/// \return True if the allocators use different pools
+///
+////////////////////////////////////////////////////////////
+template <typename T, typename U>
+bool operator !=(const PoolAllocator<T>& left, const PoolAllocator<U>& right);
+
+#include <Tyrant/System/PoolAllocator.inl>
+
+} // namespace TGE
+
+
+#endif // TGE_POOLALLOCATOR_HPP
+
+
+////////////////////////////////////////////////////////////
+/// \class TGE::PoolAllocator
+/// \ingroup system
+///
+/// TGE::PoolAllocator makes node based containers (std::list,
+/// std::set, std::map...) allocate their nodes from a
+/// TGE::MemoryPool. Inserting and erasing elements then stops
+/// touching the heap once the pool has grown to the peak size
+/// of the container.
+///
+/// The container allocates nodes rather than elements, so the
+/// blocks of the pool must be large enough for a node, which
+/// holds a few pointers besides the element. Allocations that
+/// don't fit in a block, or that are for several elements at
+/// once, go to the heap.
+///
+/// Usage example:
+/// \code
+/// typedef std::list<Event, TGE::PoolAllocator<Event> > EventList;
+///
+/// TGE::MemoryPool pool(sizeof(Event) + 4 * sizeof(void*));
+/// EventList events(TGE::PoolAllocator<Event>(pool));
+/// \endcode
+///
+/// \see TGE::MemoryPool, TGE::ArenaAllocator
+///
+////////////////////////////////////////////////////////////
@@ -0,0 +1,106 @@
+/*************************************/
+/** Copyright © 2014 Coldsnap Games **/
+/*************************************/
+
+
+////////////////////////////////////////////////////////////
+template <typename T>
+PoolAllocator<T>::PoolAllocator(MemoryPool& pool) :
+m_pool(&pool)
+{
+}
+
+
+////////////////////////////////////////////////////////////
+template <typename T>
+template <typename U>
+PoolAllocator<T>::PoolAllocator(const PoolAllocator<U>& other) :
+m_pool(&other.getPool())
+{
+}
+
+
+////////////////////////////////////////////////////////////
+template <typename T>
+typename PoolAllocator<T>::pointer PoolAllocator<T>::allocate(size_type count, const void*)
+{
+    if ((count == 1) && (sizeof(T) <= m_pool->getBlockSize()))
+        return static_cast<pointer>(m_pool->allocate());
+    else
+        return static_cast<pointer>(::operator new(count * sizeof(T)));
+}
+
+
+////////////////////////////////////////////////////////////
+template <typename T>
+void PoolAllocator<T>::deallocate(pointer elements, size_type count)
+{
+    if ((count == 1) && (sizeof(T) <= m_pool->getBlockSize()))
+        m_pool->deallocate(elements);
+    else
+        ::operator delete(elements);
+}
+
+
+////////////////////////////////////////////////////////////
+template <typename T>
+typename PoolAllocator<T>::size_type PoolAllocator<T>::max_size() const
+{
+    return static_cast<size_type>(-1) / sizeof(T);
+}
+
+
+////////////////////////////////////////////////////////////
+template <typename T>
+void PoolAllocator<T>::construct(pointer element, const T& value)
+{
+    new (element) T(value);
+}
+
+
+////////////////////////////////////////////////////////////
+template <typename T>
+void PoolAllocator<T>::destroy(pointer element)
+{
+    element->~T();
+}
+
+
+////////////////////////////////////////////////////////////
+template <typename T>
+typename PoolAllocator<T>::pointer PoolAllocator<T>::address(reference element) const
+{
+    return &element;
+}
+
+
+////////////////////////////////////////////////////////////
+template <typename T>
+typename PoolAllocator<T>::const_pointer PoolAllocator<T>::address(const_reference element) const
+{
+    return &element;
+}
+
+
+////////////////////////////////////////////////////////////
+template <typename T>
+MemoryPool& PoolAllocator<T>::getPool() const
+{
+    return *m_pool;
+}
+
+
+////////////////////////////////////////////////////////////
+template <typename T, typename U>
+bool operator ==(const PoolAllocator<T>& left, const PoolAllocator<U>& right)
+{
+    return &left.getPool() == &right.getPool();
+}
+
+
+////////////////////////////////////////////////////////////
+template <typename T, typename U>
+bool operator !=(const PoolAllocator<T>& left, const PoolAllocator<U>& right)
+{
+    return !(left == right);
+}
@@ -0,0 +1,267 @@
+/*************************************/
+/** Copyright © 2014 Coldsnap Games **/
+/*************************************/
+
+#ifndef TGE_PROFILER_HPP
+#define TGE_PROFILER_HPP
+
+/*************************************/
+/**             Headers             **/
+/*************************************/
+#include <Tyrant/Config.hpp>
+#include <Tyrant/System/NonCopyable.hpp>
+#include <string>
+
+
+////////////////////////////////////////////////////////////
+// Instrumentation macros, compiled out unless TGE_PROFILING
+// is defined
+////////////////////////////////////////////////////////////
+#if defined(TGE_PROFILING)
+
+    #define TGE_PROFILE_CONCAT_IMPL(a, b) a##b
+    #define TGE_PROFILE_CONCAT(a, b)      TGE_PROFILE_CONCAT_IMPL(a, b)
+
+    #define TGE_PROFILE_SCOPE(name)  TGE::ProfileZone TGE_PROFILE_CONCAT(tgeProfileZone, __LINE__)(name)
+    #define TGE_PROFILE_FUNCTION()   TGE_PROFILE_SCOPE(__FUNCTION__)
+    #define TGE_PROFILE_FRAME()      TGE::Profiler::markFrame()
+    #define TGE_PROFILE_THREAD(name) TGE::Profiler::setThreadName(name)
+
+#else
+
+    #define TGE_PROFILE_SCOPE(name)
+    #define TGE_PROFILE_FUNCTION()
+    #define TGE_PROFILE_FRAME()
+    #define TGE_PROFILE_THREAD(name)
+
+#endif
+
+
+namespace TGE
+{
+////////////////////////////////////////////////////////////
+/// \brief Records timed zones of code on all threads, and
+///        saves them for offline analysis
+///
+////////////////////////////////////////////////////////////
+class TGE_API Profiler
+{
+public :
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Start recording
+    ///
+    /// Events recorded before are kept, use clear() to
+    /// discard them.
+    ///
+    ////////////////////////////////////////////////////////////
+    static void start();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Stop recording
+    ///
+    /// Zones that are open when recording stops are still
+    /// closed properly.
+    ///
+    ////////////////////////////////////////////////////////////
+    static void stop();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Tell whether the profiler is recording
+    ///
+    /// \return True if recording
+    ///
+    ////////////////////////////////////////////////////////////
+    static bool isRunning();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Discard all the recorded events
+    ///
+    /// Must only be called while the profiler is stopped and
+    /// no thread is inside a zone.
+    ///
+    ////////////////////////////////////////////////////////////
+    static void clear();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Record the beginning of a zone on the calling thread
+    ///
+    /// Prefer the TGE_PROFILE_SCOPE macro, which closes the zone
+    /// automatically and can be compiled out.
+    ///
+    /// \param name Name of the zone; the pointer is stored, so it
+    ///             must stay valid (use a string literal)
+    ///
+    ////////////////////////////////////////////////////////////
+    static void beginZone(const char* name);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Record the end of the last zone opened on the
+    ///        calling thread
+    ///
+    /// \param name Name of the zone
+    ///
+    ////////////////////////////////////////////////////////////
+    static void endZone(const char* name);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Record the start of a new frame
+    ///
+    ////////////////////////////////////////////////////////////
+    static void markFrame();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Give a name to the calling thread in the output
+    ///
+    /// \param name Name of the thread; the pointer is stored,
+    ///             so it must stay valid (use a string literal)
+    ///
+    ////////////////////////////////////////////////////////////
+    static void setThreadName(const char* name);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Get the clock used for the timestamps
+    ///
+    /// \return Current time, in nanoseconds since an unspecified
+    ///         origin
+    ///
+    ////////////////////////////////////////////////////////////
+    static Uint64 getTimestamp();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Save the recorded events in the Chrome trace format
+    ///
+    /// The file can be opened with chrome://tracing or any
+    /// viewer supporting the Trace Event Format.
+    ///
+    /// \param filename Path of the file to write
+    ///
+    /// \return True if the file was written
+    ///
+    ////////////////////////////////////////////////////////////
+    static bool saveChromeTrace(const std::string& filename);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Save the recorded events in a compact binary format
+    ///
+    /// The file starts with the 8 bytes "TGEPROF1", followed by
+    /// little-endian fields:
+    /// \li Uint32 number of strings, then for each string its
+    ///     Uint32 length and its characters
+    /// \li Uint32 number of threads, then for each thread its
+    ///     Uint32 name (string index, or 0xFFFFFFFF), its Uint32
+    ///     number of events, and the events: Uint64 timestamp in
+    ///     nanoseconds, Uint32 name (string index), Uint8 type
+    ///     (0: begin, 1: end, 2: frame)
+    ///
+    /// \param filename Path of the file to write
+    ///
+    /// \return True if the file was written
+    ///
+    ////////////////////////////////////////////////////////////
+    static bool saveBinary(const std::string& filename);
+};
+
+
+////////////////////////////////////////////////////////////
+/// \brief Records a profiler zone for the lifetime of the
+///        object
+///
+////////////////////////////////////////////////////////////
+class TGE_API ProfileZone : NonCopyable
+{
+public :
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Begin the zone
+    ///
+    /// \param name Name of the zone (must stay valid)
+    ///
+    ////////////////////////////////////////////////////////////
+    explicit ProfileZone(const char* name) :
+    m_name(Profiler::isRunning() ? name : NULL)
+    {
+        if (m_name)
+            Profiler::beginZone(m_name);
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// \brief End the zone
+    ///
+    ////////////////////////////////////////////////////////////
+    ~ProfileZone()
+    {
+        if (m_name)
+            Profiler::endZone(m_name);
+    }
+
+private :
+
+    ////////////////////////////////////////////////////////////
+    // Member data
+    ////////////////////////////////////////////////////////////
+    const char* m_name; ///< Name of the zone, NULL if the profiler wasn't running when it began
+};
+
+} // namespace TGE
+
+
+#endif // TGE_PROFILER_HPP
+
+
+////////////////////////////////////////////////////////////
+/// \class TGE::Profiler
+/// \ingroup system
+///
+/// TGE::Profiler measures how long zones of code take, on every
+/// thread, frame by frame. Unlike a sampling profiler, it shows
+/// exactly which frame had a spike and what each thread was
+/// doing at that time.
+///
+/// Zones are declared with the TGE_PROFILE_SCOPE(name) macro,
+/// which records the beginning of the zone and its end when the
+/// enclosing scope exits; TGE_PROFILE_FUNCTION() does the same
+/// with the name of the current function. Zones can be nested.
+/// TGE::Game marks the start of each frame with
+/// TGE_PROFILE_FRAME(), and the engine's hot paths (rendering,
+/// glyph loading, audio streaming, image loading) are already
+/// instrumented.
+///
+/// The macros expand to nothing unless TGE_PROFILING is defined
+/// (make PROFILING=1 for the engine), so instrumentation can be
+/// left in the code at no cost. The profiler itself is always
+/// available.
+///
+/// Each thread records its events in its own buffer, without
+/// any lock. A zone costs two reads of the clock (nanosecond
+/// resolution, from CLOCK_MONOTONIC_RAW on Linux and the
+/// performance counter on Windows) and two small writes.
+///
+/// The recorded events can be saved in the Chrome trace format,
+/// to be browsed with chrome://tracing, or in a compact binary
+/// format for custom tools.
+///
+/// Usage example:
+/// \code
+/// void World::update()
+/// {
+///     TGE_PROFILE_FUNCTION();
+///
+///     {
+///         TGE_PROFILE_SCOPE("Physics");
+///         physics.step();
+///     }
+///
+///     {
+///         TGE_PROFILE_SCOPE("AI");
+///         ai.think();
+///     }
+/// }
+///
+/// TGE::Profiler::start();
+/// game.start(state);
+/// TGE::Profiler::stop();
+/// TGE::Profiler::saveChromeTrace("trace.json");
+/// \endcode
+///
+////////////////////////////////////////////////////////////
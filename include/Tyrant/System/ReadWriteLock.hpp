@@ -0,0 +1,161 @@
+/*************************************/
+/** Copyright © 2014 Coldsnap Games **/
+/*************************************/
+
+#ifndef TGE_READWRITELOCK_HPP
+#define TGE_READWRITELOCK_HPP
+
+/*************************************/
+/**             Headers             **/
+/*************************************/
+#include <Tyrant/Config.hpp>
+#include <Tyrant/System/NonCopyable.hpp>
+#include <atomic>
+
+
+namespace TGE
+{
+namespace priv
+{
+    class ReadWriteLockImpl;
+}
+
+////////////////////////////////////////////////////////////
+/// \brief Mutex that can be shared by several readers, or
+///        owned by a single writer
+///
+////////////////////////////////////////////////////////////
+class TGE_API ReadWriteLock : NonCopyable
+{
+public :
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Default constructor
+    ///
+    ////////////////////////////////////////////////////////////
+    ReadWriteLock();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Destructor
+    ///
+    ////////////////////////////////////////////////////////////
+    ~ReadWriteLock();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Lock for reading
+    ///
+    /// Blocks while a writer owns the lock. Any number of
+    /// threads can hold the read lock at the same time.
+    ///
+    /// \see unlockRead
+    ///
+    ////////////////////////////////////////////////////////////
+    void lockRead();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Lock for reading if no writer owns the lock
+    ///
+    /// \return True if the read lock was taken
+    ///
+    ////////////////////////////////////////////////////////////
+    bool tryLockRead();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Release a read lock
+    ///
+    /// \see lockRead
+    ///
+    ////////////////////////////////////////////////////////////
+    void unlockRead();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Lock for writing
+    ///
+    /// Blocks until no other thread holds the lock, either for
+    /// reading or for writing.
+    ///
+    /// \see unlockWrite
+    ///
+    ////////////////////////////////////////////////////////////
+    void lockWrite();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Lock for writing if nobody holds the lock
+    ///
+    /// \return True if the write lock was taken
+    ///
+    ////////////////////////////////////////////////////////////
+    bool tryLockWrite();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Release the write lock
+    ///
+    /// \see lockWrite
+    ///
+    ////////////////////////////////////////////////////////////
+    void unlockWrite();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Get the number of times lockRead() or lockWrite()
+    ///        had to wait for another thread
+    ///
+    /// \return Number of contended calls to lockRead() and lockWrite()
+    ///
+    ////////////////////////////////////////////////////////////
+    unsigned int getContentionCount() const;
+
+private :
+
+    ////////////////////////////////////////////////////////////
+    // Member data
+    ////////////////////////////////////////////////////////////
+    priv::ReadWriteLockImpl*  m_lockImpl;        ///< OS-specific implementation
+    std::atomic<unsigned int> m_contentionCount; ///< Number of contended calls to lockRead() and lockWrite()
+};
+
+} // namespace TGE
+
+
+#endif // TGE_READWRITELOCK_HPP
+
+
+////////////////////////////////////////////////////////////
+/// \class TGE::ReadWriteLock
+/// \ingroup system
+///
+/// TGE::ReadWriteLock protects data that is read much more
+/// often than it is modified (a resource cache, a settings
+/// table...). Readers don't block each other, only a writer
+/// gets exclusive access.
+///
+/// A thread waiting to write blocks the new readers, so that
+/// a steady flow of readers can't starve the writers.
+///
+/// The lock is not recursive: a thread must not take it again,
+/// for reading or writing, while it already holds it.
+///
+/// Usage example:
+/// \code
+/// TGE::ReadWriteLock lock;
+/// std::map<std::string, Texture*> textures;
+///
+/// Texture* find(const std::string& name)
+/// {
+///     lock.lockRead(); // other readers can run at the same time
+///     std::map<std::string, Texture*>::const_iterator it = textures.find(name);
+///     Texture* texture = (it != textures.end()) ? it->second : NULL;
+///     lock.unlockRead();
+///     return texture;
+/// }
+///
+/// void add(const std::string& name, Texture* texture)
+/// {
+///     lock.lockWrite(); // waits until all the readers are gone
+///     textures[name] = texture;
+///     lock.unlockWrite();
+/// }
+/// \endcode
+///
+/// \see TGE::Mutex
+///
+////////////////////////////////////////////////////////////
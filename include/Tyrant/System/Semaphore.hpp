@@ -0,0 +1,127 @@
+/*************************************/
+/** Copyright © 2014 Coldsnap Games **/
+/*************************************/
+
+#ifndef TGE_SEMAPHORE_HPP
+#define TGE_SEMAPHORE_HPP
+
+/*************************************/
+/**             Headers             **/
+/*************************************/
+#include <Tyrant/Config.hpp>
+#include <Tyrant/System/NonCopyable.hpp>
+#include <Tyrant/System/Time.hpp>
+
+
+namespace TGE
+{
+namespace priv
+{
+    class SemaphoreImpl;
+}
+
+////////////////////////////////////////////////////////////
+/// \brief Counter that threads can wait on until another
+///        thread signals it
+///
+////////////////////////////////////////////////////////////
+class TGE_API Semaphore : NonCopyable
+{
+public :
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Default constructor
+    ///
+    /// \param initialCount Initial value of the counter
+    ///
+    ////////////////////////////////////////////////////////////
+    explicit Semaphore(unsigned int initialCount = 0);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Destructor
+    ///
+    ////////////////////////////////////////////////////////////
+    ~Semaphore();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Wait until the counter is positive, then decrement it
+    ///
+    /// \see post
+    ///
+    ////////////////////////////////////////////////////////////
+    void wait();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Decrement the counter if it is positive, without waiting
+    ///
+    /// \return True if the counter was decremented
+    ///
+    ////////////////////////////////////////////////////////////
+    bool tryWait();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Wait until the counter is positive or a timeout
+    ///        expires, and decrement it if it is positive
+    ///
+    /// \param timeout Maximum time to wait
+    ///
+    /// \return True if the counter was decremented, false if the
+    ///         timeout expired
+    ///
+    ////////////////////////////////////////////////////////////
+    bool tryWait(Time timeout);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Increment the counter, waking up a waiting thread if any
+    ///
+    /// \see wait
+    ///
+    ////////////////////////////////////////////////////////////
+    void post();
+
+private :
+
+    ////////////////////////////////////////////////////////////
+    // Member data
+    ////////////////////////////////////////////////////////////
+    priv::SemaphoreImpl* m_semaphoreImpl; ///< OS-specific implementation
+};
+
+} // namespace TGE
+
+
+#endif // TGE_SEMAPHORE_HPP
+
+
+////////////////////////////////////////////////////////////
+/// \class TGE::Semaphore
+/// \ingroup system
+///
+/// A semaphore is a counter shared between threads. wait()
+/// blocks the calling thread until the counter is positive
+/// and then decrements it, post() increments it and wakes up
+/// one of the waiting threads.
+///
+/// Unlike a TGE::Mutex, a semaphore doesn't belong to the
+/// thread that decremented it: it is typically posted by one
+/// thread and waited on by another, which makes it the right
+/// tool to hand work over from a thread to another.
+///
+/// Usage example:
+/// \code
+/// TGE::Semaphore workReady;
+///
+/// void worker()
+/// {
+///     workReady.wait(); // blocks until the main thread posts
+///     doWork();
+/// }
+///
+/// // main thread
+/// prepareWork();
+/// workReady.post(); // wakes up the worker
+/// \endcode
+///
+/// \see TGE::Mutex, TGE::Thread
+///
+////////////////////////////////////////////////////////////
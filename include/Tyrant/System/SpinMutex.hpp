@@ -0,0 +1,132 @@
+/*************************************/
+/** Copyright © 2014 Coldsnap Games **/
+/*************************************/
+
+#ifndef TGE_SPINMUTEX_HPP
+#define TGE_SPINMUTEX_HPP
+
+/*************************************/
+/**             Headers             **/
+/*************************************/
+#include <Tyrant/Config.hpp>
+#include <Tyrant/System/NonCopyable.hpp>
+#include <atomic>
+
+
+namespace TGE
+{
+namespace priv
+{
+    class SpinMutexImpl;
+}
+
+////////////////////////////////////////////////////////////
+/// \brief Non-recursive mutex that spins for a short while
+///        before putting the thread to sleep
+///
+////////////////////////////////////////////////////////////
+class TGE_API SpinMutex : NonCopyable
+{
+public :
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Default constructor
+    ///
+    ////////////////////////////////////////////////////////////
+    SpinMutex();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Destructor
+    ///
+    ////////////////////////////////////////////////////////////
+    ~SpinMutex();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Lock the mutex
+    ///
+    /// If the mutex is locked by another thread, this call
+    /// retries for a few microseconds, then blocks until the
+    /// mutex is released.
+    ///
+    /// \see unlock
+    ///
+    ////////////////////////////////////////////////////////////
+    void lock();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Lock the mutex if it is available
+    ///
+    /// \return True if the mutex was locked, false if another
+    ///         thread owns it
+    ///
+    /// \see lock, unlock
+    ///
+    ////////////////////////////////////////////////////////////
+    bool tryLock();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Unlock the mutex
+    ///
+    /// \see lock
+    ///
+    ////////////////////////////////////////////////////////////
+    void unlock();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Get the number of times lock() had to wait for
+    ///        another thread
+    ///
+    /// \return Number of contended calls to lock()
+    ///
+    ////////////////////////////////////////////////////////////
+    unsigned int getContentionCount() const;
+
+private :
+
+    ////////////////////////////////////////////////////////////
+    // Member data
+    ////////////////////////////////////////////////////////////
+    priv::SpinMutexImpl*      m_mutexImpl;       ///< OS-specific implementation
+    std::atomic<unsigned int> m_contentionCount; ///< Number of contended calls to lock()
+};
+
+} // namespace TGE
+
+
+#endif // TGE_SPINMUTEX_HPP
+
+
+////////////////////////////////////////////////////////////
+/// \class TGE::SpinMutex
+/// \ingroup system
+///
+/// TGE::SpinMutex has the same purpose as TGE::Mutex, but is
+/// tuned for critical sections that only last a few
+/// instructions (pushing to a list, updating a counter...).
+///
+/// When a thread finds the mutex locked, it is very likely to
+/// be released soon, so instead of going to sleep immediately
+/// (which costs a system call and a context switch), the thread
+/// retries for a few microseconds. Only if the mutex is still
+/// locked after that does it block. An unlocked SpinMutex is
+/// locked and unlocked without any system call.
+///
+/// Unlike TGE::Mutex, a SpinMutex is never recursive: locking
+/// it twice from the same thread deadlocks.
+///
+/// Usage example:
+/// \code
+/// TGE::SpinMutex mutex;
+/// std::vector<Event> events;
+///
+/// void post(const Event& event)
+/// {
+///     mutex.lock();
+///     events.push_back(event);
+///     mutex.unlock();
+/// }
+/// \endcode
+///
+/// \see TGE::Mutex
+///
+////////////////////////////////////////////////////////////
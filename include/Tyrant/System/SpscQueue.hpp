@@ -0,0 +1,138 @@
+/*************************************/
+/** Copyright © 2014 Coldsnap Games **/
+/*************************************/
+
+#ifndef TGE_SPSCQUEUE_HPP
+#define TGE_SPSCQUEUE_HPP
+
+/*************************************/
+/**             Headers             **/
+/*************************************/
+#include <Tyrant/Config.hpp>
+#include <Tyrant/System/NonCopyable.hpp>
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+
+namespace TGE
+{
+////////////////////////////////////////////////////////////
+/// \brief Bounded lock-free queue for one producer thread
+///        and one consumer thread
+///
+////////////////////////////////////////////////////////////
+template <typename T>
+class SpscQueue : NonCopyable
+{
+public :
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Construct the queue
+    ///
+    /// \param capacity Maximum number of elements, rounded up to
+    ///                 a power of two
+    ///
+    ////////////////////////////////////////////////////////////
+    explicit SpscQueue(std::size_t capacity);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Add an element at the end of the queue
+    ///
+    /// Must only be called by the producer thread.
+    ///
+    /// \param value Element to copy into the queue
+    ///
+    /// \return False if the queue is full
+    ///
+    ////////////////////////////////////////////////////////////
+    bool push(const T& value);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Remove the element at the front of the queue
+    ///
+    /// Must only be called by the consumer thread.
+    ///
+    /// \param value Variable to fill with the removed element
+    ///
+    /// \return False if the queue is empty
+    ///
+    ////////////////////////////////////////////////////////////
+    bool pop(T& value);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Tell whether the queue is empty
+    ///
+    /// When called from another thread than the consumer, the
+    /// result may be outdated as soon as it is returned.
+    ///
+    /// \return True if the queue contains no element
+    ///
+    ////////////////////////////////////////////////////////////
+    bool isEmpty() const;
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Get the maximum number of elements in the queue
+    ///
+    /// \return Capacity of the queue
+    ///
+    ////////////////////////////////////////////////////////////
+    std::size_t getCapacity() const;
+
+private :
+
+    ////////////////////////////////////////////////////////////
+    // Member data
+    ////////////////////////////////////////////////////////////
+    std::vector<T>           m_slots;       ///< Circular storage of the elements
+    std::size_t              m_mask;        ///< Capacity minus one, to wrap the indices
+    std::atomic<std::size_t> m_head;        ///< Index of the next element to pop, written by the consumer
+    char                     m_padding[64]; ///< Keeps the head and the tail on different cache lines
+    std::atomic<std::size_t> m_tail;        ///< Index of the next element to push, written by the producer
+};
+
+#include <Tyrant/System/SpscQueue.inl>
+
+} // namespace TGE
+
+
+#endif // TGE_SPSCQUEUE_HPP
+
+
+////////////////////////////////////////////////////////////
+/// \class TGE::SpscQueue
+/// \ingroup system
+///
+/// TGE::SpscQueue passes elements from exactly one thread (the
+/// producer) to exactly one other thread (the consumer), in
+/// order, without any lock or system call. Neither thread ever
+/// waits for the other: push() fails when the queue is full and
+/// pop() fails when it is empty.
+///
+/// Typical uses are sending commands to an audio or network
+/// thread, or sending their results back.
+///
+/// The elements are stored in a fixed array allocated by the
+/// constructor, so T must be default-constructible and
+/// copyable. Popped elements stay in the array until they are
+/// overwritten.
+///
+/// If several threads need to push or pop, use TGE::MpmcQueue.
+///
+/// Usage example:
+/// \code
+/// TGE::SpscQueue<Command> commands(256);
+///
+/// // Main thread
+/// if (!commands.push(command))
+///     handleFullQueue();
+///
+/// // Audio thread
+/// Command command;
+/// while (commands.pop(command))
+///     execute(command);
+/// \endcode
+///
+/// \see TGE::MpmcQueue
+///
+////////////////////////////////////////////////////////////
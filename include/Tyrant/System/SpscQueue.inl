@@ -0,0 +1,64 @@
+/*************************************/
+/** Copyright © 2014 Coldsnap Games **/
+/*************************************/
+
+
+////////////////////////////////////////////////////////////
+template <typename T>
+SpscQueue<T>::SpscQueue(std::size_t capacity) :
+m_slots(),
+m_mask (1),
+m_head (0),
+m_tail (0)
+{
+    while (m_mask + 1 < capacity)
+        m_mask = (m_mask << 1) | 1;
+
+    m_slots.resize(m_mask + 1);
+}
+
+
+////////////////////////////////////////////////////////////
+template <typename T>
+bool SpscQueue<T>::push(const T& value)
+{
+    std::size_t tail = m_tail.load(std::memory_order_relaxed);
+    if (tail - m_head.load(std::memory_order_acquire) > m_mask)
+        return false;
+
+    m_slots[tail & m_mask] = value;
+    m_tail.store(tail + 1, std::memory_order_release);
+
+    return true;
+}
+
+
+////////////////////////////////////////////////////////////
+template <typename T>
+bool SpscQueue<T>::pop(T& value)
+{
+    std::size_t head = m_head.load(std::memory_order_relaxed);
+    if (head == m_tail.load(std::memory_order_acquire))
+        return false;
+
+    value = m_slots[head & m_mask];
+    m_head.store(head + 1, std::memory_order_release);
+
+    return true;
+}
+
+
+////////////////////////////////////////////////////////////
+template <typename T>
+bool SpscQueue<T>::isEmpty() const
+{
+    return m_head.load(std::memory_order_acquire) == m_tail.load(std::memory_order_acquire);
+}
+
+
+////////////////////////////////////////////////////////////
+template <typename T>
+std::size_t SpscQueue<T>::getCapacity() const
+{
+    return m_mask + 1;
+}
@@ -0,0 +1,91 @@
+/*************************************/
+/** Copyright © 2014 Coldsnap Games **/
+/*************************************/
+
+#ifndef TGE_READWRITELOCKIMPL_HPP
+#define TGE_READWRITELOCKIMPL_HPP
+
+/*************************************/
+/**             Headers             **/
+/*************************************/
+#include <Tyrant/System/NonCopyable.hpp>
+#include <pthread.h>
+
+
+namespace TGE
+{
+namespace priv
+{
+////////////////////////////////////////////////////////////
+/// \brief Unix implementation of read-write locks
+////////////////////////////////////////////////////////////
+class ReadWriteLockImpl : NonCopyable
+{
+public :
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Default constructor
+    ///
+    ////////////////////////////////////////////////////////////
+    ReadWriteLockImpl();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Destructor
+    ///
+    ////////////////////////////////////////////////////////////
+    ~ReadWriteLockImpl();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Lock for reading
+    ///
+    ////////////////////////////////////////////////////////////
+    void lockRead();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Lock for reading if no writer owns the lock
+    ///
+    /// \return True if the read lock was taken
+    ///
+    ////////////////////////////////////////////////////////////
+    bool tryLockRead();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Release a read lock
+    ///
+    ////////////////////////////////////////////////////////////
+    void unlockRead();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Lock for writing
+    ///
+    ////////////////////////////////////////////////////////////
+    void lockWrite();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Lock for writing if nobody holds the lock
+    ///
+    /// \return True if the write lock was taken
+    ///
+    ////////////////////////////////////////////////////////////
+    bool tryLockWrite();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Release the write lock
+    ///
+    ////////////////////////////////////////////////////////////
+    void unlockWrite();
+
+private :
+
+    ////////////////////////////////////////////////////////////
+    // Member data
+    ////////////////////////////////////////////////////////////
+    pthread_rwlock_t m_lock; ///< pthread handle of the lock
+};
+
+} // namespace priv
+
+} // namespace TGE
+
+
+#endif // TGE_READWRITELOCKIMPL_HPP
@@ -0,0 +1,87 @@
+/*************************************/
+/** Copyright © 2014 Coldsnap Games **/
+/*************************************/
+
+#ifndef TGE_SEMAPHOREIMPL_HPP
+#define TGE_SEMAPHOREIMPL_HPP
+
+/*************************************/
+/**             Headers             **/
+/*************************************/
+#include <Tyrant/System/NonCopyable.hpp>
+#include <Tyrant/System/Time.hpp>
+#include <pthread.h>
+
+
+namespace TGE
+{
+namespace priv
+{
+////////////////////////////////////////////////////////////
+/// \brief Unix implementation of semaphores
+////////////////////////////////////////////////////////////
+class SemaphoreImpl : NonCopyable
+{
+public :
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Default constructor
+    ///
+    /// \param initialCount Initial value of the counter
+    ///
+    ////////////////////////////////////////////////////////////
+    SemaphoreImpl(unsigned int initialCount);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Destructor
+    ///
+    ////////////////////////////////////////////////////////////
+    ~SemaphoreImpl();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Wait until the counter is positive, then decrement it
+    ///
+    ////////////////////////////////////////////////////////////
+    void wait();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Decrement the counter if it is positive
+    ///
+    /// \return True if the counter was decremented
+    ///
+    ////////////////////////////////////////////////////////////
+    bool tryWait();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Decrement the counter if it becomes positive
+    ///        before a timeout
+    ///
+    /// \param timeout Maximum time to wait
+    ///
+    /// \return True if the counter was decremented
+    ///
+    ////////////////////////////////////////////////////////////
+    bool tryWait(Time timeout);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Increment the counter
+    ///
+    ////////////////////////////////////////////////////////////
+    void post();
+
+private :
+
+    ////////////////////////////////////////////////////////////
+    // Member data
+    ////////////////////////////////////////////////////////////
+    pthread_mutex_t m_mutex;     ///< Mutex protecting the counter
+    pthread_cond_t  m_condition; ///< Condition signaled when the counter is incremented
+    unsigned int    m_count;     ///< Current value of the counter
+};
+
+} // namespace priv
+
+} // namespace TGE
+
+
+#endif // TGE_SEMAPHOREIMPL_HPP
@@ -0,0 +1,85 @@
+/*************************************/
+/** Copyright © 2014 Coldsnap Games **/
+/*************************************/
+
+#ifndef TGE_SPINMUTEXIMPL_HPP
+#define TGE_SPINMUTEXIMPL_HPP
+
+/*************************************/
+/**             Headers             **/
+/*************************************/
+#include <Tyrant/Config.hpp>
+#include <Tyrant/System/NonCopyable.hpp>
+#if defined(OS_LINUX)
+    #include <atomic>
+#else
+    #include <pthread.h>
+#endif
+
+
+namespace TGE
+{
+namespace priv
+{
+////////////////////////////////////////////////////////////
+/// \brief Unix implementation of spin mutexes
+///
+/// On Linux, the mutex is a futex: an atomic integer that
+/// threads only sleep on (with a system call) once spinning
+/// failed. Other systems spin on a pthread mutex.
+///
+////////////////////////////////////////////////////////////
+class SpinMutexImpl : NonCopyable
+{
+public :
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Default constructor
+    ///
+    ////////////////////////////////////////////////////////////
+    SpinMutexImpl();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Destructor
+    ///
+    ////////////////////////////////////////////////////////////
+    ~SpinMutexImpl();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Lock the mutex
+    ///
+    ////////////////////////////////////////////////////////////
+    void lock();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Lock the mutex if it is available
+    ///
+    /// \return True if the mutex was locked
+    ///
+    ////////////////////////////////////////////////////////////
+    bool tryLock();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Unlock the mutex
+    ///
+    ////////////////////////////////////////////////////////////
+    void unlock();
+
+private :
+
+    ////////////////////////////////////////////////////////////
+    // Member data
+    ////////////////////////////////////////////////////////////
+#if defined(OS_LINUX)
+    std::atomic<int> m_state; ///< 0: unlocked, 1: locked, 2: locked with sleeping threads
+#else
+    pthread_mutex_t  m_mutex; ///< pthread handle of the mutex
+#endif
+};
+
+} // namespace priv
+
+} // namespace TGE
+
+
+#endif // TGE_SPINMUTEXIMPL_HPP
@@ -31,6 +31,15 @@ public :
     ///
     ////////////////////////////////////////////////////////////
     static Time getCurrentTime();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Get the current time with the best available
+    ///        precision
+    ///
+    /// \return Current time, in nanoseconds
+    ///
+    ////////////////////////////////////////////////////////////
+    static Uint64 getCurrentNanoseconds();
 };
 
 } // namespace priv
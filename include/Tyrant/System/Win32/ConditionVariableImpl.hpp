@@ -0,0 +1,99 @@
+/*************************************/
+/** Copyright © 2014 Coldsnap Games **/
+/*************************************/
+
+#ifndef TGE_CONDITIONVARIABLEIMPL_HPP
+#define TGE_CONDITIONVARIABLEIMPL_HPP
+
+/*************************************/
+/**             Headers             **/
+/*************************************/
+#include <Tyrant/System/NonCopyable.hpp>
+#include <Tyrant/System/Time.hpp>
+#include <Tyrant/System/Win32/MutexImpl.hpp>
+#include <windows.h>
+#include <deque>
+#include <vector>
+
+
+namespace TGE
+{
+namespace priv
+{
+////////////////////////////////////////////////////////////
+/// \brief Windows implementation of condition variables
+///
+/// Native condition variables require Vista, so each waiting
+/// thread sleeps on its own event, which notifyOne() and
+/// notifyAll() signal in arrival order.
+///
+////////////////////////////////////////////////////////////
+class ConditionVariableImpl : NonCopyable
+{
+public :
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Default constructor
+    ///
+    ////////////////////////////////////////////////////////////
+    ConditionVariableImpl();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Destructor
+    ///
+    ////////////////////////////////////////////////////////////
+    ~ConditionVariableImpl();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Wait until the condition is notified
+    ///
+    ////////////////////////////////////////////////////////////
+    void wait(MutexImpl& mutex);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Wait until the condition is notified, or a timeout
+    ///
+    /// \return False if the timeout expired
+    ///
+    ////////////////////////////////////////////////////////////
+    bool wait(MutexImpl& mutex, Time timeout);
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Wake up one waiting thread
+    ///
+    ////////////////////////////////////////////////////////////
+    void notifyOne();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Wake up all the waiting threads
+    ///
+    ////////////////////////////////////////////////////////////
+    void notifyAll();
+
+private :
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Wait until the event of the calling thread is signaled
+    ///
+    /// \param mutex        Mutex to release while waiting
+    /// \param milliseconds Timeout, or INFINITE
+    ///
+    /// \return False if the timeout expired
+    ///
+    ////////////////////////////////////////////////////////////
+    bool waitEvent(MutexImpl& mutex, DWORD milliseconds);
+
+    ////////////////////////////////////////////////////////////
+    // Member data
+    ////////////////////////////////////////////////////////////
+    CRITICAL_SECTION    m_lock;    ///< Protects the lists of events
+    std::deque<HANDLE>  m_waiters; ///< Events of the waiting threads, in arrival order
+    std::vector<HANDLE> m_events;  ///< Unused events, kept for the next waits
+};
+
+} // namespace priv
+
+} // namespace TGE
+
+
+#endif // TGE_CONDITIONVARIABLEIMPL_HPP
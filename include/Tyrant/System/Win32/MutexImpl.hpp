@@ -26,8 +26,10 @@ public :
     ////////////////////////////////////////////////////////////
     /// \brief Default constructor
     ///
+    /// \param recursive Can the owner thread lock the mutex again?
+    ///
     ////////////////////////////////////////////////////////////
-    MutexImpl();
+    MutexImpl(bool recursive);
 
     ////////////////////////////////////////////////////////////
     /// \brief Destructor
@@ -41,6 +43,14 @@ public :
     ////////////////////////////////////////////////////////////
     void lock();
 
+    ////////////////////////////////////////////////////////////
+    /// \brief Lock the mutex if it is available
+    ///
+    /// \return True if the mutex was locked
+    ///
+    ////////////////////////////////////////////////////////////
+    bool tryLock();
+
     ////////////////////////////////////////////////////////////
     /// \brief Unlock the mutex
     ///
@@ -49,6 +59,8 @@ public :
 
 private :
 
+    friend class ConditionVariableImpl;
+
     ////////////////////////////////////////////////////////////
     // Member data
     ////////////////////////////////////////////////////////////
@@ -0,0 +1,98 @@
+/*************************************/
+/** Copyright © 2014 Coldsnap Games **/
+/*************************************/
+
+#ifndef TGE_READWRITELOCKIMPL_HPP
+#define TGE_READWRITELOCKIMPL_HPP
+
+/*************************************/
+/**             Headers             **/
+/*************************************/
+#include <Tyrant/System/NonCopyable.hpp>
+#include <windows.h>
+
+
+namespace TGE
+{
+namespace priv
+{
+////////////////////////////////////////////////////////////
+/// \brief Windows implementation of read-write locks
+///
+/// Slim reader-writer locks require Vista, so the lock is
+/// built on a critical section that writers hold for the
+/// whole write, and readers only to enter.
+///
+////////////////////////////////////////////////////////////
+class ReadWriteLockImpl : NonCopyable
+{
+public :
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Default constructor
+    ///
+    ////////////////////////////////////////////////////////////
+    ReadWriteLockImpl();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Destructor
+    ///
+    ////////////////////////////////////////////////////////////
+    ~ReadWriteLockImpl();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Lock for reading
+    ///
+    ////////////////////////////////////////////////////////////
+    void lockRead();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Lock for reading if no writer owns the lock
+    ///
+    /// \return True if the read lock was taken
+    ///
+    ////////////////////////////////////////////////////////////
+    bool tryLockRead();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Release a read lock
+    ///
+    ////////////////////////////////////////////////////////////
+    void unlockRead();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Lock for writing
+    ///
+    ////////////////////////////////////////////////////////////
+    void lockWrite();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Lock for writing if nobody holds the lock
+    ///
+    /// \return True if the write lock was taken
+    ///
+    ////////////////////////////////////////////////////////////
+    bool tryLockWrite();
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Release the write lock
+    ///
+    ////////////////////////////////////////////////////////////
+    void unlockWrite();
+
+private :
+
+    ////////////////////////////////////////////////////////////
+    // Member data
+    ////////////////////////////////////////////////////////////
+    CRITICAL_SECTION m_writerGate;  ///< Owned by writers, and briefly by readers entering
+    volatile LONG    m_readerCount; ///< Number of threads holding the read lock
+    HANDLE           m_noReaders;   ///< Auto-reset event signaled when the last reader leaves
+};
+
+} // namespace priv
+
+} // namespace TGE
+
+
+#endif // TGE_READWRITELOCKIMPL_HPP
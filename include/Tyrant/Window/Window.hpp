@@ -348,11 +348,12 @@ public :
     /// If a limit is set, the window will use a small delay after
     /// each call to display() to ensure that the current frame
     /// lasted long enough to match the framerate limit.
-    /// TGE will try to match the given limit as much as it can,
-    /// but since it internally uses TGE::sleep, whose precision
-    /// depends on the underlying OS, the results may be a little
-    /// unprecise as well (for example, you can get 65 FPS when
-    /// requesting 60).
+    /// Since the precision of TGE::sleep depends on the underlying
+    /// OS, the window sleeps for most of the delay and then spins
+    /// on a clock for the last couple of milliseconds. Frames are
+    /// scheduled on a fixed grid, so a frame that ends late is
+    /// compensated by the next one rather than shifting all the
+    /// following frames.
     ///
     /// \param limit Framerate limit, in frames per seconds (use 0 to disable limit)
     ///
@@ -396,6 +397,9 @@ public :
     /// has been done for the current frame, in order to show
     /// it on screen.
     ///
+    /// It also ends the frame of the calling thread's frame
+    /// arena (see MemoryArena::getFrameArena()), which is reset.
+    ///
     ////////////////////////////////////////////////////////////
     void display();
 
@@ -465,6 +469,7 @@ private:
     priv::GlContext*  m_context;        ///< Platform-specific implementation of the OpenGL context
     Clock             m_clock;          ///< Clock for measuring the elapsed time between frames
     Time              m_frameTimeLimit; ///< Current framerate limit
+    Time              m_nextFrameTime;  ///< Time of m_clock at which the next frame should be displayed
     Vector2u          m_size;           ///< Current size of the window
 };
 
@@ -18,7 +18,8 @@ namespace TGE
 ////////////////////////////////////////////////////////////
 Music::Music() :
 m_file    (new priv::SoundFile),
-m_duration()
+m_duration(),
+m_mutex   (Mutex::NonRecursive)
 {
 
 }
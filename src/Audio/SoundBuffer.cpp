@@ -18,8 +18,10 @@ namespace TGE
 {
 ////////////////////////////////////////////////////////////
 SoundBuffer::SoundBuffer() :
-m_buffer  (0),
-m_duration()
+m_buffer      (0),
+m_sampleRate  (0),
+m_channelCount(0),
+m_duration    ()
 {
     priv::ensureALInit();
 
@@ -30,16 +32,18 @@ m_duration()
 
 ////////////////////////////////////////////////////////////
 SoundBuffer::SoundBuffer(const SoundBuffer& copy) :
-m_buffer  (0),
-m_samples (copy.m_samples),
-m_duration(copy.m_duration),
-m_sounds  () // don't copy the attached sounds
+m_buffer      (0),
+m_samples     (copy.m_samples),
+m_sampleRate  (copy.m_sampleRate),
+m_channelCount(copy.m_channelCount),
+m_duration    (copy.m_duration),
+m_sounds      () // don't copy the attached sounds
 {
     // Create the buffer
     alCheck(alGenBuffers(1, &m_buffer));
 
     // Update the internal buffer with the new samples
-    update(copy.getChannelCount(), copy.getSampleRate());
+    update(copy.m_channelCount, copy.m_sampleRate);
 }
 
 
@@ -151,20 +155,14 @@ std::size_t SoundBuffer::getSampleCount() const
 ////////////////////////////////////////////////////////////
 unsigned int SoundBuffer::getSampleRate() const
 {
-    ALint sampleRate;
-    alCheck(alGetBufferi(m_buffer, AL_FREQUENCY, &sampleRate));
-
-    return sampleRate;
+    return m_sampleRate;
 }
 
 
 ////////////////////////////////////////////////////////////
 unsigned int SoundBuffer::getChannelCount() const
 {
-    ALint channelCount;
-    alCheck(alGetBufferi(m_buffer, AL_CHANNELS, &channelCount));
-
-    return channelCount;
+    return m_channelCount;
 }
 
 
@@ -180,10 +178,12 @@ SoundBuffer& SoundBuffer::operator =(const SoundBuffer& right)
 {
     SoundBuffer temp(right);
 
-    std::swap(m_samples,  temp.m_samples);
-    std::swap(m_buffer,   temp.m_buffer);
-    std::swap(m_duration, temp.m_duration);
-    std::swap(m_sounds,   temp.m_sounds); // swap sounds too, so that they are detached when temp is destroyed
+    std::swap(m_samples,      temp.m_samples);
+    std::swap(m_buffer,       temp.m_buffer);
+    std::swap(m_sampleRate,   temp.m_sampleRate);
+    std::swap(m_channelCount, temp.m_channelCount);
+    std::swap(m_duration,     temp.m_duration);
+    std::swap(m_sounds,       temp.m_sounds); // swap sounds too, so that they are detached when temp is destroyed
 
     return *this;
 }
@@ -228,6 +228,10 @@ bool SoundBuffer::update(unsigned int channelCount, unsigned int sampleRate)
         return false;
     }
 
+    // Keep the format, so that it's known even without an audio device
+    m_sampleRate   = sampleRate;
+    m_channelCount = channelCount;
+
     // Fill the buffer
     ALsizei size = static_cast<ALsizei>(m_samples.size()) * sizeof(Int16);
     alCheck(alBufferData(m_buffer, format, &m_samples[0], size, sampleRate));
@@ -0,0 +1,669 @@
+/*************************************/
+/** Copyright © 2014 Coldsnap Games **/
+/*************************************/
+
+/*************************************/
+/**             Headers             **/
+/*************************************/
+#include <Tyrant/Audio/SoundMixer.hpp>
+#include <Tyrant/Audio/SoundBuffer.hpp>
+#include <Tyrant/Audio/SoundStream.hpp>
+#include <Tyrant/System/Lock.hpp>
+#include <Tyrant/System/Log.hpp>
+#include <Tyrant/System/Profiler.hpp>
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+    #include <emmintrin.h>
+    #define TGE_MIXER_SSE2
+#endif
+
+
+namespace
+{
+    // Default maximum number of voices mixed at once
+    const std::size_t DefaultMixedVoiceCount = 32;
+
+    // Gain under which a voice can't be heard (-60 dB), it is never mixed
+    const float AudibleGain = 0.001f;
+
+    // Number of frames mixed at once by the output
+    const std::size_t ChunkFrames = 1024;
+
+    // Maximum number of voices, the slot is stored in 16 bits of the handles
+    const std::size_t MaxVoices = 0xFFFF;
+
+    const float Pi = 3.141592654f;
+
+    ////////////////////////////////////////////////////////////
+    // Mix frames played at the rate of the mixer, with gains
+    // changing linearly from a frame to the next
+    ////////////////////////////////////////////////////////////
+    void mixExact(const TGE::Int16* samples, unsigned int channelCount, float* mix, std::size_t count, float left, float right, float leftStep, float rightStep)
+    {
+        std::size_t i = 0;
+
+    #ifdef TGE_MIXER_SSE2
+
+        // Four frames per iteration, as two blocks of two stereo frames
+        __m128 gain = _mm_setr_ps(left, right, left + leftStep, right + rightStep);
+        __m128 step = _mm_setr_ps(2 * leftStep, 2 * rightStep, 2 * leftStep, 2 * rightStep);
+        if (channelCount == 1)
+        {
+            for (; i + 4 <= count; i += 4)
+            {
+                __m128i packed = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(samples + i));
+                __m128 values  = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(packed, packed), 16));
+
+                float* out = mix + 2 * i;
+                _mm_storeu_ps(out, _mm_add_ps(_mm_loadu_ps(out), _mm_mul_ps(_mm_unpacklo_ps(values, values), gain)));
+                gain = _mm_add_ps(gain, step);
+                _mm_storeu_ps(out + 4, _mm_add_ps(_mm_loadu_ps(out + 4), _mm_mul_ps(_mm_unpackhi_ps(values, values), gain)));
+                gain = _mm_add_ps(gain, step);
+            }
+        }
+        else
+        {
+            for (; i + 4 <= count; i += 4)
+            {
+                __m128i packed = _mm_loadu_si128(reinterpret_cast<const __m128i*>(samples + 2 * i));
+                __m128 first   = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(packed, packed), 16));
+                __m128 second  = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(packed, packed), 16));
+
+                float* out = mix + 2 * i;
+                _mm_storeu_ps(out, _mm_add_ps(_mm_loadu_ps(out), _mm_mul_ps(first, gain)));
+                gain = _mm_add_ps(gain, step);
+                _mm_storeu_ps(out + 4, _mm_add_ps(_mm_loadu_ps(out + 4), _mm_mul_ps(second, gain)));
+                gain = _mm_add_ps(gain, step);
+            }
+        }
+
+    #endif
+
+        left  += leftStep * i;
+        right += rightStep * i;
+        for (; i < count; ++i)
+        {
+            const TGE::Int16* frame = samples + i * channelCount;
+            mix[2 * i]     += frame[0] * left;
+            mix[2 * i + 1] += frame[channelCount - 1] * right;
+            left  += leftStep;
+            right += rightStep;
+        }
+    }
+
+    ////////////////////////////////////////////////////////////
+    // Mix frames played at another rate, interpolating between
+    // the frames of the buffer
+    ////////////////////////////////////////////////////////////
+    void mixResampled(const TGE::Int16* samples, std::size_t frameCount, unsigned int channelCount, double offset, double step, float* mix, std::size_t count, float left, float right, float leftStep, float rightStep)
+    {
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            std::size_t index = static_cast<std::size_t>(offset);
+            std::size_t next = std::min(index + 1, frameCount - 1);
+            float t = static_cast<float>(offset - index);
+
+            const TGE::Int16* a = samples + index * channelCount;
+            const TGE::Int16* b = samples + next * channelCount;
+            float first  = a[0] + (b[0] - a[0]) * t;
+            float second = a[channelCount - 1] + (b[channelCount - 1] - a[channelCount - 1]) * t;
+
+            mix[2 * i]     += first * left;
+            mix[2 * i + 1] += second * right;
+            left   += leftStep;
+            right  += rightStep;
+            offset += step;
+        }
+    }
+}
+
+namespace TGE
+{
+namespace priv
+{
+////////////////////////////////////////////////////////////
+/// \brief Audio stream playing the mix of a mixer
+///
+////////////////////////////////////////////////////////////
+class MixerStream : public SoundStream
+{
+public :
+
+    explicit MixerStream(SoundMixer& mixer) :
+    m_mixer  (mixer),
+    m_samples(ChunkFrames * 2)
+    {
+        initialize(2, mixer.getSampleRate());
+    }
+
+    ~MixerStream()
+    {
+        // The stream must stop before the mixer goes
+        stop();
+    }
+
+protected :
+
+    virtual bool onGetData(Chunk& data)
+    {
+        m_mixer.render(&m_samples[0], ChunkFrames);
+
+        data.samples     = &m_samples[0];
+        data.sampleCount = m_samples.size();
+
+        return true;
+    }
+
+    virtual void onSeek(Time)
+    {
+        // The mix has no position
+    }
+
+private :
+
+    SoundMixer&        m_mixer;   ///< Mixer making the mix
+    std::vector<Int16> m_samples; ///< Chunk of the mix being played
+};
+
+} // namespace priv
+
+
+////////////////////////////////////////////////////////////
+SoundMixer::SoundMixer(unsigned int sampleRate) :
+m_sampleRate      (sampleRate > 0 ? sampleRate : 44100),
+m_maxMixed        (DefaultMixedVoiceCount),
+m_mixedCount      (0),
+m_activeCount     (0),
+m_voices          (),
+m_freeSlots       (),
+m_listenerPosition(0.f, 0.f, 0.f),
+m_listenerRight   (1.f, 0.f, 0.f),
+m_audibility      (),
+m_mix             (),
+m_output          (NULL),
+m_mutex           (Mutex::NonRecursive)
+{
+    for (unsigned int i = 0; i < BusCount; ++i)
+        m_busVolumes[i] = 1.f;
+}
+
+
+////////////////////////////////////////////////////////////
+SoundMixer::~SoundMixer()
+{
+    delete m_output;
+}
+
+
+////////////////////////////////////////////////////////////
+bool SoundMixer::startOutput()
+{
+    if (!m_output)
+        m_output = new priv::MixerStream(*this);
+
+    m_output->play();
+
+    return m_output->getStatus() == SoundSource::Playing;
+}
+
+
+////////////////////////////////////////////////////////////
+void SoundMixer::stopOutput()
+{
+    if (m_output)
+        m_output->stop();
+}
+
+
+////////////////////////////////////////////////////////////
+void SoundMixer::setMixedVoiceCount(unsigned int count)
+{
+    Lock lock(m_mutex);
+
+    m_maxMixed = count;
+}
+
+
+////////////////////////////////////////////////////////////
+SoundMixer::VoiceId SoundMixer::play(const SoundBuffer& buffer, unsigned int bus, float priority)
+{
+    unsigned int channelCount = buffer.getChannelCount();
+    if ((channelCount < 1) || (channelCount > 2) || (buffer.getSampleCount() < channelCount) || (bus >= BusCount))
+    {
+        Log() << "Failed to play a sound in the mixer: the buffer must be mono or stereo, and the bus less than " << static_cast<unsigned int>(BusCount) << std::endl;
+        return 0;
+    }
+
+    Lock lock(m_mutex);
+
+    std::size_t slot;
+    if (!m_freeSlots.empty())
+    {
+        slot = m_freeSlots.back();
+        m_freeSlots.pop_back();
+    }
+    else if (m_voices.size() < MaxVoices)
+    {
+        slot = m_voices.size();
+        m_voices.push_back(Voice());
+        m_voices.back().generation = 1;
+    }
+    else
+    {
+        Log() << "Failed to play a sound in the mixer: too many voices" << std::endl;
+        return 0;
+    }
+
+    Voice& voice = m_voices[slot];
+    voice.samples      = buffer.getSamples();
+    voice.frameCount   = buffer.getSampleCount() / channelCount;
+    voice.channelCount = channelCount;
+    voice.rate         = static_cast<float>(buffer.getSampleRate()) / m_sampleRate;
+    voice.offset       = 0;
+    voice.volume       = 1.f;
+    voice.pitch        = 1.f;
+    voice.priority     = priority;
+    voice.bus          = bus;
+    voice.loop         = false;
+    voice.spatial      = false;
+    voice.position     = Vector3f(0.f, 0.f, 0.f);
+    voice.minDistance  = 1.f;
+    voice.attenuation  = 1.f;
+    voice.mixedLeft    = 0.f;
+    voice.mixedRight   = 0.f;
+    voice.active       = true;
+
+    // The voice is mixed right away if there's room, update decides later
+    computeGains(voice);
+    voice.mixed = (m_mixedCount < m_maxMixed) && (std::max(voice.left, voice.right) >= AudibleGain);
+    if (voice.mixed)
+        m_mixedCount++;
+    m_activeCount++;
+
+    return (static_cast<VoiceId>(voice.generation) << 16) | static_cast<VoiceId>(slot + 1);
+}
+
+
+////////////////////////////////////////////////////////////
+void SoundMixer::stop(VoiceId voice)
+{
+    Lock lock(m_mutex);
+
+    if (findVoice(voice))
+        release((voice & 0xFFFF) - 1);
+}
+
+
+////////////////////////////////////////////////////////////
+void SoundMixer::stopAll()
+{
+    Lock lock(m_mutex);
+
+    for (std::size_t i = 0; i < m_voices.size(); ++i)
+    {
+        if (m_voices[i].active)
+            release(i);
+    }
+}
+
+
+////////////////////////////////////////////////////////////
+bool SoundMixer::isPlaying(VoiceId voice) const
+{
+    Lock lock(m_mutex);
+
+    return findVoice(voice) != NULL;
+}
+
+
+////////////////////////////////////////////////////////////
+bool SoundMixer::isVirtual(VoiceId voice) const
+{
+    Lock lock(m_mutex);
+
+    const Voice* state = findVoice(voice);
+    return state && !state->mixed;
+}
+
+
+////////////////////////////////////////////////////////////
+void SoundMixer::setVolume(VoiceId voice, float volume)
+{
+    Lock lock(m_mutex);
+
+    if (Voice* state = findVoice(voice))
+        state->volume = std::max(volume, 0.f);
+}
+
+
+////////////////////////////////////////////////////////////
+void SoundMixer::setPitch(VoiceId voice, float pitch)
+{
+    Lock lock(m_mutex);
+
+    if (Voice* state = findVoice(voice))
+        state->pitch = std::max(pitch, 0.f);
+}
+
+
+////////////////////////////////////////////////////////////
+void SoundMixer::setLoop(VoiceId voice, bool loop)
+{
+    Lock lock(m_mutex);
+
+    if (Voice* state = findVoice(voice))
+        state->loop = loop;
+}
+
+
+////////////////////////////////////////////////////////////
+void SoundMixer::setPosition(VoiceId voice, const Vector3f& position)
+{
+    Lock lock(m_mutex);
+
+    if (Voice* state = findVoice(voice))
+    {
+        state->spatial  = true;
+        state->position = position;
+    }
+}
+
+
+////////////////////////////////////////////////////////////
+void SoundMixer::setAttenuation(VoiceId voice, float minDistance, float attenuation)
+{
+    Lock lock(m_mutex);
+
+    if (Voice* state = findVoice(voice))
+    {
+        state->minDistance = std::max(minDistance, 0.001f);
+        state->attenuation = std::max(attenuation, 0.f);
+    }
+}
+
+
+////////////////////////////////////////////////////////////
+void SoundMixer::setBusVolume(unsigned int bus, float volume)
+{
+    Lock lock(m_mutex);
+
+    if (bus < BusCount)
+        m_busVolumes[bus] = std::max(volume, 0.f);
+}
+
+
+////////////////////////////////////////////////////////////
+float SoundMixer::getBusVolume(unsigned int bus) const
+{
+    Lock lock(m_mutex);
+
+    return bus < BusCount ? m_busVolumes[bus] : 0.f;
+}
+
+
+////////////////////////////////////////////////////////////
+void SoundMixer::setListenerPosition(const Vector3f& position)
+{
+    Lock lock(m_mutex);
+
+    m_listenerPosition = position;
+}
+
+
+////////////////////////////////////////////////////////////
+void SoundMixer::setListenerDirection(const Vector3f& direction)
+{
+    // Right ear = direction x up, with up = (0, 1, 0)
+    Vector3f right(-direction.z, 0.f, direction.x);
+    float length = std::sqrt(right.x * right.x + right.z * right.z);
+    if (length <= 0.f)
+        return;
+
+    Lock lock(m_mutex);
+
+    m_listenerRight = right / length;
+}
+
+
+////////////////////////////////////////////////////////////
+void SoundMixer::update()
+{
+    TGE_PROFILE_SCOPE("SoundMixer::update");
+
+    Lock lock(m_mutex);
+
+    // Compute all the gains, and keep the voices which can be heard
+    m_audibility.clear();
+    for (std::size_t i = 0; i < m_voices.size(); ++i)
+    {
+        Voice& voice = m_voices[i];
+        if (!voice.active)
+            continue;
+
+        computeGains(voice);
+        voice.mixed = false;
+
+        float gain = std::max(voice.left, voice.right);
+        if (gain >= AudibleGain)
+            m_audibility.push_back(std::make_pair(gain * voice.priority, i));
+    }
+
+    // Mix the most audible ones
+    m_mixedCount = std::min(m_audibility.size(), m_maxMixed);
+    if (m_audibility.size() > m_maxMixed)
+        std::nth_element(m_audibility.begin(), m_audibility.begin() + m_maxMixed, m_audibility.end(), std::greater<std::pair<float, std::size_t> >());
+
+    for (std::size_t i = 0; i < m_mixedCount; ++i)
+        m_voices[m_audibility[i].second].mixed = true;
+}
+
+
+////////////////////////////////////////////////////////////
+void SoundMixer::render(Int16* samples, std::size_t frameCount)
+{
+    TGE_PROFILE_SCOPE("SoundMixer::render");
+
+    Lock lock(m_mutex);
+
+    m_mix.assign(frameCount * 2, 0.f);
+
+    // Voices which just became virtual are mixed once more, to fade out
+    for (std::size_t i = 0; i < m_voices.size(); ++i)
+    {
+        Voice& voice = m_voices[i];
+        if (!voice.active)
+            continue;
+
+        bool playing;
+        if (voice.mixed || (voice.mixedLeft > 0) || (voice.mixedRight > 0))
+            playing = mixVoice(voice, frameCount);
+        else
+            playing = skipVoice(voice, frameCount);
+
+        if (!playing)
+            release(i);
+    }
+
+    // Convert to 16 bits, saturating
+    std::size_t count = frameCount * 2;
+    std::size_t i = 0;
+
+#ifdef TGE_MIXER_SSE2
+
+    __m128 high = _mm_set1_ps(32767.f);
+    __m128 low  = _mm_set1_ps(-32768.f);
+    for (; i + 8 <= count; i += 8)
+    {
+        __m128i first  = _mm_cvtps_epi32(_mm_max_ps(_mm_min_ps(_mm_loadu_ps(&m_mix[i]), high), low));
+        __m128i second = _mm_cvtps_epi32(_mm_max_ps(_mm_min_ps(_mm_loadu_ps(&m_mix[i + 4]), high), low));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(samples + i), _mm_packs_epi32(first, second));
+    }
+
+#endif
+
+    for (; i < count; ++i)
+    {
+        float value = std::max(std::min(m_mix[i], 32767.f), -32768.f);
+        samples[i] = static_cast<Int16>(std::floor(value + 0.5f));
+    }
+}
+
+
+////////////////////////////////////////////////////////////
+unsigned int SoundMixer::getSampleRate() const
+{
+    return m_sampleRate;
+}
+
+
+////////////////////////////////////////////////////////////
+std::size_t SoundMixer::getVoiceCount() const
+{
+    Lock lock(m_mutex);
+
+    return m_activeCount;
+}
+
+
+////////////////////////////////////////////////////////////
+std::size_t SoundMixer::getMixedVoiceCount() const
+{
+    Lock lock(m_mutex);
+
+    return m_mixedCount;
+}
+
+
+////////////////////////////////////////////////////////////
+SoundMixer::Voice* SoundMixer::findVoice(VoiceId voice)
+{
+    std::size_t slot = (voice & 0xFFFF);
+    if ((slot == 0) || (slot > m_voices.size()))
+        return NULL;
+
+    Voice& state = m_voices[slot - 1];
+    return (state.active && (state.generation == (voice >> 16))) ? &state : NULL;
+}
+
+
+////////////////////////////////////////////////////////////
+const SoundMixer::Voice* SoundMixer::findVoice(VoiceId voice) const
+{
+    return const_cast<SoundMixer*>(this)->findVoice(voice);
+}
+
+
+////////////////////////////////////////////////////////////
+void SoundMixer::computeGains(Voice& voice) const
+{
+    float gain = voice.volume * m_busVolumes[voice.bus];
+
+    // Stereo voices are not spatialized, like with OpenAL
+    if (voice.channelCount == 2)
+    {
+        voice.left  = gain;
+        voice.right = gain;
+        return;
+    }
+
+    float pan = 0.f;
+    if (voice.spatial)
+    {
+        Vector3f offset = voice.position - m_listenerPosition;
+        float distance = std::sqrt(offset.x * offset.x + offset.y * offset.y + offset.z * offset.z);
+
+        float clamped = std::max(distance, voice.minDistance);
+        gain *= voice.minDistance / (voice.minDistance + voice.attenuation * (clamped - voice.minDistance));
+
+        if (distance > 0.f)
+            pan = (offset.x * m_listenerRight.x + offset.y * m_listenerRight.y + offset.z * m_listenerRight.z) / distance;
+    }
+
+    // Equal power panning, the total power doesn't depend on the side
+    float angle = (pan + 1.f) * Pi / 4.f;
+    voice.left  = gain * std::cos(angle);
+    voice.right = gain * std::sin(angle);
+}
+
+
+////////////////////////////////////////////////////////////
+bool SoundMixer::mixVoice(Voice& voice, std::size_t frameCount)
+{
+    // Fade the gains over the block, from their last values
+    float targetLeft  = voice.mixed ? voice.left : 0.f;
+    float targetRight = voice.mixed ? voice.right : 0.f;
+    float leftStep    = (targetLeft - voice.mixedLeft) / frameCount;
+    float rightStep   = (targetRight - voice.mixedRight) / frameCount;
+    double step       = static_cast<double>(voice.rate) * voice.pitch;
+
+    bool playing = true;
+    std::size_t done = 0;
+    while ((done < frameCount) && playing)
+    {
+        // Mix up to the end of the buffer
+        double remaining = step > 0 ? std::ceil((voice.frameCount - voice.offset) / step) : frameCount;
+        std::size_t count = std::min(frameCount - done, static_cast<std::size_t>(remaining));
+
+        float left  = voice.mixedLeft + leftStep * done;
+        float right = voice.mixedRight + rightStep * done;
+        if ((step == 1.0) && (voice.offset == std::floor(voice.offset)))
+            mixExact(voice.samples + static_cast<std::size_t>(voice.offset) * voice.channelCount, voice.channelCount, &m_mix[2 * done], count, left, right, leftStep, rightStep);
+        else
+            mixResampled(voice.samples, voice.frameCount, voice.channelCount, voice.offset, step, &m_mix[2 * done], count, left, right, leftStep, rightStep);
+
+        voice.offset += count * step;
+        done += count;
+
+        if (voice.offset >= voice.frameCount)
+        {
+            if (voice.loop)
+                voice.offset = std::fmod(voice.offset, static_cast<double>(voice.frameCount));
+            else
+                playing = false;
+        }
+    }
+
+    voice.mixedLeft  = targetLeft;
+    voice.mixedRight = targetRight;
+
+    return playing;
+}
+
+
+////////////////////////////////////////////////////////////
+bool SoundMixer::skipVoice(Voice& voice, std::size_t frameCount)
+{
+    voice.offset += frameCount * static_cast<double>(voice.rate) * voice.pitch;
+    if (voice.offset < voice.frameCount)
+        return true;
+
+    if (!voice.loop)
+        return false;
+
+    voice.offset = std::fmod(voice.offset, static_cast<double>(voice.frameCount));
+    return true;
+}
+
+
+////////////////////////////////////////////////////////////
+void SoundMixer::release(std::size_t index)
+{
+    Voice& voice = m_voices[index];
+    if (voice.mixed)
+        m_mixedCount--;
+
+    // A new generation invalidates the handles of the voice
+    voice.active = false;
+    voice.mixed  = false;
+    voice.generation++;
+    if (voice.generation == 0)
+        voice.generation = 1;
+
+    m_activeCount--;
+    m_freeSlots.push_back(index);
+}
+
+} // namespace TGE
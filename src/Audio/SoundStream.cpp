@@ -10,6 +10,7 @@
 #include <Tyrant/Audio/ALCheck.hpp>
 #include <Tyrant/System/Sleep.hpp>
 #include <Tyrant/System/Log.hpp>
+#include <Tyrant/System/Profiler.hpp>
 
 #ifdef _MSC_VER
     #pragma warning(disable : 4355) // 'this' used in base member initializer list
@@ -179,6 +180,8 @@ bool SoundStream::getLoop() const
 ////////////////////////////////////////////////////////////
 void SoundStream::streamData()
 {
+    TGE_PROFILE_THREAD("SoundStream");
+
     // Create the buffers
     alCheck(alGenBuffers(BufferCount, m_buffers));
     for (int i = 0; i < BufferCount; ++i)
@@ -284,6 +287,8 @@ void SoundStream::streamData()
 ////////////////////////////////////////////////////////////
 bool SoundStream::fillAndPushBuffer(unsigned int bufferNum)
 {
+    TGE_PROFILE_SCOPE("SoundStream::fillAndPushBuffer");
+
     bool requestStop = false;
 
     // Acquire audio data
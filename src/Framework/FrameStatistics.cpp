@@ -0,0 +1,112 @@
+/*************************************/
+/** Copyright © 2014 Coldsnap Games **/
+/*************************************/
+
+/*************************************/
+/**             Headers             **/
+/*************************************/
+#include <Tyrant/Framework/FrameStatistics.hpp>
+#include <algorithm>
+#include <cmath>
+
+namespace TGE
+{
+    FrameStatistics::FrameStatistics(unsigned int capacity) :
+    capacity(capacity > 0 ? capacity : 1),
+    next(0),
+    totalFrames(0),
+    lastFrameTime(0)
+    {
+        frameTimes.reserve(this->capacity);
+        frameAllocations.reserve(this->capacity);
+    }
+
+    void FrameStatistics::addFrame(Time frameTime, Uint32 allocationCount)
+    {
+        lastFrameTime = frameTime.asMicroseconds();
+
+        if (frameTimes.size() < capacity)
+        {
+            frameTimes.push_back(lastFrameTime);
+            frameAllocations.push_back(allocationCount);
+        }
+        else
+        {
+            frameTimes[next] = lastFrameTime;
+            frameAllocations[next] = allocationCount;
+        }
+
+        next = (next + 1) % capacity;
+        totalFrames++;
+    }
+
+    void FrameStatistics::clear()
+    {
+        frameTimes.clear();
+        frameAllocations.clear();
+        next = 0;
+        totalFrames = 0;
+        lastFrameTime = 0;
+    }
+
+    unsigned int FrameStatistics::getFrameCount() const
+    {
+        return static_cast<unsigned int>(frameTimes.size());
+    }
+
+    Uint64 FrameStatistics::getTotalFrameCount() const
+    {
+        return totalFrames;
+    }
+
+    Time FrameStatistics::getLastFrameTime() const
+    {
+        return microseconds(lastFrameTime);
+    }
+
+    Time FrameStatistics::getAverage() const
+    {
+        if (frameTimes.empty())
+            return Time::Zero;
+
+        Int64 total = 0;
+        for (std::vector<Int64>::const_iterator itr = frameTimes.begin(); itr != frameTimes.end(); itr++)
+            total += *itr;
+
+        return microseconds(total / static_cast<Int64>(frameTimes.size()));
+    }
+
+    Time FrameStatistics::getPercentile(float percentile) const
+    {
+        if (frameTimes.empty())
+            return Time::Zero;
+
+        percentile = std::min(std::max(percentile, 0.f), 100.f);
+
+        // Nearest-rank percentile: the smallest duration with at least
+        // the given percentage of the frames at or below it, found
+        // without sorting the whole window
+        sorted.assign(frameTimes.begin(), frameTimes.end());
+        std::size_t rank = static_cast<std::size_t>(std::ceil(percentile * sorted.size() / 100.0));
+        rank = (rank > 0) ? rank - 1 : 0;
+        std::nth_element(sorted.begin(), sorted.begin() + rank, sorted.end());
+
+        return microseconds(sorted[rank]);
+    }
+
+    Uint32 FrameStatistics::getLastAllocationCount() const
+    {
+        if (frameAllocations.empty())
+            return 0;
+
+        return frameAllocations[(next + capacity - 1) % capacity];
+    }
+
+    Uint32 FrameStatistics::getMaxAllocationCount() const
+    {
+        if (frameAllocations.empty())
+            return 0;
+
+        return *std::max_element(frameAllocations.begin(), frameAllocations.end());
+    }
+} // namespace TGE
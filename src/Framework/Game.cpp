@@ -8,15 +8,31 @@
 #include <Tyrant/Framework/Game.hpp>
 #include <Tyrant/Graphics.hpp>
 #include <Tyrant/Framework/StateManager.hpp>
+#include <Tyrant/Framework/ResourceManager.hpp>
+#include <Tyrant/System/Thread.hpp>
+#include <Tyrant/System/AllocationCounter.hpp>
+#include <Tyrant/System/ArenaAllocator.hpp>
+#include <Tyrant/System/Profiler.hpp>
 #include <vector>
 #include <string>
 #include <iostream>
 
+namespace
+{
+    // Upper bounds of the frame time buckets, in seconds, around the usual frame rates
+    std::vector<double> frameTimeBounds()
+    {
+        const double bounds[] = {0.001, 0.002, 0.004, 0.008, 1.0 / 120, 1.0 / 60, 0.025, 1.0 / 30, 0.05, 0.1, 0.25, 1};
+        return std::vector<double>(bounds, bounds + sizeof(bounds) / sizeof(*bounds));
+    }
+}
+
 namespace TGE
 {
     Game* Game::instance = 0;
 
-    Game::Game(std::string windowTitle, bool fullscreen, float width, float height)
+    Game::Game(std::string windowTitle, bool fullscreen, float width, float height) :
+    frameHistogram(frameTimeBounds())
     {
         if(fullscreen)
             window = new RenderWindow(VideoMode::getFullscreenModes().front(), windowTitle, Style::Fullscreen);
@@ -33,6 +49,16 @@ namespace TGE
         renderShader = nullptr;
         renderShaderGlobal = nullptr;
         renderPasses = 0;
+        pipelined = false;
+        renderPacket = 0;
+        updateStop = false;
+        timestep = Time::Zero;
+        maxUpdateSteps = 5;
+        interpolationAlpha = 1.f;
+        frameAllocations = 0;
+        metricsServer = nullptr;
+        updateCount = 0;
+        metricsUpdateCount = 0;
     }
 
     void Game::create(std::string windowTitle, bool fullscreen, float width, float height)
@@ -82,15 +108,70 @@ namespace TGE
 
     View Game::getView()
     {
+        // In pipelined mode the render textures belong to the main thread
+        if (pipelined)
+            return pipelinedView;
+
         return renderTexture.getView();
     }
 
     void Game::setView(View view)
     {
-        renderTexture.setView(view);
+        if (pipelined)
+            pipelinedView = view;
+        else
+            renderTexture.setView(view);
         //renderTextureGlobal.setView(view);
     }
 
+    void Game::setPipelined(bool p)
+    {
+        if (p && !pipelined)
+            pipelinedView = renderTexture.getView();
+        else if (!p && pipelined)
+            renderTexture.setView(pipelinedView);
+
+        pipelined = p;
+    }
+
+    bool Game::isPipelined()
+    {
+        return pipelined;
+    }
+
+    void Game::setFixedTimestep(Time step, unsigned int maxSteps)
+    {
+        timestep = step;
+        maxUpdateSteps = maxSteps > 0 ? maxSteps : 1;
+        accumulator = Time::Zero;
+        updateClock.restart();
+    }
+
+    Time Game::getFixedTimestep()
+    {
+        return timestep;
+    }
+
+    float Game::getInterpolationAlpha()
+    {
+        return interpolationAlpha;
+    }
+
+    const FrameStatistics& Game::getFrameStatistics()
+    {
+        return frameStatistics;
+    }
+
+    void Game::setMetricsServer(MetricsServer* server)
+    {
+        metricsServer = server;
+        metricsUpdateCount = updateCount;
+        metricsClock.restart();
+
+        if (metricsServer)
+            metricsServer->addCollector([this](MetricsServer& s) { writeMetrics(s); });
+    }
+
     Game::~Game()
     {
         delete window;
@@ -109,12 +190,76 @@ namespace TGE
         {
             stateManager->changeState(state);
 
-            while(window->isOpen())
+            accumulator = Time::Zero;
+            updateClock.restart();
+            frameClock.restart();
+            frameAllocations = AllocationCounter::getCount();
+
+            if (!pipelined)
             {
-                getInput();
-                stateManager->getActiveState()->update();
-                processEvents();
-                drawScreen();
+                while(window->isOpen())
+                {
+                    TGE_PROFILE_FRAME();
+                    getInput();
+                    runUpdates();
+                    processEvents();
+                    drawScreen();
+                    recordFrameStatistics();
+                }
+            }
+            else
+            {
+                // The worker thread lives as long as the loop, so that any
+                // OpenGL context it needs (fonts, ...) is only created once
+                Thread updateThread(&Game::updateLoop, this);
+                updateStop = false;
+                updateThread.launch();
+
+                // The first rendered frame is the initial state of the scene
+                renderPacket = 0;
+                framePackets[renderPacket].scene.setSize(window->getSize());
+                framePackets[renderPacket].overlay.setSize(window->getSize());
+                recordFrame(framePackets[renderPacket]);
+
+                try
+                {
+                    while(window->isOpen())
+                    {
+                        TGE_PROFILE_FRAME();
+
+                        // Input callbacks run here, while no update is in flight
+                        getInput();
+                        processEvents();
+
+                        // Window queries must stay on the main thread
+                        framePackets[1 - renderPacket].scene.setSize(window->getSize());
+                        framePackets[1 - renderPacket].overlay.setSize(window->getSize());
+
+                        // Update frame N on the worker while frame N-1 is rendered
+                        updateRequest.post();
+                        drawPacket(framePackets[renderPacket]);
+                        updateDone.wait();
+
+                        if (updateError)
+                        {
+                            std::exception_ptr error = updateError;
+                            updateError = std::exception_ptr();
+                            std::rethrow_exception(error);
+                        }
+
+                        renderPacket = 1 - renderPacket;
+                        recordFrameStatistics();
+                    }
+                }
+                catch(...)
+                {
+                    updateStop = true;
+                    updateRequest.post();
+                    throw;
+                }
+
+                updateStop = true;
+                updateRequest.post();
             }
         }
         catch(const char* crashMessage)
@@ -168,29 +313,22 @@ namespace TGE
 
     void Game::drawScreen()
     {
+        TGE_PROFILE_SCOPE("Game::drawScreen");
+
         // the processing power issue is not anywhere in here, i tried returning and nothing dropped
         // ho hi lo ko do mo jo po go yo bo
-        if ((renderTexture.getSize().x != window->getSize().x) || (renderTexture.getSize().y != window->getSize().y))
-        {
-            renderTexture.create(window->getSize().x,window->getSize().y);
-            renderTextureGlobal.create(window->getSize().x,window->getSize().y);
-        }
-        window->clear();
-        renderTexture.clear();
-        renderTextureGlobal.clear();
-
-        std::vector<Drawable*> tempDrawableStack;
-        std::vector<Drawable*> tempDrawableStackOverlay;
-
-        for(std::vector<Drawable*>::iterator itr = stateManager->getActiveState()->drawableStack.begin(); itr != stateManager->getActiveState()->drawableStack.end(); itr++)
-        {
-            tempDrawableStack.push_back(*itr);
-        }
+        beginFrame();
+        drawStack(stateManager->getActiveState()->drawableStack, renderTexture);
+        composeScene(renderTexture.getView(), renderShader, renderPasses);
+        drawStack(stateManager->getActiveState()->drawableStackOverlay, renderTextureGlobal);
+        endFrame(renderShaderGlobal, color);
+    }
 
-        for(std::vector<Drawable*>::iterator itr = stateManager->getActiveState()->drawableStackOverlay.begin(); itr != stateManager->getActiveState()->drawableStackOverlay.end(); itr++)
-        {
-            tempDrawableStackOverlay.push_back(*itr);
-        }
+    void Game::drawStack(const std::vector<Drawable*>& stack, RenderTarget& target)
+    {
+        // The copy lives in the frame arena, so building it doesn't touch the heap
+        typedef std::vector<Drawable*, ArenaAllocator<Drawable*> > FrameDrawableStack;
+        FrameDrawableStack tempDrawableStack(stack.begin(), stack.end(), ArenaAllocator<Drawable*>(MemoryArena::getFrameArena()));
 
         unsigned int i = 0;
 
@@ -204,11 +342,11 @@ namespace TGE
                     {
                         if (tempDrawableStack[ii]->getRenderStates() != nullptr)
                         {
-                            renderTexture.draw(*tempDrawableStack[ii],*tempDrawableStack[ii]->getRenderStates());
+                            target.draw(*tempDrawableStack[ii],*tempDrawableStack[ii]->getRenderStates());
                         }
                         else
                         {
-                            renderTexture.draw(*tempDrawableStack[ii]);
+                            target.draw(*tempDrawableStack[ii]);
                         }
                     }
                     // crashes at 4 2 here when going to menu state... why?
@@ -218,20 +356,35 @@ namespace TGE
             }
             i++;
         }
+    }
 
+    void Game::beginFrame()
+    {
+        if ((renderTexture.getSize().x != window->getSize().x) || (renderTexture.getSize().y != window->getSize().y))
+        {
+            renderTexture.create(window->getSize().x,window->getSize().y);
+            renderTextureGlobal.create(window->getSize().x,window->getSize().y);
+        }
+        window->clear();
+        renderTexture.clear();
+        renderTextureGlobal.clear();
+    }
+
+    void Game::composeScene(const View& sceneView, Shader* shader, unsigned int passes)
+    {
         Sprite sprite(renderTexture.getTexture());
         sprite.setOrigin(window->getSize().x/2,window->getSize().y/2);
         sprite.setScale(1,-1);
         sprite.setPosition(window->getView().getCenter());
-        if ((renderPasses != 0) && (renderShader != nullptr))
+        if ((passes != 0) && (shader != nullptr))
         {
-            renderTextureGlobal.setView(getView());
+            renderTextureGlobal.setView(sceneView);
             renderTexture.setView(window->getView());
-            for (i = 0; i < renderPasses; i++)
+            for (unsigned int i = 0; i < passes; i++)
             {
-                renderShader->setParameter("pass",i);
+                shader->setParameter("pass",i);
                 renderTexture.clear();
-                renderTexture.draw(sprite,renderShader);
+                renderTexture.draw(sprite,shader);
                 sprite.setTexture(renderTexture.getTexture());
             }
             renderTexture.setView(renderTextureGlobal.getView());
@@ -240,56 +393,168 @@ namespace TGE
         }
         else
         {
-            if (renderShader != nullptr)
+            if (shader != nullptr)
             {
-                renderTextureGlobal.draw(sprite,renderShader);
+                renderTextureGlobal.draw(sprite,shader);
             }
             else
             {
                 renderTextureGlobal.draw(sprite);
             }
         }
-        renderTextureGlobal.setView(getView());
+        renderTextureGlobal.setView(sceneView);
+    }
+
+    void Game::endFrame(Shader* shaderGlobal, const Color& c)
+    {
+        Sprite sprite(renderTextureGlobal.getTexture());
+        sprite.setOrigin(window->getSize().x/2,window->getSize().y/2);
+        sprite.setScale(1,-1);
+        renderTextureGlobal.setView(window->getView());
+        sprite.setPosition(window->getView().getCenter());
+        sprite.setColor(c);
+        if (shaderGlobal != nullptr)
+        {
+            window->draw(sprite,shaderGlobal);
+        }
+        else
+        {
+            window->draw(sprite);
+        }
+        window->display();
+    }
 
-        i = 0;
+    void Game::runUpdates()
+    {
+        TGE_PROFILE_SCOPE("Game::runUpdates");
 
-        while(!tempDrawableStackOverlay.empty())
+        if (timestep == Time::Zero)
+        {
+            stateManager->getActiveState()->update();
+            updateCount++;
+            interpolationAlpha = 1.f;
+        }
+        else
         {
-            for(int ii = 0; ii < tempDrawableStackOverlay.size(); ii++)
+            accumulator += updateClock.restart();
+
+            unsigned int steps = 0;
+            while ((accumulator >= timestep) && (steps < maxUpdateSteps))
             {
-                if (tempDrawableStackOverlay[ii]->getDepth() == i)
-                {
-                    if (tempDrawableStackOverlay[ii]->getVisible())
-                    {
-                        if (tempDrawableStackOverlay[ii]->getRenderStates() != nullptr)
-                        {
-                            renderTextureGlobal.draw(*tempDrawableStackOverlay[ii],*tempDrawableStackOverlay[ii]->getRenderStates());
-                        }
-                        else
-                        {
-                            renderTextureGlobal.draw(*tempDrawableStackOverlay[ii]);
-                        }
-                    }
-                    tempDrawableStackOverlay.erase(tempDrawableStackOverlay.begin()+ii);
-                    ii--;
-                }
+                stateManager->getActiveState()->update();
+                updateCount++;
+                accumulator -= timestep;
+                steps++;
             }
-            i++;
+
+            // Still behind after the maximum number of steps: drop the
+            // backlog rather than spiralling into longer and longer frames
+            if (accumulator >= timestep)
+                accumulator = accumulator % timestep;
+
+            interpolationAlpha = accumulator / timestep;
         }
 
-        renderTextureGlobal.setView(window->getView());
-        sprite.setTexture(renderTextureGlobal.getTexture());
-        sprite.setPosition(window->getView().getCenter());
-        sprite.setColor(color);
-        if (renderShaderGlobal != nullptr)
+        stateManager->getActiveState()->interpolate(interpolationAlpha);
+    }
+
+    void Game::updateLoop()
+    {
+        TGE_PROFILE_THREAD("Game update");
+
+        while(true)
         {
-            window->draw(sprite,renderShaderGlobal);
+            updateRequest.wait();
+            if (updateStop)
+                return;
+
+            // Exceptions can't cross threads, hand them over to start()
+            try
+            {
+                runUpdates();
+                recordFrame(framePackets[1 - renderPacket]);
+
+                // This thread never calls display(), which resets the frame arena
+                MemoryArena::getFrameArena().reset();
+            }
+            catch(...)
+            {
+                updateError = std::current_exception();
+            }
+
+            updateDone.post();
         }
-        else
+    }
+
+    void Game::recordFrame(FramePacket& packet)
+    {
+        packet.scene.reset();
+        packet.overlay.reset();
+
+        drawStack(stateManager->getActiveState()->drawableStack, packet.scene);
+        drawStack(stateManager->getActiveState()->drawableStackOverlay, packet.overlay);
+
+        packet.view = pipelinedView;
+        packet.color = color;
+        packet.renderShader = renderShader;
+        packet.renderShaderGlobal = renderShaderGlobal;
+        packet.renderPasses = renderPasses;
+    }
+
+    void Game::drawPacket(FramePacket& packet)
+    {
+        TGE_PROFILE_SCOPE("Game::drawPacket");
+
+        beginFrame();
+        renderTexture.setView(packet.view);
+        packet.scene.replay(renderTexture);
+        composeScene(packet.view, packet.renderShader, packet.renderPasses);
+        packet.overlay.replay(renderTextureGlobal);
+        endFrame(packet.renderShaderGlobal, packet.color);
+    }
+
+    void Game::recordFrameStatistics()
+    {
+        Time frameTime = frameClock.restart();
+        Uint32 allocations = AllocationCounter::getCount();
+        frameStatistics.addFrame(frameTime, allocations - frameAllocations);
+        frameAllocations = allocations;
+
+        // Costs an atomic load per frame while nobody requests the metrics
+        if (metricsServer)
         {
-            window->draw(sprite);
+            frameHistogram.observe(frameTime.asSeconds());
+            metricsServer->update();
         }
-        window->display();
+    }
+
+    void Game::writeMetrics(MetricsServer& server)
+    {
+        server.write("tge_frame_seconds", frameHistogram);
+        server.write(MetricsServer::Gauge, "tge_frame_time_seconds", "quantile", "0.5", frameStatistics.getPercentile(50).asSeconds());
+        server.write(MetricsServer::Gauge, "tge_frame_time_seconds", "quantile", "0.99", frameStatistics.getPercentile(99).asSeconds());
+
+        // Tick rate averaged since the previous collection
+        float elapsed = metricsClock.restart().asSeconds();
+        server.write(MetricsServer::Counter, "tge_ticks_total", static_cast<double>(updateCount));
+        server.write(MetricsServer::Gauge, "tge_tick_rate", (elapsed > 0) ? (updateCount - metricsUpdateCount) / elapsed : 0.0);
+        metricsUpdateCount = updateCount;
+
+        if (AllocationCounter::isEnabled())
+        {
+            server.write(MetricsServer::Counter, "tge_heap_allocations_total", AllocationCounter::getCount());
+            server.write(MetricsServer::Gauge, "tge_frame_heap_allocations", "frame", "last", frameStatistics.getLastAllocationCount());
+            server.write(MetricsServer::Gauge, "tge_frame_heap_allocations", "frame", "max", frameStatistics.getMaxAllocationCount());
+        }
+
+        ResourceManager* resources = ResourceManager::getInstance();
+        server.write(MetricsServer::Gauge, "tge_resource_cached", "type", "texture", static_cast<double>(resources->getTextureCount()));
+        server.write(MetricsServer::Gauge, "tge_resource_cached", "type", "font", static_cast<double>(resources->getFontCount()));
+        server.write(MetricsServer::Gauge, "tge_resource_cached", "type", "sound_buffer", static_cast<double>(resources->getSoundBufferCount()));
+        server.write(MetricsServer::Gauge, "tge_resource_cached", "type", "music", static_cast<double>(resources->getMusicCount()));
+        server.write(MetricsServer::Gauge, "tge_resource_memory_bytes", "type", "texture", static_cast<double>(resources->getTextureMemory()));
+        server.write(MetricsServer::Gauge, "tge_resource_memory_bytes", "type", "sound_buffer", static_cast<double>(resources->getSoundBufferMemory()));
+        server.write(MetricsServer::Gauge, "tge_frame_arena_capacity_bytes", static_cast<double>(MemoryArena::getFrameArena().getCapacity()));
     }
 
     StateManager* Game::getStateManager()
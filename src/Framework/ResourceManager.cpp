@@ -6,6 +6,8 @@
 /**             Headers             **/
 /*************************************/
 #include <Tyrant/Framework/ResourceManager.hpp>
+#include <algorithm>
+#include <cmath>
 
 namespace TGE
 {
@@ -29,14 +31,15 @@ namespace TGE
 
         fontMap.clear();
 
-        for(std::map<std::string, SoundBuffer*>::iterator itr = soundBufferMap.begin(); itr != soundBufferMap.end(); itr++)
+        // The sounds first, they are attached to the buffers of the entries
+        for(std::vector<SoundInstance>::iterator itr = soundInstances.begin(); itr != soundInstances.end(); itr++)
         {
-            delete itr->second;
+            delete itr->sound;
         }
 
-        soundBufferMap.clear();
+        soundInstances.clear();
 
-        for(std::map<std::string, Sound*>::iterator itr = soundMap.begin(); itr != soundMap.end(); itr++)
+        for(std::map<std::string, SoundEntry*>::iterator itr = soundMap.begin(); itr != soundMap.end(); itr++)
         {
             delete itr->second;
         }
@@ -102,68 +105,216 @@ namespace TGE
     void ResourceManager::setSoundVolume(float volume)
     {
         *soundVolume = volume;
+
+        // The free instances are set again when played
+        for(std::vector<SoundInstance>::iterator itr = soundInstances.begin(); itr != soundInstances.end(); itr++)
+            itr->sound->setVolume(*soundVolume * itr->volume / 100.f);
     }
 
-    void ResourceManager::playSound(std::string pathToSound, bool loop)
+    ResourceManager::SoundHandle ResourceManager::playSound(const std::string& pathToSound, bool loop)
     {
-        if(soundMap.find(pathToSound) == soundMap.end())
-        {
-            soundBufferMap[pathToSound] = new SoundBuffer();
+        SoundEntry& entry = requestSound(pathToSound);
+        std::size_t index = acquire(entry);
+        if(index == getSlotCount())
+            return 0;
+
+        SoundInstance& instance = soundInstances[index];
+        instance.volume = 100.f;
+
+        // A recycled sound keeps the buffer and the settings of its previous instance
+        if(instance.sound->getBuffer() != &entry.buffer)
+            instance.sound->setBuffer(entry.buffer);
+        instance.sound->setLoop(loop);
+        instance.sound->setPitch(1.f);
+        instance.sound->setPosition(0.f, 0.f, 0.f);
+        instance.sound->setVolume(*soundVolume);
+        instance.sound->play();
+
+        return getHandle(index);
+    }
 
-            if(!soundBufferMap[pathToSound]->loadFromFile(pathToSound))
-                throw("SOUND_NOT_FOUND " + pathToSound);
+    void ResourceManager::pauseSound(const std::string& pathToSound)
+    {
+        std::map<std::string, SoundEntry*>::iterator itr = soundMap.find(pathToSound);
+        if(itr == soundMap.end())
+            return;
 
-            soundMap[pathToSound] = new Sound();
-            soundMap[pathToSound]->setBuffer(*soundBufferMap[pathToSound]);
-            soundMap[pathToSound]->setVolume(*soundVolume);
+        const std::vector<std::size_t>& instances = itr->second->instances;
+        for(std::size_t i = 0; i < instances.size(); i++)
+            soundInstances[instances[i]].sound->pause();
+    }
+
+    void ResourceManager::resumeSound(const std::string& pathToSound)
+    {
+        std::map<std::string, SoundEntry*>::iterator itr = soundMap.find(pathToSound);
+        if(itr == soundMap.end())
+            return;
+
+        const std::vector<std::size_t>& instances = itr->second->instances;
+        for(std::size_t i = 0; i < instances.size(); i++)
+        {
+            Sound* sound = soundInstances[instances[i]].sound;
+            if(sound->getStatus() == Sound::Paused)
+                sound->play();
         }
+    }
 
-        soundMap[pathToSound]->setLoop(loop);
-        soundMap[pathToSound]->play();
+    void ResourceManager::stopSound(const std::string& pathToSound)
+    {
+        std::map<std::string, SoundEntry*>::iterator itr = soundMap.find(pathToSound);
+        if(itr == soundMap.end())
+            return;
+
+        // Releasing an instance removes it from the entry
+        std::vector<std::size_t>& instances = itr->second->instances;
+        while(!instances.empty())
+            release(instances.back());
     }
 
-    void ResourceManager::pauseSound(std::string pathToSound)
+    void ResourceManager::loopSound(const std::string& pathToSound, bool loop)
     {
-        if(soundMap.find(pathToSound) != soundMap.end())
-            soundMap[pathToSound]->pause();
+        const std::vector<std::size_t>& instances = requestSound(pathToSound).instances;
+        for(std::size_t i = 0; i < instances.size(); i++)
+            soundInstances[instances[i]].sound->setLoop(loop);
     }
 
-    void ResourceManager::stopSound(std::string pathToSound)
+    Time ResourceManager::getSoundDuration(const std::string& pathToSound)
     {
-        if(soundMap.find(pathToSound) != soundMap.end())
-            soundMap[pathToSound]->stop();
+        return requestSound(pathToSound).buffer.getDuration();
     }
 
-    void ResourceManager::loopSound(std::string pathToSound, bool loop)
+    void ResourceManager::setSoundInstanceLimit(const std::string& pathToSound, unsigned int maxInstances, StealPolicy policy)
     {
-        if(soundMap.find(pathToSound) == soundMap.end())
-        {
-            soundBufferMap[pathToSound] = new SoundBuffer();
-            if(!soundBufferMap[pathToSound]->loadFromFile(pathToSound))
-                throw("SOUND_NOT_FOUND " + pathToSound);
+        SoundEntry& entry = requestSound(pathToSound);
+        entry.maxInstances = std::max(maxInstances, 1u);
+        entry.policy = policy;
+    }
+
+    void ResourceManager::setMaxSoundInstances(unsigned int maxInstances)
+    {
+        setMaxInstances(maxInstances);
+    }
+
+    void ResourceManager::pauseSound(SoundHandle sound)
+    {
+        if(SoundInstance* instance = findSoundInstance(sound))
+            instance->sound->pause();
+    }
 
-            soundMap[pathToSound] = new Sound();
-            soundMap[pathToSound]->setBuffer(*soundBufferMap[pathToSound]);
-            soundMap[pathToSound]->setVolume(*soundVolume);
+    void ResourceManager::resumeSound(SoundHandle sound)
+    {
+        SoundInstance* instance = findSoundInstance(sound);
+        if(instance != NULL && instance->sound->getStatus() == Sound::Paused)
+            instance->sound->play();
+    }
+
+    void ResourceManager::stopSound(SoundHandle sound)
+    {
+        std::size_t index = find(sound);
+        if(index != getSlotCount())
+            release(index);
+    }
+
+    void ResourceManager::loopSound(SoundHandle sound, bool loop)
+    {
+        if(SoundInstance* instance = findSoundInstance(sound))
+            instance->sound->setLoop(loop);
+    }
+
+    void ResourceManager::setSoundVolume(SoundHandle sound, float volume)
+    {
+        if(SoundInstance* instance = findSoundInstance(sound))
+        {
+            instance->volume = volume;
+            instance->sound->setVolume(*soundVolume * volume / 100.f);
         }
+    }
+
+    void ResourceManager::setSoundPitch(SoundHandle sound, float pitch)
+    {
+        if(SoundInstance* instance = findSoundInstance(sound))
+            instance->sound->setPitch(pitch);
+    }
 
-        soundMap[pathToSound]->setLoop(loop);
+    void ResourceManager::setSoundPosition(SoundHandle sound, const Vector3f& position)
+    {
+        if(SoundInstance* instance = findSoundInstance(sound))
+            instance->sound->setPosition(position);
+    }
+
+    bool ResourceManager::isSoundPlaying(SoundHandle sound) const
+    {
+        const SoundInstance* instance = findSoundInstance(sound);
+        return instance != NULL && instance->sound->getStatus() == Sound::Playing;
+    }
+
+    void ResourceManager::stopAllSounds()
+    {
+        releaseAll();
     }
 
-    Time ResourceManager::getSoundDuration(std::string pathToSound)
+    ResourceManager::SoundEntry& ResourceManager::requestSound(const std::string& pathToSound)
     {
-        if(soundMap.find(pathToSound) == soundMap.end())
+        std::map<std::string, SoundEntry*>::iterator itr = soundMap.lower_bound(pathToSound);
+        if(itr == soundMap.end() || itr->first != pathToSound)
         {
-            soundBufferMap[pathToSound] = new SoundBuffer();
-            if(!soundBufferMap[pathToSound]->loadFromFile(pathToSound))
+            SoundEntry* newEntry = new SoundEntry();
+            if(!newEntry->buffer.loadFromFile(pathToSound))
+            {
+                delete newEntry;
                 throw("SOUND_NOT_FOUND " + pathToSound);
+            }
 
-            soundMap[pathToSound] = new Sound();
-            soundMap[pathToSound]->setBuffer(*soundBufferMap[pathToSound]);
-            soundMap[pathToSound]->setVolume(*soundVolume);
+            itr = soundMap.insert(itr, std::make_pair(pathToSound, newEntry));
         }
 
-        return soundBufferMap[pathToSound]->getDuration();
+        return *itr->second;
+    }
+
+    ResourceManager::SoundInstance* ResourceManager::findSoundInstance(SoundHandle sound)
+    {
+        std::size_t index = find(sound);
+        return index != getSlotCount() ? &soundInstances[index] : NULL;
+    }
+
+    const ResourceManager::SoundInstance* ResourceManager::findSoundInstance(SoundHandle sound) const
+    {
+        return const_cast<ResourceManager*>(this)->findSoundInstance(sound);
+    }
+
+    void ResourceManager::onCreate(std::size_t)
+    {
+        SoundInstance newInstance;
+        newInstance.sound = new Sound();
+        newInstance.volume = 100.f;
+        soundInstances.push_back(newInstance);
+    }
+
+    bool ResourceManager::isFinished(std::size_t index) const
+    {
+        return soundInstances[index].sound->getStatus() == Sound::Stopped;
+    }
+
+    float ResourceManager::getGain(std::size_t index) const
+    {
+        // Same distance model as OpenAL, clamped below the minimum distance
+        const SoundInstance& instance = soundInstances[index];
+        Vector3f offset = instance.sound->getPosition();
+        if(!instance.sound->isRelativeToListener())
+            offset -= Listener::getPosition();
+
+        float distance = std::sqrt(offset.x * offset.x + offset.y * offset.y + offset.z * offset.z);
+        float minDistance = instance.sound->getMinDistance();
+        float gain = instance.volume;
+        if(distance > minDistance)
+            gain *= minDistance / (minDistance + instance.sound->getAttenuation() * (distance - minDistance));
+
+        return gain;
+    }
+
+    void ResourceManager::onStop(std::size_t index)
+    {
+        soundInstances[index].sound->stop();
     }
 
     void ResourceManager::playMusic(std::string pathToMusic, bool loop)
@@ -224,4 +375,49 @@ namespace TGE
 
         return musicMap[pathToMusic]->getDuration();
     }
+
+    std::size_t ResourceManager::getTextureCount() const
+    {
+        return textureMap.size();
+    }
+
+    std::size_t ResourceManager::getFontCount() const
+    {
+        return fontMap.size();
+    }
+
+    std::size_t ResourceManager::getSoundBufferCount() const
+    {
+        return soundMap.size();
+    }
+
+    std::size_t ResourceManager::getMusicCount() const
+    {
+        return musicMap.size();
+    }
+
+    std::size_t ResourceManager::getSoundInstanceCount() const
+    {
+        return getInstanceCount();
+    }
+
+    Uint64 ResourceManager::getTextureMemory() const
+    {
+        // RGBA, 4 bytes per pixel
+        Uint64 size = 0;
+        for(std::map<std::string, Texture*>::const_iterator itr = textureMap.begin(); itr != textureMap.end(); itr++)
+            size += static_cast<Uint64>(itr->second->getSize().x) * itr->second->getSize().y * 4;
+
+        return size;
+    }
+
+    Uint64 ResourceManager::getSoundBufferMemory() const
+    {
+        // 16-bit samples
+        Uint64 size = 0;
+        for(std::map<std::string, SoundEntry*>::const_iterator itr = soundMap.begin(); itr != soundMap.end(); itr++)
+            size += static_cast<Uint64>(itr->second->buffer.getSampleCount()) * sizeof(Int16);
+
+        return size;
+    }
 }
@@ -0,0 +1,190 @@
+/*************************************/
+/** Copyright © 2014 Coldsnap Games **/
+/*************************************/
+
+/*************************************/
+/**             Headers             **/
+/*************************************/
+#include <Tyrant/Framework/SoundInstancePool.hpp>
+#include <algorithm>
+
+namespace
+{
+    // Instances of a group playing at once, unless set otherwise
+    const unsigned int DefaultGroupLimit = 8;
+
+    // Instances of all the groups playing at once, well below the sources of usual devices
+    const unsigned int DefaultMaxInstances = 64;
+
+    // Handles keep the index of the instance in their 16 low bits
+    const unsigned int MaxInstances = 0xFFFF;
+}
+
+namespace TGE
+{
+    SoundInstancePool::Group::Group() :
+    maxInstances(DefaultGroupLimit),
+    policy(StealOldest)
+    {
+    }
+
+    SoundInstancePool::SoundInstancePool() :
+    maxInstances(DefaultMaxInstances),
+    nextOrder(0)
+    {
+    }
+
+    SoundInstancePool::~SoundInstancePool()
+    {
+    }
+
+    void SoundInstancePool::setMaxInstances(unsigned int maxInstances)
+    {
+        this->maxInstances = std::min(std::max(maxInstances, 1u), MaxInstances);
+    }
+
+    std::size_t SoundInstancePool::acquire(Group& group)
+    {
+        // The finished instances of the group don't count towards its limit
+        for (std::size_t i = group.instances.size(); i > 0; i--)
+        {
+            if (isFinished(group.instances[i - 1]))
+                release(group.instances[i - 1]);
+        }
+
+        if (group.instances.size() >= group.maxInstances)
+        {
+            if (group.policy == StealNone)
+                return slots.size();
+
+            // The stolen instance keeps its sound, only its handle changes
+            std::size_t victim = group.instances[0];
+            float victimGain = 0.f;
+            for (std::size_t i = 0; i < group.instances.size(); i++)
+            {
+                std::size_t index = group.instances[i];
+                if (group.policy == StealOldest)
+                {
+                    if (isOlder(index, victim))
+                        victim = index;
+                }
+                else
+                {
+                    float gain = getGain(index);
+                    if (i == 0 || gain < victimGain)
+                    {
+                        victim = index;
+                        victimGain = gain;
+                    }
+                }
+            }
+
+            onStop(victim);
+            slots[victim].generation++;
+            slots[victim].order = nextOrder++;
+            return victim;
+        }
+
+        if (freeSlots.empty())
+        {
+            for (std::size_t i = 0; i < slots.size(); i++)
+            {
+                if (slots[i].group != NULL && isFinished(i))
+                    release(i);
+            }
+        }
+
+        if (freeSlots.empty())
+        {
+            if (slots.size() < maxInstances)
+            {
+                Slot slot;
+                slot.group = NULL;
+                slot.generation = 0;
+                slot.order = 0;
+                slots.push_back(slot);
+                freeSlots.push_back(slots.size() - 1);
+                onCreate(slots.size() - 1);
+            }
+            else
+            {
+                // All the instances are playing, the oldest of all the groups makes room
+                std::size_t victim = 0;
+                for (std::size_t i = 1; i < slots.size(); i++)
+                {
+                    if (isOlder(i, victim))
+                        victim = i;
+                }
+
+                release(victim);
+            }
+        }
+
+        std::size_t index = freeSlots.back();
+        freeSlots.pop_back();
+
+        slots[index].group = &group;
+        slots[index].order = nextOrder++;
+        group.instances.push_back(index);
+
+        return index;
+    }
+
+    void SoundInstancePool::release(std::size_t index)
+    {
+        Slot& slot = slots[index];
+        onStop(index);
+        slot.generation++;
+
+        std::vector<std::size_t>& instances = slot.group->instances;
+        std::vector<std::size_t>::iterator itr = std::find(instances.begin(), instances.end(), index);
+        *itr = instances.back();
+        instances.pop_back();
+
+        slot.group = NULL;
+        freeSlots.push_back(index);
+    }
+
+    void SoundInstancePool::releaseAll()
+    {
+        for (std::size_t i = 0; i < slots.size(); i++)
+        {
+            if (slots[i].group != NULL)
+                release(i);
+        }
+    }
+
+    SoundInstancePool::Handle SoundInstancePool::getHandle(std::size_t index) const
+    {
+        return (static_cast<Uint32>(slots[index].generation) << 16) | static_cast<Uint32>(index + 1);
+    }
+
+    std::size_t SoundInstancePool::find(Handle handle) const
+    {
+        std::size_t index = handle & 0xFFFF;
+        if (index == 0 || index > slots.size())
+            return slots.size();
+
+        const Slot& slot = slots[index - 1];
+        if (slot.group == NULL || slot.generation != (handle >> 16))
+            return slots.size();
+
+        return index - 1;
+    }
+
+    std::size_t SoundInstancePool::getSlotCount() const
+    {
+        return slots.size();
+    }
+
+    std::size_t SoundInstancePool::getInstanceCount() const
+    {
+        return slots.size() - freeSlots.size();
+    }
+
+    bool SoundInstancePool::isOlder(std::size_t first, std::size_t second) const
+    {
+        // The orders wrap around, the difference doesn't
+        return slots[first].order - slots[second].order > 0x7FFFFFFF;
+    }
+}
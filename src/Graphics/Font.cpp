@@ -8,7 +8,9 @@
 #include <Tyrant/Graphics/Font.hpp>
 #include <Tyrant/Graphics/GLCheck.hpp>
 #include <Tyrant/System/InputStream.hpp>
+#include <Tyrant/System/Lock.hpp>
 #include <Tyrant/System/Log.hpp>
+#include <Tyrant/System/Profiler.hpp>
 #include <ft2build.h>
 #include FT_FREETYPE_H
 #include FT_GLYPH_H
@@ -48,7 +50,8 @@ m_library  (NULL),
 m_face     (NULL),
 m_streamRec(NULL),
 m_refCount (NULL),
-m_info     ()
+m_info     (),
+m_mutex    (Mutex::Recursive)
 {}
 
 
@@ -60,7 +63,8 @@ m_streamRec  (copy.m_streamRec),
 m_refCount   (copy.m_refCount),
 m_info       (copy.m_info),
 m_pages      (copy.m_pages),
-m_pixelBuffer(copy.m_pixelBuffer)
+m_pixelBuffer(copy.m_pixelBuffer),
+m_mutex      (Mutex::Recursive)
 {
     // Note: as FreeType doesn't provide functions for copying/cloning,
     // we must share all the FreeType pointers
@@ -241,6 +245,9 @@ const Font::Info& Font::getInfo() const
 ////////////////////////////////////////////////////////////
 const Glyph& Font::getGlyph(Uint32 codePoint, unsigned int characterSize, bool bold) const
 {
+    // Loading a glyph updates the page texture, which another thread may be drawing with
+    Lock lock(m_mutex);
+
     // Get the page corresponding to the character size
     GlyphTable& glyphs = m_pages[characterSize].glyphs;
 
@@ -270,6 +277,8 @@ int Font::getKerning(Uint32 first, Uint32 second, unsigned int characterSize) co
     if (first == 0 || second == 0)
         return 0;
 
+    Lock lock(m_mutex);
+
     FT_Face face = static_cast<FT_Face>(m_face);
 
     if (face && FT_HAS_KERNING(face) && setCurrentSize(characterSize))
@@ -296,6 +305,8 @@ int Font::getKerning(Uint32 first, Uint32 second, unsigned int characterSize) co
 ////////////////////////////////////////////////////////////
 int Font::getLineSpacing(unsigned int characterSize) const
 {
+    Lock lock(m_mutex);
+
     FT_Face face = static_cast<FT_Face>(m_face);
 
     if (face && setCurrentSize(characterSize))
@@ -312,6 +323,8 @@ int Font::getLineSpacing(unsigned int characterSize) const
 ////////////////////////////////////////////////////////////
 const Texture& Font::getTexture(unsigned int characterSize) const
 {
+    Lock lock(m_mutex);
+
     return m_pages[characterSize].texture;
 }
 
@@ -375,6 +388,8 @@ void Font::cleanup()
 ////////////////////////////////////////////////////////////
 Glyph Font::loadGlyph(Uint32 codePoint, unsigned int characterSize, bool bold) const
 {
+    TGE_PROFILE_SCOPE("Font::loadGlyph");
+
     // The glyph to return
     Glyph glyph;
 
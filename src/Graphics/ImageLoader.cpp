@@ -8,6 +8,7 @@
 #include <Tyrant/Graphics/ImageLoader.hpp>
 #include <Tyrant/System/InputStream.hpp>
 #include <Tyrant/System/Log.hpp>
+#include <Tyrant/System/Profiler.hpp>
 #include <Tyrant/Graphics/stb_image/stb_image.h>
 #define STB_IMAGE_WRITE_IMPLEMENTATION
 #include <Tyrant/Graphics/stb_image/stb_image_write.h>
@@ -78,6 +79,8 @@ ImageLoader::~ImageLoader()
 ////////////////////////////////////////////////////////////
 bool ImageLoader::loadImageFromFile(const std::string& filename, std::vector<Uint8>& pixels, Vector2u& size)
 {
+    TGE_PROFILE_SCOPE("ImageLoader::loadImageFromFile");
+
     // Clear the array (just in case)
     pixels.clear();
 
@@ -113,6 +116,8 @@ bool ImageLoader::loadImageFromFile(const std::string& filename, std::vector<Uin
 ////////////////////////////////////////////////////////////
 bool ImageLoader::loadImageFromMemory(const void* data, std::size_t dataSize, std::vector<Uint8>& pixels, Vector2u& size)
 {
+    TGE_PROFILE_SCOPE("ImageLoader::loadImageFromMemory");
+
     // Check input parameters
     if (data && dataSize)
     {
@@ -158,6 +163,8 @@ bool ImageLoader::loadImageFromMemory(const void* data, std::size_t dataSize, st
 ////////////////////////////////////////////////////////////
 bool ImageLoader::loadImageFromStream(InputStream& stream, std::vector<Uint8>& pixels, Vector2u& size)
 {
+    TGE_PROFILE_SCOPE("ImageLoader::loadImageFromStream");
+
     // Clear the array (just in case)
     pixels.clear();
 
@@ -202,6 +209,8 @@ bool ImageLoader::loadImageFromStream(InputStream& stream, std::vector<Uint8>& p
 ////////////////////////////////////////////////////////////
 bool ImageLoader::saveImageToFile(const std::string& filename, const std::vector<Uint8>& pixels, const Vector2u& size)
 {
+    TGE_PROFILE_SCOPE("ImageLoader::saveImageToFile");
+
     // Make sure the image is not empty
     if (!pixels.empty() && (size.x > 0) && (size.y > 0))
     {
@@ -0,0 +1,470 @@
+/*************************************/
+/** Copyright © 2014 Coldsnap Games **/
+/*************************************/
+
+/*************************************/
+/**             Headers             **/
+/*************************************/
+#include <Tyrant/Graphics/InstancedSpriteBatch.hpp>
+#include <Tyrant/Graphics/RenderTarget.hpp>
+#include <Tyrant/Graphics/Shader.hpp>
+#include <Tyrant/Graphics/Texture.hpp>
+#include <Tyrant/Graphics/GLCheck.hpp>
+#include <Tyrant/System/Log.hpp>
+#include <cmath>
+#include <cstdlib>
+
+
+namespace
+{
+    // Generic attribute locations of the per-instance data. Some drivers
+    // (NVIDIA) alias the generic attributes with the conventional arrays:
+    // 0 gl_Vertex, 2 gl_Normal, 3 gl_Color, 4 gl_SecondaryColor, 5 gl_FogCoord
+    // and 8 gl_MultiTexCoord0, so the locations avoid the arrays the
+    // renderer enables (vertex, color and first texture coordinates)
+    enum
+    {
+        TransformLocation = 6,  // position.x, position.y, rotation, scale.x
+        ScaleYLocation    = 7,  // scale.y
+        RectLocation      = 9,  // texture rect
+        ColorLocation     = 10  // color
+    };
+
+    const GLuint instanceLocations[] = {TransformLocation, ScaleYLocation, RectLocation, ColorLocation};
+    const std::size_t instanceLocationCount = sizeof(instanceLocations) / sizeof(*instanceLocations);
+
+    // Unit quad expanded by the vertex shader, as a triangle strip
+    const TGE::Vertex unitQuad[4] =
+    {
+        TGE::Vertex(TGE::Vector2f(0.f, 0.f)),
+        TGE::Vertex(TGE::Vector2f(0.f, 1.f)),
+        TGE::Vertex(TGE::Vector2f(1.f, 0.f)),
+        TGE::Vertex(TGE::Vector2f(1.f, 1.f))
+    };
+
+    // Vertex shader: rebuilds the sprite transform of each instance
+    // (see Transformable::getTransform) and applies it to the unit quad
+    const char* vertexShaderCode =
+        "uniform vec2 origin;"
+        "attribute vec4 instanceTransform;"
+        "attribute float instanceScaleY;"
+        "attribute vec4 instanceRect;"
+        "attribute vec4 instanceColor;"
+        "void main()"
+        "{"
+        "    vec2 size = abs(instanceRect.zw);"
+        "    vec2 local = (gl_Vertex.xy - origin) * size * vec2(instanceTransform.w, instanceScaleY);"
+        "    float angle = radians(instanceTransform.z);"
+        "    float c = cos(angle);"
+        "    float s = sin(angle);"
+        "    vec2 world = vec2(c * local.x - s * local.y, s * local.x + c * local.y) + instanceTransform.xy;"
+        "    gl_Position = gl_ModelViewProjectionMatrix * vec4(world, 0.0, 1.0);"
+        "    gl_TexCoord[0] = gl_TextureMatrix[0] * vec4(instanceRect.xy + gl_Vertex.xy * instanceRect.zw, 0.0, 1.0);"
+        "    gl_FrontColor = instanceColor;"
+        "}";
+
+    // Fragment shader: same as the fixed pipeline used by regular sprites
+    const char* fragmentShaderCode =
+        "uniform sampler2D texture;"
+        "void main()"
+        "{"
+        "    gl_FragColor = gl_Color * texture2D(texture, gl_TexCoord[0].xy);"
+        "}";
+
+    // Compile a shader object, returns 0 on failure
+    GLhandleARB compileShader(GLenum type, const char* code)
+    {
+        GLhandleARB shader = glCheck(glCreateShaderObjectARB(type));
+        glCheck(glShaderSourceARB(shader, 1, &code, nullptr));
+        glCheck(glCompileShaderARB(shader));
+
+        GLint success;
+        glCheck(glGetObjectParameterivARB(shader, GL_OBJECT_COMPILE_STATUS_ARB, &success));
+        if (success == GL_FALSE)
+        {
+            char log[1024];
+            glCheck(glGetInfoLogARB(shader, sizeof(log), nullptr, log));
+            TGE::Log() << "Failed to compile instanced sprite shader:" << std::endl
+                       << log << std::endl;
+            glCheck(glDeleteObjectARB(shader));
+            return 0;
+        }
+
+        return shader;
+    }
+}
+
+
+namespace TGE
+{
+////////////////////////////////////////////////////////////
+InstancedSpriteBatch::Instance::Instance() :
+position(0.f, 0.f),
+rotation(0.f),
+scale   (1.f, 1.f),
+color   (Color::White)
+{
+    setTextureRect(IntRect());
+}
+
+
+////////////////////////////////////////////////////////////
+InstancedSpriteBatch::Instance::Instance(const Vector2f& thePosition, const IntRect& theTextureRect, const Color& theColor,
+                                         float theRotation, const Vector2f& theScale) :
+position(thePosition),
+rotation(theRotation),
+scale   (theScale),
+color   (theColor)
+{
+    setTextureRect(theTextureRect);
+}
+
+
+////////////////////////////////////////////////////////////
+void InstancedSpriteBatch::Instance::setTextureRect(const IntRect& rectangle)
+{
+    textureRect[0] = static_cast<Int16>(rectangle.left);
+    textureRect[1] = static_cast<Int16>(rectangle.top);
+    textureRect[2] = static_cast<Int16>(rectangle.width);
+    textureRect[3] = static_cast<Int16>(rectangle.height);
+}
+
+
+////////////////////////////////////////////////////////////
+IntRect InstancedSpriteBatch::Instance::getTextureRect() const
+{
+    return IntRect(textureRect[0], textureRect[1], textureRect[2], textureRect[3]);
+}
+
+
+////////////////////////////////////////////////////////////
+InstancedSpriteBatch::InstancedSpriteBatch() :
+m_instances     (),
+m_texture       (NULL),
+m_instanceOrigin(0.f, 0.f),
+m_vertices      (),
+m_program       (0),
+m_originLocation(-1),
+m_buffer        (0),
+m_bufferSize    (0),
+m_programFailed (false)
+{
+}
+
+
+////////////////////////////////////////////////////////////
+InstancedSpriteBatch::InstancedSpriteBatch(const Texture& texture) :
+m_instances     (),
+m_texture       (&texture),
+m_instanceOrigin(0.f, 0.f),
+m_vertices      (),
+m_program       (0),
+m_originLocation(-1),
+m_buffer        (0),
+m_bufferSize    (0),
+m_programFailed (false)
+{
+}
+
+
+////////////////////////////////////////////////////////////
+InstancedSpriteBatch::~InstancedSpriteBatch()
+{
+    // Destroy the OpenGL objects
+    if (m_program || m_buffer)
+    {
+        ensureGlContext();
+
+        if (m_program)
+        {
+            glCheck(glDeleteObjectARB(m_program));
+        }
+
+        if (m_buffer)
+        {
+            GLuint buffer = static_cast<GLuint>(m_buffer);
+            glCheck(glDeleteBuffersARB(1, &buffer));
+        }
+    }
+}
+
+
+////////////////////////////////////////////////////////////
+void InstancedSpriteBatch::setTexture(const Texture& texture)
+{
+    m_texture = &texture;
+}
+
+
+////////////////////////////////////////////////////////////
+const Texture* InstancedSpriteBatch::getTexture() const
+{
+    return m_texture;
+}
+
+
+////////////////////////////////////////////////////////////
+void InstancedSpriteBatch::setInstanceOrigin(const Vector2f& origin)
+{
+    m_instanceOrigin = origin;
+}
+
+
+////////////////////////////////////////////////////////////
+const Vector2f& InstancedSpriteBatch::getInstanceOrigin() const
+{
+    return m_instanceOrigin;
+}
+
+
+////////////////////////////////////////////////////////////
+unsigned int InstancedSpriteBatch::getInstanceCount() const
+{
+    return static_cast<unsigned int>(m_instances.size());
+}
+
+
+////////////////////////////////////////////////////////////
+InstancedSpriteBatch::Instance& InstancedSpriteBatch::operator [](unsigned int index)
+{
+    return m_instances[index];
+}
+
+
+////////////////////////////////////////////////////////////
+const InstancedSpriteBatch::Instance& InstancedSpriteBatch::operator [](unsigned int index) const
+{
+    return m_instances[index];
+}
+
+
+////////////////////////////////////////////////////////////
+void InstancedSpriteBatch::append(const Instance& instance)
+{
+    m_instances.push_back(instance);
+}
+
+
+////////////////////////////////////////////////////////////
+void InstancedSpriteBatch::resize(unsigned int instanceCount)
+{
+    m_instances.resize(instanceCount);
+}
+
+
+////////////////////////////////////////////////////////////
+void InstancedSpriteBatch::reserve(unsigned int instanceCount)
+{
+    m_instances.reserve(instanceCount);
+}
+
+
+////////////////////////////////////////////////////////////
+void InstancedSpriteBatch::clear()
+{
+    m_instances.clear();
+}
+
+
+////////////////////////////////////////////////////////////
+bool InstancedSpriteBatch::isInstancingAvailable()
+{
+    ensureGlContext();
+
+    // Make sure that extensions are initialized
+    priv::ensureExtensionsInit();
+
+    return Shader::isAvailable()            &&
+           GLEW_ARB_vertex_buffer_object    &&
+           GLEW_ARB_instanced_arrays        &&
+           GLEW_ARB_draw_instanced;
+}
+
+
+////////////////////////////////////////////////////////////
+void InstancedSpriteBatch::draw(RenderTarget& target, RenderStates states) const
+{
+    if (!m_texture || m_instances.empty())
+        return;
+
+    states.transform *= getTransform();
+    states.texture = m_texture;
+
+    // A user shader doesn't know about our per-instance attributes
+    if (states.shader || !drawInstanced(target, states))
+        drawExpanded(target, states);
+}
+
+
+////////////////////////////////////////////////////////////
+bool InstancedSpriteBatch::drawInstanced(RenderTarget& target, const RenderStates& states) const
+{
+    if (m_programFailed)
+        return false;
+
+    // Targets that can't be activated (like RenderQueue) get the expanded vertices
+    if (!target.applyStates(states))
+        return false;
+
+    if (!isInstancingAvailable() || !ensureProgram())
+        return false;
+
+    // Upload the instances, orphaning the previous storage so that
+    // we don't have to wait for the GPU to finish with it
+    std::size_t size = m_instances.size() * sizeof(Instance);
+    glCheck(glBindBufferARB(GL_ARRAY_BUFFER_ARB, m_buffer));
+    if (size > m_bufferSize)
+    {
+        glCheck(glBufferDataARB(GL_ARRAY_BUFFER_ARB, size, &m_instances[0], GL_STREAM_DRAW_ARB));
+        m_bufferSize = size;
+    }
+    else
+    {
+        glCheck(glBufferDataARB(GL_ARRAY_BUFFER_ARB, m_bufferSize, NULL, GL_STREAM_DRAW_ARB));
+        glCheck(glBufferSubDataARB(GL_ARRAY_BUFFER_ARB, 0, size, &m_instances[0]));
+    }
+
+    // Setup the per-instance attributes
+    const char* base = NULL;
+    glCheck(glVertexAttribPointerARB(TransformLocation, 4, GL_FLOAT,         GL_FALSE, sizeof(Instance), base + 0));
+    glCheck(glVertexAttribPointerARB(ScaleYLocation,    1, GL_FLOAT,         GL_FALSE, sizeof(Instance), base + 16));
+    glCheck(glVertexAttribPointerARB(RectLocation,      4, GL_SHORT,         GL_FALSE, sizeof(Instance), base + 20));
+    glCheck(glVertexAttribPointerARB(ColorLocation,     4, GL_UNSIGNED_BYTE, GL_TRUE,  sizeof(Instance), base + 28));
+    for (std::size_t i = 0; i < instanceLocationCount; ++i)
+    {
+        glCheck(glEnableVertexAttribArrayARB(instanceLocations[i]));
+        glCheck(glVertexAttribDivisorARB(instanceLocations[i], 1));
+    }
+
+    // Setup the pointers to the unit quad, shared by all instances
+    glCheck(glBindBufferARB(GL_ARRAY_BUFFER_ARB, 0));
+    const char* data = reinterpret_cast<const char*>(unitQuad);
+    glCheck(glVertexPointer(2, GL_FLOAT, sizeof(Vertex), data + 0));
+    glCheck(glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(Vertex), data + 8));
+    glCheck(glTexCoordPointer(2, GL_FLOAT, sizeof(Vertex), data + 12));
+
+    // Draw all the instances at once
+    glCheck(glUseProgramObjectARB(m_program));
+    glCheck(glUniform2fARB(m_originLocation, m_instanceOrigin.x, m_instanceOrigin.y));
+    glCheck(glDrawArraysInstancedARB(GL_TRIANGLE_STRIP, 0, 4, static_cast<GLsizei>(m_instances.size())));
+    glCheck(glUseProgramObjectARB(0));
+
+    // Restore the attribute states expected by the rest of the renderer
+    for (std::size_t i = 0; i < instanceLocationCount; ++i)
+    {
+        glCheck(glVertexAttribDivisorARB(instanceLocations[i], 0));
+        glCheck(glDisableVertexAttribArrayARB(instanceLocations[i]));
+    }
+
+    return true;
+}
+
+
+////////////////////////////////////////////////////////////
+void InstancedSpriteBatch::drawExpanded(RenderTarget& target, const RenderStates& states) const
+{
+    m_vertices.resize(m_instances.size() * 4);
+
+    for (std::size_t i = 0; i < m_instances.size(); ++i)
+    {
+        const Instance& instance = m_instances[i];
+
+        // Same computations as Transformable::getTransform
+        float angle  = -instance.rotation * 3.141592654f / 180.f;
+        float cosine = static_cast<float>(std::cos(angle));
+        float sine   = static_cast<float>(std::sin(angle));
+        float width  = static_cast<float>(std::abs(instance.textureRect[2]));
+        float height = static_cast<float>(std::abs(instance.textureRect[3]));
+        float sxc    = instance.scale.x * cosine;
+        float syc    = instance.scale.y * cosine;
+        float sxs    = instance.scale.x * sine;
+        float sys    = instance.scale.y * sine;
+        float ox     = m_instanceOrigin.x * width;
+        float oy     = m_instanceOrigin.y * height;
+        float tx     = -ox * sxc - oy * sys + instance.position.x;
+        float ty     =  ox * sxs - oy * syc + instance.position.y;
+
+        float left   = static_cast<float>(instance.textureRect[0]);
+        float top    = static_cast<float>(instance.textureRect[1]);
+        float right  = left + instance.textureRect[2];
+        float bottom = top + instance.textureRect[3];
+
+        Vertex* quad = &m_vertices[i * 4];
+        quad[0].position = Vector2f(tx, ty);
+        quad[1].position = Vector2f(height * sys + tx, height * syc + ty);
+        quad[2].position = Vector2f(width * sxc + height * sys + tx, -width * sxs + height * syc + ty);
+        quad[3].position = Vector2f(width * sxc + tx, -width * sxs + ty);
+        quad[0].texCoords = Vector2f(left, top);
+        quad[1].texCoords = Vector2f(left, bottom);
+        quad[2].texCoords = Vector2f(right, bottom);
+        quad[3].texCoords = Vector2f(right, top);
+        quad[0].color = quad[1].color = quad[2].color = quad[3].color = instance.color;
+    }
+
+    target.draw(&m_vertices[0], static_cast<unsigned int>(m_vertices.size()), Quads, states);
+}
+
+
+////////////////////////////////////////////////////////////
+bool InstancedSpriteBatch::ensureProgram() const
+{
+    if (m_program)
+        return true;
+
+    // Create the instance buffer
+    GLuint buffer;
+    glCheck(glGenBuffersARB(1, &buffer));
+    m_buffer = static_cast<unsigned int>(buffer);
+    m_bufferSize = 0;
+
+    // Create the program
+    GLhandleARB vertexShader = compileShader(GL_VERTEX_SHADER_ARB, vertexShaderCode);
+    GLhandleARB fragmentShader = compileShader(GL_FRAGMENT_SHADER_ARB, fragmentShaderCode);
+    if (!vertexShader || !fragmentShader)
+    {
+        if (vertexShader)
+        {
+            glCheck(glDeleteObjectARB(vertexShader));
+        }
+        if (fragmentShader)
+        {
+            glCheck(glDeleteObjectARB(fragmentShader));
+        }
+        m_programFailed = true;
+        return false;
+    }
+
+    GLhandleARB program = glCheck(glCreateProgramObjectARB());
+    glCheck(glAttachObjectARB(program, vertexShader));
+    glCheck(glAttachObjectARB(program, fragmentShader));
+    glCheck(glDeleteObjectARB(vertexShader));
+    glCheck(glDeleteObjectARB(fragmentShader));
+
+    // Bind the per-instance attributes to fixed locations before linking
+    glCheck(glBindAttribLocationARB(program, TransformLocation, "instanceTransform"));
+    glCheck(glBindAttribLocationARB(program, ScaleYLocation,    "instanceScaleY"));
+    glCheck(glBindAttribLocationARB(program, RectLocation,      "instanceRect"));
+    glCheck(glBindAttribLocationARB(program, ColorLocation,     "instanceColor"));
+    glCheck(glLinkProgramARB(program));
+
+    // Check the link log
+    GLint success;
+    glCheck(glGetObjectParameterivARB(program, GL_OBJECT_LINK_STATUS_ARB, &success));
+    if (success == GL_FALSE)
+    {
+        char log[1024];
+        glCheck(glGetInfoLogARB(program, sizeof(log), nullptr, log));
+        Log() << "Failed to link instanced sprite shader:" << std::endl
+              << log << std::endl;
+        glCheck(glDeleteObjectARB(program));
+        m_programFailed = true;
+        return false;
+    }
+
+    m_program = program;
+    m_originLocation = glCheck(glGetUniformLocationARB(program, "origin"));
+
+    return true;
+}
+
+} // namespace TGE
@@ -0,0 +1,117 @@
+/*************************************/
+/** Copyright © 2014 Coldsnap Games **/
+/*************************************/
+
+/*************************************/
+/**             Headers             **/
+/*************************************/
+#include <Tyrant/Graphics/RenderQueue.hpp>
+
+
+namespace TGE
+{
+////////////////////////////////////////////////////////////
+RenderQueue::RenderQueue() :
+m_vertices (),
+m_texts    (),
+m_textCount(0),
+m_commands (),
+m_size     (0, 0)
+{
+    initialize();
+}
+
+
+////////////////////////////////////////////////////////////
+void RenderQueue::setSize(const Vector2u& size)
+{
+    if (size != m_size)
+    {
+        m_size = size;
+        initialize();
+    }
+}
+
+
+////////////////////////////////////////////////////////////
+Vector2u RenderQueue::getSize() const
+{
+    return m_size;
+}
+
+
+////////////////////////////////////////////////////////////
+void RenderQueue::reset()
+{
+    m_vertices.clear();
+    m_commands.clear();
+    m_textCount = 0;
+}
+
+
+////////////////////////////////////////////////////////////
+unsigned int RenderQueue::getCommandCount() const
+{
+    return static_cast<unsigned int>(m_commands.size());
+}
+
+
+////////////////////////////////////////////////////////////
+void RenderQueue::replay(RenderTarget& target) const
+{
+    for (std::vector<Command>::const_iterator it = m_commands.begin(); it != m_commands.end(); ++it)
+    {
+        if (it->count > 0)
+            target.draw(&m_vertices[it->first], it->count, it->type, it->states);
+        else
+            target.draw(m_texts[it->first], it->states);
+    }
+}
+
+
+////////////////////////////////////////////////////////////
+bool RenderQueue::interceptDraw(const Vertex* vertices, unsigned int vertexCount,
+                                PrimitiveType type, const RenderStates& states)
+{
+    Command command;
+    command.first  = m_vertices.size();
+    command.count  = vertexCount;
+    command.type   = type;
+    command.states = states;
+
+    m_vertices.insert(m_vertices.end(), vertices, vertices + vertexCount);
+    m_commands.push_back(command);
+
+    return true;
+}
+
+
+////////////////////////////////////////////////////////////
+bool RenderQueue::interceptText(const Text& text, const RenderStates& states)
+{
+    Command command;
+    command.first  = m_textCount;
+    command.count  = 0;
+    command.type   = Quads;
+    command.states = states;
+
+    // Assigning to a previous copy reuses its string and vertex storage
+    if (m_textCount < m_texts.size())
+        m_texts[m_textCount] = text;
+    else
+        m_texts.push_back(text);
+
+    m_textCount++;
+    m_commands.push_back(command);
+
+    return true;
+}
+
+
+////////////////////////////////////////////////////////////
+bool RenderQueue::activate(bool)
+{
+    return false;
+}
+
+} // namespace TGE
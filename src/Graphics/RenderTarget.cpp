@@ -12,6 +12,7 @@
 #include <Tyrant/Graphics/VertexArray.hpp>
 #include <Tyrant/Graphics/GLCheck.hpp>
 #include <Tyrant/System/Log.hpp>
+#include <Tyrant/System/Profiler.hpp>
 #include <iostream>
 
 
@@ -174,6 +175,12 @@ void RenderTarget::draw(const Vertex* vertices, unsigned int vertexCount,
     if (!vertices || (vertexCount == 0))
         return;
 
+    TGE_PROFILE_SCOPE("RenderTarget::draw");
+
+    // Let derived classes store the draw call instead of executing it
+    if (interceptDraw(vertices, vertexCount, type, states))
+        return;
+
     if (activate(true))
     {
         // First set the persistent OpenGL states if it's the very first call
@@ -350,6 +357,54 @@ void RenderTarget::initialize()
 }
 
 
+////////////////////////////////////////////////////////////
+bool RenderTarget::interceptDraw(const Vertex*, unsigned int, PrimitiveType, const RenderStates&)
+{
+    return false;
+}
+
+
+////////////////////////////////////////////////////////////
+bool RenderTarget::interceptText(const Text&, const RenderStates&)
+{
+    return false;
+}
+
+
+////////////////////////////////////////////////////////////
+bool RenderTarget::applyStates(const RenderStates& states)
+{
+    if (!activate(true))
+        return false;
+
+    // First set the persistent OpenGL states if it's the very first call
+    if (!m_cache.glStatesSet)
+        resetGLStates();
+
+    // Custom draws never use the pre-transformed vertex cache
+    applyTransform(states.transform);
+
+    // Apply the view
+    if (m_cache.viewChanged)
+        applyCurrentView();
+
+    // Apply the blend mode
+    if (states.blendMode != m_cache.lastBlendMode)
+        applyBlendMode(states.blendMode);
+
+    // Apply the texture
+    Uint64 textureId = states.texture ? states.texture->m_cacheId : 0;
+    if (textureId != m_cache.lastTextureId)
+        applyTexture(states.texture);
+
+    // The caller will set its own vertex pointers, so the next
+    // regular draw must set them again
+    m_cache.useVertexCache = false;
+
+    return true;
+}
+
+
 ////////////////////////////////////////////////////////////
 void RenderTarget::applyCurrentView()
 {
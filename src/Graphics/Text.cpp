@@ -8,6 +8,7 @@
 #include <Tyrant/Graphics/Text.hpp>
 #include <Tyrant/Graphics/Texture.hpp>
 #include <Tyrant/Graphics/RenderTarget.hpp>
+#include <Tyrant/System/Lock.hpp>
 #include <cassert>
 
 
@@ -207,6 +208,13 @@ void Text::draw(RenderTarget& target, RenderStates states) const
 {
     if (m_font)
     {
+        // Targets replaying the draw calls later resolve the glyphs at that time
+        if (target.interceptText(*this, states))
+            return;
+
+        // Keep another thread from loading glyphs into the texture while it is used
+        Lock lock(m_font->m_mutex);
+
         ensureGeometryUpdate();
 
         states.transform *= getTransform();
@@ -238,6 +246,10 @@ void Text::ensureGeometryUpdate() const
     if (m_string.isEmpty())
         return;
 
+    // Make room for a quad per character plus the last underline at
+    // once, rather than growing the array while appending
+    m_vertices.reserve(static_cast<unsigned int>((m_string.getSize() + 1) * 6));
+
     // Compute values related to the text style
     bool  bold               = (m_style & Bold) != 0;
     bool  underlined         = (m_style & Underlined) != 0;
@@ -62,6 +62,13 @@ void VertexArray::resize(unsigned int vertexCount)
 }
 
 
+////////////////////////////////////////////////////////////
+void VertexArray::reserve(unsigned int vertexCount)
+{
+    m_vertices.reserve(vertexCount);
+}
+
+
 ////////////////////////////////////////////////////////////
 void VertexArray::append(const Vertex& vertex)
 {
@@ -0,0 +1,207 @@
+/*************************************/
+/** Copyright © 2014 Coldsnap Games **/
+/*************************************/
+
+/*************************************/
+/**             Headers             **/
+/*************************************/
+#include <Tyrant/Network/BitReader.hpp>
+#include <Tyrant/Network/BitWriter.hpp>
+#include <Tyrant/Network/Packet.hpp>
+#include <Tyrant/System/String.hpp>
+#include <cstring>
+
+
+namespace TGE
+{
+////////////////////////////////////////////////////////////
+BitReader::BitReader(const Packet& packet, std::size_t offset) :
+m_data       (static_cast<const Uint8*>(packet.getData())),
+m_size       (packet.getDataSize()),
+m_bitPosition(offset * 8),
+m_isValid    (offset <= packet.getDataSize())
+{
+
+}
+
+
+////////////////////////////////////////////////////////////
+Uint32 BitReader::readBits(unsigned int bitCount)
+{
+    if (!checkSize(bitCount))
+        return 0;
+
+    // Gather the bytes covering the bits, lowest first
+    std::size_t first = m_bitPosition / 8;
+    unsigned int shift = m_bitPosition % 8;
+    std::size_t count = (shift + bitCount + 7) / 8;
+
+    Uint64 bits = 0;
+    for (std::size_t i = 0; i < count; ++i)
+        bits |= static_cast<Uint64>(m_data[first + i]) << (i * 8);
+
+    m_bitPosition += bitCount;
+
+    Uint32 value = static_cast<Uint32>(bits >> shift);
+    if (bitCount < 32)
+        value &= (1u << bitCount) - 1;
+
+    return value;
+}
+
+
+////////////////////////////////////////////////////////////
+bool BitReader::readBool()
+{
+    return readBits(1) != 0;
+}
+
+
+////////////////////////////////////////////////////////////
+Int32 BitReader::readInteger(Int32 min, Int32 max)
+{
+    Uint32 range = static_cast<Uint32>(max) - static_cast<Uint32>(min);
+    Uint32 value = readBits(BitWriter::getBitsRequired(range));
+
+    if (value > range)
+        m_isValid = false;
+
+    return static_cast<Int32>(static_cast<Uint32>(min) + value);
+}
+
+
+////////////////////////////////////////////////////////////
+Uint32 BitReader::readVarint()
+{
+    Uint32 value = 0;
+    for (unsigned int shift = 0; shift < 35; shift += 7)
+    {
+        Uint32 group = readBits(8);
+        value |= (group & 0x7F) << shift;
+
+        if (!(group & 0x80))
+            return value;
+    }
+
+    // More than 5 groups: the data is corrupted
+    m_isValid = false;
+
+    return 0;
+}
+
+
+////////////////////////////////////////////////////////////
+Int32 BitReader::readSignedVarint()
+{
+    Uint32 zigzag = readVarint();
+
+    return static_cast<Int32>((zigzag >> 1) ^ (~(zigzag & 1) + 1));
+}
+
+
+////////////////////////////////////////////////////////////
+float BitReader::readFloat()
+{
+    Uint32 bits = readBits(32);
+
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+
+    return value;
+}
+
+
+////////////////////////////////////////////////////////////
+float BitReader::readFloat(float min, float max, unsigned int bitCount)
+{
+    Uint32 quantized = readBits(bitCount);
+
+    // Without any bit there is a single step, which is min
+    double steps = static_cast<double>(bitCount < 32 ? (1u << bitCount) - 1 : 0xFFFFFFFFu);
+    if (steps == 0)
+        return min;
+
+    return static_cast<float>(min + quantized / steps * (max - min));
+}
+
+
+////////////////////////////////////////////////////////////
+Vector2f BitReader::readVector2(float min, float max, unsigned int bitCount)
+{
+    Vector2f value;
+    value.x = readFloat(min, max, bitCount);
+    value.y = readFloat(min, max, bitCount);
+
+    return value;
+}
+
+
+////////////////////////////////////////////////////////////
+Vector3f BitReader::readVector3(float min, float max, unsigned int bitCount)
+{
+    Vector3f value;
+    value.x = readFloat(min, max, bitCount);
+    value.y = readFloat(min, max, bitCount);
+    value.z = readFloat(min, max, bitCount);
+
+    return value;
+}
+
+
+////////////////////////////////////////////////////////////
+void BitReader::readString(std::string& value)
+{
+    value.clear();
+
+    // The characters start on a new byte
+    std::size_t length = readVarint();
+    alignToByte();
+
+    if ((length > 0) && checkSize(length * 8))
+    {
+        value.assign(reinterpret_cast<const char*>(m_data) + m_bitPosition / 8, length);
+        m_bitPosition += length * 8;
+    }
+}
+
+
+////////////////////////////////////////////////////////////
+void BitReader::readString(String& value)
+{
+    std::string utf8;
+    readString(utf8);
+
+    value = String::fromUtf8(utf8.begin(), utf8.end());
+}
+
+
+////////////////////////////////////////////////////////////
+void BitReader::alignToByte()
+{
+    m_bitPosition = (m_bitPosition + 7) / 8 * 8;
+}
+
+
+////////////////////////////////////////////////////////////
+std::size_t BitReader::getRemainingBits() const
+{
+    return m_bitPosition < m_size * 8 ? m_size * 8 - m_bitPosition : 0;
+}
+
+
+////////////////////////////////////////////////////////////
+BitReader::operator BoolType() const
+{
+    return m_isValid ? &BitReader::checkSize : NULL;
+}
+
+
+////////////////////////////////////////////////////////////
+bool BitReader::checkSize(std::size_t bitCount)
+{
+    m_isValid = m_isValid && (m_bitPosition + bitCount <= m_size * 8);
+
+    return m_isValid;
+}
+
+} // namespace TGE
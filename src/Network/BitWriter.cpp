@@ -0,0 +1,211 @@
+/*************************************/
+/** Copyright © 2014 Coldsnap Games **/
+/*************************************/
+
+/*************************************/
+/**             Headers             **/
+/*************************************/
+#include <Tyrant/Network/BitWriter.hpp>
+#include <Tyrant/Network/Packet.hpp>
+#include <Tyrant/System/String.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+
+namespace TGE
+{
+////////////////////////////////////////////////////////////
+BitWriter::BitWriter(Packet& packet) :
+m_packet     (packet),
+m_scratch    (0),
+m_scratchBits(0),
+m_bitCount   (0)
+{
+
+}
+
+
+////////////////////////////////////////////////////////////
+BitWriter::~BitWriter()
+{
+    flush();
+}
+
+
+////////////////////////////////////////////////////////////
+void BitWriter::writeBits(Uint32 value, unsigned int bitCount)
+{
+    if (bitCount < 32)
+        value &= (1u << bitCount) - 1;
+
+    // The bits are stored from the lowest to the highest
+    m_scratch |= static_cast<Uint64>(value) << m_scratchBits;
+    m_scratchBits += bitCount;
+    m_bitCount += bitCount;
+
+    // Write whole 32-bit words to the packet, lowest byte first
+    if (m_scratchBits >= 32)
+    {
+        Uint8 bytes[4];
+        for (int i = 0; i < 4; ++i)
+            bytes[i] = static_cast<Uint8>(m_scratch >> (i * 8));
+
+        m_packet.append(bytes, sizeof(bytes));
+        m_scratch >>= 32;
+        m_scratchBits -= 32;
+    }
+}
+
+
+////////////////////////////////////////////////////////////
+void BitWriter::write(bool value)
+{
+    writeBits(value ? 1 : 0, 1);
+}
+
+
+////////////////////////////////////////////////////////////
+void BitWriter::writeInteger(Int32 value, Int32 min, Int32 max)
+{
+    value = std::min(std::max(value, min), max);
+
+    Uint32 range = static_cast<Uint32>(max) - static_cast<Uint32>(min);
+    writeBits(static_cast<Uint32>(value) - static_cast<Uint32>(min), getBitsRequired(range));
+}
+
+
+////////////////////////////////////////////////////////////
+void BitWriter::writeVarint(Uint32 value)
+{
+    while (value >= 0x80)
+    {
+        writeBits((value & 0x7F) | 0x80, 8);
+        value >>= 7;
+    }
+
+    writeBits(value, 8);
+}
+
+
+////////////////////////////////////////////////////////////
+void BitWriter::writeSignedVarint(Int32 value)
+{
+    // Zigzag encoding: small negative values get small codes too
+    Uint32 zigzag = (static_cast<Uint32>(value) << 1) ^ static_cast<Uint32>(value >> 31);
+    writeVarint(zigzag);
+}
+
+
+////////////////////////////////////////////////////////////
+void BitWriter::writeFloat(float value)
+{
+    Uint32 bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    writeBits(bits, 32);
+}
+
+
+////////////////////////////////////////////////////////////
+void BitWriter::writeFloat(float value, float min, float max, unsigned int bitCount)
+{
+    // An empty range only has one value, which the reader finds without any step
+    if (!(max > min))
+    {
+        writeBits(0, bitCount);
+        return;
+    }
+
+    double steps = static_cast<double>(bitCount < 32 ? (1u << bitCount) - 1 : 0xFFFFFFFFu);
+    double normalized = (std::min(std::max(value, min), max) - min) / static_cast<double>(max - min);
+
+    writeBits(static_cast<Uint32>(std::floor(normalized * steps + 0.5)), bitCount);
+}
+
+
+////////////////////////////////////////////////////////////
+void BitWriter::writeVector(const Vector2f& value, float min, float max, unsigned int bitCount)
+{
+    writeFloat(value.x, min, max, bitCount);
+    writeFloat(value.y, min, max, bitCount);
+}
+
+
+////////////////////////////////////////////////////////////
+void BitWriter::writeVector(const Vector3f& value, float min, float max, unsigned int bitCount)
+{
+    writeFloat(value.x, min, max, bitCount);
+    writeFloat(value.y, min, max, bitCount);
+    writeFloat(value.z, min, max, bitCount);
+}
+
+
+////////////////////////////////////////////////////////////
+void BitWriter::writeString(const std::string& value)
+{
+    writeVarint(static_cast<Uint32>(value.size()));
+
+    // Copy the characters at once, after the pending bits
+    flush();
+    if (!value.empty())
+    {
+        m_packet.append(value.data(), value.size());
+        m_bitCount += value.size() * 8;
+    }
+}
+
+
+////////////////////////////////////////////////////////////
+void BitWriter::writeString(const String& value)
+{
+    std::basic_string<Uint8> utf8 = value.toUtf8();
+    writeString(std::string(utf8.begin(), utf8.end()));
+}
+
+
+////////////////////////////////////////////////////////////
+void BitWriter::alignToByte()
+{
+    unsigned int padding = (8 - m_scratchBits % 8) % 8;
+    if (padding > 0)
+        writeBits(0, padding);
+}
+
+
+////////////////////////////////////////////////////////////
+void BitWriter::flush()
+{
+    alignToByte();
+
+    // Write the remaining whole bytes
+    Uint8 bytes[4];
+    std::size_t count = m_scratchBits / 8;
+    for (std::size_t i = 0; i < count; ++i)
+        bytes[i] = static_cast<Uint8>(m_scratch >> (i * 8));
+
+    if (count > 0)
+        m_packet.append(bytes, count);
+
+    m_scratch = 0;
+    m_scratchBits = 0;
+}
+
+
+////////////////////////////////////////////////////////////
+std::size_t BitWriter::getBitCount() const
+{
+    return m_bitCount;
+}
+
+
+////////////////////////////////////////////////////////////
+unsigned int BitWriter::getBitsRequired(Uint32 maxValue)
+{
+    unsigned int bits = 1;
+    while ((bits < 32) && (maxValue >> bits))
+        bits++;
+
+    return bits;
+}
+
+} // namespace TGE
@@ -0,0 +1,423 @@
+/*************************************/
+/** Copyright © 2014 Coldsnap Games **/
+/*************************************/
+
+/*************************************/
+/**             Headers             **/
+/*************************************/
+#include <Tyrant/Network/CompressedPacket.hpp>
+#include <Tyrant/Network/CompressionDictionary.hpp>
+#include <Tyrant/System/Log.hpp>
+#include <algorithm>
+#include <cstring>
+
+
+namespace
+{
+    // Methods written in the first byte of the packets
+    enum Method
+    {
+        Stored,                  // Data as is
+        Compressed,              // Size, then compressed data
+        CompressedWithDictionary // Size, dictionary identifier, then compressed data
+    };
+
+    // Shortest repeated sequence replaced by a match
+    const std::size_t MinMatch = 4;
+
+    // Farthest previous occurrence a match can refer to
+    const std::size_t MaxOffset = 65535;
+
+    // After 2^SkipTrigger positions without a match, the compressor starts skipping bytes
+    const unsigned int SkipTrigger = 6;
+
+    // Number of bytes of the original size, and of the dictionary identifier
+    const std::size_t SizeBytes = 4;
+
+    // Maximum size of the compressed data, in the worst case
+    std::size_t getCompressBound(std::size_t size)
+    {
+        return size + size / 255 + 16;
+    }
+
+    // Count the identical bytes at the start of two ranges
+    std::size_t countEqual(const char* left, const char* leftEnd, const char* right, const char* rightEnd)
+    {
+        std::size_t limit = std::min<std::size_t>(leftEnd - left, rightEnd - right);
+        std::size_t count = 0;
+
+        // Compare 8 bytes at a time, then find the different byte
+        while (count + sizeof(TGE::Uint64) <= limit)
+        {
+            TGE::Uint64 a, b;
+            std::memcpy(&a, left + count, sizeof(a));
+            std::memcpy(&b, right + count, sizeof(b));
+            if (a != b)
+                break;
+            count += sizeof(TGE::Uint64);
+        }
+        while ((count < limit) && (left[count] == right[count]))
+            ++count;
+
+        return count;
+    }
+
+    // Write the extra bytes of a literal or match length
+    char* writeLength(char* output, std::size_t length)
+    {
+        while (length >= 255)
+        {
+            *output++ = static_cast<char>(255);
+            length -= 255;
+        }
+        *output++ = static_cast<char>(length);
+
+        return output;
+    }
+
+    // Read the extra bytes of a literal or match length
+    bool readLength(const unsigned char*& input, const unsigned char* end, std::size_t& length)
+    {
+        unsigned char byte;
+        do
+        {
+            if (input == end)
+                return false;
+            byte = *input++;
+            length += byte;
+        }
+        while (byte == 255);
+
+        return true;
+    }
+
+    // Write and read the 32-bit fields of the header, in network order
+    void writeUint32(char* output, TGE::Uint32 value)
+    {
+        output[0] = static_cast<char>(value >> 24);
+        output[1] = static_cast<char>(value >> 16);
+        output[2] = static_cast<char>(value >> 8);
+        output[3] = static_cast<char>(value);
+    }
+
+    TGE::Uint32 readUint32(const char* input)
+    {
+        const unsigned char* bytes = reinterpret_cast<const unsigned char*>(input);
+        return (static_cast<TGE::Uint32>(bytes[0]) << 24) | (static_cast<TGE::Uint32>(bytes[1]) << 16) |
+               (static_cast<TGE::Uint32>(bytes[2]) << 8)  |  static_cast<TGE::Uint32>(bytes[3]);
+    }
+}
+
+namespace TGE
+{
+////////////////////////////////////////////////////////////
+CompressedPacket::CompressedPacket() :
+m_threshold (128),
+m_dictionary(NULL),
+m_buffer    (),
+m_table     ()
+{
+
+}
+
+
+////////////////////////////////////////////////////////////
+void CompressedPacket::setCompressionThreshold(std::size_t threshold)
+{
+    m_threshold = threshold;
+}
+
+
+////////////////////////////////////////////////////////////
+std::size_t CompressedPacket::getCompressionThreshold() const
+{
+    return m_threshold;
+}
+
+
+////////////////////////////////////////////////////////////
+void CompressedPacket::setDictionary(const CompressionDictionary* dictionary)
+{
+    m_dictionary = dictionary;
+}
+
+
+////////////////////////////////////////////////////////////
+const CompressionDictionary* CompressedPacket::getDictionary() const
+{
+    return m_dictionary;
+}
+
+
+////////////////////////////////////////////////////////////
+const void* CompressedPacket::onSend(std::size_t& size)
+{
+    const char* data = static_cast<const char*>(getData());
+    std::size_t dataSize = getDataSize();
+
+    if ((dataSize > 0) && (dataSize >= m_threshold))
+    {
+        bool useDictionary = m_dictionary && (m_dictionary->getSize() > 0);
+        std::size_t headerSize = 1 + SizeBytes + (useDictionary ? SizeBytes : 0);
+
+        m_buffer.resize(headerSize + getCompressBound(dataSize));
+        m_buffer[0] = static_cast<char>(useDictionary ? CompressedWithDictionary : Compressed);
+        writeUint32(&m_buffer[1], static_cast<Uint32>(dataSize));
+        if (useDictionary)
+            writeUint32(&m_buffer[1 + SizeBytes], m_dictionary->getId());
+
+        std::size_t compressedSize = headerSize + compress(data, dataSize, &m_buffer[headerSize]);
+
+        // Keep the compressed data only if it's smaller
+        if (compressedSize < 1 + dataSize)
+        {
+            size = compressedSize;
+            return &m_buffer[0];
+        }
+    }
+
+    m_buffer.resize(1 + dataSize);
+    m_buffer[0] = static_cast<char>(Stored);
+    if (dataSize > 0)
+        std::memcpy(&m_buffer[1], data, dataSize);
+
+    size = m_buffer.size();
+    return &m_buffer[0];
+}
+
+
+////////////////////////////////////////////////////////////
+void CompressedPacket::onReceive(const void* data, std::size_t size)
+{
+    const char* bytes = static_cast<const char*>(data);
+    if (size == 0)
+        return;
+
+    Method method = static_cast<Method>(bytes[0]);
+    if (method == Stored)
+    {
+        append(bytes + 1, size - 1);
+        return;
+    }
+
+    std::size_t headerSize = 1 + SizeBytes + (method == CompressedWithDictionary ? SizeBytes : 0);
+    if (((method != Compressed) && (method != CompressedWithDictionary)) || (size < headerSize))
+    {
+        Log() << "Failed to uncompress packet (invalid header)" << std::endl;
+        return;
+    }
+
+    const CompressionDictionary* dictionary = NULL;
+    if (method == CompressedWithDictionary)
+    {
+        if (!m_dictionary || (m_dictionary->getId() != readUint32(bytes + 1 + SizeBytes)))
+        {
+            Log() << "Failed to uncompress packet (it was compressed with another dictionary)" << std::endl;
+            return;
+        }
+        dictionary = m_dictionary;
+    }
+
+    // Reject sizes the compressed data can't produce, rather than allocating them
+    std::size_t originalSize = readUint32(bytes + 1);
+    if ((originalSize == 0) || (originalSize > (size - headerSize) * 255 + 16))
+    {
+        Log() << "Failed to uncompress packet (invalid size)" << std::endl;
+        return;
+    }
+
+    m_buffer.resize(originalSize);
+    if (!uncompress(bytes + headerSize, size - headerSize, dictionary, &m_buffer[0], originalSize))
+    {
+        Log() << "Failed to uncompress packet (the data is corrupted)" << std::endl;
+        return;
+    }
+
+    append(&m_buffer[0], originalSize);
+}
+
+
+////////////////////////////////////////////////////////////
+std::size_t CompressedPacket::compress(const char* data, std::size_t size, char* output)
+{
+    // The dictionary comes right before the data: positions below its
+    // size are in the dictionary, the others in the data
+    const char* dictionary = NULL;
+    std::size_t dictionarySize = 0;
+    if (m_dictionary && (m_dictionary->getSize() > 0))
+    {
+        dictionary = &m_dictionary->m_data[0];
+        dictionarySize = m_dictionary->getSize();
+        m_table = m_dictionary->m_table;
+    }
+    else
+    {
+        m_table.assign(1 << CompressionDictionary::HashLog, 0);
+    }
+
+    const char* dictionaryEnd = dictionary + dictionarySize;
+    const char* end = data + size;
+    char* out = output;
+    std::size_t anchor = 0;
+    std::size_t position = 0;
+    std::size_t misses = 0;
+
+    while (position + MinMatch <= size)
+    {
+        // Look for the previous occurrence of the next 4 bytes
+        Uint32& entry = m_table[CompressionDictionary::hash(data + position)];
+        std::size_t current = dictionarySize + position;
+        std::size_t candidate = entry;
+        entry = static_cast<Uint32>(current);
+
+        std::size_t length = 0;
+        if ((candidate < current) && (current - candidate <= MaxOffset))
+        {
+            if (candidate >= dictionarySize)
+            {
+                length = countEqual(data + candidate - dictionarySize, end, data + position, end);
+            }
+            else
+            {
+                // The match may continue past the end of the dictionary, into the data
+                length = countEqual(dictionary + candidate, dictionaryEnd, data + position, end);
+                if (candidate + length == dictionarySize)
+                    length += countEqual(data, end, data + position + length, end);
+            }
+        }
+
+        if (length < MinMatch)
+        {
+            // Data that doesn't compress is skipped faster and faster
+            position += 1 + (misses++ >> SkipTrigger);
+            continue;
+        }
+        misses = 0;
+
+        // Extend the match backwards over the pending literals
+        while ((position > anchor) && (candidate > 0))
+        {
+            char previous = candidate - 1 < dictionarySize ? dictionary[candidate - 1] : data[candidate - 1 - dictionarySize];
+            if (previous != data[position - 1])
+                break;
+
+            --position;
+            --candidate;
+            ++length;
+        }
+
+        // Token: literal length in the high bits, match length in the low bits
+        std::size_t literals = position - anchor;
+        std::size_t matchLength = length - MinMatch;
+        *out++ = static_cast<char>((std::min<std::size_t>(literals, 15) << 4) | std::min<std::size_t>(matchLength, 15));
+        if (literals >= 15)
+            out = writeLength(out, literals - 15);
+
+        std::memcpy(out, data + anchor, literals);
+        out += literals;
+
+        std::size_t offset = dictionarySize + position - candidate;
+        *out++ = static_cast<char>(offset & 0xFF);
+        *out++ = static_cast<char>(offset >> 8);
+
+        if (matchLength >= 15)
+            out = writeLength(out, matchLength - 15);
+
+        position += length;
+        anchor = position;
+
+        // Index a position inside the match, which helps the next matches
+        if (position + MinMatch <= size + 2)
+            m_table[CompressionDictionary::hash(data + position - 2)] = static_cast<Uint32>(dictionarySize + position - 2);
+    }
+
+    // Last sequence: literals only
+    std::size_t literals = size - anchor;
+    *out++ = static_cast<char>(std::min<std::size_t>(literals, 15) << 4);
+    if (literals >= 15)
+        out = writeLength(out, literals - 15);
+
+    std::memcpy(out, data + anchor, literals);
+    out += literals;
+
+    return out - output;
+}
+
+
+////////////////////////////////////////////////////////////
+bool CompressedPacket::uncompress(const char* data, std::size_t size, const CompressionDictionary* dictionary, char* output, std::size_t outputSize)
+{
+    const unsigned char* input = reinterpret_cast<const unsigned char*>(data);
+    const unsigned char* end = input + size;
+    const char* dictionaryData = (dictionary && (dictionary->getSize() > 0)) ? &dictionary->m_data[0] : NULL;
+    std::size_t dictionarySize = dictionaryData ? dictionary->getSize() : 0;
+    std::size_t position = 0;
+
+    for (;;)
+    {
+        if (input == end)
+            return false;
+
+        unsigned char token = *input++;
+
+        // Copy the literals
+        std::size_t literals = token >> 4;
+        if ((literals == 15) && !readLength(input, end, literals))
+            return false;
+
+        if ((literals > static_cast<std::size_t>(end - input)) || (literals > outputSize - position))
+            return false;
+
+        std::memcpy(output + position, input, literals);
+        input += literals;
+        position += literals;
+
+        // The last sequence has no match
+        if (input == end)
+            break;
+
+        if (end - input < 2)
+            return false;
+
+        std::size_t offset = input[0] | (input[1] << 8);
+        input += 2;
+
+        std::size_t length = token & 15;
+        if ((length == 15) && !readLength(input, end, length))
+            return false;
+        length += MinMatch;
+
+        if ((offset == 0) || (offset > position + dictionarySize) || (length > outputSize - position))
+            return false;
+
+        // Copy the part of the match which is in the dictionary
+        if (offset > position)
+        {
+            std::size_t start = dictionarySize - (offset - position);
+            std::size_t count = std::min(length, offset - position);
+            std::memcpy(output + position, dictionaryData + start, count);
+            position += count;
+            length -= count;
+        }
+
+        if (length == 0)
+            continue;
+
+        // Copy the rest; if the match overlaps the bytes it produces, it repeats
+        // a pattern of 'offset' bytes, which can be copied in doubling blocks
+        const char* source = output + position - offset;
+        char* destination = output + position;
+        position += length;
+        while (length > 0)
+        {
+            std::size_t count = std::min<std::size_t>(destination - source, length);
+            std::memcpy(destination, source, count);
+            destination += count;
+            length -= count;
+        }
+    }
+
+    return position == outputSize;
+}
+
+} // namespace TGE
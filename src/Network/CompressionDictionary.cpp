@@ -0,0 +1,214 @@
+/*************************************/
+/** Copyright © 2014 Coldsnap Games **/
+/*************************************/
+
+/*************************************/
+/**             Headers             **/
+/*************************************/
+#include <Tyrant/Network/CompressionDictionary.hpp>
+#include <Tyrant/Network/Packet.hpp>
+#include <algorithm>
+#include <cstring>
+#include <queue>
+#include <utility>
+
+
+namespace
+{
+    // Length of the byte sequences counted by the training
+    const std::size_t GramSize = 8;
+
+    // Length of the pieces of samples copied to the dictionary
+    const std::size_t SegmentSize = 64;
+
+    // Number of bits of the hash of a sequence counted by the training
+    const unsigned int GramHashLog = 16;
+
+    // Hash the GramSize bytes starting at a position
+    std::size_t hashGram(const char* data)
+    {
+        TGE::Uint64 sequence;
+        std::memcpy(&sequence, data, sizeof(sequence));
+
+        return static_cast<std::size_t>((sequence * 0x9E3779B97F4A7C15ull) >> (64 - GramHashLog));
+    }
+
+    // Piece of a sample that may be copied to the dictionary
+    struct Segment
+    {
+        const char* data;
+        std::size_t size;
+    };
+
+    // Sum of the counts of the sequences of a segment
+    TGE::Uint64 getScore(const Segment& segment, const std::vector<TGE::Uint32>& counts)
+    {
+        TGE::Uint64 score = 0;
+        for (std::size_t i = 0; i + GramSize <= segment.size; ++i)
+        {
+            // Sequences found in a single sample don't help
+            TGE::Uint32 count = counts[hashGram(segment.data + i)];
+            if (count > 1)
+                score += count;
+        }
+
+        return score;
+    }
+}
+
+namespace TGE
+{
+////////////////////////////////////////////////////////////
+CompressionDictionary::CompressionDictionary() :
+m_data (),
+m_id   (0),
+m_table(1 << HashLog, 0)
+{
+    update();
+}
+
+
+////////////////////////////////////////////////////////////
+void CompressionDictionary::loadFromMemory(const void* data, std::size_t size)
+{
+    const char* begin = static_cast<const char*>(data);
+    if (size > MaxSize)
+    {
+        begin += size - MaxSize;
+        size = MaxSize;
+    }
+
+    m_data.assign(begin, begin + size);
+    update();
+}
+
+
+////////////////////////////////////////////////////////////
+void CompressionDictionary::train(const std::vector<Packet>& samples, std::size_t maxSize)
+{
+    maxSize = std::min<std::size_t>(maxSize, MaxSize);
+
+    // Count in how many samples each sequence appears
+    std::vector<Uint32> counts(1 << GramHashLog, 0);
+    std::vector<Uint32> lastSample(1 << GramHashLog, 0);
+    std::vector<Segment> segments;
+    for (std::size_t i = 0; i < samples.size(); ++i)
+    {
+        const char* data = static_cast<const char*>(samples[i].getData());
+        std::size_t size = samples[i].getDataSize();
+        if (size < GramSize)
+            continue;
+
+        for (std::size_t j = 0; j + GramSize <= size; ++j)
+        {
+            std::size_t gram = hashGram(data + j);
+            if (lastSample[gram] != i + 1)
+            {
+                lastSample[gram] = static_cast<Uint32>(i + 1);
+                ++counts[gram];
+            }
+        }
+
+        // Overlapping segments, so that a common sequence isn't always cut in two
+        for (std::size_t j = 0; j < size; j += SegmentSize / 2)
+        {
+            Segment segment = {data + j, std::min(SegmentSize, size - j)};
+            segments.push_back(segment);
+            if (j + SegmentSize >= size)
+                break;
+        }
+    }
+
+    // Pick the best segments, updating the scores lazily: taking a segment
+    // zeroes the counts of its sequences, which only lowers other scores
+    std::priority_queue<std::pair<Uint64, std::size_t> > queue;
+    for (std::size_t i = 0; i < segments.size(); ++i)
+    {
+        Uint64 score = getScore(segments[i], counts);
+        if (score > 0)
+            queue.push(std::make_pair(score, i));
+    }
+
+    std::vector<std::size_t> selected;
+    std::size_t size = 0;
+    while (!queue.empty() && (size < maxSize))
+    {
+        std::size_t index = queue.top().second;
+        queue.pop();
+
+        Uint64 score = getScore(segments[index], counts);
+        if (score == 0)
+            continue;
+
+        if (!queue.empty() && (score < queue.top().first))
+        {
+            queue.push(std::make_pair(score, index));
+            continue;
+        }
+
+        const Segment& segment = segments[index];
+        for (std::size_t i = 0; i + GramSize <= segment.size; ++i)
+            counts[hashGram(segment.data + i)] = 0;
+
+        selected.push_back(index);
+        size += segment.size;
+    }
+
+    // The best segments go last, closest to the data compressed
+    m_data.clear();
+    for (std::vector<std::size_t>::reverse_iterator it = selected.rbegin(); it != selected.rend(); ++it)
+        m_data.insert(m_data.end(), segments[*it].data, segments[*it].data + segments[*it].size);
+
+    if (m_data.size() > maxSize)
+        m_data.erase(m_data.begin(), m_data.begin() + (m_data.size() - maxSize));
+
+    update();
+}
+
+
+////////////////////////////////////////////////////////////
+const void* CompressionDictionary::getData() const
+{
+    return m_data.empty() ? NULL : &m_data[0];
+}
+
+
+////////////////////////////////////////////////////////////
+std::size_t CompressionDictionary::getSize() const
+{
+    return m_data.size();
+}
+
+
+////////////////////////////////////////////////////////////
+Uint32 CompressionDictionary::getId() const
+{
+    return m_id;
+}
+
+
+////////////////////////////////////////////////////////////
+Uint32 CompressionDictionary::hash(const char* data)
+{
+    Uint32 sequence;
+    std::memcpy(&sequence, data, sizeof(sequence));
+
+    return (sequence * 2654435761u) >> (32 - HashLog);
+}
+
+
+////////////////////////////////////////////////////////////
+void CompressionDictionary::update()
+{
+    // FNV-1a hash of the content
+    m_id = 2166136261u;
+    for (std::size_t i = 0; i < m_data.size(); ++i)
+        m_id = (m_id ^ static_cast<unsigned char>(m_data[i])) * 16777619u;
+
+    // Index the sequences of the dictionary, like the compressor does with its input
+    std::fill(m_table.begin(), m_table.end(), 0);
+    for (std::size_t i = 0; i + 4 <= m_data.size(); ++i)
+        m_table[hash(&m_data[i])] = static_cast<Uint32>(i);
+}
+
+} // namespace TGE
@@ -6,7 +6,9 @@
 /**             Headers             **/
 /*************************************/
 #include <Tyrant/Network/Ftp.hpp>
-#include <Tyrant/Network/IpAddress.hpp>
+#include <Tyrant/System/Lock.hpp>
+#include <Tyrant/System/Mutex.hpp>
+#include <Tyrant/System/Thread.hpp>
 #include <algorithm>
 #include <cctype>
 #include <fstream>
@@ -14,6 +16,28 @@
 #include <sstream>
 
 
+namespace
+{
+    // Size of the blocks read from and written to the files
+    const std::size_t TransferBufferSize = 256 * 1024;
+
+    // Extract the filename from a file path
+    std::string getFilename(const std::string& path)
+    {
+        std::string::size_type pos = path.find_last_of("/\\");
+        return (pos != std::string::npos) ? path.substr(pos + 1) : path;
+    }
+
+    // Make sure a directory path ends with a slash
+    std::string getDirectory(const std::string& path)
+    {
+        if (!path.empty() && (path[path.size() - 1] != '\\') && (path[path.size() - 1] != '/'))
+            return path + "/";
+
+        return path;
+    }
+}
+
 namespace TGE
 {
 ////////////////////////////////////////////////////////////
@@ -28,11 +52,17 @@ public :
     Ftp::Response open(Ftp::TransferMode mode);
 
     ////////////////////////////////////////////////////////////
-    void send(const std::vector<char>& data);
+    bool send(std::istream& stream, Uint64 offset, Uint64 total, const Ftp::ProgressCallback& progress);
 
     ////////////////////////////////////////////////////////////
     void receive(std::vector<char>& data);
 
+    ////////////////////////////////////////////////////////////
+    bool receive(std::ostream& stream, Uint64 offset, Uint64 total, const Ftp::ProgressCallback& progress);
+
+    ////////////////////////////////////////////////////////////
+    void abort();
+
 private :
 
     ////////////////////////////////////////////////////////////
@@ -119,6 +149,19 @@ const std::vector<std::string>& Ftp::ListingResponse::getListing() const
 }
 
 
+////////////////////////////////////////////////////////////
+Ftp::Ftp() :
+m_commandSocket(),
+m_server       (),
+m_port         (21),
+m_timeout      (),
+m_name         (),
+m_password     ()
+{
+
+}
+
+
 ////////////////////////////////////////////////////////////
 Ftp::~Ftp()
 {
@@ -129,6 +172,10 @@ Ftp::~Ftp()
 ////////////////////////////////////////////////////////////
 Ftp::Response Ftp::connect(const IpAddress& server, unsigned short port, Time timeout)
 {
+    m_server  = server;
+    m_port    = port;
+    m_timeout = timeout;
+
     // Connect to the server
     if (m_commandSocket.connect(server, port, timeout) != Socket::Done)
         return Response(Response::ConnectionFailed);
@@ -152,6 +199,13 @@ Ftp::Response Ftp::login(const std::string& name, const std::string& password)
     if (response.isOk())
         response = sendCommand("PASS", password);
 
+    // Keep the account, to open additional connections
+    if (response.isOk())
+    {
+        m_name     = name;
+        m_password = password;
+    }
+
     return response;
 }
 
@@ -254,91 +308,154 @@ Ftp::Response Ftp::deleteFile(const std::string& name)
 
 
 ////////////////////////////////////////////////////////////
-Ftp::Response Ftp::download(const std::string& remoteFile, const std::string& localPath, TransferMode mode)
+Ftp::Response Ftp::download(const std::string& remoteFile, const std::string& localPath, TransferMode mode, bool resume, const ProgressCallback& progress)
 {
+    std::string localFile = getDirectory(localPath) + getFilename(remoteFile);
+
+    // Find where to resume the download, if the file already exists
+    Uint64 offset = 0;
+    if (resume)
+    {
+        std::ifstream existing(localFile.c_str(), std::ios_base::binary | std::ios_base::ate);
+        if (existing)
+            offset = static_cast<Uint64>(existing.tellg());
+    }
+
     // Open a data channel using the given transfer mode
     DataChannel data(*this);
     Response response = data.open(mode);
     if (response.isOk())
     {
+        // A local file bigger than the distant one can't be a part of it
+        Uint64 total = getFileSize(remoteFile);
+        if ((offset > 0) && ((offset > total) || !restartAt(offset)))
+            offset = 0;
+
         // Tell the server to start the transfer
         response = sendCommand("RETR", remoteFile);
         if (response.isOk())
         {
-            // Receive the file data
-            std::vector<char> fileData;
-            data.receive(fileData);
+            // Write the file data as it is received
+            std::ofstream file(localFile.c_str(), std::ios_base::binary | (offset > 0 ? std::ios_base::app : std::ios_base::trunc));
+            if (!file)
+            {
+                data.abort();
+                getResponse();
+                return Response(Response::InvalidFile);
+            }
+
+            bool complete = data.receive(file, offset, total, progress);
 
             // Get the response from the server
             response = getResponse();
-            if (response.isOk())
+            if (!file)
+                response = Response(Response::InvalidFile);
+            else if (!complete && response.isOk())
+                response = Response(Response::TransferAborted);
+        }
+    }
+
+    return response;
+}
+
+
+////////////////////////////////////////////////////////////
+std::vector<Ftp::Response> Ftp::downloadFiles(const std::vector<std::string>& remoteFiles, const std::string& localPath,
+                                              unsigned int connectionCount, TransferMode mode, bool resume)
+{
+    std::vector<Response> responses(remoteFiles.size());
+    std::size_t next = 0;
+    Mutex mutex;
+
+    // The additional connections must work in the same directory
+    DirectoryResponse directory = getWorkingDirectory();
+
+    // Each connection downloads the next file left until none is
+    auto downloadNext = [&](Ftp& ftp)
+    {
+        for (;;)
+        {
+            std::size_t index;
             {
-                // Extract the filename from the file path
-                std::string filename = remoteFile;
-                std::string::size_type pos = filename.find_last_of("/\\");
-                if (pos != std::string::npos)
-                    filename = filename.substr(pos + 1);
-
-                // Make sure the destination path ends with a slash
-                std::string path = localPath;
-                if (!path.empty() && (path[path.size() - 1] != '\\') && (path[path.size() - 1] != '/'))
-                    path += "/";
-
-                // Create the file and copy the received data into it
-                std::ofstream file((path + filename).c_str(), std::ios_base::binary);
-                if (!file)
-                    return Response(Response::InvalidFile);
-
-                if (!fileData.empty())
-                    file.write(&fileData[0], static_cast<std::streamsize>(fileData.size()));
+                Lock lock(mutex);
+                if (next == remoteFiles.size())
+                    break;
+                index = next++;
             }
+
+            responses[index] = ftp.download(remoteFiles[index], localPath, mode, resume);
         }
+    };
+
+    auto work = [&]()
+    {
+        Ftp ftp;
+        if (ftp.connect(m_server, m_port, m_timeout).isOk() && ftp.login(m_name, m_password).isOk() &&
+            (!directory.isOk() || ftp.changeDirectory(directory.getDirectory()).isOk()))
+            downloadNext(ftp);
+    };
+
+    std::size_t additional = std::min<std::size_t>(std::max(connectionCount, 1u) - 1, remoteFiles.size() > 0 ? remoteFiles.size() - 1 : 0);
+    std::vector<Thread*> workers(additional);
+    for (std::size_t i = 0; i < workers.size(); ++i)
+    {
+        workers[i] = new Thread(work);
+        workers[i]->launch();
     }
 
-    return response;
+    // This connection takes part too, so that every file is downloaded
+    downloadNext(*this);
+
+    for (std::size_t i = 0; i < workers.size(); ++i)
+    {
+        workers[i]->wait();
+        delete workers[i];
+    }
+
+    return responses;
 }
 
 
 ////////////////////////////////////////////////////////////
-Ftp::Response Ftp::upload(const std::string& localFile, const std::string& remotePath, TransferMode mode)
+Ftp::Response Ftp::upload(const std::string& localFile, const std::string& remotePath, TransferMode mode, bool resume, const ProgressCallback& progress)
 {
-    // Get the contents of the file to send
+    // Open the file to send
     std::ifstream file(localFile.c_str(), std::ios_base::binary);
     if (!file)
         return Response(Response::InvalidFile);
 
     file.seekg(0, std::ios::end);
-    std::size_t length = static_cast<std::size_t>(file.tellg());
+    Uint64 total = static_cast<Uint64>(file.tellg());
     file.seekg(0, std::ios::beg);
-    std::vector<char> fileData(length);
-    if (length > 0)
-        file.read(&fileData[0], static_cast<std::streamsize>(length));
 
-    // Extract the filename from the file path
-    std::string filename = localFile;
-    std::string::size_type pos = filename.find_last_of("/\\");
-    if (pos != std::string::npos)
-        filename = filename.substr(pos + 1);
-
-    // Make sure the destination path ends with a slash
-    std::string path = remotePath;
-    if (!path.empty() && (path[path.size() - 1] != '\\') && (path[path.size() - 1] != '/'))
-        path += "/";
+    std::string remoteFile = getDirectory(remotePath) + getFilename(localFile);
 
     // Open a data channel using the given transfer mode
     DataChannel data(*this);
     Response response = data.open(mode);
     if (response.isOk())
     {
+        // Find where to resume the upload, if the file already exists on the server
+        Uint64 offset = 0;
+        if (resume)
+        {
+            offset = getFileSize(remoteFile);
+            if ((offset > total) || ((offset > 0) && !restartAt(offset)))
+                offset = 0;
+        }
+
         // Tell the server to start the transfer
-        response = sendCommand("STOR", path + filename);
+        response = sendCommand("STOR", remoteFile);
         if (response.isOk())
         {
-            // Send the file data
-            data.send(fileData);
+            // Send the file data as it is read
+            file.seekg(static_cast<std::streamoff>(offset));
+            bool complete = data.send(file, offset, total, progress);
 
             // Get the response from the server
             response = getResponse();
+            if (!complete && response.isOk())
+                response = Response(Response::TransferAborted);
         }
     }
 
@@ -497,6 +614,34 @@ Ftp::Response Ftp::getResponse()
 }
 
 
+////////////////////////////////////////////////////////////
+Uint64 Ftp::getFileSize(const std::string& name)
+{
+    // SIZE is an extension, not all servers support it
+    Response response = sendCommand("SIZE", name);
+
+    Uint64 size = 0;
+    if (response.getStatus() == Response::FileStatus)
+    {
+        std::istringstream in(response.getMessage());
+        if (!(in >> size))
+            size = 0;
+    }
+
+    return size;
+}
+
+
+////////////////////////////////////////////////////////////
+bool Ftp::restartAt(Uint64 offset)
+{
+    std::ostringstream parameter;
+    parameter << offset;
+
+    return sendCommand("REST", parameter.str()).getStatus() == Response::NeedInformation;
+}
+
+
 ////////////////////////////////////////////////////////////
 Ftp::DataChannel::DataChannel(Ftp& owner) :
 m_ftp(owner)
@@ -584,14 +729,63 @@ void Ftp::DataChannel::receive(std::vector<char>& data)
 
 
 ////////////////////////////////////////////////////////////
-void Ftp::DataChannel::send(const std::vector<char>& data)
+bool Ftp::DataChannel::receive(std::ostream& stream, Uint64 offset, Uint64 total, const Ftp::ProgressCallback& progress)
+{
+    // Receive data and write it directly to the stream
+    std::vector<char> buffer(TransferBufferSize);
+    std::size_t received;
+    bool complete = true;
+    while (m_dataSocket.receive(&buffer[0], buffer.size(), received) == Socket::Done)
+    {
+        stream.write(&buffer[0], static_cast<std::streamsize>(received));
+        offset += received;
+
+        if (!stream || (progress && !progress(offset, total)))
+        {
+            complete = false;
+            break;
+        }
+    }
+
+    // Close the data socket
+    m_dataSocket.disconnect();
+
+    return complete;
+}
+
+
+////////////////////////////////////////////////////////////
+bool Ftp::DataChannel::send(std::istream& stream, Uint64 offset, Uint64 total, const Ftp::ProgressCallback& progress)
 {
-    // Send data
-    if (!data.empty())
-        m_dataSocket.send(&data[0], data.size());
+    // Send data as it is read from the stream
+    std::vector<char> buffer(TransferBufferSize);
+    bool complete = true;
+    while (stream)
+    {
+        stream.read(&buffer[0], static_cast<std::streamsize>(buffer.size()));
+        std::size_t count = static_cast<std::size_t>(stream.gcount());
+        if (count == 0)
+            break;
+
+        offset += count;
+        if ((m_dataSocket.send(&buffer[0], count) != Socket::Done) || (progress && !progress(offset, total)))
+        {
+            complete = false;
+            break;
+        }
+    }
 
     // Close the data socket
     m_dataSocket.disconnect();
+
+    return complete;
+}
+
+
+////////////////////////////////////////////////////////////
+void Ftp::DataChannel::abort()
+{
+    m_dataSocket.disconnect();
 }
 
 } // namespace TGE
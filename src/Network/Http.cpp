@@ -6,16 +6,29 @@
 /**             Headers             **/
 /*************************************/
 #include <Tyrant/Network/Http.hpp>
+#include <Tyrant/System/Lock.hpp>
 #include <Tyrant/System/Log.hpp>
 #include <cctype>
 #include <algorithm>
-#include <iterator>
+#include <cstdlib>
+#include <cstring>
 #include <sstream>
-#include <limits>
 
 
 namespace
 {
+    // Size of the buffer receiving the responses
+    const std::size_t ReceiveBufferSize = 65536;
+
+    // Maximum length of a line of the header
+    const std::size_t MaxLineSize = 65536;
+
+    // Maximum number of connections kept open
+    const std::size_t MaxIdleConnections = 8;
+
+    // Time after which a connection kept open is closed, in microseconds
+    const TGE::Int64 MaxIdleTime = 30000000;
+
     // Convert a string to lower case
     std::string toLower(std::string str)
     {
@@ -23,6 +36,26 @@ namespace
             *i = static_cast<char>(std::tolower(*i));
         return str;
     }
+
+    // Tell if a request can be sent again without side effects, if
+    // its connection was closed before it got an answer
+    bool isRepeatable(TGE::Http::Request::Method method)
+    {
+        return (method == TGE::Http::Request::Get) || (method == TGE::Http::Request::Head);
+    }
+
+    // Tell if the server closed a connection kept open, or sent
+    // something unexpected on it, without waiting
+    bool isDropped(TGE::TcpSocket& socket)
+    {
+        char byte;
+        std::size_t received = 0;
+        socket.setBlocking(false);
+        TGE::Socket::Status status = socket.receive(&byte, 1, received);
+        socket.setBlocking(true);
+
+        return status != TGE::Socket::NotReady;
+    }
 }
 
 
@@ -33,7 +66,7 @@ Http::Request::Request(const std::string& uri, Method method, const std::string&
 {
     setMethod(method);
     setUri(uri);
-    setHttpVersion(1, 0);
+    setHttpVersion(1, 1);
     setBody(body);
 }
 
@@ -124,7 +157,13 @@ bool Http::Request::hasField(const std::string& field) const
 Http::Response::Response() :
 m_status      (ConnectionFailed),
 m_majorVersion(0),
-m_minorVersion(0)
+m_minorVersion(0),
+m_state       (StatusLine),
+m_remaining   (0),
+m_received    (0),
+m_hasBody     (true),
+m_keepAlive   (false),
+m_callback    (NULL)
 {
 
 }
@@ -175,125 +214,328 @@ const std::string& Http::Response::getBody() const
 
 
 ////////////////////////////////////////////////////////////
-void Http::Response::parse(const std::string& data)
+void Http::Response::startParsing(bool hasBody, const BodyCallback* callback)
 {
-    std::istringstream in(data);
+    m_fields.clear();
+    m_status       = ConnectionFailed;
+    m_majorVersion = 0;
+    m_minorVersion = 0;
+    m_body.clear();
+    m_state        = StatusLine;
+    m_line.clear();
+    m_remaining    = 0;
+    m_received     = 0;
+    m_hasBody      = hasBody;
+    m_keepAlive    = false;
+    m_callback     = callback;
+}
+
 
-    // Extract the HTTP version from the first line
-    std::string version;
-    if (in >> version)
+////////////////////////////////////////////////////////////
+std::size_t Http::Response::parse(const char* data, std::size_t size)
+{
+    const char* current = data;
+    const char* end = data + size;
+
+    while ((current < end) && (m_state != Complete) && (m_state != Failed))
     {
-        if ((version.size() >= 8) && (version[6] == '.') &&
-            (toLower(version.substr(0, 5)) == "http/")   &&
-             isdigit(version[5]) && isdigit(version[7]))
+        if ((m_state == Body) || (m_state == ChunkData))
         {
-            m_majorVersion = version[5] - '0';
-            m_minorVersion = version[7] - '0';
+            // Hand out the body directly from the received data
+            std::size_t count = std::min<std::size_t>(m_remaining, end - current);
+            receiveBody(current, count);
+            current += count;
+            m_remaining -= count;
+
+            if ((m_remaining == 0) && (m_state != Failed))
+                m_state = (m_state == Body) ? Complete : ChunkEnd;
+        }
+        else if (m_state == BodyUntilClose)
+        {
+            receiveBody(current, end - current);
+            current = end;
         }
         else
         {
-            // Invalid HTTP version
-            m_status = InvalidResponse;
-            return;
+            const char* lineEnd = static_cast<const char*>(std::memchr(current, '\n', end - current));
+            if (!lineEnd)
+            {
+                // The line continues in the next data received
+                m_line.append(current, end);
+                current = end;
+
+                if (m_line.size() > MaxLineSize)
+                {
+                    m_status = InvalidResponse;
+                    m_state  = Failed;
+                }
+            }
+            else if (m_line.empty())
+            {
+                parseLine(current, lineEnd);
+                current = lineEnd + 1;
+            }
+            else
+            {
+                m_line.append(current, lineEnd);
+                parseLine(m_line.data(), m_line.data() + m_line.size());
+                m_line.clear();
+                current = lineEnd + 1;
+            }
         }
     }
 
-    // Extract the status code from the first line
-    int status;
-    if (in >> status)
+    m_received += current - data;
+
+    return current - data;
+}
+
+
+////////////////////////////////////////////////////////////
+void Http::Response::finishParsing()
+{
+    // Without length nor chunks, the end of the connection is the end of the body
+    if (m_state == BodyUntilClose)
     {
-        m_status = static_cast<Status>(status);
+        m_state = Complete;
     }
-    else
+    else if ((m_state != Complete) && (m_state != Failed))
     {
-        // Invalid status code
-        m_status = InvalidResponse;
-        return;
+        m_status = (m_received == 0) ? ConnectionFailed : InvalidResponse;
+        m_state  = Failed;
     }
 
-    // Ignore the end of the first line
-    in.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+    m_keepAlive = false;
+}
 
-    // Parse the other lines, which contain fields, one by one
-    parseFields(in);
 
-    m_body.clear();
+////////////////////////////////////////////////////////////
+void Http::Response::parseLine(const char* begin, const char* end)
+{
+    // Remove the trailing \r
+    if ((begin != end) && (*(end - 1) == '\r'))
+        --end;
 
-    // Determine whether the transfer is chunked
-    if (toLower(getField("transfer-encoding")) != "chunked")
+    switch (m_state)
     {
-        // Not chunked - just read everything at once
-        std::copy(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>(), std::back_inserter(m_body));
-    }
-    else
-    {
-        // Chunked - have to read chunk by chunk
-        std::size_t length;
+        case StatusLine :
+        {
+            // Ignore empty lines before the status line
+            if (begin == end)
+                return;
 
-        // Read all chunks, identified by a chunk-size not being 0
-        while (in >> std::hex >> length)
+            // Extract the HTTP version
+            if ((end - begin < 8) || (toLower(std::string(begin, begin + 5)) != "http/") ||
+                !isdigit(begin[5]) || (begin[6] != '.') || !isdigit(begin[7]))
+            {
+                m_status = InvalidResponse;
+                m_state  = Failed;
+                return;
+            }
+            m_majorVersion = begin[5] - '0';
+            m_minorVersion = begin[7] - '0';
+
+            // Extract the status code
+            const char* current = begin + 8;
+            while ((current != end) && (*current == ' '))
+                ++current;
+
+            int status = 0;
+            const char* digits = current;
+            while ((current != end) && isdigit(*current))
+                status = status * 10 + (*current++ - '0');
+
+            if ((current == digits) || (current - digits > 3))
+            {
+                m_status = InvalidResponse;
+                m_state  = Failed;
+                return;
+            }
+
+            m_status = static_cast<Status>(status);
+            m_fields.clear();
+            m_state = Header;
+            break;
+        }
+
+        case Header :
+        case Trailer :
         {
-            // Drop the rest of the line (chunk-extension)
-            in.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+            // An empty line ends the header
+            if (begin == end)
+            {
+                if (m_state == Header)
+                    startBody();
+                else
+                    m_state = Complete;
+                return;
+            }
+
+            const char* colon = std::find(begin, end, ':');
+            if (colon == end)
+                return;
+
+            // Extract the field name and its value, without the surrounding spaces
+            const char* value = colon + 1;
+            while ((value != end) && ((*value == ' ') || (*value == '\t')))
+                ++value;
+            while ((end != value) && ((*(end - 1) == ' ') || (*(end - 1) == '\t')))
+                --end;
+
+            m_fields[toLower(std::string(begin, colon))].assign(value, end);
+            break;
+        }
+
+        case ChunkSize :
+        {
+            // The size is in hexadecimal, possibly followed by extensions
+            std::size_t size = 0;
+            const char* current = begin;
+            while ((current != end) && isxdigit(*current) && (current - begin < 16))
+            {
+                char digit = static_cast<char>(std::tolower(*current++));
+                size = size * 16 + (isdigit(digit) ? digit - '0' : digit - 'a' + 10);
+            }
 
-            // Copy the actual content data
-            std::istreambuf_iterator<char> it(in);
-            for (std::size_t i = 0; i < length; i++)
-                m_body.push_back(*it++);
+            if (current == begin)
+            {
+                m_status = InvalidResponse;
+                m_state  = Failed;
+                return;
+            }
+
+            m_remaining = size;
+            m_state = (size > 0) ? ChunkData : Trailer;
+            break;
         }
 
-        // Drop the rest of the line (chunk-extension)
-        in.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+        case ChunkEnd :
+        {
+            if (begin != end)
+            {
+                m_status = InvalidResponse;
+                m_state  = Failed;
+                return;
+            }
 
-        // Read all trailers (if present)
-        parseFields(in);
+            m_state = ChunkSize;
+            break;
+        }
+
+        default :
+            break;
     }
 }
 
 
 ////////////////////////////////////////////////////////////
-void Http::Response::parseFields(std::istream &in)
+void Http::Response::startBody()
 {
-    std::string line;
-    while (std::getline(in, line) && (line.size() > 2))
+    // Informational responses are followed by the actual one
+    if ((m_status >= 100) && (m_status < 200))
+    {
+        m_state = StatusLine;
+        return;
+    }
+
+    // HTTP/1.1 connections stay open unless told otherwise, HTTP/1.0 ones the opposite
+    std::string connection = toLower(getField("connection"));
+    if (m_majorVersion * 10 + m_minorVersion >= 11)
+        m_keepAlive = connection != "close";
+    else
+        m_keepAlive = connection == "keep-alive";
+
+    const std::string& length = getField("content-length");
+    if (!m_hasBody || (m_status == NoContent) || (m_status == NotModified))
+    {
+        m_state = Complete;
+    }
+    else if (toLower(getField("transfer-encoding")).find("chunked") != std::string::npos)
     {
-        std::string::size_type pos = line.find(": ");
-        if (pos != std::string::npos)
+        m_state = ChunkSize;
+    }
+    else if (!length.empty())
+    {
+        char* end = NULL;
+        m_remaining = static_cast<std::size_t>(std::strtoul(length.c_str(), &end, 10));
+        if (*end != '\0')
         {
-            // Extract the field name and its value
-            std::string field = line.substr(0, pos);
-            std::string value = line.substr(pos + 2);
+            m_status = InvalidResponse;
+            m_state  = Failed;
+            return;
+        }
+
+        m_state = (m_remaining > 0) ? Body : Complete;
+    }
+    else
+    {
+        m_state     = BodyUntilClose;
+        m_keepAlive = false;
+    }
+}
 
-            // Remove any trailing \r
-            if (!value.empty() && (*value.rbegin() == '\r'))
-                value.erase(value.size() - 1);
 
-            // Add the field
-            m_fields[toLower(field)] = value;
+////////////////////////////////////////////////////////////
+void Http::Response::receiveBody(const char* data, std::size_t size)
+{
+    if (size == 0)
+        return;
+
+    if (m_callback)
+    {
+        // The callback may abort the transfer, the connection can't be used anymore
+        if (!(*m_callback)(data, size))
+        {
+            m_state     = Failed;
+            m_keepAlive = false;
         }
     }
+    else
+    {
+        m_body.append(data, size);
+    }
 }
 
 
 ////////////////////////////////////////////////////////////
 Http::Http() :
-m_host(),
-m_port(0)
+m_host       (),
+m_hostName   (),
+m_port       (0),
+m_connections(),
+m_mutex      (),
+m_clock      ()
 {
 
 }
 
 
 ////////////////////////////////////////////////////////////
-Http::Http(const std::string& host, unsigned short port)
+Http::Http(const std::string& host, unsigned short port) :
+m_host       (),
+m_hostName   (),
+m_port       (0),
+m_connections(),
+m_mutex      (),
+m_clock      ()
 {
     setHost(host, port);
 }
 
 
+////////////////////////////////////////////////////////////
+Http::~Http()
+{
+    closeConnections();
+}
+
+
 ////////////////////////////////////////////////////////////
 void Http::setHost(const std::string& host, unsigned short port)
 {
+    // The connections kept open lead to the previous host
+    closeConnections();
+
     // Check the protocol
     if (toLower(host.substr(0, 7)) == "http://")
     {
@@ -325,6 +567,49 @@ void Http::setHost(const std::string& host, unsigned short port)
 
 ////////////////////////////////////////////////////////////
 Http::Response Http::sendRequest(const Http::Request& request, Time timeout)
+{
+    Response received;
+    process(&request, &received, 1, NULL, timeout);
+
+    return received;
+}
+
+
+////////////////////////////////////////////////////////////
+Http::Response Http::sendRequest(const Http::Request& request, const BodyCallback& callback, Time timeout)
+{
+    Response received;
+    process(&request, &received, 1, &callback, timeout);
+
+    return received;
+}
+
+
+////////////////////////////////////////////////////////////
+std::vector<Http::Response> Http::sendRequests(const std::vector<Request>& requests, Time timeout)
+{
+    std::vector<Response> received(requests.size());
+    if (!requests.empty())
+        process(&requests[0], &received[0], requests.size(), NULL, timeout);
+
+    return received;
+}
+
+
+////////////////////////////////////////////////////////////
+void Http::closeConnections()
+{
+    Lock lock(m_mutex);
+
+    for (std::vector<Connection*>::iterator it = m_connections.begin(); it != m_connections.end(); ++it)
+        delete *it;
+
+    m_connections.clear();
+}
+
+
+////////////////////////////////////////////////////////////
+std::string Http::prepareRequest(const Http::Request& request) const
 {
     // First make sure that the request is valid -- add missing mandatory fields
     Request toSend(request);
@@ -350,44 +635,182 @@ Http::Response Http::sendRequest(const Http::Request& request, Time timeout)
     {
         toSend.setField("Content-Type", "application/x-www-form-urlencoded");
     }
-    if ((toSend.m_majorVersion * 10 + toSend.m_minorVersion >= 11) && !toSend.hasField("Connection"))
+
+    return toSend.prepare();
+}
+
+
+////////////////////////////////////////////////////////////
+void Http::process(const Request* requests, Response* responses, std::size_t count, const BodyCallback* callback, Time timeout)
+{
+    std::size_t done = 0;
+    while (done < count)
     {
-        toSend.setField("Connection", "close");
+        bool reused = false;
+        Connection* connection = acquireConnection(timeout, reused);
+        if (!connection)
+        {
+            for (; done < count; ++done)
+                responses[done] = Response();
+            return;
+        }
+
+        // A request which can't be repeated must not be lost on a connection
+        // that the server already closed
+        if (reused && !isRepeatable(requests[done].m_method) && isDropped(connection->socket))
+        {
+            delete connection;
+            continue;
+        }
+
+        // Write the requests left at once, up to the first one which can't
+        // be repeated: it is sent alone, so that it's never lost behind
+        // another request if the server closes the connection
+        std::size_t last = done + 1;
+        if (isRepeatable(requests[done].m_method))
+        {
+            while ((last < count) && isRepeatable(requests[last].m_method))
+                ++last;
+        }
+
+        std::string data;
+        for (std::size_t i = done; i < last; ++i)
+            data += prepareRequest(requests[i]);
+
+        if (connection->socket.send(data.c_str(), data.size()) != Socket::Done)
+        {
+            delete connection;
+
+            // A connection kept open may have been closed by the server meanwhile
+            if (reused && isRepeatable(requests[done].m_method))
+                continue;
+
+            for (; done < count; ++done)
+                responses[done] = Response();
+            return;
+        }
+
+        // Read the responses in order
+        bool keepAlive = true;
+        std::size_t answered = 0;
+        while ((done < last) && keepAlive)
+        {
+            const Request& request = requests[done];
+            Response& response = responses[done];
+            response.startParsing(request.m_method != Request::Head, callback);
+            receiveResponse(*connection, response);
+
+            // If the server closed the connection without answering, after
+            // answering the previous requests, send the request again if
+            // that's harmless
+            if ((response.m_state == Response::Failed) && (response.m_received == 0) && (reused || (answered > 0)) &&
+                isRepeatable(request.m_method))
+            {
+                keepAlive = false;
+                break;
+            }
+
+            Request::FieldTable::const_iterator field = request.m_fields.find("connection");
+            keepAlive = response.m_keepAlive && (response.m_state == Response::Complete) &&
+                        ((field == request.m_fields.end()) || (toLower(field->second) != "close"));
+
+            ++done;
+            ++answered;
+        }
+
+        // Unexpected data after the last response means the connection can't be trusted
+        if (keepAlive && (connection->begin == connection->end))
+            releaseConnection(connection);
+        else
+            delete connection;
     }
+}
 
-    // Prepare the response
-    Response received;
 
-    // Connect the socket to the host
-    if (m_connection.connect(m_host, m_port, timeout) == Socket::Done)
+////////////////////////////////////////////////////////////
+Http::Connection* Http::acquireConnection(Time timeout, bool& reused)
+{
     {
-        // Convert the request to string and send it through the connected socket
-        std::string requestStr = toSend.prepare();
+        Lock lock(m_mutex);
 
-        if (!requestStr.empty())
+        Int64 now = m_clock.getElapsedTime().asMicroseconds();
+        while (!m_connections.empty())
         {
-            // Send it through the socket
-            if (m_connection.send(requestStr.c_str(), requestStr.size()) == Socket::Done)
-            {
-                // Wait for the server's response
-                std::string receivedStr;
-                std::size_t size = 0;
-                char buffer[1024];
-                while (m_connection.receive(buffer, sizeof(buffer), size) == Socket::Done)
-                {
-                    receivedStr.append(buffer, buffer + size);
-                }
+            Connection* connection = m_connections.back();
+            m_connections.pop_back();
 
-                // Build the Response object from the received data
-                received.parse(receivedStr);
+            // Servers close idle connections after a while, don't bother with old ones
+            if (now - connection->lastUsed < MaxIdleTime)
+            {
+                reused = true;
+                return connection;
             }
+
+            delete connection;
         }
+    }
+
+    reused = false;
 
-        // Close the connection
-        m_connection.disconnect();
+    Connection* connection = new Connection;
+    connection->buffer.resize(ReceiveBufferSize);
+    connection->begin    = 0;
+    connection->end      = 0;
+    connection->lastUsed = 0;
+
+    if (connection->socket.connect(m_host, m_port, timeout) != Socket::Done)
+    {
+        delete connection;
+        return NULL;
     }
 
-    return received;
+    return connection;
+}
+
+
+////////////////////////////////////////////////////////////
+void Http::releaseConnection(Connection* connection)
+{
+    Lock lock(m_mutex);
+
+    if (m_connections.size() < MaxIdleConnections)
+    {
+        connection->lastUsed = m_clock.getElapsedTime().asMicroseconds();
+        m_connections.push_back(connection);
+    }
+    else
+    {
+        delete connection;
+    }
+}
+
+
+////////////////////////////////////////////////////////////
+void Http::receiveResponse(Connection& connection, Response& response)
+{
+    for (;;)
+    {
+        // Parse the data already received, which may belong to this response
+        if (connection.begin < connection.end)
+        {
+            connection.begin += response.parse(&connection.buffer[connection.begin], connection.end - connection.begin);
+            if ((response.m_state == Response::Complete) || (response.m_state == Response::Failed))
+                return;
+        }
+
+        // Everything was parsed, receive more data
+        connection.begin = 0;
+        connection.end   = 0;
+
+        std::size_t received = 0;
+        if (connection.socket.receive(&connection.buffer[0], connection.buffer.size(), received) != Socket::Done)
+        {
+            response.finishParsing();
+            return;
+        }
+
+        connection.end = received;
+    }
 }
 
 } // namespace TGE
@@ -0,0 +1,446 @@
+/*************************************/
+/** Copyright © 2014 Coldsnap Games **/
+/*************************************/
+
+/*************************************/
+/**             Headers             **/
+/*************************************/
+#include <Tyrant/Network/HttpDownloader.hpp>
+#include <Tyrant/System/Lock.hpp>
+#include <Tyrant/System/Log.hpp>
+#include <Tyrant/System/Thread.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+
+
+namespace
+{
+    // Number of times a chunk is downloaded before giving up
+    const unsigned int MaxAttempts = 3;
+
+    // First line of the journals
+    const char* JournalSignature = "TGE-DOWNLOAD 1";
+
+    // Table of the CRC-32, computed once
+    struct ChecksumTable
+    {
+        ChecksumTable()
+        {
+            for (TGE::Uint32 i = 0; i < 256; ++i)
+            {
+                TGE::Uint32 value = i;
+                for (int bit = 0; bit < 8; ++bit)
+                    value = (value & 1) ? (value >> 1) ^ 0xEDB88320u : value >> 1;
+                entries[i] = value;
+            }
+        }
+
+        TGE::Uint32 entries[256];
+    };
+
+    // Parse an unsigned 64-bit integer
+    bool parseSize(const std::string& text, TGE::Uint64& value)
+    {
+        if (text.empty())
+            return false;
+
+        value = 0;
+        for (std::string::const_iterator it = text.begin(); it != text.end(); ++it)
+        {
+            if ((*it < '0') || (*it > '9'))
+                return false;
+            value = value * 10 + (*it - '0');
+        }
+
+        return true;
+    }
+}
+
+namespace TGE
+{
+////////////////////////////////////////////////////////////
+HttpDownloader::HttpDownloader() :
+m_http           (),
+m_connectionCount(4),
+m_chunkSize      (4 * 1024 * 1024),
+m_expected       (),
+m_uri            (),
+m_partName       (),
+m_timeout        (),
+m_chunks         (),
+m_journal        (),
+m_mutex          (),
+m_stop           (false),
+m_downloadedSize (0),
+m_totalSize      (0)
+{
+
+}
+
+
+////////////////////////////////////////////////////////////
+void HttpDownloader::setHost(const std::string& host, unsigned short port)
+{
+    m_http.setHost(host, port);
+}
+
+
+////////////////////////////////////////////////////////////
+void HttpDownloader::setConnectionCount(unsigned int count)
+{
+    m_connectionCount = std::max(count, 1u);
+}
+
+
+////////////////////////////////////////////////////////////
+void HttpDownloader::setChunkSize(std::size_t size)
+{
+    m_chunkSize = std::max<std::size_t>(size, 1);
+}
+
+
+////////////////////////////////////////////////////////////
+void HttpDownloader::setExpectedChecksums(const std::vector<Uint32>& checksums)
+{
+    m_expected = checksums;
+}
+
+
+////////////////////////////////////////////////////////////
+HttpDownloader::Status HttpDownloader::download(const std::string& uri, const std::string& filename, Time timeout)
+{
+    m_stop           = false;
+    m_downloadedSize = 0;
+    m_totalSize      = 0;
+    m_uri            = uri;
+    m_partName       = filename + ".part";
+    m_timeout        = timeout;
+    m_chunks.clear();
+
+    // Ask for the size of the file, and whether it can be downloaded in ranges
+    Http::Response response = m_http.sendRequest(Http::Request(uri, Http::Request::Head), timeout);
+    if (response.getStatus() != Http::Response::Ok)
+    {
+        Log() << "Failed to download " << uri << " (HTTP status " << response.getStatus() << ")" << std::endl;
+        return Error;
+    }
+
+    Uint64 totalSize = 0;
+    if ((response.getField("accept-ranges") != "bytes") || !parseSize(response.getField("content-length"), totalSize))
+        return downloadWhole(filename);
+
+    m_totalSize = totalSize;
+
+    // Split the file in chunks
+    for (Uint64 offset = 0; offset < totalSize; offset += m_chunkSize)
+    {
+        Chunk chunk;
+        chunk.offset   = offset;
+        chunk.size     = std::min<Uint64>(m_chunkSize, totalSize - offset);
+        chunk.state    = Pending;
+        chunk.attempts = 0;
+        m_chunks.push_back(chunk);
+    }
+
+    if (!m_expected.empty() && (m_expected.size() != m_chunks.size()))
+    {
+        Log() << "Failed to download " << uri << " (expected " << m_expected.size() << " checksums, the file has "
+              << m_chunks.size() << " chunks)" << std::endl;
+        return Error;
+    }
+
+    // The file is identified by its ETag, or its date if it has none
+    std::string validator = response.getField("etag");
+    if (validator.empty())
+        validator = response.getField("last-modified");
+
+    if (!loadJournal(filename, validator))
+    {
+        // Start a new download: preallocate the file, and write the header of the journal
+        std::ofstream file(m_partName.c_str(), std::ios::binary | std::ios::trunc);
+        if (totalSize > 0)
+        {
+            file.seekp(static_cast<std::streamoff>(totalSize - 1));
+            file.put('\0');
+        }
+        if (!file)
+        {
+            Log() << "Failed to create file \"" << m_partName << "\"" << std::endl;
+            return Error;
+        }
+
+        m_journal.open((filename + ".journal").c_str(), std::ios::trunc);
+        m_journal << JournalSignature << '\n' << totalSize << ' ' << m_chunkSize << '\n' << validator << std::endl;
+    }
+    else
+    {
+        m_journal.open((filename + ".journal").c_str(), std::ios::app);
+    }
+
+    if (!m_journal)
+    {
+        Log() << "Failed to write journal \"" << filename << ".journal\"" << std::endl;
+        m_journal.close();
+        return Error;
+    }
+
+    // Download the chunks left, one connection per worker
+    std::size_t pending = 0;
+    for (std::vector<Chunk>::const_iterator it = m_chunks.begin(); it != m_chunks.end(); ++it)
+        pending += (it->state != Finished) ? 1 : 0;
+
+    std::vector<Thread*> workers(std::min<std::size_t>(m_connectionCount, pending));
+    for (std::size_t i = 0; i < workers.size(); ++i)
+    {
+        workers[i] = new Thread(&HttpDownloader::downloadChunks, this);
+        workers[i]->launch();
+    }
+    for (std::size_t i = 0; i < workers.size(); ++i)
+    {
+        workers[i]->wait();
+        delete workers[i];
+    }
+
+    m_journal.close();
+
+    for (std::vector<Chunk>::const_iterator it = m_chunks.begin(); it != m_chunks.end(); ++it)
+    {
+        if (it->state != Finished)
+            return m_stop ? Stopped : Error;
+    }
+
+    if (!finish(filename))
+        return Error;
+
+    std::remove((filename + ".journal").c_str());
+
+    return Done;
+}
+
+
+////////////////////////////////////////////////////////////
+void HttpDownloader::stop()
+{
+    m_stop = true;
+}
+
+
+////////////////////////////////////////////////////////////
+Uint64 HttpDownloader::getDownloadedSize() const
+{
+    return m_downloadedSize;
+}
+
+
+////////////////////////////////////////////////////////////
+Uint64 HttpDownloader::getTotalSize() const
+{
+    return m_totalSize;
+}
+
+
+////////////////////////////////////////////////////////////
+Uint32 HttpDownloader::computeChecksum(const void* data, std::size_t size, Uint32 previous)
+{
+    static const ChecksumTable table;
+
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    Uint32 checksum = ~previous;
+    for (std::size_t i = 0; i < size; ++i)
+        checksum = table.entries[(checksum ^ bytes[i]) & 0xFF] ^ (checksum >> 8);
+
+    return ~checksum;
+}
+
+
+////////////////////////////////////////////////////////////
+HttpDownloader::Status HttpDownloader::downloadWhole(const std::string& filename)
+{
+    // Without ranges there's nothing to resume
+    std::remove((filename + ".journal").c_str());
+
+    std::ofstream file(m_partName.c_str(), std::ios::binary | std::ios::trunc);
+    if (!file)
+    {
+        Log() << "Failed to create file \"" << m_partName << "\"" << std::endl;
+        return Error;
+    }
+
+    Http::Response response = m_http.sendRequest(Http::Request(m_uri), [&](const char* data, std::size_t size) -> bool
+    {
+        file.write(data, size);
+        m_downloadedSize += size;
+        return !m_stop && file;
+    }, m_timeout);
+
+    file.close();
+
+    if (m_stop)
+        return Stopped;
+
+    if ((response.getStatus() != Http::Response::Ok) || !file)
+    {
+        Log() << "Failed to download " << m_uri << " (HTTP status " << response.getStatus() << ")" << std::endl;
+        return Error;
+    }
+
+    m_totalSize = m_downloadedSize.load();
+
+    return finish(filename) ? Done : Error;
+}
+
+
+////////////////////////////////////////////////////////////
+bool HttpDownloader::loadJournal(const std::string& filename, const std::string& validator)
+{
+    std::ifstream journal((filename + ".journal").c_str());
+    std::ifstream file(m_partName.c_str(), std::ios::binary);
+    if (!journal || !file)
+        return false;
+
+    // The previous download must be of the same file, with the same chunks
+    std::string signature;
+    std::string previousValidator;
+    Uint64 totalSize = 0;
+    std::size_t chunkSize = 0;
+    std::getline(journal, signature);
+    journal >> totalSize >> chunkSize;
+    journal.ignore(1);
+    std::getline(journal, previousValidator);
+
+    if (!journal || (signature != JournalSignature) || (totalSize != m_totalSize) ||
+        (chunkSize != m_chunkSize) || (previousValidator != validator))
+        return false;
+
+    // Verify the chunks recorded; a record cut by a crash simply doesn't parse
+    std::vector<char> buffer(64 * 1024);
+    std::size_t index;
+    Uint32 checksum;
+    while (journal >> index >> checksum)
+    {
+        if ((index >= m_chunks.size()) || (m_chunks[index].state == Finished))
+            continue;
+
+        Chunk& chunk = m_chunks[index];
+        file.seekg(static_cast<std::streamoff>(chunk.offset));
+
+        Uint32 actual = 0;
+        for (Uint64 left = chunk.size; left > 0 && file; )
+        {
+            std::size_t count = static_cast<std::size_t>(std::min<Uint64>(left, buffer.size()));
+            file.read(&buffer[0], count);
+            actual = computeChecksum(&buffer[0], static_cast<std::size_t>(file.gcount()), actual);
+            left -= count;
+        }
+
+        if (file && (actual == checksum) && (m_expected.empty() || (m_expected[index] == checksum)))
+        {
+            chunk.state = Finished;
+            m_downloadedSize += chunk.size;
+        }
+
+        file.clear();
+    }
+
+    return true;
+}
+
+
+////////////////////////////////////////////////////////////
+void HttpDownloader::downloadChunks()
+{
+    std::fstream file(m_partName.c_str(), std::ios::in | std::ios::out | std::ios::binary);
+    if (!file)
+    {
+        Log() << "Failed to open file \"" << m_partName << "\"" << std::endl;
+        return;
+    }
+
+    while (!m_stop)
+    {
+        // Take the next chunk to download
+        Chunk* chunk = NULL;
+        std::size_t index = 0;
+        {
+            Lock lock(m_mutex);
+            for (index = 0; index < m_chunks.size(); ++index)
+            {
+                if ((m_chunks[index].state == Pending) && (m_chunks[index].attempts < MaxAttempts))
+                {
+                    chunk = &m_chunks[index];
+                    chunk->state = InProgress;
+                    break;
+                }
+            }
+        }
+
+        if (!chunk)
+            break;
+
+        std::ostringstream range;
+        range << "bytes=" << chunk->offset << "-" << (chunk->offset + chunk->size - 1);
+
+        Http::Request request(m_uri);
+        request.setField("Range", range.str());
+
+        // Write the data to its place in the file as it arrives
+        file.seekp(static_cast<std::streamoff>(chunk->offset));
+        Uint64 written = 0;
+        Uint32 checksum = 0;
+        Http::Response response = m_http.sendRequest(request, [&](const char* data, std::size_t size) -> bool
+        {
+            if (m_stop || (written + size > chunk->size))
+                return false;
+
+            file.write(data, size);
+            checksum = computeChecksum(data, size, checksum);
+            written += size;
+            m_downloadedSize += size;
+
+            return !file.fail();
+        }, m_timeout);
+
+        file.flush();
+
+        bool valid = (response.getStatus() == Http::Response::PartialContent) && (written == chunk->size) && !file.fail() &&
+                     (m_expected.empty() || (m_expected[index] == checksum));
+
+        Lock lock(m_mutex);
+        if (valid)
+        {
+            chunk->state = Finished;
+            m_journal << index << ' ' << checksum << std::endl;
+        }
+        else
+        {
+            chunk->state = Pending;
+            m_downloadedSize -= written;
+            file.clear();
+
+            if (!m_stop && (++chunk->attempts == MaxAttempts))
+            {
+                Log() << "Failed to download bytes " << chunk->offset << " to " << (chunk->offset + chunk->size - 1)
+                      << " of " << m_uri << " (HTTP status " << response.getStatus() << ")" << std::endl;
+            }
+        }
+    }
+}
+
+
+////////////////////////////////////////////////////////////
+bool HttpDownloader::finish(const std::string& filename)
+{
+    // Renaming doesn't replace an existing file on all systems
+    std::remove(filename.c_str());
+    if (std::rename(m_partName.c_str(), filename.c_str()) != 0)
+    {
+        Log() << "Failed to rename \"" << m_partName << "\" to \"" << filename << "\"" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+} // namespace TGE
@@ -0,0 +1,372 @@
+/*************************************/
+/** Copyright © 2014 Coldsnap Games **/
+/*************************************/
+
+/*************************************/
+/**             Headers             **/
+/*************************************/
+#include <Tyrant/Network/InterestManager.hpp>
+#include <algorithm>
+#include <cmath>
+
+
+namespace
+{
+    // Default ratio of the leaving radius to the entering radius
+    const float DefaultHysteresis = 1.2f;
+
+    // Default priority factor of the entities that didn't change
+    const float DefaultIdleFactor = 0.1f;
+
+    // Default size of the updates of a client, fits a datagram
+    const std::size_t DefaultBudget = 1200;
+
+    // Priority factor of the entities at the edge of an area, 1 at its center
+    const float EdgeFactor = 0.25f;
+
+    // Number of entities that may not fit in the budget before the packet is considered full
+    const std::size_t MaxMisses = 8;
+
+    // Returned for the clients that don't exist
+    const std::vector<TGE::Uint16> NoEntities;
+}
+
+namespace TGE
+{
+////////////////////////////////////////////////////////////
+InterestManager::Client::Client() :
+connected(false),
+center   (),
+radius   (0),
+budget   (DefaultBudget),
+interests(),
+entered  (),
+left     ()
+{
+
+}
+
+
+////////////////////////////////////////////////////////////
+InterestManager::InterestManager(float cellSize) :
+m_cellSize  (cellSize > 0 ? cellSize : 1.f),
+m_hysteresis(DefaultHysteresis),
+m_idleFactor(DefaultIdleFactor),
+m_tick      (0),
+m_entities  (),
+m_clients   (),
+m_grid      (),
+m_candidates(),
+m_marks     (),
+m_distances (),
+m_stamp     (0),
+m_interests (),
+m_order     (),
+m_update    ()
+{
+
+}
+
+
+////////////////////////////////////////////////////////////
+void InterestManager::setHysteresis(float factor)
+{
+    m_hysteresis = std::max(factor, 1.f);
+}
+
+
+////////////////////////////////////////////////////////////
+void InterestManager::setIdleFactor(float factor)
+{
+    m_idleFactor = std::max(factor, 0.f);
+}
+
+
+////////////////////////////////////////////////////////////
+void InterestManager::setEntity(Uint16 entity, const Vector2f& position, float priority)
+{
+    if (entity >= m_entities.size())
+    {
+        Entity none = {false, Vector2f(), 0.f, 0};
+        m_entities.resize(entity + 1, none);
+    }
+
+    // Changes made between two updates belong to the next tick
+    Entity& state = m_entities[entity];
+    if (!state.exists || (state.position != position))
+        state.changeTick = m_tick + 1;
+
+    state.exists   = true;
+    state.position = position;
+    state.priority = priority;
+}
+
+
+////////////////////////////////////////////////////////////
+void InterestManager::markChanged(Uint16 entity)
+{
+    if ((entity < m_entities.size()) && m_entities[entity].exists)
+        m_entities[entity].changeTick = m_tick + 1;
+}
+
+
+////////////////////////////////////////////////////////////
+void InterestManager::removeEntity(Uint16 entity)
+{
+    if (entity < m_entities.size())
+        m_entities[entity].exists = false;
+}
+
+
+////////////////////////////////////////////////////////////
+std::size_t InterestManager::addClient()
+{
+    std::size_t client = 0;
+    while ((client < m_clients.size()) && m_clients[client].connected)
+        ++client;
+
+    if (client == m_clients.size())
+        m_clients.push_back(Client());
+    else
+        m_clients[client] = Client();
+
+    m_clients[client].connected = true;
+
+    return client;
+}
+
+
+////////////////////////////////////////////////////////////
+void InterestManager::removeClient(std::size_t client)
+{
+    if (client < m_clients.size())
+        m_clients[client] = Client();
+}
+
+
+////////////////////////////////////////////////////////////
+void InterestManager::setArea(std::size_t client, const Vector2f& center, float radius)
+{
+    if ((client >= m_clients.size()) || !m_clients[client].connected)
+        return;
+
+    m_clients[client].center = center;
+    m_clients[client].radius = std::max(radius, 0.f);
+}
+
+
+////////////////////////////////////////////////////////////
+void InterestManager::setBudget(std::size_t client, std::size_t size)
+{
+    if ((client < m_clients.size()) && m_clients[client].connected)
+        m_clients[client].budget = size;
+}
+
+
+////////////////////////////////////////////////////////////
+void InterestManager::update()
+{
+    ++m_tick;
+
+    // Sort the entities by cell; the entities of a row of cells are contiguous
+    m_grid.clear();
+    for (std::size_t i = 0; i < m_entities.size(); ++i)
+    {
+        if (!m_entities[i].exists)
+            continue;
+
+        Int32 x = static_cast<Int32>(std::floor(m_entities[i].position.x / m_cellSize));
+        Int32 y = static_cast<Int32>(std::floor(m_entities[i].position.y / m_cellSize));
+        m_grid.push_back(std::make_pair(getCellKey(x, y), static_cast<Uint16>(i)));
+    }
+    std::sort(m_grid.begin(), m_grid.end());
+
+    for (std::vector<Client>::iterator it = m_clients.begin(); it != m_clients.end(); ++it)
+    {
+        if (it->connected)
+            updateClient(*it);
+    }
+}
+
+
+////////////////////////////////////////////////////////////
+std::size_t InterestManager::writeUpdates(std::size_t client, Packet& packet, const Writer& writer)
+{
+    if ((client >= m_clients.size()) || !m_clients[client].connected)
+        return 0;
+
+    Client& state = m_clients[client];
+
+    // Most important first; a heap only orders the entities that are written
+    m_order.clear();
+    for (std::size_t i = 0; i < state.interests.size(); ++i)
+    {
+        if (state.interests[i].accumulator > 0)
+            m_order.push_back(std::make_pair(state.interests[i].accumulator, i));
+    }
+    std::make_heap(m_order.begin(), m_order.end());
+
+    std::size_t written = 0;
+    std::size_t misses = 0;
+    for (std::vector<std::pair<float, std::size_t> >::iterator end = m_order.end(); (end != m_order.begin()) && (misses < MaxMisses); --end)
+    {
+        std::pop_heap(m_order.begin(), end);
+        Interest& interest = state.interests[(end - 1)->second];
+
+        // Write the update apart, it is only kept if it fits
+        m_update.clear();
+        writer(interest.entity, m_update);
+        if (packet.getDataSize() + m_update.getDataSize() > state.budget)
+        {
+            ++misses;
+            continue;
+        }
+
+        packet.append(m_update.getData(), m_update.getDataSize());
+        interest.accumulator = 0;
+        interest.sentTick    = m_tick;
+        ++written;
+    }
+
+    return written;
+}
+
+
+////////////////////////////////////////////////////////////
+const std::vector<Uint16>& InterestManager::getEnteredEntities(std::size_t client) const
+{
+    return client < m_clients.size() ? m_clients[client].entered : NoEntities;
+}
+
+
+////////////////////////////////////////////////////////////
+const std::vector<Uint16>& InterestManager::getLeftEntities(std::size_t client) const
+{
+    return client < m_clients.size() ? m_clients[client].left : NoEntities;
+}
+
+
+////////////////////////////////////////////////////////////
+std::size_t InterestManager::getEntityCount(std::size_t client) const
+{
+    return client < m_clients.size() ? m_clients[client].interests.size() : 0;
+}
+
+
+////////////////////////////////////////////////////////////
+Uint64 InterestManager::getCellKey(Int32 x, Int32 y)
+{
+    // Flip the sign bits so that negative coordinates sort first
+    return (static_cast<Uint64>(static_cast<Uint32>(y) ^ 0x80000000u) << 32) | (static_cast<Uint32>(x) ^ 0x80000000u);
+}
+
+
+////////////////////////////////////////////////////////////
+void InterestManager::updateClient(Client& client)
+{
+    float enterRadius = client.radius;
+    float leaveRadius = client.radius * m_hysteresis;
+    float enterSquared = enterRadius * enterRadius;
+    float leaveSquared = leaveRadius * leaveRadius;
+
+    // Each client update marks the entities it finds with two stamps of its
+    // own: found, then already in the area; no sorting needed to merge
+    if (m_marks.size() < m_entities.size())
+    {
+        m_marks.resize(m_entities.size(), 0);
+        m_distances.resize(m_entities.size(), 0.f);
+    }
+    if (m_stamp >= 0xFFFFFFF0u)
+    {
+        std::fill(m_marks.begin(), m_marks.end(), 0);
+        m_stamp = 0;
+    }
+    Uint32 found = m_stamp + 1;
+    Uint32 kept  = m_stamp + 2;
+    m_stamp += 2;
+
+    // Gather the entities within the leaving radius, from the cells it overlaps
+    Int32 left   = static_cast<Int32>(std::floor((client.center.x - leaveRadius) / m_cellSize));
+    Int32 right  = static_cast<Int32>(std::floor((client.center.x + leaveRadius) / m_cellSize));
+    Int32 top    = static_cast<Int32>(std::floor((client.center.y - leaveRadius) / m_cellSize));
+    Int32 bottom = static_cast<Int32>(std::floor((client.center.y + leaveRadius) / m_cellSize));
+
+    m_candidates.clear();
+    for (Int32 y = top; y <= bottom; ++y)
+    {
+        Uint64 last = getCellKey(right, y);
+        std::vector<std::pair<Uint64, Uint16> >::const_iterator it = std::lower_bound(m_grid.begin(), m_grid.end(), std::make_pair(getCellKey(left, y), Uint16(0)));
+        for (; (it != m_grid.end()) && (it->first <= last); ++it)
+        {
+            Vector2f offset = m_entities[it->second].position - client.center;
+            float distanceSquared = offset.x * offset.x + offset.y * offset.y;
+            if (distanceSquared <= leaveSquared)
+            {
+                m_marks[it->second] = found;
+                m_distances[it->second] = distanceSquared;
+                m_candidates.push_back(it->second);
+            }
+        }
+    }
+
+    // The entities of the area stay until they are past the leaving radius
+    client.entered.clear();
+    client.left.clear();
+
+    std::size_t count = 0;
+    for (std::size_t i = 0; i < client.interests.size(); ++i)
+    {
+        Interest& interest = client.interests[i];
+        if (m_marks[interest.entity] != found)
+        {
+            client.left.push_back(interest.entity);
+            continue;
+        }
+
+        m_marks[interest.entity] = kept;
+        accumulate(interest, m_distances[interest.entity], leaveRadius);
+        client.interests[count++] = interest;
+    }
+    client.interests.resize(count);
+
+    // The other entities only enter within the entering radius
+    m_interests.clear();
+    for (std::vector<Uint16>::const_iterator it = m_candidates.begin(); it != m_candidates.end(); ++it)
+    {
+        if ((m_marks[*it] != found) || (m_distances[*it] > enterSquared))
+            continue;
+
+        Interest interest;
+        interest.entity      = *it;
+        interest.accumulator = 0;
+        interest.sentTick    = 0;
+        accumulate(interest, m_distances[*it], leaveRadius);
+        m_interests.push_back(interest);
+    }
+
+    // Few entities enter at once, sorting them is cheap
+    if (!m_interests.empty())
+    {
+        std::sort(m_interests.begin(), m_interests.end(), [](const Interest& a, const Interest& b) { return a.entity < b.entity; });
+        for (std::vector<Interest>::const_iterator it = m_interests.begin(); it != m_interests.end(); ++it)
+            client.entered.push_back(it->entity);
+
+        client.interests.insert(client.interests.end(), m_interests.begin(), m_interests.end());
+        std::inplace_merge(client.interests.begin(), client.interests.end() - m_interests.size(), client.interests.end(), [](const Interest& a, const Interest& b) { return a.entity < b.entity; });
+    }
+}
+
+
+////////////////////////////////////////////////////////////
+void InterestManager::accumulate(Interest& interest, float distanceSquared, float leaveRadius) const
+{
+    // Close entities, and the ones that changed, gain priority faster
+    const Entity& entity = m_entities[interest.entity];
+    float distance = (leaveRadius > 0) ? std::sqrt(distanceSquared) / leaveRadius : 0.f;
+    float closeness = 1.f - (1.f - EdgeFactor) * std::min(distance, 1.f);
+    float change = (entity.changeTick > interest.sentTick) ? 1.f : m_idleFactor;
+
+    interest.accumulator += entity.priority * closeness * change;
+}
+
+} // namespace TGE
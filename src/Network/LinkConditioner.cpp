@@ -0,0 +1,217 @@
+/*************************************/
+/** Copyright © 2014 Coldsnap Games **/
+/*************************************/
+
+/*************************************/
+/**             Headers             **/
+/*************************************/
+#include <Tyrant/Network/LinkConditioner.hpp>
+#include <Tyrant/Network/Packet.hpp>
+#include <algorithm>
+
+
+namespace
+{
+    // Longest time a datagram waits for the bandwidth before being dropped, in microseconds
+    const TGE::Int64 MaxQueueDelay = 250000;
+
+    // Shortest extra delay of a reordered datagram, in microseconds
+    const TGE::Int64 MinReorderDelay = 1000;
+}
+
+namespace TGE
+{
+////////////////////////////////////////////////////////////
+bool LinkConditioner::Later::operator ()(const Datagram& left, const Datagram& right) const
+{
+    if (left.time != right.time)
+        return left.time > right.time;
+
+    return left.sequence > right.sequence;
+}
+
+
+////////////////////////////////////////////////////////////
+LinkConditioner::LinkConditioner(UdpSocket& socket, Uint32 seed) :
+m_socket     (socket),
+m_latency    (0),
+m_jitter     (0),
+m_loss       (0),
+m_reordering (0),
+m_bandwidth  (0),
+m_generator  (seed),
+m_clock      (),
+m_linkFree   (0),
+m_lastArrival(0),
+m_sequence   (0),
+m_dropped    (0),
+m_link       (),
+m_buffers    ()
+{
+
+}
+
+
+////////////////////////////////////////////////////////////
+void LinkConditioner::setLatency(Time latency)
+{
+    m_latency = std::max<Int64>(latency.asMicroseconds(), 0);
+}
+
+
+////////////////////////////////////////////////////////////
+void LinkConditioner::setJitter(Time jitter)
+{
+    m_jitter = std::max<Int64>(jitter.asMicroseconds(), 0);
+}
+
+
+////////////////////////////////////////////////////////////
+void LinkConditioner::setLoss(float probability)
+{
+    m_loss = probability;
+}
+
+
+////////////////////////////////////////////////////////////
+void LinkConditioner::setReordering(float probability)
+{
+    m_reordering = probability;
+}
+
+
+////////////////////////////////////////////////////////////
+void LinkConditioner::setBandwidth(Uint32 bytesPerSecond)
+{
+    m_bandwidth = bytesPerSecond;
+}
+
+
+////////////////////////////////////////////////////////////
+void LinkConditioner::setSeed(Uint32 seed)
+{
+    m_generator.seed(seed);
+}
+
+
+////////////////////////////////////////////////////////////
+Socket::Status LinkConditioner::send(const void* data, std::size_t size, const IpAddress& remoteAddress, unsigned short remotePort)
+{
+    if (size > UdpSocket::MaxDatagramSize)
+        return Socket::Error;
+
+    // Always draw the same numbers for a datagram, so that the
+    // decisions only depend on the seed and the datagrams sent
+    float loss = random();
+    float jitter = random();
+    float reorder = random();
+
+    if (loss < m_loss)
+    {
+        m_dropped++;
+        return Socket::Done;
+    }
+
+    Int64 now = m_clock.getElapsedTime().asMicroseconds();
+    Int64 time = now;
+
+    // The link sends one datagram at a time, the others queue up
+    if (m_bandwidth > 0)
+    {
+        Int64 start = std::max(now, m_linkFree);
+        if (start - now > MaxQueueDelay)
+        {
+            m_dropped++;
+            return Socket::Done;
+        }
+
+        m_linkFree = start + static_cast<Int64>(size) * 1000000 / m_bandwidth;
+        time = m_linkFree;
+    }
+
+    time += m_latency + static_cast<Int64>((jitter * 2 - 1) * m_jitter);
+    time = std::max(time, now);
+
+    if (reorder < m_reordering)
+    {
+        time += std::max(m_latency, MinReorderDelay);
+    }
+    else
+    {
+        // The jitter doesn't reorder the datagrams
+        time = std::max(time, m_lastArrival);
+        m_lastArrival = time;
+    }
+
+    Datagram datagram;
+    datagram.time     = time;
+    datagram.sequence = m_sequence++;
+    datagram.address  = remoteAddress;
+    datagram.port     = remotePort;
+    if (!m_buffers.empty())
+    {
+        datagram.data.swap(m_buffers.back());
+        m_buffers.pop_back();
+    }
+    datagram.data.assign(static_cast<const char*>(data), static_cast<const char*>(data) + size);
+
+    m_link.push_back(std::move(datagram));
+    std::push_heap(m_link.begin(), m_link.end(), Later());
+
+    return Socket::Done;
+}
+
+
+////////////////////////////////////////////////////////////
+Socket::Status LinkConditioner::send(Packet& packet, const IpAddress& remoteAddress, unsigned short remotePort)
+{
+    std::size_t size = 0;
+    const void* data = packet.onSend(size);
+
+    return send(data, size, remoteAddress, remotePort);
+}
+
+
+////////////////////////////////////////////////////////////
+void LinkConditioner::update()
+{
+    Int64 now = m_clock.getElapsedTime().asMicroseconds();
+
+    while (!m_link.empty() && (m_link.front().time <= now))
+    {
+        std::pop_heap(m_link.begin(), m_link.end(), Later());
+
+        // A datagram the socket can't take is lost, like on a real network
+        Datagram& datagram = m_link.back();
+        const char* data = datagram.data.empty() ? NULL : &datagram.data[0];
+        if (m_socket.send(data, datagram.data.size(), datagram.address, datagram.port) != Socket::Done)
+            m_dropped++;
+
+        m_buffers.push_back(std::vector<char>());
+        m_buffers.back().swap(datagram.data);
+        m_link.pop_back();
+    }
+}
+
+
+////////////////////////////////////////////////////////////
+std::size_t LinkConditioner::getPendingCount() const
+{
+    return m_link.size();
+}
+
+
+////////////////////////////////////////////////////////////
+Uint64 LinkConditioner::getDroppedCount() const
+{
+    return m_dropped;
+}
+
+
+////////////////////////////////////////////////////////////
+float LinkConditioner::random()
+{
+    return std::uniform_real_distribution<float>(0.f, 1.f)(m_generator);
+}
+
+} // namespace TGE
@@ -0,0 +1,788 @@
+/*************************************/
+/** Copyright © 2014 Coldsnap Games **/
+/*************************************/
+
+/*************************************/
+/**             Headers             **/
+/*************************************/
+#include <Tyrant/Network/MetricsServer.hpp>
+#include <Tyrant/System/Lock.hpp>
+#include <Tyrant/System/Log.hpp>
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <map>
+
+
+namespace
+{
+    // Maximum time the server thread sleeps while nobody is waiting for the metrics
+    const TGE::Time idleInterval = TGE::milliseconds(100);
+
+    // Maximum time the server thread sleeps while waiting for a collection
+    const TGE::Time collectInterval = TGE::milliseconds(1);
+
+    // Maximum time to wait for update() before answering with the previous metrics
+    const TGE::Int64 collectTimeout = 1000000;
+
+    // Time after which an idle connection is closed
+    const TGE::Int64 idleTimeout = 30000000;
+
+    // Maximum number of connections open at once
+    const std::size_t maxClients = 16;
+
+    // Maximum size of the header of a request
+    const std::size_t maxRequestSize = 8192;
+
+    // Append a number in a format both Prometheus and JSON understand
+    void appendNumber(std::string& out, double value)
+    {
+        char buffer[32];
+        std::snprintf(buffer, sizeof(buffer), "%.15g", value);
+        out += buffer;
+    }
+
+    // Append an unsigned integer
+    void appendNumber(std::string& out, TGE::Uint64 value)
+    {
+        char buffer[32];
+        std::snprintf(buffer, sizeof(buffer), "%llu", static_cast<unsigned long long>(value));
+        out += buffer;
+    }
+
+    // Append a string between quotes, escaped for a label value or a JSON string
+    void appendQuoted(std::string& out, const std::string& value)
+    {
+        out += '"';
+        for (std::string::const_iterator it = value.begin(); it != value.end(); ++it)
+        {
+            if ((*it == '"') || (*it == '\\'))
+            {
+                out += '\\';
+                out += *it;
+            }
+            else if (*it == '\n')
+            {
+                out += "\\n";
+            }
+            else if (static_cast<unsigned char>(*it) >= 0x20)
+            {
+                out += *it;
+            }
+        }
+        out += '"';
+    }
+
+    // Append a value to a JSON document, which can't hold infinities
+    void appendJsonNumber(std::string& out, double value)
+    {
+        if ((value != value) || (value - value != 0))
+            out += "null";
+        else
+            appendNumber(out, value);
+    }
+
+    // Append a value to a Prometheus document
+    void appendTextNumber(std::string& out, double value)
+    {
+        if (value != value)
+            out += "NaN";
+        else if (value - value != 0)
+            out += (value > 0) ? "+Inf" : "-Inf";
+        else
+            appendNumber(out, value);
+    }
+
+    // Compare the beginning of a string with a lowercase prefix, ignoring case
+    bool startsWith(const std::string& string, std::size_t position, const char* prefix)
+    {
+        for (; *prefix; ++prefix, ++position)
+        {
+            if ((position >= string.size()) || (std::tolower(static_cast<unsigned char>(string[position])) != *prefix))
+                return false;
+        }
+
+        return true;
+    }
+}
+
+namespace TGE
+{
+////////////////////////////////////////////////////////////
+MetricsServer::Histogram::Histogram(const std::vector<double>& bounds) :
+m_bounds(bounds),
+m_counts(bounds.size() + 1, 0),
+m_count (0),
+m_sum   (0)
+{
+
+}
+
+
+////////////////////////////////////////////////////////////
+void MetricsServer::Histogram::observe(double value)
+{
+    std::size_t bucket = std::lower_bound(m_bounds.begin(), m_bounds.end(), value) - m_bounds.begin();
+    m_counts[bucket]++;
+    m_count++;
+    m_sum += value;
+}
+
+
+////////////////////////////////////////////////////////////
+void MetricsServer::Histogram::clear()
+{
+    std::fill(m_counts.begin(), m_counts.end(), 0);
+    m_count = 0;
+    m_sum = 0;
+}
+
+
+////////////////////////////////////////////////////////////
+const std::vector<double>& MetricsServer::Histogram::getBounds() const
+{
+    return m_bounds;
+}
+
+
+////////////////////////////////////////////////////////////
+const std::vector<Uint64>& MetricsServer::Histogram::getCounts() const
+{
+    return m_counts;
+}
+
+
+////////////////////////////////////////////////////////////
+Uint64 MetricsServer::Histogram::getCount() const
+{
+    return m_count;
+}
+
+
+////////////////////////////////////////////////////////////
+double MetricsServer::Histogram::getSum() const
+{
+    return m_sum;
+}
+
+
+////////////////////////////////////////////////////////////
+MetricsServer::MetricsServer() :
+m_thread       (&MetricsServer::run, this),
+m_running      (false),
+m_requested    (false),
+m_published    (false),
+m_collectors   (),
+m_samples      (),
+m_sampleCount  (0),
+m_snapshot     (),
+m_snapshotCount(0),
+m_hasSnapshot  (false),
+m_mutex        (),
+m_listener     (),
+m_selector     (),
+m_clients      (),
+m_clock        ()
+{
+
+}
+
+
+////////////////////////////////////////////////////////////
+MetricsServer::~MetricsServer()
+{
+    stop();
+    m_listener.close();
+}
+
+
+////////////////////////////////////////////////////////////
+bool MetricsServer::listen(unsigned short port)
+{
+    if (m_running)
+    {
+        Log() << "Failed to listen to port " << port << " (the metrics server is already running)" << std::endl;
+        return false;
+    }
+
+    m_listener.setBlocking(false);
+    if (m_listener.listen(port) != Socket::Done)
+        return false;
+
+    m_selector.add(m_listener);
+
+    return true;
+}
+
+
+////////////////////////////////////////////////////////////
+void MetricsServer::launch()
+{
+    if (m_running)
+        return;
+
+    m_running = true;
+    m_thread.launch();
+}
+
+
+////////////////////////////////////////////////////////////
+void MetricsServer::stop()
+{
+    if (!m_running)
+        return;
+
+    m_running = false;
+    m_thread.wait();
+
+    while (!m_clients.empty())
+        close(m_clients.begin());
+}
+
+
+////////////////////////////////////////////////////////////
+void MetricsServer::addCollector(const Collector& collector)
+{
+    m_collectors.push_back(collector);
+}
+
+
+////////////////////////////////////////////////////////////
+void MetricsServer::addPool(const std::string& name, const MemoryPool& pool)
+{
+    const MemoryPool* watched = &pool;
+    addCollector([name, watched](MetricsServer& server)
+    {
+        server.write(Gauge, "tge_pool_allocated_blocks", "pool", name, static_cast<double>(watched->getAllocatedCount()));
+        server.write(Gauge, "tge_pool_capacity_blocks", "pool", name, static_cast<double>(watched->getCapacity()));
+        server.write(Gauge, "tge_pool_block_size_bytes", "pool", name, static_cast<double>(watched->getBlockSize()));
+    });
+}
+
+
+////////////////////////////////////////////////////////////
+void MetricsServer::addArena(const std::string& name, const MemoryArena& arena)
+{
+    const MemoryArena* watched = &arena;
+    addCollector([name, watched](MetricsServer& server)
+    {
+        server.write(Gauge, "tge_arena_used_bytes", "arena", name, static_cast<double>(watched->getUsedSize()));
+        server.write(Gauge, "tge_arena_capacity_bytes", "arena", name, static_cast<double>(watched->getCapacity()));
+    });
+}
+
+
+////////////////////////////////////////////////////////////
+void MetricsServer::addNetworkService(const NetworkService& service)
+{
+    const NetworkService* watched = &service;
+    addCollector([watched](MetricsServer& server)
+    {
+        typedef std::map<NetworkService::ConnectionId, NetworkService::Statistics> StatisticsMap;
+        const StatisticsMap& statistics = watched->getStatistics();
+
+        server.write(Gauge, "tge_network_connections", static_cast<double>(statistics.size()));
+
+        char id[16];
+        for (StatisticsMap::const_iterator it = statistics.begin(); it != statistics.end(); ++it)
+        {
+            std::snprintf(id, sizeof(id), "%u", static_cast<unsigned int>(it->first));
+            server.write(Counter, "tge_network_sent_bytes_total", "connection", id, static_cast<double>(it->second.bytesSent));
+            server.write(Counter, "tge_network_received_bytes_total", "connection", id, static_cast<double>(it->second.bytesReceived));
+            server.write(Counter, "tge_network_sent_packets_total", "connection", id, static_cast<double>(it->second.packetsSent));
+            server.write(Counter, "tge_network_received_packets_total", "connection", id, static_cast<double>(it->second.packetsReceived));
+        }
+    });
+}
+
+
+////////////////////////////////////////////////////////////
+void MetricsServer::update()
+{
+    // Nobody is waiting for the metrics: nothing to do
+    if (!m_requested.load(std::memory_order_acquire))
+        return;
+
+    m_sampleCount = 0;
+    for (std::vector<Collector>::iterator it = m_collectors.begin(); it != m_collectors.end(); ++it)
+        (*it)(*this);
+
+    {
+        Lock lock(m_mutex);
+        m_snapshot.swap(m_samples);
+        m_snapshotCount = m_sampleCount;
+        m_hasSnapshot = true;
+    }
+
+    m_requested.store(false, std::memory_order_relaxed);
+    m_published.store(true, std::memory_order_release);
+}
+
+
+////////////////////////////////////////////////////////////
+void MetricsServer::write(Type type, const std::string& name, double value)
+{
+    Sample& sample = nextSample();
+    sample.type      = type;
+    sample.histogram = false;
+    sample.name      = name;
+    sample.label.clear();
+    sample.labelValue.clear();
+    sample.value     = value;
+}
+
+
+////////////////////////////////////////////////////////////
+void MetricsServer::write(Type type, const std::string& name, const std::string& label, const std::string& labelValue, double value)
+{
+    Sample& sample = nextSample();
+    sample.type       = type;
+    sample.histogram  = false;
+    sample.name       = name;
+    sample.label      = label;
+    sample.labelValue = labelValue;
+    sample.value      = value;
+}
+
+
+////////////////////////////////////////////////////////////
+void MetricsServer::write(const std::string& name, const Histogram& histogram)
+{
+    Sample& sample = nextSample();
+    sample.type      = Counter;
+    sample.histogram = true;
+    sample.name      = name;
+    sample.label.clear();
+    sample.labelValue.clear();
+    sample.value     = histogram.getSum();
+    sample.count     = histogram.getCount();
+    sample.bounds    = histogram.getBounds();
+    sample.counts    = histogram.getCounts();
+}
+
+
+////////////////////////////////////////////////////////////
+void MetricsServer::run()
+{
+    while (m_running)
+    {
+        bool waiting = false;
+        for (std::list<Client>::const_iterator it = m_clients.begin(); it != m_clients.end(); ++it)
+            waiting = waiting || (it->waiting != None);
+
+        if (m_selector.wait(waiting ? collectInterval : idleInterval))
+        {
+            for (std::size_t i = 0; i < m_selector.getReadyCount(); ++i)
+            {
+                Socket& socket = m_selector.getReadySocket(i);
+                unsigned int readiness = m_selector.getReadiness(i);
+
+                if (&socket == &m_listener)
+                {
+                    acceptClients();
+                    continue;
+                }
+
+                std::list<Client>::iterator client = m_clients.begin();
+                while ((client != m_clients.end()) && (&client->socket != &socket))
+                    ++client;
+                if (client == m_clients.end())
+                    continue;
+
+                if ((readiness & SocketSelector::Read) && !receiveRequests(*client))
+                {
+                    close(client);
+                    continue;
+                }
+
+                if ((readiness & SocketSelector::Write) && !sendResponse(*client))
+                    close(client);
+            }
+        }
+
+        answerWaitingClients(m_published.exchange(false, std::memory_order_acquire));
+
+        // Drop the connections left open by the monitoring tools
+        Int64 now = m_clock.getElapsedTime().asMicroseconds();
+        for (std::list<Client>::iterator it = m_clients.begin(); it != m_clients.end();)
+        {
+            if ((it->waiting == None) && (now - it->lastTime > idleTimeout))
+                it = close(it);
+            else
+                ++it;
+        }
+    }
+}
+
+
+////////////////////////////////////////////////////////////
+void MetricsServer::acceptClients()
+{
+    for (;;)
+    {
+        m_clients.emplace_back();
+        Client& client = m_clients.back();
+        if (m_listener.accept(client.socket) != Socket::Done)
+        {
+            m_clients.pop_back();
+            return;
+        }
+
+        if (m_clients.size() > maxClients)
+        {
+            client.socket.disconnect();
+            m_clients.pop_back();
+            continue;
+        }
+
+        client.sent      = 0;
+        client.waiting   = None;
+        client.keepAlive = true;
+        client.closing   = false;
+        client.lastTime  = m_clock.getElapsedTime().asMicroseconds();
+        client.socket.setBlocking(false);
+
+        m_selector.add(client.socket, SocketSelector::Read);
+    }
+}
+
+
+////////////////////////////////////////////////////////////
+bool MetricsServer::receiveRequests(Client& client)
+{
+    char buffer[1024];
+    for (;;)
+    {
+        std::size_t received = 0;
+        Socket::Status status = client.socket.receive(buffer, sizeof(buffer), received);
+        if (status == Socket::NotReady)
+            break;
+        if (status != Socket::Done)
+            return false;
+
+        client.request.append(buffer, received);
+        client.lastTime = m_clock.getElapsedTime().asMicroseconds();
+    }
+
+    // Requests are answered in order, a pipelined request waits for the previous response
+    while (client.response.empty() && (client.waiting == None) && !client.closing && handleRequest(client)) {}
+
+    if (client.response.empty() && (client.waiting == None) && (client.request.size() > maxRequestSize))
+    {
+        client.keepAlive = false;
+        respond(client, "431 Request Header Fields Too Large", "text/plain", "Request too large\n");
+    }
+
+    return client.response.empty() || sendResponse(client);
+}
+
+
+////////////////////////////////////////////////////////////
+bool MetricsServer::handleRequest(Client& client)
+{
+    std::size_t end = client.request.find("\r\n\r\n");
+    if (end == std::string::npos)
+        return false;
+
+    std::string header = client.request.substr(0, end + 2);
+    client.request.erase(0, end + 4);
+
+    // Request line: method, target and version
+    std::size_t lineEnd = header.find("\r\n");
+    std::string line = header.substr(0, lineEnd);
+    std::size_t first = line.find(' ');
+    std::size_t last = line.rfind(' ');
+    std::string method = line.substr(0, first);
+    std::string target = (first < last) ? line.substr(first + 1, last - first - 1) : std::string();
+    std::string version = (first < last) ? line.substr(last + 1) : std::string();
+
+    std::size_t query = target.find('?');
+    if (query != std::string::npos)
+        target.erase(query);
+
+    // HTTP/1.1 connections stay open unless asked otherwise, HTTP/1.0 ones close
+    client.keepAlive = (version == "HTTP/1.1");
+    for (std::size_t position = lineEnd + 2; position < header.size(); position = header.find("\r\n", position) + 2)
+    {
+        if (startsWith(header, position, "connection:"))
+        {
+            std::size_t valueEnd = header.find("\r\n", position);
+            std::string value = header.substr(position + 11, valueEnd - position - 11);
+            std::transform(value.begin(), value.end(), value.begin(), ::tolower);
+            if (value.find("close") != std::string::npos)
+                client.keepAlive = false;
+            else if (value.find("keep-alive") != std::string::npos)
+                client.keepAlive = true;
+        }
+    }
+
+    if (version.compare(0, 5, "HTTP/") != 0)
+    {
+        client.keepAlive = false;
+        respond(client, "400 Bad Request", "text/plain", "Bad request\n");
+    }
+    else if (method != "GET")
+    {
+        respond(client, "405 Method Not Allowed", "text/plain", "Only GET is supported\n");
+    }
+    else if (target == "/metrics")
+    {
+        client.waiting = Text;
+    }
+    else if (target == "/metrics.json")
+    {
+        client.waiting = Json;
+    }
+    else
+    {
+        respond(client, "404 Not Found", "text/plain", "The metrics are at /metrics and /metrics.json\n");
+    }
+
+    // Ask the game thread for the metrics
+    if (client.waiting != None)
+    {
+        client.lastTime = m_clock.getElapsedTime().asMicroseconds();
+        m_requested.store(true, std::memory_order_release);
+    }
+
+    return true;
+}
+
+
+////////////////////////////////////////////////////////////
+bool MetricsServer::sendResponse(Client& client)
+{
+    while (client.sent < client.response.size())
+    {
+        std::size_t sent = 0;
+        Socket::Status status = client.socket.send(client.response.data() + client.sent, client.response.size() - client.sent, sent);
+        client.sent += sent;
+
+        if ((status == Socket::NotReady) || (status == Socket::Partial))
+        {
+            // Finish when the socket can take more
+            m_selector.add(client.socket, SocketSelector::Read | SocketSelector::Write);
+            return true;
+        }
+        if (status != Socket::Done)
+            return false;
+    }
+
+    client.response.clear();
+    client.sent = 0;
+    client.lastTime = m_clock.getElapsedTime().asMicroseconds();
+    m_selector.add(client.socket, SocketSelector::Read);
+
+    if (client.closing)
+        return false;
+
+    // Handle the requests that arrived in the meantime
+    if (handleRequest(client) && !client.response.empty())
+        return sendResponse(client);
+
+    return true;
+}
+
+
+////////////////////////////////////////////////////////////
+void MetricsServer::answerWaitingClients(bool published)
+{
+    Int64 now = m_clock.getElapsedTime().asMicroseconds();
+    std::string bodies[3];
+
+    for (std::list<Client>::iterator it = m_clients.begin(); it != m_clients.end();)
+    {
+        Format format = it->waiting;
+        if ((format == None) || (!published && (now - it->lastTime < collectTimeout)))
+        {
+            ++it;
+            continue;
+        }
+
+        it->waiting = None;
+
+        // Fresh metrics, or the previous ones if the game thread doesn't answer
+        Lock lock(m_mutex);
+        if (!m_hasSnapshot)
+        {
+            respond(*it, "503 Service Unavailable", "text/plain", "The metrics were never collected, is update() called?\n");
+        }
+        else
+        {
+            if (bodies[format].empty())
+                formatMetrics(format, bodies[format]);
+
+            if (format == Json)
+                respond(*it, "200 OK", "application/json", bodies[format]);
+            else
+                respond(*it, "200 OK", "text/plain; version=0.0.4; charset=utf-8", bodies[format]);
+        }
+
+        if (sendResponse(*it))
+            ++it;
+        else
+            it = close(it);
+    }
+}
+
+
+////////////////////////////////////////////////////////////
+void MetricsServer::respond(Client& client, const char* status, const char* contentType, const std::string& body)
+{
+    client.response  = "HTTP/1.1 ";
+    client.response += status;
+    client.response += "\r\nContent-Type: ";
+    client.response += contentType;
+    client.response += "\r\nContent-Length: ";
+    appendNumber(client.response, static_cast<Uint64>(body.size()));
+    client.response += client.keepAlive ? "\r\nConnection: keep-alive\r\n\r\n" : "\r\nConnection: close\r\n\r\n";
+    client.response += body;
+    client.sent    = 0;
+    client.closing = !client.keepAlive;
+}
+
+
+////////////////////////////////////////////////////////////
+void MetricsServer::formatMetrics(Format format, std::string& body) const
+{
+    // The values of a metric must be grouped, whatever the order they were written in
+    std::map<std::string, std::size_t> firstIndex;
+    std::vector<std::pair<std::size_t, std::size_t> > order;
+    order.reserve(m_snapshotCount);
+    for (std::size_t i = 0; i < m_snapshotCount; ++i)
+    {
+        std::size_t first = firstIndex.insert(std::make_pair(m_snapshot[i].name, i)).first->second;
+        order.push_back(std::make_pair(first, i));
+    }
+    std::sort(order.begin(), order.end());
+
+    if (format == Json)
+        body += "{\"metrics\":[";
+
+    for (std::size_t i = 0; i < order.size(); ++i)
+    {
+        const Sample& sample = m_snapshot[order[i].second];
+        const char* type = sample.histogram ? "histogram" : (sample.type == Counter ? "counter" : "gauge");
+
+        if (format == Json)
+        {
+            body += (i > 0) ? ",\n{\"name\":" : "\n{\"name\":";
+            appendQuoted(body, sample.name);
+            body += ",\"type\":\"";
+            body += type;
+            body += '"';
+
+            if (!sample.label.empty())
+            {
+                body += ",\"labels\":{";
+                appendQuoted(body, sample.label);
+                body += ':';
+                appendQuoted(body, sample.labelValue);
+                body += '}';
+            }
+
+            if (sample.histogram)
+            {
+                body += ",\"count\":";
+                appendNumber(body, sample.count);
+                body += ",\"sum\":";
+                appendJsonNumber(body, sample.value);
+                body += ",\"buckets\":[";
+
+                Uint64 cumulated = 0;
+                for (std::size_t j = 0; j < sample.bounds.size(); ++j)
+                {
+                    cumulated += sample.counts[j];
+                    body += (j > 0) ? ",{\"le\":" : "{\"le\":";
+                    appendJsonNumber(body, sample.bounds[j]);
+                    body += ",\"count\":";
+                    appendNumber(body, cumulated);
+                    body += '}';
+                }
+                body += "]}";
+            }
+            else
+            {
+                body += ",\"value\":";
+                appendJsonNumber(body, sample.value);
+                body += '}';
+            }
+        }
+        else
+        {
+            if (order[i].first == order[i].second)
+            {
+                body += "# TYPE ";
+                body += sample.name;
+                body += ' ';
+                body += type;
+                body += '\n';
+            }
+
+            if (sample.histogram)
+            {
+                Uint64 cumulated = 0;
+                for (std::size_t j = 0; j <= sample.bounds.size(); ++j)
+                {
+                    cumulated += sample.counts[j];
+                    body += sample.name;
+                    body += "_bucket{le=\"";
+                    appendTextNumber(body, (j < sample.bounds.size()) ? sample.bounds[j] : HUGE_VAL);
+                    body += "\"} ";
+                    appendNumber(body, cumulated);
+                    body += '\n';
+                }
+
+                body += sample.name;
+                body += "_sum ";
+                appendTextNumber(body, sample.value);
+                body += '\n';
+                body += sample.name;
+                body += "_count ";
+                appendNumber(body, sample.count);
+                body += '\n';
+            }
+            else
+            {
+                body += sample.name;
+                if (!sample.label.empty())
+                {
+                    body += '{';
+                    body += sample.label;
+                    body += '=';
+                    appendQuoted(body, sample.labelValue);
+                    body += '}';
+                }
+                body += ' ';
+                appendTextNumber(body, sample.value);
+                body += '\n';
+            }
+        }
+    }
+
+    if (format == Json)
+        body += "\n]}\n";
+}
+
+
+////////////////////////////////////////////////////////////
+MetricsServer::Sample& MetricsServer::nextSample()
+{
+    if (m_sampleCount == m_samples.size())
+        m_samples.push_back(Sample());
+
+    return m_samples[m_sampleCount++];
+}
+
+
+////////////////////////////////////////////////////////////
+std::list<MetricsServer::Client>::iterator MetricsServer::close(std::list<Client>::iterator client)
+{
+    m_selector.remove(client->socket);
+    client->socket.disconnect();
+
+    return m_clients.erase(client);
+}
+
+} // namespace TGE
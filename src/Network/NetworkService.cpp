@@ -0,0 +1,593 @@
+/*************************************/
+/** Copyright © 2014 Coldsnap Games **/
+/*************************************/
+
+/*************************************/
+/**             Headers             **/
+/*************************************/
+#include <Tyrant/Network/NetworkService.hpp>
+#include <Tyrant/System/Lock.hpp>
+#include <Tyrant/System/Log.hpp>
+#include <Tyrant/System/Sleep.hpp>
+#include <algorithm>
+
+
+namespace
+{
+    // Time the network thread waits for the game thread to make room in the event queue
+    const TGE::Time pollInterval = TGE::milliseconds(1);
+
+    // Default size of the send queues above which connections are congested
+    const std::size_t defaultSendLimit = 1024 * 1024;
+
+    // Maximum number of packets sent in a single batch; the queue size
+    // only decreases when a batch is complete, it must not be too long
+    const std::size_t maxBatchCount = 64;
+}
+
+namespace TGE
+{
+////////////////////////////////////////////////////////////
+NetworkService::NetworkService(std::size_t queueCapacity) :
+m_thread     (&NetworkService::run, this),
+m_running    (false),
+m_waiting    (false),
+m_commands   (queueCapacity),
+m_events     (queueCapacity),
+m_nextId     (1),
+m_sendLimit  (defaultSendLimit),
+m_command    (),
+m_listener   (),
+m_selector   (),
+m_clock      (),
+m_connections(),
+m_sockets    (),
+m_backlog    (),
+m_received   (),
+m_event      (),
+m_statistics (),
+m_mutex      ()
+{
+
+}
+
+
+////////////////////////////////////////////////////////////
+NetworkService::~NetworkService()
+{
+    stop();
+    m_listener.close();
+}
+
+
+////////////////////////////////////////////////////////////
+bool NetworkService::listen(unsigned short port)
+{
+    if (m_running)
+    {
+        Log() << "Failed to listen to port " << port << " (the network service is already running)" << std::endl;
+        return false;
+    }
+
+    m_listener.setBlocking(false);
+    if (m_listener.listen(port) != Socket::Done)
+        return false;
+
+    m_selector.add(m_listener);
+
+    return true;
+}
+
+
+////////////////////////////////////////////////////////////
+void NetworkService::setSendLimit(std::size_t size)
+{
+    m_sendLimit = size;
+}
+
+
+////////////////////////////////////////////////////////////
+void NetworkService::launch()
+{
+    if (m_running)
+        return;
+
+    m_running = true;
+    m_thread.launch();
+}
+
+
+////////////////////////////////////////////////////////////
+void NetworkService::stop()
+{
+    if (!m_running)
+        return;
+
+    m_running = false;
+    m_selector.interrupt();
+    m_thread.wait();
+
+    // Close the connections without reporting it
+    {
+        Lock lock(m_mutex);
+        for (std::map<ConnectionId, Connection*>::iterator it = m_connections.begin(); it != m_connections.end(); ++it)
+        {
+            m_selector.remove(it->second->socket);
+            delete it->second;
+        }
+        m_connections.clear();
+    }
+    m_sockets.clear();
+    m_backlog.clear();
+
+    Command command;
+    while (m_commands.pop(command)) {}
+    while (m_events.pop(m_event)) {}
+}
+
+
+////////////////////////////////////////////////////////////
+NetworkService::ConnectionId NetworkService::connect(const IpAddress& address, unsigned short port, Time timeout)
+{
+    ConnectionId id = m_nextId++;
+
+    m_command.type       = Command::Connect;
+    m_command.connection = id;
+    m_command.address    = address;
+    m_command.port       = port;
+    m_command.timeout    = timeout;
+    m_command.packet.clear();
+
+    if (!m_commands.push(m_command))
+        return 0;
+
+    wakeUp();
+
+    return id;
+}
+
+
+////////////////////////////////////////////////////////////
+bool NetworkService::send(ConnectionId connection, const Packet& packet)
+{
+    m_command.type       = Command::Send;
+    m_command.connection = connection;
+    m_command.packet.clear();
+    m_command.packet.append(packet.getData(), packet.getDataSize());
+
+    if (!m_commands.push(m_command))
+        return false;
+
+    wakeUp();
+
+    return true;
+}
+
+
+////////////////////////////////////////////////////////////
+bool NetworkService::disconnect(ConnectionId connection)
+{
+    m_command.type       = Command::Disconnect;
+    m_command.connection = connection;
+    m_command.packet.clear();
+
+    if (!m_commands.push(m_command))
+        return false;
+
+    wakeUp();
+
+    return true;
+}
+
+
+////////////////////////////////////////////////////////////
+bool NetworkService::pollEvent(Event& event)
+{
+    return m_events.pop(event);
+}
+
+
+////////////////////////////////////////////////////////////
+const std::map<NetworkService::ConnectionId, NetworkService::Statistics>& NetworkService::getStatistics() const
+{
+    // The connections are only added and destroyed under the lock, their counters are read as they are
+    Lock lock(m_mutex);
+
+    m_statistics.clear();
+    for (std::map<ConnectionId, Connection*>::const_iterator it = m_connections.begin(); it != m_connections.end(); ++it)
+    {
+        Statistics& statistics = m_statistics[it->first];
+        statistics.bytesSent       = it->second->bytesSent.load(std::memory_order_relaxed);
+        statistics.bytesReceived   = it->second->bytesReceived.load(std::memory_order_relaxed);
+        statistics.packetsSent     = it->second->packetsSent.load(std::memory_order_relaxed);
+        statistics.packetsReceived = it->second->packetsReceived.load(std::memory_order_relaxed);
+    }
+
+    return m_statistics;
+}
+
+
+////////////////////////////////////////////////////////////
+void NetworkService::run()
+{
+    Command command;
+    std::vector<ConnectionId> pending;
+
+    while (m_running)
+    {
+        // Execute the commands; packets are only sent once all the
+        // commands are read, so that they are sent in batches
+        pending.clear();
+        while (m_commands.pop(command))
+        {
+            execute(command);
+            if (command.type == Command::Send)
+                pending.push_back(command.connection);
+        }
+
+        for (std::vector<ConnectionId>::const_iterator it = pending.begin(); it != pending.end(); ++it)
+        {
+            std::map<ConnectionId, Connection*>::iterator connection = m_connections.find(*it);
+            if ((connection != m_connections.end()) && connection->second->connected && !connection->second->watchWrite)
+            {
+                if (sendPackets(*connection->second))
+                    update(connection->second);
+                else
+                    close(connection->second);
+            }
+        }
+
+        // Retry the events that didn't fit in the queue
+        std::size_t pushed = 0;
+        while ((pushed < m_backlog.size()) && m_events.push(m_backlog[pushed]))
+            ++pushed;
+        m_backlog.erase(m_backlog.begin(), m_backlog.begin() + pushed);
+
+        // Give up the connections that take too long to establish
+        Int64 now = m_clock.getElapsedTime().asMicroseconds();
+        Int64 nextDeadline = -1;
+        std::vector<Connection*> expired;
+        for (std::map<ConnectionId, Connection*>::iterator it = m_connections.begin(); it != m_connections.end(); ++it)
+        {
+            if (it->second->connected)
+                continue;
+
+            if (now > it->second->deadline)
+                expired.push_back(it->second);
+            else if ((nextDeadline < 0) || (it->second->deadline < nextDeadline))
+                nextDeadline = it->second->deadline;
+        }
+        for (std::vector<Connection*>::iterator it = expired.begin(); it != expired.end(); ++it)
+            close(*it);
+
+        // Sleep until a socket is ready, a command arrives or a connection
+        // expires. While the game thread doesn't keep up, leave the received
+        // data in the sockets (receivePackets does nothing), but keep
+        // connecting and sending
+        Time timeout = Time::Zero;
+        if (!m_backlog.empty())
+        {
+            sleep(pollInterval);
+            timeout = microseconds(1);
+        }
+        else if (nextDeadline >= 0)
+        {
+            timeout = microseconds(std::max<Int64>(nextDeadline - now, 1));
+        }
+
+        // The game thread interrupts the wait when it pushes a command; one
+        // pushed before m_waiting is set is found here instead
+        m_waiting = true;
+        if (!m_commands.isEmpty() || !m_running)
+            wakeUp();
+
+        bool ready = m_selector.wait(timeout);
+        m_waiting = false;
+        if (!ready)
+            continue;
+
+        for (std::size_t i = 0; i < m_selector.getReadyCount(); ++i)
+        {
+            Socket& socket = m_selector.getReadySocket(i);
+            unsigned int readiness = m_selector.getReadiness(i);
+
+            if (&socket == &m_listener)
+            {
+                acceptConnections();
+                continue;
+            }
+
+            // The connection may have been closed by a previous event
+            std::map<const Socket*, Connection*>::iterator found = m_sockets.find(&socket);
+            if (found == m_sockets.end())
+                continue;
+
+            Connection* connection = found->second;
+            if (!connection->connected)
+            {
+                // The connection attempt is over, successful or not
+                if (connection->socket.getRemoteAddress() == IpAddress::None)
+                {
+                    close(connection);
+                    continue;
+                }
+
+                connection->connected = true;
+                m_event.type       = Event::Connected;
+                m_event.connection = connection->id;
+                m_event.packet.clear();
+                pushEvent(m_event);
+            }
+
+            if ((readiness & SocketSelector::Read) && !receivePackets(*connection))
+            {
+                close(connection);
+                continue;
+            }
+
+            if (((readiness & SocketSelector::Write) || (connection->first < connection->queue.size())) && !sendPackets(*connection))
+            {
+                close(connection);
+                continue;
+            }
+
+            update(connection);
+        }
+    }
+}
+
+
+////////////////////////////////////////////////////////////
+void NetworkService::wakeUp()
+{
+    // Only the first command pushed while the network thread waits makes a system call
+    if (m_waiting.exchange(false))
+        m_selector.interrupt();
+}
+
+
+////////////////////////////////////////////////////////////
+void NetworkService::execute(Command& command)
+{
+    std::map<ConnectionId, Connection*>::iterator found = m_connections.find(command.connection);
+    Connection* connection = (found != m_connections.end()) ? found->second : NULL;
+
+    switch (command.type)
+    {
+        case Command::Connect :
+        {
+            connection = new Connection;
+            connection->id         = command.connection;
+            connection->first      = 0;
+            connection->batchCount = 0;
+            connection->queuedSize = 0;
+            connection->deadline   = m_clock.getElapsedTime().asMicroseconds() + command.timeout.asMicroseconds();
+            connection->connected  = false;
+            connection->closing    = false;
+            connection->congested  = false;
+            connection->watchWrite = true;
+            connection->bytesSent       = 0;
+            connection->bytesReceived   = 0;
+            connection->packetsSent     = 0;
+            connection->packetsReceived = 0;
+            connection->socket.setBlocking(false);
+
+            {
+                Lock lock(m_mutex);
+                m_connections[connection->id] = connection;
+            }
+            m_sockets[&connection->socket] = connection;
+
+            // The connection completes in the background, the socket becomes writable when it does
+            Socket::Status status = connection->socket.connect(command.address, command.port);
+            if ((status != Socket::Done) && (status != Socket::NotReady))
+            {
+                close(connection);
+                break;
+            }
+
+            m_selector.add(connection->socket, SocketSelector::Read | SocketSelector::Write);
+            break;
+        }
+
+        case Command::Send :
+        {
+            if (!connection || connection->closing)
+                break;
+
+            connection->queue.push_back(command.packet);
+            connection->queuedSize += command.packet.getDataSize();
+
+            if (!connection->congested && (connection->queuedSize > m_sendLimit))
+            {
+                connection->congested = true;
+                m_event.type       = Event::Congested;
+                m_event.connection = connection->id;
+                m_event.packet.clear();
+                pushEvent(m_event);
+            }
+            break;
+        }
+
+        case Command::Disconnect :
+        {
+            if (!connection)
+                break;
+
+            connection->closing = true;
+            update(connection);
+            break;
+        }
+    }
+}
+
+
+////////////////////////////////////////////////////////////
+void NetworkService::acceptConnections()
+{
+    for (;;)
+    {
+        Connection* connection = new Connection;
+        if (m_listener.accept(connection->socket) != Socket::Done)
+        {
+            delete connection;
+            return;
+        }
+
+        connection->id         = m_nextId++;
+        connection->first      = 0;
+        connection->batchCount = 0;
+        connection->queuedSize = 0;
+        connection->deadline   = 0;
+        connection->connected  = true;
+        connection->closing    = false;
+        connection->congested  = false;
+        connection->watchWrite = false;
+        connection->bytesSent       = 0;
+        connection->bytesReceived   = 0;
+        connection->packetsSent     = 0;
+        connection->packetsReceived = 0;
+        connection->socket.setBlocking(false);
+
+        {
+            Lock lock(m_mutex);
+            m_connections[connection->id] = connection;
+        }
+        m_sockets[&connection->socket] = connection;
+        m_selector.add(connection->socket, SocketSelector::Read);
+
+        m_event.type       = Event::Connected;
+        m_event.connection = connection->id;
+        m_event.packet.clear();
+        pushEvent(m_event);
+    }
+}
+
+
+////////////////////////////////////////////////////////////
+bool NetworkService::receivePackets(Connection& connection)
+{
+    while (m_backlog.empty())
+    {
+        Socket::Status status = connection.socket.receive(m_received);
+        if (status == Socket::NotReady)
+            return true;
+        if (status != Socket::Done)
+            return false;
+
+        // The received packets read the buffer of the socket, copy them
+        Uint64 size = 0;
+        for (std::vector<Packet*>::const_iterator it = m_received.begin(); it != m_received.end(); ++it)
+        {
+            m_event.type       = Event::Received;
+            m_event.connection = connection.id;
+            m_event.packet.clear();
+            m_event.packet.append((*it)->getData(), (*it)->getDataSize());
+            pushEvent(m_event);
+            size += (*it)->getDataSize();
+        }
+
+        connection.bytesReceived.fetch_add(size, std::memory_order_relaxed);
+        connection.packetsReceived.fetch_add(m_received.size(), std::memory_order_relaxed);
+    }
+
+    return true;
+}
+
+
+////////////////////////////////////////////////////////////
+bool NetworkService::sendPackets(Connection& connection)
+{
+    while (connection.first < connection.queue.size())
+    {
+        // A batch must be sent again until complete, the next packets wait for it
+        if (connection.batchCount == 0)
+            connection.batchCount = std::min(connection.queue.size() - connection.first, maxBatchCount);
+
+        Socket::Status status = connection.socket.send(&connection.queue[connection.first], connection.batchCount);
+        if ((status == Socket::NotReady) || (status == Socket::Partial))
+            break;
+        if (status != Socket::Done)
+            return false;
+
+        // Only the packets completely sent are counted, not the ones lost when a connection closes
+        Uint64 size = 0;
+        for (std::size_t i = 0; i < connection.batchCount; ++i)
+            size += connection.queue[connection.first + i].getDataSize();
+        connection.queuedSize -= static_cast<std::size_t>(size);
+        connection.bytesSent.fetch_add(size, std::memory_order_relaxed);
+        connection.packetsSent.fetch_add(connection.batchCount, std::memory_order_relaxed);
+        connection.first += connection.batchCount;
+        connection.batchCount = 0;
+    }
+
+    // Remove the packets sent, once they are the larger part of the queue
+    if ((connection.batchCount == 0) && (connection.first * 2 >= connection.queue.size()))
+    {
+        connection.queue.erase(connection.queue.begin(), connection.queue.begin() + connection.first);
+        connection.first = 0;
+    }
+
+    if (connection.congested && (connection.queuedSize <= m_sendLimit / 2))
+    {
+        connection.congested = false;
+        m_event.type       = Event::Drained;
+        m_event.connection = connection.id;
+        m_event.packet.clear();
+        pushEvent(m_event);
+    }
+
+    return true;
+}
+
+
+////////////////////////////////////////////////////////////
+void NetworkService::update(Connection* connection)
+{
+    bool sending = connection->first < connection->queue.size();
+    if (connection->closing && connection->connected && !sending)
+    {
+        close(connection);
+        return;
+    }
+
+    bool watchWrite = sending || !connection->connected;
+    if (watchWrite != connection->watchWrite)
+    {
+        connection->watchWrite = watchWrite;
+        m_selector.add(connection->socket, SocketSelector::Read | (watchWrite ? SocketSelector::Write : 0));
+    }
+}
+
+
+////////////////////////////////////////////////////////////
+void NetworkService::close(Connection* connection)
+{
+    m_selector.remove(connection->socket);
+    connection->socket.disconnect();
+
+    // The traffic of the connection isn't listed anymore once its event is polled
+    {
+        Lock lock(m_mutex);
+        m_connections.erase(connection->id);
+    }
+    m_sockets.erase(&connection->socket);
+
+    m_event.type       = Event::Disconnected;
+    m_event.connection = connection->id;
+    m_event.packet.clear();
+    pushEvent(m_event);
+
+    delete connection;
+}
+
+
+////////////////////////////////////////////////////////////
+void NetworkService::pushEvent(const Event& event)
+{
+    // Keep the order of the events: once there is a backlog, everything goes through it
+    if (!m_backlog.empty() || !m_events.push(event))
+        m_backlog.push_back(event);
+}
+
+} // namespace TGE
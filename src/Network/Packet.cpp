@@ -10,14 +10,17 @@
 #include <Tyrant/System/String.hpp>
 #include <cstring>
 #include <cwchar>
+#include <iterator>
 
 
 namespace TGE
 {
 ////////////////////////////////////////////////////////////
 Packet::Packet() :
-m_readPos(0),
-m_isValid(true)
+m_view    (NULL),
+m_viewSize(0),
+m_readPos (0),
+m_isValid (true)
 {
 
 }
@@ -35,6 +38,8 @@ void Packet::append(const void* data, std::size_t sizeInBytes)
 {
     if (data && (sizeInBytes > 0))
     {
+        detachView();
+
         std::size_t start = m_data.size();
         m_data.resize(start + sizeInBytes);
         std::memcpy(&m_data[start], data, sizeInBytes);
@@ -42,10 +47,19 @@ void Packet::append(const void* data, std::size_t sizeInBytes)
 }
 
 
+////////////////////////////////////////////////////////////
+void Packet::reserve(std::size_t sizeInBytes)
+{
+    m_data.reserve(sizeInBytes);
+}
+
+
 ////////////////////////////////////////////////////////////
 void Packet::clear()
 {
     m_data.clear();
+    m_view = NULL;
+    m_viewSize = 0;
     m_readPos = 0;
     m_isValid = true;
 }
@@ -54,6 +68,9 @@ void Packet::clear()
 ////////////////////////////////////////////////////////////
 const void* Packet::getData() const
 {
+    if (m_view)
+        return m_view;
+
     return !m_data.empty() ? &m_data[0] : NULL;
 }
 
@@ -61,14 +78,14 @@ const void* Packet::getData() const
 ////////////////////////////////////////////////////////////
 std::size_t Packet::getDataSize() const
 {
-    return m_data.size();
+    return m_view ? m_viewSize : m_data.size();
 }
 
 
 ////////////////////////////////////////////////////////////
 bool Packet::endOfPacket() const
 {
-    return m_readPos >= m_data.size();
+    return m_readPos >= getDataSize();
 }
 
 
@@ -95,7 +112,7 @@ Packet& Packet::operator >>(Int8& data)
 {
     if (checkSize(sizeof(data)))
     {
-        data = *reinterpret_cast<const Int8*>(&m_data[m_readPos]);
+        data = *reinterpret_cast<const Int8*>(getReadPointer());
         m_readPos += sizeof(data);
     }
 
@@ -108,7 +125,7 @@ Packet& Packet::operator >>(Uint8& data)
 {
     if (checkSize(sizeof(data)))
     {
-        data = *reinterpret_cast<const Uint8*>(&m_data[m_readPos]);
+        data = *reinterpret_cast<const Uint8*>(getReadPointer());
         m_readPos += sizeof(data);
     }
 
@@ -121,7 +138,7 @@ Packet& Packet::operator >>(Int16& data)
 {
     if (checkSize(sizeof(data)))
     {
-        data = ntohs(*reinterpret_cast<const Int16*>(&m_data[m_readPos]));
+        data = ntohs(*reinterpret_cast<const Int16*>(getReadPointer()));
         m_readPos += sizeof(data);
     }
 
@@ -134,7 +151,7 @@ Packet& Packet::operator >>(Uint16& data)
 {
     if (checkSize(sizeof(data)))
     {
-        data = ntohs(*reinterpret_cast<const Uint16*>(&m_data[m_readPos]));
+        data = ntohs(*reinterpret_cast<const Uint16*>(getReadPointer()));
         m_readPos += sizeof(data);
     }
 
@@ -147,7 +164,7 @@ Packet& Packet::operator >>(Int32& data)
 {
     if (checkSize(sizeof(data)))
     {
-        data = ntohl(*reinterpret_cast<const Int32*>(&m_data[m_readPos]));
+        data = ntohl(*reinterpret_cast<const Int32*>(getReadPointer()));
         m_readPos += sizeof(data);
     }
 
@@ -160,7 +177,7 @@ Packet& Packet::operator >>(Uint32& data)
 {
     if (checkSize(sizeof(data)))
     {
-        data = ntohl(*reinterpret_cast<const Uint32*>(&m_data[m_readPos]));
+        data = ntohl(*reinterpret_cast<const Uint32*>(getReadPointer()));
         m_readPos += sizeof(data);
     }
 
@@ -173,7 +190,7 @@ Packet& Packet::operator >>(float& data)
 {
     if (checkSize(sizeof(data)))
     {
-        data = *reinterpret_cast<const float*>(&m_data[m_readPos]);
+        data = *reinterpret_cast<const float*>(getReadPointer());
         m_readPos += sizeof(data);
     }
 
@@ -186,7 +203,7 @@ Packet& Packet::operator >>(double& data)
 {
     if (checkSize(sizeof(data)))
     {
-        data = *reinterpret_cast<const double*>(&m_data[m_readPos]);
+        data = *reinterpret_cast<const double*>(getReadPointer());
         m_readPos += sizeof(data);
     }
 
@@ -204,7 +221,7 @@ Packet& Packet::operator >>(char* data)
     if ((length > 0) && checkSize(length))
     {
         // Then extract characters
-        std::memcpy(data, &m_data[m_readPos], length);
+        std::memcpy(data, getReadPointer(), length);
         data[length] = '\0';
 
         // Update reading position
@@ -226,7 +243,7 @@ Packet& Packet::operator >>(std::string& data)
     if ((length > 0) && checkSize(length))
     {
         // Then extract characters
-        data.assign(&m_data[m_readPos], length);
+        data.assign(getReadPointer(), length);
 
         // Update reading position
         m_readPos += length;
@@ -418,8 +435,7 @@ Packet& Packet::operator <<(const wchar_t* data)
     *this << length;
 
     // Then insert characters
-    for (const wchar_t* c = data; *c != L'\0'; ++c)
-        *this << static_cast<Uint32>(*c);
+    appendCharacters(data, data + length);
 
     return *this;
 }
@@ -434,10 +450,7 @@ Packet& Packet::operator <<(const std::wstring& data)
 
     // Then insert characters
     if (length > 0)
-    {
-        for (std::wstring::const_iterator c = data.begin(); c != data.end(); ++c)
-            *this << static_cast<Uint32>(*c);
-    }
+        appendCharacters(data.begin(), data.end());
 
     return *this;
 }
@@ -452,10 +465,7 @@ Packet& Packet::operator <<(const String& data)
 
     // Then insert characters
     if (length > 0)
-    {
-        for (String::ConstIterator c = data.begin(); c != data.end(); ++c)
-            *this << *c;
-    }
+        appendCharacters(data.begin(), data.end());
 
     return *this;
 }
@@ -464,12 +474,62 @@ Packet& Packet::operator <<(const String& data)
 ////////////////////////////////////////////////////////////
 bool Packet::checkSize(std::size_t size)
 {
-    m_isValid = m_isValid && (m_readPos + size <= m_data.size());
+    m_isValid = m_isValid && (m_readPos + size <= getDataSize());
 
     return m_isValid;
 }
 
 
+////////////////////////////////////////////////////////////
+void Packet::setView(const void* data, std::size_t size)
+{
+    clear();
+
+    if (data && (size > 0))
+    {
+        m_view = static_cast<const char*>(data);
+        m_viewSize = size;
+    }
+}
+
+
+////////////////////////////////////////////////////////////
+const char* Packet::getReadPointer() const
+{
+    return static_cast<const char*>(getData()) + m_readPos;
+}
+
+
+////////////////////////////////////////////////////////////
+void Packet::detachView()
+{
+    if (m_view)
+    {
+        m_data.assign(m_view, m_view + m_viewSize);
+        m_view = NULL;
+        m_viewSize = 0;
+    }
+}
+
+
+////////////////////////////////////////////////////////////
+template <typename Iterator>
+void Packet::appendCharacters(Iterator begin, Iterator end)
+{
+    detachView();
+
+    // Grow the data once, then convert the characters in place
+    std::size_t start = m_data.size();
+    m_data.resize(start + std::distance(begin, end) * sizeof(Uint32));
+
+    for (char* character = &m_data[0] + start; begin != end; ++begin, character += sizeof(Uint32))
+    {
+        Uint32 toWrite = htonl(static_cast<Uint32>(*begin));
+        std::memcpy(character, &toWrite, sizeof(toWrite));
+    }
+}
+
+
 ////////////////////////////////////////////////////////////
 const void* Packet::onSend(std::size_t& size)
 {
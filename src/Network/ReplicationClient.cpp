@@ -0,0 +1,190 @@
+/*************************************/
+/** Copyright © 2014 Coldsnap Games **/
+/*************************************/
+
+/*************************************/
+/**             Headers             **/
+/*************************************/
+#include <Tyrant/Network/ReplicationClient.hpp>
+#include <Tyrant/Network/ReplicationSchema.hpp>
+#include <Tyrant/Network/BitReader.hpp>
+#include <Tyrant/Network/Packet.hpp>
+#include <algorithm>
+#include <cmath>
+
+
+namespace TGE
+{
+////////////////////////////////////////////////////////////
+ReplicationClient::ReplicationClient(const ReplicationSchema& schema, std::size_t bufferSize) :
+m_buffer  (std::max<std::size_t>(bufferSize, 2), Snapshot(schema)),
+m_valid   (m_buffer.size(), false),
+m_received(false),
+m_latest  (0),
+m_scratch (schema)
+{
+
+}
+
+
+////////////////////////////////////////////////////////////
+bool ReplicationClient::readDelta(const Packet& packet, std::size_t offset)
+{
+    BitReader reader(packet, offset);
+    const ReplicationSchema& schema = m_scratch.getSchema();
+    std::size_t fieldCount = schema.getFieldCount();
+
+    Uint32 tick = reader.readVarint();
+    if (!reader)
+        return false;
+
+    // Ignore the snapshots already received, or too old to be buffered
+    if (findSnapshot(tick) || (m_received && (static_cast<Int32>(m_latest - tick) >= static_cast<Int32>(m_buffer.size()))))
+        return false;
+
+    if (reader.readBool())
+    {
+        const Snapshot* baseline = findSnapshot(tick - reader.readVarint());
+        if (!baseline)
+            return false;
+
+        m_scratch = *baseline;
+    }
+    else
+    {
+        m_scratch.clear();
+    }
+
+    Uint32 removedCount = reader.readVarint();
+    Uint16 entity = 0;
+    for (Uint32 i = 0; (i < removedCount) && reader; ++i)
+    {
+        entity = static_cast<Uint16>(entity + reader.readVarint());
+        m_scratch.removeEntity(entity);
+    }
+
+    Uint32 changedCount = reader.readVarint();
+    entity = 0;
+    for (Uint32 i = 0; (i < changedCount) && reader; ++i)
+    {
+        entity = static_cast<Uint16>(entity + reader.readVarint());
+
+        if (reader.readBool())
+        {
+            // New entity: all its fields
+            Uint32* values = m_scratch.getValues(entity);
+            for (std::size_t field = 0; field < fieldCount; ++field)
+                values[field] = reader.readBits(schema.getBitCount(field));
+        }
+        else
+        {
+            // Known entity: the fields which changed
+            if (!m_scratch.hasEntity(entity))
+                return false;
+
+            Uint32* values = m_scratch.getValues(entity);
+            for (std::size_t field = 0; field < fieldCount; ++field)
+            {
+                if (reader.readBool())
+                    values[field] = reader.readBits(schema.getBitCount(field));
+            }
+        }
+    }
+
+    if (!reader)
+        return false;
+
+    // Store the snapshot, assigning reuses the memory of the one replaced
+    std::size_t slot = tick % m_buffer.size();
+    m_scratch.setTick(tick);
+    m_buffer[slot] = m_scratch;
+    m_valid[slot]  = true;
+
+    if (!m_received || (static_cast<Int32>(tick - m_latest) > 0))
+    {
+        m_received = true;
+        m_latest   = tick;
+    }
+
+    return true;
+}
+
+
+////////////////////////////////////////////////////////////
+bool ReplicationClient::hasSnapshot() const
+{
+    return m_received;
+}
+
+
+////////////////////////////////////////////////////////////
+Uint32 ReplicationClient::getLatestTick() const
+{
+    return m_latest;
+}
+
+
+////////////////////////////////////////////////////////////
+const Snapshot* ReplicationClient::findSnapshot(Uint32 tick) const
+{
+    std::size_t slot = tick % m_buffer.size();
+
+    return (m_valid[slot] && (m_buffer[slot].getTick() == tick)) ? &m_buffer[slot] : NULL;
+}
+
+
+////////////////////////////////////////////////////////////
+bool ReplicationClient::interpolate(double tick, Snapshot& result) const
+{
+    if (!m_received)
+        return false;
+
+    // Find the snapshots surrounding the tick, walking back from the latest one
+    const Snapshot* older = NULL;
+    const Snapshot* newer = NULL;
+    for (Uint32 i = 0; i < m_buffer.size(); ++i)
+    {
+        const Snapshot* snapshot = findSnapshot(m_latest - i);
+        if (!snapshot)
+            continue;
+
+        if (snapshot->getTick() <= tick)
+        {
+            older = snapshot;
+            break;
+        }
+
+        newer = snapshot;
+    }
+
+    if (!older)
+        return false;
+
+    result = *older;
+    if (!newer)
+        return true;
+
+    const ReplicationSchema& schema = older->getSchema();
+    std::size_t fieldCount = schema.getFieldCount();
+    double alpha = (tick - older->getTick()) / (newer->getTick() - older->getTick());
+
+    for (std::size_t i = 0; i < result.getEntityCount(); ++i)
+    {
+        std::size_t index = newer->findEntity(result.m_entities[i]);
+        if (index == newer->getEntityCount())
+            continue;
+
+        Uint32* values = &result.m_values[i * fieldCount];
+        const Uint32* targets = newer->getValuesAt(index);
+        for (std::size_t field = 0; field < fieldCount; ++field)
+        {
+            // Interpolate the quantized values, it's the same as interpolating the floats
+            if (schema.getFieldType(field) == ReplicationSchema::Float)
+                values[field] = static_cast<Uint32>(std::floor(values[field] + (static_cast<double>(targets[field]) - values[field]) * alpha + 0.5));
+        }
+    }
+
+    return true;
+}
+
+} // namespace TGE
@@ -0,0 +1,142 @@
+/*************************************/
+/** Copyright © 2014 Coldsnap Games **/
+/*************************************/
+
+/*************************************/
+/**             Headers             **/
+/*************************************/
+#include <Tyrant/Network/ReplicationSchema.hpp>
+#include <Tyrant/Network/BitWriter.hpp>
+#include <algorithm>
+#include <cmath>
+
+
+namespace
+{
+    // Number of steps of a quantized float
+    double getSteps(unsigned int bitCount)
+    {
+        return static_cast<double>(bitCount < 32 ? (1u << bitCount) - 1 : 0xFFFFFFFFu);
+    }
+}
+
+namespace TGE
+{
+////////////////////////////////////////////////////////////
+ReplicationSchema::ReplicationSchema() :
+m_fields()
+{
+
+}
+
+
+////////////////////////////////////////////////////////////
+std::size_t ReplicationSchema::addInteger(Int32 min, Int32 max)
+{
+    Field field;
+    field.type       = Integer;
+    field.minInteger = min;
+    field.maxInteger = max;
+    field.minFloat   = 0.f;
+    field.maxFloat   = 0.f;
+    field.bitCount   = BitWriter::getBitsRequired(static_cast<Uint32>(max) - static_cast<Uint32>(min));
+
+    m_fields.push_back(field);
+
+    return m_fields.size() - 1;
+}
+
+
+////////////////////////////////////////////////////////////
+std::size_t ReplicationSchema::addFloat(float min, float max, unsigned int bitCount)
+{
+    Field field;
+    field.type       = Float;
+    field.minInteger = 0;
+    field.maxInteger = 0;
+    field.minFloat   = min;
+    field.maxFloat   = max;
+    field.bitCount   = std::min(std::max(bitCount, 1u), 32u);
+
+    m_fields.push_back(field);
+
+    return m_fields.size() - 1;
+}
+
+
+////////////////////////////////////////////////////////////
+std::size_t ReplicationSchema::addBool()
+{
+    Field field;
+    field.type       = Boolean;
+    field.minInteger = 0;
+    field.maxInteger = 1;
+    field.minFloat   = 0.f;
+    field.maxFloat   = 0.f;
+    field.bitCount   = 1;
+
+    m_fields.push_back(field);
+
+    return m_fields.size() - 1;
+}
+
+
+////////////////////////////////////////////////////////////
+std::size_t ReplicationSchema::getFieldCount() const
+{
+    return m_fields.size();
+}
+
+
+////////////////////////////////////////////////////////////
+ReplicationSchema::FieldType ReplicationSchema::getFieldType(std::size_t field) const
+{
+    return m_fields[field].type;
+}
+
+
+////////////////////////////////////////////////////////////
+unsigned int ReplicationSchema::getBitCount(std::size_t field) const
+{
+    return m_fields[field].bitCount;
+}
+
+
+////////////////////////////////////////////////////////////
+Uint32 ReplicationSchema::encodeInteger(std::size_t field, Int32 value) const
+{
+    const Field& description = m_fields[field];
+    value = std::min(std::max(value, description.minInteger), description.maxInteger);
+
+    return static_cast<Uint32>(value) - static_cast<Uint32>(description.minInteger);
+}
+
+
+////////////////////////////////////////////////////////////
+Int32 ReplicationSchema::decodeInteger(std::size_t field, Uint32 value) const
+{
+    return static_cast<Int32>(static_cast<Uint32>(m_fields[field].minInteger) + value);
+}
+
+
+////////////////////////////////////////////////////////////
+Uint32 ReplicationSchema::encodeFloat(std::size_t field, float value) const
+{
+    const Field& description = m_fields[field];
+    value = std::min(std::max(value, description.minFloat), description.maxFloat);
+
+    double normalized = (value - description.minFloat) / static_cast<double>(description.maxFloat - description.minFloat);
+
+    return static_cast<Uint32>(std::floor(normalized * getSteps(description.bitCount) + 0.5));
+}
+
+
+////////////////////////////////////////////////////////////
+float ReplicationSchema::decodeFloat(std::size_t field, Uint32 value) const
+{
+    const Field& description = m_fields[field];
+
+    return static_cast<float>(description.minFloat + value / getSteps(description.bitCount) * (description.maxFloat - description.minFloat));
+}
+
+} // namespace TGE
@@ -0,0 +1,242 @@
+/*************************************/
+/** Copyright © 2014 Coldsnap Games **/
+/*************************************/
+
+/*************************************/
+/**             Headers             **/
+/*************************************/
+#include <Tyrant/Network/ReplicationServer.hpp>
+#include <Tyrant/Network/ReplicationSchema.hpp>
+#include <Tyrant/Network/BitWriter.hpp>
+#include <Tyrant/Network/Packet.hpp>
+#include <algorithm>
+#include <cstring>
+
+
+namespace
+{
+    // Window over which the bandwidth is measured, in microseconds
+    const TGE::Int64 BandwidthWindow = 1000000;
+}
+
+namespace TGE
+{
+////////////////////////////////////////////////////////////
+ReplicationServer::Client::Client() :
+connected   (false),
+acknowledged(false),
+ackedTick   (0),
+sent        ()
+{
+
+}
+
+
+////////////////////////////////////////////////////////////
+ReplicationServer::ReplicationServer(const ReplicationSchema& schema, std::size_t historySize) :
+m_history  (std::max<std::size_t>(historySize, 1), Snapshot(schema)),
+m_hasLatest(false),
+m_latest   (0),
+m_clients  (),
+m_changed  (),
+m_matching (),
+m_removed  (),
+m_clock    ()
+{
+
+}
+
+
+////////////////////////////////////////////////////////////
+void ReplicationServer::addSnapshot(const Snapshot& snapshot)
+{
+    // Assigning reuses the memory of the snapshot replaced
+    m_history[snapshot.getTick() % m_history.size()] = snapshot;
+
+    m_hasLatest = true;
+    m_latest    = snapshot.getTick();
+}
+
+
+////////////////////////////////////////////////////////////
+std::size_t ReplicationServer::addClient()
+{
+    std::size_t client = 0;
+    while ((client < m_clients.size()) && m_clients[client].connected)
+        ++client;
+
+    if (client == m_clients.size())
+        m_clients.push_back(Client());
+    else
+        m_clients[client] = Client();
+
+    m_clients[client].connected = true;
+
+    return client;
+}
+
+
+////////////////////////////////////////////////////////////
+void ReplicationServer::removeClient(std::size_t client)
+{
+    if (client < m_clients.size())
+        m_clients[client] = Client();
+}
+
+
+////////////////////////////////////////////////////////////
+void ReplicationServer::acknowledge(std::size_t client, Uint32 tick)
+{
+    if ((client >= m_clients.size()) || !m_clients[client].connected)
+        return;
+
+    Client& state = m_clients[client];
+
+    // Compare with wrap-around, like sequence numbers
+    if (!state.acknowledged || (static_cast<Int32>(tick - state.ackedTick) > 0))
+    {
+        state.acknowledged = true;
+        state.ackedTick    = tick;
+    }
+}
+
+
+////////////////////////////////////////////////////////////
+bool ReplicationServer::writeDelta(std::size_t client, Packet& packet)
+{
+    if (!m_hasLatest || (client >= m_clients.size()) || !m_clients[client].connected)
+        return false;
+
+    Client& state = m_clients[client];
+    const Snapshot& current = m_history[m_latest % m_history.size()];
+    const Snapshot* baseline = state.acknowledged ? findSnapshot(state.ackedTick) : NULL;
+    const ReplicationSchema& schema = current.getSchema();
+    std::size_t fieldCount = schema.getFieldCount();
+
+    // Match the entities of both snapshots, both lists are sorted
+    m_changed.clear();
+    m_matching.clear();
+    m_removed.clear();
+
+    std::size_t baselineCount = baseline ? baseline->getEntityCount() : 0;
+    std::size_t j = 0;
+    for (std::size_t i = 0; i < current.getEntityCount(); ++i)
+    {
+        Uint16 entity = current.m_entities[i];
+
+        while ((j < baselineCount) && (baseline->m_entities[j] < entity))
+            m_removed.push_back(baseline->m_entities[j++]);
+
+        if ((j < baselineCount) && (baseline->m_entities[j] == entity))
+        {
+            // Skip the entities which didn't change at all
+            if (std::memcmp(current.getValuesAt(i), baseline->getValuesAt(j), fieldCount * sizeof(Uint32)) != 0)
+            {
+                m_changed.push_back(i);
+                m_matching.push_back(j);
+            }
+            ++j;
+        }
+        else
+        {
+            m_changed.push_back(i);
+            m_matching.push_back(baselineCount);
+        }
+    }
+    while (j < baselineCount)
+        m_removed.push_back(baseline->m_entities[j++]);
+
+    std::size_t startSize = packet.getDataSize();
+    {
+        BitWriter writer(packet);
+
+        writer.writeVarint(current.getTick());
+        writer.write(baseline != NULL);
+        if (baseline)
+            writer.writeVarint(current.getTick() - baseline->getTick());
+
+        // Identifiers are sorted, write the difference with the previous one
+        writer.writeVarint(static_cast<Uint32>(m_removed.size()));
+        Uint16 previous = 0;
+        for (std::size_t i = 0; i < m_removed.size(); ++i)
+        {
+            writer.writeVarint(m_removed[i] - previous);
+            previous = m_removed[i];
+        }
+
+        writer.writeVarint(static_cast<Uint32>(m_changed.size()));
+        previous = 0;
+        for (std::size_t i = 0; i < m_changed.size(); ++i)
+        {
+            Uint16 entity = current.m_entities[m_changed[i]];
+            const Uint32* values = current.getValuesAt(m_changed[i]);
+
+            writer.writeVarint(entity - previous);
+            previous = entity;
+
+            if (m_matching[i] == baselineCount)
+            {
+                // New entity: all its fields
+                writer.write(true);
+                for (std::size_t field = 0; field < fieldCount; ++field)
+                    writer.writeBits(values[field], schema.getBitCount(field));
+            }
+            else
+            {
+                // Known entity: a bit per field, then the fields which changed
+                const Uint32* previousValues = baseline->getValuesAt(m_matching[i]);
+
+                writer.write(false);
+                for (std::size_t field = 0; field < fieldCount; ++field)
+                {
+                    bool changed = values[field] != previousValues[field];
+                    writer.write(changed);
+                    if (changed)
+                        writer.writeBits(values[field], schema.getBitCount(field));
+                }
+            }
+        }
+    }
+
+    // Record the size for the bandwidth statistics
+    Int64 now = m_clock.getElapsedTime().asMicroseconds();
+    while (!state.sent.empty() && (now - state.sent.front().first >= BandwidthWindow))
+        state.sent.pop_front();
+    state.sent.push_back(std::make_pair(now, packet.getDataSize() - startSize));
+
+    return true;
+}
+
+
+////////////////////////////////////////////////////////////
+std::size_t ReplicationServer::getBytesPerSecond(std::size_t client) const
+{
+    if (client >= m_clients.size())
+        return 0;
+
+    Int64 now = m_clock.getElapsedTime().asMicroseconds();
+    std::size_t bytes = 0;
+
+    const std::deque<std::pair<Int64, std::size_t> >& sent = m_clients[client].sent;
+    for (std::deque<std::pair<Int64, std::size_t> >::const_iterator it = sent.begin(); it != sent.end(); ++it)
+    {
+        if (now - it->first < BandwidthWindow)
+            bytes += it->second;
+    }
+
+    return bytes;
+}
+
+
+////////////////////////////////////////////////////////////
+const Snapshot* ReplicationServer::findSnapshot(Uint32 tick) const
+{
+    if (!m_hasLatest || (static_cast<Int32>(m_latest - tick) < 0))
+        return NULL;
+
+    const Snapshot& snapshot = m_history[tick % m_history.size()];
+
+    return snapshot.getTick() == tick ? &snapshot : NULL;
+}
+
+} // namespace TGE
@@ -0,0 +1,335 @@
+/*************************************/
+/** Copyright © 2014 Coldsnap Games **/
+/*************************************/
+
+/*************************************/
+/**             Headers             **/
+/*************************************/
+#include <Tyrant/Network/Resolver.hpp>
+#include <Tyrant/System/Lock.hpp>
+#include <Tyrant/System/Thread.hpp>
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <sstream>
+
+
+namespace
+{
+    // Default time to live of the names resolved, in microseconds
+    const TGE::Int64 DefaultResolvedTtl = 300 * 1000000LL;
+
+    // Default time to live of the failures, in microseconds
+    const TGE::Int64 DefaultFailedTtl = 10 * 1000000LL;
+
+    // Interval between two removals of the expired names, in microseconds
+    const TGE::Int64 PurgeInterval = 10 * 1000000LL;
+
+    std::string toLower(const std::string& name)
+    {
+        std::string lower(name);
+        for (std::string::iterator it = lower.begin(); it != lower.end(); ++it)
+            *it = static_cast<char>(std::tolower(static_cast<unsigned char>(*it)));
+
+        return lower;
+    }
+
+    // Parse an address in the "xxx.xxx.xxx.xxx" form, without ever asking the system
+    bool parseAddress(const std::string& name, TGE::IpAddress& address)
+    {
+        unsigned int bytes[4] = {0, 0, 0, 0};
+        std::size_t byte = 0;
+        std::size_t digits = 0;
+        for (std::string::const_iterator it = name.begin(); it != name.end(); ++it)
+        {
+            if ((*it >= '0') && (*it <= '9') && (digits < 3))
+            {
+                bytes[byte] = bytes[byte] * 10 + (*it - '0');
+                digits++;
+            }
+            else if ((*it == '.') && (digits > 0) && (byte < 3))
+            {
+                byte++;
+                digits = 0;
+            }
+            else
+            {
+                return false;
+            }
+        }
+
+        if ((byte != 3) || (digits == 0) || (bytes[0] > 255) || (bytes[1] > 255) || (bytes[2] > 255) || (bytes[3] > 255))
+            return false;
+
+        address = TGE::IpAddress(static_cast<TGE::Uint8>(bytes[0]),
+                                 static_cast<TGE::Uint8>(bytes[1]),
+                                 static_cast<TGE::Uint8>(bytes[2]),
+                                 static_cast<TGE::Uint8>(bytes[3]));
+        return true;
+    }
+}
+
+namespace TGE
+{
+////////////////////////////////////////////////////////////
+Resolver::Resolver(unsigned int workerCount) :
+m_workerCount(std::max(workerCount, 1u)),
+m_workers    (),
+m_idle       (0),
+m_running    (true),
+m_resolvedTtl(DefaultResolvedTtl),
+m_failedTtl  (DefaultFailedTtl),
+m_system     (true),
+m_hosts      (),
+m_cache      (),
+m_queue      (),
+m_results    (),
+m_lastPurge  (0),
+m_clock      (),
+m_mutex      (Mutex::NonRecursive),
+m_wakeUp     ()
+{
+
+}
+
+
+////////////////////////////////////////////////////////////
+Resolver::~Resolver()
+{
+    {
+        Lock lock(m_mutex);
+        m_running = false;
+        m_queue.clear();
+        m_wakeUp.notifyAll();
+    }
+
+    for (std::vector<Thread*>::iterator it = m_workers.begin(); it != m_workers.end(); ++it)
+    {
+        (*it)->wait();
+        delete *it;
+    }
+}
+
+
+////////////////////////////////////////////////////////////
+void Resolver::setTimeToLive(Time resolved, Time failed)
+{
+    Lock lock(m_mutex);
+
+    m_resolvedTtl = resolved.asMicroseconds();
+    m_failedTtl   = failed.asMicroseconds();
+}
+
+
+////////////////////////////////////////////////////////////
+void Resolver::setSystemLookup(bool enabled)
+{
+    Lock lock(m_mutex);
+
+    m_system = enabled;
+}
+
+
+////////////////////////////////////////////////////////////
+void Resolver::addHost(const std::string& name, const IpAddress& address)
+{
+    Lock lock(m_mutex);
+
+    m_hosts[toLower(name)] = address;
+}
+
+
+////////////////////////////////////////////////////////////
+bool Resolver::loadHostsFile(const std::string& filename)
+{
+    std::ifstream file(filename.c_str());
+    if (!file)
+        return false;
+
+    std::string line;
+    while (std::getline(file, line))
+    {
+        std::size_t comment = line.find('#');
+        if (comment != std::string::npos)
+            line.erase(comment);
+
+        std::istringstream stream(line);
+        std::string field;
+        IpAddress address;
+        if (!(stream >> field) || !parseAddress(field, address))
+            continue;
+
+        while (stream >> field)
+            addHost(field, address);
+    }
+
+    return true;
+}
+
+
+////////////////////////////////////////////////////////////
+void Resolver::resolve(const std::string& name, const Callback& callback)
+{
+    std::string key = toLower(name);
+    IpAddress address;
+    bool known = false;
+
+    {
+        Lock lock(m_mutex);
+
+        known = findAddress(key, address) || !m_system;
+        if (!known)
+        {
+            std::map<std::string, Entry>::iterator it = m_cache.find(key);
+            if (it == m_cache.end())
+            {
+                it = m_cache.insert(std::make_pair(key, Entry())).first;
+                it->second.expiry  = 0;
+                it->second.pending = false;
+            }
+
+            // A name already being resolved just gets one more callback
+            Entry& entry = it->second;
+            entry.callbacks.push_back(callback);
+            if (!entry.pending)
+            {
+                entry.pending = true;
+                m_queue.push_back(key);
+
+                if ((m_idle == 0) && (m_workers.size() < m_workerCount))
+                {
+                    m_workers.push_back(new Thread(&Resolver::resolveNames, this));
+                    m_workers.back()->launch();
+                }
+                else
+                {
+                    m_wakeUp.notifyOne();
+                }
+            }
+        }
+    }
+
+    // Called without the lock, the callback may resolve another name
+    if (known)
+        callback(key, address);
+}
+
+
+////////////////////////////////////////////////////////////
+bool Resolver::lookup(const std::string& name, IpAddress& address)
+{
+    Lock lock(m_mutex);
+
+    return findAddress(toLower(name), address);
+}
+
+
+////////////////////////////////////////////////////////////
+void Resolver::update()
+{
+    std::vector<Result> results;
+
+    {
+        Lock lock(m_mutex);
+        results.swap(m_results);
+
+        // Forget the expired names from time to time, so that the cache doesn't grow forever
+        Int64 now = m_clock.getElapsedTime().asMicroseconds();
+        if (now - m_lastPurge > PurgeInterval)
+        {
+            for (std::map<std::string, Entry>::iterator it = m_cache.begin(); it != m_cache.end(); )
+            {
+                if (!it->second.pending && (it->second.expiry <= now))
+                    m_cache.erase(it++);
+                else
+                    ++it;
+            }
+            m_lastPurge = now;
+        }
+    }
+
+    for (std::vector<Result>::const_iterator it = results.begin(); it != results.end(); ++it)
+    {
+        for (std::vector<Callback>::const_iterator callback = it->callbacks.begin(); callback != it->callbacks.end(); ++callback)
+            (*callback)(it->name, it->address);
+    }
+}
+
+
+////////////////////////////////////////////////////////////
+void Resolver::clearCache()
+{
+    Lock lock(m_mutex);
+
+    for (std::map<std::string, Entry>::iterator it = m_cache.begin(); it != m_cache.end(); )
+    {
+        if (!it->second.pending)
+            m_cache.erase(it++);
+        else
+            ++it;
+    }
+}
+
+
+////////////////////////////////////////////////////////////
+bool Resolver::findAddress(const std::string& name, IpAddress& address)
+{
+    std::map<std::string, IpAddress>::const_iterator host = m_hosts.find(name);
+    if (host != m_hosts.end())
+    {
+        address = host->second;
+        return true;
+    }
+
+    if (parseAddress(name, address))
+        return true;
+
+    std::map<std::string, Entry>::const_iterator entry = m_cache.find(name);
+    if ((entry != m_cache.end()) && !entry->second.pending && (entry->second.expiry > m_clock.getElapsedTime().asMicroseconds()))
+    {
+        address = entry->second.address;
+        return true;
+    }
+
+    return false;
+}
+
+
+////////////////////////////////////////////////////////////
+void Resolver::resolveNames()
+{
+    m_mutex.lock();
+
+    while (m_running)
+    {
+        if (m_queue.empty())
+        {
+            m_idle++;
+            m_wakeUp.wait(m_mutex);
+            m_idle--;
+            continue;
+        }
+
+        std::string name = m_queue.front();
+        m_queue.pop_front();
+
+        // The system resolver blocks, the other threads must not wait for it
+        m_mutex.unlock();
+        IpAddress address(name);
+        m_mutex.lock();
+
+        Entry& entry = m_cache[name];
+        entry.address = address;
+        entry.expiry  = m_clock.getElapsedTime().asMicroseconds() + (address != IpAddress::None ? m_resolvedTtl : m_failedTtl);
+        entry.pending = false;
+
+        m_results.push_back(Result());
+        m_results.back().name    = name;
+        m_results.back().address = address;
+        m_results.back().callbacks.swap(entry.callbacks);
+    }
+
+    m_mutex.unlock();
+}
+
+} // namespace TGE
@@ -0,0 +1,184 @@
+/*************************************/
+/** Copyright © 2014 Coldsnap Games **/
+/*************************************/
+
+/*************************************/
+/**             Headers             **/
+/*************************************/
+#include <Tyrant/Network/Snapshot.hpp>
+#include <Tyrant/Network/ReplicationSchema.hpp>
+#include <algorithm>
+
+
+namespace TGE
+{
+////////////////////////////////////////////////////////////
+Snapshot::Snapshot(const ReplicationSchema& schema) :
+m_schema    (&schema),
+m_fieldCount(schema.getFieldCount()),
+m_tick      (0),
+m_entities  (),
+m_values    ()
+{
+
+}
+
+
+////////////////////////////////////////////////////////////
+const ReplicationSchema& Snapshot::getSchema() const
+{
+    return *m_schema;
+}
+
+
+////////////////////////////////////////////////////////////
+void Snapshot::setTick(Uint32 tick)
+{
+    m_tick = tick;
+}
+
+
+////////////////////////////////////////////////////////////
+Uint32 Snapshot::getTick() const
+{
+    return m_tick;
+}
+
+
+////////////////////////////////////////////////////////////
+void Snapshot::clear()
+{
+    m_entities.clear();
+    m_values.clear();
+}
+
+
+////////////////////////////////////////////////////////////
+void Snapshot::addEntity(Uint16 entity)
+{
+    getValues(entity);
+}
+
+
+////////////////////////////////////////////////////////////
+void Snapshot::removeEntity(Uint16 entity)
+{
+    std::size_t index = findEntity(entity);
+    if (index == m_entities.size())
+        return;
+
+    m_entities.erase(m_entities.begin() + index);
+    m_values.erase(m_values.begin() + index * m_fieldCount, m_values.begin() + (index + 1) * m_fieldCount);
+}
+
+
+////////////////////////////////////////////////////////////
+bool Snapshot::hasEntity(Uint16 entity) const
+{
+    return findEntity(entity) != m_entities.size();
+}
+
+
+////////////////////////////////////////////////////////////
+std::size_t Snapshot::getEntityCount() const
+{
+    return m_entities.size();
+}
+
+
+////////////////////////////////////////////////////////////
+Uint16 Snapshot::getEntityId(std::size_t index) const
+{
+    return m_entities[index];
+}
+
+
+////////////////////////////////////////////////////////////
+void Snapshot::setInteger(Uint16 entity, std::size_t field, Int32 value)
+{
+    getValues(entity)[field] = m_schema->encodeInteger(field, value);
+}
+
+
+////////////////////////////////////////////////////////////
+Int32 Snapshot::getInteger(Uint16 entity, std::size_t field) const
+{
+    std::size_t index = findEntity(entity);
+    if (index == m_entities.size())
+        return 0;
+
+    return m_schema->decodeInteger(field, getValuesAt(index)[field]);
+}
+
+
+////////////////////////////////////////////////////////////
+void Snapshot::setFloat(Uint16 entity, std::size_t field, float value)
+{
+    getValues(entity)[field] = m_schema->encodeFloat(field, value);
+}
+
+
+////////////////////////////////////////////////////////////
+float Snapshot::getFloat(Uint16 entity, std::size_t field) const
+{
+    std::size_t index = findEntity(entity);
+    if (index == m_entities.size())
+        return 0.f;
+
+    return m_schema->decodeFloat(field, getValuesAt(index)[field]);
+}
+
+
+////////////////////////////////////////////////////////////
+void Snapshot::setBool(Uint16 entity, std::size_t field, bool value)
+{
+    getValues(entity)[field] = value ? 1 : 0;
+}
+
+
+////////////////////////////////////////////////////////////
+bool Snapshot::getBool(Uint16 entity, std::size_t field) const
+{
+    std::size_t index = findEntity(entity);
+    if (index == m_entities.size())
+        return false;
+
+    return getValuesAt(index)[field] != 0;
+}
+
+
+////////////////////////////////////////////////////////////
+std::size_t Snapshot::findEntity(Uint16 entity) const
+{
+    std::vector<Uint16>::const_iterator it = std::lower_bound(m_entities.begin(), m_entities.end(), entity);
+    if ((it == m_entities.end()) || (*it != entity))
+        return m_entities.size();
+
+    return it - m_entities.begin();
+}
+
+
+////////////////////////////////////////////////////////////
+Uint32* Snapshot::getValues(Uint16 entity)
+{
+    std::vector<Uint16>::iterator it = std::lower_bound(m_entities.begin(), m_entities.end(), entity);
+    std::size_t index = it - m_entities.begin();
+
+    // Entities are usually added in increasing order, which only appends
+    if ((it == m_entities.end()) || (*it != entity))
+    {
+        m_entities.insert(it, entity);
+        m_values.insert(m_values.begin() + index * m_fieldCount, m_fieldCount, 0);
+    }
+
+    return &m_values[index * m_fieldCount];
+}
+
+
+////////////////////////////////////////////////////////////
+const Uint32* Snapshot::getValuesAt(std::size_t index) const
+{
+    return &m_values[index * m_fieldCount];
+}
+
+} // namespace TGE
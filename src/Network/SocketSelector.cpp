@@ -9,7 +9,15 @@
 #include <Tyrant/Network/Socket.hpp>
 #include <Tyrant/Network/SocketImpl.hpp>
 #include <Tyrant/System/Log.hpp>
+#include <algorithm>
 #include <utility>
+#include <vector>
+
+#if defined(OS_LINUX)
+    #include <sys/epoll.h>
+    #include <sys/eventfd.h>
+    #include <errno.h>
+#endif
 
 #ifdef _MSC_VER
     #pragma warning(disable : 4127) // "conditional expression is constant" generated by the FD_SET macro
@@ -18,20 +26,488 @@
 
 namespace TGE
 {
+#if defined(OS_LINUX)
+
 ////////////////////////////////////////////////////////////
 struct SocketSelector::SocketSelectorImpl
 {
-    fd_set AllSockets;   ///< Set containing all the sockets handles
-    fd_set SocketsReady; ///< Set containing handles of the sockets that are ready
-    int    MaxSocket;    ///< Maximum socket handle
+    struct Entry
+    {
+        Socket*      socket;    ///< Socket registered with this handle, NULL if none
+        unsigned int readiness; ///< Readiness watched for the socket
+        unsigned int ready;     ///< Readiness reported by the last wait
+    };
+
+    struct ReadySocket
+    {
+        Socket*      socket;    ///< Socket found ready
+        unsigned int readiness; ///< How it is ready
+        SocketHandle handle;    ///< Handle of the socket
+    };
+
+    SocketSelectorImpl(Trigger trigger) :
+    Epoll      (epoll_create(256)),
+    WakeUp     (eventfd(0, EFD_NONBLOCK)),
+    TriggerMode(trigger),
+    Count      (0)
+    {
+        if (Epoll < 0)
+            Log() << "Failed to create the epoll instance of a socket selector" << std::endl;
+
+        watchWakeUp();
+    }
+
+    SocketSelectorImpl(const SocketSelectorImpl& copy) :
+    Epoll      (epoll_create(256)),
+    WakeUp     (eventfd(0, EFD_NONBLOCK)),
+    TriggerMode(copy.TriggerMode),
+    Count      (0)
+    {
+        watchWakeUp();
+
+        for (std::vector<Entry>::const_iterator it = copy.Sockets.begin(); it != copy.Sockets.end(); ++it)
+        {
+            if (it->socket)
+                add(*it->socket, it->readiness);
+        }
+    }
+
+    ~SocketSelectorImpl()
+    {
+        if (Epoll >= 0)
+            ::close(Epoll);
+        if (WakeUp >= 0)
+            ::close(WakeUp);
+    }
+
+    // The wake-up handle is always watched, level-triggered, and isn't a socket
+    void watchWakeUp()
+    {
+        epoll_event event;
+        event.events  = EPOLLIN;
+        event.data.fd = WakeUp;
+
+        if ((Epoll >= 0) && ((WakeUp < 0) || (epoll_ctl(Epoll, EPOLL_CTL_ADD, WakeUp, &event) < 0)))
+            Log() << "Failed to create the wake-up handle of a socket selector (errno " << errno << ")" << std::endl;
+    }
+
+    void interrupt()
+    {
+        Uint64 one = 1;
+        if (write(WakeUp, &one, sizeof(one)) < 0)
+        {
+            // The counter is already signaled
+        }
+    }
+
+    void add(Socket& socket, unsigned int readiness)
+    {
+        SocketHandle handle = socket.getHandle();
+        if ((handle == priv::SocketImpl::invalidSocket()) || (Epoll < 0))
+            return;
+
+        if (static_cast<std::size_t>(handle) >= Sockets.size())
+        {
+            Entry empty = {NULL, 0, 0};
+            Sockets.resize(handle + 1, empty);
+        }
+
+        epoll_event event;
+        event.events  = ((readiness & Read) ? static_cast<uint32_t>(EPOLLIN) : 0u) |
+                        ((readiness & Write) ? static_cast<uint32_t>(EPOLLOUT) : 0u) |
+                        ((TriggerMode == EdgeTriggered) ? static_cast<uint32_t>(EPOLLET) : 0u);
+        event.data.fd = handle;
+
+        Entry& entry = Sockets[handle];
+        int operation = entry.socket ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
+
+        // The handle may still be registered if the previous socket using it
+        // was closed without being removed
+        if ((epoll_ctl(Epoll, operation, handle, &event) < 0) &&
+            ((errno != EEXIST) || (epoll_ctl(Epoll, EPOLL_CTL_MOD, handle, &event) < 0)) &&
+            ((errno != ENOENT) || (epoll_ctl(Epoll, EPOLL_CTL_ADD, handle, &event) < 0)))
+        {
+            Log() << "Failed to add a socket to a socket selector (errno " << errno << ")" << std::endl;
+            return;
+        }
+
+        if (!entry.socket)
+            Count++;
+
+        entry.socket    = &socket;
+        entry.readiness = readiness;
+    }
+
+    void remove(Socket& socket)
+    {
+        SocketHandle handle = socket.getHandle();
+        if ((handle == priv::SocketImpl::invalidSocket()) || (static_cast<std::size_t>(handle) >= Sockets.size()))
+            return;
+
+        Entry& entry = Sockets[handle];
+        if (entry.socket)
+        {
+            // Fails harmlessly if the socket was already closed
+            epoll_event event = epoll_event();
+            epoll_ctl(Epoll, EPOLL_CTL_DEL, handle, &event);
+
+            entry.socket    = NULL;
+            entry.readiness = 0;
+            entry.ready     = 0;
+            Count--;
+        }
+    }
+
+    void clear()
+    {
+        for (std::size_t handle = 0; handle < Sockets.size(); ++handle)
+        {
+            if (Sockets[handle].socket)
+            {
+                epoll_event event = epoll_event();
+                epoll_ctl(Epoll, EPOLL_CTL_DEL, static_cast<int>(handle), &event);
+            }
+        }
+
+        Sockets.clear();
+        Ready.clear();
+        Count = 0;
+    }
+
+    bool wait(Time timeout)
+    {
+        // Forget the result of the previous wait
+        for (std::vector<ReadySocket>::const_iterator it = Ready.begin(); it != Ready.end(); ++it)
+            Sockets[it->handle].ready = 0;
+        Ready.clear();
+
+        if (Epoll < 0)
+            return false;
+
+        if (Events.size() < Count + 1)
+            Events.resize(Count + 1);
+
+        // Round the timeout up, so that a short timeout doesn't turn into a busy loop
+        int milliseconds = timeout != Time::Zero ? static_cast<int>((timeout.asMicroseconds() + 999) / 1000) : -1;
+
+        int count = epoll_wait(Epoll, &Events[0], static_cast<int>(Events.size()), milliseconds);
+        for (int i = 0; i < count; ++i)
+        {
+            int handle = Events[i].data.fd;
+            if (handle == WakeUp)
+            {
+                // Reset the counter, the wait only had to return
+                Uint64 signals;
+                if (read(WakeUp, &signals, sizeof(signals)) < 0)
+                {
+                    // Another wait already reset it
+                }
+                continue;
+            }
+
+            if ((static_cast<std::size_t>(handle) >= Sockets.size()) || !Sockets[handle].socket)
+                continue;
+
+            // Errors and hang-ups are reported as readable, so that the
+            // next receive returns them
+            Entry& entry = Sockets[handle];
+            unsigned int events = Events[i].events;
+            unsigned int ready = 0;
+            if (events & (EPOLLIN | EPOLLERR | EPOLLHUP))
+                ready |= Read;
+            if ((events & (EPOLLOUT | EPOLLERR | EPOLLHUP)) && (entry.readiness & Write))
+                ready |= Write;
+
+            entry.ready = ready;
+            ReadySocket readySocket = {entry.socket, ready, handle};
+            Ready.push_back(readySocket);
+        }
+
+        return !Ready.empty();
+    }
+
+    unsigned int getReadiness(Socket& socket) const
+    {
+        SocketHandle handle = socket.getHandle();
+        if ((handle == priv::SocketImpl::invalidSocket()) || (static_cast<std::size_t>(handle) >= Sockets.size()))
+            return 0;
+
+        return Sockets[handle].ready;
+    }
+
+    int                      Epoll;       ///< Handle of the epoll instance
+    int                      WakeUp;      ///< Event counter signaled by interrupt, watched by the epoll instance
+    Trigger                  TriggerMode; ///< Level or edge triggered
+    std::vector<Entry>       Sockets;     ///< Registered sockets, indexed by handle
+    std::size_t              Count;       ///< Number of registered sockets
+    std::vector<epoll_event> Events;      ///< Buffer receiving the events of epoll_wait
+    std::vector<ReadySocket> Ready;       ///< Sockets found ready by the last wait
 };
 
+#else
 
 ////////////////////////////////////////////////////////////
-SocketSelector::SocketSelector() :
-m_impl(new SocketSelectorImpl)
+struct SocketSelector::SocketSelectorImpl
 {
-    clear();
+    struct Entry
+    {
+        Socket*      socket;    ///< Registered socket
+        SocketHandle handle;    ///< Its handle when it was added
+        unsigned int readiness; ///< Readiness watched for the socket
+    };
+
+    struct ReadySocket
+    {
+        Socket*      socket;    ///< Socket found ready
+        unsigned int readiness; ///< How it is ready
+    };
+
+    SocketSelectorImpl(Trigger) :
+    MaxSocket(0)
+    {
+        FD_ZERO(&AllSockets);
+        FD_ZERO(&SocketsReady);
+        FD_ZERO(&AllWriteSockets);
+        FD_ZERO(&SocketsReadyToWrite);
+
+        createWakeUp();
+    }
+
+    SocketSelectorImpl(const SocketSelectorImpl& copy) :
+    MaxSocket(copy.MaxSocket),
+    Sockets  (copy.Sockets)
+    {
+        AllSockets          = copy.AllSockets;
+        SocketsReady        = copy.SocketsReady;
+        AllWriteSockets     = copy.AllWriteSockets;
+        SocketsReadyToWrite = copy.SocketsReadyToWrite;
+
+        createWakeUp();
+    }
+
+    ~SocketSelectorImpl()
+    {
+    #if defined(OS_WINDOWS)
+        priv::SocketImpl::close(WakeUpReader);
+    #else
+        ::close(WakeUpReader);
+        ::close(WakeUpWriter);
+    #endif
+    }
+
+    // select() only watches sockets on Windows: the wake-up is a UDP socket
+    // connected to itself there, and a pipe elsewhere
+    void createWakeUp()
+    {
+        WakeUpReader = priv::SocketImpl::invalidSocket();
+        WakeUpWriter = priv::SocketImpl::invalidSocket();
+
+    #if defined(OS_WINDOWS)
+        SocketHandle handle = socket(PF_INET, SOCK_DGRAM, 0);
+        sockaddr_in address = priv::SocketImpl::createAddress(INADDR_LOOPBACK, 0);
+        priv::SocketImpl::AddrLength size = sizeof(address);
+        if ((handle == priv::SocketImpl::invalidSocket()) ||
+            (bind(handle, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) ||
+            (getsockname(handle, reinterpret_cast<sockaddr*>(&address), &size) != 0) ||
+            (connect(handle, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0))
+        {
+            if (handle != priv::SocketImpl::invalidSocket())
+                priv::SocketImpl::close(handle);
+
+            Log() << "Failed to create the wake-up socket of a socket selector" << std::endl;
+            return;
+        }
+
+        WakeUpReader = handle;
+        WakeUpWriter = handle;
+    #else
+        int handles[2];
+        if (pipe(handles) != 0)
+        {
+            Log() << "Failed to create the wake-up pipe of a socket selector" << std::endl;
+            return;
+        }
+
+        WakeUpReader = handles[0];
+        WakeUpWriter = handles[1];
+    #endif
+
+        priv::SocketImpl::setBlocking(WakeUpReader, false);
+        priv::SocketImpl::setBlocking(WakeUpWriter, false);
+    }
+
+    void interrupt()
+    {
+        char signal = 0;
+    #if defined(OS_WINDOWS)
+        send(WakeUpWriter, &signal, 1, 0);
+    #else
+        if (write(WakeUpWriter, &signal, 1) < 0)
+        {
+            // The pipe is already full of signals
+        }
+    #endif
+    }
+
+    // Read all the pending signals, so that the next wait blocks again
+    void drainWakeUp()
+    {
+        char signals[64];
+    #if defined(OS_WINDOWS)
+        while (recv(WakeUpReader, signals, sizeof(signals), 0) > 0) {}
+    #else
+        while (read(WakeUpReader, signals, sizeof(signals)) > 0) {}
+    #endif
+    }
+
+    void add(Socket& socket, unsigned int readiness)
+    {
+        SocketHandle handle = socket.getHandle();
+        if (handle == priv::SocketImpl::invalidSocket())
+            return;
+
+        std::vector<Entry>::iterator it = Sockets.begin();
+        while ((it != Sockets.end()) && (it->handle != handle))
+            ++it;
+
+        if (it == Sockets.end())
+        {
+        #if defined(OS_WINDOWS)
+            if (AllSockets.fd_count >= FD_SETSIZE - 1)
+        #else
+            if (handle >= FD_SETSIZE)
+        #endif
+            {
+                Log() << "The socket can't be added to the selector because its "
+                      << "handle exceeds FD_SETSIZE (" << FD_SETSIZE << ")" << std::endl;
+                return;
+            }
+
+            Entry entry = {&socket, handle, readiness};
+            Sockets.push_back(entry);
+        }
+        else
+        {
+            it->socket    = &socket;
+            it->readiness = readiness;
+        }
+
+        // The read set always contains all the sockets, so that select()
+        // reports errors on sockets only watched for writing too
+        FD_SET(handle, &AllSockets);
+        if (readiness & Write)
+            FD_SET(handle, &AllWriteSockets);
+        else
+            FD_CLR(handle, &AllWriteSockets);
+
+        int size = static_cast<int>(handle);
+        if (size > MaxSocket)
+            MaxSocket = size;
+    }
+
+    void remove(Socket& socket)
+    {
+        SocketHandle handle = socket.getHandle();
+
+        FD_CLR(handle, &AllSockets);
+        FD_CLR(handle, &SocketsReady);
+        FD_CLR(handle, &AllWriteSockets);
+        FD_CLR(handle, &SocketsReadyToWrite);
+
+        for (std::vector<Entry>::iterator it = Sockets.begin(); it != Sockets.end(); ++it)
+        {
+            if (it->handle == handle)
+            {
+                Sockets.erase(it);
+                break;
+            }
+        }
+    }
+
+    void clear()
+    {
+        FD_ZERO(&AllSockets);
+        FD_ZERO(&SocketsReady);
+        FD_ZERO(&AllWriteSockets);
+        FD_ZERO(&SocketsReadyToWrite);
+
+        MaxSocket = 0;
+        Sockets.clear();
+        Ready.clear();
+    }
+
+    bool wait(Time timeout)
+    {
+        // Setup the timeout
+        timeval time;
+        time.tv_sec  = static_cast<long>(timeout.asMicroseconds() / 1000000);
+        time.tv_usec = static_cast<long>(timeout.asMicroseconds() % 1000000);
+
+        // Initialize the sets that will contain the sockets that are ready
+        SocketsReady = AllSockets;
+        SocketsReadyToWrite = AllWriteSockets;
+        Ready.clear();
+
+        // The wake-up handle is watched too, without being a socket of the selector
+        int maxSocket = MaxSocket;
+        if (WakeUpReader != priv::SocketImpl::invalidSocket())
+        {
+            FD_SET(WakeUpReader, &SocketsReady);
+            maxSocket = std::max(maxSocket, static_cast<int>(WakeUpReader));
+        }
+
+        // Wait until one of the sockets is ready, or timeout is reached
+        int count = select(maxSocket + 1, &SocketsReady, &SocketsReadyToWrite, NULL, timeout != Time::Zero ? &time : NULL);
+        if (count <= 0)
+        {
+            FD_ZERO(&SocketsReady);
+            FD_ZERO(&SocketsReadyToWrite);
+            return false;
+        }
+
+        if ((WakeUpReader != priv::SocketImpl::invalidSocket()) && FD_ISSET(WakeUpReader, &SocketsReady))
+        {
+            drainWakeUp();
+            FD_CLR(WakeUpReader, &SocketsReady);
+        }
+
+        for (std::vector<Entry>::const_iterator it = Sockets.begin(); it != Sockets.end(); ++it)
+        {
+            unsigned int ready = (FD_ISSET(it->handle, &SocketsReady) ? Read : 0) | (FD_ISSET(it->handle, &SocketsReadyToWrite) ? Write : 0);
+            if (ready)
+            {
+                ReadySocket readySocket = {it->socket, ready};
+                Ready.push_back(readySocket);
+            }
+        }
+
+        return !Ready.empty();
+    }
+
+    unsigned int getReadiness(Socket& socket) const
+    {
+        return (FD_ISSET(socket.getHandle(), &SocketsReady) ? Read : 0) | (FD_ISSET(socket.getHandle(), &SocketsReadyToWrite) ? Write : 0);
+    }
+
+    fd_set                   AllSockets;          ///< Set containing all the sockets handles
+    fd_set                   SocketsReady;        ///< Set containing handles of the sockets that are ready to read
+    fd_set                   AllWriteSockets;     ///< Set containing the handles of the sockets watched for writing
+    fd_set                   SocketsReadyToWrite; ///< Set containing handles of the sockets that are ready to write
+    int                      MaxSocket;           ///< Maximum socket handle
+    std::vector<Entry>       Sockets;             ///< Registered sockets
+    std::vector<ReadySocket> Ready;               ///< Sockets found ready by the last wait
+    SocketHandle             WakeUpReader;        ///< Handle watched for the signals of interrupt
+    SocketHandle             WakeUpWriter;        ///< Handle to which interrupt writes its signals
+};
+
+#endif
+
+
+////////////////////////////////////////////////////////////
+SocketSelector::SocketSelector(Trigger trigger) :
+m_impl(new SocketSelectorImpl(trigger))
+{
+
 }
 
 
@@ -51,60 +527,72 @@ SocketSelector::~SocketSelector()
 
 
 ////////////////////////////////////////////////////////////
-void SocketSelector::add(Socket& socket)
+void SocketSelector::add(Socket& socket, unsigned int readiness)
 {
-    SocketHandle handle = socket.getHandle();
-    if (handle != priv::SocketImpl::invalidSocket())
-    {
-        FD_SET(handle, &m_impl->AllSockets);
-
-        int size = static_cast<int>(handle);
-        if (size > m_impl->MaxSocket)
-            m_impl->MaxSocket = size;
-    }
+    m_impl->add(socket, readiness);
 }
 
 
 ////////////////////////////////////////////////////////////
 void SocketSelector::remove(Socket& socket)
 {
-    FD_CLR(socket.getHandle(), &m_impl->AllSockets);
-    FD_CLR(socket.getHandle(), &m_impl->SocketsReady);
+    m_impl->remove(socket);
 }
 
 
 ////////////////////////////////////////////////////////////
 void SocketSelector::clear()
 {
-    FD_ZERO(&m_impl->AllSockets);
-    FD_ZERO(&m_impl->SocketsReady);
-
-    m_impl->MaxSocket = 0;
+    m_impl->clear();
 }
 
 
 ////////////////////////////////////////////////////////////
 bool SocketSelector::wait(Time timeout)
 {
-    // Setup the timeout
-    timeval time;
-    time.tv_sec  = static_cast<long>(timeout.asMicroseconds() / 1000000);
-    time.tv_usec = static_cast<long>(timeout.asMicroseconds() % 1000000);
-
-    // Initialize the set that will contain the sockets that are ready
-    m_impl->SocketsReady = m_impl->AllSockets;
+    return m_impl->wait(timeout);
+}
 
-    // Wait until one of the sockets is ready for reading, or timeout is reached
-    int count = select(m_impl->MaxSocket + 1, &m_impl->SocketsReady, NULL, NULL, timeout != Time::Zero ? &time : NULL);
 
-    return count > 0;
+////////////////////////////////////////////////////////////
+void SocketSelector::interrupt()
+{
+    m_impl->interrupt();
 }
 
 
 ////////////////////////////////////////////////////////////
 bool SocketSelector::isReady(Socket& socket) const
 {
-    return FD_ISSET(socket.getHandle(), &m_impl->SocketsReady) != 0;
+    return (m_impl->getReadiness(socket) & Read) != 0;
+}
+
+
+////////////////////////////////////////////////////////////
+bool SocketSelector::isReadyToWrite(Socket& socket) const
+{
+    return (m_impl->getReadiness(socket) & Write) != 0;
+}
+
+
+////////////////////////////////////////////////////////////
+std::size_t SocketSelector::getReadyCount() const
+{
+    return m_impl->Ready.size();
+}
+
+
+////////////////////////////////////////////////////////////
+Socket& SocketSelector::getReadySocket(std::size_t index) const
+{
+    return *m_impl->Ready[index].socket;
+}
+
+
+////////////////////////////////////////////////////////////
+unsigned int SocketSelector::getReadiness(std::size_t index) const
+{
+    return m_impl->Ready[index].readiness;
 }
 
 
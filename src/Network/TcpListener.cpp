@@ -46,6 +46,14 @@ Socket::Status TcpListener::listen(unsigned short port)
     // Create the internal socket if it doesn't exist
     create();
 
+#if !defined(OS_WINDOWS)
+    // A server that closes its connections first leaves them waiting on its
+    // port for a while: allow it to listen there again at once (on Windows,
+    // SO_REUSEADDR would let another socket take a port in use instead)
+    int yes = 1;
+    setsockopt(getHandle(), SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+#endif
+
     // Bind the socket to the specified port
     sockaddr_in address = priv::SocketImpl::createAddress(INADDR_ANY, port);
     if (bind(getHandle(), reinterpret_cast<sockaddr*>(&address), sizeof(address)) == -1)
@@ -55,8 +63,8 @@ Socket::Status TcpListener::listen(unsigned short port)
         return Error;
     }
 
-    // Listen to the bound port
-    if (::listen(getHandle(), 0) == -1)
+    // Listen to the bound port, with a queue long enough for many clients connecting at once
+    if (::listen(getHandle(), SOMAXCONN) == -1)
     {
         // Oops, socket is deaf
         Log() << "Failed to listen to port " << port << std::endl;
@@ -97,6 +105,7 @@ Socket::Status TcpListener::accept(TcpSocket& socket)
     // Initialize the new connected socket
     socket.close();
     socket.create(remote);
+    socket.resetPendingData();
 
     return Done;
 }
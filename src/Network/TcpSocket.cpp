@@ -26,18 +26,39 @@ namespace
     #else
         const int flags = 0;
     #endif
+
+    // Maximum number of packets sent by a single system call
+    const std::size_t maxPacketsPerSend = 64;
+
+    // Initial size of the receive buffer, it grows to fit bigger packets
+    const std::size_t receiveBufferSize = 64 * 1024;
+
+    // Biggest packet accepted by default, a peer announcing a bigger one is disconnected
+    const std::size_t defaultMaxPacketSize = 16 * 1024 * 1024;
 }
 
 namespace TGE
 {
 ////////////////////////////////////////////////////////////
 TcpSocket::TcpSocket() :
-Socket(Tcp)
+Socket         (Tcp),
+m_receiveBegin (0),
+m_receiveEnd   (0),
+m_sendOffset   (0),
+m_maxPacketSize(defaultMaxPacketSize)
 {
 
 }
 
 
+////////////////////////////////////////////////////////////
+TcpSocket::~TcpSocket()
+{
+    for (std::vector<Packet*>::iterator it = m_packetPool.begin(); it != m_packetPool.end(); ++it)
+        delete *it;
+}
+
+
 ////////////////////////////////////////////////////////////
 unsigned short TcpSocket::getLocalPort() const
 {
@@ -95,6 +116,20 @@ unsigned short TcpSocket::getRemotePort() const
 }
 
 
+////////////////////////////////////////////////////////////
+void TcpSocket::setMaxPacketSize(std::size_t size)
+{
+    m_maxPacketSize = size;
+}
+
+
+////////////////////////////////////////////////////////////
+std::size_t TcpSocket::getMaxPacketSize() const
+{
+    return m_maxPacketSize;
+}
+
+
 ////////////////////////////////////////////////////////////
 Socket::Status TcpSocket::connect(const IpAddress& remoteAddress, unsigned short remotePort, Time timeout)
 {
@@ -192,13 +227,27 @@ void TcpSocket::disconnect()
     close();
 
     // Reset the pending packet data
-    m_pendingPacket = PendingPacket();
+    resetPendingData();
 }
 
 
 ////////////////////////////////////////////////////////////
 Socket::Status TcpSocket::send(const void* data, std::size_t size)
 {
+    if (!isBlocking())
+        Log() << "Warning: Partial sends might not be handled properly." << std::endl;
+
+    std::size_t sent;
+
+    return send(data, size, sent);
+}
+
+
+////////////////////////////////////////////////////////////
+Socket::Status TcpSocket::send(const void* data, std::size_t size, std::size_t& sent)
+{
+    sent = 0;
+
     // Check the parameters
     if (!data || (size == 0))
     {
@@ -207,16 +256,22 @@ Socket::Status TcpSocket::send(const void* data, std::size_t size)
     }
 
     // Loop until every byte has been sent
-    int sent = 0;
-    int sizeToSend = static_cast<int>(size);
-    for (int length = 0; length < sizeToSend; length += sent)
+    int result = 0;
+    for (sent = 0; sent < size; sent += result)
     {
         // Send a chunk of data
-        sent = ::send(getHandle(), static_cast<const char*>(data) + length, sizeToSend - length, flags);
+        result = ::send(getHandle(), static_cast<const char*>(data) + sent, static_cast<int>(size - sent), flags);
 
         // Check for errors
-        if (sent < 0)
-            return priv::SocketImpl::getErrorStatus();
+        if (result < 0)
+        {
+            Status status = priv::SocketImpl::getErrorStatus();
+
+            if ((status == NotReady) && (sent > 0))
+                return Partial;
+
+            return status;
+        }
     }
 
     return Done;
@@ -236,6 +291,15 @@ Socket::Status TcpSocket::receive(void* data, std::size_t size, std::size_t& rec
         return Error;
     }
 
+    // Hand out the bytes already buffered first
+    if (m_receiveBegin < m_receiveEnd)
+    {
+        received = std::min(size, m_receiveEnd - m_receiveBegin);
+        std::memcpy(data, &m_receiveBuffer[m_receiveBegin], received);
+        m_receiveBegin += received;
+        return Done;
+    }
+
     // Receive a chunk of bytes
     int sizeReceived = recv(getHandle(), static_cast<char*>(data), static_cast<int>(size), flags);
 
@@ -258,33 +322,105 @@ Socket::Status TcpSocket::receive(void* data, std::size_t size, std::size_t& rec
 
 ////////////////////////////////////////////////////////////
 Socket::Status TcpSocket::send(Packet& packet)
+{
+    return send(&packet, 1);
+}
+
+
+////////////////////////////////////////////////////////////
+Socket::Status TcpSocket::send(Packet* packets, std::size_t count)
 {
     // TCP is a stream protocol, it doesn't preserve messages boundaries.
-    // This means that we have to send the packet size first, so that the
-    // receiver knows the actual end of the packet in the data stream.
+    // This means that we have to send the size of each packet first, so
+    // that the receiver knows the actual end of the packet in the data stream.
+
+    // The sizes and the data are gathered by the system from where they
+    // are, so nothing is copied, and a group of packets only costs one
+    // call. The bytes already sent by a previous partial send are skipped.
+    Uint32 sizes[maxPacketsPerSend];
+    const char* blocks[maxPacketsPerSend * 2];
+    std::size_t blockSizes[maxPacketsPerSend * 2];
+    priv::SocketImpl::IoBuffer buffers[maxPacketsPerSend * 2];
+
+    std::size_t skip = m_sendOffset;
+    for (std::size_t first = 0; first < count; first += maxPacketsPerSend)
+    {
+        std::size_t groupCount = std::min(count - first, maxPacketsPerSend);
+        std::size_t groupSize = 0;
 
-    // We allocate an extra memory block so that the size can be sent
-    // together with the data in a single call. This may seem inefficient,
-    // but it is actually required to avoid partial send, which could cause
-    // data corruption on the receiving end.
+        // Gather the size and the data of each packet of the group
+        for (std::size_t i = 0; i < groupCount; ++i)
+        {
+            std::size_t size = 0;
+            const void* data = packets[first + i].onSend(size);
 
-    // Get the data to send from the packet
-    std::size_t size = 0;
-    const void* data = packet.onSend(size);
+            // Convert the packet size to network byte order
+            sizes[i] = htonl(static_cast<Uint32>(size));
 
-    // First convert the packet size to network byte order
-    Uint32 packetSize = htonl(static_cast<Uint32>(size));
+            blocks[i * 2]         = reinterpret_cast<const char*>(&sizes[i]);
+            blockSizes[i * 2]     = sizeof(sizes[i]);
+            blocks[i * 2 + 1]     = static_cast<const char*>(data);
+            blockSizes[i * 2 + 1] = size;
+            groupSize += sizeof(sizes[i]) + size;
+        }
 
-    // Allocate memory for the data block to send
-    std::vector<char> blockToSend(sizeof(packetSize) + size);
+        // Skip the groups which were entirely sent by the previous call
+        if (skip >= groupSize)
+        {
+            skip -= groupSize;
+            continue;
+        }
 
-    // Copy the packet size and data into the block to send
-    std::memcpy(&blockToSend[0], &packetSize, sizeof(packetSize));
-    if (size > 0)
-        std::memcpy(&blockToSend[0] + sizeof(packetSize), data, size);
+        // Loop until the whole group has been sent
+        std::size_t block = 0;
+        std::size_t blockCount = groupCount * 2;
+        std::size_t remaining = groupSize;
+        while (remaining > 0)
+        {
+            // Drop the bytes already sent from the front of the blocks
+            while (skip > 0)
+            {
+                std::size_t length = std::min(skip, blockSizes[block]);
+                blocks[block] += length;
+                blockSizes[block] -= length;
+                remaining -= length;
+                skip -= length;
+                if (blockSizes[block] == 0)
+                    block++;
+            }
+
+            std::size_t bufferCount = 0;
+            for (std::size_t i = block; i < blockCount; ++i)
+            {
+                if (blockSizes[i] > 0)
+                    priv::SocketImpl::setIoBuffer(buffers[bufferCount++], blocks[i], blockSizes[i]);
+            }
+
+            if (bufferCount == 0)
+                break;
 
-    // Send the data block
-    return send(&blockToSend[0], blockToSend.size());
+            // Send as much as possible
+            int sent = priv::SocketImpl::sendBuffers(getHandle(), buffers, bufferCount, flags);
+            if (sent < 0)
+            {
+                Status status = priv::SocketImpl::getErrorStatus();
+
+                // The packets must be sent again to finish the job
+                if (status == NotReady)
+                    return m_sendOffset > 0 ? Partial : NotReady;
+
+                m_sendOffset = 0;
+                return status;
+            }
+
+            m_sendOffset += static_cast<std::size_t>(sent);
+            skip = static_cast<std::size_t>(sent);
+        }
+    }
+
+    m_sendOffset = 0;
+
+    return Done;
 }
 
 
@@ -294,69 +430,164 @@ Socket::Status TcpSocket::receive(Packet& packet)
     // First clear the variables to fill
     packet.clear();
 
-    // We start by getting the size of the incoming packet
-    Uint32 packetSize = 0;
-    std::size_t received = 0;
-    if (m_pendingPacket.SizeReceived < sizeof(m_pendingPacket.Size))
+    // Loop until a whole packet has been received
+    const char* data = NULL;
+    std::size_t size = 0;
+    while (!extractPacket(data, size))
     {
-        // Loop until we've received the entire size of the packet
-        // (even a 4 byte variable may be received in more than one call)
-        while (m_pendingPacket.SizeReceived < sizeof(m_pendingPacket.Size))
+        Status status = fillReceiveBuffer();
+        if (status != Done)
+            return status;
+    }
+
+    // Copy the data to the user packet
+    if (size > 0)
+        packet.onReceive(data, size);
+
+    return Done;
+}
+
+
+////////////////////////////////////////////////////////////
+Socket::Status TcpSocket::receive(std::vector<Packet*>& packets)
+{
+    packets.clear();
+
+    for (;;)
+    {
+        // Read what is available, unless a complete packet is already
+        // buffered and reading could block
+        Status status = Done;
+        const char* data = NULL;
+        std::size_t size = 0;
+        bool extracted = isBlocking() && extractPacket(data, size);
+        if (!extracted)
+            status = fillReceiveBuffer();
+
+        // Make a packet of each complete frame, pointing into the buffer
+        while (extracted || extractPacket(data, size))
         {
-            char* data = reinterpret_cast<char*>(&m_pendingPacket.Size) + m_pendingPacket.SizeReceived;
-            Status status = receive(data, sizeof(m_pendingPacket.Size) - m_pendingPacket.SizeReceived, received);
-            m_pendingPacket.SizeReceived += received;
+            if (packets.size() == m_packetPool.size())
+                m_packetPool.push_back(new Packet);
 
-            if (status != Done)
-                return status;
+            Packet* packet = m_packetPool[packets.size()];
+            packet->setView(data, size);
+            packets.push_back(packet);
+            extracted = false;
         }
 
-        // The packet size has been fully received
-        packetSize = ntohl(m_pendingPacket.Size);
+        if (!packets.empty())
+            return Done;
+
+        // Only part of a packet was received: wait for the rest in blocking mode
+        if (status != Done)
+            return status;
+        else if (!isBlocking())
+            return NotReady;
     }
-    else
+}
+
+
+////////////////////////////////////////////////////////////
+void TcpSocket::resetPendingData()
+{
+    m_receiveBegin = 0;
+    m_receiveEnd = 0;
+    m_sendOffset = 0;
+}
+
+
+////////////////////////////////////////////////////////////
+Socket::Status TcpSocket::fillReceiveBuffer()
+{
+    // Move the bytes not extracted yet to the front of the buffer,
+    // so that a packet is always stored contiguously
+    if (m_receiveBegin > 0)
     {
-        // The packet size has already been received in a previous call
-        packetSize = ntohl(m_pendingPacket.Size);
+        if (m_receiveBegin < m_receiveEnd)
+            std::memmove(&m_receiveBuffer[0], &m_receiveBuffer[m_receiveBegin], m_receiveEnd - m_receiveBegin);
+
+        m_receiveEnd -= m_receiveBegin;
+        m_receiveBegin = 0;
     }
 
-    // Loop until we receive all the packet data
-    char buffer[1024];
-    while (m_pendingPacket.Data.size() < packetSize)
+    // Make room for the packet being received if its size is known,
+    // growing with the bytes actually received rather than trusting the
+    // announced size, which could be anything
+    std::size_t capacity = receiveBufferSize;
+    if (m_receiveEnd >= sizeof(Uint32))
     {
-        // Receive a chunk of data
-        std::size_t sizeToGet = std::min(static_cast<std::size_t>(packetSize - m_pendingPacket.Data.size()), sizeof(buffer));
-        Status status = receive(buffer, sizeToGet, received);
-        if (status != Done)
-            return status;
+        Uint32 packetSize;
+        std::memcpy(&packetSize, &m_receiveBuffer[0], sizeof(packetSize));
+        packetSize = ntohl(packetSize);
 
-        // Append it into the packet
-        if (received > 0)
+        if (packetSize > m_maxPacketSize)
         {
-            m_pendingPacket.Data.resize(m_pendingPacket.Data.size() + received);
-            char* begin = &m_pendingPacket.Data[0] + m_pendingPacket.Data.size() - received;
-            std::memcpy(begin, buffer, received);
+            Log() << "Closing a TCP connection whose peer sent a packet of " << packetSize
+                  << " bytes (maximum is " << m_maxPacketSize << ")" << std::endl;
+            disconnect();
+            return Error;
         }
+
+        std::size_t total = sizeof(packetSize) + packetSize;
+        if (total > capacity)
+            capacity = std::min(total, std::max(m_receiveBuffer.size(), m_receiveEnd * 2));
     }
 
-    // We have received all the packet data: we can copy it to the user packet
-    if (!m_pendingPacket.Data.empty())
-        packet.onReceive(&m_pendingPacket.Data[0], m_pendingPacket.Data.size());
+    if (m_receiveBuffer.size() < capacity)
+    {
+        m_receiveBuffer.resize(capacity);
+    }
+    else if ((m_receiveBuffer.size() > receiveBufferSize) && (capacity == receiveBufferSize) && (m_receiveEnd <= receiveBufferSize))
+    {
+        // Give back the memory of a big packet once it has been extracted
+        std::vector<char>(m_receiveBuffer.begin(), m_receiveBuffer.begin() + receiveBufferSize).swap(m_receiveBuffer);
+    }
 
-    // Clear the pending packet data
-    m_pendingPacket = PendingPacket();
+    // A single large read takes everything the system has buffered
+    std::size_t space = m_receiveBuffer.size() - m_receiveEnd;
+    if (space == 0)
+        return Done;
 
-    return Done;
+    int sizeReceived = recv(getHandle(), &m_receiveBuffer[m_receiveEnd], static_cast<int>(space), flags);
+
+    if (sizeReceived > 0)
+    {
+        m_receiveEnd += static_cast<std::size_t>(sizeReceived);
+        return Done;
+    }
+    else if (sizeReceived == 0)
+    {
+        return Socket::Disconnected;
+    }
+    else
+    {
+        return priv::SocketImpl::getErrorStatus();
+    }
 }
 
 
 ////////////////////////////////////////////////////////////
-TcpSocket::PendingPacket::PendingPacket() :
-Size        (0),
-SizeReceived(0),
-Data        ()
+bool TcpSocket::extractPacket(const char*& data, std::size_t& size)
 {
+    // TCP doesn't preserve messages boundaries: each packet is preceded by its size
+    std::size_t available = m_receiveEnd - m_receiveBegin;
+    if (available < sizeof(Uint32))
+        return false;
+
+    Uint32 packetSize;
+    std::memcpy(&packetSize, &m_receiveBuffer[m_receiveBegin], sizeof(packetSize));
+    packetSize = ntohl(packetSize);
+
+    // A packet too big is never handed out, even if it arrived whole: the next fill closes the connection
+    if ((packetSize > m_maxPacketSize) || (available - sizeof(packetSize) < packetSize))
+        return false;
+
+    data = &m_receiveBuffer[m_receiveBegin] + sizeof(packetSize);
+    size = packetSize;
+    m_receiveBegin += sizeof(packetSize) + packetSize;
 
+    return true;
 }
 
 } // namespace TGE
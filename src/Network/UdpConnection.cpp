@@ -0,0 +1,605 @@
+/*************************************/
+/** Copyright © 2014 Coldsnap Games **/
+/*************************************/
+
+/*************************************/
+/**             Headers             **/
+/*************************************/
+#include <Tyrant/Network/UdpConnection.hpp>
+#include <Tyrant/Network/LinkConditioner.hpp>
+#include <Tyrant/Network/UdpSocket.hpp>
+#include <Tyrant/System/Log.hpp>
+#include <algorithm>
+
+
+namespace
+{
+    // Identifies the datagrams sent by a connection
+    const TGE::Uint32 protocolId = 0x54474531;
+
+    // Size of the header of a datagram: protocol, sequence, flags, ack and ack bits
+    const std::size_t headerSize = 4 + 2 + 1 + 2 + 4;
+
+    // Maximum size of a datagram, small enough to never be fragmented by IP
+    const std::size_t maxDatagramSize = 1200;
+
+    // Flag of the header telling that the ack fields are valid
+    const TGE::Uint8 hasAckFlag = 0x01;
+
+    // Flag of a message telling that it is a fragment
+    const TGE::Uint8 fragmentFlag = 0x80;
+
+    // Maximum delay between two datagrams, so that the remote peer gets acks
+    const TGE::Int64 keepAliveInterval = 100000;
+
+    // Bounds of the retransmission timeout
+    const TGE::Int64 minRetransmissionTimeout = 30000;
+    const TGE::Int64 maxRetransmissionTimeout = 2000000;
+
+    // Bounds of the send rate, in bytes per second
+    const double minSendRate     = 8 * 1024;
+    const double initialSendRate = 64 * 1024;
+
+    // Read big-endian values written by TGE::Packet
+    TGE::Uint8 readUint8(const char*& cursor)
+    {
+        return static_cast<TGE::Uint8>(*cursor++);
+    }
+
+    TGE::Uint16 readUint16(const char*& cursor)
+    {
+        TGE::Uint16 high = readUint8(cursor);
+        TGE::Uint16 low  = readUint8(cursor);
+        return static_cast<TGE::Uint16>((high << 8) | low);
+    }
+
+    TGE::Uint32 readUint32(const char*& cursor)
+    {
+        TGE::Uint32 high = readUint16(cursor);
+        TGE::Uint32 low  = readUint16(cursor);
+        return (high << 16) | low;
+    }
+
+    // Compare sequence numbers which wrap around
+    bool isNewer(TGE::Uint16 sequence, TGE::Uint16 reference)
+    {
+        return (sequence != reference) && (static_cast<TGE::Uint16>(sequence - reference) < 0x8000);
+    }
+}
+
+namespace TGE
+{
+////////////////////////////////////////////////////////////
+UdpConnection::UdpConnection(UdpSocket& socket, const IpAddress& remoteAddress, unsigned short remotePort) :
+m_socket            (socket),
+m_conditioner       (NULL),
+m_remoteAddress     (remoteAddress),
+m_remotePort        (remotePort),
+m_clock             (),
+m_lastUpdate        (0),
+m_lastSend          (0),
+m_lastReceive       (0),
+m_timeout           (seconds(10).asMicroseconds()),
+m_localSequence     (0),
+m_remoteSequence    (0),
+m_receivedAny       (false),
+m_ackPending        (false),
+m_sentDatagrams     (DatagramWindow),
+m_receivedSequences (DatagramWindow, -1),
+m_reliableQueue     (),
+m_unreliableQueue   (),
+m_nextReliableId    (0),
+m_nextUnreliableId  (0),
+m_incomingReliable  (MessageWindow),
+m_expectedReliableId(0),
+m_lastSequencedId   (0),
+m_sequencedReceived (false),
+m_received          (),
+m_datagram          (),
+m_datagramMessages  (0),
+m_roundTripTime     (100000),
+m_roundTripVariation(50000),
+m_packetLoss        (0.f),
+m_sendRate          (initialSendRate),
+m_maxSendRate       (256 * 1024),
+m_sendBudget        (0),
+m_lastRateDecrease  (0)
+{
+    for (std::vector<SentDatagram>::iterator it = m_sentDatagrams.begin(); it != m_sentDatagrams.end(); ++it)
+        it->valid = false;
+
+    for (std::vector<IncomingMessage>::iterator it = m_incomingReliable.begin(); it != m_incomingReliable.end(); ++it)
+        it->valid = false;
+
+    for (int i = 0; i < 2; ++i)
+    {
+        m_reassembly[i].id = 0;
+        m_reassembly[i].received = 0;
+    }
+}
+
+
+////////////////////////////////////////////////////////////
+const IpAddress& UdpConnection::getRemoteAddress() const
+{
+    return m_remoteAddress;
+}
+
+
+////////////////////////////////////////////////////////////
+unsigned short UdpConnection::getRemotePort() const
+{
+    return m_remotePort;
+}
+
+
+////////////////////////////////////////////////////////////
+bool UdpConnection::send(Packet& packet, Channel channel)
+{
+    std::size_t size = 0;
+    const char* data = static_cast<const char*>(packet.onSend(size));
+
+    if (size > MaxMessageSize)
+    {
+        Log() << "Cannot send a message of " << size << " bytes over a UDP connection "
+              << "(greater than TGE::UdpConnection::MaxMessageSize)" << std::endl;
+        return false;
+    }
+
+    // Split the message into fragments which fit in a datagram
+    std::size_t fragmentCount = std::max<std::size_t>((size + MaxFragmentSize - 1) / MaxFragmentSize, 1);
+    Uint16 unreliableId = m_nextUnreliableId++;
+    for (std::size_t i = 0; i < fragmentCount; ++i)
+    {
+        OutgoingMessage message;
+        message.id            = (channel == ReliableOrdered) ? m_nextReliableId++ : unreliableId;
+        message.channel       = static_cast<Uint8>(channel);
+        message.fragmentIndex = static_cast<Uint8>(i);
+        message.fragmentCount = static_cast<Uint8>(fragmentCount);
+        message.acknowledged  = false;
+        message.lastSent      = -1;
+
+        std::size_t begin = i * MaxFragmentSize;
+        std::size_t end = std::min(begin + MaxFragmentSize, size);
+        message.data.assign(data + begin, data + end);
+
+        if (channel == ReliableOrdered)
+            m_reliableQueue.push_back(message);
+        else
+            m_unreliableQueue.push_back(message);
+    }
+
+    return true;
+}
+
+
+////////////////////////////////////////////////////////////
+bool UdpConnection::receive(Packet& packet)
+{
+    if (m_received.empty())
+        return false;
+
+    packet.clear();
+    if (!m_received.front().empty())
+        packet.onReceive(&m_received.front()[0], m_received.front().size());
+
+    m_received.pop_front();
+
+    return true;
+}
+
+
+////////////////////////////////////////////////////////////
+bool UdpConnection::processDatagram(const Packet& datagram)
+{
+    const char* cursor = static_cast<const char*>(datagram.getData());
+    const char* end = cursor + datagram.getDataSize();
+
+    if ((datagram.getDataSize() < headerSize) || (readUint32(cursor) != protocolId))
+        return false;
+
+    Int64 now = m_clock.getElapsedTime().asMicroseconds();
+
+    Uint16 sequence = readUint16(cursor);
+    Uint8  flags    = readUint8(cursor);
+    Uint16 ack      = readUint16(cursor);
+    Uint32 ackBits  = readUint32(cursor);
+
+    // Ignore the datagrams too old to be acknowledged, and the duplicates
+    Int32& received = m_receivedSequences[sequence % DatagramWindow];
+    if ((m_receivedAny && (static_cast<Uint16>(m_remoteSequence - sequence) >= DatagramWindow) && !isNewer(sequence, m_remoteSequence)) ||
+        (received == sequence))
+        return true;
+
+    received = sequence;
+    if (!m_receivedAny || isNewer(sequence, m_remoteSequence))
+        m_remoteSequence = sequence;
+
+    m_receivedAny = true;
+    m_ackPending = true;
+    m_lastReceive = now;
+
+    // Handle the acknowledgements of our datagrams
+    if (flags & hasAckFlag)
+    {
+        acknowledge(ack, now);
+        for (Uint16 i = 0; i < 32; ++i)
+        {
+            if (ackBits & (1u << i))
+                acknowledge(static_cast<Uint16>(ack - 1 - i), now);
+        }
+    }
+
+    // Read the messages
+    while (cursor < end)
+    {
+        if (end - cursor < 5)
+            return false;
+
+        Uint8 channel = readUint8(cursor);
+        Uint16 id = readUint16(cursor);
+        Uint8 fragmentIndex = 0;
+        Uint8 fragmentCount = 1;
+        if (channel & fragmentFlag)
+        {
+            if (end - cursor < 4)
+                return false;
+
+            fragmentIndex = readUint8(cursor);
+            fragmentCount = readUint8(cursor);
+        }
+
+        Uint16 size = readUint16(cursor);
+        channel &= ~fragmentFlag;
+        if ((channel > ReliableOrdered) || (size > end - cursor) || (fragmentIndex >= fragmentCount))
+            return false;
+
+        processMessage(channel, id, fragmentIndex, fragmentCount, cursor, size);
+        cursor += size;
+    }
+
+    deliverReliableMessages();
+
+    return true;
+}
+
+
+////////////////////////////////////////////////////////////
+Socket::Status UdpConnection::update()
+{
+    Int64 now = m_clock.getElapsedTime().asMicroseconds();
+
+    if (now - m_lastReceive > m_timeout)
+        return Socket::Disconnected;
+
+    // Earn the right to send more bytes, without allowing big bursts
+    m_sendBudget += m_sendRate * static_cast<double>(now - m_lastUpdate) / 1000000.0;
+    m_sendBudget = std::min(m_sendBudget, m_sendRate / 10 + maxDatagramSize);
+    m_lastUpdate = now;
+
+    // Let out the datagrams that made it through the link
+    if (m_conditioner)
+        m_conditioner->update();
+
+    // Datagrams not acknowledged in time are lost: slow down, at most once per round trip
+    Int64 lossTimeout = getRetransmissionTimeout() * 2;
+    for (std::vector<SentDatagram>::iterator it = m_sentDatagrams.begin(); it != m_sentDatagrams.end(); ++it)
+    {
+        if (it->valid && (now - it->time > lossTimeout))
+        {
+            it->valid = false;
+            m_packetLoss += (1.f - m_packetLoss) * 0.1f;
+
+            if (now - m_lastRateDecrease > m_roundTripTime)
+            {
+                m_sendRate = std::max(m_sendRate * 0.7, minSendRate);
+                m_lastRateDecrease = now;
+            }
+        }
+    }
+
+    Int64 retransmissionTimeout = getRetransmissionTimeout();
+    bool keepAlive = now - m_lastSend >= keepAliveInterval;
+    std::size_t reliableIndex = 0;
+    std::size_t unreliableIndex = 0;
+    Socket::Status status = Socket::Done;
+
+    for (;;)
+    {
+        // Write the header of the datagram
+        m_datagram.clear();
+        m_datagram << protocolId << m_localSequence << (m_receivedAny ? hasAckFlag : Uint8(0)) << m_remoteSequence;
+
+        Uint32 ackBits = 0;
+        for (Uint16 i = 0; i < 32; ++i)
+        {
+            Uint16 sequence = static_cast<Uint16>(m_remoteSequence - 1 - i);
+            if (m_receivedSequences[sequence % DatagramWindow] == sequence)
+                ackBits |= 1u << i;
+        }
+        m_datagram << ackBits;
+
+        SentDatagram& sent = m_sentDatagrams[m_localSequence % DatagramWindow];
+        sent.messageCount = 0;
+        m_datagramMessages = 0;
+
+        // Add the reliable messages never sent, or not acknowledged in time
+        while ((m_sendBudget > 0) && (reliableIndex < m_reliableQueue.size()) && (m_datagramMessages < MaxMessagesPerDatagram))
+        {
+            OutgoingMessage& message = m_reliableQueue[reliableIndex];
+            if (static_cast<Uint16>(message.id - m_reliableQueue.front().id) >= MessageWindow)
+                break;
+
+            if (message.acknowledged || ((message.lastSent >= 0) && (now - message.lastSent < retransmissionTimeout)))
+            {
+                reliableIndex++;
+                continue;
+            }
+
+            if (m_datagram.getDataSize() + 7 + message.data.size() > maxDatagramSize)
+                break;
+
+            writeMessage(message);
+            message.lastSent = now;
+            sent.messageIds[sent.messageCount++] = message.id;
+            reliableIndex++;
+        }
+
+        // Fill the rest with the unreliable messages
+        while ((m_sendBudget > 0) && (unreliableIndex < m_unreliableQueue.size()) && (m_datagramMessages < MaxMessagesPerDatagram))
+        {
+            const OutgoingMessage& message = m_unreliableQueue[unreliableIndex];
+            if (m_datagram.getDataSize() + 7 + message.data.size() > maxDatagramSize)
+                break;
+
+            writeMessage(message);
+            unreliableIndex++;
+        }
+
+        // Send the datagram if it has messages, or if the remote peer needs acks
+        if ((m_datagramMessages == 0) && !m_ackPending && !keepAlive)
+            break;
+
+        if (m_conditioner)
+            status = m_conditioner->send(m_datagram, m_remoteAddress, m_remotePort);
+        else
+            status = m_socket.send(m_datagram, m_remoteAddress, m_remotePort);
+        if (status != Socket::Done)
+            break;
+
+        sent.valid    = true;
+        sent.sequence = m_localSequence;
+        sent.time     = now;
+        sent.size     = static_cast<Uint32>(m_datagram.getDataSize());
+
+        m_sendBudget -= static_cast<double>(m_datagram.getDataSize());
+        m_localSequence++;
+        m_lastSend = now;
+        m_ackPending = false;
+        keepAlive = false;
+
+        if (m_datagramMessages == 0)
+            break;
+    }
+
+    // Unreliable messages are only worth sending now
+    m_unreliableQueue.clear();
+
+    return status;
+}
+
+
+////////////////////////////////////////////////////////////
+void UdpConnection::setTimeout(Time timeout)
+{
+    m_timeout = timeout.asMicroseconds();
+}
+
+
+////////////////////////////////////////////////////////////
+void UdpConnection::setMaxSendRate(Uint32 bytesPerSecond)
+{
+    m_maxSendRate = std::max(static_cast<double>(bytesPerSecond), minSendRate);
+    m_sendRate = std::min(m_sendRate, m_maxSendRate);
+}
+
+
+////////////////////////////////////////////////////////////
+void UdpConnection::setLinkConditioner(LinkConditioner* conditioner)
+{
+    m_conditioner = conditioner;
+}
+
+
+////////////////////////////////////////////////////////////
+Uint32 UdpConnection::getSendRate() const
+{
+    return static_cast<Uint32>(m_sendRate);
+}
+
+
+////////////////////////////////////////////////////////////
+Time UdpConnection::getRoundTripTime() const
+{
+    return microseconds(m_roundTripTime);
+}
+
+
+////////////////////////////////////////////////////////////
+float UdpConnection::getPacketLoss() const
+{
+    return m_packetLoss;
+}
+
+
+////////////////////////////////////////////////////////////
+void UdpConnection::writeMessage(const OutgoingMessage& message)
+{
+    if (message.fragmentCount > 1)
+        m_datagram << Uint8(message.channel | fragmentFlag) << message.id << message.fragmentIndex << message.fragmentCount;
+    else
+        m_datagram << message.channel << message.id;
+
+    m_datagram << static_cast<Uint16>(message.data.size());
+    if (!message.data.empty())
+        m_datagram.append(&message.data[0], message.data.size());
+
+    m_datagramMessages++;
+}
+
+
+////////////////////////////////////////////////////////////
+void UdpConnection::processMessage(Uint8 channel, Uint16 id, Uint8 fragmentIndex, Uint8 fragmentCount, const char* data, std::size_t size)
+{
+    if (channel == ReliableOrdered)
+    {
+        // Keep the message until all the previous ones are received, ignore the duplicates
+        if (static_cast<Uint16>(id - m_expectedReliableId) >= MessageWindow)
+            return;
+
+        IncomingMessage& slot = m_incomingReliable[id % MessageWindow];
+        if (slot.valid && (slot.id == id))
+            return;
+
+        slot.valid         = true;
+        slot.id            = id;
+        slot.fragmentIndex = fragmentIndex;
+        slot.fragmentCount = fragmentCount;
+        slot.data.assign(data, data + size);
+    }
+    else if (fragmentCount == 1)
+    {
+        deliver(channel, id, data, size);
+    }
+    else
+    {
+        // Reassemble the fragments, a newer message replaces an incomplete one
+        Reassembly& reassembly = m_reassembly[channel];
+        if ((reassembly.id != id) || (reassembly.fragments.size() != fragmentCount))
+        {
+            reassembly.id = id;
+            reassembly.received = 0;
+            reassembly.fragments.clear();
+            reassembly.fragments.resize(fragmentCount);
+        }
+
+        std::vector<char>& fragment = reassembly.fragments[fragmentIndex];
+        if (!fragment.empty() || (size == 0))
+            return;
+
+        fragment.assign(data, data + size);
+        if (++reassembly.received < fragmentCount)
+            return;
+
+        std::vector<char> message;
+        for (std::size_t i = 0; i < reassembly.fragments.size(); ++i)
+            message.insert(message.end(), reassembly.fragments[i].begin(), reassembly.fragments[i].end());
+
+        reassembly.fragments.clear();
+        deliver(channel, id, &message[0], message.size());
+    }
+}
+
+
+////////////////////////////////////////////////////////////
+void UdpConnection::acknowledge(Uint16 sequence, Int64 now)
+{
+    SentDatagram& sent = m_sentDatagrams[sequence % DatagramWindow];
+    if (!sent.valid || (sent.sequence != sequence))
+        return;
+
+    sent.valid = false;
+
+    // Update the round trip time estimation (RFC 6298)
+    Int64 sample = now - sent.time;
+    Int64 difference = sample > m_roundTripTime ? sample - m_roundTripTime : m_roundTripTime - sample;
+    m_roundTripVariation += (difference - m_roundTripVariation) / 4;
+    m_roundTripTime += (sample - m_roundTripTime) / 8;
+
+    // Speed up while datagrams get through, by about one datagram per round trip
+    double roundTripSeconds = std::max(static_cast<double>(m_roundTripTime), 1000.0) / 1000000.0;
+    m_packetLoss -= m_packetLoss * 0.1f;
+    m_sendRate = std::min(m_sendRate + sent.size * maxDatagramSize / (m_sendRate * roundTripSeconds), m_maxSendRate);
+
+    // Mark the reliable messages of the datagram as received
+    for (Uint8 i = 0; i < sent.messageCount; ++i)
+    {
+        if (m_reliableQueue.empty())
+            break;
+
+        std::size_t index = static_cast<Uint16>(sent.messageIds[i] - m_reliableQueue.front().id);
+        if (index < m_reliableQueue.size())
+            m_reliableQueue[index].acknowledged = true;
+    }
+
+    while (!m_reliableQueue.empty() && m_reliableQueue.front().acknowledged)
+        m_reliableQueue.pop_front();
+}
+
+
+////////////////////////////////////////////////////////////
+void UdpConnection::deliverReliableMessages()
+{
+    for (;;)
+    {
+        IncomingMessage& first = m_incomingReliable[m_expectedReliableId % MessageWindow];
+        if (!first.valid || (first.id != m_expectedReliableId))
+            return;
+
+        // A message which is not split is delivered at once
+        if (first.fragmentCount == 1)
+        {
+            first.valid = false;
+            m_received.push_back(first.data);
+            m_expectedReliableId++;
+            continue;
+        }
+
+        // Otherwise, wait for all its fragments
+        for (Uint8 i = 0; i < first.fragmentCount; ++i)
+        {
+            const IncomingMessage& fragment = m_incomingReliable[(m_expectedReliableId + i) % MessageWindow];
+            if (!fragment.valid || (fragment.id != static_cast<Uint16>(m_expectedReliableId + i)))
+                return;
+        }
+
+        m_received.push_back(std::vector<char>());
+        Uint8 fragmentCount = first.fragmentCount;
+        for (Uint8 i = 0; i < fragmentCount; ++i)
+        {
+            IncomingMessage& fragment = m_incomingReliable[(m_expectedReliableId + i) % MessageWindow];
+            m_received.back().insert(m_received.back().end(), fragment.data.begin(), fragment.data.end());
+            fragment.valid = false;
+        }
+
+        m_expectedReliableId += fragmentCount;
+    }
+}
+
+
+////////////////////////////////////////////////////////////
+void UdpConnection::deliver(Uint8 channel, Uint16 id, const char* data, std::size_t size)
+{
+    // Drop the sequenced messages older than the last one delivered
+    if (channel == UnreliableSequenced)
+    {
+        if (m_sequencedReceived && !isNewer(id, m_lastSequencedId))
+            return;
+
+        m_lastSequencedId = id;
+        m_sequencedReceived = true;
+    }
+
+    m_received.push_back(std::vector<char>(data, data + size));
+}
+
+
+////////////////////////////////////////////////////////////
+Int64 UdpConnection::getRetransmissionTimeout() const
+{
+    Int64 timeout = m_roundTripTime + 4 * m_roundTripVariation;
+
+    return std::min(std::max(timeout, minRetransmissionTimeout), maxRetransmissionTimeout);
+}
+
+} // namespace TGE
@@ -24,6 +24,14 @@ m_buffer(MaxDatagramSize)
 }
 
 
+////////////////////////////////////////////////////////////
+UdpSocket::~UdpSocket()
+{
+    for (std::vector<Packet*>::iterator it = m_packetPool.begin(); it != m_packetPool.end(); ++it)
+        delete *it;
+}
+
+
 ////////////////////////////////////////////////////////////
 unsigned short UdpSocket::getLocalPort() const
 {
@@ -44,11 +52,18 @@ unsigned short UdpSocket::getLocalPort() const
 
 
 ////////////////////////////////////////////////////////////
-Socket::Status UdpSocket::bind(unsigned short port)
+Socket::Status UdpSocket::bind(unsigned short port, bool sharePort)
 {
     // Create the internal socket if it doesn't exist
     create();
 
+    // Let other sockets share the port
+    if (sharePort && !priv::SocketImpl::setReusePort(getHandle()))
+    {
+        Log() << "Failed to share port " << port << " (not supported by the system)" << std::endl;
+        return Error;
+    }
+
     // Bind the socket
     sockaddr_in address = priv::SocketImpl::createAddress(INADDR_ANY, port);
     if (::bind(getHandle(), reinterpret_cast<sockaddr*>(&address), sizeof(address)) == -1)
@@ -170,4 +185,116 @@ Socket::Status UdpSocket::receive(Packet& packet, IpAddress& remoteAddress, unsi
 }
 
 
+
+////////////////////////////////////////////////////////////
+Socket::Status UdpSocket::send(const Datagram* datagrams, std::size_t count, std::size_t& sent)
+{
+    sent = 0;
+
+    // Create the internal socket if it doesn't exist
+    create();
+
+    priv::SocketImpl::IoBuffer buffers[MaxDatagramsPerCall];
+    sockaddr_in addresses[MaxDatagramsPerCall];
+
+    while (sent < count)
+    {
+        // Gather the data and the receiver of a group of datagrams
+        std::size_t groupCount = std::min(count - sent, static_cast<std::size_t>(MaxDatagramsPerCall));
+        for (std::size_t i = 0; i < groupCount; ++i)
+        {
+            const Datagram& datagram = datagrams[sent + i];
+
+            std::size_t size = 0;
+            const void* data = datagram.packet->onSend(size);
+
+            // Make sure that all the data will fit in one datagram
+            if (size > MaxDatagramSize)
+            {
+                Log() << "Cannot send data over the network "
+                      << "(the number of bytes to send is greater than TGE::UdpSocket::MaxDatagramSize)" << std::endl;
+                return Error;
+            }
+
+            priv::SocketImpl::setIoBuffer(buffers[i], data, size);
+            addresses[i] = priv::SocketImpl::createAddress(datagram.address.toInteger(), datagram.port);
+        }
+
+        // Send as many datagrams as possible
+        int result = priv::SocketImpl::sendDatagrams(getHandle(), buffers, addresses, groupCount);
+        if (result < 0)
+        {
+            Status status = priv::SocketImpl::getErrorStatus();
+
+            if ((status == NotReady) && (sent > 0))
+                return Partial;
+
+            return status;
+        }
+
+        sent += static_cast<std::size_t>(result);
+    }
+
+    return Done;
+}
+
+
+////////////////////////////////////////////////////////////
+Socket::Status UdpSocket::receive(std::vector<Datagram>& datagrams)
+{
+    datagrams.clear();
+
+    // Give each datagram its own slot in the receive buffer
+    if (m_receiveArena.empty())
+        m_receiveArena.resize(MaxDatagramsPerCall * MaxDatagramSize);
+
+    priv::SocketImpl::IoBuffer buffers[MaxDatagramsPerCall];
+    sockaddr_in addresses[MaxDatagramsPerCall];
+    std::size_t sizes[MaxDatagramsPerCall];
+    for (std::size_t i = 0; i < MaxDatagramsPerCall; ++i)
+        priv::SocketImpl::setIoBuffer(buffers[i], &m_receiveArena[i * MaxDatagramSize], MaxDatagramSize);
+
+    // Receive everything available
+    int received = priv::SocketImpl::receiveDatagrams(getHandle(), buffers, addresses, sizes, MaxDatagramsPerCall);
+    if (received < 0)
+        return priv::SocketImpl::getErrorStatus();
+
+    // Make a packet of each datagram, pointing into the buffer
+    while (m_packetPool.size() < static_cast<std::size_t>(received))
+        m_packetPool.push_back(new Packet);
+
+    datagrams.resize(static_cast<std::size_t>(received));
+    for (std::size_t i = 0; i < datagrams.size(); ++i)
+    {
+        m_packetPool[i]->setView(&m_receiveArena[i * MaxDatagramSize], sizes[i]);
+
+        datagrams[i].packet  = m_packetPool[i];
+        datagrams[i].address = IpAddress(ntohl(addresses[i].sin_addr.s_addr));
+        datagrams[i].port    = ntohs(addresses[i].sin_port);
+    }
+
+    return Done;
+}
+
+
+////////////////////////////////////////////////////////////
+UdpSocket::Datagram::Datagram() :
+packet (NULL),
+address(),
+port   (0)
+{
+
+}
+
+
+////////////////////////////////////////////////////////////
+UdpSocket::Datagram::Datagram(Packet& datagramPacket, const IpAddress& remoteAddress, unsigned short remotePort) :
+packet (&datagramPacket),
+address(remoteAddress),
+port   (remotePort)
+{
+
+}
+
+
 } // namespace TGE
@@ -6,11 +6,19 @@
 /**             Headers             **/
 /*************************************/
 #include <Tyrant/Network/Unix/SocketImpl.hpp>
+#include <Tyrant/Network/UdpSocket.hpp>
 #include <errno.h>
 #include <fcntl.h>
+#include <algorithm>
 #include <cstring>
 
 
+namespace
+{
+    // Maximum number of datagrams sent or received by a single system call
+    const std::size_t maxDatagramsPerCall = TGE::UdpSocket::MaxDatagramsPerCall;
+}
+
 namespace TGE
 {
 namespace priv
@@ -57,6 +65,114 @@ void SocketImpl::setBlocking(SocketHandle sock, bool block)
 }
 
 
+////////////////////////////////////////////////////////////
+void SocketImpl::setIoBuffer(IoBuffer& buffer, const void* data, std::size_t size)
+{
+    buffer.iov_base = const_cast<void*>(data);
+    buffer.iov_len  = size;
+}
+
+
+////////////////////////////////////////////////////////////
+int SocketImpl::sendBuffers(SocketHandle sock, IoBuffer* buffers, std::size_t count, int flags)
+{
+    // sendmsg rather than writev, so that the flags can be passed
+    msghdr message;
+    std::memset(&message, 0, sizeof(message));
+    message.msg_iov    = buffers;
+    message.msg_iovlen = count;
+
+    return static_cast<int>(sendmsg(sock, &message, flags));
+}
+
+
+////////////////////////////////////////////////////////////
+int SocketImpl::sendDatagrams(SocketHandle sock, IoBuffer* buffers, sockaddr_in* addresses, std::size_t count)
+{
+#if defined(OS_LINUX)
+
+    // Linux sends the whole array in a single call
+    mmsghdr messages[maxDatagramsPerCall];
+    count = std::min(count, maxDatagramsPerCall);
+    std::memset(messages, 0, count * sizeof(mmsghdr));
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        messages[i].msg_hdr.msg_name    = &addresses[i];
+        messages[i].msg_hdr.msg_namelen = sizeof(addresses[i]);
+        messages[i].msg_hdr.msg_iov     = &buffers[i];
+        messages[i].msg_hdr.msg_iovlen  = 1;
+    }
+
+    return sendmmsg(sock, messages, static_cast<unsigned int>(count), 0);
+
+#else
+
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        if (sendto(sock, buffers[i].iov_base, buffers[i].iov_len, 0, reinterpret_cast<sockaddr*>(&addresses[i]), sizeof(addresses[i])) < 0)
+            return i > 0 ? static_cast<int>(i) : -1;
+    }
+
+    return static_cast<int>(count);
+
+#endif
+}
+
+
+////////////////////////////////////////////////////////////
+int SocketImpl::receiveDatagrams(SocketHandle sock, IoBuffer* buffers, sockaddr_in* addresses, std::size_t* sizes, std::size_t count)
+{
+#if defined(OS_LINUX)
+
+    // Linux receives the whole array in a single call
+    mmsghdr messages[maxDatagramsPerCall];
+    count = std::min(count, maxDatagramsPerCall);
+    std::memset(messages, 0, count * sizeof(mmsghdr));
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        messages[i].msg_hdr.msg_name    = &addresses[i];
+        messages[i].msg_hdr.msg_namelen = sizeof(addresses[i]);
+        messages[i].msg_hdr.msg_iov     = &buffers[i];
+        messages[i].msg_hdr.msg_iovlen  = 1;
+    }
+
+    int received = recvmmsg(sock, messages, static_cast<unsigned int>(count), MSG_WAITFORONE, NULL);
+    for (int i = 0; i < received; ++i)
+        sizes[i] = messages[i].msg_len;
+
+    return received;
+
+#else
+
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        // Only the first datagram may be waited for
+        AddrLength addressSize = sizeof(addresses[i]);
+        ssize_t size = recvfrom(sock, buffers[i].iov_base, buffers[i].iov_len, i > 0 ? MSG_DONTWAIT : 0, reinterpret_cast<sockaddr*>(&addresses[i]), &addressSize);
+        if (size < 0)
+            return i > 0 ? static_cast<int>(i) : -1;
+
+        sizes[i] = static_cast<std::size_t>(size);
+    }
+
+    return static_cast<int>(count);
+
+#endif
+}
+
+
+////////////////////////////////////////////////////////////
+bool SocketImpl::setReusePort(SocketHandle sock)
+{
+#if defined(SO_REUSEPORT)
+    int yes = 1;
+    return setsockopt(sock, SOL_SOCKET, SO_REUSEPORT, &yes, sizeof(yes)) == 0;
+#else
+    return false;
+#endif
+}
+
+
 ////////////////////////////////////////////////////////////
 Socket::Status SocketImpl::getErrorStatus()
 {
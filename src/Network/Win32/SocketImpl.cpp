@@ -48,6 +48,72 @@ void SocketImpl::setBlocking(SocketHandle sock, bool block)
 }
 
 
+////////////////////////////////////////////////////////////
+void SocketImpl::setIoBuffer(IoBuffer& buffer, const void* data, std::size_t size)
+{
+    buffer.buf = static_cast<CHAR*>(const_cast<void*>(data));
+    buffer.len = static_cast<ULONG>(size);
+}
+
+
+////////////////////////////////////////////////////////////
+int SocketImpl::sendBuffers(SocketHandle sock, IoBuffer* buffers, std::size_t count, int flags)
+{
+    DWORD sent = 0;
+    if (WSASend(sock, buffers, static_cast<DWORD>(count), &sent, static_cast<DWORD>(flags), NULL, NULL) != 0)
+        return -1;
+
+    return static_cast<int>(sent);
+}
+
+
+////////////////////////////////////////////////////////////
+int SocketImpl::sendDatagrams(SocketHandle sock, IoBuffer* buffers, sockaddr_in* addresses, std::size_t count)
+{
+    // Windows XP has no call sending several datagrams
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        if (sendto(sock, buffers[i].buf, static_cast<int>(buffers[i].len), 0, reinterpret_cast<sockaddr*>(&addresses[i]), sizeof(addresses[i])) < 0)
+            return i > 0 ? static_cast<int>(i) : -1;
+    }
+
+    return static_cast<int>(count);
+}
+
+
+////////////////////////////////////////////////////////////
+int SocketImpl::receiveDatagrams(SocketHandle sock, IoBuffer* buffers, sockaddr_in* addresses, std::size_t* sizes, std::size_t count)
+{
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        // Only the first datagram may be waited for
+        if (i > 0)
+        {
+            u_long pending = 0;
+            if ((ioctlsocket(sock, FIONREAD, &pending) != 0) || (pending == 0))
+                return static_cast<int>(i);
+        }
+
+        AddrLength addressSize = sizeof(addresses[i]);
+        int size = recvfrom(sock, buffers[i].buf, static_cast<int>(buffers[i].len), 0, reinterpret_cast<sockaddr*>(&addresses[i]), &addressSize);
+        if (size < 0)
+            return i > 0 ? static_cast<int>(i) : -1;
+
+        sizes[i] = static_cast<std::size_t>(size);
+    }
+
+    return static_cast<int>(count);
+}
+
+
+////////////////////////////////////////////////////////////
+bool SocketImpl::setReusePort(SocketHandle)
+{
+    // SO_REUSEADDR doesn't balance the datagrams between the sockets on Windows
+    return false;
+}
+
+
 ////////////////////////////////////////////////////////////
 Socket::Status SocketImpl::getErrorStatus()
 {
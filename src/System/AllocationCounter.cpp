@@ -0,0 +1,105 @@
+/*************************************/
+/** Copyright © 2014 Coldsnap Games **/
+/*************************************/
+
+/*************************************/
+/**             Headers             **/
+/*************************************/
+#include <Tyrant/System/AllocationCounter.hpp>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+
+#if defined(TGE_COUNT_ALLOCATIONS)
+
+namespace
+{
+    std::atomic<TGE::Uint32> allocationCount(0);
+
+    void* countedAllocate(std::size_t size)
+    {
+        allocationCount.fetch_add(1, std::memory_order_relaxed);
+        return std::malloc(size > 0 ? size : 1);
+    }
+}
+
+
+////////////////////////////////////////////////////////////
+// Replacements of the global allocation functions
+////////////////////////////////////////////////////////////
+void* operator new(std::size_t size)
+{
+    void* memory = countedAllocate(size);
+    if (!memory)
+        throw std::bad_alloc();
+
+    return memory;
+}
+
+void* operator new[](std::size_t size)
+{
+    void* memory = countedAllocate(size);
+    if (!memory)
+        throw std::bad_alloc();
+
+    return memory;
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) throw()
+{
+    return countedAllocate(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) throw()
+{
+    return countedAllocate(size);
+}
+
+void operator delete(void* memory) throw()
+{
+    std::free(memory);
+}
+
+void operator delete[](void* memory) throw()
+{
+    std::free(memory);
+}
+
+void operator delete(void* memory, const std::nothrow_t&) throw()
+{
+    std::free(memory);
+}
+
+void operator delete[](void* memory, const std::nothrow_t&) throw()
+{
+    std::free(memory);
+}
+
+#endif
+
+
+namespace TGE
+{
+////////////////////////////////////////////////////////////
+bool AllocationCounter::isEnabled()
+{
+#if defined(TGE_COUNT_ALLOCATIONS)
+    return true;
+#else
+    return false;
+#endif
+}
+
+
+////////////////////////////////////////////////////////////
+Uint32 AllocationCounter::getCount()
+{
+#if defined(TGE_COUNT_ALLOCATIONS)
+    return allocationCount.load(std::memory_order_relaxed);
+#else
+    return 0;
+#endif
+}
+
+} // namespace TGE
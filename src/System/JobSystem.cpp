@@ -0,0 +1,548 @@
+/*************************************/
+/** Copyright © 2014 Coldsnap Games **/
+/*************************************/
+
+/*************************************/
+/**             Headers             **/
+/*************************************/
+#include <Tyrant/System/JobSystem.hpp>
+#include <Tyrant/System/Thread.hpp>
+#include <Tyrant/System/Lock.hpp>
+#include <Tyrant/System/MemoryPool.hpp>
+#include <Tyrant/System/Profiler.hpp>
+
+#if defined(OS_WINDOWS)
+    #include <windows.h>
+#else
+    #include <sched.h>
+    #include <unistd.h>
+#endif
+
+
+namespace
+{
+    // Number of failed attempts to find a job before an idle worker goes to sleep
+    const unsigned int idleSpinCount = 64;
+
+    // Number of job blocks allocated at once by a pool
+    const std::size_t jobBlocksPerChunk = 256;
+
+    ////////////////////////////////////////////////////////////
+    unsigned int getCoreCount()
+    {
+    #if defined(OS_WINDOWS)
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+        long count = static_cast<long>(info.dwNumberOfProcessors);
+    #else
+        long count = sysconf(_SC_NPROCESSORS_ONLN);
+    #endif
+
+        return count > 0 ? static_cast<unsigned int>(count) : 1;
+    }
+
+    ////////////////////////////////////////////////////////////
+    void yieldThread()
+    {
+    #if defined(OS_WINDOWS)
+        SwitchToThread();
+    #else
+        sched_yield();
+    #endif
+    }
+}
+
+
+namespace TGE
+{
+namespace priv
+{
+////////////////////////////////////////////////////////////
+/// \brief Thread of a job system, with its queue of jobs
+///
+/// The queue is a fixed-size Chase-Lev deque: the owner thread
+/// pushes and pops jobs at the bottom without any lock, other
+/// threads steal them from the top with a compare-and-swap.
+///
+/// The worker also owns the pool of the jobs created by its
+/// thread. Only the owner thread uses the pool; the other
+/// threads give the blocks of the jobs they ran back through a
+/// lock-free list, which the owner takes as a whole when its
+/// pool runs out of blocks.
+///
+////////////////////////////////////////////////////////////
+struct JobWorker
+{
+    enum {Capacity = 4096};
+
+    JobWorker(JobSystem* owner) :
+    system(owner),
+    thread(NULL),
+    stealIndex(0),
+    pool(JobBlockSize, jobBlocksPerChunk),
+    remoteBlocks(NULL),
+    top(0),
+    bottom(0)
+    {
+        for (unsigned int i = 0; i < Capacity; ++i)
+            slots[i].store(NULL, std::memory_order_relaxed);
+    }
+
+    ~JobWorker()
+    {
+        delete thread;
+    }
+
+    void run()
+    {
+        system->workerLoop(this);
+    }
+
+    // Owner thread only, returns false if the queue is full
+    bool push(Job* job)
+    {
+        Int64 b = bottom.load(std::memory_order_relaxed);
+        Int64 t = top.load(std::memory_order_acquire);
+        if (b - t >= Capacity)
+            return false;
+
+        slots[b & (Capacity - 1)].store(job, std::memory_order_relaxed);
+        bottom.store(b + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    // Owner thread only, takes the most recent job
+    Job* pop()
+    {
+        Int64 b = bottom.load(std::memory_order_relaxed) - 1;
+        bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        Int64 t = top.load(std::memory_order_relaxed);
+
+        if (t > b)
+        {
+            // Empty
+            bottom.store(b + 1, std::memory_order_relaxed);
+            return NULL;
+        }
+
+        Job* job = slots[b & (Capacity - 1)].load(std::memory_order_relaxed);
+        if (t == b)
+        {
+            // Last job: race against the thieves for it
+            if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                job = NULL;
+            bottom.store(b + 1, std::memory_order_relaxed);
+        }
+
+        return job;
+    }
+
+    // Owner thread only
+    void* allocate()
+    {
+        if (pool.getAllocatedCount() == pool.getCapacity())
+        {
+            // Taking the whole list at once can't race with the other threads adding to it
+            void* block = remoteBlocks.exchange(NULL, std::memory_order_acquire);
+            while (block)
+            {
+                void* next = *static_cast<void**>(block);
+                pool.deallocate(block);
+                block = next;
+            }
+        }
+
+        return pool.allocate();
+    }
+
+    // Any thread other than the owner, the job must be destroyed
+    void releaseRemote(void* block)
+    {
+        void* head = remoteBlocks.load(std::memory_order_relaxed);
+        do
+        {
+            *static_cast<void**>(block) = head;
+        }
+        while (!remoteBlocks.compare_exchange_weak(head, block, std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    // Any thread, takes the oldest job
+    Job* steal()
+    {
+        Int64 t = top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        Int64 b = bottom.load(std::memory_order_acquire);
+
+        if (t >= b)
+            return NULL;
+
+        Job* job = slots[t & (Capacity - 1)].load(std::memory_order_relaxed);
+        if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+            return NULL;
+
+        return job;
+    }
+
+    JobSystem*          system;          // Job system that owns the worker
+    Thread*             thread;          // Thread running the worker, NULL for the main thread
+    unsigned int        stealIndex;      // Next worker to steal from
+    MemoryPool          pool;            // Blocks of the jobs created by the owner thread
+    std::atomic<void*>  remoteBlocks;    // Blocks of the pool released by other threads
+    std::atomic<Int64>  top;             // Index of the oldest job, incremented by thieves
+    char                padding[64];     // Keeps top and bottom on different cache lines
+    std::atomic<Int64>  bottom;          // Index after the most recent job, owner thread only
+    std::atomic<Job*>   slots[Capacity]; // Circular storage of the jobs
+};
+
+} // namespace priv
+
+
+////////////////////////////////////////////////////////////
+JobCounter::JobCounter() :
+m_count        (0),
+m_locked       (false),
+m_continuations(NULL)
+{
+}
+
+
+////////////////////////////////////////////////////////////
+JobCounter::~JobCounter()
+{
+}
+
+
+////////////////////////////////////////////////////////////
+bool JobCounter::isDone() const
+{
+    if (m_count.load() != 0)
+        return false;
+
+    // The thread that finished the last job may still be releasing the
+    // continuations: wait until it doesn't use the counter anymore
+    lock();
+    unlock();
+
+    return true;
+}
+
+
+////////////////////////////////////////////////////////////
+unsigned int JobCounter::getPendingCount() const
+{
+    return m_count.load();
+}
+
+
+////////////////////////////////////////////////////////////
+void JobCounter::lock() const
+{
+    while (m_locked.exchange(true, std::memory_order_acquire))
+    {
+    }
+}
+
+
+////////////////////////////////////////////////////////////
+void JobCounter::unlock() const
+{
+    m_locked.store(false, std::memory_order_release);
+}
+
+
+////////////////////////////////////////////////////////////
+JobSystem::JobSystem(unsigned int workerCount) :
+m_workers    (),
+m_localWorker(NULL),
+m_sharedQueue(),
+m_sharedMutex(Mutex::NonRecursive),
+m_sharedCount(0),
+m_wakeUp     (0),
+m_sleeping   (0),
+m_running    (true)
+{
+    if (workerCount == 0)
+    {
+        unsigned int cores = getCoreCount();
+        workerCount = cores > 1 ? cores - 1 : 1;
+    }
+
+    // The calling thread is the main thread, it has a queue but no thread
+    priv::JobWorker* mainWorker = new priv::JobWorker(this);
+    m_workers.push_back(mainWorker);
+    m_localWorker = mainWorker;
+
+    // All the queues must exist before the first worker starts stealing
+    for (unsigned int i = 0; i < workerCount; ++i)
+        m_workers.push_back(new priv::JobWorker(this));
+
+    for (unsigned int i = 1; i < m_workers.size(); ++i)
+    {
+        m_workers[i]->stealIndex = i + 1;
+        m_workers[i]->thread = new Thread(&priv::JobWorker::run, m_workers[i]);
+        m_workers[i]->thread->launch();
+    }
+}
+
+
+////////////////////////////////////////////////////////////
+JobSystem::~JobSystem()
+{
+    // Stop the workers; they finish the job they are running
+    m_running.store(false);
+    for (unsigned int i = 1; i < m_workers.size(); ++i)
+        m_wakeUp.post();
+    for (unsigned int i = 1; i < m_workers.size(); ++i)
+        m_workers[i]->thread->wait();
+
+    // Run what is left in the queues on the calling thread
+    while (priv::Job* job = pop())
+        execute(job);
+
+    for (std::vector<priv::JobWorker*>::iterator it = m_workers.begin(); it != m_workers.end(); ++it)
+        delete *it;
+}
+
+
+////////////////////////////////////////////////////////////
+unsigned int JobSystem::getWorkerCount() const
+{
+    return static_cast<unsigned int>(m_workers.size() - 1);
+}
+
+
+////////////////////////////////////////////////////////////
+void JobSystem::wait(JobCounter& counter)
+{
+    while (!counter.isDone())
+    {
+        if (!runPendingJob())
+            yieldThread();
+    }
+}
+
+
+////////////////////////////////////////////////////////////
+bool JobSystem::runPendingJob()
+{
+    priv::Job* job = pop();
+    if (!job)
+        return false;
+
+    execute(job);
+    return true;
+}
+
+
+////////////////////////////////////////////////////////////
+void* JobSystem::allocateJob(std::size_t size, priv::JobWorker*& pool)
+{
+    priv::JobWorker* worker = m_localWorker;
+    if (!worker || (size > priv::JobBlockSize))
+    {
+        pool = NULL;
+        return ::operator new(size);
+    }
+
+    pool = worker;
+    return worker->allocate();
+}
+
+
+////////////////////////////////////////////////////////////
+void JobSystem::releaseJob(priv::Job* job)
+{
+    priv::JobWorker* pool = job->pool;
+    job->~Job();
+
+    if (!pool)
+        ::operator delete(job);
+    else if (pool == m_localWorker)
+        pool->pool.deallocate(job);
+    else
+        pool->releaseRemote(job);
+}
+
+
+////////////////////////////////////////////////////////////
+void JobSystem::submit(priv::Job* job)
+{
+    if (job->counter)
+        job->counter->m_count.fetch_add(1);
+
+    push(job);
+}
+
+
+////////////////////////////////////////////////////////////
+void JobSystem::submitAfter(JobCounter& dependency, priv::Job* job)
+{
+    if (job->counter)
+        job->counter->m_count.fetch_add(1);
+
+    dependency.lock();
+    if (dependency.m_count.load() == 0)
+    {
+        dependency.unlock();
+        push(job);
+    }
+    else
+    {
+        job->next = dependency.m_continuations;
+        dependency.m_continuations = job;
+        dependency.unlock();
+    }
+}
+
+
+////////////////////////////////////////////////////////////
+void JobSystem::push(priv::Job* job)
+{
+    priv::JobWorker* worker = m_localWorker;
+
+    // Jobs queued by foreign threads, or overflowing a full queue, go to the shared queue
+    if (!worker || !worker->push(job))
+    {
+        Lock lock(m_sharedMutex);
+        m_sharedQueue.push_back(job);
+        m_sharedCount.fetch_add(1);
+    }
+
+    // Wake up a sleeping worker, if any
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_sleeping.load() > 0)
+        m_wakeUp.post();
+}
+
+
+////////////////////////////////////////////////////////////
+priv::Job* JobSystem::pop()
+{
+    priv::JobWorker* local = m_localWorker;
+
+    // Most recent job of our own queue first: its data is likely to still be in cache
+    if (local)
+    {
+        if (priv::Job* job = local->pop())
+            return job;
+    }
+
+    if (m_sharedCount.load() > 0)
+    {
+        Lock lock(m_sharedMutex);
+        if (!m_sharedQueue.empty())
+        {
+            priv::Job* job = m_sharedQueue.front();
+            m_sharedQueue.pop_front();
+            m_sharedCount.fetch_sub(1);
+            return job;
+        }
+    }
+
+    // Steal from the other threads, starting from a different one each time
+    std::size_t count = m_workers.size();
+    std::size_t start = local ? local->stealIndex++ : 0;
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        priv::JobWorker* victim = m_workers[(start + i) % count];
+        if (victim != local)
+        {
+            if (priv::Job* job = victim->steal())
+                return job;
+        }
+    }
+
+    return NULL;
+}
+
+
+////////////////////////////////////////////////////////////
+void JobSystem::execute(priv::Job* job)
+{
+    job->run();
+
+    JobCounter* counter = job->counter;
+    releaseJob(job);
+
+    if (!counter)
+        return;
+
+    unsigned int count = counter->m_count.load();
+    for (;;)
+    {
+        if (count > 1)
+        {
+            if (counter->m_count.compare_exchange_weak(count, count - 1))
+                return;
+        }
+        else
+        {
+            // Last job: reaching zero and taking the continuations must happen
+            // under the lock, so that isDone() can't return true (and let the
+            // counter be destroyed) before we are done with it
+            counter->lock();
+            if (counter->m_count.compare_exchange_strong(count, 0))
+            {
+                priv::Job* continuation = counter->m_continuations;
+                counter->m_continuations = NULL;
+                counter->unlock();
+
+                while (continuation)
+                {
+                    priv::Job* next = continuation->next;
+                    continuation->next = NULL;
+                    push(continuation);
+                    continuation = next;
+                }
+
+                return;
+            }
+            counter->unlock();
+        }
+    }
+}
+
+
+////////////////////////////////////////////////////////////
+void JobSystem::workerLoop(priv::JobWorker* worker)
+{
+    TGE_PROFILE_THREAD("Job worker");
+
+    m_localWorker = worker;
+
+    unsigned int idle = 0;
+    while (m_running.load())
+    {
+        if (priv::Job* job = pop())
+        {
+            execute(job);
+            idle = 0;
+        }
+        else if (++idle < idleSpinCount)
+        {
+            yieldThread();
+        }
+        else
+        {
+            // Announce that we are going to sleep, then check one last time
+            // for jobs queued before the announcement was visible
+            m_sleeping.fetch_add(1);
+            if (priv::Job* job = pop())
+            {
+                m_sleeping.fetch_sub(1);
+                execute(job);
+            }
+            else
+            {
+                m_wakeUp.wait();
+                m_sleeping.fetch_sub(1);
+            }
+
+            idle = 0;
+        }
+    }
+}
+
+} // namespace TGE
@@ -0,0 +1,160 @@
+/*************************************/
+/** Copyright © 2014 Coldsnap Games **/
+/*************************************/
+
+/*************************************/
+/**             Headers             **/
+/*************************************/
+#include <Tyrant/System/MemoryArena.hpp>
+#include <Tyrant/System/Mutex.hpp>
+#include <Tyrant/System/Lock.hpp>
+#include <Tyrant/System/ThreadLocalPtr.hpp>
+#include <algorithm>
+#include <new>
+
+
+namespace
+{
+    // Frame arenas of the running threads, the remaining ones are destroyed at exit
+    struct FrameArenaList
+    {
+        FrameArenaList() : mutex(TGE::Mutex::NonRecursive) {}
+
+        ~FrameArenaList()
+        {
+            for (std::vector<TGE::MemoryArena*>::iterator it = arenas.begin(); it != arenas.end(); ++it)
+                delete *it;
+        }
+
+        TGE::Mutex                     mutex;
+        std::vector<TGE::MemoryArena*> arenas;
+    };
+
+    FrameArenaList frameArenas;
+    TGE::ThreadLocalPtr<TGE::MemoryArena> localFrameArena(NULL);
+
+    // Round an address up to the given alignment
+    inline std::size_t alignUp(std::size_t address, std::size_t alignment)
+    {
+        return (address + alignment - 1) & ~(alignment - 1);
+    }
+}
+
+
+namespace TGE
+{
+////////////////////////////////////////////////////////////
+MemoryArena::MemoryArena(std::size_t capacity) :
+m_buffer      (new char[capacity > 0 ? capacity : 1]),
+m_capacity    (capacity > 0 ? capacity : 1),
+m_offset      (0),
+m_overflow    (),
+m_overflowSize(0)
+{
+}
+
+
+////////////////////////////////////////////////////////////
+MemoryArena::~MemoryArena()
+{
+    for (std::vector<void*>::iterator it = m_overflow.begin(); it != m_overflow.end(); ++it)
+        ::operator delete(*it);
+
+    delete[] m_buffer;
+}
+
+
+////////////////////////////////////////////////////////////
+void* MemoryArena::allocate(std::size_t size, std::size_t alignment)
+{
+    std::size_t start  = reinterpret_cast<std::size_t>(m_buffer);
+    std::size_t offset = alignUp(start + m_offset, alignment) - start;
+
+    if (offset + size <= m_capacity)
+    {
+        m_offset = offset + size;
+        return m_buffer + offset;
+    }
+
+    // Not enough room in the buffer: fall back to the heap until the next reset
+    void* block = ::operator new(size + alignment - 1);
+    m_overflow.push_back(block);
+    m_overflowSize += size + alignment - 1;
+
+    return reinterpret_cast<void*>(alignUp(reinterpret_cast<std::size_t>(block), alignment));
+}
+
+
+////////////////////////////////////////////////////////////
+void MemoryArena::reset()
+{
+    if (!m_overflow.empty())
+    {
+        for (std::vector<void*>::iterator it = m_overflow.begin(); it != m_overflow.end(); ++it)
+            ::operator delete(*it);
+        m_overflow.clear();
+
+        // Grow the buffer so that the next frame fits in it
+        std::size_t required = m_offset + m_overflowSize;
+        std::size_t capacity = m_capacity;
+        while (capacity < required)
+            capacity *= 2;
+
+        delete[] m_buffer;
+        m_buffer   = new char[capacity];
+        m_capacity = capacity;
+    }
+
+    m_offset       = 0;
+    m_overflowSize = 0;
+}
+
+
+////////////////////////////////////////////////////////////
+std::size_t MemoryArena::getCapacity() const
+{
+    return m_capacity;
+}
+
+
+////////////////////////////////////////////////////////////
+std::size_t MemoryArena::getUsedSize() const
+{
+    return m_offset + m_overflowSize;
+}
+
+
+////////////////////////////////////////////////////////////
+MemoryArena& MemoryArena::getFrameArena()
+{
+    MemoryArena* arena = localFrameArena;
+    if (!arena)
+    {
+        arena = new MemoryArena;
+
+        Lock lock(frameArenas.mutex);
+        frameArenas.arenas.push_back(arena);
+        localFrameArena = arena;
+    }
+
+    return *arena;
+}
+
+
+////////////////////////////////////////////////////////////
+void MemoryArena::releaseFrameArena()
+{
+    MemoryArena* arena = localFrameArena;
+    if (arena)
+    {
+        {
+            Lock lock(frameArenas.mutex);
+            frameArenas.arenas.erase(std::remove(frameArenas.arenas.begin(), frameArenas.arenas.end(), arena), frameArenas.arenas.end());
+        }
+
+        delete arena;
+        localFrameArena = NULL;
+    }
+}
+
+} // namespace TGE
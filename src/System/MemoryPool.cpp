@@ -0,0 +1,101 @@
+/*************************************/
+/** Copyright © 2014 Coldsnap Games **/
+/*************************************/
+
+/*************************************/
+/**             Headers             **/
+/*************************************/
+#include <Tyrant/System/MemoryPool.hpp>
+#include <algorithm>
+
+
+namespace
+{
+    // Alignment of the blocks, enough for any fundamental type
+    const std::size_t blockAlignment = 16;
+}
+
+
+namespace TGE
+{
+////////////////////////////////////////////////////////////
+MemoryPool::MemoryPool(std::size_t blockSize, std::size_t blocksPerChunk) :
+m_blockSize     ((std::max(blockSize, sizeof(void*)) + blockAlignment - 1) & ~(blockAlignment - 1)),
+m_blocksPerChunk(blocksPerChunk > 0 ? blocksPerChunk : 1),
+m_freeList      (NULL),
+m_chunks        (),
+m_allocated     (0)
+{
+}
+
+
+////////////////////////////////////////////////////////////
+MemoryPool::~MemoryPool()
+{
+    for (std::vector<char*>::iterator it = m_chunks.begin(); it != m_chunks.end(); ++it)
+        delete[] *it;
+}
+
+
+////////////////////////////////////////////////////////////
+void* MemoryPool::allocate()
+{
+    if (!m_freeList)
+    {
+        // Allocate a new chunk, with some extra room to align the first block
+        char* chunk = new char[m_blockSize * m_blocksPerChunk + blockAlignment - 1];
+        m_chunks.push_back(chunk);
+
+        std::size_t address = reinterpret_cast<std::size_t>(chunk);
+        char* first = chunk + (((address + blockAlignment - 1) & ~(blockAlignment - 1)) - address);
+
+        // Link its blocks into the free list, in order
+        for (std::size_t i = m_blocksPerChunk; i > 0; --i)
+        {
+            void* block = first + (i - 1) * m_blockSize;
+            *static_cast<void**>(block) = m_freeList;
+            m_freeList = block;
+        }
+    }
+
+    void* block = m_freeList;
+    m_freeList = *static_cast<void**>(block);
+    m_allocated++;
+
+    return block;
+}
+
+
+////////////////////////////////////////////////////////////
+void MemoryPool::deallocate(void* block)
+{
+    if (!block)
+        return;
+
+    *static_cast<void**>(block) = m_freeList;
+    m_freeList = block;
+    m_allocated--;
+}
+
+
+////////////////////////////////////////////////////////////
+std::size_t MemoryPool::getBlockSize() const
+{
+    return m_blockSize;
+}
+
+
+////////////////////////////////////////////////////////////
+std::size_t MemoryPool::getAllocatedCount() const
+{
+    return m_allocated;
+}
+
+
+////////////////////////////////////////////////////////////
+std::size_t MemoryPool::getCapacity() const
+{
+    return m_chunks.size() * m_blocksPerChunk;
+}
+
+} // namespace TGE
@@ -17,9 +17,10 @@
 namespace TGE
 {
 ////////////////////////////////////////////////////////////
-Mutex::Mutex()
+Mutex::Mutex(Type type) :
+m_contentionCount(0)
 {
-    m_mutexImpl = new priv::MutexImpl;
+    m_mutexImpl = new priv::MutexImpl(type == Recursive);
 }
 
 
@@ -33,7 +34,19 @@ Mutex::~Mutex()
 ////////////////////////////////////////////////////////////
 void Mutex::lock()
 {
-    m_mutexImpl->lock();
+    // Try without blocking first, so that we know if we had to wait
+    if (!m_mutexImpl->tryLock())
+    {
+        m_contentionCount.fetch_add(1, std::memory_order_relaxed);
+        m_mutexImpl->lock();
+    }
+}
+
+
+////////////////////////////////////////////////////////////
+bool Mutex::tryLock()
+{
+    return m_mutexImpl->tryLock();
 }
 
 
@@ -43,4 +56,11 @@ void Mutex::unlock()
     m_mutexImpl->unlock();
 }
 
+
+////////////////////////////////////////////////////////////
+unsigned int Mutex::getContentionCount() const
+{
+    return m_contentionCount.load(std::memory_order_relaxed);
+}
+
 } // namespace TGE
@@ -0,0 +1,364 @@
+/*************************************/
+/** Copyright © 2014 Coldsnap Games **/
+/*************************************/
+
+/*************************************/
+/**             Headers             **/
+/*************************************/
+#include <Tyrant/System/Profiler.hpp>
+#include <Tyrant/System/Mutex.hpp>
+#include <Tyrant/System/Lock.hpp>
+#include <Tyrant/System/ThreadLocalPtr.hpp>
+#include <Tyrant/System/Log.hpp>
+#include <atomic>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <vector>
+
+#if defined(OS_WINDOWS)
+    #include <Tyrant/System/Win32/ClockImpl.hpp>
+#else
+    #include <Tyrant/System/Unix/ClockImpl.hpp>
+#endif
+
+
+namespace
+{
+    enum EventType
+    {
+        BeginEvent,
+        EndEvent,
+        FrameEvent
+    };
+
+    // Recorded event
+    struct Event
+    {
+        TGE::Uint64 time;
+        const char* name;
+        TGE::Uint8  type;
+    };
+
+    // Block of events; only the owner thread writes to it, and
+    // publishes each event by incrementing the count
+    struct Chunk
+    {
+        enum {Capacity = 8192};
+
+        Chunk() : count(0), next(NULL) {}
+
+        Event                     events[Capacity];
+        std::atomic<unsigned int> count;
+        std::atomic<Chunk*>       next;
+    };
+
+    // Events of a thread
+    struct ThreadBuffer
+    {
+        ThreadBuffer(unsigned int index) : id(index), name(NULL), first(new Chunk), last(first) {}
+
+        unsigned int             id;
+        std::atomic<const char*> name;
+        Chunk*                   first;
+        Chunk*                   last;
+    };
+
+    std::atomic<bool> running(false);
+    TGE::Mutex buffersMutex(TGE::Mutex::NonRecursive);
+    std::vector<ThreadBuffer*> buffers;
+    TGE::ThreadLocalPtr<ThreadBuffer> localBuffer(NULL);
+
+    // Get the buffer of the calling thread, creating it the first time
+    ThreadBuffer* getBuffer()
+    {
+        ThreadBuffer* buffer = localBuffer;
+        if (!buffer)
+        {
+            TGE::Lock lock(buffersMutex);
+            buffer = new ThreadBuffer(static_cast<unsigned int>(buffers.size()));
+            buffers.push_back(buffer);
+            localBuffer = buffer;
+        }
+
+        return buffer;
+    }
+
+    // Append an event to the buffer of the calling thread
+    void record(EventType type, const char* name, TGE::Uint64 time)
+    {
+        ThreadBuffer* buffer = getBuffer();
+
+        Chunk* chunk = buffer->last;
+        unsigned int count = chunk->count.load(std::memory_order_relaxed);
+        if (count == Chunk::Capacity)
+        {
+            Chunk* next = new Chunk;
+            chunk->next.store(next, std::memory_order_release);
+            buffer->last = next;
+            chunk = next;
+            count = 0;
+        }
+
+        Event& event = chunk->events[count];
+        event.time = time;
+        event.name = name;
+        event.type = static_cast<TGE::Uint8>(type);
+        chunk->count.store(count + 1, std::memory_order_release);
+    }
+
+    // Copy the list of buffers, so that it can be read without the lock
+    std::vector<ThreadBuffer*> getBuffers()
+    {
+        TGE::Lock lock(buffersMutex);
+        return buffers;
+    }
+
+    void writeJsonString(std::ostream& stream, const char* string)
+    {
+        stream << '"';
+        for (const char* c = string; *c; ++c)
+        {
+            if ((*c == '"') || (*c == '\\'))
+                stream << '\\' << *c;
+            else if (static_cast<unsigned char>(*c) < 0x20)
+                stream << ' ';
+            else
+                stream << *c;
+        }
+        stream << '"';
+    }
+
+    void writeJsonTime(std::ostream& stream, TGE::Uint64 nanoseconds)
+    {
+        // Chrome expects microseconds
+        stream << nanoseconds / 1000 << '.' << std::setw(3) << std::setfill('0') << nanoseconds % 1000;
+    }
+
+    void writeUint32(std::ostream& stream, TGE::Uint32 value)
+    {
+        char bytes[4];
+        for (int i = 0; i < 4; ++i)
+            bytes[i] = static_cast<char>((value >> (i * 8)) & 0xFF);
+        stream.write(bytes, 4);
+    }
+
+    void writeUint64(std::ostream& stream, TGE::Uint64 value)
+    {
+        writeUint32(stream, static_cast<TGE::Uint32>(value & 0xFFFFFFFF));
+        writeUint32(stream, static_cast<TGE::Uint32>(value >> 32));
+    }
+}
+
+
+namespace TGE
+{
+////////////////////////////////////////////////////////////
+void Profiler::start()
+{
+    running.store(true);
+}
+
+
+////////////////////////////////////////////////////////////
+void Profiler::stop()
+{
+    running.store(false);
+}
+
+
+////////////////////////////////////////////////////////////
+bool Profiler::isRunning()
+{
+    return running.load(std::memory_order_relaxed);
+}
+
+
+////////////////////////////////////////////////////////////
+void Profiler::clear()
+{
+    Lock lock(buffersMutex);
+
+    for (std::vector<ThreadBuffer*>::iterator it = buffers.begin(); it != buffers.end(); ++it)
+    {
+        ThreadBuffer* buffer = *it;
+
+        Chunk* chunk = buffer->first->next.load();
+        while (chunk)
+        {
+            Chunk* next = chunk->next.load();
+            delete chunk;
+            chunk = next;
+        }
+
+        buffer->first->next.store(NULL);
+        buffer->first->count.store(0);
+        buffer->last = buffer->first;
+    }
+}
+
+
+////////////////////////////////////////////////////////////
+void Profiler::beginZone(const char* name)
+{
+    record(BeginEvent, name, getTimestamp());
+}
+
+
+////////////////////////////////////////////////////////////
+void Profiler::endZone(const char* name)
+{
+    record(EndEvent, name, getTimestamp());
+}
+
+
+////////////////////////////////////////////////////////////
+void Profiler::markFrame()
+{
+    if (isRunning())
+        record(FrameEvent, "Frame", getTimestamp());
+}
+
+
+////////////////////////////////////////////////////////////
+void Profiler::setThreadName(const char* name)
+{
+    getBuffer()->name.store(name);
+}
+
+
+////////////////////////////////////////////////////////////
+Uint64 Profiler::getTimestamp()
+{
+    return priv::ClockImpl::getCurrentNanoseconds();
+}
+
+
+////////////////////////////////////////////////////////////
+bool Profiler::saveChromeTrace(const std::string& filename)
+{
+    std::ofstream file(filename.c_str());
+    if (!file)
+    {
+        Log() << "Failed to save profiler trace to \"" << filename << "\"" << std::endl;
+        return false;
+    }
+
+    file << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+
+    bool first = true;
+    std::vector<ThreadBuffer*> threads = getBuffers();
+    for (std::vector<ThreadBuffer*>::const_iterator it = threads.begin(); it != threads.end(); ++it)
+    {
+        const ThreadBuffer* buffer = *it;
+
+        const char* name = buffer->name.load();
+        if (name)
+        {
+            file << (first ? "\n" : ",\n") << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":0,\"tid\":" << buffer->id << ",\"args\":{\"name\":";
+            writeJsonString(file, name);
+            file << "}}";
+            first = false;
+        }
+
+        for (const Chunk* chunk = buffer->first; chunk; chunk = chunk->next.load(std::memory_order_acquire))
+        {
+            unsigned int count = chunk->count.load(std::memory_order_acquire);
+            for (unsigned int i = 0; i < count; ++i)
+            {
+                const Event& event = chunk->events[i];
+
+                file << (first ? "\n" : ",\n") << "{\"name\":";
+                writeJsonString(file, event.name);
+                switch (event.type)
+                {
+                    case BeginEvent : file << ",\"ph\":\"B\""; break;
+                    case EndEvent :   file << ",\"ph\":\"E\""; break;
+                    case FrameEvent : file << ",\"ph\":\"i\",\"s\":\"g\""; break;
+                }
+                file << ",\"pid\":0,\"tid\":" << buffer->id << ",\"ts\":";
+                writeJsonTime(file, event.time);
+                file << "}";
+                first = false;
+            }
+        }
+    }
+
+    file << "\n]}\n";
+
+    return file.good();
+}
+
+
+////////////////////////////////////////////////////////////
+bool Profiler::saveBinary(const std::string& filename)
+{
+    std::ofstream file(filename.c_str(), std::ios_base::binary);
+    if (!file)
+    {
+        Log() << "Failed to save profiler data to \"" << filename << "\"" << std::endl;
+        return false;
+    }
+
+    std::vector<ThreadBuffer*> threads = getBuffers();
+
+    // Build the string table, and take a snapshot of the event counts
+    // so that the table matches the events written afterwards
+    std::map<std::string, Uint32> indices;
+    std::vector<std::string> strings;
+    std::vector<std::vector<unsigned int> > counts(threads.size());
+    std::vector<const char*> names(threads.size());
+    for (std::size_t t = 0; t < threads.size(); ++t)
+    {
+        const char* name = names[t] = threads[t]->name.load();
+        if (name && indices.insert(std::make_pair(std::string(name), static_cast<Uint32>(strings.size()))).second)
+            strings.push_back(name);
+
+        for (const Chunk* chunk = threads[t]->first; chunk; chunk = chunk->next.load(std::memory_order_acquire))
+        {
+            unsigned int count = chunk->count.load(std::memory_order_acquire);
+            counts[t].push_back(count);
+            for (unsigned int i = 0; i < count; ++i)
+            {
+                if (indices.insert(std::make_pair(std::string(chunk->events[i].name), static_cast<Uint32>(strings.size()))).second)
+                    strings.push_back(chunk->events[i].name);
+            }
+        }
+    }
+
+    file.write("TGEPROF1", 8);
+
+    writeUint32(file, static_cast<Uint32>(strings.size()));
+    for (std::vector<std::string>::const_iterator it = strings.begin(); it != strings.end(); ++it)
+    {
+        writeUint32(file, static_cast<Uint32>(it->size()));
+        file.write(it->data(), it->size());
+    }
+
+    writeUint32(file, static_cast<Uint32>(threads.size()));
+    for (std::size_t t = 0; t < threads.size(); ++t)
+    {
+        writeUint32(file, names[t] ? indices[names[t]] : 0xFFFFFFFF);
+
+        Uint32 total = 0;
+        for (std::size_t c = 0; c < counts[t].size(); ++c)
+            total += counts[t][c];
+        writeUint32(file, total);
+
+        std::size_t c = 0;
+        for (const Chunk* chunk = threads[t]->first; chunk && (c < counts[t].size()); chunk = chunk->next.load(std::memory_order_acquire), ++c)
+        {
+            for (unsigned int i = 0; i < counts[t][c]; ++i)
+            {
+                const Event& event = chunk->events[i];
+                writeUint64(file, event.time);
+                writeUint32(file, indices[event.name]);
+                file.put(static_cast<char>(event.type));
+            }
+        }
+    }
+
+    return file.good();
+}
+
+} // namespace TGE
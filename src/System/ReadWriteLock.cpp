@@ -0,0 +1,90 @@
+/*************************************/
+/** Copyright © 2014 Coldsnap Games **/
+/*************************************/
+
+/*************************************/
+/**             Headers             **/
+/*************************************/
+#include <Tyrant/System/ReadWriteLock.hpp>
+
+#if defined(OS_WINDOWS)
+    #include <Tyrant/System/Win32/ReadWriteLockImpl.hpp>
+#else
+    #include <Tyrant/System/Unix/ReadWriteLockImpl.hpp>
+#endif
+
+
+namespace TGE
+{
+////////////////////////////////////////////////////////////
+ReadWriteLock::ReadWriteLock() :
+m_contentionCount(0)
+{
+    m_lockImpl = new priv::ReadWriteLockImpl;
+}
+
+
+////////////////////////////////////////////////////////////
+ReadWriteLock::~ReadWriteLock()
+{
+    delete m_lockImpl;
+}
+
+
+////////////////////////////////////////////////////////////
+void ReadWriteLock::lockRead()
+{
+    if (!m_lockImpl->tryLockRead())
+    {
+        m_contentionCount.fetch_add(1, std::memory_order_relaxed);
+        m_lockImpl->lockRead();
+    }
+}
+
+
+////////////////////////////////////////////////////////////
+bool ReadWriteLock::tryLockRead()
+{
+    return m_lockImpl->tryLockRead();
+}
+
+
+////////////////////////////////////////////////////////////
+void ReadWriteLock::unlockRead()
+{
+    m_lockImpl->unlockRead();
+}
+
+
+////////////////////////////////////////////////////////////
+void ReadWriteLock::lockWrite()
+{
+    if (!m_lockImpl->tryLockWrite())
+    {
+        m_contentionCount.fetch_add(1, std::memory_order_relaxed);
+        m_lockImpl->lockWrite();
+    }
+}
+
+
+////////////////////////////////////////////////////////////
+bool ReadWriteLock::tryLockWrite()
+{
+    return m_lockImpl->tryLockWrite();
+}
+
+
+////////////////////////////////////////////////////////////
+void ReadWriteLock::unlockWrite()
+{
+    m_lockImpl->unlockWrite();
+}
+
+
+////////////////////////////////////////////////////////////
+unsigned int ReadWriteLock::getContentionCount() const
+{
+    return m_contentionCount.load(std::memory_order_relaxed);
+}
+
+} // namespace TGE
@@ -0,0 +1,60 @@
+/*************************************/
+/** Copyright © 2014 Coldsnap Games **/
+/*************************************/
+
+/*************************************/
+/**             Headers             **/
+/*************************************/
+#include <Tyrant/System/Semaphore.hpp>
+
+#if defined(OS_WINDOWS)
+    #include <Tyrant/System/Win32/SemaphoreImpl.hpp>
+#else
+    #include <Tyrant/System/Unix/SemaphoreImpl.hpp>
+#endif
+
+
+namespace TGE
+{
+////////////////////////////////////////////////////////////
+Semaphore::Semaphore(unsigned int initialCount)
+{
+    m_semaphoreImpl = new priv::SemaphoreImpl(initialCount);
+}
+
+
+////////////////////////////////////////////////////////////
+Semaphore::~Semaphore()
+{
+    delete m_semaphoreImpl;
+}
+
+
+////////////////////////////////////////////////////////////
+void Semaphore::wait()
+{
+    m_semaphoreImpl->wait();
+}
+
+
+////////////////////////////////////////////////////////////
+bool Semaphore::tryWait()
+{
+    return m_semaphoreImpl->tryWait();
+}
+
+
+////////////////////////////////////////////////////////////
+bool Semaphore::tryWait(Time timeout)
+{
+    return m_semaphoreImpl->tryWait(timeout);
+}
+
+
+////////////////////////////////////////////////////////////
+void Semaphore::post()
+{
+    m_semaphoreImpl->post();
+}
+
+} // namespace TGE
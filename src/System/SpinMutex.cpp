@@ -0,0 +1,65 @@
+/*************************************/
+/** Copyright © 2014 Coldsnap Games **/
+/*************************************/
+
+/*************************************/
+/**             Headers             **/
+/*************************************/
+#include <Tyrant/System/SpinMutex.hpp>
+
+#if defined(OS_WINDOWS)
+    #include <Tyrant/System/Win32/SpinMutexImpl.hpp>
+#else
+    #include <Tyrant/System/Unix/SpinMutexImpl.hpp>
+#endif
+
+
+namespace TGE
+{
+////////////////////////////////////////////////////////////
+SpinMutex::SpinMutex() :
+m_contentionCount(0)
+{
+    m_mutexImpl = new priv::SpinMutexImpl;
+}
+
+
+////////////////////////////////////////////////////////////
+SpinMutex::~SpinMutex()
+{
+    delete m_mutexImpl;
+}
+
+
+////////////////////////////////////////////////////////////
+void SpinMutex::lock()
+{
+    if (!m_mutexImpl->tryLock())
+    {
+        m_contentionCount.fetch_add(1, std::memory_order_relaxed);
+        m_mutexImpl->lock();
+    }
+}
+
+
+////////////////////////////////////////////////////////////
+bool SpinMutex::tryLock()
+{
+    return m_mutexImpl->tryLock();
+}
+
+
+////////////////////////////////////////////////////////////
+void SpinMutex::unlock()
+{
+    m_mutexImpl->unlock();
+}
+
+
+////////////////////////////////////////////////////////////
+unsigned int SpinMutex::getContentionCount() const
+{
+    return m_contentionCount.load(std::memory_order_relaxed);
+}
+
+} // namespace TGE
@@ -6,6 +6,7 @@
 /**             Headers             **/
 /*************************************/
 #include <Tyrant/System/Thread.hpp>
+#include <Tyrant/System/MemoryArena.hpp>
 
 
 #if defined(OS_WINDOWS)
@@ -61,6 +62,9 @@ void Thread::terminate()
 void Thread::run()
 {
     m_entryPoint->run();
+
+    // The frame arena of the thread would otherwise live until the program exits
+    MemoryArena::releaseFrameArena();
 }
 
 } // namespace TGE
@@ -39,6 +39,31 @@ Time ClockImpl::getCurrentTime()
 #endif
 }
 
+
+////////////////////////////////////////////////////////////
+Uint64 ClockImpl::getCurrentNanoseconds()
+{
+#if defined(OS_MAC)
+
+    static mach_timebase_info_data_t frequency = {0, 0};
+    if (frequency.denom == 0)
+        mach_timebase_info(&frequency);
+    return mach_absolute_time() * frequency.numer / frequency.denom;
+
+#else
+
+    // The raw clock is not slewed by NTP, so short intervals are exact
+    timespec time;
+    #if defined(CLOCK_MONOTONIC_RAW)
+        clock_gettime(CLOCK_MONOTONIC_RAW, &time);
+    #else
+        clock_gettime(CLOCK_MONOTONIC, &time);
+    #endif
+    return static_cast<Uint64>(time.tv_sec) * 1000000000 + time.tv_nsec;
+
+#endif
+}
+
 } // namespace priv
 
 } // namespace TGE
@@ -0,0 +1,72 @@
+/*************************************/
+/** Copyright © 2014 Coldsnap Games **/
+/*************************************/
+
+/*************************************/
+/**             Headers             **/
+/*************************************/
+#include <Tyrant/System/Unix/ConditionVariableImpl.hpp>
+#include <errno.h>
+#include <sys/time.h>
+
+
+namespace TGE
+{
+namespace priv
+{
+////////////////////////////////////////////////////////////
+ConditionVariableImpl::ConditionVariableImpl()
+{
+    pthread_cond_init(&m_condition, NULL);
+}
+
+
+////////////////////////////////////////////////////////////
+ConditionVariableImpl::~ConditionVariableImpl()
+{
+    pthread_cond_destroy(&m_condition);
+}
+
+
+////////////////////////////////////////////////////////////
+void ConditionVariableImpl::wait(MutexImpl& mutex)
+{
+    pthread_cond_wait(&m_condition, &mutex.m_mutex);
+}
+
+
+////////////////////////////////////////////////////////////
+bool ConditionVariableImpl::wait(MutexImpl& mutex, Time timeout)
+{
+    // pthread wants an absolute time; gettimeofday is used because
+    // clock_gettime is not available on OS X
+    timeval now;
+    gettimeofday(&now, NULL);
+
+    Int64 usecs = static_cast<Int64>(now.tv_usec);
+    if (timeout > Time::Zero)
+        usecs += timeout.asMicroseconds();
+    timespec deadline;
+    deadline.tv_sec  = now.tv_sec + static_cast<time_t>(usecs / 1000000);
+    deadline.tv_nsec = static_cast<long>(usecs % 1000000) * 1000;
+
+    return pthread_cond_timedwait(&m_condition, &mutex.m_mutex, &deadline) != ETIMEDOUT;
+}
+
+
+////////////////////////////////////////////////////////////
+void ConditionVariableImpl::notifyOne()
+{
+    pthread_cond_signal(&m_condition);
+}
+
+
+////////////////////////////////////////////////////////////
+void ConditionVariableImpl::notifyAll()
+{
+    pthread_cond_broadcast(&m_condition);
+}
+
+} // namespace priv
+
+} // namespace TGE
@@ -13,14 +13,14 @@ namespace TGE
 namespace priv
 {
 ////////////////////////////////////////////////////////////
-MutexImpl::MutexImpl()
+MutexImpl::MutexImpl(bool recursive)
 {
-    // Make it recursive to follow the expected behaviour
     pthread_mutexattr_t attributes;
     pthread_mutexattr_init(&attributes);
-    pthread_mutexattr_settype(&attributes, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutexattr_settype(&attributes, recursive ? PTHREAD_MUTEX_RECURSIVE : PTHREAD_MUTEX_NORMAL);
 
     pthread_mutex_init(&m_mutex, &attributes);
+    pthread_mutexattr_destroy(&attributes);
 }
 
 
@@ -38,6 +38,13 @@ void MutexImpl::lock()
 }
 
 
+////////////////////////////////////////////////////////////
+bool MutexImpl::tryLock()
+{
+    return pthread_mutex_trylock(&m_mutex) == 0;
+}
+
+
 ////////////////////////////////////////////////////////////
 void MutexImpl::unlock()
 {
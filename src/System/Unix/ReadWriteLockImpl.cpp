@@ -0,0 +1,82 @@
+/*************************************/
+/** Copyright © 2014 Coldsnap Games **/
+/*************************************/
+
+/*************************************/
+/**             Headers             **/
+/*************************************/
+#include <Tyrant/System/Unix/ReadWriteLockImpl.hpp>
+
+
+namespace TGE
+{
+namespace priv
+{
+////////////////////////////////////////////////////////////
+ReadWriteLockImpl::ReadWriteLockImpl()
+{
+    pthread_rwlockattr_t attributes;
+    pthread_rwlockattr_init(&attributes);
+
+    // The default glibc lock lets new readers in while a writer waits;
+    // the other systems already block them
+#if defined(__GLIBC__)
+    pthread_rwlockattr_setkind_np(&attributes, PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);
+#endif
+
+    pthread_rwlock_init(&m_lock, &attributes);
+    pthread_rwlockattr_destroy(&attributes);
+}
+
+
+////////////////////////////////////////////////////////////
+ReadWriteLockImpl::~ReadWriteLockImpl()
+{
+    pthread_rwlock_destroy(&m_lock);
+}
+
+
+////////////////////////////////////////////////////////////
+void ReadWriteLockImpl::lockRead()
+{
+    pthread_rwlock_rdlock(&m_lock);
+}
+
+
+////////////////////////////////////////////////////////////
+bool ReadWriteLockImpl::tryLockRead()
+{
+    return pthread_rwlock_tryrdlock(&m_lock) == 0;
+}
+
+
+////////////////////////////////////////////////////////////
+void ReadWriteLockImpl::unlockRead()
+{
+    pthread_rwlock_unlock(&m_lock);
+}
+
+
+////////////////////////////////////////////////////////////
+void ReadWriteLockImpl::lockWrite()
+{
+    pthread_rwlock_wrlock(&m_lock);
+}
+
+
+////////////////////////////////////////////////////////////
+bool ReadWriteLockImpl::tryLockWrite()
+{
+    return pthread_rwlock_trywrlock(&m_lock) == 0;
+}
+
+
+////////////////////////////////////////////////////////////
+void ReadWriteLockImpl::unlockWrite()
+{
+    pthread_rwlock_unlock(&m_lock);
+}
+
+} // namespace priv
+
+} // namespace TGE
@@ -0,0 +1,99 @@
+/*************************************/
+/** Copyright © 2014 Coldsnap Games **/
+/*************************************/
+
+/*************************************/
+/**             Headers             **/
+/*************************************/
+#include <Tyrant/System/Unix/SemaphoreImpl.hpp>
+#include <errno.h>
+#include <sys/time.h>
+
+
+namespace TGE
+{
+namespace priv
+{
+////////////////////////////////////////////////////////////
+SemaphoreImpl::SemaphoreImpl(unsigned int initialCount) :
+m_count(initialCount)
+{
+    // Unnamed POSIX semaphores are not available on OS X,
+    // so the counter is built on a mutex and a condition
+    pthread_mutex_init(&m_mutex, NULL);
+    pthread_cond_init(&m_condition, NULL);
+}
+
+
+////////////////////////////////////////////////////////////
+SemaphoreImpl::~SemaphoreImpl()
+{
+    pthread_cond_destroy(&m_condition);
+    pthread_mutex_destroy(&m_mutex);
+}
+
+
+////////////////////////////////////////////////////////////
+void SemaphoreImpl::wait()
+{
+    pthread_mutex_lock(&m_mutex);
+    while (m_count == 0)
+        pthread_cond_wait(&m_condition, &m_mutex);
+    --m_count;
+    pthread_mutex_unlock(&m_mutex);
+}
+
+
+////////////////////////////////////////////////////////////
+bool SemaphoreImpl::tryWait()
+{
+    pthread_mutex_lock(&m_mutex);
+    bool acquired = m_count > 0;
+    if (acquired)
+        --m_count;
+    pthread_mutex_unlock(&m_mutex);
+
+    return acquired;
+}
+
+
+////////////////////////////////////////////////////////////
+bool SemaphoreImpl::tryWait(Time timeout)
+{
+    timeval now;
+    gettimeofday(&now, NULL);
+
+    Int64 usecs = static_cast<Int64>(now.tv_usec);
+    if (timeout > Time::Zero)
+        usecs += timeout.asMicroseconds();
+
+    timespec deadline;
+    deadline.tv_sec  = now.tv_sec + static_cast<time_t>(usecs / 1000000);
+    deadline.tv_nsec = static_cast<long>(usecs % 1000000) * 1000;
+
+    pthread_mutex_lock(&m_mutex);
+    bool timedOut = false;
+    while ((m_count == 0) && !timedOut)
+        timedOut = pthread_cond_timedwait(&m_condition, &m_mutex, &deadline) == ETIMEDOUT;
+
+    bool acquired = m_count > 0;
+    if (acquired)
+        --m_count;
+    pthread_mutex_unlock(&m_mutex);
+
+    return acquired;
+}
+
+
+////////////////////////////////////////////////////////////
+void SemaphoreImpl::post()
+{
+    pthread_mutex_lock(&m_mutex);
+    ++m_count;
+    pthread_mutex_unlock(&m_mutex);
+    pthread_cond_signal(&m_condition);
+}
+
+} // namespace priv
+
+} // namespace TGE
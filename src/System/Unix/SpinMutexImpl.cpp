@@ -0,0 +1,147 @@
+/*************************************/
+/** Copyright © 2014 Coldsnap Games **/
+/*************************************/
+
+/*************************************/
+/**             Headers             **/
+/*************************************/
+#include <Tyrant/System/Unix/SpinMutexImpl.hpp>
+#if defined(OS_LINUX)
+    #include <linux/futex.h>
+    #include <sys/syscall.h>
+    #include <unistd.h>
+#endif
+
+
+namespace
+{
+    // Number of attempts to take the mutex before sleeping
+    const unsigned int spinCount = 100;
+
+    // Tell the CPU that we are spinning
+    inline void cpuRelax()
+    {
+    #if defined(__i386__) || defined(__x86_64__)
+        __builtin_ia32_pause();
+    #endif
+    }
+
+#if defined(OS_LINUX)
+    inline void futexWait(std::atomic<int>* address, int value)
+    {
+        syscall(SYS_futex, reinterpret_cast<int*>(address), FUTEX_WAIT_PRIVATE, value, NULL, NULL, 0);
+    }
+
+    inline void futexWake(std::atomic<int>* address)
+    {
+        syscall(SYS_futex, reinterpret_cast<int*>(address), FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+    }
+#endif
+}
+
+
+namespace TGE
+{
+namespace priv
+{
+#if defined(OS_LINUX)
+
+////////////////////////////////////////////////////////////
+SpinMutexImpl::SpinMutexImpl() :
+m_state(0)
+{
+}
+
+
+////////////////////////////////////////////////////////////
+SpinMutexImpl::~SpinMutexImpl()
+{
+}
+
+
+////////////////////////////////////////////////////////////
+void SpinMutexImpl::lock()
+{
+    // Spin while the owner is likely to release the mutex soon
+    for (unsigned int i = 0; i < spinCount; ++i)
+    {
+        if ((m_state.load(std::memory_order_relaxed) == 0) && tryLock())
+            return;
+        cpuRelax();
+    }
+
+    // Sleep until the mutex is released; the state is set to 2 so
+    // that the owner knows that it must wake us up ("Futexes are
+    // tricky", U. Drepper)
+    int state = m_state.exchange(2, std::memory_order_acquire);
+    while (state != 0)
+    {
+        futexWait(&m_state, 2);
+        state = m_state.exchange(2, std::memory_order_acquire);
+    }
+}
+
+
+////////////////////////////////////////////////////////////
+bool SpinMutexImpl::tryLock()
+{
+    int expected = 0;
+    return m_state.compare_exchange_strong(expected, 1, std::memory_order_acquire, std::memory_order_relaxed);
+}
+
+
+////////////////////////////////////////////////////////////
+void SpinMutexImpl::unlock()
+{
+    if (m_state.exchange(0, std::memory_order_release) == 2)
+        futexWake(&m_state);
+}
+
+#else
+
+////////////////////////////////////////////////////////////
+SpinMutexImpl::SpinMutexImpl()
+{
+    pthread_mutex_init(&m_mutex, NULL);
+}
+
+
+////////////////////////////////////////////////////////////
+SpinMutexImpl::~SpinMutexImpl()
+{
+    pthread_mutex_destroy(&m_mutex);
+}
+
+
+////////////////////////////////////////////////////////////
+void SpinMutexImpl::lock()
+{
+    for (unsigned int i = 0; i < spinCount; ++i)
+    {
+        if (tryLock())
+            return;
+        cpuRelax();
+    }
+
+    pthread_mutex_lock(&m_mutex);
+}
+
+
+////////////////////////////////////////////////////////////
+bool SpinMutexImpl::tryLock()
+{
+    return pthread_mutex_trylock(&m_mutex) == 0;
+}
+
+
+////////////////////////////////////////////////////////////
+void SpinMutexImpl::unlock()
+{
+    pthread_mutex_unlock(&m_mutex);
+}
+
+#endif
+
+} // namespace priv
+
+} // namespace TGE
@@ -46,6 +46,24 @@ Time ClockImpl::getCurrentTime()
     return TGE::microseconds(1000000 * time.QuadPart / frequency.QuadPart);
 }
 
+
+////////////////////////////////////////////////////////////
+Uint64 ClockImpl::getCurrentNanoseconds()
+{
+    // Unlike getCurrentTime(), the thread affinity is not changed: it
+    // costs far more than the counter read itself, and the performance
+    // counter is synchronized across cores on current systems
+    static LARGE_INTEGER frequency = getFrequency();
+
+    LARGE_INTEGER time;
+    QueryPerformanceCounter(&time);
+
+    // Split the conversion to avoid overflowing 64 bits
+    Uint64 seconds   = time.QuadPart / frequency.QuadPart;
+    Uint64 remainder = time.QuadPart % frequency.QuadPart;
+    return seconds * 1000000000 + remainder * 1000000000 / frequency.QuadPart;
+}
+
 } // namespace priv
 
 } // namespace TGE
@@ -0,0 +1,119 @@
+/*************************************/
+/** Copyright © 2014 Coldsnap Games **/
+/*************************************/
+
+/*************************************/
+/**             Headers             **/
+/*************************************/
+#include <Tyrant/System/Win32/ConditionVariableImpl.hpp>
+#include <algorithm>
+
+
+namespace TGE
+{
+namespace priv
+{
+////////////////////////////////////////////////////////////
+ConditionVariableImpl::ConditionVariableImpl()
+{
+    InitializeCriticalSection(&m_lock);
+}
+
+
+////////////////////////////////////////////////////////////
+ConditionVariableImpl::~ConditionVariableImpl()
+{
+    for (std::vector<HANDLE>::iterator it = m_events.begin(); it != m_events.end(); ++it)
+        CloseHandle(*it);
+
+    DeleteCriticalSection(&m_lock);
+}
+
+
+////////////////////////////////////////////////////////////
+void ConditionVariableImpl::wait(MutexImpl& mutex)
+{
+    waitEvent(mutex, INFINITE);
+}
+
+
+////////////////////////////////////////////////////////////
+bool ConditionVariableImpl::wait(MutexImpl& mutex, Time timeout)
+{
+    return waitEvent(mutex, timeout > Time::Zero ? static_cast<DWORD>(timeout.asMilliseconds()) : 0);
+}
+
+
+////////////////////////////////////////////////////////////
+bool ConditionVariableImpl::waitEvent(MutexImpl& mutex, DWORD milliseconds)
+{
+    // Register an event for this thread, while the caller still holds
+    // the mutex: a notification sent after we release it can't be lost
+    EnterCriticalSection(&m_lock);
+    HANDLE event;
+    if (m_events.empty())
+    {
+        event = CreateEvent(NULL, FALSE, FALSE, NULL);
+    }
+    else
+    {
+        event = m_events.back();
+        m_events.pop_back();
+    }
+    m_waiters.push_back(event);
+    LeaveCriticalSection(&m_lock);
+
+    LeaveCriticalSection(&mutex.m_mutex);
+    bool notified = WaitForSingleObject(event, milliseconds) == WAIT_OBJECT_0;
+
+    EnterCriticalSection(&m_lock);
+    if (!notified)
+    {
+        std::deque<HANDLE>::iterator it = std::find(m_waiters.begin(), m_waiters.end(), event);
+        if (it != m_waiters.end())
+        {
+            m_waiters.erase(it);
+        }
+        else
+        {
+            // Notified right after the timeout: consume the signal
+            // so that the event can be reused
+            WaitForSingleObject(event, INFINITE);
+            notified = true;
+        }
+    }
+    m_events.push_back(event);
+    LeaveCriticalSection(&m_lock);
+
+    EnterCriticalSection(&mutex.m_mutex);
+
+    return notified;
+}
+
+
+////////////////////////////////////////////////////////////
+void ConditionVariableImpl::notifyOne()
+{
+    EnterCriticalSection(&m_lock);
+    if (!m_waiters.empty())
+    {
+        SetEvent(m_waiters.front());
+        m_waiters.pop_front();
+    }
+    LeaveCriticalSection(&m_lock);
+}
+
+
+////////////////////////////////////////////////////////////
+void ConditionVariableImpl::notifyAll()
+{
+    EnterCriticalSection(&m_lock);
+    for (std::deque<HANDLE>::iterator it = m_waiters.begin(); it != m_waiters.end(); ++it)
+        SetEvent(*it);
+    m_waiters.clear();
+    LeaveCriticalSection(&m_lock);
+}
+
+} // namespace priv
+
+} // namespace TGE
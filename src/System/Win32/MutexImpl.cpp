@@ -13,8 +13,9 @@ namespace TGE
 namespace priv
 {
 ////////////////////////////////////////////////////////////
-MutexImpl::MutexImpl()
+MutexImpl::MutexImpl(bool)
 {
+    // Critical sections are always recursive
     InitializeCriticalSection(&m_mutex);
 }
 
@@ -33,6 +34,13 @@ void MutexImpl::lock()
 }
 
 
+////////////////////////////////////////////////////////////
+bool MutexImpl::tryLock()
+{
+    return TryEnterCriticalSection(&m_mutex) != 0;
+}
+
+
 ////////////////////////////////////////////////////////////
 void MutexImpl::unlock()
 {
@@ -0,0 +1,99 @@
+/*************************************/
+/** Copyright © 2014 Coldsnap Games **/
+/*************************************/
+
+/*************************************/
+/**             Headers             **/
+/*************************************/
+#include <Tyrant/System/Win32/ReadWriteLockImpl.hpp>
+
+
+namespace TGE
+{
+namespace priv
+{
+////////////////////////////////////////////////////////////
+ReadWriteLockImpl::ReadWriteLockImpl() :
+m_readerCount(0)
+{
+    InitializeCriticalSection(&m_writerGate);
+    m_noReaders = CreateEvent(NULL, FALSE, FALSE, NULL);
+}
+
+
+////////////////////////////////////////////////////////////
+ReadWriteLockImpl::~ReadWriteLockImpl()
+{
+    CloseHandle(m_noReaders);
+    DeleteCriticalSection(&m_writerGate);
+}
+
+
+////////////////////////////////////////////////////////////
+void ReadWriteLockImpl::lockRead()
+{
+    // Going through the gate makes new readers wait behind a writer
+    EnterCriticalSection(&m_writerGate);
+    InterlockedIncrement(&m_readerCount);
+    LeaveCriticalSection(&m_writerGate);
+}
+
+
+////////////////////////////////////////////////////////////
+bool ReadWriteLockImpl::tryLockRead()
+{
+    if (!TryEnterCriticalSection(&m_writerGate))
+        return false;
+
+    InterlockedIncrement(&m_readerCount);
+    LeaveCriticalSection(&m_writerGate);
+
+    return true;
+}
+
+
+////////////////////////////////////////////////////////////
+void ReadWriteLockImpl::unlockRead()
+{
+    if (InterlockedDecrement(&m_readerCount) == 0)
+        SetEvent(m_noReaders);
+}
+
+
+////////////////////////////////////////////////////////////
+void ReadWriteLockImpl::lockWrite()
+{
+    // Close the gate, then wait for the readers already inside to leave;
+    // the event may have been left signaled by older readers, so the
+    // count is checked again after each wake up
+    EnterCriticalSection(&m_writerGate);
+    while (InterlockedCompareExchange(&m_readerCount, 0, 0) != 0)
+        WaitForSingleObject(m_noReaders, INFINITE);
+}
+
+
+////////////////////////////////////////////////////////////
+bool ReadWriteLockImpl::tryLockWrite()
+{
+    if (!TryEnterCriticalSection(&m_writerGate))
+        return false;
+
+    if (InterlockedCompareExchange(&m_readerCount, 0, 0) != 0)
+    {
+        LeaveCriticalSection(&m_writerGate);
+        return false;
+    }
+
+    return true;
+}
+
+
+////////////////////////////////////////////////////////////
+void ReadWriteLockImpl::unlockWrite()
+{
+    LeaveCriticalSection(&m_writerGate);
+}
+
+} // namespace priv
+
+} // namespace TGE
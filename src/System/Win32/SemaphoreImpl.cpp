@@ -0,0 +1,61 @@
+/*************************************/
+/** Copyright © 2014 Coldsnap Games **/
+/*************************************/
+
+/*************************************/
+/**             Headers             **/
+/*************************************/
+#include <Tyrant/System/Win32/SemaphoreImpl.hpp>
+#include <climits>
+
+
+namespace TGE
+{
+namespace priv
+{
+////////////////////////////////////////////////////////////
+SemaphoreImpl::SemaphoreImpl(unsigned int initialCount)
+{
+    m_semaphore = CreateSemaphore(NULL, initialCount, LONG_MAX, NULL);
+}
+
+
+////////////////////////////////////////////////////////////
+SemaphoreImpl::~SemaphoreImpl()
+{
+    CloseHandle(m_semaphore);
+}
+
+
+////////////////////////////////////////////////////////////
+void SemaphoreImpl::wait()
+{
+    WaitForSingleObject(m_semaphore, INFINITE);
+}
+
+
+////////////////////////////////////////////////////////////
+bool SemaphoreImpl::tryWait()
+{
+    return WaitForSingleObject(m_semaphore, 0) == WAIT_OBJECT_0;
+}
+
+
+////////////////////////////////////////////////////////////
+bool SemaphoreImpl::tryWait(Time timeout)
+{
+    DWORD milliseconds = timeout > Time::Zero ? static_cast<DWORD>(timeout.asMilliseconds()) : 0;
+
+    return WaitForSingleObject(m_semaphore, milliseconds) == WAIT_OBJECT_0;
+}
+
+
+////////////////////////////////////////////////////////////
+void SemaphoreImpl::post()
+{
+    ReleaseSemaphore(m_semaphore, 1, NULL);
+}
+
+} // namespace priv
+
+} // namespace TGE
@@ -0,0 +1,52 @@
+/*************************************/
+/** Copyright © 2014 Coldsnap Games **/
+/*************************************/
+
+/*************************************/
+/**             Headers             **/
+/*************************************/
+#include <Tyrant/System/Win32/SpinMutexImpl.hpp>
+
+
+namespace TGE
+{
+namespace priv
+{
+////////////////////////////////////////////////////////////
+SpinMutexImpl::SpinMutexImpl()
+{
+    // Spin count recommended by Microsoft for short critical sections
+    InitializeCriticalSectionAndSpinCount(&m_mutex, 4000);
+}
+
+
+////////////////////////////////////////////////////////////
+SpinMutexImpl::~SpinMutexImpl()
+{
+    DeleteCriticalSection(&m_mutex);
+}
+
+
+////////////////////////////////////////////////////////////
+void SpinMutexImpl::lock()
+{
+    EnterCriticalSection(&m_mutex);
+}
+
+
+////////////////////////////////////////////////////////////
+bool SpinMutexImpl::tryLock()
+{
+    return TryEnterCriticalSection(&m_mutex) != 0;
+}
+
+
+////////////////////////////////////////////////////////////
+void SpinMutexImpl::unlock()
+{
+    LeaveCriticalSection(&m_mutex);
+}
+
+} // namespace priv
+
+} // namespace TGE
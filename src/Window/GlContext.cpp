@@ -44,7 +44,7 @@ namespace
     // Internal contexts
     TGE::ThreadLocalPtr<TGE::priv::GlContext> internalContext(NULL);
     std::set<TGE::priv::GlContext*> internalContexts;
-    TGE::Mutex internalContextsMutex;
+    TGE::Mutex internalContextsMutex(TGE::Mutex::NonRecursive);
 
     // Check if the internal context of the current thread is valid
     bool hasInternalContext()
@@ -9,12 +9,16 @@
 #include <Tyrant/Window/GlContext.hpp>
 #include <Tyrant/Window/WindowImpl.hpp>
 #include <Tyrant/System/Sleep.hpp>
+#include <Tyrant/System/MemoryArena.hpp>
 #include <Tyrant/System/Log.hpp>
 
 
 namespace
 {
     const TGE::Window* fullscreenWindow = NULL;
+
+    // Remaining frame time under which display() spins instead of sleeping
+    const TGE::Time frameSpinThreshold = TGE::milliseconds(2);
 }
 
 
@@ -25,6 +29,7 @@ Window::Window() :
 m_impl          (NULL),
 m_context       (NULL),
 m_frameTimeLimit(Time::Zero),
+m_nextFrameTime (Time::Zero),
 m_size          (0, 0)
 {
 
@@ -36,6 +41,7 @@ Window::Window(VideoMode mode, const String& title, Uint32 style, const ContextS
 m_impl          (NULL),
 m_context       (NULL),
 m_frameTimeLimit(Time::Zero),
+m_nextFrameTime (Time::Zero),
 m_size          (0, 0)
 {
     create(mode, title, style, settings);
@@ -47,6 +53,7 @@ Window::Window(WindowHandle handle, const ContextSettings& settings) :
 m_impl          (NULL),
 m_context       (NULL),
 m_frameTimeLimit(Time::Zero),
+m_nextFrameTime (Time::Zero),
 m_size          (0, 0)
 {
     create(handle, settings);
@@ -276,6 +283,9 @@ void Window::setFramerateLimit(unsigned int limit)
         m_frameTimeLimit = seconds(1.f / limit);
     else
         m_frameTimeLimit = Time::Zero;
+
+    // Restart the frame schedule from now
+    m_nextFrameTime = m_clock.getElapsedTime();
 }
 
 
@@ -316,11 +326,35 @@ void Window::display()
     if (setActive())
         m_context->display();
 
+    // The temporaries of this frame are not needed anymore
+    MemoryArena::getFrameArena().reset();
+
     // Limit the framerate if needed
     if (m_frameTimeLimit != Time::Zero)
     {
-        sleep(m_frameTimeLimit - m_clock.getElapsedTime());
-        m_clock.restart();
+        // Frames are scheduled on a fixed grid, so that a frame which
+        // ends a bit late doesn't delay all the following ones
+        m_nextFrameTime += m_frameTimeLimit;
+        Time now = m_clock.getElapsedTime();
+
+        if (now < m_nextFrameTime)
+        {
+            // Sleep for the bulk of the remaining time, stopping early since
+            // the OS may wake us up to a scheduler tick late...
+            Time remaining = m_nextFrameTime - now;
+            if (remaining > frameSpinThreshold)
+                sleep(remaining - frameSpinThreshold);
+
+            // ... then spin on the clock until the exact deadline
+            while (m_clock.getElapsedTime() < m_nextFrameTime)
+            {
+            }
+        }
+        else if (now - m_nextFrameTime > m_frameTimeLimit)
+        {
+            // We missed more than a whole frame, don't try to catch up
+            m_nextFrameTime = now;
+        }
     }
 }
 
@@ -379,6 +413,7 @@ void Window::initialize()
 
     // Reset frame time
     m_clock.restart();
+    m_nextFrameTime = Time::Zero;
 
     // Activate the window
     setActive();
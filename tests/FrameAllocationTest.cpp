@@ -0,0 +1,244 @@
+/*************************************/
+/** Copyright © 2014 Coldsnap Games **/
+/*************************************/
+
+/*************************************/
+/**             Headers             **/
+/*************************************/
+#include <Tyrant/Graphics.hpp>
+#include <Tyrant/Framework/FrameStatistics.hpp>
+#include <Tyrant/System/AllocationCounter.hpp>
+#include <Tyrant/System/ArenaAllocator.hpp>
+#include <Tyrant/System/Clock.hpp>
+#include <Tyrant/System/MemoryArena.hpp>
+#include <cstdio>
+#include <vector>
+
+
+////////////////////////////////////////////////////////////
+/// Checks that the frames of a steady scene don't allocate:
+/// each frame updates the drawables, copies the drawable
+/// stack into the frame arena and records it into a
+/// TGE::RenderQueue by depth like TGE::Game, replays the
+/// queue on a target, then resets the frame arena like
+/// Window::display().
+///
+/// The allocations of each frame are recorded in a
+/// TGE::FrameStatistics; after the first frames, which size
+/// the queue and the arena, there must be none.
+///
+/// The engine must be built with COUNT_ALLOCATIONS=1, which
+/// the ALLOCATION_TEST target of the Makefile does.
+///
+/// Usage: FrameAllocationTest
+///
+////////////////////////////////////////////////////////////
+namespace
+{
+    // Number of frames run, and of the first ones allowed to allocate
+    const unsigned int FrameCount = 500;
+    const unsigned int WarmupFrameCount = 5;
+
+    // Number of shapes of each kind in the scene, and of depths they are spread over
+    const unsigned int ShapeCount = 200;
+    const unsigned int DepthCount = 4;
+
+    // Number of different strings shown by the text
+    const unsigned int StringCount = 8;
+
+    int failures = 0;
+
+    void check(bool condition, const char* what)
+    {
+        if (!condition)
+        {
+            std::printf("FAILED: %s\n", what);
+            failures++;
+        }
+    }
+
+
+    ////////////////////////////////////////////////////////////
+    /// Render target counting what it receives, without
+    /// keeping it
+    ////////////////////////////////////////////////////////////
+    class CountingTarget : public TGE::RenderTarget
+    {
+    public :
+
+        CountingTarget() : vertexCount(0), textCount(0)
+        {
+            initialize();
+        }
+
+        virtual TGE::Vector2u getSize() const
+        {
+            return TGE::Vector2u(800, 600);
+        }
+
+        std::size_t vertexCount;
+        std::size_t textCount;
+
+    private :
+
+        virtual bool activate(bool)
+        {
+            return false;
+        }
+
+        virtual bool interceptDraw(const TGE::Vertex*, unsigned int count, TGE::PrimitiveType, const TGE::RenderStates&)
+        {
+            vertexCount += count;
+            return true;
+        }
+
+        virtual bool interceptText(const TGE::Text&, const TGE::RenderStates&)
+        {
+            textCount++;
+            return true;
+        }
+    };
+
+
+    ////////////////////////////////////////////////////////////
+    /// Scene of moving shapes and a text, at several depths
+    ////////////////////////////////////////////////////////////
+    struct Scene
+    {
+        Scene() :
+        boxes  (ShapeCount),
+        circles(ShapeCount)
+        {
+            for (unsigned int i = 0; i < ShapeCount; ++i)
+            {
+                boxes[i].setDepth(i % DepthCount);
+                circles[i].setDepth((i + 1) % DepthCount);
+                stack.push_back(&boxes[i]);
+                stack.push_back(&circles[i]);
+            }
+
+            // Changing strings are built in advance, as a game would keep its labels
+            for (unsigned int i = 0; i < StringCount; ++i)
+            {
+                char string[32];
+                std::sprintf(string, "score %u", i * 1000);
+                strings.push_back(TGE::String(string));
+            }
+
+            label.setFont(font);
+            label.setDepth(DepthCount - 1);
+            stack.push_back(&label);
+        }
+
+        void update(unsigned int frame)
+        {
+            float time = static_cast<float>(frame);
+            for (unsigned int i = 0; i < ShapeCount; ++i)
+            {
+                boxes[i].setSize(TGE::Vector2f(10.f + i % 7, 5.f + frame % 11));
+                boxes[i].setPosition(time + i, 2.f * i);
+                boxes[i].setRotation(time);
+                boxes[i].setFillColor(TGE::Color(frame % 256, i % 256, 7));
+
+                circles[i].setRadius(3.f + frame % 5);
+                circles[i].setPosition(i, time);
+            }
+
+            label.setString(strings[frame % StringCount]);
+            label.setPosition(time, 1.f);
+        }
+
+        // Record the stack by depth, the way TGE::Game does
+        void record(TGE::RenderQueue& queue)
+        {
+            typedef std::vector<TGE::Drawable*, TGE::ArenaAllocator<TGE::Drawable*> > FrameStack;
+            FrameStack sorted(stack.begin(), stack.end(), TGE::ArenaAllocator<TGE::Drawable*>(TGE::MemoryArena::getFrameArena()));
+
+            queue.reset();
+            for (unsigned int depth = 0; depth < DepthCount; ++depth)
+            {
+                for (FrameStack::iterator it = sorted.begin(); it != sorted.end(); ++it)
+                {
+                    if (((*it)->getDepth() == static_cast<int>(depth)) && (*it)->getVisible())
+                        queue.draw(**it);
+                }
+            }
+        }
+
+        std::vector<TGE::RectangleShape> boxes;
+        std::vector<TGE::CircleShape>    circles;
+        std::vector<TGE::String>         strings;
+        TGE::Font                        font;
+        TGE::Text                        label;
+        std::vector<TGE::Drawable*>      stack;
+    };
+}
+
+
+////////////////////////////////////////////////////////////
+int main()
+{
+    if (!TGE::AllocationCounter::isEnabled())
+    {
+        std::printf("FrameAllocationTest: the engine must be built with COUNT_ALLOCATIONS=1\n");
+        return 1;
+    }
+
+    // The counter sees the allocations of the program
+    TGE::Uint32 before = TGE::AllocationCounter::getCount();
+    delete new int(0);
+    check(TGE::AllocationCounter::getCount() - before == 1, "allocation counted");
+
+    Scene scene;
+    TGE::RenderQueue queue;
+    queue.setSize(TGE::Vector2u(800, 600));
+    CountingTarget target;
+    TGE::FrameStatistics statistics;
+    TGE::Uint32 warmupAllocations = 0;
+    TGE::Clock clock;
+
+    for (unsigned int frame = 0; frame < FrameCount; ++frame)
+    {
+        before = TGE::AllocationCounter::getCount();
+
+        scene.update(frame);
+        scene.record(queue);
+        queue.replay(target);
+        TGE::MemoryArena::getFrameArena().reset();
+
+        statistics.addFrame(clock.restart(), TGE::AllocationCounter::getCount() - before);
+
+        // Only the steady frames are kept
+        if (frame < WarmupFrameCount)
+        {
+            warmupAllocations += statistics.getLastAllocationCount();
+            if (frame == WarmupFrameCount - 1)
+                statistics.clear();
+        }
+        else if (statistics.getLastAllocationCount() > 0)
+        {
+            std::printf("frame %u: %u allocations\n", frame, statistics.getLastAllocationCount());
+        }
+    }
+
+    check(queue.getCommandCount() == 2 * ShapeCount + 1, "every drawable recorded");
+    check((target.textCount == FrameCount) && (target.vertexCount > 0), "every frame replayed");
+    check(statistics.getFrameCount() == FrameCount - WarmupFrameCount, "steady frames recorded");
+    check(statistics.getMaxAllocationCount() == 0, "steady frames make no heap allocation");
+
+    std::printf("%u allocations in the first %u frames, at most %u in the next %u, p99 %.3f ms\n",
+                warmupAllocations,
+                WarmupFrameCount,
+                statistics.getMaxAllocationCount(),
+                statistics.getFrameCount(),
+                statistics.getPercentile(99).asSeconds() * 1000);
+
+    if (failures > 0)
+    {
+        std::printf("FrameAllocationTest: %d failures\n", failures);
+        return 1;
+    }
+
+    std::printf("FrameAllocationTest: steady frames recorded and replayed without touching the heap\n");
+    return 0;
+}
@@ -0,0 +1,538 @@
+/*************************************/
+/** Copyright © 2014 Coldsnap Games **/
+/*************************************/
+
+/*************************************/
+/**             Headers             **/
+/*************************************/
+#include <Tyrant/Network.hpp>
+#include <Tyrant/System/Clock.hpp>
+#include <Tyrant/System/Lock.hpp>
+#include <Tyrant/System/Mutex.hpp>
+#include <Tyrant/System/Sleep.hpp>
+#include <Tyrant/System/Thread.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+
+////////////////////////////////////////////////////////////
+/// Checks the file transfers of TGE::Ftp against a minimal
+/// FTP server running in the same process, which keeps its
+/// files in memory and supports PASV, SIZE and REST.
+///
+/// Downloads and uploads must be intact and report their
+/// progress; a transfer aborted by its progress callback
+/// must resume where it stopped, or start over when the
+/// server refuses REST; and downloadFiles must use several
+/// connections at once, each one throttled by the server.
+///
+/// Usage: FtpTest [port]
+///
+////////////////////////////////////////////////////////////
+namespace
+{
+    // Size of the large file transferred
+    const std::size_t LargeFileSize = 3 * 1024 * 1024 + 321;
+
+    // Number and size of the files downloaded at once
+    const std::size_t SmallFileCount = 8;
+    const std::size_t SmallFileSize = 64 * 1024;
+
+    // Time the server waits before sending each file to downloadFiles
+    const TGE::Time Throttle = TGE::milliseconds(50);
+
+    // Names of the files, in the current directory and on the server
+    const std::string LargeFile = "FtpTest.large";
+    const std::string UploadFile = "FtpTest.upload";
+
+    unsigned short port = 48200;
+    int failures = 0;
+
+    void check(bool condition, const char* what)
+    {
+        if (!condition)
+        {
+            std::printf("FAILED: %s\n", what);
+            failures++;
+        }
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// FTP server with one thread per control connection,
+    /// transferring its files in passive mode
+    ////////////////////////////////////////////////////////////
+    class Server
+    {
+    public :
+
+        Server() :
+        restEnabled     (true),
+        throttle        (TGE::Time::Zero),
+        m_thread        (&Server::run, this),
+        m_stop          (false),
+        m_transfers     (0),
+        m_peakTransfers (0)
+        {
+        }
+
+        bool start()
+        {
+            if (m_listener.listen(port) != TGE::Socket::Done)
+                return false;
+
+            m_thread.launch();
+            return true;
+        }
+
+        void stop()
+        {
+            m_stop = true;
+            m_thread.wait();
+        }
+
+        void setFile(const std::string& name, const std::string& content)
+        {
+            TGE::Lock lock(m_mutex);
+            m_files[name] = content;
+        }
+
+        std::string getFile(const std::string& name)
+        {
+            TGE::Lock lock(m_mutex);
+            return m_files[name];
+        }
+
+        // Offsets accepted by REST since the last call
+        std::vector<TGE::Uint64> takeRestarts()
+        {
+            TGE::Lock lock(m_mutex);
+            std::vector<TGE::Uint64> restarts;
+            restarts.swap(m_restarts);
+            return restarts;
+        }
+
+        // Maximum number of files transferred at once since the last call
+        std::size_t takePeakTransfers()
+        {
+            TGE::Lock lock(m_mutex);
+            std::size_t peak = m_peakTransfers;
+            m_peakTransfers = 0;
+            return peak;
+        }
+
+        volatile bool restEnabled; ///< Accept the REST command?
+        TGE::Time     throttle;    ///< Time to wait before sending a file
+
+    private :
+
+        struct Session
+        {
+            TGE::TcpSocket   control;
+            TGE::TcpListener passive;
+            std::string      data;
+            TGE::Uint64      restart;
+        };
+
+        void run()
+        {
+            TGE::SocketSelector selector;
+            selector.add(m_listener);
+            std::vector<TGE::Thread*> threads;
+            std::vector<Session*> sessions;
+
+            while (!m_stop)
+            {
+                if (!selector.wait(TGE::milliseconds(20)) || !selector.isReady(m_listener))
+                    continue;
+
+                Session* session = new Session;
+                session->restart = 0;
+                if (m_listener.accept(session->control) != TGE::Socket::Done)
+                {
+                    delete session;
+                    continue;
+                }
+
+                sessions.push_back(session);
+                threads.push_back(new TGE::Thread([this, session]() {serve(*session);}));
+                threads.back()->launch();
+            }
+
+            // The clients have all quit by now
+            for (std::size_t i = 0; i < threads.size(); ++i)
+            {
+                threads[i]->wait();
+                delete threads[i];
+                delete sessions[i];
+            }
+        }
+
+        bool reply(Session& session, const std::string& line)
+        {
+            std::string data = line + "\r\n";
+            return session.control.send(data.data(), data.size()) == TGE::Socket::Done;
+        }
+
+        // Answer the commands of a client until it quits
+        void serve(Session& session)
+        {
+            reply(session, "220 FtpTest ready");
+
+            for (;;)
+            {
+                std::size_t end;
+                while ((end = session.data.find("\r\n")) == std::string::npos)
+                {
+                    char buffer[1024];
+                    std::size_t received = 0;
+                    if (session.control.receive(buffer, sizeof(buffer), received) != TGE::Socket::Done)
+                        return;
+                    session.data.append(buffer, received);
+                }
+
+                std::string line = session.data.substr(0, end);
+                session.data.erase(0, end + 2);
+
+                std::string command = line.substr(0, line.find(' '));
+                std::string parameter = (line.find(' ') != std::string::npos) ? line.substr(line.find(' ') + 1) : "";
+
+                if (command == "QUIT")
+                {
+                    reply(session, "221 Goodbye");
+                    return;
+                }
+
+                if (!answer(session, command, parameter))
+                    return;
+            }
+        }
+
+        bool answer(Session& session, const std::string& command, const std::string& parameter)
+        {
+            if (command == "USER")
+                return reply(session, "331 Password required");
+            if (command == "PASS")
+                return reply(session, "230 Logged in");
+            if (command == "PWD")
+                return reply(session, "257 \"/\" is the current directory");
+            if ((command == "CWD") || (command == "TYPE") || (command == "NOOP"))
+                return reply(session, "200 Ok");
+
+            if (command == "PASV")
+            {
+                if (session.passive.listen(TGE::Socket::AnyPort) != TGE::Socket::Done)
+                    return reply(session, "425 Cannot open a data connection");
+
+                std::ostringstream line;
+                line << "227 Entering Passive Mode (127,0,0,1," << session.passive.getLocalPort() / 256 << ","
+                     << session.passive.getLocalPort() % 256 << ")";
+                return reply(session, line.str());
+            }
+
+            if (command == "SIZE")
+            {
+                TGE::Lock lock(m_mutex);
+                std::map<std::string, std::string>::const_iterator file = m_files.find(parameter);
+                if (file == m_files.end())
+                    return reply(session, "550 No such file");
+
+                std::ostringstream line;
+                line << "213 " << file->second.size();
+                return reply(session, line.str());
+            }
+
+            if (command == "REST")
+            {
+                if (!restEnabled)
+                    return reply(session, "502 Command not implemented");
+
+                session.restart = std::strtoul(parameter.c_str(), NULL, 10);
+                TGE::Lock lock(m_mutex);
+                m_restarts.push_back(session.restart);
+                return reply(session, "350 Restarting");
+            }
+
+            if (command == "RETR")
+                return retrieve(session, parameter);
+            if (command == "STOR")
+                return store(session, parameter);
+
+            return reply(session, "502 Command not implemented");
+        }
+
+        bool retrieve(Session& session, const std::string& name)
+        {
+            std::string content;
+            {
+                TGE::Lock lock(m_mutex);
+                std::map<std::string, std::string>::const_iterator file = m_files.find(name);
+                if ((file == m_files.end()) || (session.restart > file->second.size()))
+                    return reply(session, "550 No such file");
+
+                content = file->second.substr(static_cast<std::size_t>(session.restart));
+                session.restart = 0;
+                m_peakTransfers = std::max(++m_transfers, m_peakTransfers);
+            }
+
+            TGE::TcpSocket data;
+            bool accepted = session.passive.accept(data) == TGE::Socket::Done;
+            session.passive.close();
+            if (!reply(session, accepted ? "150 Sending the file" : "425 No data connection") || !accepted)
+                return accepted;
+
+            // TGE::Ftp reads one reply per receive: let it read this one
+            // before the transfer reply follows
+            TGE::sleep(TGE::milliseconds(5) + throttle);
+
+            bool complete = data.send(content.data(), content.size()) == TGE::Socket::Done;
+            data.disconnect();
+            {
+                TGE::Lock lock(m_mutex);
+                m_transfers--;
+            }
+
+            return reply(session, complete ? "226 Transfer complete" : "426 Transfer aborted");
+        }
+
+        bool store(Session& session, const std::string& name)
+        {
+            TGE::TcpSocket data;
+            bool accepted = session.passive.accept(data) == TGE::Socket::Done;
+            session.passive.close();
+            if (!reply(session, accepted ? "150 Receiving the file" : "425 No data connection") || !accepted)
+                return accepted;
+
+            std::string content;
+            char buffer[65536];
+            std::size_t received = 0;
+            while (data.receive(buffer, sizeof(buffer), received) == TGE::Socket::Done)
+                content.append(buffer, received);
+
+            {
+                TGE::Lock lock(m_mutex);
+                std::string& file = m_files[name];
+                file = file.substr(0, std::min<std::size_t>(static_cast<std::size_t>(session.restart), file.size())) + content;
+                session.restart = 0;
+            }
+
+            return reply(session, "226 Transfer complete");
+        }
+
+        TGE::TcpListener                   m_listener;      ///< Socket accepting the control connections
+        TGE::Thread                        m_thread;        ///< Thread accepting the clients
+        volatile bool                      m_stop;          ///< Stop the server?
+        TGE::Mutex                         m_mutex;         ///< Protects the files and the statistics
+        std::map<std::string, std::string> m_files;         ///< Content of the files, by name
+        std::vector<TGE::Uint64>           m_restarts;      ///< Offsets accepted by REST
+        std::size_t                        m_transfers;     ///< Number of files being sent
+        std::size_t                        m_peakTransfers; ///< Maximum number of files sent at once
+    };
+
+    std::string makeContent(std::size_t size, int seed)
+    {
+        std::srand(seed);
+        std::string content(size, '\0');
+        for (std::size_t i = 0; i < content.size(); ++i)
+            content[i] = static_cast<char>(std::rand());
+        return content;
+    }
+
+    std::string readFile(const std::string& filename)
+    {
+        std::ifstream file(filename.c_str(), std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+
+    void writeFile(const std::string& filename, const std::string& content)
+    {
+        std::ofstream file(filename.c_str(), std::ios::binary | std::ios::trunc);
+        file.write(content.data(), content.size());
+    }
+
+    std::string getSmallFile(std::size_t index)
+    {
+        std::ostringstream name;
+        name << "FtpTest.small" << index;
+        return name.str();
+    }
+
+
+    ////////////////////////////////////////////////////////////
+    void testDownload(TGE::Ftp& ftp, Server& server, const std::string& large)
+    {
+        std::remove(LargeFile.c_str());
+
+        TGE::Uint64 transferred = 0;
+        TGE::Uint64 total = 0;
+        TGE::Ftp::Response response = ftp.download(LargeFile, "", TGE::Ftp::Binary, false,
+                                                   [&](TGE::Uint64 bytes, TGE::Uint64 size) {transferred = bytes; total = size; return true;});
+
+        check(response.isOk(), "download succeeded");
+        check(readFile(LargeFile) == large, "downloaded file identical to the original");
+        check((transferred == large.size()) && (total == large.size()), "download progress reported");
+
+        // Abort after a third of the file, then resume
+        response = ftp.download(LargeFile, "", TGE::Ftp::Binary, false,
+                                [&](TGE::Uint64 bytes, TGE::Uint64 size) {return bytes < size / 3;});
+        TGE::Uint64 partial = readFile(LargeFile).size();
+
+        check(response.getStatus() == TGE::Ftp::Response::TransferAborted, "download aborted by the callback");
+        check((partial > 0) && (partial < large.size()), "part of the file kept after the abort");
+
+        server.takeRestarts();
+        response = ftp.download(LargeFile, "", TGE::Ftp::Binary, true);
+        std::vector<TGE::Uint64> restarts = server.takeRestarts();
+
+        check(response.isOk(), "resumed download succeeded");
+        check(readFile(LargeFile) == large, "resumed download identical to the original");
+        check((restarts.size() == 1) && (restarts[0] == partial), "download resumed at the size of the local file");
+
+        std::printf("download aborted at %u of %u bytes, resumed from there\n",
+                    static_cast<unsigned int>(partial),
+                    static_cast<unsigned int>(large.size()));
+
+        // A server refusing REST sends the whole file again
+        server.restEnabled = false;
+        writeFile(LargeFile, std::string(1000, 'x'));
+        response = ftp.download(LargeFile, "", TGE::Ftp::Binary, true);
+
+        check(response.isOk(), "download without REST succeeded");
+        check(readFile(LargeFile) == large, "download without REST identical to the original");
+
+        server.restEnabled = true;
+        std::remove(LargeFile.c_str());
+    }
+
+
+    ////////////////////////////////////////////////////////////
+    void testUpload(TGE::Ftp& ftp, Server& server, const std::string& large)
+    {
+        writeFile(UploadFile, large);
+
+        TGE::Uint64 transferred = 0;
+        TGE::Ftp::Response response = ftp.upload(UploadFile, "", TGE::Ftp::Binary, false,
+                                                 [&](TGE::Uint64 bytes, TGE::Uint64) {transferred = bytes; return true;});
+
+        check(response.isOk(), "upload succeeded");
+        check(server.getFile(UploadFile) == large, "uploaded file identical to the original");
+        check(transferred == large.size(), "upload progress reported");
+
+        // Abort after a third of the file, then resume
+        server.setFile(UploadFile, "");
+        response = ftp.upload(UploadFile, "", TGE::Ftp::Binary, false,
+                              [&](TGE::Uint64 bytes, TGE::Uint64 size) {return bytes < size / 3;});
+        TGE::Uint64 partial = server.getFile(UploadFile).size();
+
+        check(response.getStatus() == TGE::Ftp::Response::TransferAborted, "upload aborted by the callback");
+        check((partial > 0) && (partial < large.size()), "part of the file kept by the server after the abort");
+
+        server.takeRestarts();
+        response = ftp.upload(UploadFile, "", TGE::Ftp::Binary, true);
+        std::vector<TGE::Uint64> restarts = server.takeRestarts();
+
+        check(response.isOk(), "resumed upload succeeded");
+        check(server.getFile(UploadFile) == large, "resumed upload identical to the original");
+        check((restarts.size() == 1) && (restarts[0] == partial), "upload resumed at the size of the remote file");
+
+        std::printf("upload aborted at %u of %u bytes, resumed from there\n",
+                    static_cast<unsigned int>(partial),
+                    static_cast<unsigned int>(large.size()));
+
+        std::remove(UploadFile.c_str());
+    }
+
+
+    ////////////////////////////////////////////////////////////
+    void testDownloadFiles(TGE::Ftp& ftp, Server& server)
+    {
+        std::vector<std::string> names;
+        std::vector<std::string> contents;
+        for (std::size_t i = 0; i < SmallFileCount; ++i)
+        {
+            names.push_back(getSmallFile(i));
+            contents.push_back(makeContent(SmallFileSize, static_cast<int>(i + 100)));
+            server.setFile(names.back(), contents.back());
+        }
+
+        server.throttle = Throttle;
+        const unsigned int connections[] = {1, 4};
+        for (std::size_t run = 0; run < 2; ++run)
+        {
+            server.takePeakTransfers();
+
+            TGE::Clock clock;
+            std::vector<TGE::Ftp::Response> responses = ftp.downloadFiles(names, "", connections[run]);
+            double elapsed = clock.getElapsedTime().asSeconds();
+            std::size_t peak = server.takePeakTransfers();
+
+            std::size_t identical = 0;
+            for (std::size_t i = 0; i < SmallFileCount; ++i)
+            {
+                identical += (i < responses.size()) && responses[i].isOk() && (readFile(names[i]) == contents[i]) ? 1 : 0;
+                std::remove(names[i].c_str());
+            }
+
+            check(identical == SmallFileCount, "files downloaded at once identical to the originals");
+            check(peak == std::min<std::size_t>(connections[run], SmallFileCount), "files sent at once");
+
+            std::printf("%u files over %u connection(s): %.2f s, %u sent at once\n",
+                        static_cast<unsigned int>(SmallFileCount),
+                        connections[run],
+                        elapsed,
+                        static_cast<unsigned int>(peak));
+        }
+
+        server.throttle = TGE::Time::Zero;
+    }
+}
+
+
+////////////////////////////////////////////////////////////
+int main(int argc, char* argv[])
+{
+    if (argc > 1)
+        port = static_cast<unsigned short>(std::atoi(argv[1]));
+
+    std::string large = makeContent(LargeFileSize, 3);
+
+    Server server;
+    if (!server.start())
+    {
+        std::printf("FtpTest: cannot listen on port %u\n", port);
+        return 1;
+    }
+    server.setFile(LargeFile, large);
+
+    {
+        TGE::Ftp ftp;
+        bool connected = ftp.connect(TGE::IpAddress::LocalHost, port, TGE::seconds(5)).isOk() && ftp.login().isOk();
+        check(connected, "connected and logged in");
+
+        if (connected)
+        {
+            testDownload(ftp, server, large);
+            testUpload(ftp, server, large);
+            testDownloadFiles(ftp, server);
+        }
+
+        ftp.disconnect();
+    }
+
+    server.stop();
+
+    if (failures > 0)
+    {
+        std::printf("FtpTest: %d failures\n", failures);
+        return 1;
+    }
+
+    std::printf("FtpTest: every transfer identical to the original file\n");
+    return 0;
+}
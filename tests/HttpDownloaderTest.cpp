@@ -0,0 +1,447 @@
+/*************************************/
+/** Copyright © 2014 Coldsnap Games **/
+/*************************************/
+
+/*************************************/
+/**             Headers             **/
+/*************************************/
+#include <Tyrant/Network.hpp>
+#include <Tyrant/System/Clock.hpp>
+#include <Tyrant/System/Mutex.hpp>
+#include <Tyrant/System/Lock.hpp>
+#include <Tyrant/System/Sleep.hpp>
+#include <Tyrant/System/Thread.hpp>
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+
+////////////////////////////////////////////////////////////
+/// Checks TGE::HttpDownloader against a minimal HTTP/1.1
+/// server running in the same process, which answers HEAD
+/// requests and byte ranges like a file server.
+///
+/// The file must be downloaded intact with one and several
+/// connections; a download stopped half-way must resume
+/// without fetching its finished chunks again, except one
+/// damaged on disk in the meantime; chunks corrupted in
+/// transit must be fetched again when the checksums are
+/// known; and a server without ranges must get the file in a
+/// single request.
+///
+/// Usage: HttpDownloaderTest [port]
+///
+////////////////////////////////////////////////////////////
+namespace
+{
+    // Size of the file served, and of the chunks it's downloaded in
+    const std::size_t FileSize = 2 * 1024 * 1024 + 1234;
+    const std::size_t ChunkSize = 64 * 1024;
+    const std::size_t ChunkCount = (FileSize + ChunkSize - 1) / ChunkSize;
+
+    // Name of the downloaded file; the downloader adds ".part" and ".journal"
+    const std::string FileName = "HttpDownloaderTest.download";
+
+    unsigned short port = 48100;
+    int failures = 0;
+
+    void check(bool condition, const char* what)
+    {
+        if (!condition)
+        {
+            std::printf("FAILED: %s\n", what);
+            failures++;
+        }
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// HTTP server of a single file, with one thread for all
+    /// its connections
+    ////////////////////////////////////////////////////////////
+    class Server
+    {
+    public :
+
+        Server() :
+        ranges          (true),
+        corruptCount    (0),
+        delay           (TGE::Time::Zero),
+        m_thread        (&Server::run, this),
+        m_stop          (false)
+        {
+        }
+
+        bool start(const std::string& file)
+        {
+            if (m_listener.listen(port) != TGE::Socket::Done)
+                return false;
+
+            m_file = file;
+            m_thread.launch();
+            return true;
+        }
+
+        void stop()
+        {
+            m_stop = true;
+            m_thread.wait();
+        }
+
+        // Offsets of the ranges requested since the last call
+        std::vector<std::size_t> takeRequests()
+        {
+            TGE::Lock lock(m_mutex);
+            std::vector<std::size_t> requests;
+            requests.swap(m_requests);
+            return requests;
+        }
+
+        // Number of ranges requested since the last call to takeRequests
+        std::size_t getRequestCount()
+        {
+            TGE::Lock lock(m_mutex);
+            return m_requests.size();
+        }
+
+        volatile bool        ranges;       ///< Answer the range requests?
+        volatile std::size_t corruptCount; ///< Number of range responses left to corrupt
+        TGE::Time            delay;        ///< Time to wait before each range response
+
+    private :
+
+        struct Connection
+        {
+            TGE::TcpSocket socket;
+            std::string    data;
+        };
+
+        void run()
+        {
+            TGE::SocketSelector selector;
+            selector.add(m_listener);
+            std::vector<Connection*> connections;
+
+            while (!m_stop)
+            {
+                if (!selector.wait(TGE::milliseconds(20)))
+                    continue;
+
+                if (selector.isReady(m_listener))
+                {
+                    Connection* connection = new Connection;
+                    if (m_listener.accept(connection->socket) == TGE::Socket::Done)
+                    {
+                        selector.add(connection->socket);
+                        connections.push_back(connection);
+                    }
+                    else
+                    {
+                        delete connection;
+                    }
+                }
+
+                for (std::vector<Connection*>::iterator it = connections.begin(); it != connections.end(); )
+                {
+                    Connection* connection = *it;
+                    if (selector.isReady(connection->socket) && !serve(*connection))
+                    {
+                        selector.remove(connection->socket);
+                        delete connection;
+                        it = connections.erase(it);
+                    }
+                    else
+                    {
+                        ++it;
+                    }
+                }
+            }
+
+            for (std::vector<Connection*>::iterator it = connections.begin(); it != connections.end(); ++it)
+                delete *it;
+        }
+
+        // Read what the client sent and answer the complete requests, false to close the connection
+        bool serve(Connection& connection)
+        {
+            char buffer[4096];
+            std::size_t received = 0;
+            if (connection.socket.receive(buffer, sizeof(buffer), received) != TGE::Socket::Done)
+                return false;
+            connection.data.append(buffer, received);
+
+            // The requests have no body
+            std::size_t end;
+            while ((end = connection.data.find("\r\n\r\n")) != std::string::npos)
+            {
+                std::string request = connection.data.substr(0, end + 2);
+                connection.data.erase(0, end + 4);
+                std::transform(request.begin(), request.end(), request.begin(), ::tolower);
+
+                if (!answer(connection.socket, request))
+                    return false;
+            }
+
+            return true;
+        }
+
+        bool answer(TGE::TcpSocket& socket, const std::string& request)
+        {
+            bool head = request.compare(0, 5, "head ") == 0;
+            std::size_t first = 0;
+            std::size_t last = m_file.size() - 1;
+            std::size_t field = request.find("\r\nrange: bytes=");
+            bool range = ranges && !head && (field != std::string::npos);
+            if (range)
+            {
+                char* next = NULL;
+                first = std::strtoul(request.c_str() + field + 15, &next, 10);
+                last = std::strtoul(next + 1, NULL, 10);
+                if ((first > last) || (last >= m_file.size()))
+                {
+                    const char* invalid = "HTTP/1.1 416 Range Not Satisfiable\r\nContent-Length: 0\r\n\r\n";
+                    return socket.send(invalid, std::strlen(invalid)) == TGE::Socket::Done;
+                }
+
+                TGE::Lock lock(m_mutex);
+                m_requests.push_back(first);
+            }
+
+            std::string body = m_file.substr(first, last - first + 1);
+            if (range && (corruptCount > 0))
+            {
+                body[body.size() / 2] ^= 0x5A;
+                corruptCount = corruptCount - 1;
+            }
+
+            char header[256];
+            if (range)
+            {
+                std::sprintf(header, "HTTP/1.1 206 Partial Content\r\nContent-Length: %u\r\nContent-Range: bytes %u-%u/%u\r\n\r\n",
+                             static_cast<unsigned int>(body.size()),
+                             static_cast<unsigned int>(first),
+                             static_cast<unsigned int>(last),
+                             static_cast<unsigned int>(m_file.size()));
+                TGE::sleep(delay);
+            }
+            else
+            {
+                std::sprintf(header, "HTTP/1.1 200 OK\r\nContent-Length: %u\r\nETag: \"tge-1\"\r\n%s\r\n",
+                             static_cast<unsigned int>(body.size()),
+                             ranges ? "Accept-Ranges: bytes\r\n" : "");
+            }
+
+            if (socket.send(header, std::strlen(header)) != TGE::Socket::Done)
+                return false;
+            return head || (socket.send(body.data(), body.size()) == TGE::Socket::Done);
+        }
+
+        TGE::TcpListener         m_listener; ///< Socket accepting the connections
+        TGE::Thread              m_thread;   ///< Thread running the server
+        volatile bool            m_stop;     ///< Stop the server?
+        std::string              m_file;     ///< Content of the file served
+        TGE::Mutex               m_mutex;    ///< Protects the requests
+        std::vector<std::size_t> m_requests; ///< Offsets of the ranges requested
+    };
+
+    std::string readFile(const std::string& filename)
+    {
+        std::ifstream file(filename.c_str(), std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+
+    bool exists(const std::string& filename)
+    {
+        return std::ifstream(filename.c_str()).good();
+    }
+
+    void removeFiles()
+    {
+        std::remove(FileName.c_str());
+        std::remove((FileName + ".part").c_str());
+        std::remove((FileName + ".journal").c_str());
+    }
+
+
+    ////////////////////////////////////////////////////////////
+    void testComplete(TGE::HttpDownloader& downloader, Server& server, const std::string& file, unsigned int connections)
+    {
+        removeFiles();
+        downloader.setConnectionCount(connections);
+
+        TGE::HttpDownloader::Status status = downloader.download("/file", FileName);
+        std::vector<std::size_t> requests = server.takeRequests();
+
+        check(status == TGE::HttpDownloader::Done, "download finished");
+        check(readFile(FileName) == file, "downloaded file identical to the original");
+        check(requests.size() == ChunkCount, "each chunk requested once");
+        check(!exists(FileName + ".part") && !exists(FileName + ".journal"), "temporary files removed");
+        check(downloader.getDownloadedSize() == FileSize, "downloaded size");
+
+        std::printf("%u connection(s): %u ranges requested for %u chunks\n",
+                    connections,
+                    static_cast<unsigned int>(requests.size()),
+                    static_cast<unsigned int>(ChunkCount));
+    }
+
+
+    ////////////////////////////////////////////////////////////
+    void testResume(TGE::HttpDownloader& downloader, Server& server, const std::string& file)
+    {
+        removeFiles();
+        downloader.setConnectionCount(2);
+
+        // Stop the download half-way, from another thread; the size
+        // downloaded is the previous one until the download starts
+        server.delay = TGE::milliseconds(10);
+        TGE::HttpDownloader::Status status = TGE::HttpDownloader::Error;
+        TGE::Thread thread([&]() {status = downloader.download("/file", FileName);});
+        thread.launch();
+
+        TGE::Clock clock;
+        while ((server.getRequestCount() < ChunkCount / 2) && (clock.getElapsedTime() < TGE::seconds(10)))
+            TGE::sleep(TGE::milliseconds(1));
+        downloader.stop();
+        thread.wait();
+        server.delay = TGE::Time::Zero;
+
+        std::size_t before = server.takeRequests().size();
+        check(status == TGE::HttpDownloader::Stopped, "download stopped");
+        check(exists(FileName + ".part") && exists(FileName + ".journal"), "progress kept after the stop");
+        check(!exists(FileName), "no file before the end of the download");
+
+        // Damage the first chunk recorded in the journal
+        std::size_t damaged = ChunkCount;
+        {
+            std::ifstream journal((FileName + ".journal").c_str());
+            std::string line;
+            for (int i = 0; i < 3; ++i)
+                std::getline(journal, line);
+            journal >> damaged;
+        }
+        check(damaged < ChunkCount, "a finished chunk recorded in the journal");
+        if (damaged < ChunkCount)
+        {
+            std::fstream part((FileName + ".part").c_str(), std::ios::in | std::ios::out | std::ios::binary);
+            part.seekp(static_cast<std::streamoff>(damaged * ChunkSize + 10));
+            part.put(static_cast<char>(file[damaged * ChunkSize + 10] ^ 0x5A));
+        }
+
+        status = downloader.download("/file", FileName);
+        std::vector<std::size_t> after = server.takeRequests();
+
+        check(status == TGE::HttpDownloader::Done, "resumed download finished");
+        check(readFile(FileName) == file, "resumed file identical to the original");
+        check(after.size() < ChunkCount, "finished chunks not requested again");
+        check(std::find(after.begin(), after.end(), damaged * ChunkSize) != after.end(), "damaged chunk requested again");
+
+        std::printf("stopped after %u ranges, resumed with %u ranges for %u chunks\n",
+                    static_cast<unsigned int>(before),
+                    static_cast<unsigned int>(after.size()),
+                    static_cast<unsigned int>(ChunkCount));
+    }
+
+
+    ////////////////////////////////////////////////////////////
+    void testChecksums(TGE::HttpDownloader& downloader, Server& server, const std::string& file)
+    {
+        removeFiles();
+        downloader.setConnectionCount(4);
+
+        std::vector<TGE::Uint32> checksums;
+        for (std::size_t offset = 0; offset < file.size(); offset += ChunkSize)
+            checksums.push_back(TGE::HttpDownloader::computeChecksum(file.data() + offset, std::min(ChunkSize, file.size() - offset)));
+        downloader.setExpectedChecksums(checksums);
+
+        // Corrupted chunks are fetched again
+        server.corruptCount = 3;
+        TGE::HttpDownloader::Status status = downloader.download("/file", FileName);
+        std::size_t requests = server.takeRequests().size();
+
+        check(status == TGE::HttpDownloader::Done, "download with corrupted chunks finished");
+        check(readFile(FileName) == file, "file identical despite the corrupted chunks");
+        check(requests == ChunkCount + 3, "corrupted chunks requested again");
+
+        std::printf("3 chunks corrupted in transit: %u ranges requested for %u chunks\n",
+                    static_cast<unsigned int>(requests),
+                    static_cast<unsigned int>(ChunkCount));
+
+        // A chunk which never matches makes the download fail
+        removeFiles();
+        checksums[1] ^= 1;
+        downloader.setExpectedChecksums(checksums);
+        status = downloader.download("/file", FileName);
+        std::vector<std::size_t> failed = server.takeRequests();
+
+        check(status == TGE::HttpDownloader::Error, "download failed on a wrong checksum");
+        check(std::count(failed.begin(), failed.end(), ChunkSize) == 3, "wrong chunk tried three times");
+        check(!exists(FileName), "no file after a failed download");
+
+        downloader.setExpectedChecksums(std::vector<TGE::Uint32>());
+        removeFiles();
+    }
+
+
+    ////////////////////////////////////////////////////////////
+    void testWithoutRanges(TGE::HttpDownloader& downloader, Server& server, const std::string& file)
+    {
+        removeFiles();
+        server.ranges = false;
+
+        TGE::HttpDownloader::Status status = downloader.download("/file", FileName);
+
+        check(status == TGE::HttpDownloader::Done, "download without ranges finished");
+        check(readFile(FileName) == file, "file without ranges identical to the original");
+        check(server.takeRequests().empty(), "no range requested");
+
+        server.ranges = true;
+        std::printf("server without ranges: file downloaded in a single request\n");
+    }
+}
+
+
+////////////////////////////////////////////////////////////
+int main(int argc, char* argv[])
+{
+    if (argc > 1)
+        port = static_cast<unsigned short>(std::atoi(argv[1]));
+
+    std::string file(FileSize, '\0');
+    std::srand(11);
+    for (std::size_t i = 0; i < file.size(); ++i)
+        file[i] = static_cast<char>(std::rand());
+
+    Server server;
+    if (!server.start(file))
+    {
+        std::printf("HttpDownloaderTest: cannot listen on port %u\n", port);
+        return 1;
+    }
+
+    TGE::HttpDownloader downloader;
+    downloader.setHost("127.0.0.1", port);
+    downloader.setChunkSize(ChunkSize);
+
+    testComplete(downloader, server, file, 4);
+    testComplete(downloader, server, file, 1);
+    testResume(downloader, server, file);
+    testChecksums(downloader, server, file);
+    testWithoutRanges(downloader, server, file);
+
+    removeFiles();
+    server.stop();
+
+    if (failures > 0)
+    {
+        std::printf("HttpDownloaderTest: %d failures\n", failures);
+        return 1;
+    }
+
+    std::printf("HttpDownloaderTest: every download identical to the file served\n");
+    return 0;
+}
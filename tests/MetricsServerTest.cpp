@@ -0,0 +1,385 @@
+/*************************************/
+/** Copyright © 2014 Coldsnap Games **/
+/*************************************/
+
+/*************************************/
+/**             Headers             **/
+/*************************************/
+#include <Tyrant/Network.hpp>
+#include <Tyrant/System/Clock.hpp>
+#include <Tyrant/System/Sleep.hpp>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+
+////////////////////////////////////////////////////////////
+/// Checks TGE::MetricsServer with HTTP clients running in the
+/// same process, the test playing the game thread that calls
+/// update().
+///
+/// Before any collection, a scrape must get a 503 once the
+/// collect timeout is over; afterwards it must get the
+/// previous metrics. The metrics must be served in both
+/// formats, with the traffic counted by a TGE::NetworkService,
+/// and the unknown targets, other methods, malformed and
+/// oversized requests must get their error status. Several
+/// requests, pipelined or not, must be answered in order on a
+/// kept-alive connection, and the connections asking for it
+/// must be closed.
+///
+/// Usage: MetricsServerTest [port]
+///
+////////////////////////////////////////////////////////////
+namespace
+{
+    // Time the server waits for update() before answering without it
+    const TGE::Time CollectTimeout = TGE::seconds(1);
+
+    // Size of a request header bigger than the server accepts
+    const std::size_t OversizedRequestSize = 9000;
+
+    // Maximum duration of an exchange
+    const TGE::Time Timeout = TGE::seconds(10);
+
+    unsigned short port = 48700;
+    int failures = 0;
+
+    void check(bool condition, const char* what)
+    {
+        if (!condition)
+        {
+            std::printf("FAILED: %s\n", what);
+            failures++;
+        }
+    }
+
+    bool contains(const std::string& string, const std::string& part)
+    {
+        return string.find(part) != std::string::npos;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Response of the server
+    ////////////////////////////////////////////////////////////
+    struct Response
+    {
+        std::string status;
+        std::string header;
+        std::string body;
+    };
+
+    ////////////////////////////////////////////////////////////
+    /// HTTP client of the metrics server
+    ////////////////////////////////////////////////////////////
+    class Client
+    {
+    public :
+
+        bool connect()
+        {
+            if (m_socket.connect(TGE::IpAddress::LocalHost, port) != TGE::Socket::Done)
+                return false;
+
+            m_socket.setBlocking(false);
+            return true;
+        }
+
+        void send(const std::string& request)
+        {
+            std::size_t offset = 0;
+            TGE::Clock clock;
+            while ((offset < request.size()) && (clock.getElapsedTime() < Timeout))
+            {
+                std::size_t sent = 0;
+                m_socket.send(request.data() + offset, request.size() - offset, sent);
+                offset += sent;
+            }
+        }
+
+        // Wait for the next response; while waiting, the metrics are collected if a server is given
+        bool receive(Response& response, TGE::MetricsServer* collecting = NULL)
+        {
+            TGE::Clock clock;
+            while (clock.getElapsedTime() < Timeout)
+            {
+                if (extract(response))
+                    return true;
+
+                char buffer[4096];
+                std::size_t received = 0;
+                TGE::Socket::Status status = m_socket.receive(buffer, sizeof(buffer), received);
+                if (status == TGE::Socket::Done)
+                {
+                    m_pending.append(buffer, received);
+                    continue;
+                }
+                if (status != TGE::Socket::NotReady)
+                    return extract(response);
+
+                if (collecting)
+                    collecting->update();
+                TGE::sleep(TGE::milliseconds(1));
+            }
+
+            return false;
+        }
+
+        // Wait for the server to close the connection
+        bool isClosedByServer()
+        {
+            TGE::Clock clock;
+            while (clock.getElapsedTime() < Timeout)
+            {
+                char buffer[1024];
+                std::size_t received = 0;
+                TGE::Socket::Status status = m_socket.receive(buffer, sizeof(buffer), received);
+                if (status == TGE::Socket::Disconnected)
+                    return true;
+                if (status != TGE::Socket::NotReady)
+                    return false;
+
+                TGE::sleep(TGE::milliseconds(1));
+            }
+
+            return false;
+        }
+
+    private :
+
+        // Take a complete response out of the data received
+        bool extract(Response& response)
+        {
+            std::size_t end = m_pending.find("\r\n\r\n");
+            if (end == std::string::npos)
+                return false;
+
+            std::size_t lengthStart = m_pending.find("Content-Length: ");
+            if ((lengthStart == std::string::npos) || (lengthStart > end))
+                return false;
+
+            std::size_t length = std::strtoul(m_pending.c_str() + lengthStart + 16, NULL, 10);
+            if (m_pending.size() < end + 4 + length)
+                return false;
+
+            std::size_t lineEnd = m_pending.find("\r\n");
+            response.status = m_pending.substr(0, lineEnd);
+            response.header = m_pending.substr(lineEnd + 2, end - lineEnd);
+            response.body   = m_pending.substr(end + 4, length);
+            m_pending.erase(0, end + 4 + length);
+
+            return true;
+        }
+
+        TGE::TcpSocket m_socket;
+        std::string    m_pending;
+    };
+
+
+    ////////////////////////////////////////////////////////////
+    void testCollection(TGE::MetricsServer& metrics, unsigned int& frames)
+    {
+        Client client;
+        if (!client.connect())
+        {
+            check(false, "client connected");
+            return;
+        }
+
+        // Never collected: the server gives up after the collect timeout
+        Response response;
+        TGE::Clock clock;
+        client.send("GET /metrics HTTP/1.1\r\nHost: localhost\r\n\r\n");
+        check(client.receive(response) && (response.status == "HTTP/1.1 503 Service Unavailable"), "503 before any collection");
+        check(clock.getElapsedTime() >= CollectTimeout - TGE::milliseconds(100), "update() waited for before the 503");
+        check(contains(response.header, "Connection: keep-alive"), "connection kept alive after a 503");
+
+        // Collected by update() on the same connection
+        frames = 1;
+        clock.restart();
+        client.send("GET /metrics HTTP/1.1\r\nHost: localhost\r\n\r\n");
+        check(client.receive(response, &metrics) && (response.status == "HTTP/1.1 200 OK"), "metrics collected by update()");
+        check(clock.getElapsedTime() < CollectTimeout, "metrics answered as soon as collected");
+        check(contains(response.header, "Content-Type: text/plain; version=0.0.4"), "Prometheus content type");
+        check(contains(response.body, "# TYPE test_frames_total counter\ntest_frames_total 1\n"), "counter written");
+        check(contains(response.body, "test_players{team=\"red\"} 3\ntest_players{team=\"blue\"} 4\n"), "labeled values grouped");
+        check(contains(response.body, "test_latency_seconds_bucket{le=\"0.1\"} 2\n") &&
+              contains(response.body, "test_latency_seconds_bucket{le=\"+Inf\"} 3\n") &&
+              contains(response.body, "test_latency_seconds_count 3\n"), "histogram written");
+
+        // The JSON format, with a query string ignored
+        frames = 2;
+        client.send("GET /metrics.json?pretty=1 HTTP/1.1\r\n\r\n");
+        check(client.receive(response, &metrics) && (response.status == "HTTP/1.1 200 OK"), "JSON metrics collected");
+        check(contains(response.header, "Content-Type: application/json"), "JSON content type");
+        check(contains(response.body, "{\"name\":\"test_frames_total\",\"type\":\"counter\",\"value\":2}"), "JSON counter written");
+
+        // Not collected anymore: the previous metrics after the collect timeout
+        frames = 3;
+        clock.restart();
+        client.send("GET /metrics HTTP/1.1\r\n\r\n");
+        check(client.receive(response) && (response.status == "HTTP/1.1 200 OK"), "previous metrics after the collect timeout");
+        check(clock.getElapsedTime() >= CollectTimeout - TGE::milliseconds(100), "update() waited for before the previous metrics");
+        check(contains(response.body, "test_frames_total 2\n"), "previous metrics returned");
+
+        std::printf("collection: 503 before any collection, fresh metrics from update(), previous ones after %.1f s\n",
+                    CollectTimeout.asSeconds());
+    }
+
+
+    ////////////////////////////////////////////////////////////
+    void testRequests(TGE::MetricsServer& metrics)
+    {
+        Client client;
+        if (!client.connect())
+        {
+            check(false, "client connected");
+            return;
+        }
+
+        // Errors keep the connection open, pipelined requests are answered in order
+        Response response;
+        client.send("GET /status HTTP/1.1\r\n\r\n"
+                    "POST /metrics HTTP/1.1\r\nContent-Length: 0\r\n\r\n"
+                    "GET /metrics HTTP/1.1\r\n\r\n");
+        check(client.receive(response, &metrics) && (response.status == "HTTP/1.1 404 Not Found"), "404 for an unknown target");
+        check(client.receive(response, &metrics) && (response.status == "HTTP/1.1 405 Method Not Allowed"), "405 for another method");
+        check(client.receive(response, &metrics) && (response.status == "HTTP/1.1 200 OK"), "pipelined requests answered in order");
+
+        // Header names in any case
+        client.send("GET /metrics HTTP/1.0\r\nCONNECTION: Keep-Alive\r\n\r\n");
+        check(client.receive(response, &metrics) && contains(response.header, "Connection: keep-alive"), "HTTP/1.0 connection kept alive on request");
+
+        client.send("GET /metrics HTTP/1.1\r\nconnection: close\r\n\r\n");
+        check(client.receive(response, &metrics) && contains(response.header, "Connection: close"), "connection closed on request");
+        check(client.isClosedByServer(), "connection closed after the response");
+
+        // HTTP/1.0 closes by default
+        Client old;
+        old.connect();
+        old.send("GET /nowhere HTTP/1.0\r\n\r\n");
+        check(old.receive(response) && (response.status == "HTTP/1.1 404 Not Found") && contains(response.header, "Connection: close"), "HTTP/1.0 connection closed");
+        check(old.isClosedByServer(), "HTTP/1.0 connection closed after the response");
+
+        // Malformed request line
+        Client malformed;
+        malformed.connect();
+        malformed.send("GET /metrics\r\n\r\n");
+        check(malformed.receive(response) && (response.status == "HTTP/1.1 400 Bad Request"), "400 for a request without version");
+        check(malformed.isClosedByServer(), "connection closed after a malformed request");
+
+        // A header that never ends
+        Client oversized;
+        oversized.connect();
+        oversized.send("GET /metrics HTTP/1.1\r\nX-Padding: " + std::string(OversizedRequestSize, 'x'));
+        check(oversized.receive(response) && (response.status == "HTTP/1.1 431 Request Header Fields Too Large"), "431 for an oversized request");
+        check(oversized.isClosedByServer(), "connection closed after an oversized request");
+
+        std::printf("requests: 404, 405, 400 and 431 answered, pipelined requests in order, connections closed on request\n");
+    }
+
+
+    ////////////////////////////////////////////////////////////
+    void testNetworkService(TGE::MetricsServer& metrics, TGE::NetworkService& service)
+    {
+        TGE::TcpSocket peer;
+        if (peer.connect(TGE::IpAddress::LocalHost, port + 1) != TGE::Socket::Done)
+        {
+            check(false, "peer connected to the network service");
+            return;
+        }
+
+        // Three packets of 10 bytes received by the service, two sent back
+        TGE::Packet packet;
+        packet.append("0123456789", 10);
+        for (int i = 0; i < 3; ++i)
+            peer.send(packet);
+
+        TGE::NetworkService::Event event;
+        unsigned int received = 0;
+        TGE::NetworkService::ConnectionId connection = 0;
+        TGE::Clock clock;
+        while ((received < 3) && (clock.getElapsedTime() < Timeout))
+        {
+            if (!service.pollEvent(event))
+                TGE::sleep(TGE::milliseconds(1));
+            else if (event.type == TGE::NetworkService::Event::Connected)
+                connection = event.connection;
+            else if (event.type == TGE::NetworkService::Event::Received)
+                received++;
+        }
+
+        service.send(connection, packet);
+        service.send(connection, packet);
+        TGE::Packet reply;
+        check((peer.receive(reply) == TGE::Socket::Done) && (peer.receive(reply) == TGE::Socket::Done), "packets sent by the service");
+
+        Client client;
+        Response response;
+        client.connect();
+        client.send("GET /metrics HTTP/1.1\r\n\r\n");
+        check(client.receive(response, &metrics) && (response.status == "HTTP/1.1 200 OK"), "traffic collected");
+
+        char expected[256];
+        std::snprintf(expected, sizeof(expected),
+                      "tge_network_sent_bytes_total{connection=\"%u\"} 20\n", connection);
+        check(contains(response.body, "tge_network_connections 1\n"), "connection counted");
+        check(contains(response.body, expected), "bytes sent counted by the network thread");
+        std::snprintf(expected, sizeof(expected),
+                      "tge_network_received_packets_total{connection=\"%u\"} 3\n", connection);
+        check(contains(response.body, expected), "packets received counted by the network thread");
+
+        std::printf("network service: traffic of the connection collected\n");
+    }
+}
+
+
+////////////////////////////////////////////////////////////
+int main(int argc, char* argv[])
+{
+    if (argc > 1)
+        port = static_cast<unsigned short>(std::atoi(argv[1]));
+
+    TGE::NetworkService service;
+    TGE::MetricsServer metrics;
+    if (!service.listen(port + 1) || !metrics.listen(port))
+    {
+        std::printf("MetricsServerTest: failed to listen on port %u\n", port);
+        return 1;
+    }
+
+    unsigned int frames = 0;
+    std::vector<double> bounds;
+    bounds.push_back(0.01);
+    bounds.push_back(0.1);
+    TGE::MetricsServer::Histogram latency(bounds);
+    latency.observe(0.005);
+    latency.observe(0.05);
+    latency.observe(2.0);
+
+    metrics.addCollector([&](TGE::MetricsServer& server)
+    {
+        server.write(TGE::MetricsServer::Gauge, "test_players", "team", "red", 3);
+        server.write(TGE::MetricsServer::Counter, "test_frames_total", frames);
+        server.write(TGE::MetricsServer::Gauge, "test_players", "team", "blue", 4);
+        server.write("test_latency_seconds", latency);
+    });
+    metrics.addNetworkService(service);
+
+    service.launch();
+    metrics.launch();
+
+    testCollection(metrics, frames);
+    testRequests(metrics);
+    testNetworkService(metrics, service);
+
+    if (failures > 0)
+    {
+        std::printf("MetricsServerTest: %d failures\n", failures);
+        return 1;
+    }
+
+    std::printf("MetricsServerTest: every request answered as expected\n");
+    return 0;
+}
@@ -0,0 +1,277 @@
+/*************************************/
+/** Copyright © 2014 Coldsnap Games **/
+/*************************************/
+
+/*************************************/
+/**             Headers             **/
+/*************************************/
+#include <Tyrant/Network.hpp>
+#include <Tyrant/System/Clock.hpp>
+#include <Tyrant/System/Sleep.hpp>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+
+////////////////////////////////////////////////////////////
+/// Checks TGE::NetworkService over the loopback interface.
+///
+/// Two services exchange packets back and forth, each one
+/// handed from the game thread to the network thread and
+/// back: they must arrive intact, in order, without waiting
+/// for a polling interval, a disconnection must deliver the
+/// packets sent before it, and a sleeping service must stop
+/// at once. Then a service sends to a peer that doesn't read
+/// until its queue is congested; once the peer reads, every
+/// packet must arrive intact and in order, the batches cut
+/// by the full socket being sent again, the connection must
+/// report that it drained, and only the packets actually sent
+/// must be counted.
+///
+/// Usage: NetworkServiceTest [port]
+///
+////////////////////////////////////////////////////////////
+namespace
+{
+    // Number of packets sent back and forth between the services
+    const unsigned int RoundTripCount = 500;
+
+    // Size of the packets sent until the connection is congested, and the limit
+    const std::size_t BigPacketSize = 16 * 1024;
+    const std::size_t SendLimit = 256 * 1024;
+
+    // Maximum number of packets sent to congest a connection
+    const TGE::Uint32 MaxPacketCount = 8192;
+
+    // Maximum duration of a transfer
+    const TGE::Time Timeout = TGE::seconds(20);
+
+    unsigned short port = 48500;
+    int failures = 0;
+
+    void check(bool condition, const char* what)
+    {
+        if (!condition)
+        {
+            std::printf("FAILED: %s\n", what);
+            failures++;
+        }
+    }
+
+    // Content of the packet of a given index: its index, then bytes recognizable at any offset
+    void fillPacket(TGE::Packet& packet, TGE::Uint32 index, std::size_t size)
+    {
+        packet.clear();
+        packet << index;
+        for (std::size_t i = 0; i < size; ++i)
+            packet << static_cast<TGE::Uint8>(index + i);
+    }
+
+    bool isIntact(TGE::Packet& packet, TGE::Uint32 expected, std::size_t size)
+    {
+        if (packet.getDataSize() != sizeof(TGE::Uint32) + size)
+            return false;
+
+        TGE::Uint32 index;
+        packet >> index;
+        if (index != expected)
+            return false;
+
+        const TGE::Uint8* bytes = static_cast<const TGE::Uint8*>(packet.getData()) + sizeof(TGE::Uint32);
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            if (bytes[i] != static_cast<TGE::Uint8>(index + i))
+                return false;
+        }
+
+        return true;
+    }
+
+    // Poll the events of a service until one of the given type arrives
+    bool waitEvent(TGE::NetworkService& service, TGE::NetworkService::Event::Type type, TGE::NetworkService::Event& event)
+    {
+        TGE::Clock clock;
+        while (clock.getElapsedTime() < Timeout)
+        {
+            if (!service.pollEvent(event))
+                std::this_thread::yield();
+            else if (event.type == type)
+                return true;
+        }
+
+        return false;
+    }
+
+    // Send a packet again while the command queue is full
+    bool sendPacket(TGE::NetworkService& service, TGE::NetworkService::ConnectionId connection, const TGE::Packet& packet)
+    {
+        TGE::Clock clock;
+        while (!service.send(connection, packet))
+        {
+            if (clock.getElapsedTime() > Timeout)
+                return false;
+
+            std::this_thread::yield();
+        }
+
+        return true;
+    }
+
+
+    ////////////////////////////////////////////////////////////
+    void testHandoff()
+    {
+        TGE::NetworkService server;
+        TGE::NetworkService client;
+        check(server.listen(port), "service listening");
+        server.launch();
+        client.launch();
+
+        // Both sides report the connection
+        TGE::NetworkService::Event event;
+        TGE::NetworkService::ConnectionId toServer = client.connect(TGE::IpAddress::LocalHost, port);
+        check(waitEvent(client, TGE::NetworkService::Event::Connected, event) && (event.connection == toServer), "connection established");
+        check(waitEvent(server, TGE::NetworkService::Event::Connected, event), "connection accepted");
+        TGE::NetworkService::ConnectionId toClient = event.connection;
+
+        // Each packet goes through both network threads twice; they sleep in between
+        TGE::Packet packet;
+        bool intact = true;
+        TGE::Clock clock;
+        for (TGE::Uint32 i = 0; (i < RoundTripCount) && intact; ++i)
+        {
+            fillPacket(packet, i, i % 100);
+            intact &= client.send(toServer, packet);
+
+            intact &= waitEvent(server, TGE::NetworkService::Event::Received, event) && (event.connection == toClient);
+            intact &= server.send(toClient, event.packet);
+
+            intact &= waitEvent(client, TGE::NetworkService::Event::Received, event) && isIntact(event.packet, i, i % 100);
+        }
+        double roundTrip = clock.getElapsedTime().asSeconds() * 1000 / RoundTripCount;
+
+        check(intact, "packets sent back and forth intact and in order");
+        check(roundTrip < 1, "commands picked up without waiting for a polling interval");
+
+        // Traffic counted on both sides
+        const std::map<TGE::NetworkService::ConnectionId, TGE::NetworkService::Statistics>& statistics = client.getStatistics();
+        check((statistics.count(toServer) == 1) &&
+              (statistics.find(toServer)->second.packetsSent == RoundTripCount) &&
+              (statistics.find(toServer)->second.packetsReceived == RoundTripCount), "traffic counted");
+
+        // Packets sent before a disconnection are delivered first, the ones after are ignored
+        fillPacket(packet, RoundTripCount, 10);
+        client.send(toServer, packet);
+        client.disconnect(toServer);
+        client.send(toServer, packet);
+
+        check(waitEvent(server, TGE::NetworkService::Event::Received, event) && isIntact(event.packet, RoundTripCount, 10), "packet sent before the disconnection delivered");
+        check(waitEvent(server, TGE::NetworkService::Event::Disconnected, event) && (event.connection == toClient), "disconnection reported to the peer");
+        check(waitEvent(client, TGE::NetworkService::Event::Disconnected, event) && (event.connection == toServer), "disconnection reported");
+        check(client.getStatistics().empty() && server.getStatistics().empty(), "traffic of the closed connections forgotten");
+
+        // A service sleeping without any timeout stops right away
+        TGE::sleep(TGE::milliseconds(50));
+        clock.restart();
+        client.stop();
+        check(clock.getElapsedTime() < TGE::milliseconds(500), "sleeping service stopped at once");
+
+        std::printf("handoff: %u round trips of %.3f ms between two services\n", RoundTripCount, roundTrip);
+    }
+
+
+    ////////////////////////////////////////////////////////////
+    void testCongestion()
+    {
+        TGE::NetworkService server;
+        server.setSendLimit(SendLimit);
+        check(server.listen(port + 1), "congested service listening");
+        server.launch();
+
+        TGE::TcpSocket peer;
+        TGE::NetworkService::Event event;
+        if ((peer.connect(TGE::IpAddress::LocalHost, port + 1) != TGE::Socket::Done) ||
+            !waitEvent(server, TGE::NetworkService::Event::Connected, event))
+        {
+            check(false, "peer connected");
+            return;
+        }
+        TGE::NetworkService::ConnectionId connection = event.connection;
+        peer.setBlocking(false);
+
+        // Send until the peer, which doesn't read, congests the connection
+        TGE::Packet packet;
+        TGE::Uint32 sent = 0;
+        bool congested = false;
+        while (!congested && (sent < MaxPacketCount))
+        {
+            fillPacket(packet, sent, BigPacketSize);
+            if (!sendPacket(server, connection, packet))
+                break;
+            sent++;
+
+            while (server.pollEvent(event))
+                congested |= (event.type == TGE::NetworkService::Event::Congested) && (event.connection == connection);
+        }
+        check(congested, "connection congested by a peer that doesn't read");
+
+        // The packets still queued aren't counted as sent
+        const TGE::NetworkService::Statistics& queued = server.getStatistics().find(connection)->second;
+        check(queued.packetsSent + SendLimit / BigPacketSize <= sent, "queued packets not counted as sent");
+
+        // Once the peer reads, the queue drains and every packet arrives
+        TGE::Uint32 received = 0;
+        bool intact = true;
+        bool drained = false;
+        TGE::Clock clock;
+        while (((received < sent) || !drained) && (clock.getElapsedTime() < Timeout))
+        {
+            std::vector<TGE::Packet*> packets;
+            if (peer.receive(packets) == TGE::Socket::Done)
+            {
+                for (std::vector<TGE::Packet*>::const_iterator it = packets.begin(); it != packets.end(); ++it)
+                    intact &= isIntact(**it, received++, BigPacketSize);
+            }
+
+            while (server.pollEvent(event))
+                drained |= (event.type == TGE::NetworkService::Event::Drained) && (event.connection == connection);
+
+            std::this_thread::yield();
+        }
+        check(drained, "connection drained once the peer reads");
+        check(received == sent, "every packet of the congested connection received");
+        check(intact, "packets of the congested connection intact and in order");
+
+        const TGE::NetworkService::Statistics& delivered = server.getStatistics().find(connection)->second;
+        check((delivered.packetsSent == sent) && (delivered.bytesSent == sent * (sizeof(TGE::Uint32) + BigPacketSize)), "delivered packets counted as sent");
+
+        std::printf("congestion: %u packets of %u bytes queued before the connection was congested, all received\n",
+                    sent,
+                    static_cast<unsigned int>(BigPacketSize));
+
+        // The peer closes, which the service reports
+        peer.disconnect();
+        check(waitEvent(server, TGE::NetworkService::Event::Disconnected, event) && (event.connection == connection), "disconnection of the peer reported");
+    }
+}
+
+
+////////////////////////////////////////////////////////////
+int main(int argc, char* argv[])
+{
+    if (argc > 1)
+        port = static_cast<unsigned short>(std::atoi(argv[1]));
+
+    testHandoff();
+    testCongestion();
+
+    if (failures > 0)
+    {
+        std::printf("NetworkServiceTest: %d failures\n", failures);
+        return 1;
+    }
+
+    std::printf("NetworkServiceTest: every packet handed over and delivered as expected\n");
+    return 0;
+}
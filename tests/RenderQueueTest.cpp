@@ -0,0 +1,304 @@
+/*************************************/
+/** Copyright © 2014 Coldsnap Games **/
+/*************************************/
+
+/*************************************/
+/**             Headers             **/
+/*************************************/
+#include <Tyrant/Graphics.hpp>
+#include <Tyrant/System/Semaphore.hpp>
+#include <Tyrant/System/Thread.hpp>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+
+////////////////////////////////////////////////////////////
+/// Checks that a TGE::RenderQueue isolates the rendering of a
+/// frame from the update of the next one, the way the
+/// pipelined loop of TGE::Game uses it: an update thread
+/// modifies and destroys the drawables, then records them into
+/// one packet while the main thread replays the other.
+///
+/// The interleaving is forced, not left to the scheduler: the
+/// whole update of frame N runs in the middle of the replay of
+/// frame N-1, between its first and second draw calls. The
+/// replay must still be identical to drawing the frame N-1
+/// scene directly. No OpenGL context is needed.
+///
+/// Usage: RenderQueueTest
+///
+////////////////////////////////////////////////////////////
+namespace
+{
+    // Number of frames run through the pipeline
+    const int FrameCount = 200;
+
+    int failures = 0;
+
+    void check(bool condition, const char* what, int frame)
+    {
+        if (!condition)
+        {
+            std::printf("FAILED: %s (frame %d)\n", what, frame);
+            failures++;
+        }
+    }
+
+
+    ////////////////////////////////////////////////////////////
+    /// Render target keeping the draw calls it receives, texts
+    /// included, and calling a function after the first one
+    ////////////////////////////////////////////////////////////
+    class CaptureTarget : public TGE::RenderTarget
+    {
+    public :
+
+        struct Call
+        {
+            std::vector<TGE::Vertex> vertices;
+            TGE::PrimitiveType       type;
+            TGE::RenderStates        states;
+            bool                     isText;
+            std::string              string;
+            TGE::Color               color;
+            TGE::Vector2f            position;
+        };
+
+        CaptureTarget() : onFirstCall(NULL)
+        {
+            initialize();
+        }
+
+        virtual TGE::Vector2u getSize() const
+        {
+            return TGE::Vector2u(800, 600);
+        }
+
+        std::vector<Call> calls;
+        void (*onFirstCall)();
+
+    private :
+
+        virtual bool activate(bool)
+        {
+            return false;
+        }
+
+        virtual bool interceptDraw(const TGE::Vertex* vertices, unsigned int vertexCount,
+                                   TGE::PrimitiveType type, const TGE::RenderStates& states)
+        {
+            Call call;
+            call.vertices.assign(vertices, vertices + vertexCount);
+            call.type   = type;
+            call.states = states;
+            call.isText = false;
+            add(call);
+            return true;
+        }
+
+        virtual bool interceptText(const TGE::Text& text, const TGE::RenderStates& states)
+        {
+            Call call;
+            call.type     = TGE::Quads;
+            call.states   = states;
+            call.isText   = true;
+            call.string   = text.getString().toAnsiString();
+            call.color    = text.getColor();
+            call.position = text.getPosition();
+            add(call);
+            return true;
+        }
+
+        void add(const Call& call)
+        {
+            calls.push_back(call);
+            if ((calls.size() == 1) && onFirstCall)
+                onFirstCall();
+        }
+    };
+
+
+    ////////////////////////////////////////////////////////////
+    /// Scene modified by the updates: a shape, a text, and a
+    /// shape destroyed and created again by every update
+    ////////////////////////////////////////////////////////////
+    struct Scene
+    {
+        Scene() : bullet(NULL)
+        {
+            label.setFont(font);
+        }
+
+        ~Scene()
+        {
+            delete bullet;
+        }
+
+        void update(int frame)
+        {
+            float x = static_cast<float>(frame);
+
+            box.setSize(TGE::Vector2f(10.f + x, 20.f));
+            box.setPosition(x, 2.f * x);
+            box.setRotation(x);
+            box.setFillColor(TGE::Color(frame % 256, 255 - frame % 256, 7));
+
+            char string[32];
+            std::sprintf(string, "frame %d", frame);
+            label.setString(string);
+            label.setPosition(3.f * x, 1.f);
+            label.setColor(TGE::Color(1, 2, frame % 256));
+
+            // The previous bullet may still be referenced by the frame being rendered
+            delete bullet;
+            bullet = new TGE::RectangleShape(TGE::Vector2f(1.f, x));
+            bullet->setPosition(x, x);
+
+            stack.clear();
+            stack.push_back(&box);
+            stack.push_back(&label);
+            stack.push_back(bullet);
+        }
+
+        void draw(TGE::RenderTarget& target) const
+        {
+            for (std::size_t i = 0; i < stack.size(); ++i)
+                target.draw(*stack[i]);
+        }
+
+        TGE::Font                   font;
+        TGE::RectangleShape         box;
+        TGE::Text                   label;
+        TGE::RectangleShape*        bullet;
+        std::vector<TGE::Drawable*> stack;
+    };
+
+    bool sameVertices(const std::vector<TGE::Vertex>& left, const std::vector<TGE::Vertex>& right)
+    {
+        if (left.size() != right.size())
+            return false;
+
+        for (std::size_t i = 0; i < left.size(); ++i)
+        {
+            if ((left[i].position != right[i].position) ||
+                (left[i].color != right[i].color) ||
+                (left[i].texCoords != right[i].texCoords))
+                return false;
+        }
+
+        return true;
+    }
+
+    bool sameStates(const TGE::RenderStates& left, const TGE::RenderStates& right)
+    {
+        const float* a = left.transform.getMatrix();
+        const float* b = right.transform.getMatrix();
+        for (int i = 0; i < 16; ++i)
+        {
+            if (a[i] != b[i])
+                return false;
+        }
+
+        return (left.texture == right.texture) && (left.shader == right.shader);
+    }
+
+
+    ////////////////////////////////////////////////////////////
+    // State shared with the update thread, as in TGE::Game
+    ////////////////////////////////////////////////////////////
+    Scene scene;
+    TGE::RenderQueue packets[2];
+    int renderPacket = 0;
+    int updateFrame = 0;
+    bool updateStop = false;
+    TGE::Semaphore updateRequest;
+    TGE::Semaphore updateDone;
+
+    void record(TGE::RenderQueue& packet)
+    {
+        packet.reset();
+        scene.draw(packet);
+    }
+
+    void updateLoop()
+    {
+        while (true)
+        {
+            updateRequest.wait();
+            if (updateStop)
+                return;
+
+            scene.update(updateFrame);
+            record(packets[1 - renderPacket]);
+            updateDone.post();
+        }
+    }
+
+    // Called in the middle of a replay: run the whole next update
+    void updateDuringReplay()
+    {
+        updateRequest.post();
+        updateDone.wait();
+    }
+}
+
+
+////////////////////////////////////////////////////////////
+int main()
+{
+    TGE::Thread updateThread(&updateLoop);
+    updateThread.launch();
+
+    scene.update(0);
+    record(packets[renderPacket]);
+
+    for (int frame = 1; frame <= FrameCount; ++frame)
+    {
+        // Replay frame N-1, with the update of frame N run after its first draw call
+        updateFrame = frame;
+        CaptureTarget rendered;
+        rendered.onFirstCall = &updateDuringReplay;
+        packets[renderPacket].replay(rendered);
+
+        // What frame N-1 looks like when drawn directly
+        Scene reference;
+        reference.update(frame - 1);
+        CaptureTarget expected;
+        reference.draw(expected);
+
+        check(rendered.calls.size() == expected.calls.size(), "number of draw calls", frame);
+        for (std::size_t i = 0; (i < rendered.calls.size()) && (i < expected.calls.size()); ++i)
+        {
+            const CaptureTarget::Call& got = rendered.calls[i];
+            const CaptureTarget::Call& want = expected.calls[i];
+
+            check(got.isText == want.isText, "kind of draw call", frame);
+            check(got.type == want.type, "primitive type", frame);
+            check(sameVertices(got.vertices, want.vertices), "vertices", frame);
+            check(sameStates(got.states, want.states), "render states", frame);
+            check(got.string == want.string, "text string", frame);
+            check(got.color == want.color, "text color", frame);
+            check(got.position == want.position, "text position", frame);
+        }
+
+        // The update must have happened, and be in the other packet
+        check(scene.box.getPosition().x == static_cast<float>(frame), "update ran during the replay", frame);
+        check(packets[1 - renderPacket].getCommandCount() == 3, "next packet recorded", frame);
+
+        renderPacket = 1 - renderPacket;
+    }
+
+    updateStop = true;
+    updateRequest.post();
+    updateThread.wait();
+
+    if (failures > 0)
+    {
+        std::printf("RenderQueueTest: %d failures\n", failures);
+        return 1;
+    }
+
+    std::printf("RenderQueueTest: %d frames replayed while the next was updated, all identical to the direct draws\n", FrameCount);
+    return 0;
+}
@@ -0,0 +1,282 @@
+/*************************************/
+/** Copyright © 2014 Coldsnap Games **/
+/*************************************/
+
+/*************************************/
+/**             Headers             **/
+/*************************************/
+#include <Tyrant/Network.hpp>
+#include <Tyrant/System/Clock.hpp>
+#include <Tyrant/System/Sleep.hpp>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <vector>
+
+
+////////////////////////////////////////////////////////////
+/// Replicates a world from a TGE::ReplicationServer to a few
+/// TGE::ReplicationClient over the loopback interface, in real
+/// time. The deltas and the acknowledgements go through
+/// TGE::LinkConditioner links which lose some of them.
+///
+/// Every snapshot rebuilt by a client must be identical to
+/// the one the server took at the same tick, and the clients
+/// must keep up despite the losses. The program prints the
+/// size of the deltas against full snapshots, and the bytes
+/// sent per client and per second.
+///
+/// Usage: ReplicationTest [port]
+///
+////////////////////////////////////////////////////////////
+namespace
+{
+    // Simulation rate and duration
+    const int TickRate = 20;
+    const TGE::Uint32 TickCount = 100;
+
+    // Size of the world
+    const TGE::Uint16 EntityCount = 300;
+    const std::size_t ClientCount = 4;
+
+    // Ratio of the entities moving on each tick
+    const int MovingPercent = 20;
+
+    // Ratio of the deltas and acknowledgements lost
+    const float Loss = 0.1f;
+
+    unsigned short port = 47600;
+    int failures = 0;
+
+    void check(bool condition, const char* what, TGE::Uint32 tick)
+    {
+        if (!condition)
+        {
+            std::printf("FAILED: %s (tick %u)\n", what, tick);
+            failures++;
+        }
+    }
+
+    // Fields of the entities
+    struct Fields
+    {
+        std::size_t x;
+        std::size_t y;
+        std::size_t health;
+        std::size_t alive;
+    };
+
+    bool isIdentical(const TGE::Snapshot& left, const TGE::Snapshot& right, const Fields& fields)
+    {
+        if ((left.getTick() != right.getTick()) || (left.getEntityCount() != right.getEntityCount()))
+            return false;
+
+        for (std::size_t i = 0; i < left.getEntityCount(); ++i)
+        {
+            TGE::Uint16 entity = left.getEntityId(i);
+            if ((right.getEntityId(i) != entity) ||
+                (left.getFloat(entity, fields.x) != right.getFloat(entity, fields.x)) ||
+                (left.getFloat(entity, fields.y) != right.getFloat(entity, fields.y)) ||
+                (left.getInteger(entity, fields.health) != right.getInteger(entity, fields.health)) ||
+                (left.getBool(entity, fields.alive) != right.getBool(entity, fields.alive)))
+                return false;
+        }
+
+        return true;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// One client, with its sockets and the link delivering
+    /// the deltas to it
+    ////////////////////////////////////////////////////////////
+    struct Client
+    {
+        Client(const TGE::ReplicationSchema& schema, TGE::UdpSocket& serverSocket, TGE::Uint32 seed) :
+        replication (schema),
+        deltaLink   (serverSocket, seed),
+        ackLink     (socket, seed + 100),
+        id          (0),
+        received    (0)
+        {
+            socket.bind(TGE::Socket::AnyPort);
+            socket.setBlocking(false);
+            deltaLink.setLoss(Loss);
+            ackLink.setLoss(Loss);
+        }
+
+        TGE::UdpSocket         socket;
+        TGE::ReplicationClient replication;
+        TGE::LinkConditioner   deltaLink;
+        TGE::LinkConditioner   ackLink;
+        std::size_t            id;
+        TGE::Uint32            received;
+    };
+}
+
+
+////////////////////////////////////////////////////////////
+int main(int argc, char* argv[])
+{
+    if (argc > 1)
+        port = static_cast<unsigned short>(std::atoi(argv[1]));
+
+    TGE::ReplicationSchema schema;
+    Fields fields;
+    fields.x      = schema.addFloat(-1000.f, 1000.f, 16);
+    fields.y      = schema.addFloat(-1000.f, 1000.f, 16);
+    fields.health = schema.addInteger(0, 100);
+    fields.alive  = schema.addBool();
+
+    TGE::UdpSocket serverSocket;
+    if (serverSocket.bind(port) != TGE::Socket::Done)
+    {
+        std::printf("ReplicationTest: cannot bind port %u\n", port);
+        return 1;
+    }
+    serverSocket.setBlocking(false);
+
+    TGE::ReplicationServer server(schema);
+    std::vector<Client*> clients;
+    for (std::size_t i = 0; i < ClientCount; ++i)
+    {
+        clients.push_back(new Client(schema, serverSocket, static_cast<TGE::Uint32>(i + 1)));
+        clients.back()->id = server.addClient();
+    }
+
+    // Snapshots taken by the server, to check what the clients rebuild
+    std::map<TGE::Uint32, TGE::Snapshot> taken;
+    TGE::Snapshot world(schema);
+    for (TGE::Uint16 entity = 0; entity < EntityCount; ++entity)
+    {
+        world.setFloat(entity, fields.x, entity * 3.f - 450.f);
+        world.setFloat(entity, fields.y, entity * -2.f + 300.f);
+        world.setInteger(entity, fields.health, 100);
+        world.setBool(entity, fields.alive, true);
+    }
+
+    std::srand(7);
+    std::size_t deltaBytes = 0;
+    std::size_t deltaCount = 0;
+    std::size_t fullBytes = 0;
+    std::size_t bytesPerSecond = 0;
+    TGE::Packet packet;
+    TGE::IpAddress address;
+    unsigned short remotePort;
+    TGE::Clock clock;
+
+    for (TGE::Uint32 tick = 1; tick <= TickCount; ++tick)
+    {
+        // Move some entities, and now and then replace one
+        for (TGE::Uint16 entity = 0; entity < EntityCount; ++entity)
+        {
+            if ((std::rand() % 100 < MovingPercent) && world.hasEntity(entity))
+            {
+                world.setFloat(entity, fields.x, world.getFloat(entity, fields.x) + std::rand() % 11 - 5.f);
+                world.setFloat(entity, fields.y, world.getFloat(entity, fields.y) + std::rand() % 11 - 5.f);
+            }
+        }
+        if (tick % 10 == 0)
+        {
+            TGE::Uint16 entity = static_cast<TGE::Uint16>(std::rand() % EntityCount);
+            world.removeEntity(entity);
+            world.setInteger(static_cast<TGE::Uint16>(EntityCount + tick), fields.health, std::rand() % 101);
+        }
+        world.setTick(tick);
+        server.addSnapshot(world);
+        taken.insert(std::make_pair(tick, world));
+
+        // The size of a full snapshot, as sent to a new client
+        {
+            TGE::ReplicationServer fresh(schema, 1);
+            std::size_t client = fresh.addClient();
+            fresh.addSnapshot(world);
+            packet.clear();
+            fresh.writeDelta(client, packet);
+            fullBytes += packet.getDataSize();
+        }
+
+        for (std::vector<Client*>::iterator it = clients.begin(); it != clients.end(); ++it)
+        {
+            packet.clear();
+            server.writeDelta((*it)->id, packet);
+            deltaBytes += packet.getDataSize();
+            deltaCount++;
+            (*it)->deltaLink.send(packet, TGE::IpAddress::LocalHost, (*it)->socket.getLocalPort());
+        }
+
+        // Deliver the datagrams until the next tick
+        TGE::Int64 nextTick = static_cast<TGE::Int64>(tick) * 1000000 / TickRate;
+        while (clock.getElapsedTime().asMicroseconds() < nextTick)
+        {
+            for (std::vector<Client*>::iterator it = clients.begin(); it != clients.end(); ++it)
+            {
+                Client& client = **it;
+                client.deltaLink.update();
+                client.ackLink.update();
+
+                while (client.socket.receive(packet, address, remotePort) == TGE::Socket::Done)
+                {
+                    if (!client.replication.readDelta(packet))
+                    {
+                        check(false, "delta read by a client", tick);
+                        continue;
+                    }
+
+                    TGE::Uint32 latest = client.replication.getLatestTick();
+                    const TGE::Snapshot* rebuilt = client.replication.findSnapshot(latest);
+                    check(rebuilt && isIdentical(*rebuilt, taken.find(latest)->second, fields), "snapshot rebuilt identical", latest);
+                    client.received++;
+
+                    TGE::Packet ack;
+                    ack << static_cast<TGE::Uint32>(client.id) << latest;
+                    client.ackLink.send(ack, TGE::IpAddress::LocalHost, port);
+                }
+            }
+
+            while (serverSocket.receive(packet, address, remotePort) == TGE::Socket::Done)
+            {
+                TGE::Uint32 client = 0;
+                TGE::Uint32 acked = 0;
+                if (packet >> client >> acked)
+                    server.acknowledge(client, acked);
+            }
+
+            TGE::sleep(TGE::milliseconds(1));
+        }
+
+        if (tick == TickCount)
+        {
+            for (std::vector<Client*>::iterator it = clients.begin(); it != clients.end(); ++it)
+                bytesPerSecond += server.getBytesPerSecond((*it)->id);
+        }
+    }
+
+    // With 10% of the deltas lost, the clients must still get most ticks
+    for (std::vector<Client*>::iterator it = clients.begin(); it != clients.end(); ++it)
+    {
+        check((*it)->received >= TickCount * 8 / 10, "client kept up despite the losses", TickCount);
+        check((*it)->replication.getLatestTick() + 5 >= TickCount, "client up to date at the end", TickCount);
+        delete *it;
+    }
+
+    std::printf("ReplicationTest: %u entities, %u ticks at %d Hz, %u clients, %.0f%% loss each way\n",
+                EntityCount,
+                TickCount,
+                TickRate,
+                static_cast<unsigned int>(ClientCount),
+                Loss * 100);
+    std::printf("delta %.0f B on average, full snapshot %.0f B (%.1fx smaller)\n",
+                static_cast<double>(deltaBytes) / deltaCount,
+                static_cast<double>(fullBytes) / TickCount,
+                (static_cast<double>(fullBytes) / TickCount) / (static_cast<double>(deltaBytes) / deltaCount));
+    std::printf("%u B/s per client over the last second\n", static_cast<unsigned int>(bytesPerSecond / ClientCount));
+
+    if (failures > 0)
+    {
+        std::printf("ReplicationTest: %d failures\n", failures);
+        return 1;
+    }
+
+    std::printf("ReplicationTest: every snapshot rebuilt by the clients is identical to the server's\n");
+    return 0;
+}
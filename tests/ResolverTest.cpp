@@ -0,0 +1,247 @@
+/*************************************/
+/** Copyright © 2014 Coldsnap Games **/
+/*************************************/
+
+/*************************************/
+/**             Headers             **/
+/*************************************/
+#include <Tyrant/Network.hpp>
+#include <Tyrant/System/Clock.hpp>
+#include <Tyrant/System/Sleep.hpp>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+
+////////////////////////////////////////////////////////////
+/// Checks TGE::Resolver without any network access: the
+/// names come from an /etc/hosts style file written by the
+/// program, and the system lookup only gets the shorthand
+/// numeric forms that inet_addr converts by itself, like
+/// "10.1.2" for 10.1.0.2.
+///
+/// The hosts and the dotted addresses must be answered right
+/// away, the unknown names must fail at once when the system
+/// lookup is disabled, and the other names must be answered
+/// by update() only, once per callback even when requested
+/// together, then cached for the time to live.
+///
+/// Usage: ResolverTest
+///
+////////////////////////////////////////////////////////////
+namespace
+{
+    // Name of the hosts file written for the test
+    const char* HostsFile = "ResolverTest.hosts";
+
+    // Number of names resolved at once by the workers
+    const unsigned int ConcurrentCount = 50;
+
+    // Maximum time to wait for the workers
+    const TGE::Time Timeout = TGE::seconds(5);
+
+    int failures = 0;
+
+    void check(bool condition, const char* what)
+    {
+        if (!condition)
+        {
+            std::printf("FAILED: %s\n", what);
+            failures++;
+        }
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Answers received by a callback
+    ////////////////////////////////////////////////////////////
+    struct Answers
+    {
+        Answers() :
+        count(0)
+        {
+        }
+
+        TGE::Resolver::Callback callback()
+        {
+            return [this](const std::string& answered, const TGE::IpAddress& resolved)
+            {
+                name = answered;
+                address = resolved;
+                count++;
+            };
+        }
+
+        std::string    name;
+        TGE::IpAddress address;
+        unsigned int   count;
+    };
+
+    // Call update() until the given number of answers arrived, return the number of calls
+    unsigned int updateUntil(TGE::Resolver& resolver, const unsigned int& count, unsigned int expected)
+    {
+        unsigned int updates = 0;
+        TGE::Clock clock;
+        while ((count < expected) && (clock.getElapsedTime() < Timeout))
+        {
+            TGE::sleep(TGE::milliseconds(1));
+            resolver.update();
+            updates++;
+        }
+
+        return updates;
+    }
+
+
+    ////////////////////////////////////////////////////////////
+    void testHosts()
+    {
+        TGE::Resolver resolver;
+        resolver.setSystemLookup(false);
+
+        check(!resolver.loadHostsFile("ResolverTest.missing"), "missing hosts file reported");
+        check(resolver.loadHostsFile(HostsFile), "hosts file loaded");
+
+        // The hosts, dotted addresses and failures are answered before resolve() returns
+        Answers answers;
+        resolver.resolve("game.local", answers.callback());
+        check((answers.count == 1) && (answers.address == TGE::IpAddress(10, 0, 0, 5)), "host answered right away");
+
+        resolver.resolve("LOBBY.Game.Local", answers.callback());
+        check((answers.count == 2) && (answers.address == TGE::IpAddress(10, 0, 0, 6)), "alias answered in any case");
+        check(answers.name == "lobby.game.local", "name given in lower case");
+
+        resolver.resolve("192.168.1.20", answers.callback());
+        check((answers.count == 3) && (answers.address == TGE::IpAddress(192, 168, 1, 20)), "dotted address answered right away");
+
+        resolver.resolve("unknown.local", answers.callback());
+        check((answers.count == 4) && (answers.address == TGE::IpAddress::None), "unknown name failed at once");
+
+        resolver.resolve("commented.local", answers.callback());
+        check((answers.count == 5) && (answers.address == TGE::IpAddress::None), "commented host ignored");
+
+        resolver.resolve("invalid.local", answers.callback());
+        check((answers.count == 6) && (answers.address == TGE::IpAddress::None), "host with an invalid address ignored");
+
+        // Hosts added afterwards replace the file's
+        resolver.addHost("game.local", TGE::IpAddress(10, 0, 0, 9));
+        TGE::IpAddress address;
+        check(resolver.lookup("game.local", address) && (address == TGE::IpAddress(10, 0, 0, 9)), "host replaced");
+        check(!resolver.lookup("unknown.local", address), "unknown name not found by lookup");
+
+        // A callback may resolve another name
+        unsigned int nested = 0;
+        resolver.resolve("game.local", [&](const std::string&, const TGE::IpAddress&)
+        {
+            resolver.resolve("lobby.game.local", [&](const std::string&, const TGE::IpAddress&) {nested++;});
+        });
+        check(nested == 1, "name resolved from a callback");
+
+        std::printf("hosts file: hosts, aliases and dotted addresses answered right away\n");
+    }
+
+
+    ////////////////////////////////////////////////////////////
+    void testWorkers()
+    {
+        TGE::Resolver resolver(2);
+        resolver.setTimeToLive(TGE::milliseconds(200), TGE::milliseconds(200));
+
+        // Requests for the same name share one lookup, answered by update() only
+        Answers answers;
+        for (int i = 0; i < 3; ++i)
+            resolver.resolve("10.1.2", answers.callback());
+        TGE::sleep(TGE::milliseconds(50));
+        check(answers.count == 0, "names answered by update() only");
+
+        updateUntil(resolver, answers.count, 1);
+        check(answers.count == 3, "every request answered by the same update");
+        check(answers.address == TGE::IpAddress(10, 1, 0, 2), "name resolved by the system");
+
+        // Cached for the time to live only
+        TGE::IpAddress address;
+        check(resolver.lookup("10.1.2", address) && (address == TGE::IpAddress(10, 1, 0, 2)), "name cached");
+        resolver.resolve("10.1.2", answers.callback());
+        check(answers.count == 4, "cached name answered right away");
+
+        TGE::sleep(TGE::milliseconds(250));
+        check(!resolver.lookup("10.1.2", address), "name expired after its time to live");
+
+        resolver.resolve("10.1.2", answers.callback());
+        updateUntil(resolver, answers.count, 5);
+        check(answers.count == 5, "expired name resolved again");
+
+        resolver.clearCache();
+        check(!resolver.lookup("10.1.2", address), "cache cleared");
+
+        // Many names at once through two workers
+        std::vector<TGE::IpAddress> addresses(ConcurrentCount);
+        unsigned int count = 0;
+        TGE::Clock clock;
+        for (unsigned int i = 0; i < ConcurrentCount; ++i)
+        {
+            std::ostringstream name;
+            name << "10.2." << i;
+            resolver.resolve(name.str(), [&addresses, &count, i](const std::string&, const TGE::IpAddress& resolved)
+            {
+                addresses[i] = resolved;
+                count++;
+            });
+        }
+        unsigned int updates = updateUntil(resolver, count, ConcurrentCount);
+
+        unsigned int correct = 0;
+        for (unsigned int i = 0; i < ConcurrentCount; ++i)
+            correct += (addresses[i] == TGE::IpAddress(10, 2, 0, static_cast<TGE::Uint8>(i))) ? 1 : 0;
+        check(correct == ConcurrentCount, "names resolved at once answered correctly");
+
+        std::printf("workers: %u names resolved in %.1f ms over %u updates\n",
+                    correct,
+                    clock.getElapsedTime().asSeconds() * 1000,
+                    updates);
+
+        // Destroyed with names still queued, it must not wait for them
+        clock.restart();
+        {
+            TGE::Resolver pending(1);
+            for (unsigned int i = 0; i < ConcurrentCount; ++i)
+            {
+                std::ostringstream name;
+                name << "10.3." << i;
+                pending.resolve(name.str(), answers.callback());
+            }
+        }
+        check(clock.getElapsedTime() < Timeout, "resolver destroyed with names queued");
+    }
+}
+
+
+////////////////////////////////////////////////////////////
+int main()
+{
+    {
+        std::ofstream hosts(HostsFile);
+        hosts << "# Hosts of the test\n"
+              << "10.0.0.5    game.local\n"
+              << "10.0.0.6\tlobby.game.local  lobby   # the lobby\n"
+              << "# 10.0.0.7  commented.local\n"
+              << "\n"
+              << "10.0.0.256  invalid.local\n";
+    }
+
+    testHosts();
+    testWorkers();
+
+    std::remove(HostsFile);
+
+    if (failures > 0)
+    {
+        std::printf("ResolverTest: %d failures\n", failures);
+        return 1;
+    }
+
+    std::printf("ResolverTest: every name answered as expected, without the network\n");
+    return 0;
+}
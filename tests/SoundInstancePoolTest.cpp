@@ -0,0 +1,274 @@
+/*************************************/
+/** Copyright © 2014 Coldsnap Games **/
+/*************************************/
+
+/*************************************/
+/**             Headers             **/
+/*************************************/
+#include <Tyrant/Framework/SoundInstancePool.hpp>
+#include <cstdio>
+#include <vector>
+
+
+////////////////////////////////////////////////////////////
+/// Checks the instance pool behind TGE::ResourceManager
+/// offline: the instances are plain flags set by the
+/// program instead of sounds, so the program doesn't need
+/// any audio device.
+///
+/// The finished instances must be recycled rather than
+/// created again, the limit of a group must steal the
+/// oldest or the quietest instance, or refuse the new one,
+/// the limit of the pool must recycle or steal across the
+/// groups, and the handles of the instances released or
+/// stolen must be refused.
+///
+/// Usage: SoundInstancePoolTest
+///
+////////////////////////////////////////////////////////////
+namespace
+{
+    int failures = 0;
+
+    void check(bool condition, const char* what)
+    {
+        if (!condition)
+        {
+            std::printf("FAILED: %s\n", what);
+            failures++;
+        }
+    }
+
+
+    ////////////////////////////////////////////////////////////
+    /// Pool of flags: an instance plays until it is stopped or
+    /// marked as finished
+    ////////////////////////////////////////////////////////////
+    class FlagPool : public TGE::SoundInstancePool
+    {
+    public :
+
+        FlagPool() : stopCount(0)
+        {
+        }
+
+        // Play an instance of a group, return its handle or 0
+        Handle play(Group& group)
+        {
+            std::size_t index = acquire(group);
+            if (index == getSlotCount())
+                return 0;
+
+            finished[index] = false;
+            gains[index] = 100.f;
+            return getHandle(index);
+        }
+
+        bool isPlaying(Handle handle) const
+        {
+            std::size_t index = find(handle);
+            return (index != getSlotCount()) && !finished[index];
+        }
+
+        std::vector<bool>  finished;
+        std::vector<float> gains;
+        unsigned int       stopCount;
+
+    private :
+
+        virtual void onCreate(std::size_t index)
+        {
+            check(index == finished.size(), "instances created in order");
+            finished.push_back(true);
+            gains.push_back(100.f);
+        }
+
+        virtual bool isFinished(std::size_t index) const
+        {
+            return finished[index];
+        }
+
+        virtual float getGain(std::size_t index) const
+        {
+            return gains[index];
+        }
+
+        virtual void onStop(std::size_t index)
+        {
+            finished[index] = true;
+            stopCount++;
+        }
+    };
+
+
+    ////////////////////////////////////////////////////////////
+    void testRecycling()
+    {
+        FlagPool pool;
+        TGE::SoundInstancePool::Group shot;
+
+        // Each shot plays another instance
+        TGE::SoundInstancePool::Handle first = pool.play(shot);
+        TGE::SoundInstancePool::Handle second = pool.play(shot);
+        TGE::SoundInstancePool::Handle third = pool.play(shot);
+        check((first != 0) && (second != 0) && (third != 0), "instances played");
+        check((first != second) && (second != third) && (first != third), "a handle per instance");
+        check((pool.getSlotCount() == 3) && (pool.getInstanceCount() == 3), "instances created for the shots playing together");
+        check(pool.find(0) == pool.getSlotCount(), "null handle refused");
+
+        // A finished instance is recycled with a new handle
+        std::size_t index = pool.find(second);
+        pool.finished[index] = true;
+        TGE::SoundInstancePool::Handle recycled = pool.play(shot);
+        check(pool.find(recycled) == index, "finished instance recycled");
+        check(pool.getSlotCount() == 3, "no instance created for a recycled one");
+        check(recycled != second, "recycled instance handled by another handle");
+        check(pool.find(second) == pool.getSlotCount(), "handle of the finished instance refused");
+        check(pool.isPlaying(first) && pool.isPlaying(third) && pool.isPlaying(recycled), "other instances kept");
+
+        // A released instance stops, and is the next one taken
+        unsigned int stops = pool.stopCount;
+        index = pool.find(third);
+        pool.release(index);
+        check((pool.stopCount == stops + 1) && (pool.find(third) == pool.getSlotCount()), "released instance stopped and handle refused");
+        check(pool.getInstanceCount() == 2, "released instance free");
+        check(pool.find(pool.play(shot)) == index, "released instance taken again");
+
+        // Releasing everything refuses every handle
+        pool.releaseAll();
+        check(pool.getInstanceCount() == 0, "all instances free");
+        check(shot.instances.empty(), "group emptied");
+        check((pool.find(first) == pool.getSlotCount()) && (pool.find(recycled) == pool.getSlotCount()), "handles refused after releasing everything");
+
+        // The generations wrap around without ever repeating the last handle
+        TGE::SoundInstancePool::Handle previous = pool.play(shot);
+        bool renewed = true;
+        for (int i = 0; i < 70000; ++i)
+        {
+            pool.release(pool.find(previous));
+            TGE::SoundInstancePool::Handle next = pool.play(shot);
+            renewed &= (next != previous) && (next != 0);
+            previous = next;
+        }
+        check(renewed, "handle changed at each recycling, across the wrap of the generations");
+        check(pool.getSlotCount() == 3, "recycling creates no instance");
+
+        std::printf("recycling: %u instances for all the shots\n", static_cast<unsigned int>(pool.getSlotCount()));
+    }
+
+
+    ////////////////////////////////////////////////////////////
+    void testGroupLimit()
+    {
+        FlagPool pool;
+        TGE::SoundInstancePool::Group shot;
+        shot.maxInstances = 3;
+        check(TGE::SoundInstancePool::Group().maxInstances == 8, "8 instances per group by default");
+        check(TGE::SoundInstancePool::Group().policy == TGE::SoundInstancePool::StealOldest, "oldest stolen by default");
+
+        // Oldest: the instances are stolen in the order they were played
+        TGE::SoundInstancePool::Handle handles[3];
+        for (int i = 0; i < 3; ++i)
+            handles[i] = pool.play(shot);
+
+        unsigned int stops = pool.stopCount;
+        TGE::SoundInstancePool::Handle stealer = pool.play(shot);
+        check(pool.find(stealer) == static_cast<std::size_t>((handles[0] & 0xFFFF) - 1), "oldest instance stolen");
+        check((pool.find(handles[0]) == pool.getSlotCount()) && (pool.stopCount == stops + 1), "stolen instance stopped and handle refused");
+        check(pool.isPlaying(handles[1]) && pool.isPlaying(handles[2]), "younger instances kept");
+        check((pool.getSlotCount() == 3) && (shot.instances.size() == 3), "limit of the group kept");
+
+        TGE::SoundInstancePool::Handle next = pool.play(shot);
+        check((pool.find(handles[1]) == pool.getSlotCount()) && pool.isPlaying(handles[2]) && pool.isPlaying(stealer), "stealer younger than the others");
+        check(pool.isPlaying(next), "second stealer playing");
+
+        // Quietest: the instance heard the least is stolen, whatever its age
+        TGE::SoundInstancePool::Group voice;
+        voice.maxInstances = 3;
+        voice.policy = TGE::SoundInstancePool::StealQuietest;
+        const float gains[] = {50.f, 10.f, 80.f};
+        for (int i = 0; i < 3; ++i)
+        {
+            handles[i] = pool.play(voice);
+            pool.gains[pool.find(handles[i])] = gains[i];
+        }
+
+        stealer = pool.play(voice);
+        check(pool.find(handles[1]) == pool.getSlotCount(), "quietest instance stolen");
+        check(pool.isPlaying(handles[0]) && pool.isPlaying(handles[2]) && pool.isPlaying(stealer), "louder instances kept");
+
+        // None: the new instance isn't played until one finishes
+        TGE::SoundInstancePool::Group music;
+        music.maxInstances = 2;
+        music.policy = TGE::SoundInstancePool::StealNone;
+        handles[0] = pool.play(music);
+        handles[1] = pool.play(music);
+        std::size_t slots = pool.getSlotCount();
+        check(pool.play(music) == 0, "instance over the limit refused");
+        check(pool.isPlaying(handles[0]) && pool.isPlaying(handles[1]), "instances kept when refusing another");
+        check(pool.getSlotCount() == slots, "no instance created when refusing one");
+
+        pool.finished[pool.find(handles[0])] = true;
+        check(pool.isPlaying(pool.play(music)), "instance played once another finished");
+
+        std::printf("group limit: oldest and quietest instances stolen, new ones refused without stealing\n");
+    }
+
+
+    ////////////////////////////////////////////////////////////
+    void testPoolLimit()
+    {
+        FlagPool pool;
+        pool.setMaxInstances(4);
+        TGE::SoundInstancePool::Group steps;
+        TGE::SoundInstancePool::Group shots;
+
+        TGE::SoundInstancePool::Handle step = pool.play(steps);
+        TGE::SoundInstancePool::Handle handles[3];
+        for (int i = 0; i < 3; ++i)
+            handles[i] = pool.play(shots);
+
+        // A finished instance of another group is recycled first
+        pool.finished[pool.find(handles[1])] = true;
+        TGE::SoundInstancePool::Handle recycled = pool.play(steps);
+        check((pool.getSlotCount() == 4) && pool.isPlaying(recycled), "finished instance of another group recycled");
+        check(pool.isPlaying(step) && pool.isPlaying(handles[0]) && pool.isPlaying(handles[2]), "playing instances kept while one finished");
+        check((steps.instances.size() == 2) && (shots.instances.size() == 2), "recycled instance moved to its new group");
+
+        // Then the oldest of all the groups is stolen
+        TGE::SoundInstancePool::Handle stealer = pool.play(shots);
+        check((pool.getSlotCount() == 4) && pool.isPlaying(stealer), "instance played at the limit of the pool");
+        check(pool.find(step) == pool.getSlotCount(), "oldest instance of all stolen");
+        check(pool.isPlaying(handles[0]) && pool.isPlaying(handles[2]) && pool.isPlaying(recycled), "younger instances kept");
+        check((steps.instances.size() == 1) && (shots.instances.size() == 3), "stolen instance moved to its new group");
+
+        // The limit is at least one instance
+        FlagPool single;
+        TGE::SoundInstancePool::Group first;
+        TGE::SoundInstancePool::Group second;
+        single.setMaxInstances(0);
+        TGE::SoundInstancePool::Handle alone = single.play(first);
+        TGE::SoundInstancePool::Handle thief = single.play(second);
+        check((single.getSlotCount() == 1) && single.isPlaying(thief) && (single.find(alone) == single.getSlotCount()), "pool of a single instance");
+
+        std::printf("pool limit: %u instances shared by the groups\n", static_cast<unsigned int>(pool.getSlotCount()));
+    }
+}
+
+
+////////////////////////////////////////////////////////////
+int main()
+{
+    testRecycling();
+    testGroupLimit();
+    testPoolLimit();
+
+    if (failures > 0)
+    {
+        std::printf("SoundInstancePoolTest: %d failures\n", failures);
+        return 1;
+    }
+
+    std::printf("SoundInstancePoolTest: every instance recycled and stolen as expected\n");
+    return 0;
+}
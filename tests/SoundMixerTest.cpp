@@ -0,0 +1,298 @@
+/*************************************/
+/** Copyright © 2014 Coldsnap Games **/
+/*************************************/
+
+/*************************************/
+/**             Headers             **/
+/*************************************/
+#include <Tyrant/Audio.hpp>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+
+////////////////////////////////////////////////////////////
+/// Checks the mix of TGE::SoundMixer offline: render() is
+/// called directly, without starting the output, so the
+/// program doesn't need any audio device.
+///
+/// The voices play constant or ramp signals whose mix is
+/// known, to check the volumes, the buses, the equal power
+/// panning and the distance attenuation, the saturation, the
+/// resampling, the end of the voices, the choice of the
+/// voices mixed, and the fades between mix blocks.
+///
+/// Usage: SoundMixerTest
+///
+////////////////////////////////////////////////////////////
+namespace
+{
+    // Sample rate of the mixer
+    const unsigned int SampleRate = 44100;
+
+    // Number of frames rendered at once, as the output does
+    const std::size_t BlockFrames = 1024;
+
+    // Value of the constant signals
+    const TGE::Int16 Level = 10000;
+
+    int failures = 0;
+
+    void check(bool condition, const char* what)
+    {
+        if (!condition)
+        {
+            std::printf("FAILED: %s\n", what);
+            failures++;
+        }
+    }
+
+    bool isNear(int value, float expected)
+    {
+        return std::fabs(value - expected) <= 1.5f;
+    }
+
+    // Value of the last frame of a block fading from a gain to another
+    float getFadeEnd(float from, float to)
+    {
+        return from + (to - from) * (BlockFrames - 1) / BlockFrames;
+    }
+
+    // A buffer of a constant value on each channel
+    void makeConstant(TGE::SoundBuffer& buffer, std::size_t frameCount, TGE::Int16 left, TGE::Int16 right, unsigned int channelCount)
+    {
+        std::vector<TGE::Int16> samples(frameCount * channelCount);
+        for (std::size_t i = 0; i < frameCount; ++i)
+        {
+            samples[i * channelCount] = left;
+            samples[i * channelCount + channelCount - 1] = right;
+        }
+        buffer.loadFromSamples(&samples[0], samples.size(), channelCount, SampleRate);
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// One block of the mix
+    ////////////////////////////////////////////////////////////
+    struct Block
+    {
+        explicit Block(TGE::SoundMixer& mixer, std::size_t frameCount = BlockFrames) :
+        samples(frameCount * 2)
+        {
+            mixer.render(&samples[0], frameCount);
+        }
+
+        int left(std::size_t frame) const  {return samples[frame * 2];}
+        int right(std::size_t frame) const {return samples[frame * 2 + 1];}
+        int lastLeft() const               {return samples[samples.size() - 2];}
+        int lastRight() const              {return samples[samples.size() - 1];}
+
+        // Are both channels at the given values on every frame?
+        bool isConstant(float expectedLeft, float expectedRight) const
+        {
+            for (std::size_t i = 0; i < samples.size(); i += 2)
+            {
+                if (!isNear(samples[i], expectedLeft) || !isNear(samples[i + 1], expectedRight))
+                    return false;
+            }
+            return true;
+        }
+
+        std::vector<TGE::Int16> samples;
+    };
+
+    // Render frames whose values don't matter
+    void skip(TGE::SoundMixer& mixer, std::size_t frameCount = BlockFrames)
+    {
+        Block block(mixer, frameCount);
+    }
+
+
+    ////////////////////////////////////////////////////////////
+    void testGains()
+    {
+        TGE::SoundMixer mixer(SampleRate);
+        check(Block(mixer).isConstant(0, 0), "silence without voices");
+
+        TGE::SoundBuffer mono;
+        makeConstant(mono, BlockFrames, Level, Level, 1);
+        check((mono.getChannelCount() == 1) && (mono.getSampleRate() == SampleRate), "buffer format known without an audio device");
+
+        // A centered mono voice has -3 dB on each side, and fades in over the first block
+        TGE::SoundMixer::VoiceId voice = mixer.play(mono);
+        mixer.setLoop(voice, true);
+        check(voice != 0, "voice played");
+
+        const float center = Level * std::cos(3.141592654f / 4);
+        Block fadeIn(mixer);
+        check((std::abs(fadeIn.left(0)) < 20) && isNear(fadeIn.lastLeft(), getFadeEnd(0, center)), "voice fades in over the first block");
+        check(Block(mixer).isConstant(center, center), "centered voice at -3 dB on each side");
+
+        // Volume and bus volume multiply
+        mixer.setVolume(voice, 0.5f);
+        mixer.setBusVolume(0, 0.5f);
+        mixer.update();
+        Block fade(mixer);
+        check(isNear(fade.left(0), center) && isNear(fade.lastLeft(), getFadeEnd(center, center / 4)), "gain change fades over a block");
+        check(Block(mixer).isConstant(center / 4, center / 4), "voice and bus volumes applied");
+        mixer.setBusVolume(0, 1.f);
+        mixer.setVolume(voice, 1.f);
+
+        // To the right of the listener, 10 units away: only the right channel, attenuated to 1/10
+        mixer.setPosition(voice, TGE::Vector3f(10.f, 0.f, 0.f));
+        mixer.update();
+        skip(mixer);
+        check(Block(mixer).isConstant(0, Level * 0.1f), "voice panned right and attenuated");
+
+        // Facing the other way, it's on the left
+        mixer.setListenerDirection(TGE::Vector3f(0.f, 0.f, 1.f));
+        mixer.update();
+        skip(mixer);
+        check(Block(mixer).isConstant(Level * 0.1f, 0), "voice panned left when the listener turns");
+        mixer.stop(voice);
+
+        // Stereo voices keep their channels
+        TGE::SoundBuffer stereo;
+        makeConstant(stereo, BlockFrames * 4, 1000, -2000, 2);
+        mixer.play(stereo);
+        skip(mixer);
+        check(Block(mixer).isConstant(1000, -2000), "stereo voice keeps its channels");
+        mixer.stopAll();
+
+        // Loud voices saturate instead of wrapping around
+        TGE::SoundBuffer loud;
+        makeConstant(loud, BlockFrames * 4, 30000, -30000, 2);
+        for (int i = 0; i < 4; ++i)
+            mixer.play(loud);
+        skip(mixer);
+        check(Block(mixer).isConstant(32767, -32768), "mix saturated");
+
+        std::printf("gains: volumes, buses, panning, attenuation and saturation as expected\n");
+    }
+
+
+    ////////////////////////////////////////////////////////////
+    void testPlayback()
+    {
+        TGE::SoundMixer mixer(SampleRate);
+
+        // A voice stops at its end, the rest of the block is silent
+        TGE::SoundBuffer stereo;
+        makeConstant(stereo, BlockFrames + 100, Level, Level, 2);
+        TGE::SoundMixer::VoiceId voice = mixer.play(stereo);
+        skip(mixer);
+        Block end(mixer);
+        check(isNear(end.left(99), Level) && (end.left(100) == 0) && (end.lastLeft() == 0), "voice stops at its end");
+        check(!mixer.isPlaying(voice) && (mixer.getVoiceCount() == 0), "voice released at its end");
+
+        // The handle of a stopped voice doesn't control the voice reusing its slot
+        TGE::SoundMixer::VoiceId next = mixer.play(stereo);
+        mixer.setVolume(voice, 0.f);
+        check(mixer.isPlaying(next) && !mixer.isPlaying(voice), "stale handle not playing");
+        skip(mixer);
+        check(isNear(Block(mixer, 50).left(0), Level), "stale handle ignored");
+        mixer.stopAll();
+
+        // A buffer at half the rate is resampled: a ramp of 1000 per frame becomes 500
+        std::vector<TGE::Int16> ramp(64 * 2);
+        for (std::size_t i = 0; i < ramp.size(); ++i)
+            ramp[i] = static_cast<TGE::Int16>((i / 2) * 1000 % 30000);
+        TGE::SoundBuffer slow;
+        slow.loadFromSamples(&ramp[0], ramp.size(), 2, SampleRate / 2);
+        voice = mixer.play(slow);
+        mixer.setLoop(voice, true);
+        skip(mixer);
+        Block resampled(mixer);
+
+        bool interpolated = true;
+        for (std::size_t i = 0; i < 40; ++i)
+        {
+            // Position in the buffer, after a first block of 1024 frames at half speed
+            double offset = std::fmod((BlockFrames + i) * 0.5, 64.0);
+            std::size_t index = static_cast<std::size_t>(offset);
+            float expected = ramp[index * 2] + (ramp[((index + 1) % 64 == 0 ? 63 : index + 1) * 2] - ramp[index * 2]) * static_cast<float>(offset - index);
+            interpolated &= isNear(resampled.left(i), expected);
+        }
+        check(interpolated, "buffer resampled to the mixer's rate");
+
+        // The pitch changes the speed the same way
+        mixer.stop(voice);
+        voice = mixer.play(stereo);
+        mixer.setPitch(voice, 2.f);
+        skip(mixer, (BlockFrames + 100) / 2 - 10);
+        check(mixer.isPlaying(voice), "voice at double speed still playing");
+        skip(mixer, 20);
+        check(!mixer.isPlaying(voice), "voice at double speed ended in half the time");
+
+        std::printf("playback: ends, stale handles, resampling and pitch as expected\n");
+    }
+
+
+    ////////////////////////////////////////////////////////////
+    void testVirtualVoices()
+    {
+        TGE::SoundMixer mixer(SampleRate);
+        mixer.setMixedVoiceCount(2);
+
+        // Five voices of different levels, the two most important are mixed
+        const TGE::Int16 levels[] = {100, 200, 400, 800, 1600};
+        const float priorities[] = {1.f, 1.f, 1.f, 1.f, 0.1f};
+        TGE::SoundBuffer buffers[5];
+        TGE::SoundMixer::VoiceId voices[5];
+        for (std::size_t i = 0; i < 5; ++i)
+        {
+            makeConstant(buffers[i], BlockFrames * 8, levels[i], levels[i], 2);
+            voices[i] = mixer.play(buffers[i], 0, priorities[i]);
+        }
+
+        // The louder voice has a low priority: 1600 x 0.1 ranks below 400 and 800
+        mixer.update();
+        check((mixer.getVoiceCount() == 5) && (mixer.getMixedVoiceCount() == 2), "two voices mixed out of five");
+        check(!mixer.isVirtual(voices[2]) && !mixer.isVirtual(voices[3]), "most important voices mixed");
+        check(mixer.isVirtual(voices[0]) && mixer.isVirtual(voices[1]) && mixer.isVirtual(voices[4]), "other voices virtual");
+
+        // The voices mixed fade in over the first block
+        Block fadeIn(mixer);
+        check((std::abs(fadeIn.left(0)) < 5) && isNear(fadeIn.lastLeft(), getFadeEnd(0, 1200)), "mixed voices faded in");
+        check(Block(mixer).isConstant(1200, 1200), "only the mixed voices heard");
+
+        // When a mixed voice stops, the next most important one is mixed, from where it is
+        mixer.stop(voices[3]);
+        mixer.update();
+        check(!mixer.isVirtual(voices[1]) && mixer.isVirtual(voices[4]), "next most important voice mixed");
+        Block change(mixer);
+        check(isNear(change.left(0), 400) && isNear(change.lastLeft(), getFadeEnd(400, 600)), "virtual voice fades in");
+
+        // Virtual voices keep advancing, and end at the same time as the mixed ones
+        skip(mixer, BlockFrames * 8 - BlockFrames * 3 - 10);
+        check(mixer.getVoiceCount() == 4, "voices still playing before their end");
+        skip(mixer, 20);
+        check(mixer.getVoiceCount() == 0, "virtual voices ended with the mixed ones");
+
+        // Voices too quiet to be heard are never mixed
+        TGE::SoundMixer::VoiceId quiet = mixer.play(buffers[4]);
+        mixer.setVolume(quiet, 0.0005f);
+        mixer.update();
+        check(mixer.isVirtual(quiet), "inaudible voice not mixed");
+
+        std::printf("virtual voices: most important voices mixed, the others kept in time\n");
+    }
+}
+
+
+////////////////////////////////////////////////////////////
+int main()
+{
+    testGains();
+    testPlayback();
+    testVirtualVoices();
+
+    if (failures > 0)
+    {
+        std::printf("SoundMixerTest: %d failures\n", failures);
+        return 1;
+    }
+
+    std::printf("SoundMixerTest: every mix as expected, without an audio device\n");
+    return 0;
+}
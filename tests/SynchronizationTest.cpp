@@ -0,0 +1,458 @@
+/*************************************/
+/** Copyright © 2014 Coldsnap Games **/
+/*************************************/
+
+/*************************************/
+/**             Headers             **/
+/*************************************/
+#include <Tyrant/System.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <queue>
+#include <thread>
+#include <vector>
+
+
+////////////////////////////////////////////////////////////
+/// Stresses the synchronization primitives of the System
+/// module with several threads at once.
+///
+/// The mutexes and the spin mutex must never let two threads
+/// in; a thread waiting to write must block the new readers
+/// of TGE::ReadWriteLock, and a writer must get in while
+/// readers keep coming; the condition variable and the
+/// semaphore must wake their waiters and honor their
+/// timeouts; and the lock-free queues must deliver every
+/// element exactly once, in the order of each producer.
+///
+/// Usage: SynchronizationTest [elements]
+///
+////////////////////////////////////////////////////////////
+namespace
+{
+    // Number of threads of the stress tests
+    const unsigned int ThreadCount = 4;
+
+    // Number of times each thread takes a lock
+    const unsigned int LockCount = 100000;
+
+    // Maximum time to wait for a thread
+    const TGE::Time Timeout = TGE::seconds(10);
+
+    unsigned int elementCount = 200000;
+    int failures = 0;
+
+    void check(bool condition, const char* what)
+    {
+        if (!condition)
+        {
+            std::printf("FAILED: %s\n", what);
+            failures++;
+        }
+    }
+
+    // Wait until a flag is set, false if it took too long
+    bool waitFor(const std::atomic<bool>& flag)
+    {
+        TGE::Clock clock;
+        while (!flag.load() && (clock.getElapsedTime() < Timeout))
+            TGE::sleep(TGE::milliseconds(1));
+
+        return flag.load();
+    }
+
+    // Let the other threads run while waiting on a queue, they may share the same core
+    void pause()
+    {
+        std::this_thread::yield();
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Counter incremented by several threads under a lock,
+    /// in two steps so that a missing exclusion shows
+    ////////////////////////////////////////////////////////////
+    template <typename LockType>
+    unsigned int countWith(LockType& lock)
+    {
+        volatile unsigned int counter = 0;
+        std::vector<TGE::Thread*> threads;
+        for (unsigned int i = 0; i < ThreadCount; ++i)
+        {
+            threads.push_back(new TGE::Thread([&]()
+            {
+                for (unsigned int j = 0; j < LockCount; ++j)
+                {
+                    lock.lock();
+                    unsigned int value = counter;
+                    counter = value + 1;
+                    lock.unlock();
+                }
+            }));
+            threads.back()->launch();
+        }
+
+        for (std::vector<TGE::Thread*>::iterator it = threads.begin(); it != threads.end(); ++it)
+            delete *it;
+
+        return counter;
+    }
+
+
+    ////////////////////////////////////////////////////////////
+    void testMutexes()
+    {
+        TGE::Mutex recursive;
+        TGE::Mutex nonRecursive(TGE::Mutex::NonRecursive);
+        TGE::SpinMutex spin;
+
+        check(countWith(recursive) == ThreadCount * LockCount, "recursive mutex excludes the other threads");
+        check(countWith(nonRecursive) == ThreadCount * LockCount, "non-recursive mutex excludes the other threads");
+        check(countWith(spin) == ThreadCount * LockCount, "spin mutex excludes the other threads");
+
+        // tryLock fails while another thread holds the lock
+        std::atomic<bool> locked(false);
+        std::atomic<bool> release(false);
+        TGE::Thread holder([&]()
+        {
+            nonRecursive.lock();
+            spin.lock();
+            locked = true;
+            waitFor(release);
+            spin.unlock();
+            nonRecursive.unlock();
+        });
+        holder.launch();
+        waitFor(locked);
+        check(!nonRecursive.tryLock() && !spin.tryLock(), "tryLock fails while the lock is held");
+        release = true;
+        holder.wait();
+        check(spin.tryLock(), "tryLock succeeds once the lock is released");
+        spin.unlock();
+
+        std::printf("mutexes: %u increments each, %u, %u and %u contended locks\n",
+                    ThreadCount * LockCount,
+                    recursive.getContentionCount(),
+                    nonRecursive.getContentionCount(),
+                    spin.getContentionCount());
+    }
+
+
+    ////////////////////////////////////////////////////////////
+    void testReadWriteLock()
+    {
+        TGE::ReadWriteLock lock;
+
+        // A reader holds the lock, a writer waits for it
+        check(lock.tryLockRead(), "first reader admitted");
+        std::atomic<bool> written(false);
+        TGE::Thread writer([&]()
+        {
+            lock.lockWrite();
+            written = true;
+            TGE::sleep(TGE::milliseconds(20));
+            lock.unlockWrite();
+        });
+        writer.launch();
+
+        // The writer counts as contended before it blocks
+        TGE::Clock clock;
+        while ((lock.getContentionCount() == 0) && (clock.getElapsedTime() < Timeout))
+            TGE::sleep(TGE::milliseconds(1));
+        TGE::sleep(TGE::milliseconds(20));
+
+        // New readers wait behind the writer
+        bool admitted = lock.tryLockRead();
+        if (admitted)
+            lock.unlockRead();
+        check(!admitted && !written, "new reader blocked while a writer waits");
+
+        std::atomic<bool> readerStarted(false);
+        std::atomic<bool> writtenBeforeRead(false);
+        TGE::Thread reader([&]()
+        {
+            readerStarted = true;
+            lock.lockRead();
+            writtenBeforeRead = written.load();
+            lock.unlockRead();
+        });
+        reader.launch();
+        waitFor(readerStarted);
+        TGE::sleep(TGE::milliseconds(20));
+
+        lock.unlockRead();
+        writer.wait();
+        reader.wait();
+        check(writtenBeforeRead, "waiting writer admitted before the new reader");
+
+        // Readers share the lock, and a writer still gets in while they keep coming
+        std::atomic<bool> stop(false);
+        std::atomic<unsigned int> reads(0);
+        volatile unsigned int first = 0;
+        volatile unsigned int second = 0;
+        std::atomic<bool> consistent(true);
+        std::vector<TGE::Thread*> readers;
+        for (unsigned int i = 0; i < ThreadCount; ++i)
+        {
+            readers.push_back(new TGE::Thread([&]()
+            {
+                while (!stop)
+                {
+                    lock.lockRead();
+                    if (first != second)
+                        consistent = false;
+                    lock.unlockRead();
+                    reads++;
+                }
+            }));
+            readers.back()->launch();
+        }
+
+        clock.restart();
+        const unsigned int writeCount = 200;
+        for (unsigned int i = 0; i < writeCount; ++i)
+        {
+            lock.lockWrite();
+            first = first + 1;
+            second = second + 1;
+            lock.unlockWrite();
+            pause();
+        }
+        TGE::Time writeTime = clock.getElapsedTime();
+
+        stop = true;
+        for (std::vector<TGE::Thread*>::iterator it = readers.begin(); it != readers.end(); ++it)
+            delete *it;
+
+        check(consistent.load(), "readers never see a write half done");
+        check((first == writeCount) && (writeTime < Timeout), "writer not starved by the readers");
+
+        std::printf("read-write lock: %u writes in %.1f ms among %u reads\n",
+                    writeCount,
+                    writeTime.asSeconds() * 1000,
+                    reads.load());
+    }
+
+
+    ////////////////////////////////////////////////////////////
+    void testWaits()
+    {
+        // A timed wait without notification times out
+        TGE::Mutex mutex(TGE::Mutex::NonRecursive);
+        TGE::ConditionVariable condition;
+        TGE::Clock clock;
+        mutex.lock();
+        bool notified = condition.wait(mutex, TGE::milliseconds(30));
+        mutex.unlock();
+        check(!notified && (clock.getElapsedTime() >= TGE::milliseconds(25)), "condition wait timed out");
+
+        // Messages passed from producers to consumers through a queue
+        std::queue<unsigned int> messages;
+        unsigned int produced = 0;
+        unsigned int consumed = 0;
+        unsigned int sum = 0;
+        const unsigned int messageCount = 20000;
+        std::vector<TGE::Thread*> threads;
+        for (unsigned int i = 0; i < ThreadCount; ++i)
+        {
+            threads.push_back(new TGE::Thread([&]()
+            {
+                for (;;)
+                {
+                    TGE::Lock lock(mutex);
+                    if (produced == messageCount)
+                        return;
+                    messages.push(++produced);
+                    condition.notifyOne();
+                }
+            }));
+            threads.push_back(new TGE::Thread([&]()
+            {
+                for (;;)
+                {
+                    TGE::Lock lock(mutex);
+                    while (messages.empty() && (consumed < messageCount))
+                        condition.wait(mutex);
+                    if (consumed == messageCount)
+                    {
+                        condition.notifyAll();
+                        return;
+                    }
+                    sum += messages.front();
+                    messages.pop();
+                    consumed++;
+                }
+            }));
+        }
+        for (std::vector<TGE::Thread*>::iterator it = threads.begin(); it != threads.end(); ++it)
+            (*it)->launch();
+        for (std::vector<TGE::Thread*>::iterator it = threads.begin(); it != threads.end(); ++it)
+            delete *it;
+
+        check((consumed == messageCount) && (sum == messageCount * (messageCount + 1) / 2), "every message passed through the condition variable");
+
+        // The semaphore times out without a post, and wakes up on one
+        TGE::Semaphore semaphore;
+        clock.restart();
+        check(!semaphore.tryWait(), "semaphore empty");
+        check(!semaphore.tryWait(TGE::milliseconds(30)) && (clock.getElapsedTime() >= TGE::milliseconds(25)), "semaphore wait timed out");
+
+        TGE::Thread poster([&]()
+        {
+            TGE::sleep(TGE::milliseconds(10));
+            semaphore.post();
+        });
+        poster.launch();
+        check(semaphore.tryWait(Timeout), "semaphore woken by a post");
+        poster.wait();
+
+        std::printf("waits: timeouts honored, %u messages passed\n", consumed);
+    }
+
+
+    ////////////////////////////////////////////////////////////
+    void testSpscQueue()
+    {
+        TGE::SpscQueue<unsigned int> queue(1000);
+        check(queue.getCapacity() >= 1000, "single producer queue capacity");
+
+        // Fill and empty it from a single thread
+        unsigned int value = 0;
+        std::size_t pushed = 0;
+        while (queue.push(static_cast<unsigned int>(pushed)))
+            pushed++;
+        check(pushed == queue.getCapacity(), "single producer queue full at its capacity");
+
+        bool ordered = true;
+        for (std::size_t i = 0; i < pushed; ++i)
+            ordered &= queue.pop(value) && (value == i);
+        check(ordered && queue.isEmpty() && !queue.pop(value), "single producer queue emptied in order");
+
+        // One producer and one consumer at once
+        TGE::Clock clock;
+        TGE::Thread producer([&]()
+        {
+            for (unsigned int i = 1; i <= elementCount; ++i)
+            {
+                while (!queue.push(i) && (clock.getElapsedTime() < Timeout))
+                    pause();
+            }
+        });
+        producer.launch();
+
+        unsigned int expected = 1;
+        ordered = true;
+        while ((expected <= elementCount) && (clock.getElapsedTime() < Timeout))
+        {
+            if (queue.pop(value))
+            {
+                ordered &= (value == expected);
+                expected++;
+            }
+            else
+            {
+                pause();
+            }
+        }
+        producer.wait();
+
+        check(ordered && (expected == elementCount + 1), "single producer queue delivers every element in order");
+        std::printf("single producer queue: %u elements in %.1f ms\n",
+                    expected - 1,
+                    clock.getElapsedTime().asSeconds() * 1000);
+    }
+
+
+    ////////////////////////////////////////////////////////////
+    void testMpmcQueue()
+    {
+        TGE::MpmcQueue<unsigned int> queue(1000);
+        check(queue.getCapacity() >= 1000, "multiple producer queue capacity");
+
+        // Each element carries its producer in the upper bits, and its index in the lower bits
+        const unsigned int perProducer = elementCount / ThreadCount;
+        std::vector<unsigned char> received(ThreadCount * perProducer, 0);
+        std::atomic<unsigned int> consumed(0);
+        std::atomic<bool> ordered(true);
+        TGE::Clock clock;
+
+        std::vector<TGE::Thread*> threads;
+        for (unsigned int producer = 0; producer < ThreadCount; ++producer)
+        {
+            threads.push_back(new TGE::Thread([&, producer]()
+            {
+                for (unsigned int i = 0; i < perProducer; ++i)
+                {
+                    while (!queue.push((producer << 24) | i) && (clock.getElapsedTime() < Timeout))
+                        pause();
+                }
+            }));
+        }
+        for (unsigned int consumer = 0; consumer < ThreadCount; ++consumer)
+        {
+            threads.push_back(new TGE::Thread([&]()
+            {
+                // A consumer sees the elements of each producer in the order they were pushed
+                std::vector<int> last(ThreadCount, -1);
+                unsigned int value;
+                while ((consumed.load() < ThreadCount * perProducer) && (clock.getElapsedTime() < Timeout))
+                {
+                    if (!queue.pop(value))
+                    {
+                        pause();
+                        continue;
+                    }
+
+                    unsigned int producer = value >> 24;
+                    int index = static_cast<int>(value & 0xFFFFFF);
+                    if (index <= last[producer])
+                        ordered = false;
+                    last[producer] = index;
+
+                    received[producer * perProducer + index]++;
+                    consumed++;
+                }
+            }));
+        }
+        for (std::vector<TGE::Thread*>::iterator it = threads.begin(); it != threads.end(); ++it)
+            (*it)->launch();
+        for (std::vector<TGE::Thread*>::iterator it = threads.begin(); it != threads.end(); ++it)
+            delete *it;
+
+        bool once = true;
+        for (std::vector<unsigned char>::const_iterator it = received.begin(); it != received.end(); ++it)
+            once &= (*it == 1);
+
+        check(once && (consumed.load() == ThreadCount * perProducer), "multiple producer queue delivers every element once");
+        check(ordered.load(), "multiple producer queue keeps the order of each producer");
+        std::printf("multiple producer queue: %u elements through %u producers and %u consumers in %.1f ms\n",
+                    consumed.load(),
+                    ThreadCount,
+                    ThreadCount,
+                    clock.getElapsedTime().asSeconds() * 1000);
+    }
+}
+
+
+////////////////////////////////////////////////////////////
+int main(int argc, char* argv[])
+{
+    if (argc > 1)
+        elementCount = std::min(std::max(std::atoi(argv[1]), 4), 0xFFFFFF);
+
+    testMutexes();
+    testReadWriteLock();
+    testWaits();
+    testSpscQueue();
+    testMpmcQueue();
+
+    if (failures > 0)
+    {
+        std::printf("SynchronizationTest: %d failures\n", failures);
+        return 1;
+    }
+
+    std::printf("SynchronizationTest: every primitive kept its guarantees under contention\n");
+    return 0;
+}
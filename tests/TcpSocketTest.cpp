@@ -0,0 +1,273 @@
+/*************************************/
+/** Copyright © 2014 Coldsnap Games **/
+/*************************************/
+
+/*************************************/
+/**             Headers             **/
+/*************************************/
+#include <Tyrant/Network.hpp>
+#include <Tyrant/System/Clock.hpp>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#if defined(OS_WINDOWS)
+    #include <winsock2.h>
+#else
+    #include <sys/socket.h>
+#endif
+
+
+////////////////////////////////////////////////////////////
+/// Checks the packet framing of TGE::TcpSocket over the
+/// loopback interface, when the system can't take the data
+/// as fast as it is sent.
+///
+/// The sending socket is non-blocking with tiny system
+/// buffers, so that the batches of packets and the big
+/// packets are only partly sent: each send must be repeated
+/// with the same packets until it's done, and the receiver,
+/// which reads in between, must get every packet intact and
+/// in order. Then a packet over the maximum size set on the
+/// receiver must close the connection.
+///
+/// Usage: TcpSocketTest [port]
+///
+////////////////////////////////////////////////////////////
+namespace
+{
+    // Number of packets of the batch, more than a single system call sends
+    const TGE::Uint32 BatchCount = 300;
+
+    // Size of the big packet sent alone
+    const std::size_t BigPacketSize = 1024 * 1024;
+
+    // Size asked for the system buffers of the sockets
+    const int SystemBufferSize = 4096;
+
+    // Maximum duration of a transfer
+    const TGE::Time Timeout = TGE::seconds(20);
+
+    unsigned short port = 48300;
+    int failures = 0;
+
+    void check(bool condition, const char* what)
+    {
+        if (!condition)
+        {
+            std::printf("FAILED: %s\n", what);
+            failures++;
+        }
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// TCP socket whose system buffers can be shrunk
+    ////////////////////////////////////////////////////////////
+    class SmallBufferSocket : public TGE::TcpSocket
+    {
+    public :
+
+        void shrinkBuffers()
+        {
+            setsockopt(getHandle(), SOL_SOCKET, SO_SNDBUF, reinterpret_cast<const char*>(&SystemBufferSize), sizeof(SystemBufferSize));
+            setsockopt(getHandle(), SOL_SOCKET, SO_RCVBUF, reinterpret_cast<const char*>(&SystemBufferSize), sizeof(SystemBufferSize));
+        }
+    };
+
+    // Size of the packet of a given index, some of them bigger than the system buffers
+    std::size_t getPacketSize(TGE::Uint32 index)
+    {
+        return (index % 7 == 0) ? 30000 : (index * 37) % 500 + 1;
+    }
+
+    // Content of the packet of a given index: its index, then bytes recognizable at any offset
+    void fillPacket(TGE::Packet& packet, TGE::Uint32 index, std::size_t size)
+    {
+        packet.clear();
+        packet << index;
+        for (std::size_t i = 0; i < size; ++i)
+            packet << static_cast<TGE::Uint8>(index + i);
+    }
+
+    bool isIntact(TGE::Packet& packet, TGE::Uint32 expected, std::size_t size)
+    {
+        if (packet.getDataSize() != sizeof(TGE::Uint32) + size)
+            return false;
+
+        TGE::Uint32 index;
+        packet >> index;
+        if (index != expected)
+            return false;
+
+        const TGE::Uint8* bytes = static_cast<const TGE::Uint8*>(packet.getData()) + sizeof(TGE::Uint32);
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            if (bytes[i] != static_cast<TGE::Uint8>(index + i))
+                return false;
+        }
+
+        return true;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Receiving end, reading whatever is available
+    ////////////////////////////////////////////////////////////
+    struct Receiver
+    {
+        Receiver(TGE::TcpSocket& receiving) :
+        socket  (receiving),
+        next    (0),
+        intact  (true)
+        {
+        }
+
+        // Check the packets available, return the number received
+        std::size_t receive(std::size_t (*size)(TGE::Uint32))
+        {
+            std::vector<TGE::Packet*> packets;
+            if (socket.receive(packets) != TGE::Socket::Done)
+                return 0;
+
+            for (std::vector<TGE::Packet*>::const_iterator it = packets.begin(); it != packets.end(); ++it)
+            {
+                intact &= isIntact(**it, next, size(next));
+                next++;
+            }
+
+            return packets.size();
+        }
+
+        TGE::TcpSocket& socket;
+        TGE::Uint32     next;
+        bool            intact;
+    };
+
+    std::size_t getBigPacketSize(TGE::Uint32)
+    {
+        return BigPacketSize;
+    }
+
+
+    ////////////////////////////////////////////////////////////
+    void testPartialSends(SmallBufferSocket& sender, TGE::TcpSocket& receiving)
+    {
+        std::vector<TGE::Packet> packets(BatchCount);
+        for (TGE::Uint32 i = 0; i < BatchCount; ++i)
+            fillPacket(packets[i], i, getPacketSize(i));
+
+        // The batch is sent again until it's done, while the receiver reads some of it
+        Receiver receiver(receiving);
+        unsigned int partials = 0;
+        unsigned int attempts = 0;
+        TGE::Clock clock;
+        TGE::Socket::Status status;
+        while (((status = sender.send(&packets[0], packets.size())) != TGE::Socket::Done) && (clock.getElapsedTime() < Timeout))
+        {
+            check((status == TGE::Socket::Partial) || (status == TGE::Socket::NotReady), "batch send only interrupted by full buffers");
+            if (status == TGE::Socket::Partial)
+                partials++;
+            attempts++;
+
+            receiver.receive(getPacketSize);
+        }
+        check(status == TGE::Socket::Done, "batch sent");
+
+        while ((receiver.next < BatchCount) && (clock.getElapsedTime() < Timeout))
+            receiver.receive(getPacketSize);
+
+        check(partials > 0, "batch partly sent");
+        check(receiver.next == BatchCount, "every packet of the batch received");
+        check(receiver.intact, "batch received intact and in order");
+
+        std::printf("batch: %u packets sent in %u attempts, %u of them partial\n", BatchCount, attempts + 1, partials);
+
+        // A single big packet resumes the same way
+        TGE::Packet big;
+        fillPacket(big, 0, BigPacketSize);
+        Receiver bigReceiver(receiving);
+        partials = 0;
+        clock.restart();
+        while (((status = sender.send(big)) != TGE::Socket::Done) && (clock.getElapsedTime() < Timeout))
+        {
+            partials += (status == TGE::Socket::Partial) ? 1 : 0;
+            bigReceiver.receive(getBigPacketSize);
+        }
+        while ((bigReceiver.next < 1) && (clock.getElapsedTime() < Timeout))
+            bigReceiver.receive(getBigPacketSize);
+
+        check((status == TGE::Socket::Done) && (partials > 0), "big packet sent in parts");
+        check((bigReceiver.next == 1) && bigReceiver.intact, "big packet received intact");
+
+        std::printf("big packet: %u bytes sent in %u partial sends\n", static_cast<unsigned int>(BigPacketSize), partials);
+    }
+
+
+    ////////////////////////////////////////////////////////////
+    void testMaxPacketSize(SmallBufferSocket& sender, TGE::TcpSocket& receiving)
+    {
+        const std::size_t maxSize = 1000;
+        check(receiving.getMaxPacketSize() == 16 * 1024 * 1024, "default maximum packet size");
+        receiving.setMaxPacketSize(maxSize);
+
+        // A packet of the maximum size is accepted
+        TGE::Packet packet;
+        fillPacket(packet, 1, maxSize - sizeof(TGE::Uint32));
+        TGE::Clock clock;
+        while ((sender.send(packet) != TGE::Socket::Done) && (clock.getElapsedTime() < Timeout))
+            ;
+
+        TGE::Packet received;
+        TGE::Socket::Status status;
+        while (((status = receiving.receive(received)) == TGE::Socket::NotReady) && (clock.getElapsedTime() < Timeout))
+            ;
+        check((status == TGE::Socket::Done) && isIntact(received, 1, maxSize - sizeof(TGE::Uint32)), "packet of the maximum size received");
+
+        // A bigger one closes the connection
+        fillPacket(packet, 2, maxSize);
+        while ((sender.send(packet) != TGE::Socket::Done) && (clock.getElapsedTime() < Timeout))
+            ;
+        while (((status = receiving.receive(received)) == TGE::Socket::NotReady) && (clock.getElapsedTime() < Timeout))
+            ;
+        check(status == TGE::Socket::Error, "packet over the maximum size refused");
+        check(receiving.getRemotePort() == 0, "peer sending a packet over the maximum size disconnected");
+
+        std::printf("maximum packet size: %u bytes accepted, more refused\n", static_cast<unsigned int>(maxSize));
+    }
+}
+
+
+////////////////////////////////////////////////////////////
+int main(int argc, char* argv[])
+{
+    if (argc > 1)
+        port = static_cast<unsigned short>(std::atoi(argv[1]));
+
+    // The receiving end is the one that closes, so it's the client: the
+    // port of the listener is then free again for the next run
+    TGE::TcpListener listener;
+    SmallBufferSocket sender;
+    TGE::TcpSocket receiving;
+    if ((listener.listen(port) != TGE::Socket::Done) ||
+        (receiving.connect(TGE::IpAddress::LocalHost, port) != TGE::Socket::Done) ||
+        (listener.accept(sender) != TGE::Socket::Done))
+    {
+        std::printf("TcpSocketTest: failed to connect on port %u\n", port);
+        return 1;
+    }
+
+    sender.shrinkBuffers();
+    sender.setBlocking(false);
+    receiving.setBlocking(false);
+
+    testPartialSends(sender, receiving);
+    testMaxPacketSize(sender, receiving);
+
+    if (failures > 0)
+    {
+        std::printf("TcpSocketTest: %d failures\n", failures);
+        return 1;
+    }
+
+    std::printf("TcpSocketTest: every packet received intact after partial sends\n");
+    return 0;
+}
@@ -0,0 +1,240 @@
+/*************************************/
+/** Copyright © 2014 Coldsnap Games **/
+/*************************************/
+
+/*************************************/
+/**             Headers             **/
+/*************************************/
+#include <Tyrant/Network.hpp>
+#include <Tyrant/System/Clock.hpp>
+#include <Tyrant/System/Sleep.hpp>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+
+////////////////////////////////////////////////////////////
+/// Checks the delivery guarantees of TGE::UdpConnection over
+/// the loopback interface, through a TGE::LinkConditioner on
+/// each side which delays, drops and reorders the datagrams.
+///
+/// For several seeds, a stream of numbered messages is sent
+/// on each channel, some big enough to be fragmented. The
+/// reliable messages must all arrive exactly once, in order
+/// and intact; the sequenced ones must never go backwards.
+/// Raw datagrams are sent through the same links first, to
+/// prove that they really drop and reorder.
+///
+/// Usage: UdpConnectionTest [port]
+///
+////////////////////////////////////////////////////////////
+namespace
+{
+    // Seeds of the links, each one is a separate run
+    const TGE::Uint32 Seeds[] = {1, 2, 3};
+
+    // Number of messages sent on each channel by a run
+    const TGE::Uint32 MessageCount = 300;
+
+    // Every nth reliable message is big enough to be split into fragments
+    const TGE::Uint32 BigMessageInterval = 25;
+    const std::size_t BigMessageSize = 3 * TGE::UdpConnection::MaxFragmentSize + 100;
+
+    // Number of raw datagrams sent to check that the link reorders
+    const TGE::Uint32 RawDatagramCount = 200;
+
+    // Maximum duration of a run
+    const TGE::Time Timeout = TGE::seconds(30);
+
+    unsigned short port = 47500;
+    int failures = 0;
+
+    void check(bool condition, const char* what, TGE::Uint32 seed)
+    {
+        if (!condition)
+        {
+            std::printf("FAILED: %s (seed %u)\n", what, seed);
+            failures++;
+        }
+    }
+
+    // Content of the message of a given index, recognizable at any offset
+    void fillMessage(TGE::Packet& packet, TGE::Uint8 channel, TGE::Uint32 index)
+    {
+        packet.clear();
+        packet << channel << index;
+
+        std::size_t size = ((channel == TGE::UdpConnection::ReliableOrdered) && (index % BigMessageInterval == 0)) ? BigMessageSize : 32;
+        for (std::size_t i = 0; i < size; ++i)
+            packet << static_cast<TGE::Uint8>(index + i);
+    }
+
+    bool isIntact(TGE::Packet& packet, TGE::Uint32 index)
+    {
+        std::size_t size = packet.getDataSize() - sizeof(TGE::Uint8) - sizeof(TGE::Uint32);
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            TGE::Uint8 byte;
+            if (!(packet >> byte) || (byte != static_cast<TGE::Uint8>(index + i)))
+                return false;
+        }
+
+        return packet.endOfPacket();
+    }
+
+
+    ////////////////////////////////////////////////////////////
+    void runLink(TGE::Uint32 seed)
+    {
+        TGE::UdpSocket clientSocket;
+        TGE::UdpSocket serverSocket;
+        if ((clientSocket.bind(TGE::Socket::AnyPort) != TGE::Socket::Done) || (serverSocket.bind(port) != TGE::Socket::Done))
+        {
+            check(false, "binding the sockets", seed);
+            return;
+        }
+        clientSocket.setBlocking(false);
+        serverSocket.setBlocking(false);
+
+        TGE::LinkConditioner clientLink(clientSocket, seed);
+        TGE::LinkConditioner serverLink(serverSocket, seed + 100);
+        TGE::LinkConditioner* links[] = {&clientLink, &serverLink};
+        for (std::size_t i = 0; i < 2; ++i)
+        {
+            links[i]->setLatency(TGE::milliseconds(20));
+            links[i]->setJitter(TGE::milliseconds(15));
+            links[i]->setLoss(0.1f);
+            links[i]->setReordering(0.1f);
+        }
+
+        // Raw datagrams, without the connection
+        TGE::Uint32 rawReceived = 0;
+        TGE::Uint32 inversions = 0;
+        TGE::Uint32 lastRaw = 0;
+        TGE::Packet packet;
+        TGE::IpAddress address;
+        unsigned short remotePort;
+        for (TGE::Uint32 i = 0; i < RawDatagramCount; ++i)
+        {
+            packet.clear();
+            packet << i;
+            clientLink.send(packet, TGE::IpAddress::LocalHost, port);
+        }
+
+        TGE::Clock clock;
+        while ((rawReceived + clientLink.getDroppedCount() < RawDatagramCount) && (clock.getElapsedTime() < Timeout))
+        {
+            clientLink.update();
+            while (serverSocket.receive(packet, address, remotePort) == TGE::Socket::Done)
+            {
+                TGE::Uint32 index = 0;
+                packet >> index;
+                inversions += (rawReceived > 0) && (index < lastRaw) ? 1 : 0;
+                lastRaw = index;
+                rawReceived++;
+            }
+
+            TGE::sleep(TGE::milliseconds(1));
+        }
+
+        check(clientLink.getDroppedCount() > 0, "the link dropped datagrams", seed);
+        check(inversions > 0, "the link reordered datagrams", seed);
+
+        TGE::UdpConnection client(clientSocket, TGE::IpAddress::LocalHost, port);
+        TGE::UdpConnection server(serverSocket, TGE::IpAddress::LocalHost, clientSocket.getLocalPort());
+        client.setLinkConditioner(&clientLink);
+        server.setLinkConditioner(&serverLink);
+
+        TGE::Uint32 sent = 0;
+        TGE::Uint32 expected = 0;
+        TGE::Uint32 lastSequenced = 0;
+        bool sequencedReceived = false;
+
+        clock.restart();
+        while ((expected < MessageCount) && (clock.getElapsedTime() < Timeout))
+        {
+            // One message per channel and per update
+            if (sent < MessageCount)
+            {
+                fillMessage(packet, TGE::UdpConnection::ReliableOrdered, sent);
+                client.send(packet, TGE::UdpConnection::ReliableOrdered);
+                fillMessage(packet, TGE::UdpConnection::UnreliableSequenced, sent);
+                client.send(packet, TGE::UdpConnection::UnreliableSequenced);
+                fillMessage(packet, TGE::UdpConnection::Unreliable, sent);
+                client.send(packet, TGE::UdpConnection::Unreliable);
+                sent++;
+            }
+
+            client.update();
+            server.update();
+
+            while (clientSocket.receive(packet, address, remotePort) == TGE::Socket::Done)
+                client.processDatagram(packet);
+            while (serverSocket.receive(packet, address, remotePort) == TGE::Socket::Done)
+                server.processDatagram(packet);
+
+            while (server.receive(packet))
+            {
+                TGE::Uint8 channel = 0;
+                TGE::Uint32 index = 0;
+                packet >> channel >> index;
+
+                switch (channel)
+                {
+                    case TGE::UdpConnection::ReliableOrdered :
+                        check(index == expected, "reliable message received out of order, twice or not at all", seed);
+                        check(isIntact(packet, index), "reliable message corrupted", seed);
+                        expected = index + 1;
+                        break;
+
+                    case TGE::UdpConnection::UnreliableSequenced :
+                        check(!sequencedReceived || (index > lastSequenced), "sequenced message older than the previous one", seed);
+                        check(isIntact(packet, index), "sequenced message corrupted", seed);
+                        lastSequenced = index;
+                        sequencedReceived = true;
+                        break;
+
+                    case TGE::UdpConnection::Unreliable :
+                        check(isIntact(packet, index), "unreliable message corrupted", seed);
+                        break;
+
+                    default :
+                        check(false, "unknown message", seed);
+                        break;
+                }
+            }
+
+            TGE::sleep(TGE::milliseconds(2));
+        }
+
+        check(expected == MessageCount, "all the reliable messages received before the timeout", seed);
+        check(sequencedReceived, "some sequenced messages received", seed);
+
+        std::printf("seed %u: %u/%u reliable messages in order in %.2f s, %u raw datagrams out of order\n",
+                    seed,
+                    expected,
+                    MessageCount,
+                    clock.getElapsedTime().asSeconds(),
+                    inversions);
+    }
+}
+
+
+////////////////////////////////////////////////////////////
+int main(int argc, char* argv[])
+{
+    if (argc > 1)
+        port = static_cast<unsigned short>(std::atoi(argv[1]));
+
+    for (std::size_t i = 0; i < sizeof(Seeds) / sizeof(*Seeds); ++i)
+        runLink(Seeds[i]);
+
+    if (failures > 0)
+    {
+        std::printf("UdpConnectionTest: %d failures\n", failures);
+        return 1;
+    }
+
+    std::printf("UdpConnectionTest: every reliable message delivered once and in order through the conditioned links\n");
+    return 0;
+}
@@ -0,0 +1,269 @@
+/*************************************/
+/** Copyright © 2014 Coldsnap Games **/
+/*************************************/
+
+/*************************************/
+/**             Headers             **/
+/*************************************/
+#include <Tyrant/Network.hpp>
+#include <Tyrant/System/Clock.hpp>
+#include <Tyrant/System/Sleep.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+
+////////////////////////////////////////////////////////////
+/// Checks the batch functions of TGE::UdpSocket over the
+/// loopback interface.
+///
+/// A batch bigger than MaxDatagramsPerCall, for two
+/// receivers, must be sent whole, and each receiver must
+/// get its datagrams intact, in order, with the address and
+/// port of the sender, never more than MaxDatagramsPerCall
+/// per receive. Then two sockets sharing a port must both
+/// bind and split the datagrams of several senders, while a
+/// socket that doesn't share can't bind to a taken port.
+///
+/// Usage: UdpSocketTest [port]
+///
+////////////////////////////////////////////////////////////
+namespace
+{
+    // Number of datagrams of the batch, several system calls' worth
+    const TGE::Uint32 BatchCount = 100;
+
+    // Number of senders to the shared port
+    const unsigned int SenderCount = 16;
+
+    // Maximum duration of a transfer
+    const TGE::Time Timeout = TGE::seconds(5);
+
+    unsigned short port = 48400;
+    int failures = 0;
+
+    void check(bool condition, const char* what)
+    {
+        if (!condition)
+        {
+            std::printf("FAILED: %s\n", what);
+            failures++;
+        }
+    }
+
+    // Size of the datagram of a given index, small enough for the system buffers to keep the batch
+    std::size_t getDatagramSize(TGE::Uint32 index)
+    {
+        return (index * 53) % 1000;
+    }
+
+    // Content of the datagram of a given index: its index, then bytes recognizable at any offset
+    void fillPacket(TGE::Packet& packet, TGE::Uint32 index)
+    {
+        packet.clear();
+        packet << index;
+        for (std::size_t i = 0; i < getDatagramSize(index); ++i)
+            packet << static_cast<TGE::Uint8>(index * 3 + i);
+    }
+
+    // Read the index of a datagram and check the rest of its content
+    bool isIntact(TGE::Packet& packet, TGE::Uint32& index)
+    {
+        if (!(packet >> index) || (packet.getDataSize() != sizeof(TGE::Uint32) + getDatagramSize(index)))
+            return false;
+
+        const TGE::Uint8* bytes = static_cast<const TGE::Uint8*>(packet.getData()) + sizeof(TGE::Uint32);
+        for (std::size_t i = 0; i < getDatagramSize(index); ++i)
+        {
+            if (bytes[i] != static_cast<TGE::Uint8>(index * 3 + i))
+                return false;
+        }
+
+        return true;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Receiving end, expecting the datagrams of one sender
+    ////////////////////////////////////////////////////////////
+    struct Receiver
+    {
+        Receiver(TGE::UdpSocket& receiving, unsigned short senderPort) :
+        socket    (receiving),
+        sender    (senderPort),
+        count     (0),
+        next      (0),
+        intact    (true),
+        fromSender(true),
+        maxBatch  (0)
+        {
+        }
+
+        // Check the datagrams available
+        void receive(TGE::Uint32 step)
+        {
+            std::vector<TGE::UdpSocket::Datagram> datagrams;
+            if (socket.receive(datagrams) != TGE::Socket::Done)
+                return;
+
+            for (std::vector<TGE::UdpSocket::Datagram>::const_iterator it = datagrams.begin(); it != datagrams.end(); ++it)
+            {
+                TGE::Uint32 index;
+                intact &= isIntact(*it->packet, index) && (index == next);
+                fromSender &= (it->address == TGE::IpAddress::LocalHost) && (it->port == sender);
+                next += step;
+            }
+
+            count += datagrams.size();
+            maxBatch = std::max(maxBatch, datagrams.size());
+        }
+
+        TGE::UdpSocket& socket;
+        unsigned short  sender;
+        std::size_t     count;
+        TGE::Uint32     next;
+        bool            intact;
+        bool            fromSender;
+        std::size_t     maxBatch;
+    };
+
+
+    ////////////////////////////////////////////////////////////
+    void testBatches()
+    {
+        TGE::UdpSocket sender;
+        TGE::UdpSocket even;
+        TGE::UdpSocket odd;
+        if ((sender.bind(TGE::Socket::AnyPort) != TGE::Socket::Done) ||
+            (even.bind(port) != TGE::Socket::Done) ||
+            (odd.bind(port + 1) != TGE::Socket::Done))
+        {
+            check(false, "sockets bound");
+            return;
+        }
+        even.setBlocking(false);
+        odd.setBlocking(false);
+
+        // The datagrams alternate between the two receivers
+        std::vector<TGE::Packet> packets(BatchCount);
+        std::vector<TGE::UdpSocket::Datagram> datagrams;
+        for (TGE::Uint32 i = 0; i < BatchCount; ++i)
+        {
+            fillPacket(packets[i], i);
+            datagrams.push_back(TGE::UdpSocket::Datagram(packets[i], TGE::IpAddress::LocalHost, port + i % 2));
+        }
+
+        std::size_t sent = 0;
+        TGE::Socket::Status status = sender.send(&datagrams[0], datagrams.size(), sent);
+        check((status == TGE::Socket::Done) && (sent == BatchCount), "whole batch sent");
+
+        Receiver evenReceiver(even, sender.getLocalPort());
+        Receiver oddReceiver(odd, sender.getLocalPort());
+        oddReceiver.next = 1;
+        TGE::Clock clock;
+        while ((evenReceiver.count + oddReceiver.count < BatchCount) && (clock.getElapsedTime() < Timeout))
+        {
+            evenReceiver.receive(2);
+            oddReceiver.receive(2);
+            TGE::sleep(TGE::milliseconds(1));
+        }
+
+        check((evenReceiver.count == BatchCount / 2) && (oddReceiver.count == BatchCount / 2), "every datagram received by its receiver");
+        check(evenReceiver.intact && oddReceiver.intact, "datagrams received intact and in order");
+        check(evenReceiver.fromSender && oddReceiver.fromSender, "address and port of the sender received");
+        check((evenReceiver.maxBatch <= TGE::UdpSocket::MaxDatagramsPerCall) && (oddReceiver.maxBatch <= TGE::UdpSocket::MaxDatagramsPerCall), "receives limited to MaxDatagramsPerCall");
+
+        // An empty batch sends nothing
+        status = sender.send(&datagrams[0], 0, sent);
+        check((status == TGE::Socket::Done) && (sent == 0), "empty batch sent");
+
+        std::printf("batches: %u datagrams sent at once, received up to %u at a time\n",
+                    BatchCount,
+                    static_cast<unsigned int>(std::max(evenReceiver.maxBatch, oddReceiver.maxBatch)));
+    }
+
+
+    ////////////////////////////////////////////////////////////
+    void testSharedPort()
+    {
+        unsigned short shared = port + 2;
+
+        // Both sockets asking to share get the port, another one can't
+        TGE::UdpSocket first;
+        TGE::UdpSocket second;
+        TGE::UdpSocket alone;
+        check(first.bind(shared, true) == TGE::Socket::Done, "first socket bound to the shared port");
+        check(second.bind(shared, true) == TGE::Socket::Done, "second socket bound to the shared port");
+        check(alone.bind(shared) == TGE::Socket::Error, "socket not sharing refused on the shared port");
+
+        TGE::UdpSocket taken;
+        TGE::UdpSocket late;
+        check(taken.bind(port + 3) == TGE::Socket::Done, "port taken");
+        check(late.bind(port + 3, true) == TGE::Socket::Error, "port taken without sharing refused");
+
+        // The system spreads the senders between the sockets
+        first.setBlocking(false);
+        second.setBlocking(false);
+        TGE::UdpSocket senders[SenderCount];
+        for (TGE::Uint32 i = 0; i < SenderCount; ++i)
+        {
+            TGE::Packet packet;
+            fillPacket(packet, i);
+            senders[i].send(packet, TGE::IpAddress::LocalHost, shared);
+        }
+
+        std::size_t firstCount = 0;
+        std::size_t secondCount = 0;
+        bool intact = true;
+        TGE::Clock clock;
+        while ((firstCount + secondCount < SenderCount) && (clock.getElapsedTime() < Timeout))
+        {
+            TGE::UdpSocket* sockets[] = {&first, &second};
+            for (int i = 0; i < 2; ++i)
+            {
+                std::vector<TGE::UdpSocket::Datagram> datagrams;
+                if (sockets[i]->receive(datagrams) != TGE::Socket::Done)
+                    continue;
+
+                for (std::vector<TGE::UdpSocket::Datagram>::const_iterator it = datagrams.begin(); it != datagrams.end(); ++it)
+                {
+                    TGE::Uint32 index;
+                    intact &= isIntact(*it->packet, index) && (index < SenderCount);
+                }
+
+                (i == 0 ? firstCount : secondCount) += datagrams.size();
+            }
+            TGE::sleep(TGE::milliseconds(1));
+        }
+
+        check(firstCount + secondCount == SenderCount, "every datagram received on the shared port");
+        check(intact, "datagrams received intact on the shared port");
+        check((firstCount > 0) && (secondCount > 0), "datagrams spread over the sockets sharing the port");
+
+        std::printf("shared port: %u datagrams from %u senders, %u and %u per socket\n",
+                    static_cast<unsigned int>(firstCount + secondCount),
+                    SenderCount,
+                    static_cast<unsigned int>(firstCount),
+                    static_cast<unsigned int>(secondCount));
+    }
+}
+
+
+////////////////////////////////////////////////////////////
+int main(int argc, char* argv[])
+{
+    if (argc > 1)
+        port = static_cast<unsigned short>(std::atoi(argv[1]));
+
+    testBatches();
+    testSharedPort();
+
+    if (failures > 0)
+    {
+        std::printf("UdpSocketTest: %d failures\n", failures);
+        return 1;
+    }
+
+    std::printf("UdpSocketTest: every batch and shared port as expected\n");
+    return 0;
+}